@@ -197,6 +197,19 @@ static inline void binder_stats_created(enum binder_stat_types type)
 	atomic_inc(&binder_stats.obj_created[type]);
 }
 
+static s64 binder_lat_record(struct binder_lat_hist *hist, ktime_t start)
+{
+	s64 ns = ktime_to_ns(ktime_sub(ktime_get(), start));
+	u64 us = div_u64(ns, NSEC_PER_USEC);
+	unsigned int bucket;
+
+	bucket = min_t(unsigned int, fls64(us), BINDER_LAT_BUCKETS - 1);
+	atomic_inc(&hist->count[bucket]);
+	atomic64_add(ns, &hist->total_ns);
+
+	return ns;
+}
+
 struct binder_transaction_log_entry {
 	int debug_id;
 	int debug_id_done;
@@ -3138,6 +3151,7 @@ static void binder_transaction(struct binder_proc *proc,
 	INIT_LIST_HEAD(&t->fd_fixups);
 	binder_stats_created(BINDER_STAT_TRANSACTION);
 	spin_lock_init(&t->lock);
+	t->start_time = ktime_get();
 
 	tcomplete = kzalloc(sizeof(*tcomplete), GFP_KERNEL);
 	if (tcomplete == NULL) {
@@ -3594,6 +3608,7 @@ static void binder_transaction(struct binder_proc *proc,
 		target_proc->outstanding_txns++;
 		binder_inner_proc_unlock(target_proc);
 		wake_up_interruptible_sync(&target_thread->wait);
+		binder_lat_record(&proc->lat.reply, in_reply_to->start_time);
 		binder_free_transaction(in_reply_to);
 	} else if (!(t->flags & TF_ONE_WAY)) {
 		BUG_ON(t->buffer->async_transaction != 0);
@@ -4613,6 +4628,12 @@ static int binder_thread_read(struct binder_proc *proc,
 		BUG_ON(t->buffer == NULL);
 		if (t->buffer->target_node) {
 			struct binder_node *target_node = t->buffer->target_node;
+			s64 pickup_ns;
+
+			pickup_ns = binder_lat_record(&proc->lat.pickup,
+						      t->start_time);
+			atomic_inc(&target_node->txns);
+			atomic64_add(pickup_ns, &target_node->txn_pickup_ns);
 
 			trd->target.ptr = target_node->ptr;
 			trd->cookie =  target_node->cookie;
@@ -5518,6 +5539,18 @@ static long binder_ioctl(struct file *filp, unsigned int cmd, unsigned long arg)
 		if (ret < 0)
 			goto err;
 		break;
+	case BINDER_SET_PREALLOC_PAGES: {
+		uint32_t pages;
+
+		if (copy_from_user(&pages, ubuf, sizeof(pages))) {
+			ret = -EFAULT;
+			goto err;
+		}
+		ret = binder_alloc_set_prealloc(&proc->alloc, pages);
+		if (ret < 0)
+			goto err;
+		break;
+	}
 	default:
 		ret = -EINVAL;
 		goto err;
@@ -6059,7 +6092,7 @@ static void print_binder_node_nilocked(struct seq_file *m,
 {
 	struct binder_ref *ref;
 	struct binder_work *w;
-	int count;
+	int count, txns;
 
 	count = 0;
 	hlist_for_each_entry(ref, &node->refs, node_entry)
@@ -6076,6 +6109,11 @@ static void print_binder_node_nilocked(struct seq_file *m,
 			seq_printf(m, " %d", ref->proc->pid);
 	}
 	seq_puts(m, "\n");
+	txns = atomic_read(&node->txns);
+	if (txns)
+		seq_printf(m, "    txns %d avg pickup %llu us\n", txns,
+			   div_u64(atomic64_read(&node->txn_pickup_ns),
+				   txns * NSEC_PER_USEC));
 	if (node->proc) {
 		list_for_each_entry(w, &node->async_todo, entry)
 			print_binder_work_ilocked(m, node->proc, "    ",
@@ -6260,6 +6298,33 @@ static void print_binder_stats(struct seq_file *m, const char *prefix,
 	}
 }
 
+static void print_binder_lat_hist(struct seq_file *m, const char *name,
+				  struct binder_lat_hist *hist)
+{
+	int counts[BINDER_LAT_BUCKETS];
+	int i, total = 0;
+
+	for (i = 0; i < BINDER_LAT_BUCKETS; i++) {
+		counts[i] = atomic_read(&hist->count[i]);
+		total += counts[i];
+	}
+	if (!total)
+		return;
+
+	seq_printf(m, "  %s latency: count %d avg %llu us\n   ", name, total,
+		   div_u64(atomic64_read(&hist->total_ns),
+			   total * NSEC_PER_USEC));
+	for (i = 0; i < BINDER_LAT_BUCKETS; i++) {
+		if (!counts[i])
+			continue;
+		if (i == BINDER_LAT_BUCKETS - 1)
+			seq_printf(m, " >=%luus:%d", 1UL << (i - 1), counts[i]);
+		else
+			seq_printf(m, " <%luus:%d", 1UL << i, counts[i]);
+	}
+	seq_puts(m, "\n");
+}
+
 static void print_binder_proc_stats(struct seq_file *m,
 				    struct binder_proc *proc)
 {
@@ -6321,6 +6386,9 @@ static void print_binder_proc_stats(struct seq_file *m,
 	binder_inner_proc_unlock(proc);
 	seq_printf(m, "  pending transactions: %d\n", count);
 
+	print_binder_lat_hist(m, "pickup", &proc->lat.pickup);
+	print_binder_lat_hist(m, "reply", &proc->lat.reply);
+
 	print_binder_stats(m, "  ", &proc->stats);
 }
 
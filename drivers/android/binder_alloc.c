@@ -23,6 +23,7 @@
 #include <linux/uaccess.h>
 #include <linux/highmem.h>
 #include <linux/sizes.h>
+#include <linux/ktime.h>
 #include "binder_alloc.h"
 #include "binder_trace.h"
 
@@ -57,6 +58,26 @@ static struct binder_buffer *binder_buffer_prev(struct binder_buffer *buffer)
 	return list_entry(buffer->entry.prev, struct binder_buffer, entry);
 }
 
+/*
+ * Take alloc->mutex, accounting how often and for how long callers had
+ * to wait for it. The counters are protected by the mutex itself.
+ */
+static void binder_alloc_lock(struct binder_alloc *alloc)
+{
+	ktime_t start;
+
+	if (mutex_trylock(&alloc->mutex)) {
+		alloc->lock_acquired++;
+		return;
+	}
+
+	start = ktime_get();
+	mutex_lock(&alloc->mutex);
+	alloc->lock_acquired++;
+	alloc->lock_contended++;
+	alloc->lock_wait_ns += ktime_to_ns(ktime_sub(ktime_get(), start));
+}
+
 static size_t binder_alloc_buffer_size(struct binder_alloc *alloc,
 				       struct binder_buffer *buffer)
 {
@@ -172,7 +193,7 @@ struct binder_buffer *binder_alloc_prepare_to_free(struct binder_alloc *alloc,
 {
 	struct binder_buffer *buffer;
 
-	mutex_lock(&alloc->mutex);
+	binder_alloc_lock(alloc);
 	buffer = binder_alloc_prepare_to_free_locked(alloc, user_ptr);
 	mutex_unlock(&alloc->mutex);
 	return buffer;
@@ -366,8 +387,15 @@ static bool debug_low_async_space_locked(struct binder_alloc *alloc, int pid)
 	return false;
 }
 
+/*
+ * @new_buffer is allocated by the caller outside of alloc->mutex and is
+ * used to track the remainder when the best fit buffer has to be split.
+ * It is freed here when it is not needed.
+ */
 static struct binder_buffer *binder_alloc_new_buf_locked(
 				struct binder_alloc *alloc,
+				struct binder_buffer *new_buffer,
+				size_t size,
 				size_t data_size,
 				size_t offsets_size,
 				size_t extra_buffers_size,
@@ -380,7 +408,6 @@ static struct binder_buffer *binder_alloc_new_buf_locked(
 	struct rb_node *best_fit = NULL;
 	void __user *has_page_addr;
 	void __user *end_page_addr;
-	size_t size, data_offsets_size;
 	int ret;
 
 	/* Check binder_alloc is fully initialized */
@@ -388,36 +415,19 @@ static struct binder_buffer *binder_alloc_new_buf_locked(
 		binder_alloc_debug(BINDER_DEBUG_USER_ERROR,
 				   "%d: binder_alloc_buf, no vma\n",
 				   alloc->pid);
-		return ERR_PTR(-ESRCH);
+		buffer = ERR_PTR(-ESRCH);
+		goto out;
 	}
 
-	data_offsets_size = ALIGN(data_size, sizeof(void *)) +
-		ALIGN(offsets_size, sizeof(void *));
-
-	if (data_offsets_size < data_size || data_offsets_size < offsets_size) {
-		binder_alloc_debug(BINDER_DEBUG_BUFFER_ALLOC,
-				"%d: got transaction with invalid size %zd-%zd\n",
-				alloc->pid, data_size, offsets_size);
-		return ERR_PTR(-EINVAL);
-	}
-	size = data_offsets_size + ALIGN(extra_buffers_size, sizeof(void *));
-	if (size < data_offsets_size || size < extra_buffers_size) {
-		binder_alloc_debug(BINDER_DEBUG_BUFFER_ALLOC,
-				"%d: got transaction with invalid extra_buffers_size %zd\n",
-				alloc->pid, extra_buffers_size);
-		return ERR_PTR(-EINVAL);
-	}
 	if (is_async &&
 	    alloc->free_async_space < size + sizeof(struct binder_buffer)) {
 		binder_alloc_debug(BINDER_DEBUG_BUFFER_ALLOC,
 			     "%d: binder_alloc_buf size %zd failed, no async space left\n",
 			      alloc->pid, size);
-		return ERR_PTR(-ENOSPC);
+		buffer = ERR_PTR(-ENOSPC);
+		goto out;
 	}
 
-	/* Pad 0-size buffers so they get assigned unique addresses */
-	size = max(size, sizeof(void *));
-
 	while (n) {
 		buffer = rb_entry(n, struct binder_buffer, rb_node);
 		BUG_ON(!buffer->free);
@@ -467,7 +477,8 @@ static struct binder_buffer *binder_alloc_new_buf_locked(
 				   total_alloc_size, allocated_buffers,
 				   largest_alloc_size, total_free_size,
 				   free_buffers, largest_free_size);
-		return ERR_PTR(-ENOSPC);
+		buffer = ERR_PTR(-ENOSPC);
+		goto out;
 	}
 	if (n == NULL) {
 		buffer = rb_entry(best_fit, struct binder_buffer, rb_node);
@@ -487,22 +498,17 @@ static struct binder_buffer *binder_alloc_new_buf_locked(
 		end_page_addr = has_page_addr;
 	ret = binder_update_page_range(alloc, 1, (void __user *)
 		PAGE_ALIGN((uintptr_t)buffer->user_data), end_page_addr);
-	if (ret)
-		return ERR_PTR(ret);
+	if (ret) {
+		buffer = ERR_PTR(ret);
+		goto out;
+	}
 
 	if (buffer_size != size) {
-		struct binder_buffer *new_buffer;
-
-		new_buffer = kzalloc(sizeof(*buffer), GFP_KERNEL);
-		if (!new_buffer) {
-			pr_err("%s: %d failed to alloc new buffer struct\n",
-			       __func__, alloc->pid);
-			goto err_alloc_buf_struct_failed;
-		}
 		new_buffer->user_data = (u8 __user *)buffer->user_data + size;
 		list_add(&new_buffer->entry, &buffer->entry);
 		new_buffer->free = 1;
 		binder_insert_free_buffer(alloc, new_buffer);
+		new_buffer = NULL;
 	}
 
 	rb_erase(best_fit, &alloc->free_buffers);
@@ -534,13 +540,9 @@ static struct binder_buffer *binder_alloc_new_buf_locked(
 			alloc->oneway_spam_detected = false;
 		}
 	}
+out:
+	kfree(new_buffer);
 	return buffer;
-
-err_alloc_buf_struct_failed:
-	binder_update_page_range(alloc, 0, (void __user *)
-				 PAGE_ALIGN((uintptr_t)buffer->user_data),
-				 end_page_addr);
-	return ERR_PTR(-ENOMEM);
 }
 
 /**
@@ -566,10 +568,40 @@ struct binder_buffer *binder_alloc_new_buf(struct binder_alloc *alloc,
 					   int is_async,
 					   int pid)
 {
-	struct binder_buffer *buffer;
+	struct binder_buffer *buffer, *new_buffer;
+	size_t size, data_offsets_size;
 
-	mutex_lock(&alloc->mutex);
-	buffer = binder_alloc_new_buf_locked(alloc, data_size, offsets_size,
+	data_offsets_size = ALIGN(data_size, sizeof(void *)) +
+		ALIGN(offsets_size, sizeof(void *));
+
+	if (data_offsets_size < data_size || data_offsets_size < offsets_size) {
+		binder_alloc_debug(BINDER_DEBUG_BUFFER_ALLOC,
+				"%d: got transaction with invalid size %zd-%zd\n",
+				alloc->pid, data_size, offsets_size);
+		return ERR_PTR(-EINVAL);
+	}
+	size = data_offsets_size + ALIGN(extra_buffers_size, sizeof(void *));
+	if (size < data_offsets_size || size < extra_buffers_size) {
+		binder_alloc_debug(BINDER_DEBUG_BUFFER_ALLOC,
+				"%d: got transaction with invalid extra_buffers_size %zd\n",
+				alloc->pid, extra_buffers_size);
+		return ERR_PTR(-EINVAL);
+	}
+
+	/* Pad 0-size buffers so they get assigned unique addresses */
+	size = max(size, sizeof(void *));
+
+	/* Keep the slab allocation out of the alloc->mutex section */
+	new_buffer = kzalloc(sizeof(*new_buffer), GFP_KERNEL);
+	if (!new_buffer) {
+		pr_err("%s: %d failed to alloc new buffer struct\n",
+		       __func__, alloc->pid);
+		return ERR_PTR(-ENOMEM);
+	}
+
+	binder_alloc_lock(alloc);
+	buffer = binder_alloc_new_buf_locked(alloc, new_buffer, size,
+					     data_size, offsets_size,
 					     extra_buffers_size, is_async, pid);
 	mutex_unlock(&alloc->mutex);
 	return buffer;
@@ -715,7 +747,7 @@ void binder_alloc_free_buf(struct binder_alloc *alloc,
 		binder_alloc_clear_buf(alloc, buffer);
 		buffer->clear_on_free = false;
 	}
-	mutex_lock(&alloc->mutex);
+	binder_alloc_lock(alloc);
 	binder_free_buf_locked(alloc, buffer);
 	mutex_unlock(&alloc->mutex);
 }
@@ -912,6 +944,7 @@ void binder_alloc_print_pages(struct seq_file *m,
 	int active = 0;
 	int lru = 0;
 	int free = 0;
+	u64 lock_acquired, lock_contended, lock_wait_ns;
 
 	mutex_lock(&alloc->mutex);
 	/*
@@ -929,9 +962,15 @@ void binder_alloc_print_pages(struct seq_file *m,
 				lru++;
 		}
 	}
+	lock_acquired = alloc->lock_acquired;
+	lock_contended = alloc->lock_contended;
+	lock_wait_ns = alloc->lock_wait_ns;
 	mutex_unlock(&alloc->mutex);
 	seq_printf(m, "  pages: %d:%d:%d\n", active, lru, free);
 	seq_printf(m, "  pages high watermark: %zu\n", alloc->pages_high);
+	seq_printf(m, "  pages preallocated: %zu\n", alloc->prealloc_pages);
+	seq_printf(m, "  alloc lock: %llu acquired, %llu contended, %llu ns waited\n",
+		   lock_acquired, lock_contended, lock_wait_ns);
 }
 
 /**
@@ -966,6 +1005,88 @@ void binder_alloc_vma_close(struct binder_alloc *alloc)
 	binder_alloc_set_vma(alloc, NULL);
 }
 
+/**
+ * binder_alloc_set_prealloc() - keep the start of the buffer populated
+ * @alloc: binder_alloc for this proc
+ * @pages: number of pages to keep populated, 0 for lazy allocation only
+ *
+ * Allocates and maps the missing pages in [0, @pages) up front and puts
+ * them on the lru like pages of a freed buffer, so a transaction that
+ * fits below the watermark only has to take its pages off the lru
+ * instead of allocating and inserting them with the mmap lock held.
+ * Pages below the watermark are skipped by the shrinker. Lowering the
+ * watermark lets the shrinker reclaim the pages above it again.
+ *
+ * Return: 0 on success, -ESRCH if the buffer is not mapped, or a
+ *         negative errno if a page could not be allocated or mapped.
+ */
+int binder_alloc_set_prealloc(struct binder_alloc *alloc, size_t pages)
+{
+	struct binder_lru_page *page;
+	struct vm_area_struct *vma;
+	struct mm_struct *mm;
+	size_t index;
+	int ret = 0;
+
+	mutex_lock(&alloc->mutex);
+	mm = alloc->mm;
+	if (!binder_alloc_get_vma(alloc) || !mmget_not_zero(mm)) {
+		ret = -ESRCH;
+		goto err_no_vma;
+	}
+
+	pages = min_t(size_t, pages, alloc->buffer_size / PAGE_SIZE);
+
+	mmap_write_lock(mm);
+	vma = alloc->vma;
+	if (!vma) {
+		ret = -ESRCH;
+		goto out;
+	}
+
+	for (index = 0; index < pages; index++) {
+		page = &alloc->pages[index];
+		if (page->page_ptr)
+			continue;
+
+		page->page_ptr = alloc_page(GFP_KERNEL |
+					    __GFP_HIGHMEM |
+					    __GFP_ZERO);
+		if (!page->page_ptr) {
+			ret = -ENOMEM;
+			break;
+		}
+		page->alloc = alloc;
+		INIT_LIST_HEAD(&page->lru);
+
+		ret = vm_insert_page(vma,
+				     (uintptr_t)alloc->buffer + index * PAGE_SIZE,
+				     page->page_ptr);
+		if (ret) {
+			__free_page(page->page_ptr);
+			page->page_ptr = NULL;
+			break;
+		}
+
+		if (index + 1 > alloc->pages_high)
+			alloc->pages_high = index + 1;
+
+		list_lru_add(&binder_alloc_lru, &page->lru);
+	}
+
+	/* keep whatever got populated, a retry picks up the rest */
+	alloc->prealloc_pages = index;
+	if (ret)
+		pr_err("%d: failed to prealloc page %zu of %zu: %d\n",
+		       alloc->pid, index, pages, ret);
+out:
+	mmap_write_unlock(mm);
+	mmput(mm);
+err_no_vma:
+	mutex_unlock(&alloc->mutex);
+	return ret;
+}
+
 /**
  * binder_alloc_free_page() - shrinker callback to free pages
  * @item:   item to free
@@ -998,6 +1119,8 @@ enum lru_status binder_alloc_free_page(struct list_head *item,
 		goto err_page_already_freed;
 
 	index = page - alloc->pages;
+	if (index < alloc->prealloc_pages)
+		goto err_page_preallocated;
 	page_addr = (uintptr_t)alloc->buffer + index * PAGE_SIZE;
 
 	mm = alloc->mm;
@@ -1031,6 +1154,10 @@ enum lru_status binder_alloc_free_page(struct list_head *item,
 	mutex_unlock(&alloc->mutex);
 	return LRU_REMOVED_RETRY;
 
+err_page_preallocated:
+	mutex_unlock(&alloc->mutex);
+	return LRU_ROTATE;
+
 err_mmap_read_lock_failed:
 	mmput_async(mm);
 err_mmget:
@@ -89,8 +89,13 @@ struct binder_lru_page {
  * @buffer_size:        size of address space specified via mmap
  * @pid:                pid for associated binder_proc (invariant after init)
  * @pages_high:         high watermark of offset in @pages
+ * @prealloc_pages:     number of pages at the start of @pages that are kept
+ *                      populated and are never handed to the shrinker
  * @oneway_spam_detected: %true if oneway spam detection fired, clear that
  * flag once the async buffer has returned to a healthy state
+ * @lock_acquired:      number of times @mutex was taken on the buffer paths
+ * @lock_contended:     number of those that had to wait for @mutex
+ * @lock_wait_ns:       total time spent waiting for @mutex
  *
  * Bookkeeping structure for per-proc address space management for binder
  * buffers. It is normally initialized during binder_init() and binder_mmap()
@@ -110,7 +115,11 @@ struct binder_alloc {
 	size_t buffer_size;
 	int pid;
 	size_t pages_high;
+	size_t prealloc_pages;
 	bool oneway_spam_detected;
+	u64 lock_acquired;
+	u64 lock_contended;
+	u64 lock_wait_ns;
 };
 
 #ifdef CONFIG_ANDROID_BINDER_IPC_SELFTEST
@@ -131,6 +140,8 @@ extern void binder_alloc_init(struct binder_alloc *alloc);
 extern int binder_alloc_shrinker_init(void);
 extern void binder_alloc_shrinker_exit(void);
 extern void binder_alloc_vma_close(struct binder_alloc *alloc);
+extern int binder_alloc_set_prealloc(struct binder_alloc *alloc,
+				     size_t pages);
 extern struct binder_buffer *
 binder_alloc_prepare_to_free(struct binder_alloc *alloc,
 			     uintptr_t user_ptr);
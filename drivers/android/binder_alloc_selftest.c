@@ -10,10 +10,12 @@
 
 #include <linux/mm_types.h>
 #include <linux/err.h>
+#include <linux/ktime.h>
 #include "binder_alloc.h"
 
 #define BUFFER_NUM 5
 #define BUFFER_MIN_SIZE (PAGE_SIZE / 8)
+#define PREALLOC_PAGES 4
 
 static bool binder_selftest_run = true;
 static int binder_selftest_failures;
@@ -271,6 +273,65 @@ static void binder_selftest_alloc_offset(struct binder_alloc *alloc,
 	}
 }
 
+static s64 binder_selftest_time_alloc(struct binder_alloc *alloc,
+				      size_t size)
+{
+	struct binder_buffer *buffer;
+	ktime_t start;
+	s64 ns;
+
+	start = ktime_get();
+	buffer = binder_alloc_new_buf(alloc, size, 0, 0, 0, 0);
+	ns = ktime_to_ns(ktime_sub(ktime_get(), start));
+	if (IS_ERR(buffer) ||
+	    !check_buffer_pages_allocated(alloc, buffer, size)) {
+		binder_selftest_failures++;
+		return -1;
+	}
+	binder_alloc_free_buf(alloc, buffer);
+	return ns;
+}
+
+/**
+ * binder_selftest_prealloc() - Test pre-populated pages.
+ * @alloc: Pointer to alloc struct.
+ *
+ * Check that pages below the prealloc watermark survive the shrinker,
+ * and report the cost of a first allocation with and without them.
+ */
+static void binder_selftest_prealloc(struct binder_alloc *alloc)
+{
+	size_t size = PREALLOC_PAGES * PAGE_SIZE / 2;
+	s64 lazy_ns, prealloc_ns;
+	int i;
+
+	lazy_ns = binder_selftest_time_alloc(alloc, size);
+	binder_selftest_free_page(alloc);
+
+	if (binder_alloc_set_prealloc(alloc, PREALLOC_PAGES)) {
+		pr_err("failed to prealloc %d pages\n", PREALLOC_PAGES);
+		binder_selftest_failures++;
+		return;
+	}
+
+	list_lru_walk(&binder_alloc_lru, binder_alloc_free_page, NULL,
+		      list_lru_count(&binder_alloc_lru));
+	for (i = 0; i < PREALLOC_PAGES; i++) {
+		if (!alloc->pages[i].page_ptr) {
+			pr_err("expect prealloc but is free at page index %d\n",
+			       i);
+			binder_selftest_failures++;
+		}
+	}
+
+	prealloc_ns = binder_selftest_time_alloc(alloc, size);
+	pr_info("first alloc of %zu bytes: lazy %lld ns, prealloc %lld ns\n",
+		size, lazy_ns, prealloc_ns);
+
+	binder_alloc_set_prealloc(alloc, 0);
+	binder_selftest_free_page(alloc);
+}
+
 /**
  * binder_selftest_alloc() - Test alloc and free of buffer pages.
  * @alloc: Pointer to alloc struct.
@@ -278,7 +339,8 @@ static void binder_selftest_alloc_offset(struct binder_alloc *alloc,
  * Allocate BUFFER_NUM buffers to cover all page alignment cases,
  * then free them in all orders possible. Check that pages are
  * correctly allocated, put onto lru when buffers are freed, and
- * are freed when binder_alloc_free_page is called.
+ * are freed when binder_alloc_free_page is called unless they are
+ * below the prealloc watermark.
  */
 void binder_selftest_alloc(struct binder_alloc *alloc)
 {
@@ -291,6 +353,7 @@ void binder_selftest_alloc(struct binder_alloc *alloc)
 		goto done;
 	pr_info("STARTED\n");
 	binder_selftest_alloc_offset(alloc, end_offset, 0);
+	binder_selftest_prealloc(alloc);
 	binder_selftest_run = false;
 	if (binder_selftest_failures > 0)
 		pr_info("%d tests FAILED\n", binder_selftest_failures);
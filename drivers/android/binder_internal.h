@@ -5,6 +5,7 @@
 
 #include <linux/export.h>
 #include <linux/fs.h>
+#include <linux/ktime.h>
 #include <linux/list.h>
 #include <linux/miscdevice.h>
 #include <linux/mutex.h>
@@ -15,6 +16,15 @@
 #include <uapi/linux/android/binderfs.h>
 #include "binder_alloc.h"
 
+/*
+ * Keep the first N pages of the caller's binder buffer populated so that
+ * transactions fitting in them never fault in pages. 0 restores lazy
+ * allocation.
+ */
+#ifndef BINDER_SET_PREALLOC_PAGES
+#define BINDER_SET_PREALLOC_PAGES	_IOW('b', 64, __u32)
+#endif
+
 struct binder_context {
 	struct binder_node *binder_context_mgr_node;
 	struct mutex context_mgr_node_lock;
@@ -139,6 +149,33 @@ struct binder_stats {
 	atomic_t obj_deleted[BINDER_STAT_COUNT];
 };
 
+/*
+ * Latency histogram buckets, bucket 0 counts latencies below 1us and
+ * bucket n counts [2^(n-1), 2^n) us. The last bucket is open ended.
+ */
+#define BINDER_LAT_BUCKETS 20
+
+/**
+ * struct binder_lat_hist - latency histogram
+ * @count:    number of samples per log2 microsecond bucket
+ * @total_ns: sum of all samples
+ */
+struct binder_lat_hist {
+	atomic_t count[BINDER_LAT_BUCKETS];
+	atomic64_t total_ns;
+};
+
+/**
+ * struct binder_lat_stats - transaction latencies of a target process
+ * @pickup: from the send to a thread of the target picking the
+ *          transaction up
+ * @reply:  from the send to the target replying to it
+ */
+struct binder_lat_stats {
+	struct binder_lat_hist pickup;
+	struct binder_lat_hist reply;
+};
+
 /**
  * struct binder_work - work enqueued on a worklist
  * @entry:             node enqueued on list
@@ -223,6 +260,10 @@ struct binder_error {
  *                        (invariant after initialized)
  * @async_todo:           list of async work items
  *                        (protected by @proc->inner_lock)
+ * @txns:                 transactions picked up by a thread of @proc
+ *                        (atomic, no lock needed)
+ * @txn_pickup_ns:        total time those transactions were queued
+ *                        (atomic, no lock needed)
  *
  * Bookkeeping structure for binder nodes.
  */
@@ -262,6 +303,8 @@ struct binder_node {
 	};
 	bool has_async_transaction;
 	struct list_head async_todo;
+	atomic_t txns;
+	atomic64_t txn_pickup_ns;
 };
 
 struct binder_ref_death {
@@ -371,6 +414,8 @@ struct binder_ref {
  *                        (protected by @inner_lock)
  * @stats:                per-process binder statistics
  *                        (atomics, no lock needed)
+ * @lat:                  latencies of transactions sent to this process
+ *                        (atomics, no lock needed)
  * @delivered_death:      list of delivered death notification
  *                        (protected by @inner_lock)
  * @max_threads:          cap on number of binder threads
@@ -419,6 +464,7 @@ struct binder_proc {
 
 	struct list_head todo;
 	struct binder_stats stats;
+	struct binder_lat_stats lat;
 	struct list_head delivered_death;
 	int max_threads;
 	int requested_threads;
@@ -529,6 +575,7 @@ struct binder_transaction {
 	kuid_t  sender_euid;
 	struct list_head fd_fixups;
 	binder_uintptr_t security_ctx;
+	ktime_t start_time;
 	/**
 	 * @lock:  protects @from, @to_proc, and @to_thread
 	 *
@@ -14,6 +14,8 @@
 #include <linux/of.h>
 #include <linux/platform_device.h>
 #include <linux/pm_runtime.h>
+#include <linux/slab.h>
+#include <linux/workqueue.h>
 
 #define _SBF(s, v)	((v) << (s))
 #define HIWORD_UPDATE(val, mask, shift) \
@@ -22,7 +24,20 @@
 #define ROCKCHIP_AUTOSUSPEND_DELAY		100
 #define ROCKCHIP_POLL_PERIOD_US			100
 #define ROCKCHIP_POLL_TIMEOUT_US		50000
+#define ROCKCHIP_POLL_FAST_US			20
 #define RK_MAX_RNG_BYTE				(32)
+#define RK_RNG_POOL_SIZE			2048
+#define RK_RNG_REFILL_BYTE			256
+
+/*
+ * A generation takes a few microseconds, spin on it shortly before falling
+ * back to the sleeping poll, a sleep costs more than a whole generation.
+ */
+#define rk_rng_poll(rng, offset, val, cond) \
+	(read_poll_timeout_atomic(rk_rng_readl, val, cond, 1, \
+				  ROCKCHIP_POLL_FAST_US, false, rng, offset) ? \
+	 read_poll_timeout(rk_rng_readl, val, cond, ROCKCHIP_POLL_PERIOD_US, \
+			   ROCKCHIP_POLL_TIMEOUT_US, false, rng, offset) : 0)
 
 /* start of CRYPTO V1 register define */
 #define CRYPTO_V1_CTRL				0x0008
@@ -122,6 +137,19 @@ struct rk_rng {
 	struct rk_rng_soc_data	*soc_data;
 	int			clk_num;
 	struct clk_bulk_data	*clk_bulks;
+
+	/* serializes the generator between readers and the refill work */
+	struct mutex		hw_lock;
+	struct work_struct	refill_work;
+	/* protects the pool and the statistics below */
+	spinlock_t		pool_lock;
+	u8			*pool;
+	unsigned int		pool_len;
+
+	u64			total_bytes;
+	u64			win_start;
+	u64			win_bytes;
+	u64			rate;
 };
 
 static void rk_rng_writel(struct rk_rng *rng, u32 val, u32 offset)
@@ -158,14 +186,12 @@ static void rk_rng_cleanup(struct hwrng *rng)
 	clk_bulk_disable_unprepare(rk_rng->clk_num, rk_rng->clk_bulks);
 }
 
-static int rk_rng_read(struct hwrng *rng, void *buf, size_t max, bool wait)
+static int rk_rng_hw_read(struct rk_rng *rk_rng, void *buf, size_t max,
+			  bool wait)
 {
+	struct hwrng *rng = &rk_rng->rng;
 	int ret;
 	int read_len = 0;
-	struct rk_rng *rk_rng = container_of(rng, struct rk_rng, rng);
-
-	if (!rk_rng->soc_data->rk_rng_read)
-		return -EFAULT;
 
 	ret = pm_runtime_get_sync(rk_rng->dev);
 	if (ret < 0) {
@@ -173,6 +199,7 @@ static int rk_rng_read(struct hwrng *rng, void *buf, size_t max, bool wait)
 		return ret;
 	}
 
+	mutex_lock(&rk_rng->hw_lock);
 	ret = 0;
 	while (max > ret) {
 		read_len = rk_rng->soc_data->rk_rng_read(rng, buf + ret,
@@ -183,6 +210,7 @@ static int rk_rng_read(struct hwrng *rng, void *buf, size_t max, bool wait)
 		}
 		ret += read_len;
 	}
+	mutex_unlock(&rk_rng->hw_lock);
 
 	pm_runtime_mark_last_busy(rk_rng->dev);
 	pm_runtime_put_sync_autosuspend(rk_rng->dev);
@@ -190,6 +218,143 @@ static int rk_rng_read(struct hwrng *rng, void *buf, size_t max, bool wait)
 	return ret;
 }
 
+static size_t rk_rng_pool_take(struct rk_rng *rk_rng, void *buf, size_t max)
+{
+	size_t len;
+
+	spin_lock(&rk_rng->pool_lock);
+	len = min_t(size_t, max, rk_rng->pool_len);
+	rk_rng->pool_len -= len;
+	memcpy(buf, rk_rng->pool + rk_rng->pool_len, len);
+	memzero_explicit(rk_rng->pool + rk_rng->pool_len, len);
+	if (rk_rng->pool_len < RK_RNG_POOL_SIZE / 2)
+		queue_work(system_freezable_wq, &rk_rng->refill_work);
+	spin_unlock(&rk_rng->pool_lock);
+
+	return len;
+}
+
+static void rk_rng_account(struct rk_rng *rk_rng, size_t len)
+{
+	u64 now = ktime_get_ns();
+
+	spin_lock(&rk_rng->pool_lock);
+	rk_rng->total_bytes += len;
+	if (now - rk_rng->win_start >= NSEC_PER_SEC) {
+		rk_rng->rate = div64_u64(rk_rng->win_bytes * NSEC_PER_SEC,
+					 now - rk_rng->win_start);
+		rk_rng->win_start = now;
+		rk_rng->win_bytes = 0;
+	}
+	rk_rng->win_bytes += len;
+	spin_unlock(&rk_rng->pool_lock);
+}
+
+/*
+ * The hwrng core reads a cache line or a page at a time, each read paying
+ * for the runtime pm and the generator start-up. Keep a pool topped up in
+ * larger batches in between, so that reads are served from memory.
+ */
+static void rk_rng_refill_work(struct work_struct *work)
+{
+	struct rk_rng *rk_rng = container_of(work, struct rk_rng, refill_work);
+	u8 tmp[RK_RNG_REFILL_BYTE];
+	unsigned int space;
+	int len;
+
+	for (;;) {
+		spin_lock(&rk_rng->pool_lock);
+		space = RK_RNG_POOL_SIZE - rk_rng->pool_len;
+		spin_unlock(&rk_rng->pool_lock);
+		if (!space)
+			break;
+
+		len = rk_rng_hw_read(rk_rng, tmp, min_t(size_t, space, sizeof(tmp)),
+				     true);
+		if (len <= 0)
+			break;
+
+		spin_lock(&rk_rng->pool_lock);
+		len = min_t(unsigned int, len,
+			    RK_RNG_POOL_SIZE - rk_rng->pool_len);
+		memcpy(rk_rng->pool + rk_rng->pool_len, tmp, len);
+		rk_rng->pool_len += len;
+		spin_unlock(&rk_rng->pool_lock);
+	}
+
+	memzero_explicit(tmp, sizeof(tmp));
+}
+
+static int rk_rng_read(struct hwrng *rng, void *buf, size_t max, bool wait)
+{
+	struct rk_rng *rk_rng = container_of(rng, struct rk_rng, rng);
+	int ret, len;
+
+	if (!rk_rng->soc_data->rk_rng_read)
+		return -EFAULT;
+
+	ret = rk_rng_pool_take(rk_rng, buf, max);
+	if (ret < max && (wait || !ret)) {
+		len = rk_rng_hw_read(rk_rng, buf + ret, max - ret, wait);
+		if (len < 0 && !ret)
+			return len;
+		if (len > 0)
+			ret += len;
+	}
+
+	if (ret > 0)
+		rk_rng_account(rk_rng, ret);
+
+	return ret;
+}
+
+static ssize_t bytes_per_sec_show(struct device *dev,
+				  struct device_attribute *attr, char *buf)
+{
+	struct rk_rng *rk_rng = dev_get_drvdata(dev);
+	u64 rate;
+
+	spin_lock(&rk_rng->pool_lock);
+	/* idle for more than a window */
+	if (ktime_get_ns() - rk_rng->win_start >= 2 * NSEC_PER_SEC)
+		rate = 0;
+	else
+		rate = rk_rng->rate;
+	spin_unlock(&rk_rng->pool_lock);
+
+	return sysfs_emit(buf, "%llu\n", rate);
+}
+static DEVICE_ATTR_RO(bytes_per_sec);
+
+static ssize_t bytes_total_show(struct device *dev,
+				struct device_attribute *attr, char *buf)
+{
+	struct rk_rng *rk_rng = dev_get_drvdata(dev);
+	u64 total;
+
+	spin_lock(&rk_rng->pool_lock);
+	total = rk_rng->total_bytes;
+	spin_unlock(&rk_rng->pool_lock);
+
+	return sysfs_emit(buf, "%llu\n", total);
+}
+static DEVICE_ATTR_RO(bytes_total);
+
+static struct attribute *rk_rng_attrs[] = {
+	&dev_attr_bytes_per_sec.attr,
+	&dev_attr_bytes_total.attr,
+	NULL
+};
+ATTRIBUTE_GROUPS(rk_rng);
+
+static void rk_rng_cancel_refill(void *data)
+{
+	struct rk_rng *rk_rng = data;
+
+	cancel_work_sync(&rk_rng->refill_work);
+	memzero_explicit(rk_rng->pool, RK_RNG_POOL_SIZE);
+}
+
 static void rk_rng_read_regs(struct rk_rng *rng, u32 offset, void *buf,
 			     size_t size)
 {
@@ -213,11 +378,8 @@ static int crypto_v1_read(struct hwrng *rng, void *buf, size_t max, bool wait)
 
 	rk_rng_writel(rk_rng, reg_ctrl, CRYPTO_V1_CTRL);
 
-	ret = read_poll_timeout(rk_rng_readl, reg_ctrl,
-				!(reg_ctrl & CRYPTO_V1_RNG_START),
-				ROCKCHIP_POLL_PERIOD_US,
-				ROCKCHIP_POLL_TIMEOUT_US, false,
-				rk_rng, CRYPTO_V1_CTRL);
+	ret = rk_rng_poll(rk_rng, CRYPTO_V1_CTRL, reg_ctrl,
+			  !(reg_ctrl & CRYPTO_V1_RNG_START));
 
 	if (ret < 0)
 		goto out;
@@ -251,11 +413,8 @@ static int crypto_v2_read(struct hwrng *rng, void *buf, size_t max, bool wait)
 	rk_rng_writel(rk_rng, HIWORD_UPDATE(reg_ctrl, 0xffff, 0),
 		      CRYPTO_V2_RNG_CTL);
 
-	ret = read_poll_timeout(rk_rng_readl, reg_ctrl,
-				!(reg_ctrl & CRYPTO_V2_RNG_START),
-				ROCKCHIP_POLL_PERIOD_US,
-				ROCKCHIP_POLL_TIMEOUT_US, false,
-				rk_rng, CRYPTO_V2_RNG_CTL);
+	ret = rk_rng_poll(rk_rng, CRYPTO_V2_RNG_CTL, reg_ctrl,
+			  !(reg_ctrl & CRYPTO_V2_RNG_START));
 	if (ret < 0)
 		goto out;
 
@@ -341,11 +500,8 @@ static int trng_v1_read(struct hwrng *rng, void *buf, size_t max, bool wait)
 	reg_ctrl = rk_rng_readl(rk_rng, TRNG_V1_ISTAT);
 	if (!(reg_ctrl & TRNG_V1_ISTAT_RAND_RDY)) {
 		/* wait RAND_RDY triggered */
-		ret = read_poll_timeout(rk_rng_readl, reg_ctrl,
-					(reg_ctrl & TRNG_V1_ISTAT_RAND_RDY),
-					ROCKCHIP_POLL_PERIOD_US,
-					ROCKCHIP_POLL_TIMEOUT_US, false,
-					rk_rng, TRNG_V1_ISTAT);
+		ret = rk_rng_poll(rk_rng, TRNG_V1_ISTAT, reg_ctrl,
+				  (reg_ctrl & TRNG_V1_ISTAT_RAND_RDY));
 		if (ret < 0)
 			goto out;
 	}
@@ -386,11 +542,8 @@ static int rkrng_read(struct hwrng *rng, void *buf, size_t max, bool wait)
 
 	rk_rng_writel(rk_rng, HIWORD_UPDATE(reg_ctrl, 0xffff, 0), RKRNG_CTRL);
 
-	ret = readl_poll_timeout(rk_rng->mem + RKRNG_STATE, reg_ctrl,
-				 (reg_ctrl & RKRNG_STATE_SW_DRNG_ACK),
-				 ROCKCHIP_POLL_PERIOD_US,
-				 ROCKCHIP_POLL_TIMEOUT_US);
-
+	ret = rk_rng_poll(rk_rng, RKRNG_STATE, reg_ctrl,
+			  (reg_ctrl & RKRNG_STATE_SW_DRNG_ACK));
 	if (ret)
 		goto exit;
 
@@ -471,7 +624,14 @@ static int rk_rng_probe(struct platform_device *pdev)
 	match = of_match_node(rk_rng_dt_match, np);
 	rk_rng->soc_data = (struct rk_rng_soc_data *)match->data;
 
+	rk_rng->pool = devm_kzalloc(&pdev->dev, RK_RNG_POOL_SIZE, GFP_KERNEL);
+	if (!rk_rng->pool)
+		return -ENOMEM;
+
 	rk_rng->dev = &pdev->dev;
+	mutex_init(&rk_rng->hw_lock);
+	spin_lock_init(&rk_rng->pool_lock);
+	INIT_WORK(&rk_rng->refill_work, rk_rng_refill_work);
 	rk_rng->rng.name    = "rockchip";
 #ifndef CONFIG_PM
 	rk_rng->rng.init    = rk_rng_init;
@@ -511,6 +671,11 @@ static int rk_rng_probe(struct platform_device *pdev)
 	pm_runtime_use_autosuspend(&pdev->dev);
 	pm_runtime_enable(&pdev->dev);
 
+	/* registered first so that it runs after the hwrng is gone */
+	ret = devm_add_action_or_reset(&pdev->dev, rk_rng_cancel_refill, rk_rng);
+	if (ret)
+		return ret;
+
 	ret = devm_hwrng_register(&pdev->dev, &rk_rng->rng);
 	if (ret) {
 		pm_runtime_dont_use_autosuspend(&pdev->dev);
@@ -559,6 +724,7 @@ static const struct dev_pm_ops rk_rng_pm_ops = {
 static struct platform_driver rk_rng_driver = {
 	.driver	= {
 		.name	= "rockchip-rng",
+		.dev_groups = rk_rng_groups,
 #ifdef CONFIG_PM
 		.pm	= &rk_rng_pm_ops,
 #endif
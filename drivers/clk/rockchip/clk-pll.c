@@ -8,6 +8,8 @@
  */
 
 #include <asm/div64.h>
+#include <linux/debugfs.h>
+#include <linux/ktime.h>
 #include <linux/slab.h>
 #include <linux/io.h>
 #include <linux/delay.h>
@@ -26,6 +28,18 @@
 #define PLL_MODE_DEEP		0x2
 #define PLL_RK3328_MODE_MASK	0x1
 
+/* Number of rates calculated by auto kept per pll */
+#define PLL_AUTO_CACHE_SIZE	4
+
+struct rockchip_pll_stats {
+	u32			set_count;
+	u32			set_skipped;
+	u32			auto_hits;
+	u32			auto_misses;
+	u64			set_ns_total;
+	u64			set_ns_max;
+};
+
 struct rockchip_clk_pll {
 	struct clk_hw		hw;
 
@@ -45,6 +59,11 @@ struct rockchip_clk_pll {
 	unsigned long		scaling;
 	spinlock_t		*lock;
 
+	struct rockchip_pll_rate_table auto_cache[PLL_AUTO_CACHE_SIZE];
+	unsigned int		auto_cache_num;
+	unsigned int		auto_cache_next;
+	struct rockchip_pll_stats stats;
+
 	struct rockchip_clk_provider *ctx;
 
 #ifdef CONFIG_ROCKCHIP_CLK_BOOST
@@ -435,10 +454,22 @@ rockchip_rk3588_pll_clk_set_by_auto(struct rockchip_clk_pll *pll,
 	return NULL;
 }
 
+static const struct rockchip_pll_rate_table *rockchip_get_pll_settings_auto(
+			    struct rockchip_clk_pll *pll, unsigned long rate)
+{
+	if (pll->type == pll_rk3066)
+		return rockchip_rk3066_pll_clk_set_by_auto(pll, 24 * MHZ, rate);
+	else if (pll->type == pll_rk3588 || pll->type == pll_rk3588_core)
+		return rockchip_rk3588_pll_clk_set_by_auto(pll, 24 * MHZ, rate);
+	else
+		return rockchip_pll_clk_set_by_auto(pll, 24 * MHZ, rate);
+}
+
 static const struct rockchip_pll_rate_table *rockchip_get_pll_settings(
 			    struct rockchip_clk_pll *pll, unsigned long rate)
 {
 	const struct rockchip_pll_rate_table  *rate_table = pll->rate_table;
+	struct rockchip_pll_rate_table *entry;
 	int i;
 
 	for (i = 0; i < pll->rate_count; i++) {
@@ -453,12 +484,30 @@ static const struct rockchip_pll_rate_table *rockchip_get_pll_settings(
 	}
 	pll->scaling = 0;
 
-	if (pll->type == pll_rk3066)
-		return rockchip_rk3066_pll_clk_set_by_auto(pll, 24 * MHZ, rate);
-	else if (pll->type == pll_rk3588 || pll->type == pll_rk3588_core)
-		return rockchip_rk3588_pll_clk_set_by_auto(pll, 24 * MHZ, rate);
-	else
-		return rockchip_pll_clk_set_by_auto(pll, 24 * MHZ, rate);
+	/*
+	 * Rates missing from the table are searched for by auto, which is
+	 * slow for fractional rates. Users such as vop dclk or audio switch
+	 * between a few of them, so keep the last results around.
+	 */
+	for (i = 0; i < pll->auto_cache_num; i++) {
+		if (pll->auto_cache[i].rate == rate) {
+			pll->stats.auto_hits++;
+			return &pll->auto_cache[i];
+		}
+	}
+
+	rate_table = rockchip_get_pll_settings_auto(pll, rate);
+	if (!rate_table)
+		return NULL;
+
+	pll->stats.auto_misses++;
+	entry = &pll->auto_cache[pll->auto_cache_next];
+	*entry = *rate_table;
+	entry->rate = rate;
+	pll->auto_cache_next = (pll->auto_cache_next + 1) % PLL_AUTO_CACHE_SIZE;
+	pll->auto_cache_num = min(pll->auto_cache_num + 1, PLL_AUTO_CACHE_SIZE);
+
+	return entry;
 }
 
 static long rockchip_pll_round_rate(struct clk_hw *hw,
@@ -1431,6 +1480,18 @@ static int rockchip_rk3588_pll_set_params(struct rockchip_clk_pll *pll,
 	rockchip_rk3588_pll_get_params(pll, &cur);
 	cur.rate = 0;
 
+	/*
+	 * Scaling through pll->sel may map different rates to the same
+	 * settings, don't power down and relock the pll for nothing.
+	 */
+	if (cur.m == rate->m && cur.p == rate->p && cur.s == rate->s &&
+	    cur.k == rate->k &&
+	    !(readl_relaxed(pll->reg_base + RK3588_PLLCON(1)) & RK3588_PLLCON1_PWRDOWN) &&
+	    (readl_relaxed(pll->reg_base + RK3588_PLLCON(6)) & RK3588_PLLCON6_LOCK_STATUS)) {
+		pll->stats.set_skipped++;
+		return 0;
+	}
+
 	if (pll->type == pll_rk3588) {
 		cur_parent = pll_mux_ops->get_parent(&pll_mux->hw);
 		if (cur_parent == PLL_MODE_NORM) {
@@ -1484,6 +1545,8 @@ static int rockchip_rk3588_pll_set_rate(struct clk_hw *hw, unsigned long drate,
 	struct rockchip_clk_pll *pll = to_rockchip_clk_pll(hw);
 	const struct rockchip_pll_rate_table *rate;
 	unsigned long old_rate = rockchip_rk3588_pll_recalc_rate(hw, prate);
+	ktime_t start;
+	u64 ns;
 	int ret;
 
 	pr_debug("%s: changing %s from %lu to %lu with a parent rate of %lu\n",
@@ -1497,10 +1560,16 @@ static int rockchip_rk3588_pll_set_rate(struct clk_hw *hw, unsigned long drate,
 		return -EINVAL;
 	}
 
+	start = ktime_get();
 	ret = rockchip_rk3588_pll_set_params(pll, rate);
 	if (ret)
 		pll->scaling = 0;
 
+	ns = ktime_to_ns(ktime_sub(ktime_get(), start));
+	pll->stats.set_count++;
+	pll->stats.set_ns_total += ns;
+	pll->stats.set_ns_max = max(pll->stats.set_ns_max, ns);
+
 	return ret;
 }
 
@@ -1550,6 +1619,37 @@ static int rockchip_rk3588_pll_init(struct clk_hw *hw)
 	return 0;
 }
 
+static int rockchip_pll_stats_show(struct seq_file *s, void *data)
+{
+	struct rockchip_clk_pll *pll = s->private;
+	struct rockchip_pll_stats *stats = &pll->stats;
+	int i;
+
+	seq_printf(s, "set_rate: %u skipped: %u\n",
+		   stats->set_count, stats->set_skipped);
+	seq_printf(s, "set_rate ns avg: %llu max: %llu\n",
+		   stats->set_count ? div_u64(stats->set_ns_total, stats->set_count) : 0,
+		   stats->set_ns_max);
+	seq_printf(s, "auto hits: %u misses: %u\n",
+		   stats->auto_hits, stats->auto_misses);
+	for (i = 0; i < pll->auto_cache_num; i++)
+		seq_printf(s, "auto cache: %lu p: %u m: %u s: %u k: %u\n",
+			   pll->auto_cache[i].rate, pll->auto_cache[i].p,
+			   pll->auto_cache[i].m, pll->auto_cache[i].s,
+			   pll->auto_cache[i].k);
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(rockchip_pll_stats);
+
+static void rockchip_rk3588_pll_debug_init(struct clk_hw *hw, struct dentry *dentry)
+{
+	struct rockchip_clk_pll *pll = to_rockchip_clk_pll(hw);
+
+	debugfs_create_file("pll_stats", 0444, dentry, pll,
+			    &rockchip_pll_stats_fops);
+}
+
 static const struct clk_ops rockchip_rk3588_pll_clk_norate_ops = {
 	.recalc_rate = rockchip_rk3588_pll_recalc_rate,
 	.enable = rockchip_rk3588_pll_enable,
@@ -1565,6 +1665,7 @@ static const struct clk_ops rockchip_rk3588_pll_clk_ops = {
 	.disable = rockchip_rk3588_pll_disable,
 	.is_enabled = rockchip_rk3588_pll_is_enabled,
 	.init = rockchip_rk3588_pll_init,
+	.debug_init = rockchip_rk3588_pll_debug_init,
 };
 
 #ifdef CONFIG_ROCKCHIP_CLK_COMPENSATION
@@ -2079,8 +2180,6 @@ void rockchip_boost_add_core_div(struct clk_hw *hw, unsigned long prate)
 }
 
 #ifdef CONFIG_DEBUG_FS
-#include <linux/debugfs.h>
-
 #ifndef MODULE
 static int boost_summary_show(struct seq_file *s, void *data)
 {
@@ -619,6 +619,9 @@ static int cpufreq_interactive_speedchange_task(void *data)
 	goto again;
 }
 
+/* Upper bound of a single boost hint from a kernel driver */
+#define BOOST_HINT_MAX_US	(200 * USEC_PER_MSEC)
+
 static void cpufreq_interactive_boost(struct interactive_tunables *tunables)
 {
 	struct interactive_policy *ipolicy;
@@ -665,6 +668,81 @@ static void cpufreq_interactive_boost(struct interactive_tunables *tunables)
 		wake_up_process(speedchange_task);
 }
 
+/**
+ * cpufreq_interactive_boost_cpu - raise the floor of the cluster of @cpu
+ * @cpu: any cpu of the cluster to boost
+ * @duration_us: boost duration, capped at BOOST_HINT_MAX_US
+ *
+ * Acts as a boostpulse of @duration_us on the policy of @cpu only, for
+ * drivers that know some latency critical work is coming. Safe to call
+ * from atomic context.
+ */
+void cpufreq_interactive_boost_cpu(unsigned int cpu, unsigned int duration_us)
+{
+	struct interactive_tunables *tunables;
+	struct cpufreq_policy *policy;
+	struct interactive_cpu *icpu, *pcpu;
+	unsigned long flags[2];
+	bool wakeup = false;
+	u64 now, endtime;
+	int i;
+
+	if (cpu >= nr_cpu_ids || !duration_us)
+		return;
+
+	icpu = &per_cpu(interactive_cpu, cpu);
+	if (!down_read_trylock(&icpu->enable_sem))
+		return;
+
+	if (!icpu->ipolicy) {
+		up_read(&icpu->enable_sem);
+		return;
+	}
+
+	tunables = icpu->ipolicy->tunables;
+	policy = icpu->ipolicy->policy;
+	now = ktime_to_us(ktime_get());
+	endtime = now + min_t(unsigned int, duration_us, BOOST_HINT_MAX_US);
+	if (endtime <= tunables->boostpulse_endtime) {
+		up_read(&icpu->enable_sem);
+		return;
+	}
+	tunables->boostpulse_endtime = endtime;
+	tunables->boosted = true;
+	trace_cpufreq_interactive_boost("hint");
+
+	spin_lock_irqsave(&speedchange_cpumask_lock, flags[0]);
+	for_each_cpu(i, policy->cpus) {
+		pcpu = &per_cpu(interactive_cpu, i);
+
+		/* the enable_sem of @cpu keeps the policy alive */
+		if (pcpu != icpu && !down_read_trylock(&pcpu->enable_sem))
+			continue;
+
+		if (pcpu->ipolicy) {
+			spin_lock_irqsave(&pcpu->target_freq_lock, flags[1]);
+			if (pcpu->target_freq < tunables->hispeed_freq) {
+				pcpu->target_freq = tunables->hispeed_freq;
+				cpumask_set_cpu(i, &speedchange_cpumask);
+				pcpu->pol_hispeed_val_time = now;
+				wakeup = true;
+			}
+			spin_unlock_irqrestore(&pcpu->target_freq_lock,
+					       flags[1]);
+		}
+
+		if (pcpu != icpu)
+			up_read(&pcpu->enable_sem);
+	}
+	spin_unlock_irqrestore(&speedchange_cpumask_lock, flags[0]);
+
+	up_read(&icpu->enable_sem);
+
+	if (wakeup)
+		wake_up_process(speedchange_task);
+}
+EXPORT_SYMBOL_GPL(cpufreq_interactive_boost_cpu);
+
 static int cpufreq_interactive_notifier(struct notifier_block *nb,
 					unsigned long val, void *data)
 {
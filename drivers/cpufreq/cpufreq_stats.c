@@ -22,6 +22,12 @@ struct cpufreq_stats {
 	unsigned int *freq_table;
 	unsigned int *trans_table;
 
+	/* Reported by drivers through cpufreq_stats_record_latency() */
+	u64 last_latency;
+	u64 max_latency;
+	u64 total_latency;
+	unsigned int latency_count;
+
 	/* Deferred reset */
 	unsigned int reset_pending;
 	unsigned long long reset_time;
@@ -44,6 +50,10 @@ static void cpufreq_stats_reset_table(struct cpufreq_stats *stats)
 	memset(stats->trans_table, 0, count * count * sizeof(int));
 	stats->last_time = local_clock();
 	stats->total_trans = 0;
+	stats->last_latency = 0;
+	stats->max_latency = 0;
+	stats->total_latency = 0;
+	stats->latency_count = 0;
 
 	/* Adjust for the time elapsed since reset was requested */
 	WRITE_ONCE(stats->reset_pending, 0);
@@ -172,11 +182,29 @@ static ssize_t show_trans_table(struct cpufreq_policy *policy, char *buf)
 }
 cpufreq_freq_attr_ro(trans_table);
 
+/* last, average and max transition latency in ns */
+static ssize_t show_transition_latency(struct cpufreq_policy *policy,
+				       char *buf)
+{
+	struct cpufreq_stats *stats = policy->stats;
+	u64 avg = 0;
+
+	if (READ_ONCE(stats->reset_pending) || !stats->latency_count)
+		return sprintf(buf, "0 0 0\n");
+
+	avg = div_u64(stats->total_latency, stats->latency_count);
+
+	return sprintf(buf, "%llu %llu %llu\n", stats->last_latency, avg,
+		       stats->max_latency);
+}
+cpufreq_freq_attr_ro(transition_latency);
+
 static struct attribute *default_attrs[] = {
 	&total_trans.attr,
 	&time_in_state.attr,
 	&reset.attr,
 	&trans_table.attr,
+	&transition_latency.attr,
 	NULL
 };
 static const struct attribute_group stats_attr_group = {
@@ -288,3 +316,20 @@ void cpufreq_stats_record_transition(struct cpufreq_policy *policy,
 	stats->trans_table[old_index * stats->max_state + new_index]++;
 	stats->total_trans++;
 }
+
+void cpufreq_stats_record_latency(struct cpufreq_policy *policy, u64 latency_ns)
+{
+	struct cpufreq_stats *stats = policy->stats;
+
+	if (unlikely(!stats))
+		return;
+
+	if (unlikely(READ_ONCE(stats->reset_pending)))
+		cpufreq_stats_reset_table(stats);
+
+	stats->last_latency = latency_ns;
+	stats->max_latency = max(stats->max_latency, latency_ns);
+	stats->total_latency += latency_ns;
+	stats->latency_count++;
+}
+EXPORT_SYMBOL_GPL(cpufreq_stats_record_latency);
@@ -20,6 +20,7 @@
 #include <linux/err.h>
 #include <linux/init.h>
 #include <linux/kernel.h>
+#include <linux/ktime.h>
 #include <linux/mfd/syscon.h>
 #include <linux/module.h>
 #include <linux/nvmem-consumer.h>
@@ -33,6 +34,7 @@
 #include <linux/regmap.h>
 #include <linux/regulator/consumer.h>
 #include <linux/rockchip/cpu.h>
+#include <soc/rockchip/rockchip_ipa.h>
 #include <soc/rockchip/rockchip_opp_select.h>
 #include <soc/rockchip/rockchip_system_monitor.h>
 
@@ -517,12 +519,17 @@ static int rockchip_cpufreq_cluster_init(int cpu, struct cluster_info *cluster)
 int rockchip_cpufreq_adjust_table(struct device *dev)
 {
 	struct cluster_info *cluster;
+	int ret;
 
 	cluster = rockchip_cluster_info_lookup(dev->id);
 	if (!cluster)
 		return -EINVAL;
 
-	return rockchip_adjust_opp_table(dev, &cluster->opp_info);
+	ret = rockchip_adjust_opp_table(dev, &cluster->opp_info);
+	/* voltages are final now, build the em from the measured table */
+	rockchip_ipa_register_em(dev, &cluster->cpus);
+
+	return ret;
 }
 EXPORT_SYMBOL_GPL(rockchip_cpufreq_adjust_table);
 
@@ -532,7 +539,9 @@ int rockchip_cpufreq_opp_set_rate(struct device *dev, unsigned long target_freq)
 	struct dev_pm_opp *opp;
 	struct rockchip_opp_info *opp_info;
 	struct dev_pm_opp_supply supplies[2] = {0};
+	struct cpufreq_policy *policy;
 	unsigned long freq;
+	ktime_t start;
 	int ret = 0;
 
 	cluster = rockchip_cluster_info_lookup(dev->id);
@@ -541,8 +550,13 @@ int rockchip_cpufreq_opp_set_rate(struct device *dev, unsigned long target_freq)
 	opp_info = &cluster->opp_info;
 
 	rockchip_opp_dvfs_lock(opp_info);
+	start = ktime_get();
 	ret = dev_pm_opp_set_rate(dev, target_freq);
 	if (!ret) {
+		policy = cpufreq_cpu_get_raw(dev->id);
+		if (policy)
+			cpufreq_stats_record_latency(policy,
+					ktime_to_ns(ktime_sub(ktime_get(), start)));
 		cluster->rate = freq = target_freq;
 		opp = dev_pm_opp_find_freq_ceil(dev, &freq);
 		if (!IS_ERR(opp)) {
@@ -659,6 +673,25 @@ static int rockchip_cpufreq_add_bus_qos_req(struct cluster_info *cluster,
 	return ret;
 }
 
+/*
+ * The opp core counts the whole regulator ramp, with fast dvfs the pll
+ * lock time overlaps it and the governors can react sooner.
+ */
+static void rockchip_cpufreq_adjust_latency(struct cluster_info *cluster,
+					    struct cpufreq_policy *policy)
+{
+	struct rockchip_opp_info *opp_info = &cluster->opp_info;
+	unsigned int latency = policy->cpuinfo.transition_latency;
+	unsigned int overlap = opp_info->pll_lock_us * NSEC_PER_USEC;
+
+	if (!opp_info->is_fast_dvfs || latency == CPUFREQ_ETERNAL)
+		return;
+	if (latency <= overlap)
+		return;
+
+	policy->cpuinfo.transition_latency = latency - overlap;
+}
+
 static int rockchip_cpufreq_notifier(struct notifier_block *nb,
 				     unsigned long event, void *data)
 {
@@ -670,6 +703,7 @@ static int rockchip_cpufreq_notifier(struct notifier_block *nb,
 		return NOTIFY_BAD;
 
 	if (event == CPUFREQ_CREATE_POLICY) {
+		rockchip_cpufreq_adjust_latency(cluster, policy);
 		if (rockchip_cpufreq_add_monitor(cluster, policy))
 			return NOTIFY_BAD;
 		if (rockchip_cpufreq_add_bus_qos_req(cluster, policy))
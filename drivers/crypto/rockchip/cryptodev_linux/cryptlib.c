@@ -36,6 +36,7 @@
 #include <crypto/authenc.h>
 #include "cryptodev.h"
 #include "cipherapi.h"
+#include "rk_cryptodev.h"
 
 #if (LINUX_VERSION_CODE < KERNEL_VERSION(5, 0, 0))
 extern const struct crypto_type crypto_givcipher_type;
@@ -258,10 +259,63 @@ int cryptodev_cipher_init(struct cipher_data *out, const char *alg_name,
 	return ret;
 }
 
+/*
+ * Attach a cpu implementation of the same block cipher to an initialized
+ * session, short requests are run on it instead of the crypto engine.
+ */
+int cryptodev_cipher_init_cpu(struct cipher_data *cdata, const char *alg_name,
+			      uint8_t *keyp, size_t keylen)
+{
+	int ret;
+
+	if (unlikely(!cdata->init || cdata->aead))
+		return -EINVAL;
+
+	cdata->async.cpu_s = cryptodev_crypto_alloc_blkcipher(alg_name, 0, 0);
+	if (IS_ERR(cdata->async.cpu_s)) {
+		ddebug(2, "Failed to load cpu cipher %s", alg_name);
+		ret = PTR_ERR(cdata->async.cpu_s);
+		cdata->async.cpu_s = NULL;
+		return ret;
+	}
+
+	ret = cryptodev_crypto_blkcipher_setkey(cdata->async.cpu_s, keyp, keylen);
+	if (unlikely(ret)) {
+		ddebug(1, "Setting key failed for %s-%zu.", alg_name, keylen*8);
+		ret = -EINVAL;
+		goto error;
+	}
+
+	cdata->async.cpu_request = cryptodev_blkcipher_request_alloc(cdata->async.cpu_s,
+								     GFP_KERNEL);
+	if (unlikely(!cdata->async.cpu_request)) {
+		derr(1, "error allocating async crypto request");
+		ret = -ENOMEM;
+		goto error;
+	}
+
+	cryptodev_blkcipher_request_set_callback(cdata->async.cpu_request,
+				CRYPTO_TFM_REQ_MAY_BACKLOG,
+				cryptodev_complete, &cdata->async.result);
+
+	return 0;
+error:
+	cryptodev_crypto_free_blkcipher(cdata->async.cpu_s);
+	cdata->async.cpu_s = NULL;
+	return ret;
+}
+
 void cryptodev_cipher_deinit(struct cipher_data *cdata)
 {
 	if (cdata->init) {
 		if (cdata->aead == 0) {
+			if (cdata->async.cpu_request)
+				cryptodev_blkcipher_request_free(cdata->async.cpu_request);
+			if (cdata->async.cpu_s)
+				cryptodev_crypto_free_blkcipher(cdata->async.cpu_s);
+			cdata->async.cpu_request = NULL;
+			cdata->async.cpu_s = NULL;
+
 			cryptodev_blkcipher_request_free(cdata->async.request);
 			cryptodev_crypto_free_blkcipher(cdata->async.s);
 		} else {
@@ -302,6 +356,16 @@ static inline int waitfor(struct cryptodev_result *cr, ssize_t ret)
 	return 0;
 }
 
+/* the crypto engine's setup cost dominates short requests, keep them on the cpu */
+static inline cryptodev_blkcipher_request_t *
+cryptodev_cipher_request(struct cipher_data *cdata, size_t len)
+{
+	if (cdata->async.cpu_request && rk_cryptodev_use_cpu(len))
+		return cdata->async.cpu_request;
+
+	return cdata->async.request;
+}
+
 ssize_t cryptodev_cipher_encrypt(struct cipher_data *cdata,
 		const struct scatterlist *src, struct scatterlist *dst,
 		size_t len)
@@ -311,10 +375,12 @@ ssize_t cryptodev_cipher_encrypt(struct cipher_data *cdata,
 	reinit_completion(&cdata->async.result.completion);
 
 	if (cdata->aead == 0) {
-		cryptodev_blkcipher_request_set_crypt(cdata->async.request,
+		cryptodev_blkcipher_request_t *request = cryptodev_cipher_request(cdata, len);
+
+		cryptodev_blkcipher_request_set_crypt(request,
 			(struct scatterlist *)src, dst,
 			len, cdata->async.iv);
-		ret = cryptodev_crypto_blkcipher_encrypt(cdata->async.request);
+		ret = cryptodev_crypto_blkcipher_encrypt(request);
 	} else {
 		aead_request_set_crypt(cdata->async.arequest,
 			(struct scatterlist *)src, dst,
@@ -333,10 +399,12 @@ ssize_t cryptodev_cipher_decrypt(struct cipher_data *cdata,
 
 	reinit_completion(&cdata->async.result.completion);
 	if (cdata->aead == 0) {
-		cryptodev_blkcipher_request_set_crypt(cdata->async.request,
+		cryptodev_blkcipher_request_t *request = cryptodev_cipher_request(cdata, len);
+
+		cryptodev_blkcipher_request_set_crypt(request,
 			(struct scatterlist *)src, dst,
 			len, cdata->async.iv);
-		ret = cryptodev_crypto_blkcipher_decrypt(cdata->async.request);
+		ret = cryptodev_crypto_blkcipher_decrypt(request);
 	} else {
 		aead_request_set_crypt(cdata->async.arequest,
 			(struct scatterlist *)src, dst,
@@ -24,6 +24,10 @@ struct cipher_data {
 		cryptodev_crypto_blkcipher_t *s;
 		cryptodev_blkcipher_request_t *request;
 
+		/* cpu implementation, used below rk_cryptodev_cpu_threshold */
+		cryptodev_crypto_blkcipher_t *cpu_s;
+		cryptodev_blkcipher_request_t *cpu_request;
+
 		/* AEAD ciphers */
 		struct crypto_aead *as;
 		struct aead_request *arequest;
@@ -35,6 +39,8 @@ struct cipher_data {
 
 int cryptodev_cipher_init(struct cipher_data *out, const char *alg_name,
 			  uint8_t *key, size_t keylen, int stream, int aead);
+int cryptodev_cipher_init_cpu(struct cipher_data *cdata, const char *alg_name,
+			      uint8_t *keyp, size_t keylen);
 void cryptodev_cipher_deinit(struct cipher_data *cdata);
 int cryptodev_get_cipher_key(uint8_t *key, struct session_op *sop, int aead);
 int cryptodev_get_cipher_keylen(unsigned int *keylen, struct session_op *sop,
@@ -19,6 +19,8 @@
 #include <linux/module.h>
 #include <linux/moduleparam.h>
 #include <linux/scatterlist.h>
+#include <linux/wait.h>
+#include <linux/workqueue.h>
 #include <uapi/linux/cryptodev.h>
 #include <crypto/aead.h>
 
@@ -42,6 +44,10 @@ extern int cryptodev_verbosity;
 struct fcrypt {
 	struct list_head list;
 	struct list_head dma_map_list;
+	struct list_head batch_list;
+	uint32_t batch_id;
+	struct work_struct batch_work;
+	wait_queue_head_t batch_waiter;
 	struct mutex sem;
 };
 
@@ -279,6 +279,12 @@ crypto_create_session(struct fcrypt *fcr, struct session_op *sop)
 			ddebug(1, "Failed to load cipher for %s", alg_name);
 			goto session_error;
 		}
+
+		/* optional, the crypto engine handles every length without it */
+		if (aead == 0 && rk_get_cipher_cpu_name(sop->cipher))
+			cryptodev_cipher_init_cpu(&ses_new->cdata,
+						  rk_get_cipher_cpu_name(sop->cipher),
+						  keys.ckey, keylen);
 	}
 
 	if (hash_name && aead == 0) {
@@ -588,7 +594,7 @@ cryptodev_open(struct inode *inode, struct file *filp)
 	mutex_init(&pcr->done.lock);
 
 	INIT_LIST_HEAD(&pcr->fcrypt.list);
-	INIT_LIST_HEAD(&pcr->fcrypt.dma_map_list);
+	rk_cryptodev_init(&pcr->fcrypt);
 	INIT_LIST_HEAD(&pcr->free.list);
 	INIT_LIST_HEAD(&pcr->todo.list);
 	INIT_LIST_HEAD(&pcr->done.list);
@@ -652,6 +658,7 @@ cryptodev_release(struct inode *inode, struct file *filp)
 				items_freed, pcr->itemcount);
 	}
 
+	rk_cryptodev_release(&pcr->fcrypt);
 	crypto_finish_all_sessions(&pcr->fcrypt);
 
 	mutex_destroy(&pcr->done.lock);
@@ -1210,6 +1217,8 @@ static unsigned int cryptodev_poll(struct file *file, poll_table *wait)
 	if (!list_empty_careful(&pcr->free.list) || pcr->itemcount < MAX_COP_RINGSIZE)
 		ret |= POLLOUT | POLLWRNORM;
 
+	ret |= rk_cryptodev_poll(file, &pcr->fcrypt, wait);
+
 	return ret;
 }
 
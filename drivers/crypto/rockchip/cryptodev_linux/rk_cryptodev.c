@@ -9,6 +9,7 @@
  */
 #include <crypto/internal/akcipher.h>
 #include <crypto/internal/rsa.h>
+#include <crypto/skcipher.h>
 #include <linux/kernel.h>
 #include <linux/scatterlist.h>
 #include <linux/rtnetlink.h>
@@ -16,7 +17,13 @@
 #include <linux/dma-mapping.h>
 #include <linux/dma-direct.h>
 #include <linux/dma-buf.h>
+#include <linux/eventfd.h>
+#include <linux/kthread.h>
 #include <linux/list.h>
+#include <linux/poll.h>
+#include <linux/sched/mm.h>
+#include <linux/sizes.h>
+#include <linux/workqueue.h>
 
 #include "version.h"
 #include "cipherapi.h"
@@ -26,6 +33,7 @@ MODULE_IMPORT_NS(DMA_BUF);
 
 #define MAX_CRYPTO_DEV		1
 #define MAX_CRYPTO_NAME_LEN	64
+#define MAX_CRYPTO_BATCH_PENDING	16
 
 struct dma_fd_map_node {
 	struct kernel_crypt_fd_map_op fd_map;
@@ -35,6 +43,23 @@ struct dma_fd_map_node {
 	struct list_head	list;
 };
 
+enum crypt_batch_state {
+	CRYPT_BATCH_QUEUED,
+	CRYPT_BATCH_RUNNING,
+	CRYPT_BATCH_DONE,
+};
+
+struct crypt_batch_node {
+	struct fcrypt *fcr;
+	struct crypt_fd_batch_op bop;
+	struct crypt_fd_batch_entry __user *entries;
+	struct mm_struct *mm;
+	struct eventfd_ctx *eventfd;
+	enum crypt_batch_state state;	/* protected by fcr->sem */
+	struct completion done;
+	struct list_head list;
+};
+
 struct crypto_dev_info {
 	struct device *dev;
 	char name[MAX_CRYPTO_NAME_LEN];
@@ -43,6 +68,119 @@ struct crypto_dev_info {
 
 static struct crypto_dev_info g_dev_infos[MAX_CRYPTO_DEV];
 
+/*
+ * Requests shorter than this many bytes run on the ARMv8 CE cipher instead
+ * of the crypto engine, whose setup cost dominates short requests.
+ * -1 until calibrated when the engine registers, 0 disables the cpu path.
+ */
+static int rk_cpu_threshold = -1;
+module_param_named(cpu_threshold, rk_cpu_threshold, int, 0644);
+MODULE_PARM_DESC(cpu_threshold, "bytes below which ciphers run on the cpu, -1: calibrate, 0: never");
+
+#define CALIBRATE_MIN_LEN	64
+#define CALIBRATE_MAX_LEN	SZ_64K
+#define CALIBRATE_LOOPS		8
+
+static void rk_cryptodev_calibrate_work(struct work_struct *work);
+static DECLARE_WORK(g_calibrate_work, rk_cryptodev_calibrate_work);
+
+bool rk_cryptodev_use_cpu(size_t len)
+{
+	int threshold = READ_ONCE(rk_cpu_threshold);
+
+	return threshold > 0 && len < threshold;
+}
+
+/* average ns per request of @len bytes on the cipher driver @name */
+static s64 rk_cryptodev_time_cipher(const char *name, u8 *buf, unsigned int len)
+{
+	static const u8 key[16];
+	u8 iv[16] = { 0 };
+	struct crypto_skcipher *tfm;
+	struct skcipher_request *req;
+	struct scatterlist sg;
+	DECLARE_CRYPTO_WAIT(wait);
+	ktime_t start;
+	s64 ns = -1;
+	int i, ret;
+
+	tfm = crypto_alloc_skcipher(name, 0, 0);
+	if (IS_ERR(tfm))
+		return -1;
+
+	req = skcipher_request_alloc(tfm, GFP_KERNEL);
+	if (!req)
+		goto out_tfm;
+
+	if (crypto_skcipher_setkey(tfm, key, sizeof(key)))
+		goto out_req;
+
+	sg_init_one(&sg, buf, len);
+	skcipher_request_set_callback(req, CRYPTO_TFM_REQ_MAY_BACKLOG,
+				      crypto_req_done, &wait);
+	skcipher_request_set_crypt(req, &sg, &sg, len, iv);
+
+	/* warm up, the first request pays for clocks and caches */
+	ret = crypto_wait_req(crypto_skcipher_encrypt(req), &wait);
+	if (ret)
+		goto out_req;
+
+	start = ktime_get();
+	for (i = 0; i < CALIBRATE_LOOPS; i++) {
+		ret = crypto_wait_req(crypto_skcipher_encrypt(req), &wait);
+		if (ret)
+			goto out_req;
+	}
+	ns = ktime_to_ns(ktime_sub(ktime_get(), start)) / CALIBRATE_LOOPS;
+
+out_req:
+	skcipher_request_free(req);
+out_tfm:
+	crypto_free_skcipher(tfm);
+
+	return ns;
+}
+
+/*
+ * Find the shortest AES-CBC request on which the engine beats the cpu,
+ * the other modes share the same setup cost.
+ */
+static void rk_cryptodev_calibrate_work(struct work_struct *work)
+{
+	unsigned int len, threshold = CALIBRATE_MAX_LEN;
+	s64 hw_ns, cpu_ns;
+	u8 *buf;
+
+	if (READ_ONCE(rk_cpu_threshold) >= 0)
+		return;
+
+	buf = kzalloc(CALIBRATE_MAX_LEN, GFP_KERNEL);
+	if (!buf)
+		return;
+
+	for (len = CALIBRATE_MIN_LEN; len <= CALIBRATE_MAX_LEN; len *= 2) {
+		hw_ns  = rk_cryptodev_time_cipher("cbc-aes-rk", buf, len);
+		cpu_ns = rk_cryptodev_time_cipher("cbc-aes-ce", buf, len);
+
+		if (cpu_ns < 0 || hw_ns < 0) {
+			/* no cpu cipher, or no engine to compare it with */
+			threshold = 0;
+			break;
+		}
+
+		if (hw_ns <= cpu_ns) {
+			threshold = len;
+			break;
+		}
+	}
+
+	kfree(buf);
+
+	/* don't override a value set while calibrating */
+	if (cmpxchg(&rk_cpu_threshold, -1, threshold) == -1)
+		pr_info("rk_cryptodev: cpu cipher threshold %u bytes\n", threshold);
+}
+
 /*
  * rk_cryptodev_register_dev - register crypto device into rk_cryptodev.
  * @dev:	[in]	crypto device to register
@@ -67,6 +205,8 @@ int rk_cryptodev_register_dev(struct device *dev, const char *name)
 
 			g_dev_infos[i].is_multi_thread = strstr(g_dev_infos[i].name, "multi");
 			dev_info(dev, "register to cryptodev ok!\n");
+
+			schedule_work(&g_calibrate_work);
 			return 0;
 		}
 	}
@@ -86,6 +226,8 @@ int rk_cryptodev_unregister_dev(struct device *dev)
 	if (WARN_ON(!dev))
 		return -EINVAL;
 
+	cancel_work_sync(&g_calibrate_work);
+
 	for (i = 0; i < ARRAY_SIZE(g_dev_infos); i++) {
 		if (g_dev_infos[i].dev == dev) {
 			memset(&g_dev_infos[i], 0x00, sizeof(g_dev_infos[i]));
@@ -1125,6 +1267,356 @@ static int kcaop_fd_to_user(struct kernel_crypt_auth_fd_op *kcaop,
 	return 0;
 }
 
+static void crypt_fd_batch_entry_to_cop(struct crypt_auth_fd_op *caop, struct crypt_fd_op *cop)
+{
+	memset(cop, 0x00, sizeof(*cop));
+
+	cop->ses    = caop->ses;
+	cop->op     = caop->op;
+	cop->flags  = caop->flags;
+	cop->len    = caop->len;
+	cop->src_fd = caop->src_fd;
+	cop->dst_fd = caop->dst_fd;
+	cop->mac    = caop->tag ? u64_to_user_ptr(caop->tag) : NULL;
+	cop->iv     = caop->iv ? u64_to_user_ptr(caop->iv) : NULL;
+}
+
+/* run one batch entry, AEAD sessions go through the auth path */
+static int crypto_batch_run_entry(struct fcrypt *fcr, struct crypt_fd_batch_entry __user *uentry)
+{
+	struct crypt_fd_batch_entry entry;
+	struct kernel_crypt_auth_fd_op kcaop;
+	struct kernel_crypt_fd_op kcop;
+	struct csession *ses_ptr;
+	bool is_aead;
+	int ret;
+
+	if (unlikely(copy_from_user(&entry, uentry, sizeof(entry))))
+		return -EFAULT;
+
+	/* this also enters ses_ptr->sem */
+	ses_ptr = crypto_get_session_by_sid(fcr, entry.op.ses);
+	if (unlikely(!ses_ptr)) {
+		derr(1, "invalid session ID=0x%08X", entry.op.ses);
+		return -EINVAL;
+	}
+	is_aead = ses_ptr->cdata.init && ses_ptr->cdata.aead;
+	crypto_put_session(ses_ptr);
+
+	if (is_aead) {
+		kcaop.caop = entry.op;
+		ret = fill_kcaop_fd_from_caop(&kcaop, fcr);
+		if (unlikely(ret))
+			return ret;
+
+		ret = crypto_auth_fd_run(fcr, &kcaop);
+		if (unlikely(ret))
+			return ret;
+
+		return kcaop_fd_to_user(&kcaop, fcr, &uentry->op);
+	}
+
+	crypt_fd_batch_entry_to_cop(&entry.op, &kcop.cop);
+	ret = fill_kcop_fd_from_cop(&kcop, fcr);
+	if (unlikely(ret))
+		return ret;
+
+	ret = crypto_fd_run(fcr, &kcop);
+	if (unlikely(ret))
+		return ret;
+
+	return fill_cop_fd_from_kcop(&kcop, fcr);
+}
+
+static void crypto_batch_run(struct crypt_batch_node *batch)
+{
+	struct crypt_fd_batch_op *bop = &batch->bop;
+	uint32_t i;
+	int ret;
+
+	bop->done   = 0;
+	bop->status = 0;
+
+	for (i = 0; i < bop->num; i++) {
+		ret = crypto_batch_run_entry(batch->fcr, &batch->entries[i]);
+		if (unlikely(put_user(ret, &batch->entries[i].status)) && !ret)
+			ret = -EFAULT;
+
+		bop->done++;
+
+		if (unlikely(ret)) {
+			derr(1, "batch entry %u failed: %d", i, ret);
+			if (!bop->status)
+				bop->status = ret;
+			if (bop->flags & RK_CRYPT_BATCH_STOP_ON_ERROR)
+				break;
+		}
+	}
+}
+
+static struct crypt_batch_node *crypto_batch_find(struct fcrypt *fcr,
+						  enum crypt_batch_state state)
+{
+	struct crypt_batch_node *batch;
+
+	list_for_each_entry(batch, &fcr->batch_list, list) {
+		if (batch->state == state)
+			return batch;
+	}
+
+	return NULL;
+}
+
+/*
+ * Async batches of one fd run in submission order, so multi-update hash
+ * sessions shared between batches see their data in order.
+ */
+static void crypto_batch_work(struct work_struct *work)
+{
+	struct fcrypt *fcr = container_of(work, struct fcrypt, batch_work);
+	struct crypt_batch_node *batch;
+
+	for (;;) {
+		mutex_lock(&fcr->sem);
+		batch = crypto_batch_find(fcr, CRYPT_BATCH_QUEUED);
+		if (batch)
+			batch->state = CRYPT_BATCH_RUNNING;
+		mutex_unlock(&fcr->sem);
+
+		if (!batch)
+			break;
+
+		/* entries, IVs and tags are user pointers of the submitter */
+		kthread_use_mm(batch->mm);
+		crypto_batch_run(batch);
+		kthread_unuse_mm(batch->mm);
+
+		mutex_lock(&fcr->sem);
+		batch->state = CRYPT_BATCH_DONE;
+		mutex_unlock(&fcr->sem);
+
+		complete_all(&batch->done);
+
+		if (batch->eventfd)
+			eventfd_signal(batch->eventfd, 1);
+
+		/* wake for POLLIN */
+		wake_up_interruptible(&fcr->batch_waiter);
+	}
+}
+
+static void crypto_batch_free(struct crypt_batch_node *batch)
+{
+	if (batch->eventfd)
+		eventfd_ctx_put(batch->eventfd);
+
+	mmput(batch->mm);
+	kfree(batch);
+}
+
+static int crypto_batch_submit(struct fcrypt *fcr, struct crypt_fd_batch_op *bop)
+{
+	struct crypt_batch_node *batch, *tmp;
+	unsigned int pending = 0;
+	int ret;
+
+	if (unlikely(!bop->num || bop->num > RK_CRYPT_BATCH_MAX))
+		return -EINVAL;
+
+	if (unlikely(!access_ok(u64_to_user_ptr(bop->entries),
+				bop->num * sizeof(struct crypt_fd_batch_entry))))
+		return -EFAULT;
+
+	batch = kzalloc(sizeof(*batch), GFP_KERNEL);
+	if (!batch)
+		return -ENOMEM;
+
+	batch->fcr     = fcr;
+	batch->entries = u64_to_user_ptr(bop->entries);
+
+	if (!(bop->flags & RK_CRYPT_BATCH_ASYNC)) {
+		batch->bop = *bop;
+		crypto_batch_run(batch);
+		*bop = batch->bop;
+		kfree(batch);
+		return 0;
+	}
+
+	if (bop->eventfd >= 0) {
+		batch->eventfd = eventfd_ctx_fdget(bop->eventfd);
+		if (IS_ERR(batch->eventfd)) {
+			ret = PTR_ERR(batch->eventfd);
+			kfree(batch);
+			return ret;
+		}
+	}
+
+	batch->mm = current->mm;
+	mmget(batch->mm);
+	batch->state = CRYPT_BATCH_QUEUED;
+	init_completion(&batch->done);
+
+	mutex_lock(&fcr->sem);
+
+	list_for_each_entry(tmp, &fcr->batch_list, list)
+		pending++;
+
+	if (unlikely(pending >= MAX_CRYPTO_BATCH_PENDING)) {
+		mutex_unlock(&fcr->sem);
+		crypto_batch_free(batch);
+		return -EBUSY;
+	}
+
+	/* 0 is never a valid batch id */
+	if (unlikely(!++fcr->batch_id))
+		++fcr->batch_id;
+
+	bop->id    = fcr->batch_id;
+	batch->bop = *bop;
+	list_add_tail(&batch->list, &fcr->batch_list);
+
+	mutex_unlock(&fcr->sem);
+
+	queue_work(system_unbound_wq, &fcr->batch_work);
+
+	return 0;
+}
+
+/*
+ * Wait for the async batch bop->id, or reap any finished batch without
+ * blocking when bop->id is 0, poll() reports POLLIN while there is one.
+ */
+static int crypto_batch_wait(struct fcrypt *fcr, struct crypt_fd_batch_op *bop)
+{
+	struct crypt_batch_node *batch = NULL, *tmp;
+	int ret;
+
+	mutex_lock(&fcr->sem);
+	if (bop->id) {
+		list_for_each_entry(tmp, &fcr->batch_list, list) {
+			if (tmp->bop.id == bop->id) {
+				batch = tmp;
+				break;
+			}
+		}
+	} else {
+		batch = crypto_batch_find(fcr, CRYPT_BATCH_DONE);
+		if (!batch) {
+			mutex_unlock(&fcr->sem);
+			return -EAGAIN;
+		}
+	}
+
+	if (batch)
+		list_del(&batch->list);
+	mutex_unlock(&fcr->sem);
+
+	if (unlikely(!batch)) {
+		derr(1, "batch id %u not found!", bop->id);
+		return -ENOENT;
+	}
+
+	ret = wait_for_completion_interruptible(&batch->done);
+	if (unlikely(ret)) {
+		/* keep the batch so it can be waited for again */
+		mutex_lock(&fcr->sem);
+		list_add_tail(&batch->list, &fcr->batch_list);
+		mutex_unlock(&fcr->sem);
+		return ret;
+	}
+
+	*bop = batch->bop;
+	crypto_batch_free(batch);
+
+	/* wake for POLLOUT */
+	wake_up_interruptible(&fcr->batch_waiter);
+
+	return 0;
+}
+
+static int kcop_batch_from_user(struct crypt_fd_batch_op *bop, void __user *arg)
+{
+	if (unlikely(copy_from_user(bop, arg, sizeof(*bop))))
+		return -EFAULT;
+
+	return 0;
+}
+
+static int kcop_batch_to_user(struct crypt_fd_batch_op *bop, void __user *arg)
+{
+	if (unlikely(copy_to_user(arg, bop, sizeof(*bop)))) {
+		derr(1, "Cannot copy to userspace");
+		return -EFAULT;
+	}
+
+	return 0;
+}
+
+/*
+ * rk_cryptodev_init - set up the rockchip specific part of a new fd.
+ */
+void rk_cryptodev_init(struct fcrypt *fcr)
+{
+	INIT_LIST_HEAD(&fcr->dma_map_list);
+	INIT_LIST_HEAD(&fcr->batch_list);
+	INIT_WORK(&fcr->batch_work, crypto_batch_work);
+	init_waitqueue_head(&fcr->batch_waiter);
+}
+
+/*
+ * rk_cryptodev_poll - POLLIN when an async batch can be reaped,
+ * POLLOUT when another one can be queued.
+ */
+__poll_t rk_cryptodev_poll(struct file *file, struct fcrypt *fcr, poll_table *wait)
+{
+	struct crypt_batch_node *batch;
+	unsigned int pending = 0;
+	__poll_t mask = 0;
+
+	poll_wait(file, &fcr->batch_waiter, wait);
+
+	mutex_lock(&fcr->sem);
+	list_for_each_entry(batch, &fcr->batch_list, list) {
+		if (batch->state == CRYPT_BATCH_DONE)
+			mask |= EPOLLIN | EPOLLRDNORM;
+		pending++;
+	}
+	mutex_unlock(&fcr->sem);
+
+	if (pending < MAX_CRYPTO_BATCH_PENDING)
+		mask |= EPOLLOUT | EPOLLWRNORM;
+
+	return mask;
+}
+
+/*
+ * rk_cryptodev_release - drop everything a closing fd still holds: wait for
+ * its async batches and unmap the dma-bufs registered with RIOCCRYPT_FD_MAP.
+ * Called before the sessions are destroyed, the batches still use them.
+ */
+void rk_cryptodev_release(struct fcrypt *fcr)
+{
+	struct crypt_batch_node *batch, *batch_tmp;
+	struct dma_fd_map_node *map_node, *map_tmp;
+
+	/* the work drains every queued batch before it returns */
+	flush_work(&fcr->batch_work);
+
+	list_for_each_entry_safe(batch, batch_tmp, &fcr->batch_list, list) {
+		list_del(&batch->list);
+		crypto_batch_free(batch);
+	}
+
+	list_for_each_entry_safe(map_node, map_tmp, &fcr->dma_map_list, list) {
+		dma_buf_unmap_attachment(map_node->dma_attach, map_node->sgtbl,
+					 DMA_BIDIRECTIONAL);
+		dma_buf_detach(map_node->dmabuf, map_node->dma_attach);
+		dma_buf_put(map_node->dmabuf);
+		list_del(&map_node->list);
+		kfree(map_node);
+	}
+}
+
 long
 rk_cryptodev_ioctl(struct fcrypt *fcr, unsigned int cmd, unsigned long arg_)
 {
@@ -1132,6 +1624,7 @@ rk_cryptodev_ioctl(struct fcrypt *fcr, unsigned int cmd, unsigned long arg_)
 	struct kernel_crypt_fd_map_op kmop;
 	struct kernel_crypt_rsa_op krop;
 	struct kernel_crypt_auth_fd_op kcaop;
+	struct crypt_fd_batch_op bop;
 	void __user *arg = (void __user *)arg_;
 	int ret;
 
@@ -1228,6 +1721,34 @@ rk_cryptodev_ioctl(struct fcrypt *fcr, unsigned int cmd, unsigned long arg_)
 		}
 
 		return kcop_rsa_to_user(&krop, fcr, arg);
+	case RIOCCRYPT_FD_BATCH:
+		ret = kcop_batch_from_user(&bop, arg);
+		if (unlikely(ret)) {
+			dwarning(1, "Error copying from user");
+			return ret;
+		}
+
+		ret = crypto_batch_submit(fcr, &bop);
+		if (unlikely(ret)) {
+			dwarning(1, "Error in crypto_batch_submit");
+			return ret;
+		}
+
+		return kcop_batch_to_user(&bop, arg);
+	case RIOCCRYPT_FD_BATCH_WAIT:
+		ret = kcop_batch_from_user(&bop, arg);
+		if (unlikely(ret)) {
+			dwarning(1, "Error copying from user");
+			return ret;
+		}
+
+		ret = crypto_batch_wait(fcr, &bop);
+		if (unlikely(ret)) {
+			dwarning(1, "Error in crypto_batch_wait");
+			return ret;
+		}
+
+		return kcop_batch_to_user(&bop, arg);
 	default:
 		return -EINVAL;
 	}
@@ -1424,6 +1945,7 @@ struct cipher_algo_name_map {
 	const char	*name;
 	int		is_stream;
 	int		is_aead;
+	const char	*cpu_name;	/* ARMv8 CE driver for short requests */
 };
 
 struct hash_algo_name_map {
@@ -1433,32 +1955,32 @@ struct hash_algo_name_map {
 };
 
 static const struct cipher_algo_name_map c_algo_map_tbl[] = {
-	{CRYPTO_RK_DES_ECB,     "ecb-des-rk",      0, 0},
-	{CRYPTO_RK_DES_CBC,     "cbc-des-rk",      0, 0},
-	{CRYPTO_RK_DES_CFB,     "cfb-des-rk",      0, 0},
-	{CRYPTO_RK_DES_OFB,     "ofb-des-rk",      0, 0},
-	{CRYPTO_RK_3DES_ECB,    "ecb-des3_ede-rk", 0, 0},
-	{CRYPTO_RK_3DES_CBC,    "cbc-des3_ede-rk", 0, 0},
-	{CRYPTO_RK_3DES_CFB,    "cfb-des3_ede-rk", 0, 0},
-	{CRYPTO_RK_3DES_OFB,    "ofb-des3_ede-rk", 0, 0},
-	{CRYPTO_RK_SM4_ECB,     "ecb-sm4-rk",      0, 0},
-	{CRYPTO_RK_SM4_CBC,     "cbc-sm4-rk",      0, 0},
-	{CRYPTO_RK_SM4_CFB,     "cfb-sm4-rk",      0, 0},
-	{CRYPTO_RK_SM4_OFB,     "ofb-sm4-rk",      0, 0},
-	{CRYPTO_RK_SM4_CTS,     "cts-sm4-rk",      0, 0},
-	{CRYPTO_RK_SM4_CTR,     "ctr-sm4-rk",      1, 0},
-	{CRYPTO_RK_SM4_XTS,     "xts-sm4-rk",      0, 0},
-	{CRYPTO_RK_SM4_CCM,     "ccm-sm4-rk",      1, 1},
-	{CRYPTO_RK_SM4_GCM,     "gcm-sm4-rk",      1, 1},
-	{CRYPTO_RK_AES_ECB,     "ecb-aes-rk",      0, 0},
-	{CRYPTO_RK_AES_CBC,     "cbc-aes-rk",      0, 0},
-	{CRYPTO_RK_AES_CFB,     "cfb-aes-rk",      0, 0},
-	{CRYPTO_RK_AES_OFB,     "ofb-aes-rk",      0, 0},
-	{CRYPTO_RK_AES_CTS,     "cts-aes-rk",      0, 0},
-	{CRYPTO_RK_AES_CTR,     "ctr-aes-rk",      1, 0},
-	{CRYPTO_RK_AES_XTS,     "xts-aes-rk",      0, 0},
-	{CRYPTO_RK_AES_CCM,     "ccm-aes-rk",      1, 1},
-	{CRYPTO_RK_AES_GCM,     "gcm-aes-rk",      1, 1},
+	{CRYPTO_RK_DES_ECB,     "ecb-des-rk",      0, 0, NULL},
+	{CRYPTO_RK_DES_CBC,     "cbc-des-rk",      0, 0, NULL},
+	{CRYPTO_RK_DES_CFB,     "cfb-des-rk",      0, 0, NULL},
+	{CRYPTO_RK_DES_OFB,     "ofb-des-rk",      0, 0, NULL},
+	{CRYPTO_RK_3DES_ECB,    "ecb-des3_ede-rk", 0, 0, NULL},
+	{CRYPTO_RK_3DES_CBC,    "cbc-des3_ede-rk", 0, 0, NULL},
+	{CRYPTO_RK_3DES_CFB,    "cfb-des3_ede-rk", 0, 0, NULL},
+	{CRYPTO_RK_3DES_OFB,    "ofb-des3_ede-rk", 0, 0, NULL},
+	{CRYPTO_RK_SM4_ECB,     "ecb-sm4-rk",      0, 0, "ecb-sm4-ce"},
+	{CRYPTO_RK_SM4_CBC,     "cbc-sm4-rk",      0, 0, "cbc-sm4-ce"},
+	{CRYPTO_RK_SM4_CFB,     "cfb-sm4-rk",      0, 0, "cfb-sm4-ce"},
+	{CRYPTO_RK_SM4_OFB,     "ofb-sm4-rk",      0, 0, NULL},
+	{CRYPTO_RK_SM4_CTS,     "cts-sm4-rk",      0, 0, NULL},
+	{CRYPTO_RK_SM4_CTR,     "ctr-sm4-rk",      1, 0, "ctr-sm4-ce"},
+	{CRYPTO_RK_SM4_XTS,     "xts-sm4-rk",      0, 0, NULL},
+	{CRYPTO_RK_SM4_CCM,     "ccm-sm4-rk",      1, 1, NULL},
+	{CRYPTO_RK_SM4_GCM,     "gcm-sm4-rk",      1, 1, NULL},
+	{CRYPTO_RK_AES_ECB,     "ecb-aes-rk",      0, 0, "ecb-aes-ce"},
+	{CRYPTO_RK_AES_CBC,     "cbc-aes-rk",      0, 0, "cbc-aes-ce"},
+	{CRYPTO_RK_AES_CFB,     "cfb-aes-rk",      0, 0, NULL},
+	{CRYPTO_RK_AES_OFB,     "ofb-aes-rk",      0, 0, NULL},
+	{CRYPTO_RK_AES_CTS,     "cts-aes-rk",      0, 0, "cts-cbc-aes-ce"},
+	{CRYPTO_RK_AES_CTR,     "ctr-aes-rk",      1, 0, "ctr-aes-ce"},
+	{CRYPTO_RK_AES_XTS,     "xts-aes-rk",      0, 0, "xts-aes-ce"},
+	{CRYPTO_RK_AES_CCM,     "ccm-aes-rk",      1, 1, NULL},
+	{CRYPTO_RK_AES_GCM,     "gcm-aes-rk",      1, 1, NULL},
 };
 
 static const struct hash_algo_name_map h_algo_map_tbl[] = {
@@ -1501,6 +2023,18 @@ const char *rk_get_cipher_name(uint32_t id, int *is_stream, int *is_aead)
 	return NULL;
 }
 
+const char *rk_get_cipher_cpu_name(uint32_t id)
+{
+	uint32_t i;
+
+	for (i = 0; i < ARRAY_SIZE(c_algo_map_tbl); i++) {
+		if (id == c_algo_map_tbl[i].id)
+			return c_algo_map_tbl[i].cpu_name;
+	}
+
+	return NULL;
+}
+
 const char *rk_get_hash_name(uint32_t id, int *is_hmac)
 {
 	uint32_t i;
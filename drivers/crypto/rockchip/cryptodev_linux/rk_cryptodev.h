@@ -6,6 +6,7 @@
 #define __RK_CRYPTODEV_H__
 
 #include <linux/device.h>
+#include <linux/poll.h>
 #include <uapi/linux/rk_cryptodev.h>
 #include "cryptodev.h"
 
@@ -94,6 +95,12 @@ static inline int rk_cryptodev_unregister_dev(struct device *dev)
 }
 #endif
 
+void rk_cryptodev_init(struct fcrypt *fcr);
+
+__poll_t rk_cryptodev_poll(struct file *file, struct fcrypt *fcr, poll_table *wait);
+
+void rk_cryptodev_release(struct fcrypt *fcr);
+
 long
 rk_cryptodev_ioctl(struct fcrypt *fcr, unsigned int cmd, unsigned long arg_);
 
@@ -102,8 +109,12 @@ rk_compat_cryptodev_ioctl(struct fcrypt *fcr, unsigned int cmd, unsigned long ar
 
 const char *rk_get_cipher_name(uint32_t id, int *is_stream, int *is_aead);
 
+const char *rk_get_cipher_cpu_name(uint32_t id);
+
 const char *rk_get_hash_name(uint32_t id, int *is_hmac);
 
+bool rk_cryptodev_use_cpu(size_t len);
+
 bool rk_cryptodev_multi_thread(const char *name);
 
 #endif
@@ -5,16 +5,20 @@
  */
 
 #include <linux/clk.h>
+#include <linux/cpuhotplug.h>
 #include <linux/devfreq-event.h>
+#include <linux/hrtimer.h>
 #include <linux/kernel.h>
 #include <linux/err.h>
 #include <linux/init.h>
 #include <linux/io.h>
 #include <linux/mfd/syscon.h>
 #include <linux/module.h>
+#include <linux/perf_event.h>
 #include <linux/platform_device.h>
 #include <linux/regmap.h>
 #include <linux/slab.h>
+#include <linux/spinlock.h>
 #include <linux/list.h>
 #include <linux/of.h>
 
@@ -63,6 +67,8 @@
 #define READ_SYSREG_VERSION(m)		(((m) >> 28) & 0xf)
 #define READ_LP5_BANK_MODE(m)		(((m) >> 1) & 0x3)
 #define READ_LP5_CKR(m)			(((m) >> 0) & 0x1)
+/* bus width of channel ch in bytes, the field is 0: 32bit, 1: 16bit, 2: 8bit */
+#define READ_BW_INFO(n, ch)		(4 >> (((n) >> (2 + ((ch) & 1) * 16)) & 0x3))
 /* DDRMON_CTRL */
 #define DDRMON_CTRL			0x04
 #define CLR_DDRMON_CTRL			(0xffff0000 << 0)
@@ -81,6 +87,8 @@
 #define LPDDR5_BANK_MODE_CTRL1(m)	((0x30000 | ((m) & 0x3)) << 1)
 #define LPDDR5_EN_CTRL1			(0x10001 << 0)
 
+#define DDRMON_CH0_WR_NUM		0x20
+#define DDRMON_CH0_RD_NUM		0x24
 #define DDRMON_CH0_COUNT_NUM		0x28
 #define DDRMON_CH0_DFI_ACCESS_NUM	0x2c
 #define DDRMON_CH1_COUNT_NUM		0x3c
@@ -107,6 +115,14 @@ struct dmc_usage {
 	u64 total;
 };
 
+/* running totals of the hardware counters, which are cleared on every read */
+struct dmc_count {
+	u64 access;
+	u64 total;
+	u64 read;
+	u64 write;
+};
+
 /*
  * The dfi controller can monitor DDR load. It has an upper and lower threshold
  * for the operating points. Whenever the usage leaves these bounds an event is
@@ -141,6 +157,20 @@ struct rockchip_dfi {
 	 * each bit represent a channel
 	 */
 	u32 ch_msk;
+	/* bus width of each channel in bytes, 0 if unknown */
+	u32 buswidth[MAX_DMC_NUM_CH];
+	/* protects the hardware counters and the totals below */
+	spinlock_t lock;
+	struct dmc_count ch_count[MAX_DMC_NUM_CH];
+	/* totals at the last devfreq get_event */
+	struct dmc_count ch_last[MAX_DMC_NUM_CH];
+#ifdef CONFIG_PERF_EVENTS
+	struct pmu pmu;
+	struct hrtimer pmu_timer;
+	struct hlist_node pmu_node;
+	unsigned int pmu_cpu;
+	int pmu_active;
+#endif
 };
 
 static void rk3128_dfi_start_hardware_counter(struct devfreq_event_dev *edev)
@@ -461,13 +491,18 @@ static void rockchip_dfi_stop_hardware_counter(struct devfreq_event_dev *edev)
 	}
 }
 
-static int rockchip_dfi_get_busier_ch(struct devfreq_event_dev *edev)
+/*
+ * Fold the hardware counters into the running totals and restart them. Both
+ * the devfreq governor and the perf pmu read the counters, each one works on
+ * the differences of the totals so that neither steals the counts of the
+ * other. Must be called with info->lock held.
+ */
+static void rockchip_dfi_update_count(struct devfreq_event_dev *edev)
 {
 	struct rockchip_dfi *info = devfreq_event_get_drvdata(edev);
-	u32 tmp, max = 0;
-	u32 i, busier_ch = 0;
 	void __iomem *dfi_regs = info->regs;
 	u32 mon_idx = 0x14, count_rate = 1;
+	u32 i;
 
 	rockchip_dfi_stop_hardware_counter(edev);
 
@@ -476,18 +511,42 @@ static int rockchip_dfi_get_busier_ch(struct devfreq_event_dev *edev)
 	if (info->count_rate)
 		count_rate = info->count_rate;
 
-	/* Find out which channel is busier */
 	for (i = 0; i < MAX_DMC_NUM_CH; i++) {
 		if (!(info->ch_msk & BIT(i)))
 			continue;
 
 		/* rk3588 counter is dfi clk rate */
-		info->ch_usage[i].total = readl_relaxed(dfi_regs +
+		info->ch_count[i].total += (u64)readl_relaxed(dfi_regs +
 				info->mon_count_num + i * mon_idx) * count_rate;
+		info->ch_count[i].access += readl_relaxed(dfi_regs +
+				info->mon_access_num + i * mon_idx);
+		if (info->mon_version < 0x40) {
+			info->ch_count[i].read += readl_relaxed(dfi_regs +
+					DDRMON_CH0_RD_NUM + i * mon_idx);
+			info->ch_count[i].write += readl_relaxed(dfi_regs +
+					DDRMON_CH0_WR_NUM + i * mon_idx);
+		}
+	}
+	rockchip_dfi_start_hardware_counter(edev);
+}
+
+static int rockchip_dfi_get_busier_ch(struct devfreq_event_dev *edev)
+{
+	struct rockchip_dfi *info = devfreq_event_get_drvdata(edev);
+	u32 tmp, max = 0;
+	u32 i, busier_ch = 0;
+
+	rockchip_dfi_update_count(edev);
+
+	/* Find out which channel is busier */
+	for (i = 0; i < MAX_DMC_NUM_CH; i++) {
+		if (!(info->ch_msk & BIT(i)))
+			continue;
+
+		info->ch_usage[i].total = info->ch_count[i].total - info->ch_last[i].total;
 
 		/* LPDDR5 LPDDR4 and LPDDR4X BL = 16,other DDR type BL = 8 */
-		tmp = readl_relaxed(dfi_regs +
-				info->mon_access_num + i * mon_idx);
+		tmp = info->ch_count[i].access - info->ch_last[i].access;
 		if (info->dram_type == LPDDR4 || info->dram_type == LPDDR4X)
 			tmp *= 8;
 		else if (info->dram_type == LPDDR5)
@@ -495,13 +554,13 @@ static int rockchip_dfi_get_busier_ch(struct devfreq_event_dev *edev)
 		else
 			tmp *= 4;
 		info->ch_usage[i].access = tmp;
+		info->ch_last[i] = info->ch_count[i];
 
 		if (tmp > max) {
 			busier_ch = i;
 			max = tmp;
 		}
 	}
-	rockchip_dfi_start_hardware_counter(edev);
 
 	return busier_ch;
 }
@@ -549,9 +608,9 @@ static int rockchip_dfi_get_event(struct devfreq_event_dev *edev,
 	int busier_ch;
 	unsigned long flags;
 
-	local_irq_save(flags);
+	spin_lock_irqsave(&info->lock, flags);
 	busier_ch = rockchip_dfi_get_busier_ch(edev);
-	local_irq_restore(flags);
+	spin_unlock_irqrestore(&info->lock, flags);
 
 	edata->load_count = info->ch_usage[busier_ch].access;
 	edata->total_count = info->ch_usage[busier_ch].total;
@@ -566,6 +625,356 @@ static const struct devfreq_event_ops rockchip_dfi_ops = {
 	.set_event = rockchip_dfi_set_event,
 };
 
+#ifdef CONFIG_PERF_EVENTS
+/*
+ * DDR traffic as a system wide perf pmu, e.g.
+ *   perf stat -a -e rockchip_dfi/bytes/,rockchip_dfi/ch0-read-bytes/ -- cmd
+ * config[7:0] selects the event, config[11:8] the channel: 0 for the sum of
+ * all channels, n for channel n - 1. Bytes are the dfi accesses times the
+ * burst length times the bus width.
+ */
+#define DFI_PMU_EVENT(config)		((config) & 0xff)
+#define DFI_PMU_CHAN(config)		(((config) >> 8) & 0xf)
+#define DFI_PMU_CYCLES			0
+#define DFI_PMU_BYTES			1
+#define DFI_PMU_READ_BYTES		2
+#define DFI_PMU_WRITE_BYTES		3
+#define DFI_PMU_MAX			DFI_PMU_WRITE_BYTES
+/* fold the 32 bit counters well before they can wrap */
+#define DFI_PMU_POLL_NS			(100 * NSEC_PER_MSEC)
+
+static enum cpuhp_state rockchip_dfi_pmu_cpuhp_state;
+
+#define to_rockchip_dfi(p) container_of(p, struct rockchip_dfi, pmu)
+
+static u64 rockchip_dfi_pmu_count(struct rockchip_dfi *info, u64 config)
+{
+	u32 ev = DFI_PMU_EVENT(config), chan = DFI_PMU_CHAN(config);
+	u32 burst_len, i;
+	unsigned long flags;
+	u64 count = 0;
+
+	burst_len = (info->dram_type == LPDDR4 || info->dram_type == LPDDR4X ||
+		     info->dram_type == LPDDR5) ? 16 : 8;
+
+	spin_lock_irqsave(&info->lock, flags);
+	rockchip_dfi_update_count(info->edev);
+	for (i = 0; i < MAX_DMC_NUM_CH; i++) {
+		if (!(info->ch_msk & BIT(i)) || (chan && chan - 1 != i))
+			continue;
+
+		switch (ev) {
+		case DFI_PMU_CYCLES:
+			count += info->ch_count[i].total;
+			break;
+		case DFI_PMU_BYTES:
+			count += info->ch_count[i].access * burst_len * info->buswidth[i];
+			break;
+		case DFI_PMU_READ_BYTES:
+			count += info->ch_count[i].read * burst_len * info->buswidth[i];
+			break;
+		case DFI_PMU_WRITE_BYTES:
+			count += info->ch_count[i].write * burst_len * info->buswidth[i];
+			break;
+		}
+		/* the channels share one clock */
+		if (ev == DFI_PMU_CYCLES)
+			break;
+	}
+	spin_unlock_irqrestore(&info->lock, flags);
+
+	return count;
+}
+
+static void rockchip_dfi_pmu_event_destroy(struct perf_event *event)
+{
+	struct rockchip_dfi *info = to_rockchip_dfi(event->pmu);
+
+	devfreq_event_disable_edev(info->edev);
+}
+
+static int rockchip_dfi_pmu_event_init(struct perf_event *event)
+{
+	struct rockchip_dfi *info = to_rockchip_dfi(event->pmu);
+	u64 config = event->attr.config;
+	u32 chan = DFI_PMU_CHAN(config);
+	int ret;
+
+	if (event->attr.type != event->pmu->type)
+		return -ENOENT;
+
+	if (is_sampling_event(event) || event->attach_state & PERF_ATTACH_TASK)
+		return -EINVAL;
+
+	if (event->cpu < 0)
+		return -EINVAL;
+
+	if (DFI_PMU_EVENT(config) > DFI_PMU_MAX ||
+	    (chan && !(info->ch_msk & BIT(chan - 1))))
+		return -EINVAL;
+
+	ret = devfreq_event_enable_edev(info->edev);
+	if (ret)
+		return ret;
+
+	/* only the first monitor version splits reads and writes */
+	if (info->mon_version >= 0x40 &&
+	    (DFI_PMU_EVENT(config) == DFI_PMU_READ_BYTES ||
+	     DFI_PMU_EVENT(config) == DFI_PMU_WRITE_BYTES)) {
+		devfreq_event_disable_edev(info->edev);
+		return -EOPNOTSUPP;
+	}
+
+	event->cpu = info->pmu_cpu;
+	event->destroy = rockchip_dfi_pmu_event_destroy;
+
+	return 0;
+}
+
+static void rockchip_dfi_pmu_read(struct perf_event *event)
+{
+	struct rockchip_dfi *info = to_rockchip_dfi(event->pmu);
+	struct hw_perf_event *hwc = &event->hw;
+	u64 now, prev;
+
+	now = rockchip_dfi_pmu_count(info, event->attr.config);
+	prev = local64_xchg(&hwc->prev_count, now);
+	local64_add(now - prev, &event->count);
+}
+
+static void rockchip_dfi_pmu_start(struct perf_event *event, int flags)
+{
+	struct rockchip_dfi *info = to_rockchip_dfi(event->pmu);
+
+	local64_set(&event->hw.prev_count,
+		    rockchip_dfi_pmu_count(info, event->attr.config));
+}
+
+static void rockchip_dfi_pmu_stop(struct perf_event *event, int flags)
+{
+	if (flags & PERF_EF_UPDATE)
+		rockchip_dfi_pmu_read(event);
+}
+
+static int rockchip_dfi_pmu_add(struct perf_event *event, int flags)
+{
+	struct rockchip_dfi *info = to_rockchip_dfi(event->pmu);
+
+	if (!info->pmu_active++)
+		hrtimer_start(&info->pmu_timer, ns_to_ktime(DFI_PMU_POLL_NS),
+			      HRTIMER_MODE_REL_PINNED);
+
+	if (flags & PERF_EF_START)
+		rockchip_dfi_pmu_start(event, flags);
+
+	return 0;
+}
+
+static void rockchip_dfi_pmu_del(struct perf_event *event, int flags)
+{
+	struct rockchip_dfi *info = to_rockchip_dfi(event->pmu);
+
+	rockchip_dfi_pmu_stop(event, PERF_EF_UPDATE);
+	info->pmu_active--;
+}
+
+static enum hrtimer_restart rockchip_dfi_pmu_timer(struct hrtimer *timer)
+{
+	struct rockchip_dfi *info = container_of(timer, struct rockchip_dfi, pmu_timer);
+	unsigned long flags;
+
+	if (!READ_ONCE(info->pmu_active))
+		return HRTIMER_NORESTART;
+
+	spin_lock_irqsave(&info->lock, flags);
+	rockchip_dfi_update_count(info->edev);
+	spin_unlock_irqrestore(&info->lock, flags);
+
+	hrtimer_forward_now(timer, ns_to_ktime(DFI_PMU_POLL_NS));
+
+	return HRTIMER_RESTART;
+}
+
+static ssize_t rockchip_dfi_pmu_cpumask_show(struct device *dev,
+					     struct device_attribute *attr,
+					     char *buf)
+{
+	struct rockchip_dfi *info = to_rockchip_dfi(dev_get_drvdata(dev));
+
+	return cpumap_print_to_pagebuf(true, buf, cpumask_of(info->pmu_cpu));
+}
+
+static struct device_attribute rockchip_dfi_pmu_cpumask_attr =
+	__ATTR(cpumask, 0444, rockchip_dfi_pmu_cpumask_show, NULL);
+
+static struct attribute *rockchip_dfi_pmu_cpumask_attrs[] = {
+	&rockchip_dfi_pmu_cpumask_attr.attr,
+	NULL,
+};
+
+static const struct attribute_group rockchip_dfi_pmu_cpumask_group = {
+	.attrs = rockchip_dfi_pmu_cpumask_attrs,
+};
+
+PMU_FORMAT_ATTR(event, "config:0-7");
+PMU_FORMAT_ATTR(chan, "config:8-11");
+
+static struct attribute *rockchip_dfi_pmu_format_attrs[] = {
+	&format_attr_event.attr,
+	&format_attr_chan.attr,
+	NULL,
+};
+
+static const struct attribute_group rockchip_dfi_pmu_format_group = {
+	.name = "format",
+	.attrs = rockchip_dfi_pmu_format_attrs,
+};
+
+PMU_EVENT_ATTR_STRING(cycles, rockchip_dfi_pmu_cycles, "event=0x0");
+PMU_EVENT_ATTR_STRING(bytes, rockchip_dfi_pmu_bytes, "event=0x1");
+PMU_EVENT_ATTR_STRING(read-bytes, rockchip_dfi_pmu_read_bytes, "event=0x2");
+PMU_EVENT_ATTR_STRING(write-bytes, rockchip_dfi_pmu_write_bytes, "event=0x3");
+PMU_EVENT_ATTR_STRING(ch0-bytes, rockchip_dfi_pmu_ch0_bytes, "event=0x1,chan=0x1");
+PMU_EVENT_ATTR_STRING(ch0-read-bytes, rockchip_dfi_pmu_ch0_read_bytes, "event=0x2,chan=0x1");
+PMU_EVENT_ATTR_STRING(ch0-write-bytes, rockchip_dfi_pmu_ch0_write_bytes, "event=0x3,chan=0x1");
+PMU_EVENT_ATTR_STRING(ch1-bytes, rockchip_dfi_pmu_ch1_bytes, "event=0x1,chan=0x2");
+PMU_EVENT_ATTR_STRING(ch1-read-bytes, rockchip_dfi_pmu_ch1_read_bytes, "event=0x2,chan=0x2");
+PMU_EVENT_ATTR_STRING(ch1-write-bytes, rockchip_dfi_pmu_ch1_write_bytes, "event=0x3,chan=0x2");
+PMU_EVENT_ATTR_STRING(ch2-bytes, rockchip_dfi_pmu_ch2_bytes, "event=0x1,chan=0x3");
+PMU_EVENT_ATTR_STRING(ch2-read-bytes, rockchip_dfi_pmu_ch2_read_bytes, "event=0x2,chan=0x3");
+PMU_EVENT_ATTR_STRING(ch2-write-bytes, rockchip_dfi_pmu_ch2_write_bytes, "event=0x3,chan=0x3");
+PMU_EVENT_ATTR_STRING(ch3-bytes, rockchip_dfi_pmu_ch3_bytes, "event=0x1,chan=0x4");
+PMU_EVENT_ATTR_STRING(ch3-read-bytes, rockchip_dfi_pmu_ch3_read_bytes, "event=0x2,chan=0x4");
+PMU_EVENT_ATTR_STRING(ch3-write-bytes, rockchip_dfi_pmu_ch3_write_bytes, "event=0x3,chan=0x4");
+
+static struct attribute *rockchip_dfi_pmu_event_attrs[] = {
+	&rockchip_dfi_pmu_cycles.attr.attr,
+	&rockchip_dfi_pmu_bytes.attr.attr,
+	&rockchip_dfi_pmu_read_bytes.attr.attr,
+	&rockchip_dfi_pmu_write_bytes.attr.attr,
+	&rockchip_dfi_pmu_ch0_bytes.attr.attr,
+	&rockchip_dfi_pmu_ch0_read_bytes.attr.attr,
+	&rockchip_dfi_pmu_ch0_write_bytes.attr.attr,
+	&rockchip_dfi_pmu_ch1_bytes.attr.attr,
+	&rockchip_dfi_pmu_ch1_read_bytes.attr.attr,
+	&rockchip_dfi_pmu_ch1_write_bytes.attr.attr,
+	&rockchip_dfi_pmu_ch2_bytes.attr.attr,
+	&rockchip_dfi_pmu_ch2_read_bytes.attr.attr,
+	&rockchip_dfi_pmu_ch2_write_bytes.attr.attr,
+	&rockchip_dfi_pmu_ch3_bytes.attr.attr,
+	&rockchip_dfi_pmu_ch3_read_bytes.attr.attr,
+	&rockchip_dfi_pmu_ch3_write_bytes.attr.attr,
+	NULL,
+};
+
+/* hide the channels which are not populated */
+static umode_t rockchip_dfi_pmu_event_visible(struct kobject *kobj,
+					      struct attribute *attr, int i)
+{
+	struct device *dev = kobj_to_dev(kobj);
+	struct rockchip_dfi *info = to_rockchip_dfi(dev_get_drvdata(dev));
+	int ch = (i - 4) / 3;
+
+	if (i >= 4 && !(info->ch_msk & BIT(ch)))
+		return 0;
+
+	return attr->mode;
+}
+
+static const struct attribute_group rockchip_dfi_pmu_event_group = {
+	.name = "events",
+	.attrs = rockchip_dfi_pmu_event_attrs,
+	.is_visible = rockchip_dfi_pmu_event_visible,
+};
+
+static const struct attribute_group *rockchip_dfi_pmu_attr_groups[] = {
+	&rockchip_dfi_pmu_cpumask_group,
+	&rockchip_dfi_pmu_format_group,
+	&rockchip_dfi_pmu_event_group,
+	NULL,
+};
+
+static int rockchip_dfi_pmu_offline_cpu(unsigned int cpu, struct hlist_node *node)
+{
+	struct rockchip_dfi *info = hlist_entry_safe(node, struct rockchip_dfi, pmu_node);
+	unsigned int target;
+
+	if (cpu != info->pmu_cpu)
+		return 0;
+
+	target = cpumask_any_but(cpu_online_mask, cpu);
+	if (target >= nr_cpu_ids)
+		return 0;
+
+	perf_pmu_migrate_context(&info->pmu, cpu, target);
+	info->pmu_cpu = target;
+
+	return 0;
+}
+
+static void rockchip_dfi_pmu_unregister(void *data)
+{
+	struct rockchip_dfi *info = data;
+
+	perf_pmu_unregister(&info->pmu);
+	cpuhp_state_remove_instance_nocalls(rockchip_dfi_pmu_cpuhp_state,
+					    &info->pmu_node);
+}
+
+static int rockchip_dfi_pmu_init(struct rockchip_dfi *info)
+{
+	int ret;
+
+	/* only the ddr monitor counters are exposed */
+	if (info->desc->ops != &rockchip_dfi_ops)
+		return 0;
+
+	if (!rockchip_dfi_pmu_cpuhp_state) {
+		ret = cpuhp_setup_state_multi(CPUHP_AP_ONLINE_DYN,
+					      "perf/rockchip_dfi:online",
+					      NULL, rockchip_dfi_pmu_offline_cpu);
+		if (ret < 0)
+			return ret;
+		rockchip_dfi_pmu_cpuhp_state = ret;
+	}
+
+	info->pmu = (struct pmu) {
+		.module		= THIS_MODULE,
+		.capabilities	= PERF_PMU_CAP_NO_EXCLUDE,
+		.task_ctx_nr	= perf_invalid_context,
+		.attr_groups	= rockchip_dfi_pmu_attr_groups,
+		.event_init	= rockchip_dfi_pmu_event_init,
+		.add		= rockchip_dfi_pmu_add,
+		.del		= rockchip_dfi_pmu_del,
+		.start		= rockchip_dfi_pmu_start,
+		.stop		= rockchip_dfi_pmu_stop,
+		.read		= rockchip_dfi_pmu_read,
+	};
+	info->pmu_cpu = raw_smp_processor_id();
+	hrtimer_init(&info->pmu_timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+	info->pmu_timer.function = rockchip_dfi_pmu_timer;
+
+	ret = cpuhp_state_add_instance_nocalls(rockchip_dfi_pmu_cpuhp_state,
+					       &info->pmu_node);
+	if (ret)
+		return ret;
+
+	ret = perf_pmu_register(&info->pmu, "rockchip_dfi", -1);
+	if (ret) {
+		cpuhp_state_remove_instance_nocalls(rockchip_dfi_pmu_cpuhp_state,
+						    &info->pmu_node);
+		return ret;
+	}
+
+	return devm_add_action_or_reset(info->dev, rockchip_dfi_pmu_unregister, info);
+}
+#else
+static int rockchip_dfi_pmu_init(struct rockchip_dfi *info)
+{
+	return 0;
+}
+#endif
+
 static __maybe_unused __init int rk3588_dfi_init(struct platform_device *pdev,
 						 struct rockchip_dfi *data,
 						 struct devfreq_event_desc *desc)
@@ -598,6 +1007,10 @@ static __maybe_unused __init int rk3588_dfi_init(struct platform_device *pdev,
 		data->count_rate = 2;
 	data->dram_dynamic_info_reg = RK3588_PMUGRF_OS_REG(6);
 	data->ch_msk = READ_CH_INFO(val_2) | READ_CH_INFO(val_4) << 2;
+	data->buswidth[0] = READ_BW_INFO(val_2, 0);
+	data->buswidth[1] = READ_BW_INFO(val_2, 1);
+	data->buswidth[2] = READ_BW_INFO(val_4, 0);
+	data->buswidth[3] = READ_BW_INFO(val_4, 1);
 	data->clk = NULL;
 
 	desc->ops = &rockchip_dfi_ops;
@@ -647,6 +1060,7 @@ static __maybe_unused __init int px30_dfi_init(struct platform_device *pdev,
 	else
 		data->dram_type = READ_DRAMTYPE_INFO(val_2);
 	data->ch_msk = 1;
+	data->buswidth[0] = READ_BW_INFO(val_2, 0);
 	data->clk = NULL;
 
 	desc->ops = &rockchip_dfi_ops;
@@ -756,6 +1170,8 @@ static __maybe_unused __init int rockchip_dfi_init(struct platform_device *pdev,
 	regmap_read(data->regmap_pmu, PMUGRF_OS_REG2, &val);
 	data->dram_type = READ_DRAMTYPE_INFO(val);
 	data->ch_msk = READ_CH_INFO(val);
+	data->buswidth[0] = READ_BW_INFO(val, 0);
+	data->buswidth[1] = READ_BW_INFO(val, 1);
 
 	desc->ops = &rockchip_dfi_ops;
 
@@ -785,6 +1201,7 @@ static __maybe_unused __init int rk3328_dfi_init(struct platform_device *pdev,
 	regmap_read(data->regmap_grf, RK3328_GRF_OS_REG2, &val);
 	data->dram_type = READ_DRAMTYPE_INFO(val);
 	data->ch_msk = 1;
+	data->buswidth[0] = READ_BW_INFO(val, 0);
 	data->clk = NULL;
 
 	desc->ops = &rockchip_dfi_ops;
@@ -820,6 +1237,7 @@ static __maybe_unused __init int rk3528_dfi_init(struct platform_device *pdev,
 		data->dram_type = READ_DRAMTYPE_INFO(val_18);
 	data->count_rate = 2;
 	data->ch_msk = 1;
+	data->buswidth[0] = READ_BW_INFO(val_18, 0);
 	data->clk = NULL;
 
 	desc->ops = &rockchip_dfi_ops;
@@ -883,6 +1301,7 @@ static int rockchip_dfi_probe(struct platform_device *pdev)
 	data = devm_kzalloc(dev, sizeof(struct rockchip_dfi), GFP_KERNEL);
 	if (!data)
 		return -ENOMEM;
+	spin_lock_init(&data->lock);
 
 	desc = devm_kzalloc(dev, sizeof(*desc), GFP_KERNEL);
 	if (!desc)
@@ -914,6 +1333,9 @@ static int rockchip_dfi_probe(struct platform_device *pdev)
 
 	platform_set_drvdata(pdev, data);
 
+	if (rockchip_dfi_pmu_init(data))
+		dev_warn(dev, "failed to register perf pmu\n");
+
 	return 0;
 }
 
@@ -17,6 +17,7 @@
 #include <linux/rockchip/rockchip_sip.h>
 #include <linux/slab.h>
 #include <linux/string.h>
+#include <soc/rockchip/rockchip_dmc.h>
 #include <soc/rockchip/rockchip_opp_select.h>
 
 #define CLUSTER0	0
@@ -27,12 +28,21 @@
 	container_of(nb, struct rockchip_bus, clk_nb)
 #define to_rockchip_bus_cpufreq_nb(nb) \
 	container_of(nb, struct rockchip_bus, cpufreq_nb)
+#define to_rockchip_bus_dmc_nb(nb) \
+	container_of(nb, struct rockchip_bus, dmc_nb)
+#define to_rockchip_bus_bw_nb(nb) \
+	container_of(nb, struct rockchip_bus, bw_nb)
 
 struct busfreq_table {
 	unsigned long freq;
 	unsigned long volt;
 };
 
+struct busfreq_map {
+	unsigned long in;
+	unsigned long rate;
+};
+
 struct rockchip_bus {
 	struct device *dev;
 	struct regulator *regulator;
@@ -57,6 +67,22 @@ struct rockchip_bus {
 	unsigned long low_rate;
 	unsigned int cpu_high_freq;
 	unsigned int cpu_freq[MAX_CLUSTERS];
+
+	/*
+	 * Busfreq-policy-dmcfreq:
+	 * Follow the dmc rate and the multimedia bandwidth votes, the bus
+	 * rate is the higher of the two mapped rates.
+	 */
+	struct mutex lock;
+	struct devfreq *dmc_devfreq;
+	struct notifier_block dmc_nb;
+	struct notifier_block bw_nb;
+	struct busfreq_map *dmc_map;
+	struct busfreq_map *bw_map;
+	int dmc_map_cnt;
+	int bw_map_cnt;
+	unsigned long dmc_rate;
+	unsigned long bw_rate;
 };
 
 static int rockchip_sip_bus_smc_config(u32 bus_id, u32 cfg, u32 enable_msk)
@@ -435,11 +461,9 @@ static int rockchip_bus_cpufreq_notifier(struct notifier_block *nb,
 	return NOTIFY_OK;
 }
 
-static int rockchip_bus_cpufreq(struct rockchip_bus *bus)
+static int rockchip_bus_rate_init(struct rockchip_bus *bus)
 {
 	struct device *dev = bus->dev;
-	struct device_node *np = dev->of_node;
-	unsigned int freq;
 	int ret = 0;
 
 	if (of_parse_phandle(dev->of_node, "operating-points-v2", 0)) {
@@ -457,6 +481,20 @@ static int rockchip_bus_cpufreq(struct rockchip_bus *bus)
 		bus->regulator = NULL;
 	}
 
+	return 0;
+}
+
+static int rockchip_bus_cpufreq(struct rockchip_bus *bus)
+{
+	struct device *dev = bus->dev;
+	struct device_node *np = dev->of_node;
+	unsigned int freq;
+	int ret = 0;
+
+	ret = rockchip_bus_rate_init(bus);
+	if (ret)
+		return ret;
+
 	ret = of_property_read_u32(np, "cpu-high-freq", &bus->cpu_high_freq);
 	if (ret) {
 		dev_err(dev, "failed to get cpu-high-freq\n");
@@ -486,6 +524,176 @@ static int rockchip_bus_cpufreq(struct rockchip_bus *bus)
 	return 0;
 }
 
+static int rockchip_bus_get_map(struct device *dev, const char *prop_name,
+				struct busfreq_map **map, int *cnt)
+{
+	struct device_node *np = dev->of_node;
+	u32 *table;
+	int i, count, ret;
+
+	count = of_property_count_u32_elems(np, prop_name);
+	if (count <= 0)
+		return 0;
+	if (count % 2) {
+		dev_err(dev, "Invalid count of %s\n", prop_name);
+		return -EINVAL;
+	}
+
+	table = kmalloc_array(count, sizeof(u32), GFP_KERNEL);
+	if (!table)
+		return -ENOMEM;
+	ret = of_property_read_u32_array(np, prop_name, table, count);
+	if (ret)
+		goto out;
+
+	*map = devm_kcalloc(dev, count / 2, sizeof(**map), GFP_KERNEL);
+	if (!*map) {
+		ret = -ENOMEM;
+		goto out;
+	}
+	/* table[2n]: input, ascending, table[2n + 1]: bus rate in kHz */
+	for (i = 0; i < count / 2; i++) {
+		(*map)[i].in = table[2 * i];
+		(*map)[i].rate = table[2 * i + 1] * 1000UL;
+	}
+	*cnt = count / 2;
+out:
+	kfree(table);
+
+	return ret;
+}
+
+static unsigned long rockchip_bus_map_rate(struct busfreq_map *map, int cnt,
+					   unsigned long in)
+{
+	unsigned long rate = 0;
+	int i;
+
+	for (i = 0; i < cnt; i++) {
+		if (in < map[i].in)
+			break;
+		rate = map[i].rate;
+	}
+
+	return rate;
+}
+
+static void rockchip_bus_dmcfreq_update(struct rockchip_bus *bus)
+{
+	unsigned long target_rate;
+
+	mutex_lock(&bus->lock);
+	target_rate = max(bus->dmc_rate, bus->bw_rate);
+	if (target_rate && target_rate != bus->cur_rate) {
+		dev_dbg(bus->dev, "dmc %lu bw %lu, bus rate to %lu\n",
+			bus->dmc_rate, bus->bw_rate, target_rate);
+		rockchip_bus_cpufreq_target(bus->dev, target_rate, 0);
+	}
+	mutex_unlock(&bus->lock);
+}
+
+static int rockchip_bus_dmc_notifier(struct notifier_block *nb,
+				     unsigned long event, void *data)
+{
+	struct rockchip_bus *bus = to_rockchip_bus_dmc_nb(nb);
+	struct devfreq_freqs *freqs = data;
+
+	switch (event) {
+	case DEVFREQ_PRECHANGE:
+		/* raise the bus before the ddr gets faster */
+		if (freqs->new > freqs->old) {
+			bus->dmc_rate = rockchip_bus_map_rate(bus->dmc_map,
+							      bus->dmc_map_cnt,
+							      freqs->new / 1000);
+			rockchip_bus_dmcfreq_update(bus);
+		}
+		break;
+	case DEVFREQ_POSTCHANGE:
+		if (freqs->new < freqs->old) {
+			bus->dmc_rate = rockchip_bus_map_rate(bus->dmc_map,
+							      bus->dmc_map_cnt,
+							      freqs->new / 1000);
+			rockchip_bus_dmcfreq_update(bus);
+		}
+		break;
+	}
+
+	return NOTIFY_OK;
+}
+
+static int rockchip_bus_bw_notifier(struct notifier_block *nb,
+				    unsigned long event, void *data)
+{
+	struct rockchip_bus *bus = to_rockchip_bus_bw_nb(nb);
+	u64 *mbyte = data;
+
+	bus->bw_rate = rockchip_bus_map_rate(bus->bw_map, bus->bw_map_cnt,
+					     *mbyte);
+	rockchip_bus_dmcfreq_update(bus);
+
+	return NOTIFY_OK;
+}
+
+static int rockchip_bus_dmcfreq(struct rockchip_bus *bus)
+{
+	struct device *dev = bus->dev;
+	int ret = 0;
+
+	mutex_init(&bus->lock);
+
+	ret = rockchip_bus_get_map(dev, "rockchip,dmc-freq-table",
+				   &bus->dmc_map, &bus->dmc_map_cnt);
+	if (ret)
+		return ret;
+	ret = rockchip_bus_get_map(dev, "rockchip,bw-freq-table",
+				   &bus->bw_map, &bus->bw_map_cnt);
+	if (ret)
+		return ret;
+	if (!bus->dmc_map_cnt && !bus->bw_map_cnt) {
+		dev_err(dev, "failed to get dmc or bw freq table\n");
+		return -EINVAL;
+	}
+
+	ret = rockchip_bus_rate_init(bus);
+	if (ret)
+		return ret;
+	bus->cur_rate = clk_get_rate(bus->clk);
+
+	if (bus->dmc_map_cnt) {
+		bus->dmc_devfreq = devfreq_get_devfreq_by_phandle(dev, "devfreq", 0);
+		if (IS_ERR(bus->dmc_devfreq)) {
+			ret = PTR_ERR(bus->dmc_devfreq);
+			if (ret != -EPROBE_DEFER)
+				dev_err(dev, "failed to get dmc devfreq\n");
+			return ret;
+		}
+		bus->dmc_rate = rockchip_bus_map_rate(bus->dmc_map,
+						      bus->dmc_map_cnt,
+						      bus->dmc_devfreq->previous_freq / 1000);
+		rockchip_bus_dmcfreq_update(bus);
+
+		bus->dmc_nb.notifier_call = rockchip_bus_dmc_notifier;
+		ret = devm_devfreq_register_notifier(dev, bus->dmc_devfreq,
+						     &bus->dmc_nb,
+						     DEVFREQ_TRANSITION_NOTIFIER);
+		if (ret) {
+			dev_err(dev, "failed to register dmc notifier\n");
+			return ret;
+		}
+	}
+
+	if (bus->bw_map_cnt) {
+		bus->bw_nb.notifier_call = rockchip_bus_bw_notifier;
+		ret = rockchip_dmcfreq_bw_register_notifier(&bus->bw_nb);
+		if (ret) {
+			dev_err(dev, "failed to register bw notifier\n");
+			return ret;
+		}
+	}
+
+	return 0;
+}
+
 static const struct of_device_id rockchip_busfreq_of_match[] = {
 	{ .compatible = "rockchip,px30-bus", },
 	{ .compatible = "rockchip,rk1808-bus", },
@@ -529,6 +737,8 @@ static int rockchip_busfreq_probe(struct platform_device *pdev)
 		ret = rockchip_bus_clkfreq(bus);
 	else if (!strcmp(policy_name, "cpufreq"))
 		ret = rockchip_bus_cpufreq(bus);
+	else if (!strcmp(policy_name, "dmcfreq"))
+		ret = rockchip_bus_dmcfreq(bus);
 
 	return ret;
 }
@@ -53,6 +53,8 @@
 						  status_nb)
 #define reboot_to_dmcfreq(nb) container_of(nb, struct rockchip_dmcfreq, \
 					   reboot_nb)
+#define video_to_dmcfreq(nb) container_of(nb, struct rockchip_dmcfreq, \
+					  video_nb)
 #define boost_to_dmcfreq(work) container_of(work, struct rockchip_dmcfreq, \
 					    boost_work)
 #define input_hd_to_dmcfreq(hd) container_of(hd, struct rockchip_dmcfreq, \
@@ -113,6 +115,8 @@ struct rockchip_dmcfreq {
 	struct dram_timing *timing;
 	struct notifier_block status_nb;
 	struct notifier_block panic_nb;
+	struct notifier_block video_nb;
+	struct dmcfreq_bw_req video_bw_req;
 	struct list_head video_info_list;
 	struct freq_map_table *cpu_bw_tbl;
 	struct work_struct boost_work;
@@ -160,15 +164,52 @@ struct rockchip_dmcfreq {
 
 	bool is_fixed;
 	bool is_set_rate_direct;
+	bool video_bw_en;
 
 	unsigned int touchboostpulse_duration_val;
 	u64 touchboostpulse_endtime;
 
+	unsigned int down_delay_ms;
+	u64 last_switch_time;
+
 	int (*set_auto_self_refresh)(u32 en);
 };
 
 static struct pm_qos_request pm_qos;
 
+#define DMC_LAT_HIST_NUM	8
+
+static const unsigned int dmc_lat_hist_us[DMC_LAT_HIST_NUM - 1] = {
+	50, 100, 200, 500, 1000, 2000, 5000,
+};
+
+struct dmcfreq_lat_stats {
+	u64 count;
+	u64 total_us;
+	unsigned int max_us;
+	unsigned int hist[DMC_LAT_HIST_NUM];
+};
+
+/* updated with the dmcfreq write lock held */
+static struct dmcfreq_lat_stats dmc_switch_stats;
+static struct dmcfreq_lat_stats dmc_wait_stats;
+
+static void rockchip_dmcfreq_lat_record(struct dmcfreq_lat_stats *stats,
+					ktime_t start)
+{
+	unsigned int us = ktime_us_delta(ktime_get(), start);
+	int i;
+
+	for (i = 0; i < DMC_LAT_HIST_NUM - 1; i++)
+		if (us < dmc_lat_hist_us[i])
+			break;
+	stats->hist[i]++;
+	stats->count++;
+	stats->total_us += us;
+	if (us > stats->max_us)
+		stats->max_us = us;
+}
+
 static int rockchip_dmcfreq_check_rate_volt(struct monitor_dev_info *info);
 
 static struct monitor_dev_profile dmc_mdevp = {
@@ -389,6 +430,7 @@ static int rockchip_dmcfreq_opp_set_rate(struct device *dev,
 	struct cpufreq_policy *policy;
 	bool is_cpufreq_changed = false;
 	unsigned int cpu_cur, cpufreq_cur;
+	ktime_t start;
 	int ret = 0;
 
 	vdd_reg = opp_info->regulators[0];
@@ -473,6 +515,7 @@ static int rockchip_dmcfreq_opp_set_rate(struct device *dev,
 	while (!rockchip_dmcfreq_write_trylock())
 		cond_resched();
 	dev_dbg(dev, "%lu Hz --> %lu Hz\n", old_freq, new_freq);
+	start = ktime_get();
 
 	if (dmcfreq->set_rate_params) {
 		dmcfreq->set_rate_params->lcdc_type = rk_drm_get_lcdc_type();
@@ -485,6 +528,8 @@ static int rockchip_dmcfreq_opp_set_rate(struct device *dev,
 	else
 		ret = clk_set_rate(clk, new_freq);
 
+	rockchip_dmcfreq_lat_record(&dmc_switch_stats, start);
+	dmcfreq->last_switch_time = ktime_to_us(ktime_get());
 	rockchip_dmcfreq_write_unlock();
 	if (ret) {
 		dev_err(dev, "%s: failed to set clock rate: %d\n", __func__,
@@ -601,6 +646,7 @@ static int rockchip_dmcfreq_get_dev_status(struct device *dev,
 	struct rockchip_dmcfreq *dmcfreq = dev_get_drvdata(dev);
 	struct rockchip_opp_info *opp_info = &dmcfreq->opp_info;
 	struct devfreq_event_data edata;
+	struct dmcfreq_load load;
 	int i, ret = 0;
 
 	if (!dmcfreq->info.auto_freq_en)
@@ -629,6 +675,13 @@ static int rockchip_dmcfreq_get_dev_status(struct device *dev,
 out:
 	rockchip_opp_dvfs_unlock(opp_info);
 
+	if (!ret && dmcfreq->dfi_id >= 0) {
+		load.status = rockchip_get_system_status();
+		load.busy_time = stat->busy_time;
+		load.total_time = stat->total_time;
+		rockchip_dmcfreq_load_notify(&load);
+	}
+
 	return ret;
 }
 
@@ -1138,12 +1191,14 @@ static irqreturn_t wait_dcf_complete_irq(int irqno, void *dev_id)
 int rockchip_dmcfreq_wait_complete(void)
 {
 	struct arm_smccc_res res;
+	ktime_t start;
 
 	if (!wait_ctrl.wait_en) {
 		pr_err("%s: Do not support time out!\n", __func__);
 		return 0;
 	}
 	wait_ctrl.wait_flag = -1;
+	start = ktime_get();
 
 	enable_irq(wait_ctrl.complt_irq);
 	/*
@@ -1179,6 +1234,7 @@ int rockchip_dmcfreq_wait_complete(void)
 
 	cpu_latency_qos_update_request(&pm_qos, PM_QOS_DEFAULT_VALUE);
 	disable_irq(wait_ctrl.complt_irq);
+	rockchip_dmcfreq_lat_record(&dmc_wait_stats, start);
 
 	return 0;
 }
@@ -2552,22 +2608,26 @@ static int rockchip_dmcfreq_system_status_notifier(struct notifier_block *nb,
 			target_rate = dmcfreq->hdmirx_rate;
 	}
 
-	if (dmcfreq->video_4k_rate && (status & SYS_STATUS_VIDEO_4K)) {
+	if (dmcfreq->video_4k_rate && !dmcfreq->video_bw_en &&
+	    (status & SYS_STATUS_VIDEO_4K)) {
 		if (dmcfreq->video_4k_rate > target_rate)
 			target_rate = dmcfreq->video_4k_rate;
 	}
 
-	if (dmcfreq->video_4k_10b_rate && (status & SYS_STATUS_VIDEO_4K_10B)) {
+	if (dmcfreq->video_4k_10b_rate && !dmcfreq->video_bw_en &&
+	    (status & SYS_STATUS_VIDEO_4K_10B)) {
 		if (dmcfreq->video_4k_10b_rate > target_rate)
 			target_rate = dmcfreq->video_4k_10b_rate;
 	}
 
-	if (dmcfreq->video_4k_60p_rate && (status & SYS_STATUS_VIDEO_4K_60P)) {
+	if (dmcfreq->video_4k_60p_rate && !dmcfreq->video_bw_en &&
+	    (status & SYS_STATUS_VIDEO_4K_60P)) {
 		if (dmcfreq->video_4k_60p_rate > target_rate)
 			target_rate = dmcfreq->video_4k_60p_rate;
 	}
 
-	if (dmcfreq->video_1080p_rate && (status & SYS_STATUS_VIDEO_1080P)) {
+	if (dmcfreq->video_1080p_rate && !dmcfreq->video_bw_en &&
+	    (status & SYS_STATUS_VIDEO_1080P)) {
 		if (dmcfreq->video_1080p_rate > target_rate)
 			target_rate = dmcfreq->video_1080p_rate;
 	}
@@ -2592,6 +2652,29 @@ static int rockchip_dmcfreq_system_status_notifier(struct notifier_block *nb,
 	return NOTIFY_OK;
 }
 
+/*
+ * DDR traffic of video decoding, in tenths of a byte per decoded pixel:
+ * the 4:2:0 frame is written once, read back about twice as a reference
+ * and once for display, 1.5 bytes per pixel each time (1.875 at 10 bit).
+ */
+#define VIDEO_DDR_BYTES_X10		60
+#define VIDEO_DDR_BYTES_10BIT_X10	75
+
+static int rockchip_dmcfreq_video_load_notifier(struct notifier_block *nb,
+						unsigned long action, void *ptr)
+{
+	struct rockchip_dmcfreq *dmcfreq = video_to_dmcfreq(nb);
+	struct rockchip_video_load *load = ptr;
+	u64 bytes;
+
+	bytes = load->pixel_rate * VIDEO_DDR_BYTES_X10 +
+		load->pixel_rate_10bit * VIDEO_DDR_BYTES_10BIT_X10;
+	rockchip_dmcfreq_bw_req_update(&dmcfreq->video_bw_req,
+				       div_u64(bytes, 10 * 1000000));
+
+	return NOTIFY_OK;
+}
+
 static int rockchip_dmcfreq_panic_notifier(struct notifier_block *nb,
 					   unsigned long v, void *p)
 {
@@ -2692,6 +2775,78 @@ static ssize_t downdifferential_store(struct device *dev,
 
 static DEVICE_ATTR_RW(downdifferential);
 
+static ssize_t down_delay_ms_show(struct device *dev,
+				  struct device_attribute *attr,
+				  char *buf)
+{
+	struct rockchip_dmcfreq *dmcfreq = dev_get_drvdata(dev->parent);
+
+	return sprintf(buf, "%u\n", dmcfreq->down_delay_ms);
+}
+
+static ssize_t down_delay_ms_store(struct device *dev,
+				   struct device_attribute *attr,
+				   const char *buf,
+				   size_t count)
+{
+	struct rockchip_dmcfreq *dmcfreq = dev_get_drvdata(dev->parent);
+	unsigned int value;
+
+	if (kstrtouint(buf, 10, &value))
+		return -EINVAL;
+
+	dmcfreq->down_delay_ms = value;
+
+	return count;
+}
+
+static DEVICE_ATTR_RW(down_delay_ms);
+
+static int rockchip_dmcfreq_lat_show(char *buf, int len, const char *name,
+				     struct dmcfreq_lat_stats *stats)
+{
+	u64 avg = stats->count ? div64_u64(stats->total_us, stats->count) : 0;
+	int i;
+
+	len += sysfs_emit_at(buf, len, "%s: count %llu avg %llu us max %u us\n",
+			     name, stats->count, avg, stats->max_us);
+	for (i = 0; i < DMC_LAT_HIST_NUM - 1; i++)
+		len += sysfs_emit_at(buf, len, "  < %5u us: %u\n",
+				     dmc_lat_hist_us[i], stats->hist[i]);
+	len += sysfs_emit_at(buf, len, "  >=%5u us: %u\n",
+			     dmc_lat_hist_us[i - 1], stats->hist[i]);
+
+	return len;
+}
+
+static ssize_t switch_stats_show(struct device *dev,
+				 struct device_attribute *attr,
+				 char *buf)
+{
+	int len = 0;
+
+	len = rockchip_dmcfreq_lat_show(buf, len, "switch", &dmc_switch_stats);
+	len = rockchip_dmcfreq_lat_show(buf, len, "wait", &dmc_wait_stats);
+
+	return len;
+}
+
+static ssize_t switch_stats_store(struct device *dev,
+				  struct device_attribute *attr,
+				  const char *buf,
+				  size_t count)
+{
+	while (!rockchip_dmcfreq_write_trylock())
+		cond_resched();
+	memset(&dmc_switch_stats, 0, sizeof(dmc_switch_stats));
+	memset(&dmc_wait_stats, 0, sizeof(dmc_wait_stats));
+	rockchip_dmcfreq_write_unlock();
+
+	return count;
+}
+
+static DEVICE_ATTR_RW(switch_stats);
+
 static unsigned long get_nocp_req_rate(struct rockchip_dmcfreq *dmcfreq)
 {
 	unsigned long target = 0, cpu_bw = 0;
@@ -2732,6 +2887,7 @@ static int devfreq_dmc_ondemand_func(struct devfreq *df,
 		nocp_req_rate = get_nocp_req_rate(dmcfreq);
 		target_freq = max3(target_freq, nocp_req_rate,
 				   dmcfreq->info.vop_req_rate);
+		target_freq = max(target_freq, dmcfreq->info.bw_req_rate);
 		now = ktime_to_us(ktime_get());
 		if (now < dmcfreq->touchboostpulse_endtime)
 			target_freq = max(target_freq, dmcfreq->boost_rate);
@@ -2800,6 +2956,12 @@ static int devfreq_dmc_ondemand_func(struct devfreq *df,
 	b = div_u64(b, (upthreshold - downdifferential / 2));
 	*freq = max_t(unsigned long, target_freq, b);
 
+	/* Hold the current frequency for a while after a switch */
+	if (*freq < stat->current_frequency && dmcfreq->down_delay_ms &&
+	    now < dmcfreq->last_switch_time +
+		  dmcfreq->down_delay_ms * USEC_PER_MSEC)
+		*freq = stat->current_frequency;
+
 	return 0;
 
 reset_last_status:
@@ -3001,6 +3163,7 @@ static void rockchip_dmcfreq_parse_dt(struct rockchip_dmcfreq *dmcfreq)
 			     &dmcfreq->ondemand_data.upthreshold);
 	of_property_read_u32(np, "downdifferential",
 			     &dmcfreq->ondemand_data.downdifferential);
+	of_property_read_u32(np, "down-delay-ms", &dmcfreq->down_delay_ms);
 	if (dmcfreq->info.auto_freq_en)
 		of_property_read_u32(np, "auto-freq-en",
 				     &dmcfreq->info.auto_freq_en);
@@ -3019,6 +3182,11 @@ static void rockchip_dmcfreq_parse_dt(struct rockchip_dmcfreq *dmcfreq)
 	if (rockchip_get_freq_map_talbe(np, "vop-bw-dmc-freq",
 					&dmcfreq->info.vop_bw_tbl))
 		dev_err(dev, "failed to get vop bandwidth to dmc rate\n");
+	of_property_read_u32(np, "bw-req-bus-bytes",
+			     &dmcfreq->info.bw_bus_bytes);
+	of_property_read_u32(np, "bw-req-util", &dmcfreq->info.bw_util);
+	of_property_read_u32(np, "bw-req-headroom",
+			     &dmcfreq->info.bw_headroom);
 	if (rockchip_get_rl_map_talbe(np, "vop-pn-msch-readlatency",
 				      &dmcfreq->info.vop_pn_rl_tbl))
 		dev_err(dev, "failed to get vop pn to msch rl\n");
@@ -3087,6 +3255,27 @@ static void rockchip_dmcfreq_register_notifier(struct rockchip_dmcfreq *dmcfreq)
 			dev_err(dmcfreq->dev, "failed to register system_status nb\n");
 	}
 
+	/*
+	 * With bandwidth requests available, size the rate for the actual
+	 * video streams instead of the worst case video status rates.
+	 */
+	if (dmcfreq->info.auto_freq_en && dmcfreq->info.bw_bus_bytes &&
+	    dmcfreq->info.bw_util) {
+		struct rockchip_video_load load;
+
+		rockchip_dmcfreq_bw_req_add(&dmcfreq->video_bw_req, "video");
+		dmcfreq->video_nb.notifier_call =
+			rockchip_dmcfreq_video_load_notifier;
+		if (!rockchip_register_video_load_notifier(&dmcfreq->video_nb)) {
+			dmcfreq->video_bw_en = true;
+			rockchip_get_video_load(&load);
+			rockchip_dmcfreq_video_load_notifier(&dmcfreq->video_nb,
+							     0, &load);
+		} else {
+			rockchip_dmcfreq_bw_req_remove(&dmcfreq->video_bw_req);
+		}
+	}
+
 	dmcfreq->panic_nb.notifier_call = rockchip_dmcfreq_panic_notifier;
 	ret = atomic_notifier_chain_register(&panic_notifier_list,
 					     &dmcfreq->panic_nb);
@@ -3115,6 +3304,14 @@ static void rockchip_dmcfreq_add_interface(struct rockchip_dmcfreq *dmcfreq)
 			      &dev_attr_downdifferential.attr))
 		dev_err(dmcfreq->dev,
 			"failed to register downdifferential sysfs file\n");
+	if (sysfs_create_file(&devfreq->dev.kobj,
+			      &dev_attr_down_delay_ms.attr))
+		dev_err(dmcfreq->dev,
+			"failed to register down_delay_ms sysfs file\n");
+	if (sysfs_create_file(&devfreq->dev.kobj,
+			      &dev_attr_switch_stats.attr))
+		dev_err(dmcfreq->dev,
+			"failed to register switch_stats sysfs file\n");
 
 	if (!rockchip_add_system_status_interface(&devfreq->dev))
 		return;
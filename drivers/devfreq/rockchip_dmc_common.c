@@ -6,7 +6,10 @@
  * Author: Finley Xiao <finley.xiao@rock-chips.com>
  */
 
+#include <linux/math64.h>
 #include <linux/module.h>
+#include <linux/mutex.h>
+#include <linux/notifier.h>
 #include <soc/rockchip/rockchip_dmc.h>
 
 #define msch_rl_to_dmcfreq(work) container_of(to_delayed_work(work), \
@@ -14,8 +17,16 @@
 					      msch_rl_work)
 #define MSCH_RL_DELAY_TIME	50 /* ms */
 
+#define BW_REQ_DEF_BUS_BYTES	4
+#define BW_REQ_DEF_UTIL		60 /* percent */
+#define BW_REQ_DEF_HEADROOM	25 /* percent */
+
 static struct dmcfreq_common_info *common_info;
 static DECLARE_RWSEM(rockchip_dmcfreq_sem);
+static LIST_HEAD(bw_req_list);
+static DEFINE_MUTEX(bw_req_lock);
+static BLOCKING_NOTIFIER_HEAD(bw_req_notifier);
+static BLOCKING_NOTIFIER_HEAD(load_notifier);
 
 void rockchip_dmcfreq_lock(void)
 {
@@ -70,7 +81,16 @@ int rockchip_dmcfreq_vop_bandwidth_init(struct dmcfreq_common_info *info)
 {
 	if (info->set_msch_readlatency)
 		INIT_DELAYED_WORK(&info->msch_rl_work, set_msch_rl_work);
+	if (!info->bw_bus_bytes)
+		info->bw_bus_bytes = BW_REQ_DEF_BUS_BYTES;
+	if (!info->bw_util || info->bw_util > 100)
+		info->bw_util = BW_REQ_DEF_UTIL;
+	if (!info->bw_headroom)
+		info->bw_headroom = BW_REQ_DEF_HEADROOM;
+
+	mutex_lock(&bw_req_lock);
 	common_info = info;
+	mutex_unlock(&bw_req_lock);
 
 	return 0;
 }
@@ -166,6 +186,108 @@ int rockchip_dmcfreq_vop_bandwidth_request(struct dmcfreq_vop_info *vop_info)
 }
 EXPORT_SYMBOL(rockchip_dmcfreq_vop_bandwidth_request);
 
+/*
+ * Convert the sum of all registered bandwidth votes to a ddr rate: the
+ * ddr moves 2 * bus_bytes per clock and only bw_util percent of that is
+ * usable, plus bw_headroom percent on top of the request.
+ */
+static void rockchip_dmcfreq_bw_req_apply(void)
+{
+	struct dmcfreq_bw_req *req;
+	unsigned long last_rate;
+	u64 mbyte = 0, rate;
+
+	if (!common_info)
+		return;
+
+	list_for_each_entry(req, &bw_req_list, node)
+		mbyte += req->mbyte;
+
+	rate = div_u64(mbyte * (100 + common_info->bw_headroom),
+		       2 * common_info->bw_bus_bytes * common_info->bw_util);
+	rate *= 1000000;
+
+	last_rate = common_info->bw_req_rate;
+	common_info->bw_req_rate = rate;
+	dev_dbg(common_info->dev, "bw req %llu MB/s, rate %lu -> %llu\n",
+		mbyte, last_rate, rate);
+
+	if (common_info->auto_freq_en && common_info->devfreq &&
+	    rate > last_rate) {
+		mutex_lock(&common_info->devfreq->lock);
+		update_devfreq(common_info->devfreq);
+		mutex_unlock(&common_info->devfreq->lock);
+	}
+
+	blocking_notifier_call_chain(&bw_req_notifier, 0, &mbyte);
+}
+
+void rockchip_dmcfreq_bw_req_add(struct dmcfreq_bw_req *req, const char *name)
+{
+	req->name = name;
+	req->mbyte = 0;
+	mutex_lock(&bw_req_lock);
+	list_add_tail(&req->node, &bw_req_list);
+	mutex_unlock(&bw_req_lock);
+}
+EXPORT_SYMBOL(rockchip_dmcfreq_bw_req_add);
+
+void rockchip_dmcfreq_bw_req_update(struct dmcfreq_bw_req *req,
+				    unsigned int mbyte)
+{
+	mutex_lock(&bw_req_lock);
+	if (req->mbyte != mbyte) {
+		req->mbyte = mbyte;
+		rockchip_dmcfreq_bw_req_apply();
+	}
+	mutex_unlock(&bw_req_lock);
+}
+EXPORT_SYMBOL(rockchip_dmcfreq_bw_req_update);
+
+void rockchip_dmcfreq_bw_req_remove(struct dmcfreq_bw_req *req)
+{
+	mutex_lock(&bw_req_lock);
+	list_del(&req->node);
+	if (req->mbyte) {
+		req->mbyte = 0;
+		rockchip_dmcfreq_bw_req_apply();
+	}
+	mutex_unlock(&bw_req_lock);
+}
+EXPORT_SYMBOL(rockchip_dmcfreq_bw_req_remove);
+
+/* notified with a pointer to the u64 sum of all votes in MB/s */
+int rockchip_dmcfreq_bw_register_notifier(struct notifier_block *nb)
+{
+	return blocking_notifier_chain_register(&bw_req_notifier, nb);
+}
+EXPORT_SYMBOL(rockchip_dmcfreq_bw_register_notifier);
+
+int rockchip_dmcfreq_bw_unregister_notifier(struct notifier_block *nb)
+{
+	return blocking_notifier_chain_unregister(&bw_req_notifier, nb);
+}
+EXPORT_SYMBOL(rockchip_dmcfreq_bw_unregister_notifier);
+
+void rockchip_dmcfreq_load_notify(struct dmcfreq_load *load)
+{
+	blocking_notifier_call_chain(&load_notifier, 0, load);
+}
+EXPORT_SYMBOL(rockchip_dmcfreq_load_notify);
+
+/* notified with a pointer to struct dmcfreq_load on every devfreq poll */
+int rockchip_dmcfreq_load_register_notifier(struct notifier_block *nb)
+{
+	return blocking_notifier_chain_register(&load_notifier, nb);
+}
+EXPORT_SYMBOL(rockchip_dmcfreq_load_register_notifier);
+
+int rockchip_dmcfreq_load_unregister_notifier(struct notifier_block *nb)
+{
+	return blocking_notifier_chain_unregister(&load_notifier, nb);
+}
+EXPORT_SYMBOL(rockchip_dmcfreq_load_unregister_notifier);
+
 unsigned int rockchip_dmcfreq_get_stall_time_ns(void)
 {
 	if (!common_info)
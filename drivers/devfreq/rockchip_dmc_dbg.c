@@ -2,18 +2,25 @@
 /*
  * Copyright (c) 2020, Rockchip Electronics Co., Ltd.
  */
+#include <linux/math64.h>
 #include <linux/module.h>
+#include <linux/mutex.h>
 #include <linux/nospec.h>
+#include <linux/notifier.h>
 #include <linux/of.h>
 #include <linux/platform_device.h>
 #include <linux/proc_fs.h>
 #include <linux/rockchip/rockchip_sip.h>
 #include <linux/seq_file.h>
+#include <linux/spinlock.h>
 #include <linux/string.h>
 #include <linux/uaccess.h>
 #include <linux/vmalloc.h>
+#include <linux/workqueue.h>
 
+#include <soc/rockchip/rockchip_dmc.h>
 #include <soc/rockchip/rockchip_sip.h>
+#include <soc/rockchip/rockchip-system-status.h>
 
 #include "rockchip_dmc_timing.h"
 
@@ -29,6 +36,7 @@
 #define PROC_DMCDBG_DRVODT			"drvodt"
 #define PROC_DMCDBG_DESKEW			"deskew"
 #define PROC_DMCDBG_REGS_INFO			"regsinfo"
+#define PROC_DMCDBG_AUTOIDLE			"autoidle"
 
 #define DDRDBG_FUNC_GET_VERSION			(0x01)
 #define DDRDBG_FUNC_GET_SUPPORTED		(0x02)
@@ -51,6 +59,23 @@
 #define SKEW_GROUP_NUM_MAX			(6)
 #define SKEW_TIMING_NUM_MAX			(50)
 
+/*
+ * Auto idle: the DFI utilization of each devfreq poll (50ms) is binned,
+ * and the windows are judged in groups of AUTOIDLE_WINDOWS. Light traffic
+ * (bins 1%..25%) means short idle gaps, on which the DRAM keeps entering
+ * and leaving power-down/self-refresh for nothing; the idle thresholds are
+ * then scaled up until the traffic is either idle or busy again.
+ */
+#define AUTOIDLE_BUCKETS			(6)
+#define AUTOIDLE_LIGHT_FIRST			(1)
+#define AUTOIDLE_LIGHT_LAST			(3)
+#define AUTOIDLE_WINDOWS			(40)
+#define AUTOIDLE_RELAX_PCT			(60)
+#define AUTOIDLE_RESTORE_PCT			(30)
+#define AUTOIDLE_SCALE				(4)
+#define AUTOIDLE_PD_IDLE_MAX			(31)
+#define AUTOIDLE_SR_IDLE_MAX			(255)
+
 struct rockchip_dmcdbg {
 	struct device *dev;
 };
@@ -171,11 +196,56 @@ struct skew_group {
 	char *note;
 };
 
+enum autoidle_class {
+	AUTOIDLE_CLASS_NORMAL,
+	AUTOIDLE_CLASS_VIDEO,
+	AUTOIDLE_CLASS_CAMERA,
+	AUTOIDLE_CLASS_PERFORMANCE,
+	AUTOIDLE_CLASS_NUM,
+};
+
+static const char * const autoidle_class_name[] = {
+	"normal",
+	"video",
+	"camera",
+	"performance",
+};
+
+/* upper bound in percent of each utilization bucket but the last */
+static const unsigned int autoidle_bucket_pct[AUTOIDLE_BUCKETS - 1] = {
+	1, 5, 10, 25, 50,
+};
+
+static const char * const autoidle_bucket_name[] = {
+	"<1%", "1-5%", "5-10%", "10-25%", "25-50%", ">=50%",
+};
+
+struct dmcdbg_autoidle {
+	/* share memory, @base, @enabled and @relaxed */
+	struct mutex lock;
+	struct work_struct work;
+	struct notifier_block nb;
+	bool registered;
+	bool enabled;
+	bool relaxed;
+	struct power_save_info base;
+
+	/* sampling state, updated from the devfreq poll */
+	spinlock_t stat_lock;
+	bool want_relaxed;
+	unsigned int class;
+	unsigned int windows;
+	unsigned int light;
+	unsigned long hist[AUTOIDLE_CLASS_NUM][AUTOIDLE_BUCKETS];
+	unsigned long relax_count;
+};
+
 struct rockchip_dmcdbg_data {
 	unsigned int inited_flag;
 	void __iomem *share_memory;
 	unsigned int skew_group_num;
 	struct skew_group skew_group[SKEW_GROUP_NUM_MAX];
+	struct dmcdbg_autoidle autoidle;
 };
 
 static struct rockchip_dmcdbg_data dmcdbg_data;
@@ -323,7 +393,9 @@ static int powersave_proc_show(struct seq_file *m, void *v)
 	struct power_save_info *p_power;
 	unsigned int *p_uint;
 	unsigned int i = 0;
+	int ret = 0;
 
+	mutex_lock(&dmcdbg_data.autoidle.lock);
 	/* get low power information */
 	res = sip_smc_dram(SHARE_PAGE_TYPE_DDRDBG,
 			   DDRDBG_FUNC_GET_POWERSAVE_INFO,
@@ -331,12 +403,14 @@ static int powersave_proc_show(struct seq_file *m, void *v)
 	if (res.a0) {
 		seq_printf(m, "rockchip_sip_config_dram_debug error:%lx\n",
 			   res.a0);
-		return -ENOMEM;
+		ret = -ENOMEM;
+		goto out;
 	}
 
 	if (!dmcdbg_data.inited_flag) {
 		seq_puts(m, "dmcdbg_data no int\n");
-		return -EPERM;
+		ret = -EPERM;
+		goto out;
 	}
 	p_power = (struct power_save_info *)dmcdbg_data.share_memory;
 
@@ -367,7 +441,9 @@ static int powersave_proc_show(struct seq_file *m, void *v)
 		   "  echo 0=1,1=32 > /proc/dmcdbg/powersave\n"
 		   );
 
-	return 0;
+out:
+	mutex_unlock(&dmcdbg_data.autoidle.lock);
+	return ret;
 }
 
 static int powersave_proc_open(struct inode *inode, struct file *file)
@@ -398,6 +474,7 @@ static ssize_t powersave_proc_write(struct file *file,
 		goto err;
 	}
 
+	mutex_lock(&dmcdbg_data.autoidle.lock);
 	/* get power save setting information */
 	res = sip_smc_dram(SHARE_PAGE_TYPE_DDRDBG,
 			   DDRDBG_FUNC_GET_POWERSAVE_INFO,
@@ -405,15 +482,20 @@ static ssize_t powersave_proc_write(struct file *file,
 	if (res.a0) {
 		pr_err("rockchip_sip_config_dram_debug error:%lx\n", res.a0);
 		ret = -ENOMEM;
-		goto err;
+		goto unlock;
 	}
 
 	if (!dmcdbg_data.inited_flag) {
 		pr_err("dmcdbg_data no int\n");
 		ret = -EPERM;
-		goto err;
+		goto unlock;
 	}
 	p_power = (struct power_save_info *)dmcdbg_data.share_memory;
+	/* edit on top of the baseline, not of the auto idle thresholds */
+	if (dmcdbg_data.autoidle.relaxed) {
+		p_power->pd_idle = dmcdbg_data.autoidle.base.pd_idle;
+		p_power->sr_idle = dmcdbg_data.autoidle.base.sr_idle;
+	}
 
 	loop = 0;
 	for (i = 0; i < count; i++) {
@@ -426,7 +508,7 @@ static ssize_t powersave_proc_write(struct file *file,
 		p_char = strsep(&cookie_pot, "=");
 		ret = kstrtol(p_char, 10, &long_val);
 		if (ret)
-			goto err;
+			goto unlock;
 		offset = long_val;
 
 		if (i == (loop - 1))
@@ -436,12 +518,12 @@ static ssize_t powersave_proc_write(struct file *file,
 
 		ret = kstrtol(p_char, 10, &long_val);
 		if (ret)
-			goto err;
+			goto unlock;
 		value = long_val;
 
 		if (offset >= ARRAY_SIZE(power_save_msg)) {
 			ret = -EINVAL;
-			goto err;
+			goto unlock;
 		}
 		offset = array_index_nospec(offset, ARRAY_SIZE(power_save_msg));
 
@@ -454,10 +536,21 @@ static ssize_t powersave_proc_write(struct file *file,
 	if (res.a0) {
 		pr_err("rockchip_sip_config_dram_debug error:%lx\n", res.a0);
 		ret = -ENOMEM;
-		goto err;
+		goto unlock;
 	}
 
+	/* a manual setting becomes the new auto idle baseline */
+	dmcdbg_data.autoidle.base = *p_power;
+	dmcdbg_data.autoidle.relaxed = false;
+	spin_lock(&dmcdbg_data.autoidle.stat_lock);
+	dmcdbg_data.autoidle.want_relaxed = false;
+	dmcdbg_data.autoidle.windows = 0;
+	dmcdbg_data.autoidle.light = 0;
+	spin_unlock(&dmcdbg_data.autoidle.stat_lock);
+
 	ret = count;
+unlock:
+	mutex_unlock(&dmcdbg_data.autoidle.lock);
 err:
 	vfree(buf);
 	return ret;
@@ -480,6 +573,264 @@ static int proc_powersave_init(void)
 	return 0;
 }
 
+static unsigned int autoidle_get_class(unsigned long status)
+{
+	if (status & (SYS_STATUS_PERFORMANCE | SYS_STATUS_BOOST))
+		return AUTOIDLE_CLASS_PERFORMANCE;
+	if (status & (SYS_STATUS_ISP | SYS_STATUS_CIF0 | SYS_STATUS_CIF1))
+		return AUTOIDLE_CLASS_CAMERA;
+	if (status & SYS_STATUS_VIDEO)
+		return AUTOIDLE_CLASS_VIDEO;
+
+	return AUTOIDLE_CLASS_NORMAL;
+}
+
+/* called with autoidle.lock held */
+static int autoidle_apply(bool relax)
+{
+	struct dmcdbg_autoidle *ai = &dmcdbg_data.autoidle;
+	struct power_save_info *p_power;
+	struct arm_smccc_res res;
+
+	res = sip_smc_dram(SHARE_PAGE_TYPE_DDRDBG,
+			   DDRDBG_FUNC_GET_POWERSAVE_INFO,
+			   ROCKCHIP_SIP_CONFIG_DRAM_DEBUG);
+	if (res.a0) {
+		pr_err("rockchip_sip_config_dram_debug error:%lx\n", res.a0);
+		return -ENOMEM;
+	}
+
+	p_power = (struct power_save_info *)dmcdbg_data.share_memory;
+	if (relax) {
+		p_power->pd_idle = min_t(unsigned int,
+					 ai->base.pd_idle * AUTOIDLE_SCALE,
+					 AUTOIDLE_PD_IDLE_MAX);
+		p_power->sr_idle = min_t(unsigned int,
+					 ai->base.sr_idle * AUTOIDLE_SCALE,
+					 AUTOIDLE_SR_IDLE_MAX);
+	} else {
+		p_power->pd_idle = ai->base.pd_idle;
+		p_power->sr_idle = ai->base.sr_idle;
+	}
+
+	/* keep the ddr frequency stable while the controller is reprogrammed */
+	rockchip_dmcfreq_lock();
+	res = sip_smc_dram(SHARE_PAGE_TYPE_DDRDBG, DDRDBG_FUNC_UPDATE_POWERSAVE,
+			   ROCKCHIP_SIP_CONFIG_DRAM_DEBUG);
+	rockchip_dmcfreq_unlock();
+	if (res.a0) {
+		pr_err("rockchip_sip_config_dram_debug error:%lx\n", res.a0);
+		return -ENOMEM;
+	}
+
+	ai->relaxed = relax;
+	if (relax)
+		ai->relax_count++;
+
+	return 0;
+}
+
+static void autoidle_work(struct work_struct *work)
+{
+	struct dmcdbg_autoidle *ai = &dmcdbg_data.autoidle;
+	bool relax;
+
+	mutex_lock(&ai->lock);
+	relax = READ_ONCE(ai->want_relaxed) && ai->enabled;
+	if (relax != ai->relaxed)
+		autoidle_apply(relax);
+	mutex_unlock(&ai->lock);
+}
+
+static int autoidle_load_notify(struct notifier_block *nb,
+				unsigned long action, void *data)
+{
+	struct dmcdbg_autoidle *ai = &dmcdbg_data.autoidle;
+	struct dmcfreq_load *load = data;
+	unsigned int class, util, bucket;
+	bool relax, changed;
+
+	if (!load->total_time)
+		return NOTIFY_OK;
+
+	util = div64_u64((u64)load->busy_time * 100, load->total_time);
+	for (bucket = 0; bucket < AUTOIDLE_BUCKETS - 1; bucket++)
+		if (util < autoidle_bucket_pct[bucket])
+			break;
+	class = autoidle_get_class(load->status);
+
+	spin_lock(&ai->stat_lock);
+	ai->hist[class][bucket]++;
+	relax = ai->want_relaxed;
+	if (class != ai->class) {
+		/* start over from the baseline on a status change */
+		ai->class = class;
+		ai->windows = 0;
+		ai->light = 0;
+		relax = false;
+	}
+	ai->windows++;
+	if (bucket >= AUTOIDLE_LIGHT_FIRST && bucket <= AUTOIDLE_LIGHT_LAST)
+		ai->light++;
+	if (class == AUTOIDLE_CLASS_PERFORMANCE) {
+		relax = false;
+	} else if (ai->windows >= AUTOIDLE_WINDOWS) {
+		if (ai->light * 100 >= ai->windows * AUTOIDLE_RELAX_PCT)
+			relax = true;
+		else if (ai->light * 100 < ai->windows * AUTOIDLE_RESTORE_PCT)
+			relax = false;
+		ai->windows = 0;
+		ai->light = 0;
+	}
+	changed = relax != ai->want_relaxed;
+	ai->want_relaxed = relax;
+	spin_unlock(&ai->stat_lock);
+
+	if (changed && READ_ONCE(ai->enabled))
+		schedule_work(&ai->work);
+
+	return NOTIFY_OK;
+}
+
+static int autoidle_proc_show(struct seq_file *m, void *v)
+{
+	struct dmcdbg_autoidle *ai = &dmcdbg_data.autoidle;
+	unsigned long hist[AUTOIDLE_CLASS_NUM][AUTOIDLE_BUCKETS];
+	unsigned int i, j;
+
+	spin_lock(&ai->stat_lock);
+	memcpy(hist, ai->hist, sizeof(hist));
+	spin_unlock(&ai->stat_lock);
+
+	mutex_lock(&ai->lock);
+	seq_printf(m,
+		   "auto idle: %s\n"
+		   "state: %s, relaxed %lu times\n"
+		   "baseline: pd_idle %u sr_idle %u\n"
+		   "relaxed: pd_idle %u sr_idle %u\n",
+		   ai->enabled ? "enabled" : "disabled",
+		   ai->relaxed ? "relaxed" : "baseline", ai->relax_count,
+		   ai->base.pd_idle, ai->base.sr_idle,
+		   min_t(unsigned int, ai->base.pd_idle * AUTOIDLE_SCALE,
+			 AUTOIDLE_PD_IDLE_MAX),
+		   min_t(unsigned int, ai->base.sr_idle * AUTOIDLE_SCALE,
+			 AUTOIDLE_SR_IDLE_MAX));
+	mutex_unlock(&ai->lock);
+
+	seq_puts(m, "\nddr utilization windows per system status:\n");
+	seq_printf(m, "%-12s", "");
+	for (j = 0; j < AUTOIDLE_BUCKETS; j++)
+		seq_printf(m, "%10s", autoidle_bucket_name[j]);
+	seq_puts(m, "\n");
+	for (i = 0; i < AUTOIDLE_CLASS_NUM; i++) {
+		seq_printf(m, "%-12s", autoidle_class_name[i]);
+		for (j = 0; j < AUTOIDLE_BUCKETS; j++)
+			seq_printf(m, "%10lu", hist[i][j]);
+		seq_puts(m, "\n");
+	}
+
+	seq_puts(m,
+		 "\n"
+		 "auto idle setting:\n"
+		 "echo 0 > /proc/dmcdbg/autoidle to disable and restore the baseline\n"
+		 "echo 1 > /proc/dmcdbg/autoidle to enable\n"
+		 );
+
+	return 0;
+}
+
+static int autoidle_proc_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, autoidle_proc_show, NULL);
+}
+
+static ssize_t autoidle_proc_write(struct file *file,
+				   const char __user *buffer,
+				   size_t count, loff_t *ppos)
+{
+	struct dmcdbg_autoidle *ai = &dmcdbg_data.autoidle;
+	bool enable;
+	int ret;
+
+	ret = kstrtobool_from_user(buffer, count, &enable);
+	if (ret)
+		return ret;
+
+	mutex_lock(&ai->lock);
+	WRITE_ONCE(ai->enabled, enable);
+	if (!enable && ai->relaxed)
+		ret = autoidle_apply(false);
+	mutex_unlock(&ai->lock);
+	if (ret)
+		return ret;
+
+	if (enable)
+		schedule_work(&ai->work);
+
+	return count;
+}
+
+static const struct file_operations autoidle_proc_fops = {
+	.open		= autoidle_proc_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+	.write		= autoidle_proc_write,
+};
+
+static int proc_autoidle_init(void)
+{
+	struct dmcdbg_autoidle *ai = &dmcdbg_data.autoidle;
+	struct arm_smccc_res res;
+	int ret;
+
+	/* the powersave setting from the dts is the baseline */
+	mutex_lock(&ai->lock);
+	res = sip_smc_dram(SHARE_PAGE_TYPE_DDRDBG,
+			   DDRDBG_FUNC_GET_POWERSAVE_INFO,
+			   ROCKCHIP_SIP_CONFIG_DRAM_DEBUG);
+	if (!res.a0)
+		ai->base = *(struct power_save_info *)dmcdbg_data.share_memory;
+	mutex_unlock(&ai->lock);
+	if (res.a0) {
+		pr_err("rockchip_sip_config_dram_debug error:%lx\n", res.a0);
+		return -ENOMEM;
+	}
+
+	ai->enabled = true;
+	ai->nb.notifier_call = autoidle_load_notify;
+	ret = rockchip_dmcfreq_load_register_notifier(&ai->nb);
+	if (ret) {
+		pr_err("failed to register dmcfreq load notifier\n");
+		return ret;
+	}
+	ai->registered = true;
+
+	/* create autoidle file */
+	proc_create(PROC_DMCDBG_AUTOIDLE, 0644, proc_dmcdbg_dir,
+		    &autoidle_proc_fops);
+
+	return 0;
+}
+
+static void autoidle_exit(void)
+{
+	struct dmcdbg_autoidle *ai = &dmcdbg_data.autoidle;
+
+	if (!ai->registered)
+		return;
+
+	rockchip_dmcfreq_load_unregister_notifier(&ai->nb);
+	ai->registered = false;
+	cancel_work_sync(&ai->work);
+
+	mutex_lock(&ai->lock);
+	ai->enabled = false;
+	if (ai->relaxed)
+		autoidle_apply(false);
+	mutex_unlock(&ai->lock);
+}
+
 static int drvodt_proc_show(struct seq_file *m, void *v)
 {
 	struct arm_smccc_res res;
@@ -1010,6 +1361,7 @@ static __maybe_unused int rv1126_dmcdbg_init(struct platform_device *pdev,
 	proc_drvodt_init();
 	proc_skew_init();
 	proc_regsinfo_init();
+	proc_autoidle_init();
 	return 0;
 }
 
@@ -1034,6 +1386,10 @@ static int rockchip_dmcdbg_probe(struct platform_device *pdev)
 
 	data->dev = dev;
 
+	mutex_init(&dmcdbg_data.autoidle.lock);
+	spin_lock_init(&dmcdbg_data.autoidle.stat_lock);
+	INIT_WORK(&dmcdbg_data.autoidle.work, autoidle_work);
+
 	/* match soc chip init */
 	match = of_match_node(rockchip_dmcdbg_of_match, pdev->dev.of_node);
 	if (match) {
@@ -1047,8 +1403,17 @@ static int rockchip_dmcdbg_probe(struct platform_device *pdev)
 	return ret;
 }
 
+static int rockchip_dmcdbg_remove(struct platform_device *pdev)
+{
+	autoidle_exit();
+	proc_remove(proc_dmcdbg_dir);
+
+	return 0;
+}
+
 static struct platform_driver rockchip_dmcdbg_driver = {
 	.probe	= rockchip_dmcdbg_probe,
+	.remove	= rockchip_dmcdbg_remove,
 	.driver = {
 		.name	= "rockchip,dmcdbg",
 		.of_match_table = rockchip_dmcdbg_of_match,
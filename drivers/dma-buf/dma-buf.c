@@ -79,11 +79,19 @@ EXPORT_SYMBOL_NS_GPL(dma_buf_get_each, MINIDUMP);
 #if IS_ENABLED(CONFIG_RK_DMABUF_DEBUG)
 static size_t db_total_size;
 static size_t db_peak_size;
+static LIST_HEAD(db_exp_stats);
+static LIST_HEAD(db_proc_stats);
 
 void dma_buf_reset_peak_size(void)
 {
+	struct dma_buf_owner_stats *stats;
+
 	mutex_lock(&db_list.lock);
 	db_peak_size = 0;
+	list_for_each_entry(stats, &db_exp_stats, node)
+		stats->peak = stats->size;
+	list_for_each_entry(stats, &db_proc_stats, node)
+		stats->peak = stats->size;
 	mutex_unlock(&db_list.lock);
 }
 EXPORT_SYMBOL_GPL(dma_buf_reset_peak_size);
@@ -111,6 +119,161 @@ size_t dma_buf_get_total_size(void)
 	return sz;
 }
 EXPORT_SYMBOL_GPL(dma_buf_get_total_size);
+
+/* Called with db_list.lock held */
+static struct dma_buf_owner_stats *dma_buf_exp_stats_get(const char *exp_name)
+{
+	struct dma_buf_owner_stats *stats;
+
+	list_for_each_entry(stats, &db_exp_stats, node) {
+		if (!strncmp(stats->name, exp_name, sizeof(stats->name) - 1))
+			return stats;
+	}
+
+	stats = kzalloc(sizeof(*stats), GFP_KERNEL);
+	if (!stats)
+		return NULL;
+
+	strscpy(stats->name, exp_name, sizeof(stats->name));
+	list_add_tail(&stats->node, &db_exp_stats);
+
+	return stats;
+}
+
+/* Called with db_list.lock held */
+static struct dma_buf_owner_stats *dma_buf_proc_stats_get(void)
+{
+	struct dma_buf_owner_stats *stats;
+
+	list_for_each_entry(stats, &db_proc_stats, node) {
+		if (stats->tgid == current->tgid)
+			return stats;
+	}
+
+	stats = kzalloc(sizeof(*stats), GFP_KERNEL);
+	if (!stats)
+		return NULL;
+
+	stats->tgid = current->tgid;
+	__get_task_comm(stats->name, sizeof(stats->name), current->group_leader);
+	list_add_tail(&stats->node, &db_proc_stats);
+
+	return stats;
+}
+
+/* Called with db_list.lock held */
+static void dma_buf_owner_stats_add(struct dma_buf_owner_stats *stats,
+				    struct dma_buf *dmabuf)
+{
+	if (!stats)
+		return;
+
+	stats->size += dmabuf->size;
+	stats->peak = max(stats->size, stats->peak);
+	stats->count++;
+}
+
+/* Called with db_list.lock held */
+static void dma_buf_owner_stats_del(struct dma_buf_owner_stats *stats,
+				    struct dma_buf *dmabuf)
+{
+	int i;
+
+	if (!stats)
+		return;
+
+	stats->size -= dmabuf->size;
+	stats->count--;
+	for (i = 0; i < DMA_BUF_STATS_ORDERS; i++)
+		stats->chunks[i] -= dmabuf->chunks[i];
+
+	/* Exporters are kept to report their peak, processes come and go */
+	if (stats->tgid && !stats->count) {
+		list_del(&stats->node);
+		kfree(stats);
+	}
+}
+
+static void dma_buf_stats_export(struct dma_buf *dmabuf)
+{
+	dmabuf->exp_stats = dma_buf_exp_stats_get(dmabuf->exp_name ?: "unknown");
+	dmabuf->proc_stats = dma_buf_proc_stats_get();
+	dma_buf_owner_stats_add(dmabuf->exp_stats, dmabuf);
+	dma_buf_owner_stats_add(dmabuf->proc_stats, dmabuf);
+}
+
+static void dma_buf_stats_release(struct dma_buf *dmabuf)
+{
+	dma_buf_owner_stats_del(dmabuf->exp_stats, dmabuf);
+	dma_buf_owner_stats_del(dmabuf->proc_stats, dmabuf);
+}
+
+/**
+ * dma_buf_account_sgt - account the backing chunks of a dma-buf
+ * @dmabuf:	[in]	dma-buf just exported
+ * @sgt:	[in]	sg table of the backing pages
+ *
+ * Lets an exporter report the physical layout of a new dma-buf, each sg entry
+ * is accounted as one contiguous chunk by its order for the exporter and the
+ * process.
+ */
+void dma_buf_account_sgt(struct dma_buf *dmabuf, struct sg_table *sgt)
+{
+	unsigned int chunks[DMA_BUF_STATS_ORDERS] = { 0 };
+	struct scatterlist *sg;
+	unsigned int order;
+	int i;
+
+	for_each_sgtable_sg(sgt, sg, i) {
+		order = ilog2(max_t(unsigned int, sg->length >> PAGE_SHIFT, 1));
+		chunks[min_t(unsigned int, order, DMA_BUF_STATS_ORDERS - 1)]++;
+	}
+
+	mutex_lock(&db_list.lock);
+	for (i = 0; i < DMA_BUF_STATS_ORDERS; i++) {
+		dmabuf->chunks[i] += chunks[i];
+		if (dmabuf->exp_stats)
+			dmabuf->exp_stats->chunks[i] += chunks[i];
+		if (dmabuf->proc_stats)
+			dmabuf->proc_stats->chunks[i] += chunks[i];
+	}
+	mutex_unlock(&db_list.lock);
+}
+EXPORT_SYMBOL_GPL(dma_buf_account_sgt);
+
+/**
+ * dma_buf_owner_stats_get_each - iterate over the exporter and process stats
+ * @callback:	[in]	called for each exporter, then for each process
+ * @private:	[in]	passed to @callback
+ *
+ * Stops at the first non-zero return of @callback and returns it.
+ */
+int dma_buf_owner_stats_get_each(int (*callback)(const struct dma_buf_owner_stats *stats,
+						 void *private), void *private)
+{
+	struct dma_buf_owner_stats *stats;
+	int ret = mutex_lock_interruptible(&db_list.lock);
+
+	if (ret)
+		return ret;
+
+	list_for_each_entry(stats, &db_exp_stats, node) {
+		ret = callback(stats, private);
+		if (ret)
+			goto out;
+	}
+
+	list_for_each_entry(stats, &db_proc_stats, node) {
+		ret = callback(stats, private);
+		if (ret)
+			goto out;
+	}
+out:
+	mutex_unlock(&db_list.lock);
+
+	return ret;
+}
+EXPORT_SYMBOL_GPL(dma_buf_owner_stats_get_each);
 #endif
 
 static char *dmabuffs_dname(struct dentry *dentry, char *buffer, int buflen)
@@ -179,6 +342,7 @@ static int dma_buf_file_release(struct inode *inode, struct file *file)
 		mutex_lock(&db_list.lock);
 #if IS_ENABLED(CONFIG_RK_DMABUF_DEBUG)
 		db_total_size -= dmabuf->size;
+		dma_buf_stats_release(dmabuf);
 #endif
 		list_del(&dmabuf->list_node);
 		mutex_unlock(&db_list.lock);
@@ -844,6 +1008,7 @@ struct dma_buf *dma_buf_export(const struct dma_buf_export_info *exp_info)
 #if IS_ENABLED(CONFIG_RK_DMABUF_DEBUG)
 	db_total_size += dmabuf->size;
 	db_peak_size = max(db_total_size, db_peak_size);
+	dma_buf_stats_export(dmabuf);
 #endif
 	mutex_unlock(&db_list.lock);
 
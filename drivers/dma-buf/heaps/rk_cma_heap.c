@@ -13,22 +13,39 @@
  */
 
 #include <linux/cma.h>
+#include <linux/debugfs.h>
 #include <linux/dma-buf.h>
 #include <linux/dma-heap.h>
 #include <linux/dma-map-ops.h>
 #include <linux/err.h>
+#include <linux/genalloc.h>
 #include <linux/highmem.h>
 #include <linux/io.h>
+#include <linux/ktime.h>
 #include <linux/mm.h>
 #include <linux/module.h>
 #include <linux/scatterlist.h>
+#include <linux/seq_file.h>
 #include <linux/slab.h>
 #include <linux/vmalloc.h>
 #include <uapi/linux/dma-heap.h>
 
+/*
+ * Size of the cma area kept allocated for the "cma-fast" heap, whose buffers
+ * never wait for movable pages to be migrated out of the cma area.
+ */
+static unsigned int fast_pool_mb;
+module_param(fast_pool_mb, uint, 0444);
+MODULE_PARM_DESC(fast_pool_mb, "Size in MiB reserved for the cma-fast heap");
+
+/* Allocation latency buckets of 2^n us, the last one holds the slower ones */
+#define LATENCY_BUCKETS	20
+
 struct cma_heap {
 	struct dma_heap *heap;
 	struct cma *cma;
+	struct gen_pool *pool;
+	atomic_long_t latency[LATENCY_BUCKETS];
 };
 
 struct cma_heap_buffer {
@@ -43,6 +60,15 @@ struct cma_heap_buffer {
 	void *vaddr;
 
 	bool uncached;
+	bool pooled;
+
+	/*
+	 * A buffer nobody mapped on the cpu is only touched by devices, once a
+	 * device mapping has cleaned the zeroed pages (device_clean) the cache
+	 * maintenance on map and unmap is skipped until the first cpu mapping.
+	 */
+	bool cpu_access;
+	bool device_clean;
 };
 
 struct dma_heap_attachment {
@@ -105,18 +131,26 @@ static void cma_heap_detach(struct dma_buf *dmabuf,
 static struct sg_table *cma_heap_map_dma_buf(struct dma_buf_attachment *attachment,
 					     enum dma_data_direction direction)
 {
+	struct cma_heap_buffer *buffer = attachment->dmabuf->priv;
 	struct dma_heap_attachment *a = attachment->priv;
 	struct sg_table *table = &a->table;
 	int attrs = attachment->dma_map_attrs;
 	int ret;
 
-	if (a->uncached)
+	mutex_lock(&buffer->lock);
+	if (a->uncached || buffer->device_clean)
 		attrs |= DMA_ATTR_SKIP_CPU_SYNC;
 
 	ret = dma_map_sgtable(attachment->dev, table, direction, attrs);
-	if (ret)
+	if (ret) {
+		mutex_unlock(&buffer->lock);
 		return ERR_PTR(-ENOMEM);
+	}
+	if (!buffer->cpu_access)
+		buffer->device_clean = true;
 	a->mapped = true;
+	mutex_unlock(&buffer->lock);
+
 	return table;
 }
 
@@ -124,15 +158,37 @@ static void cma_heap_unmap_dma_buf(struct dma_buf_attachment *attachment,
 				   struct sg_table *table,
 				   enum dma_data_direction direction)
 {
+	struct cma_heap_buffer *buffer = attachment->dmabuf->priv;
 	struct dma_heap_attachment *a = attachment->priv;
 	int attrs = attachment->dma_map_attrs;
 
+	mutex_lock(&buffer->lock);
 	a->mapped = false;
 
-	if (a->uncached)
+	/* no cpu can see the buffer, see cma_heap_cpu_access() */
+	if (a->uncached || !buffer->cpu_access)
 		attrs |= DMA_ATTR_SKIP_CPU_SYNC;
 
 	dma_unmap_sgtable(attachment->dev, table, direction, attrs);
+	mutex_unlock(&buffer->lock);
+}
+
+/*
+ * The buffer is about to be mapped on the cpu, called with buffer->lock held.
+ * Device writes were not invalidated on unmap while the buffer was device
+ * only, do that once now.
+ */
+static void cma_heap_cpu_access(struct cma_heap_buffer *buffer)
+{
+	if (buffer->cpu_access)
+		return;
+
+	buffer->cpu_access = true;
+	if (buffer->device_clean && !buffer->uncached)
+		dma_sync_single_for_cpu(dma_heap_get_dev(buffer->heap->heap),
+					page_to_phys(buffer->cma_pages),
+					buffer->len, DMA_FROM_DEVICE);
+	buffer->device_clean = false;
 }
 
 static int __maybe_unused
@@ -147,7 +203,7 @@ cma_heap_dma_buf_begin_cpu_access_partial(struct dma_buf *dmabuf,
 	if (buffer->vmap_cnt)
 		invalidate_kernel_vmap_range(buffer->vaddr, buffer->len);
 
-	if (buffer->uncached)
+	if (buffer->uncached || !READ_ONCE(buffer->cpu_access))
 		return 0;
 
 	mutex_lock(&buffer->lock);
@@ -172,7 +228,7 @@ cma_heap_dma_buf_end_cpu_access_partial(struct dma_buf *dmabuf,
 	if (buffer->vmap_cnt)
 		flush_kernel_vmap_range(buffer->vaddr, buffer->len);
 
-	if (buffer->uncached)
+	if (buffer->uncached || !READ_ONCE(buffer->cpu_access))
 		return 0;
 
 	mutex_lock(&buffer->lock);
@@ -195,11 +251,16 @@ static int cma_heap_dma_buf_begin_cpu_access(struct dma_buf *dmabuf,
 		invalidate_kernel_vmap_range(buffer->vaddr, buffer->len);
 
 	mutex_lock(&buffer->lock);
+	/* without a cpu mapping there is nothing to maintain */
+	if (!buffer->cpu_access)
+		goto out;
+
 	list_for_each_entry(a, &buffer->attachments, list) {
 		if (!a->mapped)
 			continue;
 		dma_sync_sgtable_for_cpu(a->dev, &a->table, direction);
 	}
+out:
 	mutex_unlock(&buffer->lock);
 
 	return 0;
@@ -215,11 +276,15 @@ static int cma_heap_dma_buf_end_cpu_access(struct dma_buf *dmabuf,
 		flush_kernel_vmap_range(buffer->vaddr, buffer->len);
 
 	mutex_lock(&buffer->lock);
+	if (!buffer->cpu_access)
+		goto out;
+
 	list_for_each_entry(a, &buffer->attachments, list) {
 		if (!a->mapped)
 			continue;
 		dma_sync_sgtable_for_device(a->dev, &a->table, direction);
 	}
+out:
 	mutex_unlock(&buffer->lock);
 
 	return 0;
@@ -250,6 +315,10 @@ static int cma_heap_mmap(struct dma_buf *dmabuf, struct vm_area_struct *vma)
 	if ((vma->vm_flags & (VM_SHARED | VM_MAYSHARE)) == 0)
 		return -EINVAL;
 
+	mutex_lock(&buffer->lock);
+	cma_heap_cpu_access(buffer);
+	mutex_unlock(&buffer->lock);
+
 	if (buffer->uncached)
 		vma->vm_page_prot = pgprot_writecombine(vma->vm_page_prot);
 
@@ -286,6 +355,7 @@ static void *cma_heap_vmap(struct dma_buf *dmabuf)
 		goto out;
 	}
 
+	cma_heap_cpu_access(buffer);
 	vaddr = cma_heap_do_vmap(buffer);
 	if (IS_ERR(vaddr))
 		goto out;
@@ -310,6 +380,34 @@ static void cma_heap_vunmap(struct dma_buf *dmabuf, void *vaddr)
 	mutex_unlock(&buffer->lock);
 }
 
+static struct page *cma_heap_alloc_pages(struct cma_heap *cma_heap,
+					 pgoff_t pagecount, unsigned long align,
+					 bool *pooled)
+{
+	unsigned long phys;
+
+	*pooled = false;
+	if (cma_heap->pool) {
+		phys = gen_pool_alloc(cma_heap->pool, pagecount << PAGE_SHIFT);
+		if (phys) {
+			*pooled = true;
+			return phys_to_page(phys);
+		}
+	}
+
+	return cma_alloc(cma_heap->cma, pagecount, align, GFP_KERNEL);
+}
+
+static void cma_heap_free_pages(struct cma_heap *cma_heap, struct page *pages,
+				pgoff_t pagecount, bool pooled)
+{
+	if (pooled)
+		gen_pool_free(cma_heap->pool, page_to_phys(pages),
+			      pagecount << PAGE_SHIFT);
+	else
+		cma_release(cma_heap->cma, pages, pagecount);
+}
+
 static void cma_heap_dma_buf_release(struct dma_buf *dmabuf)
 {
 	struct cma_heap_buffer *buffer = dmabuf->priv;
@@ -323,7 +421,8 @@ static void cma_heap_dma_buf_release(struct dma_buf *dmabuf)
 	/* free page list */
 	kfree(buffer->pages);
 	/* release memory */
-	cma_release(cma_heap->cma, buffer->cma_pages, buffer->pagecount);
+	cma_heap_free_pages(cma_heap, buffer->cma_pages, buffer->pagecount,
+			    buffer->pooled);
 	kfree(buffer);
 }
 
@@ -357,9 +456,11 @@ static struct dma_buf *cma_heap_do_allocate(struct dma_heap *heap,
 	unsigned long align = get_order(size);
 	struct page *cma_pages;
 	struct dma_buf *dmabuf;
+	ktime_t start = ktime_get();
 	int ret = -ENOMEM;
 	pgoff_t pg;
 	dma_addr_t dma;
+	u64 us;
 
 	buffer = kzalloc(sizeof(*buffer), GFP_KERNEL);
 	if (!buffer)
@@ -374,7 +475,8 @@ static struct dma_buf *cma_heap_do_allocate(struct dma_heap *heap,
 	if (align > CONFIG_CMA_ALIGNMENT)
 		align = CONFIG_CMA_ALIGNMENT;
 
-	cma_pages = cma_alloc(cma_heap->cma, pagecount, align, GFP_KERNEL);
+	cma_pages = cma_heap_alloc_pages(cma_heap, pagecount, align,
+					 &buffer->pooled);
 	if (!cma_pages)
 		goto free_buffer;
 
@@ -433,12 +535,16 @@ static struct dma_buf *cma_heap_do_allocate(struct dma_heap *heap,
 			       buffer->pagecount * PAGE_SIZE, DMA_FROM_DEVICE);
 	}
 
+	us = ktime_us_delta(ktime_get(), start);
+	atomic_long_inc(&cma_heap->latency[min_t(int, us ? ilog2(us) + 1 : 0,
+						 LATENCY_BUCKETS - 1)]);
+
 	return dmabuf;
 
 free_pages:
 	kfree(buffer->pages);
 free_cma:
-	cma_release(cma_heap->cma, cma_pages, pagecount);
+	cma_heap_free_pages(cma_heap, cma_pages, pagecount, buffer->pooled);
 free_buffer:
 	kfree(buffer);
 
@@ -541,6 +647,121 @@ static int set_heap_dev_dma(struct device *heap_dev)
 	return 0;
 }
 
+#ifdef CONFIG_DEBUG_FS
+static struct dentry *cma_heap_debugfs_dir;
+
+/* Upper bound in us of the bucket holding the given percentile */
+static unsigned long cma_heap_latency_percentile(unsigned long *hist,
+						 unsigned long total,
+						 unsigned int percent)
+{
+	unsigned long sum = 0;
+	int i;
+
+	for (i = 0; i < LATENCY_BUCKETS; i++) {
+		sum += hist[i];
+		if (sum * 100 >= total * percent)
+			break;
+	}
+
+	return 1UL << min(i, LATENCY_BUCKETS - 1);
+}
+
+static int cma_heap_latency_show(struct seq_file *s, void *data)
+{
+	struct cma_heap *cma_heap = s->private;
+	unsigned long hist[LATENCY_BUCKETS], total = 0;
+	int i;
+
+	for (i = 0; i < LATENCY_BUCKETS; i++) {
+		hist[i] = atomic_long_read(&cma_heap->latency[i]);
+		total += hist[i];
+	}
+
+	seq_printf(s, "allocations: %lu\n", total);
+	if (cma_heap->pool)
+		seq_printf(s, "pool: %zu/%zu KiB free\n",
+			   gen_pool_avail(cma_heap->pool) >> 10,
+			   gen_pool_size(cma_heap->pool) >> 10);
+	if (!total)
+		return 0;
+
+	seq_printf(s, "p50: <%lu us\n",
+		   cma_heap_latency_percentile(hist, total, 50));
+	seq_printf(s, "p90: <%lu us\n",
+		   cma_heap_latency_percentile(hist, total, 90));
+	seq_printf(s, "p99: <%lu us\n",
+		   cma_heap_latency_percentile(hist, total, 99));
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(cma_heap_latency);
+
+static void cma_heap_debugfs_add(struct cma_heap *cma_heap)
+{
+	if (!cma_heap_debugfs_dir)
+		cma_heap_debugfs_dir = debugfs_create_dir("rk_cma_heap", NULL);
+
+	debugfs_create_file(dma_heap_get_name(cma_heap->heap), 0444,
+			    cma_heap_debugfs_dir, cma_heap,
+			    &cma_heap_latency_fops);
+}
+#else
+static inline void cma_heap_debugfs_add(struct cma_heap *cma_heap)
+{
+}
+#endif
+
+static int __add_cma_fast_heap(struct cma *cma)
+{
+	struct dma_heap_export_info exp_info;
+	pgoff_t pagecount = (unsigned long)fast_pool_mb << (20 - PAGE_SHIFT);
+	struct cma_heap *cma_heap;
+	struct page *pages;
+	int ret = -ENOMEM;
+
+	cma_heap = kzalloc(sizeof(*cma_heap), GFP_KERNEL);
+	if (!cma_heap)
+		return -ENOMEM;
+	cma_heap->cma = cma;
+
+	cma_heap->pool = gen_pool_create(PAGE_SHIFT, -1);
+	if (!cma_heap->pool)
+		goto free_cma_heap;
+
+	/* Taken while the cma area is still free of movable pages */
+	pages = cma_alloc(cma, pagecount, 0, false);
+	if (!pages)
+		goto destroy_pool;
+
+	ret = gen_pool_add(cma_heap->pool, page_to_phys(pages),
+			   pagecount << PAGE_SHIFT, -1);
+	if (ret)
+		goto release_pages;
+
+	exp_info.name = "cma-fast";
+	exp_info.ops = &cma_heap_ops;
+	exp_info.priv = cma_heap;
+
+	cma_heap->heap = dma_heap_add(&exp_info);
+	if (IS_ERR(cma_heap->heap)) {
+		ret = PTR_ERR(cma_heap->heap);
+		goto release_pages;
+	}
+	cma_heap_debugfs_add(cma_heap);
+
+	return 0;
+
+release_pages:
+	cma_release(cma, pages, pagecount);
+destroy_pool:
+	gen_pool_destroy(cma_heap->pool);
+free_cma_heap:
+	kfree(cma_heap);
+
+	return ret;
+}
+
 static int __add_cma_heap(struct cma *cma, void *data)
 {
 	struct cma_heap *cma_heap, *cma_uncached_heap;
@@ -587,6 +808,13 @@ static int __add_cma_heap(struct cma *cma, void *data)
 	mb(); /* make sure we only set allocate after dma_mask is set */
 	cma_uncached_heap_ops.allocate = cma_uncached_heap_allocate;
 
+	cma_heap_debugfs_add(cma_heap);
+	cma_heap_debugfs_add(cma_uncached_heap);
+
+	if (fast_pool_mb && __add_cma_fast_heap(cma))
+		pr_warn("cma_heap: failed to reserve %u MiB for cma-fast\n",
+			fast_pool_mb);
+
 	return 0;
 
 put_uncached_cma_heap:
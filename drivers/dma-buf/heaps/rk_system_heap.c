@@ -15,9 +15,12 @@
 #include <linux/dma-mapping.h>
 #include <linux/dma-heap.h>
 #include <linux/err.h>
+#include <linux/freezer.h>
 #include <linux/highmem.h>
+#include <linux/kthread.h>
 #include <linux/mm.h>
 #include <linux/module.h>
+#include <linux/sched.h>
 #include <linux/scatterlist.h>
 #include <linux/slab.h>
 #include <linux/swiotlb.h>
@@ -36,6 +39,31 @@ static struct dma_heap *sys_uncached_dma32_heap;
 static u32 bank_bit_first = 12;
 static u32 bank_bit_mask = 0x7;
 
+/*
+ * The ddr channel of a page is given by the parity of its address bits in
+ * each channel mask. Only masks with bits above the page size are used, as
+ * the other ones interleave the channels inside every page anyway.
+ */
+static u64 ch_mask[2];
+static unsigned int ch_bits;
+static bool channel_interleave = true;
+module_param(channel_interleave, bool, 0644);
+MODULE_PARM_DESC(channel_interleave,
+		 "Interleave the 4K pages of a buffer over ddr channels and banks");
+
+/* 8 banks per ddr channel */
+#define BANK_COLORS	8
+#define MAX_COLORS	(BANK_COLORS << ARRAY_SIZE(ch_mask))
+static atomic_t color_start;
+
+/* Number of cpu written ranges tracked before they are merged into one */
+#define MAX_DIRTY_RANGES	8
+
+struct system_heap_range {
+	unsigned int start;
+	unsigned int end;
+};
+
 struct system_heap_buffer {
 	struct dma_heap *heap;
 	struct list_head attachments;
@@ -47,6 +75,23 @@ struct system_heap_buffer {
 	struct deferred_freelist_item deferred_free;
 	struct dmabuf_page_pool **pools;
 	bool uncached;
+
+	/*
+	 * Ranges declared as cpu written by begin_cpu_access_partial(), only
+	 * these are cleaned by the next full end_cpu_access() unless the whole
+	 * buffer was opened for writing.
+	 */
+	struct system_heap_range dirty[MAX_DIRTY_RANGES];
+	int dirty_cnt;
+	bool dirty_all;
+
+	/*
+	 * A buffer nobody mapped on the cpu is only touched by devices, once a
+	 * device mapping has cleaned the zeroed pages (device_clean) the cache
+	 * maintenance on map and unmap is skipped until the first cpu mapping.
+	 */
+	bool cpu_access;
+	bool device_clean;
 };
 
 struct dma_heap_attachment {
@@ -74,6 +119,19 @@ static unsigned int orders[] = {8, 4, 0};
 struct dmabuf_page_pool *pools[NUM_ORDERS];
 struct dmabuf_page_pool *dma32_pools[NUM_ORDERS];
 
+/*
+ * Size of pre-zeroed pages kept in each high order pool of the system heaps,
+ * refilled by a low priority thread after allocations. The pool shrinker
+ * still frees them under memory pressure, and the refill never reclaims.
+ */
+static unsigned int refill_kb = SZ_16K;
+module_param(refill_kb, uint, 0644);
+MODULE_PARM_DESC(refill_kb, "Size in KiB of pre-zeroed pages kept per high order pool");
+
+static struct task_struct *refill_task;
+static DECLARE_WAIT_QUEUE_HEAD(refill_wait);
+static bool refill_pending;
+
 static struct sg_table *dup_sg_table(struct sg_table *table)
 {
 	struct sg_table *new_table;
@@ -148,19 +206,27 @@ static void system_heap_detach(struct dma_buf *dmabuf,
 static struct sg_table *system_heap_map_dma_buf(struct dma_buf_attachment *attachment,
 						enum dma_data_direction direction)
 {
+	struct system_heap_buffer *buffer = attachment->dmabuf->priv;
 	struct dma_heap_attachment *a = attachment->priv;
 	struct sg_table *table = a->table;
 	int attr = attachment->dma_map_attrs;
 	int ret;
 
-	if (a->uncached)
+	mutex_lock(&buffer->lock);
+	if (a->uncached || buffer->device_clean)
 		attr |= DMA_ATTR_SKIP_CPU_SYNC;
 
 	ret = dma_map_sgtable(attachment->dev, table, direction, attr);
-	if (ret)
+	if (ret) {
+		mutex_unlock(&buffer->lock);
 		return ERR_PTR(ret);
+	}
 
+	if (!buffer->cpu_access)
+		buffer->device_clean = true;
 	a->mapped = true;
+	mutex_unlock(&buffer->lock);
+
 	return table;
 }
 
@@ -168,59 +234,17 @@ static void system_heap_unmap_dma_buf(struct dma_buf_attachment *attachment,
 				      struct sg_table *table,
 				      enum dma_data_direction direction)
 {
+	struct system_heap_buffer *buffer = attachment->dmabuf->priv;
 	struct dma_heap_attachment *a = attachment->priv;
 	int attr = attachment->dma_map_attrs;
 
-	if (a->uncached)
+	mutex_lock(&buffer->lock);
+	/* no cpu can see the buffer, see system_heap_cpu_access() */
+	if (a->uncached || !buffer->cpu_access)
 		attr |= DMA_ATTR_SKIP_CPU_SYNC;
 	a->mapped = false;
 	dma_unmap_sgtable(attachment->dev, table, direction, attr);
-}
-
-static int system_heap_dma_buf_begin_cpu_access(struct dma_buf *dmabuf,
-						enum dma_data_direction direction)
-{
-	struct system_heap_buffer *buffer = dmabuf->priv;
-	struct dma_heap_attachment *a;
-
-	mutex_lock(&buffer->lock);
-
-	if (buffer->vmap_cnt)
-		invalidate_kernel_vmap_range(buffer->vaddr, buffer->len);
-
-	if (!buffer->uncached) {
-		list_for_each_entry(a, &buffer->attachments, list) {
-			if (!a->mapped)
-				continue;
-			dma_sync_sgtable_for_cpu(a->dev, a->table, direction);
-		}
-	}
-	mutex_unlock(&buffer->lock);
-
-	return 0;
-}
-
-static int system_heap_dma_buf_end_cpu_access(struct dma_buf *dmabuf,
-					      enum dma_data_direction direction)
-{
-	struct system_heap_buffer *buffer = dmabuf->priv;
-	struct dma_heap_attachment *a;
-
-	mutex_lock(&buffer->lock);
-
-	if (buffer->vmap_cnt)
-		flush_kernel_vmap_range(buffer->vaddr, buffer->len);
-
-	if (!buffer->uncached) {
-		list_for_each_entry(a, &buffer->attachments, list) {
-			if (!a->mapped)
-				continue;
-			dma_sync_sgtable_for_device(a->dev, a->table, direction);
-		}
-	}
 	mutex_unlock(&buffer->lock);
-
-	return 0;
 }
 
 static int system_heap_sgl_sync_range(struct device *dev,
@@ -265,6 +289,140 @@ static int system_heap_sgl_sync_range(struct device *dev,
 	return 0;
 }
 
+/* Add [start, end) to the cpu written ranges, called with buffer->lock held */
+static void system_heap_dirty_add(struct system_heap_buffer *buffer,
+				  unsigned int start, unsigned int end)
+{
+	struct system_heap_range *r;
+	int i;
+
+	if (buffer->dirty_all)
+		return;
+
+	/* Merge with the overlapping or adjacent ranges */
+	for (i = 0; i < buffer->dirty_cnt; ) {
+		r = &buffer->dirty[i];
+		if (r->start > end || r->end < start) {
+			i++;
+			continue;
+		}
+		start = min(start, r->start);
+		end = max(end, r->end);
+		*r = buffer->dirty[--buffer->dirty_cnt];
+	}
+
+	if (buffer->dirty_cnt == MAX_DIRTY_RANGES) {
+		for (i = 0; i < buffer->dirty_cnt; i++) {
+			start = min(start, buffer->dirty[i].start);
+			end = max(end, buffer->dirty[i].end);
+		}
+		buffer->dirty_cnt = 0;
+	}
+
+	buffer->dirty[buffer->dirty_cnt].start = start;
+	buffer->dirty[buffer->dirty_cnt].end = end;
+	buffer->dirty_cnt++;
+}
+
+/* Drop the cpu written ranges inside [start, end), which have been cleaned */
+static void system_heap_dirty_clear(struct system_heap_buffer *buffer,
+				    unsigned int start, unsigned int end)
+{
+	int i;
+
+	for (i = 0; i < buffer->dirty_cnt; ) {
+		if (buffer->dirty[i].start >= start && buffer->dirty[i].end <= end)
+			buffer->dirty[i] = buffer->dirty[--buffer->dirty_cnt];
+		else
+			i++;
+	}
+}
+
+/*
+ * The buffer is about to be mapped on the cpu, called with buffer->lock held.
+ * Device writes were not invalidated on unmap while the buffer was device
+ * only, do that once now.
+ */
+static void system_heap_cpu_access(struct system_heap_buffer *buffer)
+{
+	if (buffer->cpu_access)
+		return;
+
+	buffer->cpu_access = true;
+	if (buffer->device_clean && !buffer->uncached)
+		system_heap_sgl_sync_range(dma_heap_get_dev(buffer->heap),
+					   &buffer->sg_table, 0, buffer->len,
+					   DMA_FROM_DEVICE, true);
+	buffer->device_clean = false;
+}
+
+static int system_heap_dma_buf_begin_cpu_access(struct dma_buf *dmabuf,
+						enum dma_data_direction direction)
+{
+	struct system_heap_buffer *buffer = dmabuf->priv;
+	struct dma_heap_attachment *a;
+
+	mutex_lock(&buffer->lock);
+
+	if (direction != DMA_FROM_DEVICE)
+		buffer->dirty_all = true;
+
+	if (buffer->vmap_cnt)
+		invalidate_kernel_vmap_range(buffer->vaddr, buffer->len);
+
+	/* without a cpu mapping there is nothing to maintain */
+	if (!buffer->uncached && buffer->cpu_access) {
+		list_for_each_entry(a, &buffer->attachments, list) {
+			if (!a->mapped)
+				continue;
+			dma_sync_sgtable_for_cpu(a->dev, a->table, direction);
+		}
+	}
+	mutex_unlock(&buffer->lock);
+
+	return 0;
+}
+
+static int system_heap_dma_buf_end_cpu_access(struct dma_buf *dmabuf,
+					      enum dma_data_direction direction)
+{
+	struct system_heap_buffer *buffer = dmabuf->priv;
+	struct dma_heap_attachment *a;
+	int i;
+
+	mutex_lock(&buffer->lock);
+
+	if (buffer->vmap_cnt)
+		flush_kernel_vmap_range(buffer->vaddr, buffer->len);
+
+	if (buffer->uncached || !buffer->cpu_access)
+		goto out;
+
+	/* Only clean what the cpu declared as written */
+	if (!buffer->dirty_all && buffer->dirty_cnt) {
+		for (i = 0; i < buffer->dirty_cnt; i++)
+			system_heap_sgl_sync_range(dma_heap_get_dev(buffer->heap),
+						   &buffer->sg_table,
+						   buffer->dirty[i].start,
+						   buffer->dirty[i].end -
+						   buffer->dirty[i].start,
+						   direction, false);
+		goto out;
+	}
+
+	list_for_each_entry(a, &buffer->attachments, list) {
+		if (!a->mapped)
+			continue;
+		dma_sync_sgtable_for_device(a->dev, a->table, direction);
+	}
+out:
+	buffer->dirty_cnt = 0;
+	buffer->dirty_all = false;
+	mutex_unlock(&buffer->lock);
+
+	return 0;
+}
+
 static int __maybe_unused
 system_heap_dma_buf_begin_cpu_access_partial(struct dma_buf *dmabuf,
 					     enum dma_data_direction direction,
@@ -276,14 +434,19 @@ system_heap_dma_buf_begin_cpu_access_partial(struct dma_buf *dmabuf,
 	struct sg_table *table = &buffer->sg_table;
 	int ret;
 
-	if (direction == DMA_TO_DEVICE)
+	mutex_lock(&buffer->lock);
+	if (direction != DMA_FROM_DEVICE)
+		system_heap_dirty_add(buffer, offset, offset + len);
+
+	if (direction == DMA_TO_DEVICE) {
+		mutex_unlock(&buffer->lock);
 		return 0;
+	}
 
-	mutex_lock(&buffer->lock);
 	if (buffer->vmap_cnt)
 		invalidate_kernel_vmap_range(buffer->vaddr, buffer->len);
 
-	if (buffer->uncached) {
+	if (buffer->uncached || !buffer->cpu_access) {
 		mutex_unlock(&buffer->lock);
 		return 0;
 	}
@@ -310,13 +473,15 @@ system_heap_dma_buf_end_cpu_access_partial(struct dma_buf *dmabuf,
 	if (buffer->vmap_cnt)
 		flush_kernel_vmap_range(buffer->vaddr, buffer->len);
 
-	if (buffer->uncached) {
+	if (buffer->uncached || !buffer->cpu_access) {
+		system_heap_dirty_clear(buffer, offset, offset + len);
 		mutex_unlock(&buffer->lock);
 		return 0;
 	}
 
 	ret = system_heap_sgl_sync_range(dma_heap_get_dev(heap), table,
 					 offset, len, direction, false);
+	system_heap_dirty_clear(buffer, offset, offset + len);
 	mutex_unlock(&buffer->lock);
 
 	return ret;
@@ -330,6 +495,10 @@ static int system_heap_mmap(struct dma_buf *dmabuf, struct vm_area_struct *vma)
 	struct sg_page_iter piter;
 	int ret;
 
+	mutex_lock(&buffer->lock);
+	system_heap_cpu_access(buffer);
+	mutex_unlock(&buffer->lock);
+
 	if (buffer->uncached)
 		vma->vm_page_prot = pgprot_writecombine(vma->vm_page_prot);
 
@@ -389,6 +558,7 @@ static void *system_heap_vmap(struct dma_buf *dmabuf)
 		goto out;
 	}
 
+	system_heap_cpu_access(buffer);
 	vaddr = system_heap_do_vmap(buffer);
 	if (IS_ERR(vaddr))
 		goto out;
@@ -488,6 +658,70 @@ static const struct dma_buf_ops system_heap_buf_ops = {
 	.release = system_heap_dma_buf_release,
 };
 
+static unsigned int system_heap_page_color(struct page *page)
+{
+	dma_addr_t phys = page_to_phys(page);
+	unsigned int color = ((phys >> bank_bit_first) & bank_bit_mask) & 0x7;
+	int i;
+
+	if (!channel_interleave)
+		return color;
+
+	for (i = 0; i < ch_bits; i++)
+		color |= (hweight64(phys & ch_mask[i]) & 1) << (3 + i);
+
+	return color;
+}
+
+static bool system_heap_pool_low(struct dmabuf_page_pool *pool)
+{
+	unsigned long target;
+
+	target = ((unsigned long)READ_ONCE(refill_kb) * SZ_1K) >>
+		 (PAGE_SHIFT + pool->order);
+
+	return pool->count[POOL_LOWPAGE] + pool->count[POOL_HIGHPAGE] < target;
+}
+
+static int system_heap_refill_thread(void *data)
+{
+	struct page *page;
+	int i;
+
+	set_freezable();
+
+	while (!kthread_should_stop()) {
+		wait_event_freezable(refill_wait, READ_ONCE(refill_pending) ||
+				     kthread_should_stop());
+		WRITE_ONCE(refill_pending, false);
+
+		/* The order 0 pool is only refilled by freed buffers */
+		for (i = 0; i < NUM_ORDERS - 1; i++) {
+			while (!kthread_should_stop() &&
+			       system_heap_pool_low(pools[i])) {
+				page = alloc_pages(pools[i]->gfp_mask,
+						   pools[i]->order);
+				if (!page)
+					break;
+
+				dmabuf_page_pool_free(pools[i], page);
+				cond_resched();
+			}
+		}
+	}
+
+	return 0;
+}
+
+static void system_heap_refill_kick(void)
+{
+	if (!refill_task || !READ_ONCE(refill_kb))
+		return;
+
+	WRITE_ONCE(refill_pending, true);
+	wake_up(&refill_wait);
+}
+
 static struct page *system_heap_alloc_largest_available(struct dma_heap *heap,
 							struct dmabuf_page_pool **pool,
 							unsigned long size,
@@ -525,11 +759,12 @@ static struct dma_buf *system_heap_do_allocate(struct dma_heap *heap,
 	struct list_head pages;
 	struct page *page, *tmp_page;
 	int i, ret = -ENOMEM;
-	struct list_head lists[8];
-	unsigned int block_index[8] = {0};
+	struct list_head lists[MAX_COLORS];
+	unsigned int block_index[MAX_COLORS] = {0};
 	unsigned int block_1M = 0;
 	unsigned int block_64K = 0;
-	unsigned int maximum;
+	unsigned int colors = BANK_COLORS;
+	unsigned int maximum, start;
 	int j;
 
 	buffer = kzalloc(sizeof(*buffer), GFP_KERNEL);
@@ -543,8 +778,17 @@ static struct dma_buf *system_heap_do_allocate(struct dma_heap *heap,
 	buffer->uncached = uncached;
 	buffer->pools = strstr(dma_heap_get_name(heap), "dma32") ? dma32_pools : pools;
 
+	/*
+	 * Start each buffer on the next ddr channel, so that the same page
+	 * of ping-pong buffers which are accessed together does not end up
+	 * on the same channel.
+	 */
+	if (channel_interleave)
+		colors <<= ch_bits;
+	start = (atomic_inc_return(&color_start) * BANK_COLORS) % colors;
+
 	INIT_LIST_HEAD(&pages);
-	for (i = 0; i < 8; i++)
+	for (i = 0; i < MAX_COLORS; i++)
 		INIT_LIST_HEAD(&lists[i]);
 	i = 0;
 	while (size_remaining > 0) {
@@ -570,8 +814,7 @@ static struct dma_buf *system_heap_do_allocate(struct dma_heap *heap,
 				block_64K++;
 			list_add_tail(&page->lru, &pages);
 		} else {
-			dma_addr_t phys = page_to_phys(page);
-			unsigned int bit_index = ((phys >> bank_bit_first) & bank_bit_mask) & 0x7;
+			unsigned int bit_index = system_heap_page_color(page);
 
 			list_add_tail(&page->lru, &lists[bit_index]);
 			block_index[bit_index]++;
@@ -584,7 +827,7 @@ static struct dma_buf *system_heap_do_allocate(struct dma_heap *heap,
 		goto free_buffer;
 
 	maximum = block_index[0];
-	for (i = 1; i < 8; i++)
+	for (i = 1; i < colors; i++)
 		maximum = max(maximum, block_index[i]);
 	sg = table->sgl;
 	list_for_each_entry_safe(page, tmp_page, &pages, lru) {
@@ -593,9 +836,11 @@ static struct dma_buf *system_heap_do_allocate(struct dma_heap *heap,
 		list_del(&page->lru);
 	}
 	for (i = 0; i < maximum; i++) {
-		for (j = 0; j < 8; j++) {
-			if (!list_empty(&lists[j])) {
-				page = list_first_entry(&lists[j], struct page, lru);
+		for (j = 0; j < colors; j++) {
+			unsigned int k = (start + j) % colors;
+
+			if (!list_empty(&lists[k])) {
+				page = list_first_entry(&lists[k], struct page, lru);
 				sg_set_page(sg, page, PAGE_SIZE, 0);
 				sg = sg_next(sg);
 				list_del(&page->lru);
@@ -615,6 +860,8 @@ static struct dma_buf *system_heap_do_allocate(struct dma_heap *heap,
 		goto free_pages;
 	}
 
+	dma_buf_account_sgt(dmabuf, table);
+
 	/*
 	 * For uncached buffers, we need to initially flush cpu cache, since
 	 * the __GFP_ZERO on the allocation means the zeroing was done by the
@@ -626,6 +873,10 @@ static struct dma_buf *system_heap_do_allocate(struct dma_heap *heap,
 		dma_unmap_sgtable(dma_heap_get_dev(heap), table, DMA_BIDIRECTIONAL, 0);
 	}
 
+	/* Top the high order pools up again for the next large buffer */
+	if (buffer->pools == pools && len >= (PAGE_SIZE << orders[NUM_ORDERS - 2]))
+		system_heap_refill_kick();
+
 	return dmabuf;
 
 free_pages:
@@ -638,7 +889,7 @@ static struct dma_buf *system_heap_do_allocate(struct dma_heap *heap,
 free_buffer:
 	list_for_each_entry_safe(page, tmp_page, &pages, lru)
 		__free_pages(page, compound_order(page));
-	for (i = 0; i < 8; i++) {
+	for (i = 0; i < MAX_COLORS; i++) {
 		list_for_each_entry_safe(page, tmp_page, &lists[i], lru)
 			__free_pages(page, compound_order(page));
 	}
@@ -828,6 +1079,21 @@ static int system_heap_create(void)
 	if (ddr_map_info) {
 		bank_bit_first = ddr_map_info->bank_bit_first;
 		bank_bit_mask = ddr_map_info->bank_bit_mask;
+
+		for (i = 0; i < ARRAY_SIZE(ddr_map_info->ch_mask); i++) {
+			if (ddr_map_info->ch_mask[i] & PAGE_MASK)
+				ch_mask[ch_bits++] = ddr_map_info->ch_mask[i];
+		}
+	}
+
+	refill_task = kthread_run(system_heap_refill_thread, NULL,
+				  "system_heap_refill");
+	if (IS_ERR(refill_task)) {
+		pr_warn("system_heap: failed to start the pool refill thread\n");
+		refill_task = NULL;
+	} else {
+		sched_set_normal(refill_task, MAX_NICE);
+		system_heap_refill_kick();
 	}
 
 	return 0;
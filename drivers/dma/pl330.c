@@ -269,6 +269,9 @@ static unsigned cmd_line;
 
 #define NR_DEFAULT_DESC	16
 
+/* Descriptors added to the DMAC pool the first time a channel is allocated */
+#define NR_CHAN_DESC	8
+
 /* Delay for runtime PM autosuspend, ms */
 #define PL330_AUTOSUSPEND_DELAY 20
 
@@ -355,10 +358,29 @@ enum pl330_cond {
 
 struct dma_pl330_desc;
 
+/* Everything the microcode of a request is generated from */
+struct _pl330_mc_key {
+	u32 ccr;
+	u32 src_addr;
+	u32 dst_addr;
+	u32 bytes;
+	u32 rqtype;
+	u32 peri;
+	bool cyclic;
+	bool cyclic_no_irq;
+	size_t num_periods;
+	size_t sgl_size;
+	size_t src_icg;
+	size_t dst_icg;
+};
+
 struct _pl330_req {
 	u32 mc_bus;
 	void *mc_cpu;
 	struct dma_pl330_desc *desc;
+	/* what mc_cpu currently holds, mc_len is 0 if nothing valid */
+	struct _pl330_mc_key mc_key;
+	int mc_len;
 };
 
 /* ToBeDone for tasklet */
@@ -458,6 +480,9 @@ struct dma_pl330_chan {
 
 	/* for runtime pm tracking */
 	bool active;
+
+	/* NR_CHAN_DESC were added to the DMAC pool for this channel */
+	bool desc_pool_grown;
 };
 
 struct pl330_dmac {
@@ -546,6 +571,8 @@ struct dma_pl330_desc {
 
 	/* For cyclic capability */
 	bool cyclic;
+	/* cyclic without DMA_PREP_INTERRUPT, no event per period */
+	bool cyclic_no_irq;
 	size_t num_periods;
 
 	/* interleaved size */
@@ -560,6 +587,8 @@ struct _xfer_spec {
 static int pl330_config_write(struct dma_chan *chan,
 			struct dma_slave_config *slave_config,
 			enum dma_transfer_direction direction);
+static int add_desc(struct list_head *pool, spinlock_t *lock,
+		    gfp_t flg, int count);
 
 static inline bool _queue_full(struct pl330_thread *thrd)
 {
@@ -1469,7 +1498,9 @@ static int _period(struct pl330_dmac *pl330, unsigned int dry_run, u8 buf[],
 		}
 	}
 
-	off += _emit_SEV(dry_run, &buf[off], ev);
+	/* the client tracks the position through the residue instead */
+	if (!pxs->desc->cyclic_no_irq)
+		off += _emit_SEV(dry_run, &buf[off], ev);
 
 	return off;
 }
@@ -1659,6 +1690,7 @@ static int pl330_submit_req(struct pl330_thread *thrd,
 	struct dma_pl330_desc *desc)
 {
 	struct pl330_dmac *pl330 = thrd->dmac;
+	struct _pl330_mc_key key;
 	struct _xfer_spec xs;
 	unsigned long flags;
 	unsigned idx;
@@ -1715,6 +1747,31 @@ static int pl330_submit_req(struct pl330_thread *thrd,
 	xs.ccr = ccr;
 	xs.desc = desc;
 
+	/*
+	 * Clients such as audio resubmit the same transfer over and over,
+	 * reuse the microcode left in the buffer if it matches.
+	 */
+	memset(&key, 0, sizeof(key));
+	key.ccr = ccr;
+	key.src_addr = desc->px.src_addr;
+	key.dst_addr = desc->px.dst_addr;
+	key.bytes = desc->px.bytes;
+	key.rqtype = desc->rqtype;
+	key.peri = desc->peri;
+	key.cyclic = desc->cyclic;
+	key.cyclic_no_irq = desc->cyclic_no_irq;
+	key.num_periods = desc->num_periods;
+	key.sgl_size = desc->sgl.size;
+	key.src_icg = desc->sgl.src_icg;
+	key.dst_icg = desc->sgl.dst_icg;
+
+	if (thrd->req[idx].mc_len &&
+	    !memcmp(&thrd->req[idx].mc_key, &key, sizeof(key))) {
+		thrd->lstenq = idx;
+		thrd->req[idx].desc = desc;
+		goto xfer_exit;
+	}
+
 	/* First dry run to check if req is acceptable */
 	ret = _setup_req(pl330, 1, thrd, idx, &xs);
 
@@ -1728,7 +1785,8 @@ static int pl330_submit_req(struct pl330_thread *thrd,
 	/* Hook the request */
 	thrd->lstenq = idx;
 	thrd->req[idx].desc = desc;
-	_setup_req(pl330, 0, thrd, idx, &xs);
+	thrd->req[idx].mc_len = _setup_req(pl330, 0, thrd, idx, &xs);
+	thrd->req[idx].mc_key = key;
 
 	ret = 0;
 
@@ -1967,6 +2025,9 @@ static struct pl330_thread *pl330_request_channel(struct pl330_dmac *pl330)
 				thrd->lstenq = 1;
 				thrd->req[0].desc = NULL;
 				thrd->req[1].desc = NULL;
+				/* the cached microcode embeds the old event */
+				thrd->req[0].mc_len = 0;
+				thrd->req[1].mc_len = 0;
 				thrd->req_running = -1;
 				break;
 			}
@@ -2352,6 +2413,15 @@ static int pl330_alloc_chan_resources(struct dma_chan *chan)
 	struct pl330_dmac *pl330 = pch->dmac;
 	unsigned long flags;
 
+	/*
+	 * Grow the DMAC pool once per channel while we may sleep, so prep
+	 * does not fall back to atomic allocations when several channels
+	 * are busy. Descriptors are never freed, hence only once.
+	 */
+	if (!pch->desc_pool_grown)
+		pch->desc_pool_grown = add_desc(&pl330->desc_pool, &pl330->pool_lock,
+						GFP_KERNEL, NR_CHAN_DESC);
+
 	spin_lock_irqsave(&pl330->lock, flags);
 
 	dma_cookie_init(chan);
@@ -2804,6 +2874,7 @@ static struct dma_pl330_desc *pl330_get_desc(struct dma_pl330_chan *pch)
 	desc->rqcfg.pcfg = &pch->dmac->pcfg;
 
 	desc->cyclic = false;
+	desc->cyclic_no_irq = false;
 	desc->num_periods = 1;
 
 	desc->sgl.size = 0;
@@ -2923,6 +2994,7 @@ static struct dma_async_tx_descriptor *pl330_prep_dma_cyclic(
 	fill_px(&desc->px, dst, src, period_len);
 
 	desc->cyclic = true;
+	desc->cyclic_no_irq = !(flags & DMA_PREP_INTERRUPT);
 	desc->num_periods = len / period_len;
 
 	return &desc->txd;
@@ -162,11 +162,27 @@ static int rockchip_gpio_set_direction(struct gpio_chip *chip,
 	struct rockchip_pin_bank *bank = gpiochip_get_data(chip);
 	unsigned long flags;
 	u32 data = input ? 0 : 1;
+	int ret;
 
-	if (input)
-		pinctrl_gpio_direction_input(bank->pin_base + offset);
-	else
-		pinctrl_gpio_direction_output(bank->pin_base + offset);
+	/*
+	 * Muxing the pin goes through the pinctrl core and the grf regmap,
+	 * skip it while the pin is known to be a gpio already. Bit-banging
+	 * drivers turn bus lines around on every cycle.
+	 */
+	if (!test_bit(offset, &bank->gpio_muxed)) {
+		if (input)
+			ret = pinctrl_gpio_direction_input(bank->pin_base + offset);
+		else
+			ret = pinctrl_gpio_direction_output(bank->pin_base + offset);
+		if (!ret)
+			set_bit(offset, &bank->gpio_muxed);
+	}
+
+	/* v2 registers have a write mask, no read-modify-write to protect */
+	if (bank->gpio_type == GPIO_TYPE_V2) {
+		rockchip_gpio_writel_bit(bank, offset, data, bank->gpio_regs->port_ddr);
+		return 0;
+	}
 
 	raw_spin_lock_irqsave(&bank->slock, flags);
 	rockchip_gpio_writel_bit(bank, offset, data, bank->gpio_regs->port_ddr);
@@ -181,11 +197,41 @@ static void rockchip_gpio_set(struct gpio_chip *gc, unsigned int offset,
 	struct rockchip_pin_bank *bank = gpiochip_get_data(gc);
 	unsigned long flags;
 
+	if (bank->gpio_type == GPIO_TYPE_V2) {
+		rockchip_gpio_writel_bit(bank, offset, value, bank->gpio_regs->port_dr);
+		return;
+	}
+
 	raw_spin_lock_irqsave(&bank->slock, flags);
 	rockchip_gpio_writel_bit(bank, offset, value, bank->gpio_regs->port_dr);
 	raw_spin_unlock_irqrestore(&bank->slock, flags);
 }
 
+static void rockchip_gpio_set_multiple(struct gpio_chip *gc,
+				       unsigned long *mask, unsigned long *bits)
+{
+	struct rockchip_pin_bank *bank = gpiochip_get_data(gc);
+	void __iomem *reg = bank->reg_base + bank->gpio_regs->port_dr;
+	u32 m = *mask, b = *bits & m;
+	unsigned long flags;
+	u32 data;
+
+	if (bank->gpio_type == GPIO_TYPE_V2) {
+		/* one write per 16 bit half, the mask selects the pins */
+		if (m & 0xffff)
+			writel((m & 0xffff) << 16 | (b & 0xffff), reg);
+		if (m >> 16)
+			writel((m >> 16) << 16 | (b >> 16), reg + 0x4);
+		return;
+	}
+
+	raw_spin_lock_irqsave(&bank->slock, flags);
+	data = readl(reg);
+	data = (data & ~m) | b;
+	writel(data, reg);
+	raw_spin_unlock_irqrestore(&bank->slock, flags);
+}
+
 static int rockchip_gpio_get(struct gpio_chip *gc, unsigned int offset)
 {
 	struct rockchip_pin_bank *bank = gpiochip_get_data(gc);
@@ -198,6 +244,18 @@ static int rockchip_gpio_get(struct gpio_chip *gc, unsigned int offset)
 	return data;
 }
 
+static int rockchip_gpio_get_multiple(struct gpio_chip *gc,
+				      unsigned long *mask, unsigned long *bits)
+{
+	struct rockchip_pin_bank *bank = gpiochip_get_data(gc);
+	u32 data;
+
+	data = readl(bank->reg_base + bank->gpio_regs->ext_port);
+	*bits = (*bits & ~*mask) | (data & *mask);
+
+	return 0;
+}
+
 static int rockchip_gpio_set_debounce(struct gpio_chip *gc,
 				      unsigned int offset,
 				      unsigned int debounce)
@@ -328,6 +386,8 @@ static const struct gpio_chip rockchip_gpiolib_chip = {
 	.free = gpiochip_generic_free,
 	.set = rockchip_gpio_set,
 	.get = rockchip_gpio_get,
+	.set_multiple = rockchip_gpio_set_multiple,
+	.get_multiple = rockchip_gpio_get_multiple,
 	.get_direction	= rockchip_gpio_get_direction,
 	.direction_input = rockchip_gpio_direction_input,
 	.direction_output = rockchip_gpio_direction_output,
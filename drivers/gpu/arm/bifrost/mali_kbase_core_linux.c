@@ -693,6 +693,70 @@ static const struct file_operations kbase_force_same_va_fops = {
 	.write = write_ctx_force_same_va,
 	.read = read_ctx_force_same_va,
 };
+
+#if !MALI_USE_CSF
+static ssize_t write_ctx_frame_deadline(struct file *f, const char __user *ubuf, size_t size,
+					loff_t *off)
+{
+	struct kbase_context *kctx = f->private_data;
+	int err;
+	u64 value;
+
+	CSTD_UNUSED(off);
+
+	err = kstrtou64_from_user(ubuf, size, 0, &value);
+	if (err)
+		return err;
+
+	kbase_js_set_frame_deadline(kctx, ns_to_ktime(value));
+
+	return size;
+}
+
+static ssize_t read_ctx_frame_deadline(struct file *f, char __user *ubuf, size_t size,
+				       loff_t *off)
+{
+	struct kbase_context *kctx = f->private_data;
+	char buf[32];
+	int count;
+
+	count = scnprintf(buf, sizeof(buf), "%lld\n", ktime_to_ns(READ_ONCE(kctx->frame_deadline)));
+
+	return simple_read_from_buffer(ubuf, size, off, buf, count);
+}
+
+static const struct file_operations kbase_frame_deadline_fops = {
+	.owner = THIS_MODULE,
+	.open = simple_open,
+	.write = write_ctx_frame_deadline,
+	.read = read_ctx_frame_deadline,
+};
+
+static ssize_t read_ctx_sched_latency(struct file *f, char __user *ubuf, size_t size,
+				      loff_t *off)
+{
+	struct kbase_context *kctx = f->private_data;
+	struct kbase_js_sched_latency lat;
+	unsigned long flags;
+	char buf[96];
+	int count;
+
+	spin_lock_irqsave(&kctx->kbdev->hwaccess_lock, flags);
+	lat = kctx->sched_latency;
+	spin_unlock_irqrestore(&kctx->kbdev->hwaccess_lock, flags);
+
+	count = scnprintf(buf, sizeof(buf), "count %llu avg_ns %llu max_ns %llu\n", lat.count,
+			  lat.count ? div64_u64(lat.total_ns, lat.count) : 0, lat.max_ns);
+
+	return simple_read_from_buffer(ubuf, size, off, buf, count);
+}
+
+static const struct file_operations kbase_sched_latency_fops = {
+	.owner = THIS_MODULE,
+	.open = simple_open,
+	.read = read_ctx_sched_latency,
+};
+#endif /* !MALI_USE_CSF */
 #endif /* CONFIG_DEBUG_FS */
 
 static int kbase_file_create_kctx(struct kbase_file *const kfile,
@@ -741,6 +805,12 @@ static int kbase_file_create_kctx(struct kbase_file *const kfile,
 				    &kbase_infinite_cache_fops);
 		debugfs_create_file("force_same_va", 0600, kctx->kctx_dentry, kctx,
 				    &kbase_force_same_va_fops);
+#if !MALI_USE_CSF
+		debugfs_create_file("frame_deadline", 0600, kctx->kctx_dentry, kctx,
+				    &kbase_frame_deadline_fops);
+		debugfs_create_file("sched_latency", 0444, kctx->kctx_dentry, kctx,
+				    &kbase_sched_latency_fops);
+#endif
 
 		kbase_context_debugfs_init(kctx);
 	}
@@ -3833,6 +3903,120 @@ static ssize_t lp_mem_pool_max_size_store(struct device *dev, struct device_attr
 
 static DEVICE_ATTR_RW(lp_mem_pool_max_size);
 
+/**
+ * mem_pool_watermark_show - Show the watermark of the small memory pages pool.
+ * @dev:  The device this sysfs file is for.
+ * @attr: The attributes of the sysfs file.
+ * @buf:  The output buffer to receive the watermarks.
+ *
+ * This function is called to get the number of small memory pages the background grower keeps in the kbdev pool.
+ *
+ * Return: The number of bytes output to @buf.
+ */
+static ssize_t mem_pool_watermark_show(struct device *dev, struct device_attribute *attr,
+				      char *const buf)
+{
+	struct kbase_device *const kbdev = to_kbase_device(dev);
+
+	CSTD_UNUSED(attr);
+
+	if (!kbdev)
+		return -ENODEV;
+
+	return kbase_debugfs_helper_get_attr_to_string(buf, PAGE_SIZE, kbdev->mem_pools.small,
+						       MEMORY_GROUP_MANAGER_NR_GROUPS,
+						       kbase_mem_pool_debugfs_watermark);
+}
+
+/**
+ * mem_pool_watermark_store - Set the watermark of the small memory pages pool.
+ * @dev:   The device this sysfs file is for.
+ * @attr:  The attributes of the sysfs file.
+ * @buf:   The value written to the sysfs file.
+ * @count: The number of bytes written to the sysfs file.
+ *
+ * This function is called to set the number of small memory pages the background grower keeps in the kbdev pool.
+ * The watermark is clamped to the maximum size of the pool, 0 disables background growing.
+ *
+ * Return: @count if the function succeeded. An error code on failure.
+ */
+static ssize_t mem_pool_watermark_store(struct device *dev, struct device_attribute *attr,
+				       const char *buf, size_t count)
+{
+	struct kbase_device *const kbdev = to_kbase_device(dev);
+	ssize_t err;
+
+	CSTD_UNUSED(attr);
+
+	if (!kbdev)
+		return -ENODEV;
+
+	err = kbase_debugfs_helper_set_attr_from_string(buf, kbdev->mem_pools.small,
+							MEMORY_GROUP_MANAGER_NR_GROUPS,
+							kbase_mem_pool_debugfs_set_watermark);
+
+	return err ? err : (ssize_t)count;
+}
+
+static DEVICE_ATTR_RW(mem_pool_watermark);
+
+/**
+ * lp_mem_pool_watermark_show - Show the watermark of the large memory pages pool.
+ * @dev:  The device this sysfs file is for.
+ * @attr: The attributes of the sysfs file.
+ * @buf:  The output buffer to receive the watermarks.
+ *
+ * This function is called to get the number of large memory pages the background grower keeps in the kbdev pool.
+ *
+ * Return: The number of bytes output to @buf.
+ */
+static ssize_t lp_mem_pool_watermark_show(struct device *dev, struct device_attribute *attr,
+					 char *const buf)
+{
+	struct kbase_device *const kbdev = to_kbase_device(dev);
+
+	CSTD_UNUSED(attr);
+
+	if (!kbdev)
+		return -ENODEV;
+
+	return kbase_debugfs_helper_get_attr_to_string(buf, PAGE_SIZE, kbdev->mem_pools.large,
+						       MEMORY_GROUP_MANAGER_NR_GROUPS,
+						       kbase_mem_pool_debugfs_watermark);
+}
+
+/**
+ * lp_mem_pool_watermark_store - Set the watermark of the large memory pages pool.
+ * @dev:   The device this sysfs file is for.
+ * @attr:  The attributes of the sysfs file.
+ * @buf:   The value written to the sysfs file.
+ * @count: The number of bytes written to the sysfs file.
+ *
+ * This function is called to set the number of large memory pages the background grower keeps in the kbdev pool.
+ * The watermark is clamped to the maximum size of the pool, 0 disables background growing.
+ *
+ * Return: @count if the function succeeded. An error code on failure.
+ */
+static ssize_t lp_mem_pool_watermark_store(struct device *dev, struct device_attribute *attr,
+					  const char *buf, size_t count)
+{
+	struct kbase_device *const kbdev = to_kbase_device(dev);
+	ssize_t err;
+
+	CSTD_UNUSED(attr);
+
+	if (!kbdev)
+		return -ENODEV;
+
+	err = kbase_debugfs_helper_set_attr_from_string(buf, kbdev->mem_pools.large,
+							MEMORY_GROUP_MANAGER_NR_GROUPS,
+							kbase_mem_pool_debugfs_set_watermark);
+
+	return err ? err : (ssize_t)count;
+}
+
+static DEVICE_ATTR_RW(lp_mem_pool_watermark);
+
 /**
  * show_simplified_mem_pool_max_size - Show the maximum size for the memory
  *                                     pool 0 of small (4KiB) pages.
@@ -5002,6 +5186,7 @@ static struct dentry *init_debugfs(struct kbase_device *kbdev)
 #endif /* !MALI_USE_CSF */
 
 	kbasep_gpu_memory_debugfs_init(kbdev);
+	kbase_mem_pool_debugfs_device_init(kbdev->mali_debugfs_directory, kbdev);
 	kbase_as_fault_debugfs_init(kbdev);
 #ifdef CONFIG_MALI_PRFCNT_SET_SELECT_VIA_DEBUG_FS
 	kbase_instr_backend_debugfs_init(kbdev);
@@ -5692,6 +5877,8 @@ static struct attribute *kbase_attrs[] = {
 	&dev_attr_mem_pool_max_size.attr,
 	&dev_attr_lp_mem_pool_size.attr,
 	&dev_attr_lp_mem_pool_max_size.attr,
+	&dev_attr_mem_pool_watermark.attr,
+	&dev_attr_lp_mem_pool_watermark.attr,
 #if !MALI_USE_CSF
 	&dev_attr_js_ctx_scheduling_mode.attr,
 #endif /* !MALI_USE_CSF */
@@ -541,6 +541,12 @@ struct kbase_pm_device_data {
  *                             operations should be abandoned
  * @dont_reclaim:              true if the shrinker is forbidden from reclaiming memory from
  *                             this pool, eg during a grow operation
+ * @watermark:                 Number of free pages the background grower keeps in the pool,
+ *                             0 if the pool is only grown on demand
+ * @reclaim_jiffies:           Time of the last shrinker scan or failed background grow,
+ *                             the grower backs off for a while after either
+ * @hits:                      Number of pages allocated straight from the pool
+ * @misses:                    Number of pages the pool could not provide
  */
 struct kbase_mem_pool {
 	struct kbase_device *kbdev;
@@ -557,6 +563,11 @@ struct kbase_mem_pool {
 
 	bool dying;
 	bool dont_reclaim;
+
+	size_t watermark;
+	unsigned long reclaim_jiffies;
+	u64 hits;
+	u64 misses;
 };
 
 /**
@@ -823,6 +834,8 @@ struct kbase_mem_migrate {
  *                         the device
  * @mem_pools:             Global pools of free physical memory pages which can
  *                         be used by all the contexts.
+ * @mem_pool_grower:       Kernel thread keeping @mem_pools filled up to their
+ *                         watermarks.
  * @memdev:                keeps track of the in use physical pages allocated by
  *                         the Driver.
  * @mmu_mode:              Pointer to the object containing methods for programming
@@ -1131,6 +1144,7 @@ struct kbase_device {
 	struct kbase_pm_device_data pm;
 
 	struct kbase_mem_pool_group mem_pools;
+	struct task_struct *mem_pool_grower;
 	struct kbasep_mem_device memdev;
 	struct kbase_mmu_mode const *mmu_mode;
 
@@ -1666,6 +1680,19 @@ struct kbase_sub_alloc {
 	DECLARE_BITMAP(sub_pages, SZ_2M / SZ_4K);
 };
 
+/**
+ * struct kbase_js_sched_latency - Time a context waited to be scheduled
+ *
+ * @count:     Number of times the context was popped from a pullable queue.
+ * @total_ns:  Sum of the time spent on the pullable queues.
+ * @max_ns:    Longest single wait.
+ */
+struct kbase_js_sched_latency {
+	u64 count;
+	u64 total_ns;
+	u64 max_ns;
+};
+
 /**
  * struct kbase_context - Kernel base context
  *
@@ -1742,6 +1769,8 @@ struct kbase_sub_alloc {
  *                        when special tracking page is freed by userspace where it
  *                        is reset to 0.
  * @permanent_mapped_pages: Usage count of permanently mapped memory
+ * @page_faults:          Number of GPU page faults handled for this context,
+ *                        incremented by the MMU page fault worker.
  * @mem_pools:            Context-specific pools of free physical memory pages.
  * @reclaim:              Shrinker object registered with the kernel containing
  *                        the pointer to callback function which is invoked under
@@ -1907,6 +1936,12 @@ struct kbase_sub_alloc {
  * @priority:             Indicates the context priority. Used along with @atoms_count
  *                        for context scheduling, protected by hwaccess_lock.
  * @atoms_count:          Number of GPU atoms currently in use, per priority
+ * @frame_deadline:       Frame deadline hint, the context is scheduled at high
+ *                        priority until then. Protected by hwaccess_lock.
+ * @pullable_since:       Per slot, time the context was last added to the
+ *                        pullable queue, protected by hwaccess_lock.
+ * @sched_latency:        Time the context spent waiting on the pullable queues,
+ *                        protected by hwaccess_lock.
  * @create_flags:         Flags used in context creation.
  * @kinstr_jm:            Kernel job manager instrumentation context handle
  * @tl_kctx_list_node:    List item into the device timeline's list of
@@ -1972,6 +2007,9 @@ struct kbase_context {
 
 	int priority;
 	s16 atoms_count[KBASE_JS_ATOM_SCHED_PRIO_COUNT];
+	ktime_t frame_deadline;
+	ktime_t pullable_since[BASE_JM_MAX_NR_SLOTS];
+	struct kbase_js_sched_latency sched_latency;
 	u32 slots_pullable;
 	u32 age_count;
 #endif /* MALI_USE_CSF */
@@ -1984,6 +2022,7 @@ struct kbase_context {
 	atomic_t used_pages;
 	atomic_t nonmapped_pages;
 	atomic_t permanent_mapped_pages;
+	atomic_t page_faults;
 
 	struct kbase_mem_pool_group mem_pools;
 
@@ -962,6 +962,7 @@ static bool kbase_js_ctx_list_add_pullable_nolock(struct kbase_device *kbdev,
 
 	list_add_tail(&kctx->jctx.sched_info.ctx.ctx_list_entry[js],
 		      &kbdev->js_data.ctx_list_pullable[js][kctx->priority]);
+	kctx->pullable_since[js] = ktime_get();
 
 	if (!kctx->slots_pullable) {
 		kbdev->js_data.nr_contexts_pullable++;
@@ -1003,6 +1004,7 @@ static bool kbase_js_ctx_list_add_pullable_head_nolock(struct kbase_device *kbde
 
 	list_add(&kctx->jctx.sched_info.ctx.ctx_list_entry[js],
 		 &kbdev->js_data.ctx_list_pullable[js][kctx->priority]);
+	kctx->pullable_since[js] = ktime_get();
 
 	if (!kctx->slots_pullable) {
 		kbdev->js_data.nr_contexts_pullable++;
@@ -1129,6 +1131,28 @@ static bool kbase_js_ctx_list_remove_nolock(struct kbase_device *kbdev, struct k
 	return ret;
 }
 
+/**
+ * kbase_js_account_sched_latency - Account the time a context waited on the
+ *                                  pullable queue of a slot
+ * @kctx:  Context popped from the queue
+ * @js:    Job slot the context was popped for
+ *
+ * Caller must hold hwaccess_lock
+ */
+static void kbase_js_account_sched_latency(struct kbase_context *kctx, unsigned int js)
+{
+	struct kbase_js_sched_latency *lat = &kctx->sched_latency;
+	u64 ns;
+
+	lockdep_assert_held(&kctx->kbdev->hwaccess_lock);
+
+	ns = ktime_to_ns(ktime_sub(ktime_get(), kctx->pullable_since[js]));
+	lat->count++;
+	lat->total_ns += ns;
+	if (ns > lat->max_ns)
+		lat->max_ns = ns;
+}
+
 /**
  * kbase_js_ctx_list_pop_head_nolock - Variant of kbase_js_ctx_list_pop_head()
  *                                     where the caller must hold
@@ -1157,6 +1181,7 @@ static struct kbase_context *kbase_js_ctx_list_pop_head_nolock(struct kbase_devi
 				  struct kbase_context, jctx.sched_info.ctx.ctx_list_entry[js]);
 
 		list_del_init(&kctx->jctx.sched_info.ctx.ctx_list_entry[js]);
+		kbase_js_account_sched_latency(kctx, js);
 		dev_dbg(kbdev->dev, "Popped %pK from the pullable queue (s:%u)\n", (void *)kctx,
 			js);
 		return kctx;
@@ -1443,10 +1468,32 @@ void kbase_js_update_ctx_priority(struct kbase_context *kctx)
 		}
 	}
 
+	/* Ahead of a frame deadline hint, let the context overtake the
+	 * medium and low priority contexts competing for the slots.
+	 */
+	if (new_priority > KBASE_JS_ATOM_SCHED_PRIO_HIGH &&
+	    ktime_before(ktime_get(), kctx->frame_deadline))
+		new_priority = KBASE_JS_ATOM_SCHED_PRIO_HIGH;
+
 	kbase_js_set_ctx_priority(kctx, new_priority);
 }
 KBASE_EXPORT_TEST_API(kbase_js_update_ctx_priority);
 
+void kbase_js_set_frame_deadline(struct kbase_context *kctx, ktime_t deadline)
+{
+	struct kbase_device *kbdev = kctx->kbdev;
+	unsigned long flags;
+
+	mutex_lock(&kctx->jctx.sched_info.ctx.jsctx_mutex);
+	spin_lock_irqsave(&kbdev->hwaccess_lock, flags);
+	kctx->frame_deadline = deadline;
+	kbase_js_update_ctx_priority(kctx);
+	spin_unlock_irqrestore(&kbdev->hwaccess_lock, flags);
+	mutex_unlock(&kctx->jctx.sched_info.ctx.jsctx_mutex);
+
+	kbase_js_sched_all(kbdev);
+}
+
 /**
  * js_add_start_rp() - Add an atom that starts a renderpass to the job scheduler
  * @start_katom: Pointer to the atom to be added.
@@ -1591,8 +1638,11 @@ bool kbasep_js_add_job(struct kbase_context *kctx, struct kbase_jd_atom *atom)
 	/* Lock for state available during IRQ */
 	spin_lock_irqsave(&kbdev->hwaccess_lock, flags);
 
-	if (++kctx->atoms_count[atom->sched_priority] == 1)
-		kbase_js_update_ctx_priority(kctx);
+	/* Also re-evaluated on every submission so that an expired frame
+	 * deadline boost is dropped
+	 */
+	++kctx->atoms_count[atom->sched_priority];
+	kbase_js_update_ctx_priority(kctx);
 
 	if (!kbase_js_dep_validate(kctx, atom)) {
 		/* Dependencies could not be represented */
@@ -33,4 +33,18 @@
 #include "jm/mali_kbase_jm_js.h"
 #include "jm/mali_kbase_js_defs.h"
 
+#if !MALI_USE_CSF
+/**
+ * kbase_js_set_frame_deadline - Set the frame deadline hint of a context
+ * @kctx:      Context the hint applies to
+ * @deadline:  CLOCK_MONOTONIC time the context's next frame is due, e.g. the
+ *             next vsync of the display it renders for
+ *
+ * Until @deadline the context is scheduled at least at
+ * KBASE_JS_ATOM_SCHED_PRIO_HIGH, ahead of medium and low priority contexts.
+ * A deadline in the past clears the hint.
+ */
+void kbase_js_set_frame_deadline(struct kbase_context *kctx, ktime_t deadline);
+#endif
+
 #endif /* _KBASE_JS_H_ */
@@ -265,6 +265,11 @@ int kbase_mem_init(struct kbase_device *kbdev)
 							 KBASE_MEM_POOL_MAX_SIZE_KBDEV);
 
 		err = kbase_mem_pool_group_init(&kbdev->mem_pools, kbdev, &mem_pool_defaults, NULL);
+		if (!err) {
+			err = kbase_mem_pool_group_grower_init(kbdev);
+			if (err)
+				kbase_mem_pool_group_term(&kbdev->mem_pools);
+		}
 	}
 
 	return err;
@@ -288,6 +293,7 @@ void kbase_mem_term(struct kbase_device *kbdev)
 	if (pages != 0)
 		dev_warn(kbdev->dev, "%s: %d pages in use!\n", __func__, pages);
 
+	kbase_mem_pool_group_grower_term(kbdev);
 	kbase_mem_pool_group_term(&kbdev->mem_pools);
 
 	kbase_mem_migrate_term(kbdev);
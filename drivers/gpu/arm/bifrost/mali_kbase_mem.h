@@ -366,6 +366,7 @@ struct kbase_mem_phy_alloc {
 			unsigned int current_mapping_usage_count;
 			struct sg_table *sgt;
 			bool need_sync;
+			bool cpu_uncached;
 		} umm;
 		struct {
 			u64 stride;
@@ -1238,6 +1239,37 @@ static inline size_t kbase_mem_pool_max_size(struct kbase_mem_pool *pool)
  */
 void kbase_mem_pool_set_max_size(struct kbase_mem_pool *pool, size_t max_size);
 
+/**
+ * kbase_mem_pool_watermark - Get number of free pages kept in memory pool
+ * @pool:  Memory pool to inspect
+ *
+ * Return: Number of free pages the background grower keeps in the pool
+ */
+static inline size_t kbase_mem_pool_watermark(struct kbase_mem_pool *pool)
+{
+	return pool->watermark;
+}
+
+/**
+ * kbase_mem_pool_set_watermark - Set number of free pages kept in memory pool
+ * @pool:      Memory pool to configure
+ * @watermark: Number of free pages the background grower keeps in the pool,
+ *             clamped to the maximum size of the pool. 0 disables the grower
+ *             for this pool.
+ *
+ * Only the device wide pools are refilled by the grower, see
+ * kbase_mem_pool_group_grower_init().
+ */
+void kbase_mem_pool_set_watermark(struct kbase_mem_pool *pool, size_t watermark);
+
+/**
+ * kbase_mem_pool_get_stats - Get allocation statistics of memory pool
+ * @pool:   Memory pool to inspect
+ * @hits:   Returns the number of pages allocated straight from the pool
+ * @misses: Returns the number of pages the pool could not provide
+ */
+void kbase_mem_pool_get_stats(struct kbase_mem_pool *pool, u64 *hits, u64 *misses);
+
 /**
  * kbase_mem_pool_grow - Grow the pool
  * @pool:       Memory pool to grow
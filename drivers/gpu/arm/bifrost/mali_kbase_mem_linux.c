@@ -1116,6 +1116,10 @@ int kbase_mem_do_sync_imported(struct kbase_context *kctx, struct kbase_va_regio
 	/* Currently only handle dma-bufs */
 	if (reg->gpu_alloc->type != KBASE_MEM_TYPE_IMPORTED_UMM)
 		return ret;
+
+	/* The exporter maps the buffer uncached, there is nothing to sync */
+	if (reg->gpu_alloc->imported.umm.cpu_uncached)
+		return 0;
 	/*
 	 * Attempting to sync with CONFIG_MALI_DMA_BUF_MAP_ON_DEMAND
 	 * enabled can expose us to a Linux Kernel issue between v4.6 and
@@ -1369,6 +1373,21 @@ void kbase_mem_umm_unmap(struct kbase_context *kctx, struct kbase_va_region *reg
 	kbase_mem_umm_unmap_attachment(kctx, alloc);
 }
 
+/**
+ * kbase_mem_umm_is_cpu_uncached - Check if a dma-buf is never cached by the CPU
+ * @dma_buf: dma-buf being imported
+ *
+ * The Rockchip system and cma heaps export their uncached buffers from the
+ * "*-uncached*" heaps, whose CPU mappings are write-combined and whose
+ * cache maintenance callbacks only do bookkeeping.
+ *
+ * Return: true if syncing the buffer for the CPU or the GPU is a no-op.
+ */
+static bool kbase_mem_umm_is_cpu_uncached(struct dma_buf *dma_buf)
+{
+	return dma_buf->exp_name && strstr(dma_buf->exp_name, "-uncached");
+}
+
 static int get_umm_memory_group_id(struct kbase_context *kctx, struct dma_buf *dma_buf)
 {
 	int group_id = BASE_MEM_GROUP_DEFAULT;
@@ -1456,6 +1475,9 @@ static struct kbase_va_region *kbase_mem_from_umm(struct kbase_context *kctx, in
 	if (*flags & BASE_MEM_IMPORT_SYNC_ON_MAP_UNMAP)
 		need_sync = true;
 
+	if (kbase_mem_umm_is_cpu_uncached(dma_buf))
+		need_sync = false;
+
 	if (!kbase_ctx_compat_mode(kctx)) {
 		/*
 		 * 64-bit tasks require us to reserve VA on the CPU that we use
@@ -1508,6 +1530,7 @@ static struct kbase_va_region *kbase_mem_from_umm(struct kbase_context *kctx, in
 	reg->gpu_alloc->imported.umm.dma_attachment = dma_attachment;
 	reg->gpu_alloc->imported.umm.current_mapping_usage_count = 0;
 	reg->gpu_alloc->imported.umm.need_sync = need_sync;
+	reg->gpu_alloc->imported.umm.cpu_uncached = kbase_mem_umm_is_cpu_uncached(dma_buf);
 	reg->gpu_alloc->imported.umm.kctx = kctx;
 	reg->extension = 0;
 
@@ -42,6 +42,25 @@
 #define NOT_DIRTY false
 #define NOT_RECLAIMED false
 
+/* Wake the background grower once a watermarked pool drops below its mark */
+static void kbase_mem_pool_check_watermark(struct kbase_mem_pool *pool)
+{
+	struct task_struct *grower = READ_ONCE(pool->kbdev->mem_pool_grower);
+
+	lockdep_assert_held(&pool->pool_lock);
+
+	if (pool->watermark && kbase_mem_pool_size(pool) < pool->watermark && grower)
+		wake_up_process(grower);
+}
+
+static void kbase_mem_pool_account_miss_locked(struct kbase_mem_pool *pool, size_t nr_pages)
+{
+	lockdep_assert_held(&pool->pool_lock);
+
+	pool->misses += nr_pages;
+	kbase_mem_pool_check_watermark(pool);
+}
+
 /**
  * can_alloc_page() - Check if the current thread can allocate a physical page
  *
@@ -222,6 +241,11 @@ static struct page *kbase_mem_pool_remove_locked(struct kbase_mem_pool *pool,
 	list_del_init(&p->lru);
 	pool->cur_size--;
 
+	if (status == ALLOCATE_IN_PROGRESS) {
+		pool->hits++;
+		kbase_mem_pool_check_watermark(pool);
+	}
+
 	pool_dbg(pool, "removed page\n");
 
 	return p;
@@ -458,6 +482,7 @@ void kbase_mem_pool_set_max_size(struct kbase_mem_pool *pool, size_t max_size)
 	kbase_mem_pool_lock(pool);
 
 	pool->max_size = max_size;
+	pool->watermark = min(pool->watermark, max_size);
 
 	cur_size = kbase_mem_pool_size(pool);
 	if (max_size < cur_size) {
@@ -469,6 +494,22 @@ void kbase_mem_pool_set_max_size(struct kbase_mem_pool *pool, size_t max_size)
 }
 KBASE_EXPORT_TEST_API(kbase_mem_pool_set_max_size);
 
+void kbase_mem_pool_set_watermark(struct kbase_mem_pool *pool, size_t watermark)
+{
+	kbase_mem_pool_lock(pool);
+	pool->watermark = min(watermark, pool->max_size);
+	kbase_mem_pool_check_watermark(pool);
+	kbase_mem_pool_unlock(pool);
+}
+
+void kbase_mem_pool_get_stats(struct kbase_mem_pool *pool, u64 *hits, u64 *misses)
+{
+	kbase_mem_pool_lock(pool);
+	*hits = pool->hits;
+	*misses = pool->misses;
+	kbase_mem_pool_unlock(pool);
+}
+
 static unsigned long kbase_mem_pool_reclaim_count_objects(struct shrinker *s,
 							  struct shrink_control *sc)
 {
@@ -512,6 +553,8 @@ static unsigned long kbase_mem_pool_reclaim_scan_objects(struct shrinker *s,
 
 	pool_dbg(pool, "reclaim scan %ld:\n", sc->nr_to_scan);
 
+	/* Keep the background grower from refilling what was just reclaimed */
+	pool->reclaim_jiffies = jiffies;
 	freed = kbase_mem_pool_shrink_locked(pool, sc->nr_to_scan);
 
 	kbase_mem_pool_unlock(pool);
@@ -536,6 +579,10 @@ int kbase_mem_pool_init(struct kbase_mem_pool *pool, const struct kbase_mem_pool
 	pool->kbdev = kbdev;
 	pool->next_pool = next_pool;
 	pool->dying = false;
+	pool->watermark = 0;
+	pool->reclaim_jiffies = jiffies;
+	pool->hits = 0;
+	pool->misses = 0;
 	atomic_set(&pool->isolation_in_progress_cnt, 0);
 
 	spin_lock_init(&pool->pool_lock);
@@ -640,7 +687,11 @@ struct page *kbase_mem_pool_alloc(struct kbase_mem_pool *pool)
 
 	do {
 		pool_dbg(pool, "alloc()\n");
-		p = kbase_mem_pool_remove(pool, ALLOCATE_IN_PROGRESS);
+		kbase_mem_pool_lock(pool);
+		p = kbase_mem_pool_remove_locked(pool, ALLOCATE_IN_PROGRESS);
+		if (!p)
+			kbase_mem_pool_account_miss_locked(pool, 1);
+		kbase_mem_pool_unlock(pool);
 
 		if (p)
 			return p;
@@ -653,10 +704,16 @@ struct page *kbase_mem_pool_alloc(struct kbase_mem_pool *pool)
 
 struct page *kbase_mem_pool_alloc_locked(struct kbase_mem_pool *pool)
 {
+	struct page *p;
+
 	lockdep_assert_held(&pool->pool_lock);
 
 	pool_dbg(pool, "alloc_locked()\n");
-	return kbase_mem_pool_remove_locked(pool, ALLOCATE_IN_PROGRESS);
+	p = kbase_mem_pool_remove_locked(pool, ALLOCATE_IN_PROGRESS);
+	if (!p)
+		kbase_mem_pool_account_miss_locked(pool, 1);
+
+	return p;
 }
 
 void kbase_mem_pool_free(struct kbase_mem_pool *pool, struct page *p, bool dirty)
@@ -724,6 +781,8 @@ int kbase_mem_pool_alloc_pages(struct kbase_mem_pool *pool, size_t nr_4k_pages,
 	/* Get pages from this pool */
 	kbase_mem_pool_lock(pool);
 	nr_from_pool = min(nr_pages_internal, kbase_mem_pool_size(pool));
+	if (nr_from_pool < nr_pages_internal)
+		kbase_mem_pool_account_miss_locked(pool, nr_pages_internal - nr_from_pool);
 
 	while (nr_from_pool--) {
 		uint j;
@@ -808,6 +867,7 @@ int kbase_mem_pool_alloc_pages_locked(struct kbase_mem_pool *pool, size_t nr_4k_
 
 	if (kbase_mem_pool_size(pool) < nr_pages_internal) {
 		pool_dbg(pool, "Failed alloc\n");
+		kbase_mem_pool_account_miss_locked(pool, nr_pages_internal);
 		return -ENOMEM;
 	}
 
@@ -65,6 +65,26 @@ size_t kbase_mem_pool_debugfs_max_size(void *const array, size_t const index)
 	return kbase_mem_pool_max_size(&mem_pools[index]);
 }
 
+void kbase_mem_pool_debugfs_set_watermark(void *const array, size_t const index, size_t const value)
+{
+	struct kbase_mem_pool *const mem_pools = array;
+
+	if (WARN_ON(!mem_pools) || WARN_ON(index >= MEMORY_GROUP_MANAGER_NR_GROUPS))
+		return;
+
+	kbase_mem_pool_set_watermark(&mem_pools[index], value);
+}
+
+size_t kbase_mem_pool_debugfs_watermark(void *const array, size_t const index)
+{
+	struct kbase_mem_pool *const mem_pools = array;
+
+	if (WARN_ON(!mem_pools) || WARN_ON(index >= MEMORY_GROUP_MANAGER_NR_GROUPS))
+		return 0;
+
+	return kbase_mem_pool_watermark(&mem_pools[index]);
+}
+
 void kbase_mem_pool_config_debugfs_set_max_size(void *const array, size_t const index,
 						size_t const value)
 {
@@ -150,6 +170,47 @@ static const struct file_operations kbase_mem_pool_debugfs_max_size_fops = {
 	.release = single_release,
 };
 
+static int kbase_mem_pool_debugfs_stats_show(struct seq_file *sfile, void *data)
+{
+	struct kbase_mem_pool *const mem_pools = sfile->private;
+	size_t i;
+
+	CSTD_UNUSED(data);
+
+	seq_puts(sfile, "group size watermark hits misses\n");
+	for (i = 0; i < MEMORY_GROUP_MANAGER_NR_GROUPS; i++) {
+		u64 hits, misses;
+
+		kbase_mem_pool_get_stats(&mem_pools[i], &hits, &misses);
+		seq_printf(sfile, "%zu %zu %zu %llu %llu\n", i, kbase_mem_pool_size(&mem_pools[i]),
+			   kbase_mem_pool_watermark(&mem_pools[i]), hits, misses);
+	}
+
+	return 0;
+}
+
+static int kbase_mem_pool_debugfs_stats_open(struct inode *in, struct file *file)
+{
+	return single_open(file, kbase_mem_pool_debugfs_stats_show, in->i_private);
+}
+
+static const struct file_operations kbase_mem_pool_debugfs_stats_fops = {
+	.owner = THIS_MODULE,
+	.open = kbase_mem_pool_debugfs_stats_open,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
+void kbase_mem_pool_debugfs_device_init(struct dentry *parent, struct kbase_device *kbdev)
+{
+	debugfs_create_file("mem_pool_stats", 0444, parent, &kbdev->mem_pools.small,
+			    &kbase_mem_pool_debugfs_stats_fops);
+
+	debugfs_create_file("lp_mem_pool_stats", 0444, parent, &kbdev->mem_pools.large,
+			    &kbase_mem_pool_debugfs_stats_fops);
+}
+
 void kbase_mem_pool_debugfs_init(struct dentry *parent, struct kbase_context *kctx)
 {
 	const mode_t mode = 0644;
@@ -165,4 +226,10 @@ void kbase_mem_pool_debugfs_init(struct dentry *parent, struct kbase_context *kc
 
 	debugfs_create_file("lp_mem_pool_max_size", mode, parent, &kctx->mem_pools.large,
 			    &kbase_mem_pool_debugfs_max_size_fops);
+
+	debugfs_create_file("mem_pool_stats", 0444, parent, &kctx->mem_pools.small,
+			    &kbase_mem_pool_debugfs_stats_fops);
+
+	debugfs_create_file("lp_mem_pool_stats", 0444, parent, &kctx->mem_pools.large,
+			    &kbase_mem_pool_debugfs_stats_fops);
 }
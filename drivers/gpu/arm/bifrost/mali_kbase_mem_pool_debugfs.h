@@ -34,9 +34,24 @@
  * - mem_pool_max_size: get/set the max sizes of @kctx: mem_pools
  * - lp_mem_pool_size: get/set the current sizes of @kctx: lp_mem_pool
  * - lp_mem_pool_max_size: get/set the max sizes of @kctx:lp_mem_pool
+ *
+ * and two read-only files with the hit/miss counters of each pool:
+ * - mem_pool_stats
+ * - lp_mem_pool_stats
  */
 void kbase_mem_pool_debugfs_init(struct dentry *parent, struct kbase_context *kctx);
 
+/**
+ * kbase_mem_pool_debugfs_device_init - add debugfs statistics for the device
+ *                                      wide memory pools
+ * @parent:  Parent debugfs dentry
+ * @kbdev:   The kbase device
+ *
+ * Adds mem_pool_stats and lp_mem_pool_stats under @parent, one line per
+ * memory group with the pool size, watermark, hits and misses.
+ */
+void kbase_mem_pool_debugfs_device_init(struct dentry *parent, struct kbase_device *kbdev);
+
 /**
  * kbase_mem_pool_debugfs_trim - Grow or shrink a memory pool to a new size
  *
@@ -90,6 +105,29 @@ size_t kbase_mem_pool_debugfs_size(void *array, size_t index);
  */
 size_t kbase_mem_pool_debugfs_max_size(void *array, size_t index);
 
+/**
+ * kbase_mem_pool_debugfs_set_watermark - Set number of free pages the
+ *                                        background grower keeps in a pool
+ *
+ * @array: Address of the first in an array of physical memory pools.
+ * @index: A memory group ID to be used as an index into the array of memory
+ *         pools. Valid range is 0..(MEMORY_GROUP_MANAGER_NR_GROUPS-1).
+ * @value: Number of free pages to keep, 0 disables background growing.
+ */
+void kbase_mem_pool_debugfs_set_watermark(void *array, size_t index, size_t value);
+
+/**
+ * kbase_mem_pool_debugfs_watermark - Get number of free pages the background
+ *                                    grower keeps in a pool
+ *
+ * @array: Address of the first in an array of physical memory pools.
+ * @index: A memory group ID to be used as an index into the array of memory
+ *         pools. Valid range is 0..(MEMORY_GROUP_MANAGER_NR_GROUPS-1).
+ *
+ * Return: Watermark of the pool in pages
+ */
+size_t kbase_mem_pool_debugfs_watermark(void *array, size_t index);
+
 /**
  * kbase_mem_pool_config_debugfs_set_max_size - Set maximum number of free pages
  *                                              in initial configuration of pool
@@ -24,6 +24,14 @@
 #include <mali_kbase_mem_pool_group.h>
 
 #include <linux/memory_group_manager.h>
+#include <linux/kthread.h>
+#include <linux/sched.h>
+
+/* How long the grower leaves a pool alone after reclaim or a failed grow */
+#define KBASE_MEM_POOL_GROWER_BACKOFF msecs_to_jiffies(1000)
+
+/* Number of 4 KiB pages added per pass, 2 MiB pools grow one page per pass */
+#define KBASE_MEM_POOL_GROWER_BATCH ((size_t)32)
 
 void kbase_mem_pool_group_config_set_max_size(struct kbase_mem_pool_group_config *const configs,
 					      size_t const max_size)
@@ -99,3 +107,110 @@ void kbase_mem_pool_group_term(struct kbase_mem_pool_group *const mem_pools)
 		kbase_mem_pool_term(&mem_pools->large[gid]);
 	}
 }
+
+static size_t kbase_mem_pool_grower_deficit(struct kbase_mem_pool *pool, bool *backoff)
+{
+	size_t deficit = 0;
+
+	kbase_mem_pool_lock(pool);
+	if (!pool->dying && kbase_mem_pool_size(pool) < pool->watermark) {
+		if (time_before(jiffies, pool->reclaim_jiffies + KBASE_MEM_POOL_GROWER_BACKOFF))
+			*backoff = true;
+		else
+			deficit = pool->watermark - kbase_mem_pool_size(pool);
+	}
+	kbase_mem_pool_unlock(pool);
+
+	return deficit;
+}
+
+static bool kbase_mem_pool_grower_refill(struct kbase_mem_pool *pool, bool *backoff)
+{
+	size_t nr_to_grow = kbase_mem_pool_grower_deficit(pool, backoff);
+
+	if (!nr_to_grow)
+		return false;
+
+	nr_to_grow = min(nr_to_grow, pool->order ? (size_t)1 : KBASE_MEM_POOL_GROWER_BATCH);
+	if (kbase_mem_pool_grow(pool, nr_to_grow, NULL)) {
+		kbase_mem_pool_lock(pool);
+		pool->reclaim_jiffies = jiffies;
+		kbase_mem_pool_unlock(pool);
+	}
+
+	return true;
+}
+
+static bool kbase_mem_pool_grower_pending(struct kbase_device *kbdev, bool *backoff)
+{
+	bool pending = false;
+	int gid;
+
+	for (gid = 0; gid < MEMORY_GROUP_MANAGER_NR_GROUPS; ++gid) {
+		pending |= !!kbase_mem_pool_grower_deficit(&kbdev->mem_pools.small[gid], backoff);
+		pending |= !!kbase_mem_pool_grower_deficit(&kbdev->mem_pools.large[gid], backoff);
+	}
+
+	return pending;
+}
+
+static int kbase_mem_pool_grower_thread(void *data)
+{
+	struct kbase_device *kbdev = data;
+
+	set_user_nice(current, MAX_NICE);
+
+	while (!kthread_should_stop()) {
+		bool backoff = false;
+		bool grown = false;
+		int gid;
+
+		for (gid = 0; gid < MEMORY_GROUP_MANAGER_NR_GROUPS; ++gid) {
+			grown |= kbase_mem_pool_grower_refill(&kbdev->mem_pools.large[gid],
+							      &backoff);
+			grown |= kbase_mem_pool_grower_refill(&kbdev->mem_pools.small[gid],
+							      &backoff);
+		}
+
+		if (grown) {
+			cond_resched();
+			continue;
+		}
+
+		/* Re-check after setting the state so a wake-up is not lost */
+		set_current_state(TASK_INTERRUPTIBLE);
+		if (!kthread_should_stop() && !kbase_mem_pool_grower_pending(kbdev, &backoff)) {
+			if (backoff)
+				schedule_timeout(KBASE_MEM_POOL_GROWER_BACKOFF);
+			else
+				schedule();
+		}
+		__set_current_state(TASK_RUNNING);
+	}
+
+	return 0;
+}
+
+int kbase_mem_pool_group_grower_init(struct kbase_device *kbdev)
+{
+	struct task_struct *grower;
+
+	grower = kthread_run(kbase_mem_pool_grower_thread, kbdev, "mali_pool_grower");
+	if (IS_ERR(grower))
+		return PTR_ERR(grower);
+
+	WRITE_ONCE(kbdev->mem_pool_grower, grower);
+
+	return 0;
+}
+
+void kbase_mem_pool_group_grower_term(struct kbase_device *kbdev)
+{
+	struct task_struct *grower = kbdev->mem_pool_grower;
+
+	if (!grower)
+		return;
+
+	WRITE_ONCE(kbdev->mem_pool_grower, NULL);
+	kthread_stop(grower);
+}
@@ -111,4 +111,26 @@ void kbase_mem_pool_group_mark_dying(struct kbase_mem_pool_group *mem_pools);
  */
 void kbase_mem_pool_group_term(struct kbase_mem_pool_group *mem_pools);
 
+/**
+ * kbase_mem_pool_group_grower_init - Start the background pool grower
+ *
+ * @kbdev: Kbase device whose global memory pools are to be kept filled
+ *
+ * Starts a low priority kernel thread that refills the global 4 KiB and
+ * 2 MiB pools of every memory group up to their watermarks, so the first
+ * frames of a new application don't pay for page allocation and zeroing.
+ * The grower is woken when an allocation takes a pool below its watermark
+ * and backs off for a while after the shrinker reclaimed from a pool.
+ *
+ * Return: 0 on success, otherwise a negative error code
+ */
+int kbase_mem_pool_group_grower_init(struct kbase_device *kbdev);
+
+/**
+ * kbase_mem_pool_group_grower_term - Stop the background pool grower
+ *
+ * @kbdev: Kbase device passed to kbase_mem_pool_group_grower_init()
+ */
+void kbase_mem_pool_group_grower_term(struct kbase_device *kbdev);
+
 #endif /* _KBASE_MEM_POOL_GROUP_H_ */
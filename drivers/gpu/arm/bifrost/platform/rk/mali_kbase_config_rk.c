@@ -162,12 +162,30 @@ static int kbase_platform_rk_init(struct kbase_device *kbdev)
 	}
 
 	kbdev->platform_context = (void *)platform;
+
+	ret = kbase_platform_rk_dvfs_init(kbdev);
+	if (ret) {
+		E("fail to init dvfs. ret = %d.", ret);
+		goto err_dvfs;
+	}
+
+	ret = kbase_platform_rk_stats_init(kbdev);
+	if (ret) {
+		E("fail to init stats. ret = %d.", ret);
+		goto err_stats;
+	}
+
 	pm_runtime_enable(kbdev->dev);
 
 	mutex_init(&platform->lock);
 
 	return 0;
 
+err_stats:
+	kbase_platform_rk_dvfs_term(kbdev);
+err_dvfs:
+	kbdev->platform_context = NULL;
+	kbase_platform_rk_remove_sysfs_files(kbdev->dev);
 err_sysfs_files:
 	wake_lock_destroy(&platform->wake_lock);
 	destroy_workqueue(platform->power_off_wq);
@@ -181,6 +199,10 @@ static void kbase_platform_rk_term(struct kbase_device *kbdev)
 		(struct rk_context *)kbdev->platform_context;
 
 	pm_runtime_disable(kbdev->dev);
+	if (platform) {
+		kbase_platform_rk_stats_term(kbdev);
+		kbase_platform_rk_dvfs_term(kbdev);
+	}
 	kbdev->platform_context = NULL;
 
 	if (platform) {
@@ -194,9 +216,32 @@ static void kbase_platform_rk_term(struct kbase_device *kbdev)
 	kbase_platform_rk_remove_sysfs_files(kbdev->dev);
 }
 
+#if !MALI_USE_CSF
+static void kbase_platform_rk_atom_submit(struct kbase_jd_atom *katom)
+{
+	kbase_platform_rk_dvfs_atom_submit(katom);
+	kbase_platform_rk_stats_atom_submit(katom);
+}
+
+static void kbase_platform_rk_atom_complete(struct kbase_jd_atom *katom)
+{
+	kbase_platform_rk_dvfs_atom_complete(katom);
+	kbase_platform_rk_stats_atom_complete(katom);
+}
+#endif
+
 struct kbase_platform_funcs_conf platform_funcs = {
 	.platform_init_func = &kbase_platform_rk_init,
 	.platform_term_func = &kbase_platform_rk_term,
+#if !MALI_USE_CSF
+	.platform_handler_context_init_func =
+		&kbase_platform_rk_stats_context_init,
+	.platform_handler_context_term_func =
+		&kbase_platform_rk_stats_context_term,
+	.platform_handler_atom_submit_func = &kbase_platform_rk_atom_submit,
+	.platform_handler_atom_complete_func =
+		&kbase_platform_rk_atom_complete,
+#endif
 };
 
 /*---------------------------------------------------------------------------*/
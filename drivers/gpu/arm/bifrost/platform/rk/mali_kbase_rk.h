@@ -53,6 +53,12 @@ struct rk_context {
 
 	/* to protect operations on 'is_powered' and clks, pd, vd of gpu. */
 	struct mutex lock;
+
+	/* frame paced dvfs, see mali_kbase_rk_dvfs.c. */
+	struct rk_dvfs *dvfs;
+
+	/* per context accounting, see mali_kbase_rk_stats.c. */
+	struct rk_stats *stats;
 };
 
 /*---------------------------------------------------------------------------*/
@@ -63,5 +69,49 @@ static inline struct rk_context *get_rk_context(
 	return (struct rk_context *)(kbdev->platform_context);
 }
 
+/*---------------------------------------------------------------------------*/
+
+#if defined(CONFIG_MALI_BIFROST_DEVFREQ) && !MALI_USE_CSF
+int kbase_platform_rk_dvfs_init(struct kbase_device *kbdev);
+void kbase_platform_rk_dvfs_term(struct kbase_device *kbdev);
+void kbase_platform_rk_dvfs_atom_submit(struct kbase_jd_atom *katom);
+void kbase_platform_rk_dvfs_atom_complete(struct kbase_jd_atom *katom);
+#else
+static inline int kbase_platform_rk_dvfs_init(struct kbase_device *kbdev)
+{
+	return 0;
+}
+
+static inline void kbase_platform_rk_dvfs_term(struct kbase_device *kbdev)
+{
+}
+
+static inline void kbase_platform_rk_dvfs_atom_submit(struct kbase_jd_atom *katom)
+{
+}
+
+static inline void kbase_platform_rk_dvfs_atom_complete(struct kbase_jd_atom *katom)
+{
+}
+#endif
+
+#if !MALI_USE_CSF
+int kbase_platform_rk_stats_init(struct kbase_device *kbdev);
+void kbase_platform_rk_stats_term(struct kbase_device *kbdev);
+int kbase_platform_rk_stats_context_init(struct kbase_context *kctx);
+void kbase_platform_rk_stats_context_term(struct kbase_context *kctx);
+void kbase_platform_rk_stats_atom_submit(struct kbase_jd_atom *katom);
+void kbase_platform_rk_stats_atom_complete(struct kbase_jd_atom *katom);
+#else
+static inline int kbase_platform_rk_stats_init(struct kbase_device *kbdev)
+{
+	return 0;
+}
+
+static inline void kbase_platform_rk_stats_term(struct kbase_device *kbdev)
+{
+}
+#endif
+
 #endif				/* _MALI_KBASE_RK_H_ */
 
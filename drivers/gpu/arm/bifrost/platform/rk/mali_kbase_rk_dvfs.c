@@ -0,0 +1,508 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Copyright (C) Rockchip Electronics Co.Ltd
+ *
+ * Frame paced gpu dvfs.
+ *
+ * Job slot occupancy is sampled at atom submit and completion, the same
+ * points that feed the kinstr_jm hw_submit and hw_release events, and is
+ * evaluated once per display frame. A window that rendered a frame is
+ * scaled so the busy time fits the frame with some headroom, a window that
+ * only ran compute jobs is scaled to a plain utilisation target so long
+ * compute jobs don't push the gpu to its top opp.
+ */
+
+/* #define ENABLE_DEBUG_LOG */
+#include "custom_log.h"
+
+#include <mali_kbase.h>
+#include <mali_kbase_defs.h>
+
+#include <linux/devfreq.h>
+#include <linux/hrtimer.h>
+#include <linux/pm_opp.h>
+#include <linux/workqueue.h>
+#include <soc/rockchip/rockchip_system_monitor.h>
+#include <../drivers/devfreq/governor.h>
+
+#include "mali_kbase_rk.h"
+
+#define CREATE_TRACE_POINTS
+#include "mali_kbase_rk_trace.h"
+
+#if defined(CONFIG_MALI_BIFROST_DEVFREQ) && !MALI_USE_CSF
+
+/* window length when no display is active */
+#define RK_DVFS_POLL_MS			16
+/* idle windows before the window timer stops */
+#define RK_DVFS_IDLE_WINDOWS		8
+/* busy share of a window at which the gpu counts as saturated */
+#define RK_DVFS_SATURATED		95
+
+struct rk_dvfs_stats {
+	u64 window_ns;
+	u64 busy_ns;
+	u64 slot_busy_ns;
+	bool frame;
+};
+
+struct rk_dvfs {
+	struct kbase_device *kbdev;
+
+	/* protects the fields below up to 'stats', taken in irq context */
+	spinlock_t lock;
+	unsigned int active[BASE_JM_MAX_NR_SLOTS];
+	unsigned int nr_active;
+	u64 slot_busy_ns[BASE_JM_MAX_NR_SLOTS];
+	u64 busy_ns;
+	bool frame;
+	ktime_t last_update;
+	ktime_t window_start;
+	unsigned int idle_windows;
+	bool running;
+	bool timer_armed;
+	struct rk_dvfs_stats stats;
+
+	struct hrtimer timer;
+	struct work_struct work;
+
+	/* policy state, under devfreq->lock */
+	unsigned int down_count;
+
+	/* tunables, percent of a window and number of windows */
+	unsigned int frame_target;
+	unsigned int compute_target;
+	unsigned int down_windows;
+};
+
+static struct devfreq_governor rk_mali_frame_governor;
+
+static struct rk_dvfs *rk_dvfs_from_devfreq(struct devfreq *df)
+{
+	struct kbase_device *kbdev = dev_get_drvdata(df->dev.parent);
+	struct rk_context *platform;
+
+	if (!kbdev)
+		return NULL;
+	platform = get_rk_context(kbdev);
+
+	return platform ? platform->dvfs : NULL;
+}
+
+/* must hold dvfs->lock */
+static void rk_dvfs_account(struct rk_dvfs *dvfs, ktime_t now)
+{
+	u64 delta = ktime_to_ns(ktime_sub(now, dvfs->last_update));
+	int js;
+
+	if (dvfs->nr_active) {
+		dvfs->busy_ns += delta;
+		for (js = 0; js < BASE_JM_MAX_NR_SLOTS; js++)
+			if (dvfs->active[js])
+				dvfs->slot_busy_ns[js] += delta;
+	}
+	dvfs->last_update = now;
+}
+
+/* must hold dvfs->lock */
+static void rk_dvfs_arm_timer(struct rk_dvfs *dvfs, ktime_t now)
+{
+	ktime_t vsync, expires;
+	u32 period;
+
+	if (rockchip_system_monitor_get_vsync(&vsync, &period)) {
+		/* end the window on the next vblank */
+		expires = ktime_add_ns(vsync, period);
+		while (!ktime_after(expires, now))
+			expires = ktime_add_ns(expires, period);
+	} else {
+		expires = ktime_add_ms(now, RK_DVFS_POLL_MS);
+	}
+
+	hrtimer_start(&dvfs->timer, expires, HRTIMER_MODE_ABS);
+	dvfs->timer_armed = true;
+}
+
+static enum hrtimer_restart rk_dvfs_timer_func(struct hrtimer *timer)
+{
+	struct rk_dvfs *dvfs = container_of(timer, struct rk_dvfs, timer);
+	ktime_t now = ktime_get();
+	unsigned long flags;
+	u64 slot_busy_ns = 0;
+	int js;
+
+	spin_lock_irqsave(&dvfs->lock, flags);
+	rk_dvfs_account(dvfs, now);
+
+	for (js = 0; js < BASE_JM_MAX_NR_SLOTS; js++) {
+		slot_busy_ns = max(slot_busy_ns, dvfs->slot_busy_ns[js]);
+		dvfs->slot_busy_ns[js] = 0;
+	}
+	dvfs->stats.window_ns = ktime_to_ns(ktime_sub(now, dvfs->window_start));
+	dvfs->stats.busy_ns = dvfs->busy_ns;
+	dvfs->stats.slot_busy_ns = slot_busy_ns;
+	dvfs->stats.frame = dvfs->frame;
+
+	if (dvfs->busy_ns || dvfs->nr_active)
+		dvfs->idle_windows = 0;
+	else
+		dvfs->idle_windows++;
+
+	dvfs->busy_ns = 0;
+	dvfs->frame = false;
+	dvfs->window_start = now;
+
+	dvfs->timer_armed = false;
+	if (dvfs->running && dvfs->idle_windows < RK_DVFS_IDLE_WINDOWS)
+		rk_dvfs_arm_timer(dvfs, now);
+	spin_unlock_irqrestore(&dvfs->lock, flags);
+
+	queue_work(system_highpri_wq, &dvfs->work);
+
+	return HRTIMER_NORESTART;
+}
+
+static void rk_dvfs_work(struct work_struct *work)
+{
+	struct rk_dvfs *dvfs = container_of(work, struct rk_dvfs, work);
+	struct devfreq *devfreq = dvfs->kbdev->devfreq;
+
+	if (!devfreq)
+		return;
+
+	mutex_lock(&devfreq->lock);
+	if (devfreq->governor == &rk_mali_frame_governor)
+		update_devfreq(devfreq);
+	mutex_unlock(&devfreq->lock);
+}
+
+void kbase_platform_rk_dvfs_atom_submit(struct kbase_jd_atom *katom)
+{
+	struct rk_context *platform = get_rk_context(katom->kctx->kbdev);
+	struct rk_dvfs *dvfs = platform ? platform->dvfs : NULL;
+	unsigned int js = katom->slot_nr;
+	ktime_t now;
+
+	if (!dvfs || js >= BASE_JM_MAX_NR_SLOTS)
+		return;
+
+	now = ktime_get();
+	spin_lock(&dvfs->lock);
+	rk_dvfs_account(dvfs, now);
+	dvfs->active[js]++;
+	dvfs->nr_active++;
+	if (katom->core_req & BASE_JD_REQ_FS)
+		dvfs->frame = true;
+	dvfs->idle_windows = 0;
+	if (dvfs->running && !dvfs->timer_armed) {
+		dvfs->window_start = now;
+		rk_dvfs_arm_timer(dvfs, now);
+	}
+	spin_unlock(&dvfs->lock);
+}
+
+void kbase_platform_rk_dvfs_atom_complete(struct kbase_jd_atom *katom)
+{
+	struct rk_context *platform = get_rk_context(katom->kctx->kbdev);
+	struct rk_dvfs *dvfs = platform ? platform->dvfs : NULL;
+	unsigned int js = katom->slot_nr;
+
+	if (!dvfs || js >= BASE_JM_MAX_NR_SLOTS)
+		return;
+
+	spin_lock(&dvfs->lock);
+	if (dvfs->active[js]) {
+		rk_dvfs_account(dvfs, ktime_get());
+		dvfs->active[js]--;
+		dvfs->nr_active--;
+	}
+	spin_unlock(&dvfs->lock);
+}
+
+static int rk_mali_frame_func(struct devfreq *df, unsigned long *freq)
+{
+	struct rk_dvfs *dvfs = rk_dvfs_from_devfreq(df);
+	struct rk_dvfs_stats stats;
+	struct dev_pm_opp *opp;
+	unsigned long cur = df->previous_freq;
+	unsigned long rate;
+	unsigned int target;
+	unsigned long flags;
+	u64 period;
+
+	if (!dvfs) {
+		*freq = cur;
+		return 0;
+	}
+
+	spin_lock_irqsave(&dvfs->lock, flags);
+	stats = dvfs->stats;
+	spin_unlock_irqrestore(&dvfs->lock, flags);
+
+	if (!stats.window_ns || !stats.busy_ns) {
+		rate = 0;
+		goto down;
+	}
+
+	target = stats.frame ? dvfs->frame_target : dvfs->compute_target;
+	period = div_u64(stats.window_ns * target, 100);
+	rate = div64_u64((u64)cur * stats.busy_ns, period);
+
+	/*
+	 * a frame that kept the gpu busy for the whole window may need a lot
+	 * more than the busy time shows, catch up quickly.
+	 */
+	if (stats.frame &&
+	    stats.busy_ns * 100 >= stats.window_ns * RK_DVFS_SATURATED)
+		rate = max(rate, cur + cur / 2);
+
+	if (rate >= cur) {
+		dvfs->down_count = 0;
+		goto out;
+	}
+
+down:
+	if (++dvfs->down_count < dvfs->down_windows) {
+		rate = cur;
+		goto out;
+	}
+	dvfs->down_count = 0;
+
+out:
+	/* round up here, devfreq rounds down when lowering the rate */
+	opp = dev_pm_opp_find_freq_ceil(df->dev.parent, &rate);
+	if (IS_ERR(opp))
+		rate = ULONG_MAX;
+	else
+		dev_pm_opp_put(opp);
+
+	trace_mali_rk_dvfs_decision(stats.window_ns, stats.busy_ns,
+				    stats.slot_busy_ns, stats.frame, cur, rate);
+	D("window=%llu busy=%llu frame=%d cur=%lu target=%lu",
+	  stats.window_ns, stats.busy_ns, stats.frame, cur, rate);
+
+	*freq = rate;
+
+	return 0;
+}
+
+static void rk_dvfs_start(struct rk_dvfs *dvfs)
+{
+	unsigned long flags;
+	ktime_t now = ktime_get();
+
+	spin_lock_irqsave(&dvfs->lock, flags);
+	dvfs->running = true;
+	dvfs->idle_windows = 0;
+	dvfs->busy_ns = 0;
+	memset(dvfs->slot_busy_ns, 0, sizeof(dvfs->slot_busy_ns));
+	dvfs->last_update = now;
+	dvfs->window_start = now;
+	if (!dvfs->timer_armed)
+		rk_dvfs_arm_timer(dvfs, now);
+	spin_unlock_irqrestore(&dvfs->lock, flags);
+}
+
+static void rk_dvfs_stop(struct rk_dvfs *dvfs)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&dvfs->lock, flags);
+	dvfs->running = false;
+	spin_unlock_irqrestore(&dvfs->lock, flags);
+
+	hrtimer_cancel(&dvfs->timer);
+	cancel_work_sync(&dvfs->work);
+	dvfs->timer_armed = false;
+}
+
+static int rk_mali_frame_handler(struct devfreq *devfreq,
+				 unsigned int event, void *data)
+{
+	struct rk_dvfs *dvfs = rk_dvfs_from_devfreq(devfreq);
+
+	if (!dvfs)
+		return 0;
+
+	switch (event) {
+	case DEVFREQ_GOV_START:
+	case DEVFREQ_GOV_RESUME:
+		dvfs->down_count = 0;
+		rk_dvfs_start(dvfs);
+		break;
+	case DEVFREQ_GOV_STOP:
+	case DEVFREQ_GOV_SUSPEND:
+		rk_dvfs_stop(dvfs);
+		break;
+	default:
+		break;
+	}
+
+	return 0;
+}
+
+static struct devfreq_governor rk_mali_frame_governor = {
+	.name = "rk_mali_frame",
+	.get_target_freq = rk_mali_frame_func,
+	.event_handler = rk_mali_frame_handler,
+};
+
+static ssize_t dvfs_frame_target_show(struct device *dev,
+				      struct device_attribute *attr, char *buf)
+{
+	struct kbase_device *kbdev = dev_get_drvdata(dev);
+	struct rk_dvfs *dvfs = get_rk_context(kbdev)->dvfs;
+
+	return sprintf(buf, "%u\n", dvfs->frame_target);
+}
+
+static ssize_t dvfs_frame_target_store(struct device *dev,
+				       struct device_attribute *attr,
+				       const char *buf, size_t count)
+{
+	struct kbase_device *kbdev = dev_get_drvdata(dev);
+	struct rk_dvfs *dvfs = get_rk_context(kbdev)->dvfs;
+	unsigned int val;
+	int ret;
+
+	ret = kstrtouint(buf, 0, &val);
+	if (ret)
+		return ret;
+	if (!val || val > 100)
+		return -EINVAL;
+	dvfs->frame_target = val;
+
+	return count;
+}
+
+static ssize_t dvfs_compute_target_show(struct device *dev,
+					struct device_attribute *attr,
+					char *buf)
+{
+	struct kbase_device *kbdev = dev_get_drvdata(dev);
+	struct rk_dvfs *dvfs = get_rk_context(kbdev)->dvfs;
+
+	return sprintf(buf, "%u\n", dvfs->compute_target);
+}
+
+static ssize_t dvfs_compute_target_store(struct device *dev,
+					 struct device_attribute *attr,
+					 const char *buf, size_t count)
+{
+	struct kbase_device *kbdev = dev_get_drvdata(dev);
+	struct rk_dvfs *dvfs = get_rk_context(kbdev)->dvfs;
+	unsigned int val;
+	int ret;
+
+	ret = kstrtouint(buf, 0, &val);
+	if (ret)
+		return ret;
+	if (!val || val > 100)
+		return -EINVAL;
+	dvfs->compute_target = val;
+
+	return count;
+}
+
+static ssize_t dvfs_down_windows_show(struct device *dev,
+				      struct device_attribute *attr, char *buf)
+{
+	struct kbase_device *kbdev = dev_get_drvdata(dev);
+	struct rk_dvfs *dvfs = get_rk_context(kbdev)->dvfs;
+
+	return sprintf(buf, "%u\n", dvfs->down_windows);
+}
+
+static ssize_t dvfs_down_windows_store(struct device *dev,
+				       struct device_attribute *attr,
+				       const char *buf, size_t count)
+{
+	struct kbase_device *kbdev = dev_get_drvdata(dev);
+	struct rk_dvfs *dvfs = get_rk_context(kbdev)->dvfs;
+	unsigned int val;
+	int ret;
+
+	ret = kstrtouint(buf, 0, &val);
+	if (ret)
+		return ret;
+	if (!val)
+		return -EINVAL;
+	dvfs->down_windows = val;
+
+	return count;
+}
+
+static DEVICE_ATTR_RW(dvfs_frame_target);
+static DEVICE_ATTR_RW(dvfs_compute_target);
+static DEVICE_ATTR_RW(dvfs_down_windows);
+
+static struct attribute *rk_dvfs_attrs[] = {
+	&dev_attr_dvfs_frame_target.attr,
+	&dev_attr_dvfs_compute_target.attr,
+	&dev_attr_dvfs_down_windows.attr,
+	NULL,
+};
+
+static const struct attribute_group rk_dvfs_group = {
+	.attrs = rk_dvfs_attrs,
+};
+
+int kbase_platform_rk_dvfs_init(struct kbase_device *kbdev)
+{
+	struct rk_context *platform = get_rk_context(kbdev);
+	struct rk_dvfs *dvfs;
+	int ret;
+
+	dvfs = kzalloc(sizeof(*dvfs), GFP_KERNEL);
+	if (!dvfs)
+		return -ENOMEM;
+
+	dvfs->kbdev = kbdev;
+	spin_lock_init(&dvfs->lock);
+	hrtimer_init(&dvfs->timer, CLOCK_MONOTONIC, HRTIMER_MODE_ABS);
+	dvfs->timer.function = rk_dvfs_timer_func;
+	INIT_WORK(&dvfs->work, rk_dvfs_work);
+	dvfs->frame_target = 85;
+	dvfs->compute_target = 90;
+	dvfs->down_windows = 3;
+
+	ret = sysfs_create_group(&kbdev->dev->kobj, &rk_dvfs_group);
+	if (ret) {
+		E("fail to create dvfs sysfs files. ret = %d.", ret);
+		goto err_free;
+	}
+
+	platform->dvfs = dvfs;
+
+	ret = devfreq_add_governor(&rk_mali_frame_governor);
+	if (ret) {
+		E("fail to add rk_mali_frame governor. ret = %d.", ret);
+		goto err_sysfs;
+	}
+
+	return 0;
+
+err_sysfs:
+	platform->dvfs = NULL;
+	sysfs_remove_group(&kbdev->dev->kobj, &rk_dvfs_group);
+err_free:
+	kfree(dvfs);
+	return ret;
+}
+
+void kbase_platform_rk_dvfs_term(struct kbase_device *kbdev)
+{
+	struct rk_context *platform = get_rk_context(kbdev);
+	struct rk_dvfs *dvfs = platform->dvfs;
+
+	if (!dvfs)
+		return;
+
+	devfreq_remove_governor(&rk_mali_frame_governor);
+	rk_dvfs_stop(dvfs);
+	sysfs_remove_group(&kbdev->dev->kobj, &rk_dvfs_group);
+	platform->dvfs = NULL;
+	kfree(dvfs);
+}
+
+#endif
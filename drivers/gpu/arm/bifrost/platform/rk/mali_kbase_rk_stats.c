@@ -0,0 +1,230 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Copyright (C) Rockchip Electronics Co.Ltd
+ *
+ * Per context gpu accounting.
+ *
+ * GPU active time and job count are sampled at atom submit and completion,
+ * memory is read from the context's page counters and pools at read time.
+ * The result is exported as one line per context in /proc/rk_mali/ctx_stats
+ * so a userspace daemon can throttle per uid without enabling tracing.
+ */
+
+/* #define ENABLE_DEBUG_LOG */
+#include "custom_log.h"
+
+#include <mali_kbase.h>
+#include <mali_kbase_defs.h>
+
+#include <linux/cred.h>
+#include <linux/proc_fs.h>
+#include <linux/seq_file.h>
+#include <linux/slab.h>
+
+#include "mali_kbase_rk.h"
+
+#if !MALI_USE_CSF
+
+#define RK_STATS_PROC_DIR	"rk_mali"
+
+struct rk_ctx_stats {
+	struct kbase_context *kctx;
+	struct list_head link;
+	uid_t uid;
+
+	/* protects the fields below, taken in irq context */
+	spinlock_t lock;
+	unsigned int nr_active;
+	ktime_t active_start;
+	u64 active_ns;
+	u64 nr_jobs;
+};
+
+struct rk_stats {
+	struct kbase_device *kbdev;
+	struct proc_dir_entry *proc_dir;
+
+	/* protects 'ctx_list' */
+	struct mutex list_lock;
+	struct list_head ctx_list;
+};
+
+static struct rk_stats *rk_stats_from_kbdev(struct kbase_device *kbdev)
+{
+	struct rk_context *platform = get_rk_context(kbdev);
+
+	return platform ? platform->stats : NULL;
+}
+
+int kbase_platform_rk_stats_context_init(struct kbase_context *kctx)
+{
+	struct rk_stats *stats = rk_stats_from_kbdev(kctx->kbdev);
+	struct rk_ctx_stats *cs;
+
+	if (!stats)
+		return 0;
+
+	cs = kzalloc(sizeof(*cs), GFP_KERNEL);
+	if (!cs)
+		return -ENOMEM;
+
+	cs->kctx = kctx;
+	cs->uid = from_kuid(&init_user_ns, current_uid());
+	spin_lock_init(&cs->lock);
+
+	mutex_lock(&stats->list_lock);
+	list_add_tail(&cs->link, &stats->ctx_list);
+	mutex_unlock(&stats->list_lock);
+
+	kctx->platform_data = cs;
+
+	return 0;
+}
+
+void kbase_platform_rk_stats_context_term(struct kbase_context *kctx)
+{
+	struct rk_stats *stats = rk_stats_from_kbdev(kctx->kbdev);
+	struct rk_ctx_stats *cs = kctx->platform_data;
+
+	if (!stats || !cs)
+		return;
+
+	mutex_lock(&stats->list_lock);
+	list_del(&cs->link);
+	mutex_unlock(&stats->list_lock);
+
+	kctx->platform_data = NULL;
+	kfree(cs);
+}
+
+/* Called with hwaccess_lock held, possibly from irq context. */
+void kbase_platform_rk_stats_atom_submit(struct kbase_jd_atom *katom)
+{
+	struct rk_ctx_stats *cs = katom->kctx->platform_data;
+
+	if (!cs)
+		return;
+
+	spin_lock(&cs->lock);
+	if (!cs->nr_active++)
+		cs->active_start = ktime_get();
+	cs->nr_jobs++;
+	spin_unlock(&cs->lock);
+}
+
+/* Called with hwaccess_lock held, possibly from irq context. */
+void kbase_platform_rk_stats_atom_complete(struct kbase_jd_atom *katom)
+{
+	struct rk_ctx_stats *cs = katom->kctx->platform_data;
+
+	if (!cs)
+		return;
+
+	spin_lock(&cs->lock);
+	if (cs->nr_active && !--cs->nr_active)
+		cs->active_ns += ktime_to_ns(ktime_sub(ktime_get(),
+						       cs->active_start));
+	spin_unlock(&cs->lock);
+}
+
+static u64 rk_ctx_stats_active_ns(struct rk_ctx_stats *cs)
+{
+	unsigned long flags;
+	u64 active_ns;
+
+	spin_lock_irqsave(&cs->lock, flags);
+	active_ns = cs->active_ns;
+	/* count the atoms still running up to now */
+	if (cs->nr_active)
+		active_ns += ktime_to_ns(ktime_sub(ktime_get(),
+						   cs->active_start));
+	spin_unlock_irqrestore(&cs->lock, flags);
+
+	return active_ns;
+}
+
+static size_t rk_ctx_pool_pages(struct kbase_mem_pool *pools)
+{
+	size_t pages = 0;
+	int gid;
+
+	for (gid = 0; gid < MEMORY_GROUP_MANAGER_NR_GROUPS; gid++)
+		pages += kbase_mem_pool_size(&pools[gid]);
+
+	return pages;
+}
+
+static int rk_stats_ctx_stats_show(struct seq_file *sfile, void *data)
+{
+	struct rk_stats *stats = sfile->private;
+	struct rk_ctx_stats *cs;
+
+	seq_puts(sfile, "tgid pid uid ctx active_ns jobs used_pages pool_pages lp_pool_pages page_faults comm\n");
+
+	mutex_lock(&stats->list_lock);
+	list_for_each_entry(cs, &stats->ctx_list, link) {
+		struct kbase_context *kctx = cs->kctx;
+		u64 nr_jobs;
+		unsigned long flags;
+
+		spin_lock_irqsave(&cs->lock, flags);
+		nr_jobs = cs->nr_jobs;
+		spin_unlock_irqrestore(&cs->lock, flags);
+
+		seq_printf(sfile, "%d %d %u %u %llu %llu %d %zu %zu %d %s\n",
+			   kctx->tgid, kctx->pid, cs->uid, kctx->id,
+			   rk_ctx_stats_active_ns(cs), nr_jobs,
+			   atomic_read(&kctx->used_pages),
+			   rk_ctx_pool_pages(kctx->mem_pools.small),
+			   rk_ctx_pool_pages(kctx->mem_pools.large) <<
+				   KBASE_MEM_POOL_2MB_PAGE_TABLE_ORDER,
+			   atomic_read(&kctx->page_faults), kctx->comm);
+	}
+	mutex_unlock(&stats->list_lock);
+
+	return 0;
+}
+
+int kbase_platform_rk_stats_init(struct kbase_device *kbdev)
+{
+	struct rk_context *platform = get_rk_context(kbdev);
+	struct rk_stats *stats;
+
+	stats = kzalloc(sizeof(*stats), GFP_KERNEL);
+	if (!stats)
+		return -ENOMEM;
+
+	stats->kbdev = kbdev;
+	mutex_init(&stats->list_lock);
+	INIT_LIST_HEAD(&stats->ctx_list);
+
+	stats->proc_dir = proc_mkdir(RK_STATS_PROC_DIR, NULL);
+	if (!stats->proc_dir ||
+	    !proc_create_single_data("ctx_stats", 0444, stats->proc_dir,
+				     rk_stats_ctx_stats_show, stats)) {
+		E("fail to create /proc/%s.", RK_STATS_PROC_DIR);
+		proc_remove(stats->proc_dir);
+		kfree(stats);
+		return -ENOMEM;
+	}
+
+	platform->stats = stats;
+
+	return 0;
+}
+
+void kbase_platform_rk_stats_term(struct kbase_device *kbdev)
+{
+	struct rk_context *platform = get_rk_context(kbdev);
+	struct rk_stats *stats = platform->stats;
+
+	if (!stats)
+		return;
+
+	proc_remove(stats->proc_dir);
+	platform->stats = NULL;
+	WARN_ON(!list_empty(&stats->ctx_list));
+	kfree(stats);
+}
+
+#endif /* !MALI_USE_CSF */
@@ -0,0 +1,50 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/*
+ * Copyright (C) Rockchip Electronics Co.Ltd
+ */
+
+#if !defined(_MALI_KBASE_RK_TRACE_H_) || defined(TRACE_HEADER_MULTI_READ)
+#define _MALI_KBASE_RK_TRACE_H_
+
+#include <linux/types.h>
+#include <linux/tracepoint.h>
+
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM mali_rk
+#define TRACE_INCLUDE_FILE mali_kbase_rk_trace
+
+TRACE_EVENT(mali_rk_dvfs_decision,
+	TP_PROTO(u64 window_ns, u64 busy_ns, u64 slot_busy_ns, bool frame,
+		 unsigned long cur_freq, unsigned long target_freq),
+	TP_ARGS(window_ns, busy_ns, slot_busy_ns, frame, cur_freq,
+		target_freq),
+
+	TP_STRUCT__entry(
+		__field(u64, window_ns)
+		__field(u64, busy_ns)
+		__field(u64, slot_busy_ns)
+		__field(bool, frame)
+		__field(unsigned long, cur_freq)
+		__field(unsigned long, target_freq)
+	),
+
+	TP_fast_assign(
+		__entry->window_ns = window_ns;
+		__entry->busy_ns = busy_ns;
+		__entry->slot_busy_ns = slot_busy_ns;
+		__entry->frame = frame;
+		__entry->cur_freq = cur_freq;
+		__entry->target_freq = target_freq;
+	),
+
+	TP_printk("window_ns=%llu busy_ns=%llu slot_busy_ns=%llu frame=%d cur_freq=%lu target_freq=%lu",
+		  __entry->window_ns, __entry->busy_ns, __entry->slot_busy_ns,
+		  __entry->frame, __entry->cur_freq, __entry->target_freq)
+);
+
+#endif /* _MALI_KBASE_RK_TRACE_H_ */
+
+/* This part must be outside protection */
+#undef TRACE_INCLUDE_PATH
+#define TRACE_INCLUDE_PATH .
+#include <trace/define_trace.h>
@@ -284,6 +284,13 @@ struct dw_hdmi {
 	bool sink_is_hdmi;
 	bool sink_has_audio;
 	bool hpd_state;
+	/* bumped on every hpd edge and on resume, the sink may have changed */
+	atomic_t hpd_gen;
+	/* last edid read from the sink, valid while edid_hpd_gen == hpd_gen */
+	struct edid *cached_edid;
+	unsigned int edid_hpd_gen;
+	/* time of the last plug in, cleared once the output is up */
+	ktime_t hpd_plug_time;
 	bool support_hdmi;
 	bool force_logo;		/* force uboot hdmi output specific resolution */
 	bool force_kernel_output;	/* force kernel hdmi output specific resolution */
@@ -454,10 +461,12 @@ static bool check_hdmi_irq(struct dw_hdmi *hdmi, int intr_stat,
 	if (!(intr_stat & HDMI_IH_PHY_STAT0_HPD))
 		return false;
 
+	atomic_inc(&hdmi->hpd_gen);
 	if (phy_int_pol & HDMI_PHY_HPD) {
 		dev_dbg(hdmi->dev, "dw hdmi plug in\n");
 		msecs = 150;
 		hdmi->hpd_state = true;
+		hdmi->hpd_plug_time = ktime_get();
 	} else {
 		dev_dbg(hdmi->dev, "dw hdmi plug out\n");
 		msecs = 20;
@@ -3137,12 +3146,26 @@ static enum drm_connector_status dw_hdmi_detect(struct dw_hdmi *hdmi)
 static struct edid *dw_hdmi_get_edid(struct dw_hdmi *hdmi,
 				     struct drm_connector *connector)
 {
+	unsigned int gen = atomic_read(&hdmi->hpd_gen);
 	struct edid *edid;
 
 	if (!hdmi->ddc)
 		return NULL;
 
-	edid = drm_get_edid(connector, hdmi->ddc);
+	/*
+	 * get_modes runs on every userspace probe, each ddc read of the edid
+	 * takes tens of ms. Reuse the last one until an hpd edge shows the
+	 * sink may have changed.
+	 */
+	if (hdmi->cached_edid && hdmi->edid_hpd_gen == gen &&
+	    !connector->override_edid) {
+		edid = drm_edid_duplicate(hdmi->cached_edid);
+	} else {
+		edid = drm_get_edid(connector, hdmi->ddc);
+		kfree(hdmi->cached_edid);
+		hdmi->cached_edid = edid ? drm_edid_duplicate(edid) : NULL;
+		hdmi->edid_hpd_gen = gen;
+	}
 	if (!edid) {
 		dev_dbg(hdmi->dev, "failed to get edid\n");
 		return NULL;
@@ -4162,6 +4185,11 @@ static void dw_hdmi_bridge_atomic_enable(struct drm_bridge *bridge,
 	dw_hdmi_update_power(hdmi);
 	dw_hdmi_update_phy_mask(hdmi);
 	handle_plugged_change(hdmi, true);
+	if (hdmi->hpd_plug_time) {
+		dev_info(hdmi->dev, "output enabled %lld ms after plug in\n",
+			 ktime_ms_delta(ktime_get(), hdmi->hpd_plug_time));
+		hdmi->hpd_plug_time = 0;
+	}
 	mutex_unlock(&hdmi->mutex);
 }
 
@@ -5339,6 +5367,9 @@ void dw_hdmi_remove(struct dw_hdmi *hdmi)
 		i2c_del_adapter(&hdmi->i2c->adap);
 	else
 		i2c_put_adapter(hdmi->ddc);
+
+	kfree(hdmi->cached_edid);
+	hdmi->cached_edid = NULL;
 }
 EXPORT_SYMBOL_GPL(dw_hdmi_remove);
 
@@ -5433,6 +5464,9 @@ void dw_hdmi_resume(struct dw_hdmi *hdmi)
 	if (!hdmi)
 		return;
 
+	/* no hpd irq while suspended, the sink may have been swapped */
+	atomic_inc(&hdmi->hpd_gen);
+
 	pinctrl_pm_select_default_state(hdmi->dev);
 	mutex_lock(&hdmi->mutex);
 	dw_hdmi_reg_initial(hdmi);
@@ -56,6 +56,9 @@
 #define EBC_WIN_MST2			0x0058 //Framecount memory start
 #define EBC_LUT_DATA_ADDR	0x1000 //lut data address
 
+/* 256 frames of 16 words or 64 frames of 64 words */
+#define EBC_LUT_MAX_WORDS	4096
+
 #define DSP_HTOTAL(x)			UPDATE(x, 27, 16)
 #define DSP_HS_END(x)			UPDATE(x, 7, 0)
 #define DSP_HACT_END(x)		UPDATE(x, 26, 16)
@@ -166,6 +169,8 @@ static int tcon_enable(struct ebc_tcon *tcon, struct ebc_panel *panel)
 	clk_prepare_enable(tcon->hclk);
 	clk_prepare_enable(tcon->dclk);
 	pm_runtime_get_sync(tcon->dev);
+	/* the lut ram may have lost its content while powered off */
+	tcon->lut_size = 0;
 
 	/* panel timing and win info config */
 	tcon_write(tcon, EBC_DSP_HTIMING0,
@@ -254,7 +259,6 @@ static void tcon_frame_addr_set(struct ebc_tcon *tcon, u32 frame_addr)
 
 static int tcon_lut_data_set(struct ebc_tcon *tcon, unsigned int *lut_data, int frame_count, int lut_32)
 {
-	int i;
 	int lut_size;
 
 	if ((!lut_32 && frame_count > 256) || (lut_32 && frame_count > 64)) {
@@ -267,9 +271,17 @@ static int tcon_lut_data_set(struct ebc_tcon *tcon, unsigned int *lut_data, int
 	else
 		lut_size = frame_count * 16;
 
-	for (i = 0; i < lut_size; i++) {
-		tcon_write(tcon, EBC_LUT_DATA_ADDR + (i * 4), lut_data[i]);
-	}
+	/*
+	 * Consecutive partial refreshes mostly reuse the same waveform, skip
+	 * the few thousand register writes when the hardware already has it.
+	 */
+	if (lut_size == tcon->lut_size &&
+	    !memcmp(tcon->lut_cache, lut_data, lut_size * sizeof(u32)))
+		return 0;
+
+	regmap_bulk_write(tcon->regmap_base, EBC_LUT_DATA_ADDR, lut_data, lut_size);
+	memcpy(tcon->lut_cache, lut_data, lut_size * sizeof(u32));
+	tcon->lut_size = lut_size;
 	tcon_cfg_done(tcon);
 
 	return 0;
@@ -345,6 +357,10 @@ static int ebc_tcon_probe(struct platform_device *pdev)
 	if (IS_ERR(tcon->regmap_base))
 		return PTR_ERR(tcon->regmap_base);
 
+	tcon->lut_cache = devm_kcalloc(dev, EBC_LUT_MAX_WORDS, sizeof(u32), GFP_KERNEL);
+	if (!tcon->lut_cache)
+		return -ENOMEM;
+
 	tcon->hclk = devm_clk_get(dev, "hclk");
 	if (IS_ERR(tcon->hclk)) {
 		ret = PTR_ERR(tcon->hclk);
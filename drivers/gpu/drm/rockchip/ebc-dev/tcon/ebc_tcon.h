@@ -39,6 +39,10 @@ struct ebc_tcon {
 	void (*frame_start)(struct ebc_tcon *tcon, int frame_total);
 
 	void (*dsp_end_callback)(void);
+
+	/* copy of the lut last written to the hardware, lut_size 0 if none */
+	u32 *lut_cache;
+	int lut_size;
 };
 
 static inline int ebc_tcon_enable(struct ebc_tcon *tcon, struct ebc_panel *panel)
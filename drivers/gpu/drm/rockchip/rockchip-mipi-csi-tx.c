@@ -301,8 +301,8 @@ static void rockchip_mipi_csi_irq_init(struct rockchip_mipi_csi *csi)
 	/* enable csi err irq */
 	writel(m_ERR_INTR_EN | m_ERR_INTR_MASK, csi->regs + CSITX_ERR_INTR_EN);
 
-	/* disable csi frame end tx irq */
-	writel(m_FRM_END_TX | v_FRM_END_TX(0), csi->regs + CSITX_INTR_EN);
+	/* frame end tx irq, for the frame pacing statistics */
+	writel(m_FRM_END_TX | v_FRM_END_TX(1), csi->regs + CSITX_INTR_EN);
 }
 
 static void rockchip_mipi_csi_irq_disable(struct rockchip_mipi_csi *csi)
@@ -345,6 +345,10 @@ static void rockchip_mipi_csi_host_power_on(struct rockchip_mipi_csi *csi)
 	u32 mask, val;
 
 	rockchip_mipi_csi_tx_en(csi);
+
+	spin_lock_irq(&csi->stats_lock);
+	memset(&csi->stats, 0, sizeof(csi->stats));
+	spin_unlock_irq(&csi->stats_lock);
 	rockchip_mipi_csi_irq_init(csi);
 
 	mask = m_CONFIG_DONE | m_CONFIG_DONE_IMD | m_CONFIG_DONE_MODE;
@@ -1174,6 +1178,63 @@ static const struct component_ops rockchip_mipi_csi_ops = {
 	.unbind	= rockchip_mipi_csi_unbind,
 };
 
+static void rockchip_mipi_csi_account(struct rockchip_mipi_csi *csi,
+				      bool frame_end, bool error)
+{
+	struct rockchip_mipi_csi_frame_stats *stats = &csi->stats;
+	ktime_t now = ktime_get();
+	u32 us;
+
+	spin_lock(&csi->stats_lock);
+	if (error)
+		stats->errors++;
+	if (!frame_end)
+		goto out;
+	if (stats->frames) {
+		us = ktime_us_delta(now, stats->last);
+		stats->last_us = us;
+		stats->sum_us += us;
+		if (!stats->min_us || us < stats->min_us)
+			stats->min_us = us;
+		if (us > stats->max_us)
+			stats->max_us = us;
+	}
+	stats->last = now;
+	stats->frames++;
+out:
+	spin_unlock(&csi->stats_lock);
+}
+
+static ssize_t frame_stats_show(struct device *dev,
+				struct device_attribute *attr, char *buf)
+{
+	struct rockchip_mipi_csi *csi = dev_get_drvdata(dev);
+	struct rockchip_mipi_csi_frame_stats stats;
+	u64 avg_us = 0;
+
+	spin_lock_irq(&csi->stats_lock);
+	stats = csi->stats;
+	spin_unlock_irq(&csi->stats_lock);
+
+	if (stats.frames > 1)
+		avg_us = div64_u64(stats.sum_us, stats.frames - 1);
+
+	return sysfs_emit(buf,
+			  "frames: %llu\nerrors: %llu\ninterval_us: last %u min %u max %u avg %llu\n",
+			  stats.frames, stats.errors, stats.last_us,
+			  stats.min_us, stats.max_us, avg_us);
+}
+static DEVICE_ATTR_RO(frame_stats);
+
+static struct attribute *rockchip_mipi_csi_attrs[] = {
+	&dev_attr_frame_stats.attr,
+	NULL,
+};
+
+static const struct attribute_group rockchip_mipi_csi_attr_group = {
+	.attrs = rockchip_mipi_csi_attrs,
+};
+
 static irqreturn_t rockchip_mipi_csi_irq_handler(int irq, void *data)
 {
 	struct rockchip_mipi_csi *csi = data;
@@ -1183,6 +1244,11 @@ static irqreturn_t rockchip_mipi_csi_irq_handler(int irq, void *data)
 	int_status = csi_readl(csi, CSITX_INTR_STATUS);
 	err_int_status = csi_readl(csi, CSITX_ERR_INTR_STATUS);
 
+	if (int_status & v_FRM_END_TX(1) || err_int_status)
+		rockchip_mipi_csi_account(csi, int_status & v_FRM_END_TX(1),
+					  err_int_status);
+	int_status &= ~v_FRM_END_TX(1);
+
 	for (i = 0; i < ARRAY_SIZE(csi_tx_intr); i++)
 		if (int_status & BIT(i))
 			DRM_DEV_ERROR_RATELIMITED(csi->dev, "%s\n",
@@ -1192,7 +1258,8 @@ static irqreturn_t rockchip_mipi_csi_irq_handler(int irq, void *data)
 		if (err_int_status & BIT(i))
 			DRM_DEV_ERROR_RATELIMITED(csi->dev, "%s\n",
 						  csi_tx_err_intr[i]);
-	writel(int_status | m_INTR_MASK, csi->regs + CSITX_INTR_CLR);
+	writel(int_status | v_FRM_END_TX(1) | m_INTR_MASK,
+	       csi->regs + CSITX_INTR_CLR);
 	writel(err_int_status | m_ERR_INTR_MASK,
 	       csi->regs + CSITX_ERR_INTR_CLR);
 
@@ -1268,6 +1335,7 @@ static int rockchip_mipi_csi_probe(struct platform_device *pdev)
 
 	csi->dev = dev;
 	csi->pdata = of_device_get_match_data(dev);
+	spin_lock_init(&csi->stats_lock);
 	platform_set_drvdata(pdev, csi);
 
 	ret = dw_mipi_csi_parse_dt(csi);
@@ -1331,6 +1399,10 @@ static int rockchip_mipi_csi_probe(struct platform_device *pdev)
 		return ret;
 	}
 
+	ret = devm_device_add_group(dev, &rockchip_mipi_csi_attr_group);
+	if (ret)
+		return ret;
+
 	csi->dsi_host.ops = &rockchip_mipi_csi_host_ops;
 	csi->dsi_host.dev = dev;
 
@@ -250,6 +250,17 @@ struct mipi_dphy {
 	struct clk *hs_clk;
 };
 
+/* frame pacing as seen by the TX frame end interrupt */
+struct rockchip_mipi_csi_frame_stats {
+	u64 frames;
+	u64 errors;
+	ktime_t last;
+	u64 sum_us;
+	u32 last_us;
+	u32 min_us;
+	u32 max_us;
+};
+
 struct rockchip_mipi_csi {
 	struct drm_encoder encoder;
 	struct drm_connector connector;
@@ -278,6 +289,9 @@ struct rockchip_mipi_csi {
 	u32 path_mode; /* vop path or bypass path */
 	struct drm_property *csi_tx_path_property;
 
+	spinlock_t stats_lock;
+	struct rockchip_mipi_csi_frame_stats stats;
+
 	const struct rockchip_mipi_csi_plat_data *pdata;
 };
 
@@ -5,7 +5,9 @@
  */
 #include <linux/dma-buf-cache.h>
 #include <linux/fdtable.h>
+#include <drm/drm_atomic.h>
 #include <drm/drm_atomic_uapi.h>
+#include <drm/drm_prime.h>
 
 #include "../drm_internal.h"
 #include "rockchip_drm_direct_show.h"
@@ -155,6 +157,50 @@ int rockchip_drm_direct_show_alloc_buffer(struct drm_device *drm,
 	return -ENOMEM;
 }
 
+/*
+ * Wrap a dma-buf exported by another device (e.g. the camera) into a buffer
+ * that can be committed. The caller fills width, height, pixel_format and
+ * pitch[0], no CPU mapping is created.
+ */
+int rockchip_drm_direct_show_import_buffer(struct drm_device *drm,
+					   struct rockchip_drm_direct_show_buffer *buffer,
+					   struct dma_buf *dmabuf)
+{
+	const struct drm_format_info *format_info = drm_format_info(buffer->pixel_format);
+	struct drm_gem_object *obj;
+	int ret;
+
+	if (!format_info || !buffer->pitch[0])
+		return -EINVAL;
+
+	obj = drm_gem_prime_import(drm, dmabuf);
+	if (IS_ERR(obj)) {
+		DRM_DS_ERR("failed to import dma buf, ret %ld\n", PTR_ERR(obj));
+		return PTR_ERR(obj);
+	}
+
+	buffer->bpp = rockchip_drm_get_bpp(format_info);
+	buffer->rk_gem_obj = to_rockchip_obj(obj);
+	buffer->vir_addr[0] = NULL;
+	buffer->phy_addr[0] = buffer->rk_gem_obj->dma_addr;
+	if (format_info->is_yuv) {
+		buffer->vir_addr[1] = NULL;
+		buffer->pitch[1] = buffer->pitch[0];
+		buffer->phy_addr[1] = buffer->phy_addr[0] + buffer->width * buffer->height;
+	}
+	buffer->dmabuf_fd = -1;
+
+	ret = rockchip_drm_direct_show_alloc_fb(drm, buffer);
+	if (ret) {
+		drm_gem_object_put(obj);
+		return ret;
+	}
+
+	DRM_DS_DBG("import buffer: 0x%p, dma buf:0x%p\n", buffer->rk_gem_obj, dmabuf);
+
+	return 0;
+}
+
 void rockchip_drm_direct_show_free_buffer(struct drm_device *drm,
 					  struct rockchip_drm_direct_show_buffer *buffer)
 {
@@ -304,6 +350,90 @@ int rockchip_drm_direct_show_commit(struct drm_device *drm,
 	return ret;
 }
 
+/*
+ * Queue the plane update as a nonblocking atomic commit. The commit waits for
+ * @in_fence (may be NULL) in the commit worker and latches on the next vblank,
+ * so the caller can hand over a buffer that is still being written by the
+ * camera without stalling.
+ */
+int rockchip_drm_direct_show_commit_async(struct drm_device *drm,
+					  struct rockchip_drm_direct_show_commit_info *commit_info,
+					  struct dma_fence *in_fence)
+{
+	struct drm_plane *plane = commit_info->plane;
+	struct drm_crtc *crtc = commit_info->crtc;
+	struct drm_framebuffer *fb = commit_info->buffer->fb;
+	struct drm_modeset_acquire_ctx ctx;
+	struct drm_atomic_state *state;
+	struct drm_plane_state *plane_state;
+	struct drm_property *zpos_prop = NULL;
+	int ret;
+
+	if (commit_info->top_zpos) {
+		zpos_prop = rockchip_drm_direct_show_find_prop(drm, &plane->base, "zpos");
+		if (!zpos_prop)
+			DRM_DS_ERR("failed to find plane zpos prop\n");
+	}
+
+	state = drm_atomic_state_alloc(drm);
+	if (!state)
+		return -ENOMEM;
+
+	drm_modeset_acquire_init(&ctx, 0);
+	state->acquire_ctx = &ctx;
+retry:
+	plane_state = drm_atomic_get_plane_state(state, plane);
+	if (IS_ERR(plane_state)) {
+		ret = PTR_ERR(plane_state);
+		goto out;
+	}
+
+	ret = drm_atomic_set_crtc_for_plane(plane_state, crtc);
+	if (ret)
+		goto out;
+	drm_atomic_set_fb_for_plane(plane_state, fb);
+	plane_state->crtc_x = commit_info->dst_x;
+	plane_state->crtc_y = commit_info->dst_y;
+	plane_state->crtc_w = commit_info->dst_w;
+	plane_state->crtc_h = commit_info->dst_h;
+	plane_state->src_x = commit_info->src_x << 16;
+	plane_state->src_y = commit_info->src_y << 16;
+	plane_state->src_w = commit_info->src_w << 16;
+	plane_state->src_h = commit_info->src_h << 16;
+	/* set the max zpos value */
+	if (zpos_prop)
+		plane_state->zpos = zpos_prop->values[1];
+	if (in_fence)
+		drm_atomic_set_fence_for_plane(plane_state, dma_fence_get(in_fence));
+
+	ret = drm_atomic_nonblocking_commit(state);
+out:
+	if (ret == -EDEADLK) {
+		drm_atomic_state_clear(state);
+		ret = drm_modeset_backoff(&ctx);
+		if (!ret)
+			goto retry;
+	}
+	drm_atomic_state_put(state);
+	drm_modeset_drop_locks(&ctx);
+	drm_modeset_acquire_fini(&ctx);
+
+	if (ret) {
+		DRM_DS_ERR("async commit failed: plane[%s], crtc[%s], ret:%d\n",
+			   plane->name, crtc->name, ret);
+		return ret;
+	}
+
+	DRM_DS_DBG("async commit queued: plane[%s], crtc[%s], src[%dx%d@%dx%d], dst[%dx%d@%dx%d]\n",
+		   plane->name, crtc->name,
+		   commit_info->src_w, commit_info->src_h,
+		   commit_info->src_x, commit_info->src_y,
+		   commit_info->dst_w, commit_info->dst_h,
+		   commit_info->dst_x, commit_info->dst_y);
+
+	return 0;
+}
+
 int rockchip_drm_direct_show_disable_plane(struct drm_device *drm, struct drm_plane *plane)
 {
 	int ret = 0;
@@ -317,10 +447,22 @@ int rockchip_drm_direct_show_disable_plane(struct drm_device *drm, struct drm_pl
 	return ret;
 }
 
+/*
+ * Only cachable buffers need maintenance, the kernel mapping of the others is
+ * write combined and the display reads them straight from memory.
+ */
+static bool rockchip_drm_direct_show_buf_need_sync(struct rockchip_drm_direct_show_buffer *buffer)
+{
+	return buffer->rk_gem_obj->flags & ROCKCHIP_BO_CACHABLE;
+}
+
 int rockchip_drm_direct_show_buf_begin_cpu_access(struct rockchip_drm_direct_show_buffer *buffer)
 {
 	struct drm_gem_object *obj = &buffer->rk_gem_obj->base;
 
+	if (!rockchip_drm_direct_show_buf_need_sync(buffer))
+		return 0;
+
 	return rockchip_gem_prime_begin_cpu_access(obj, DMA_FROM_DEVICE);
 }
 
@@ -328,6 +470,9 @@ int rockchip_drm_direct_show_buf_end_cpu_access(struct rockchip_drm_direct_show_
 {
 	struct drm_gem_object *obj = &buffer->rk_gem_obj->base;
 
+	if (!rockchip_drm_direct_show_buf_need_sync(buffer))
+		return 0;
+
 	return rockchip_gem_prime_end_cpu_access(obj, DMA_TO_DEVICE);
 }
 
@@ -7,7 +7,9 @@
 #ifndef ROCKCHIP_DRM_DIRECT_SHOW_H
 #define ROCKCHIP_DRM_DIRECT_SHOW_H
 
+#include <linux/dma-buf.h>
 #include <linux/dma-direction.h>
+#include <linux/dma-fence.h>
 #include <linux/memblock.h>
 #include <drm/drm_atomic_uapi.h>
 #include <drm/drm_drv.h>
@@ -54,12 +56,18 @@ struct rockchip_drm_direct_show_commit_info {
 struct drm_device *rockchip_drm_get_dev(void);
 int rockchip_drm_direct_show_alloc_buffer(struct drm_device *drm,
 					  struct rockchip_drm_direct_show_buffer *buffer);
+int rockchip_drm_direct_show_import_buffer(struct drm_device *drm,
+					   struct rockchip_drm_direct_show_buffer *buffer,
+					   struct dma_buf *dmabuf);
 void rockchip_drm_direct_show_free_buffer(struct drm_device *drm,
 					  struct rockchip_drm_direct_show_buffer *buffer);
 struct drm_crtc *rockchip_drm_direct_show_get_crtc(struct drm_device *drm, const char *name);
 struct drm_plane *rockchip_drm_direct_show_get_plane(struct drm_device *drm, const char *name);
 int rockchip_drm_direct_show_commit(struct drm_device *drm,
 				    struct rockchip_drm_direct_show_commit_info *commit_info);
+int rockchip_drm_direct_show_commit_async(struct drm_device *drm,
+					  struct rockchip_drm_direct_show_commit_info *commit_info,
+					  struct dma_fence *in_fence);
 int rockchip_drm_direct_show_disable_plane(struct drm_device *drm, struct drm_plane *plane);
 int rockchip_drm_direct_show_buf_begin_cpu_access(struct rockchip_drm_direct_show_buffer *buffer);
 int rockchip_drm_direct_show_buf_end_cpu_access(struct rockchip_drm_direct_show_buffer *buffer);
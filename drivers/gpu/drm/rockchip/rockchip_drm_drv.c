@@ -1769,6 +1769,75 @@ static int rockchip_drm_get_vcnt_event_ioctl(struct drm_device *dev, void *data,
 	return 0;
 }
 
+static int rockchip_drm_wb_ring_ioctl(struct drm_device *dev, void *data,
+				      struct drm_file *file_priv)
+{
+	struct rockchip_drm_private *priv = dev->dev_private;
+	struct drm_rockchip_wb_ring *args = data;
+	struct drm_framebuffer *fbs[ARRAY_SIZE(args->fb_id)] = {};
+	const struct rockchip_crtc_funcs *funcs;
+	struct drm_crtc *crtc;
+	int i, ret;
+
+	if (args->count > ARRAY_SIZE(args->fb_id))
+		return -EINVAL;
+
+	crtc = drm_crtc_find(dev, file_priv, args->crtc_id);
+	if (!crtc)
+		return -ENOENT;
+
+	funcs = priv->crtc_funcs[drm_crtc_index(crtc)];
+	if (!funcs || !funcs->wb_ring)
+		return -EOPNOTSUPP;
+
+	for (i = 0; i < args->count; i++) {
+		fbs[i] = drm_framebuffer_lookup(dev, file_priv, args->fb_id[i]);
+		if (!fbs[i]) {
+			ret = -ENOENT;
+			goto err_put_fb;
+		}
+	}
+
+	drm_modeset_lock_all(dev);
+	ret = funcs->wb_ring(crtc, fbs, args->count);
+	drm_modeset_unlock_all(dev);
+	if (!ret)
+		return 0;
+
+err_put_fb:
+	for (i = 0; i < args->count; i++) {
+		if (fbs[i])
+			drm_framebuffer_put(fbs[i]);
+	}
+
+	return ret;
+}
+
+static int rockchip_drm_wb_ring_fence_ioctl(struct drm_device *dev, void *data,
+					    struct drm_file *file_priv)
+{
+	struct rockchip_drm_private *priv = dev->dev_private;
+	struct drm_rockchip_wb_ring_fence *args = data;
+	const struct rockchip_crtc_funcs *funcs;
+	struct drm_crtc *crtc;
+	int fd;
+
+	crtc = drm_crtc_find(dev, file_priv, args->crtc_id);
+	if (!crtc)
+		return -ENOENT;
+
+	funcs = priv->crtc_funcs[drm_crtc_index(crtc)];
+	if (!funcs || !funcs->wb_ring_fence)
+		return -EOPNOTSUPP;
+
+	fd = funcs->wb_ring_fence(crtc, args->index);
+	if (fd < 0)
+		return fd;
+	args->fence_fd = fd;
+
+	return 0;
+}
+
 static const struct drm_ioctl_desc rockchip_ioctls[] = {
 	DRM_IOCTL_DEF_DRV(ROCKCHIP_GEM_CREATE, rockchip_gem_create_ioctl,
 			  DRM_UNLOCKED | DRM_AUTH | DRM_RENDER_ALLOW),
@@ -1779,6 +1848,10 @@ static const struct drm_ioctl_desc rockchip_ioctls[] = {
 			  DRM_UNLOCKED | DRM_AUTH | DRM_RENDER_ALLOW),
 	DRM_IOCTL_DEF_DRV(ROCKCHIP_GET_VCNT_EVENT, rockchip_drm_get_vcnt_event_ioctl,
 			  DRM_UNLOCKED),
+	DRM_IOCTL_DEF_DRV(ROCKCHIP_WB_RING, rockchip_drm_wb_ring_ioctl,
+			  DRM_UNLOCKED | DRM_MASTER),
+	DRM_IOCTL_DEF_DRV(ROCKCHIP_WB_RING_FENCE, rockchip_drm_wb_ring_fence_ioctl,
+			  DRM_UNLOCKED | DRM_MASTER),
 };
 
 static int rockchip_drm_gem_dmabuf_begin_cpu_access(struct dma_buf *dma_buf,
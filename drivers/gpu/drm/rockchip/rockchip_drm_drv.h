@@ -337,6 +337,10 @@ struct rockchip_crtc_state {
 	int request_refresh_rate;
 	int max_refresh_rate;
 	int min_refresh_rate;
+	/**
+	 * @line_bw_mbyte: estimated peak line bandwidth of the planes in MB/s
+	 */
+	u32 line_bw_mbyte;
 };
 
 #define to_rockchip_crtc_state(s) \
@@ -475,6 +479,7 @@ struct next_hdr_sink_data {
  * @crtc_send_mcu_cmd: send mcu panel init cmd.
  * @te_handler: soft te hand for cmd mode panel.
  * @wait_vact_end: wait the last active line.
+ * @get_underflow_count: number of post buffer underflows since probe.
  */
 struct rockchip_crtc_funcs {
 	int (*loader_protect)(struct drm_crtc *crtc, bool on, void *data);
@@ -501,6 +506,9 @@ struct rockchip_crtc_funcs {
 	void (*crtc_output_pre_disable)(struct drm_crtc *crtc, int intf);
 	int (*crtc_set_color_bar)(struct drm_crtc *crtc, enum rockchip_color_bar_mode mode);
 	int (*set_aclk)(struct drm_crtc *crtc, enum rockchip_drm_vop_aclk_mode aclk_mode);
+	int (*wb_ring)(struct drm_crtc *crtc, struct drm_framebuffer **fbs, int num);
+	int (*wb_ring_fence)(struct drm_crtc *crtc, u32 index);
+	u32 (*get_underflow_count)(struct drm_crtc *crtc);
 };
 
 struct rockchip_dclk_pll {
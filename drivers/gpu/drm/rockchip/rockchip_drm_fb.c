@@ -344,6 +344,46 @@ static void rockchip_drm_output_poll_changed(struct drm_device *dev)
 		drm_fb_helper_hotplug_event(fb_helper);
 }
 
+/*
+ * A linear full screen layer costs several times the memory bandwidth of an
+ * afbc one. Report it once per framebuffer when the plane would have taken a
+ * compressed layout of the same format, so the producer can be fixed.
+ */
+static void rockchip_drm_check_linear_scanout(struct drm_atomic_state *state)
+{
+	struct drm_plane_state *pstate;
+	struct drm_plane *plane;
+	int i;
+
+	for_each_new_plane_in_state(state, plane, pstate, i) {
+		struct drm_framebuffer *fb = pstate->fb;
+		unsigned int j;
+
+		if (!fb || !pstate->visible || fb->modifier != DRM_FORMAT_MOD_LINEAR ||
+		    plane->type == DRM_PLANE_TYPE_CURSOR ||
+		    !plane->funcs->format_mod_supported)
+			continue;
+
+		if (fb->flags & (ROCKCHIP_DRM_MODE_LOGO_FB | ROCKCHIP_DRM_MODE_LINEAR_WARNED))
+			continue;
+
+		for (j = 0; j < plane->modifier_count; j++) {
+			u64 modifier = plane->modifiers[j];
+
+			if (!drm_is_afbc(modifier) ||
+			    !plane->funcs->format_mod_supported(plane, fb->format->format, modifier))
+				continue;
+
+			drm_warn(state->dev,
+				 "[PLANE:%d:%s] scans out linear %p4cc [FB:%d] %ux%u, afbc modifier 0x%llx is supported\n",
+				 plane->base.id, plane->name, &fb->format->format, fb->base.id,
+				 fb->width, fb->height, modifier);
+			fb->flags |= ROCKCHIP_DRM_MODE_LINEAR_WARNED;
+			break;
+		}
+	}
+}
+
 static int rockchip_atomic_check(struct drm_device *dev, struct drm_atomic_state *state)
 {
 	int ret;
@@ -352,6 +392,8 @@ static int rockchip_atomic_check(struct drm_device *dev, struct drm_atomic_state
 	if (ret)
 		return ret;
 
+	rockchip_drm_check_linear_scanout(state);
+
 #ifdef CONFIG_DRM_DISPLAY_DP_HELPER
 	ret = drm_dp_mst_atomic_check(state);
 	if (ret)
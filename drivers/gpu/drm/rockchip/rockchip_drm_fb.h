@@ -11,6 +11,7 @@
 #include "rockchip_drm_gem.h"
 
 #define ROCKCHIP_DRM_MODE_LOGO_FB	(1<<31) /* used for kernel logo, follow the define: DRM_MODE_FB_MODIFIERS at drm_mode.h */
+#define ROCKCHIP_DRM_MODE_LINEAR_WARNED	(1<<30) /* linear scanout where afbc was possible already reported */
 
 void rockchip_drm_mode_config_init(struct drm_device *dev);
 struct drm_framebuffer *
@@ -16,6 +16,7 @@
 
 #include <linux/genalloc.h>
 #include <linux/iommu.h>
+#include <linux/module.h>
 #include <linux/pagemap.h>
 #include <linux/vmalloc.h>
 #include <linux/rockchip/rockchip_sip.h>
@@ -33,16 +34,38 @@ struct page_info {
 
 #define PG_ROUND       8
 
+/*
+ * Chunk orders (1MB, 64K, 4K) tried for iommu mapped buffers, the same as
+ * the system dma-buf heap. A chunk is mapped by a single iommu_map() when
+ * the iova has the same alignment, and keeps the scanout of the buffer in
+ * fewer DDR pages.
+ */
+static const unsigned int chunk_orders[] = {8, 4, 0};
+#define CHUNK_ORDER_GFP	(__GFP_ZERO | __GFP_NOWARN | __GFP_NORETRY)
+
+static bool chunk_alloc = true;
+module_param(chunk_alloc, bool, 0644);
+MODULE_PARM_DESC(chunk_alloc, "Allocate iommu mapped buffers from physically contiguous chunks");
+
 static int rockchip_gem_iommu_map(struct rockchip_gem_object *rk_obj)
 {
 	struct drm_device *drm = rk_obj->base.dev;
 	struct rockchip_drm_private *private = drm->dev_private;
 	int prot = IOMMU_READ | IOMMU_WRITE;
+	u64 align = PAGE_SIZE;
 	ssize_t ret;
 
+	/* keep the iova as aligned as the largest chunk of the buffer */
+	if (rk_obj->buf_type == ROCKCHIP_GEM_BUF_TYPE_CHUNK) {
+		if (rk_obj->base.size >= SZ_1M)
+			align = SZ_1M;
+		else if (rk_obj->base.size >= SZ_64K)
+			align = SZ_64K;
+	}
+
 	mutex_lock(&private->mm_lock);
 	ret = drm_mm_insert_node_generic(&private->mm, &rk_obj->mm,
-					 rk_obj->base.size, PAGE_SIZE,
+					 rk_obj->base.size, align,
 					 0, 0);
 	mutex_unlock(&private->mm_lock);
 
@@ -254,6 +277,92 @@ static void rockchip_gem_put_pages(struct rockchip_gem_object *rk_obj)
 	drm_gem_put_pages(&rk_obj->base, rk_obj->pages, true, true);
 }
 
+/*
+ * Allocate the buffer from the largest chunks available, falling back to
+ * smaller orders when memory is fragmented. A chunk is only used at an
+ * offset aligned to its size, so the buffer offset and the physical
+ * address share the alignment the iommu mapping needs.
+ */
+static int rockchip_gem_alloc_chunks(struct rockchip_gem_object *rk_obj)
+{
+	struct drm_device *drm = rk_obj->base.dev;
+	gfp_t gfp = mapping_gfp_mask(rk_obj->base.filp->f_mapping) & ~__GFP_RECLAIMABLE;
+	unsigned long n_pages = rk_obj->base.size >> PAGE_SHIFT;
+	unsigned long i = 0, j, nr;
+	unsigned int order = 0;
+	struct scatterlist *s;
+	struct page **pages;
+	struct page *page;
+	int k, ret;
+
+	pages = kvmalloc_array(n_pages, sizeof(*pages), GFP_KERNEL);
+	if (!pages)
+		return -ENOMEM;
+
+	while (i < n_pages) {
+		page = NULL;
+		for (k = 0; k < ARRAY_SIZE(chunk_orders); k++) {
+			order = chunk_orders[k];
+			nr = 1UL << order;
+			if (n_pages - i < nr || (i & (nr - 1)))
+				continue;
+
+			if (order)
+				page = alloc_pages((gfp | CHUNK_ORDER_GFP) & ~__GFP_RECLAIM, order);
+			else
+				page = alloc_page(gfp | __GFP_ZERO);
+			if (page)
+				break;
+		}
+		if (!page) {
+			ret = -ENOMEM;
+			goto err_free_pages;
+		}
+
+		/* let every page be mapped and freed on its own */
+		split_page(page, order);
+		for (j = 0; j < (1UL << order); j++)
+			pages[i++] = page + j;
+	}
+
+	rk_obj->sgt = drm_prime_pages_to_sg(drm, pages, n_pages);
+	if (IS_ERR(rk_obj->sgt)) {
+		ret = PTR_ERR(rk_obj->sgt);
+		goto err_free_pages;
+	}
+
+	DRM_DEBUG_KMS("%s, %lu pages in %u chunks\n", __func__, n_pages, rk_obj->sgt->orig_nents);
+
+	/* same as rockchip_gem_get_pages(), so dma_sync_sg_for_device() can be used */
+	for_each_sgtable_sg(rk_obj->sgt, s, k)
+		sg_dma_address(s) = sg_phys(s);
+
+	dma_sync_sgtable_for_device(drm->dev, rk_obj->sgt, DMA_TO_DEVICE);
+
+	rk_obj->pages = pages;
+	rk_obj->num_pages = n_pages;
+
+	return 0;
+
+err_free_pages:
+	while (i--)
+		__free_page(pages[i]);
+	kvfree(pages);
+
+	return ret;
+}
+
+static void rockchip_gem_free_chunks(struct rockchip_gem_object *rk_obj)
+{
+	unsigned long i;
+
+	sg_free_table(rk_obj->sgt);
+	kfree(rk_obj->sgt);
+	for (i = 0; i < rk_obj->num_pages; i++)
+		__free_page(rk_obj->pages[i]);
+	kvfree(rk_obj->pages);
+}
+
 static inline void *drm_calloc_large(size_t nmemb, size_t size);
 static inline void drm_free_large(void *ptr);
 static void rockchip_gem_free_dma(struct rockchip_gem_object *rk_obj);
@@ -446,8 +555,13 @@ static int rockchip_gem_alloc_buf(struct rockchip_gem_object *rk_obj,
 		if (ret)
 			return ret;
 	} else {
-		rk_obj->buf_type = ROCKCHIP_GEM_BUF_TYPE_SHMEM;
-		ret = rockchip_gem_get_pages(rk_obj);
+		if (chunk_alloc && private->domain) {
+			rk_obj->buf_type = ROCKCHIP_GEM_BUF_TYPE_CHUNK;
+			ret = rockchip_gem_alloc_chunks(rk_obj);
+		} else {
+			rk_obj->buf_type = ROCKCHIP_GEM_BUF_TYPE_SHMEM;
+			ret = rockchip_gem_get_pages(rk_obj);
+		}
 		if (ret < 0)
 			return ret;
 
@@ -482,6 +596,8 @@ static int rockchip_gem_alloc_buf(struct rockchip_gem_object *rk_obj,
 		rockchip_gem_free_secure(rk_obj);
 	else if (rk_obj->buf_type == ROCKCHIP_GEM_BUF_TYPE_CMA)
 		rockchip_gem_free_dma(rk_obj);
+	else if (rk_obj->buf_type == ROCKCHIP_GEM_BUF_TYPE_CHUNK)
+		rockchip_gem_free_chunks(rk_obj);
 	else
 		rockchip_gem_put_pages(rk_obj);
 	return ret;
@@ -510,6 +626,9 @@ static void rockchip_gem_free_buf(struct rockchip_gem_object *rk_obj)
 	if (rk_obj->buf_type == ROCKCHIP_GEM_BUF_TYPE_SHMEM) {
 		vunmap(rk_obj->kvaddr);
 		rockchip_gem_put_pages(rk_obj);
+	} else if (rk_obj->buf_type == ROCKCHIP_GEM_BUF_TYPE_CHUNK) {
+		vunmap(rk_obj->kvaddr);
+		rockchip_gem_free_chunks(rk_obj);
 	} else if (rk_obj->buf_type == ROCKCHIP_GEM_BUF_TYPE_SECURE) {
 		rockchip_gem_free_secure(rk_obj);
 	} else {
@@ -857,6 +857,8 @@ static int setup_initial_state(struct drm_device *drm_dev,
 	if (!match || !is_crtc_enabled) {
 		set->mode_changed = true;
 	} else {
+		DRM_DEV_DEBUG_KMS(drm_dev->dev, "connector[%s] adopt loader mode without modeset\n",
+				  connector->name);
 		ret = drm_atomic_set_crtc_for_connector(conn_state, crtc);
 		if (ret)
 			goto error_conn;
@@ -1133,6 +1135,12 @@ void rockchip_drm_show_logo(struct drm_device *drm_dev)
 
 	if (list_empty(&mode_set_list)) {
 		dev_warn(drm_dev->dev, "can't not find any logo display\n");
+		/*
+		 * Every route is closed or was never enabled by the loader,
+		 * nothing scans out of the loader memory any more, give it
+		 * back instead of keeping it reserved until reboot.
+		 */
+		rockchip_free_loader_memory(drm_dev);
 		ret = -ENXIO;
 		goto err_free_state;
 	}
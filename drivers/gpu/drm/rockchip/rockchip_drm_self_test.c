@@ -5,8 +5,10 @@
  */
 
 #include <linux/delay.h>
+#include <linux/fdtable.h>
 #include <linux/init.h>
 #include <linux/kthread.h>
+#include <linux/ktime.h>
 #include <linux/module.h>
 #include <linux/workqueue.h>
 
@@ -36,6 +38,47 @@ struct rockchip_drm_self_test {
 
 static struct rockchip_drm_self_test rockchip_drm_st;
 
+static bool bench;
+module_param(bench, bool, 0444);
+MODULE_PARM_DESC(bench, "sweep plane count, format, scaling and size on each active vp instead of showing the pattern");
+
+#define BENCH_FRAMES		30
+#define BENCH_MAX_PLANES	4
+#define BENCH_RETRY		100
+
+static const u32 bench_formats[] = {
+	DRM_FORMAT_RGB565,
+	DRM_FORMAT_XRGB8888,
+	DRM_FORMAT_NV12,
+};
+
+static const struct {
+	u32 width;
+	u32 height;
+} bench_sizes[] = {
+	{ 1280, 720 },
+	{ 1920, 1080 },
+	{ 3840, 2160 },
+};
+
+/* dst = src * num / den */
+static const struct {
+	u32 num;
+	u32 den;
+	const char *name;
+} bench_scales[] = {
+	{ 1, 1, "1:1" },
+	{ 1, 2, "down" },
+	{ 2, 1, "up" },
+};
+
+struct rockchip_drm_bench_result {
+	u32 lat_avg_us;
+	u32 lat_max_us;
+	u32 underflow;
+	u32 bw_mbyte;
+};
+
 static void __maybe_unused
 rockchip_drm_draw_white(struct rockchip_drm_direct_show_buffer *buffer)
 {
@@ -113,6 +156,213 @@ static int rockchip_drm_self_test_free_buffer(struct rockchip_drm_self_test *sel
 	return 0;
 }
 
+static void rockchip_drm_bench_free_buffer(struct drm_device *dev,
+					   struct rockchip_drm_direct_show_buffer *buffer)
+{
+	if (!buffer)
+		return;
+
+	if (buffer->rk_gem_obj) {
+		if (buffer->fb)
+			drm_framebuffer_put(buffer->fb);
+		if (buffer->dmabuf_fd >= 0)
+			close_fd(buffer->dmabuf_fd);
+		rockchip_drm_direct_show_free_buffer(dev, buffer);
+	}
+	kfree(buffer);
+}
+
+static struct rockchip_drm_direct_show_buffer *
+rockchip_drm_bench_alloc_buffer(struct drm_device *dev, u32 width, u32 height, u32 format)
+{
+	struct rockchip_drm_direct_show_buffer *buffer;
+
+	buffer = kzalloc(sizeof(*buffer), GFP_KERNEL);
+	if (!buffer)
+		return NULL;
+
+	buffer->width = width;
+	buffer->height = height;
+	buffer->pixel_format = format;
+	buffer->dmabuf_fd = -1;
+	if (rockchip_drm_direct_show_alloc_buffer(dev, buffer)) {
+		kfree(buffer);
+		return NULL;
+	}
+	if (!buffer->fb) {
+		rockchip_drm_bench_free_buffer(dev, buffer);
+		return NULL;
+	}
+	rockchip_drm_draw_color_bar(buffer);
+
+	return buffer;
+}
+
+static u32 rockchip_drm_bench_underflow(struct drm_crtc *crtc)
+{
+	struct rockchip_drm_private *priv = crtc->dev->dev_private;
+	const struct rockchip_crtc_funcs *funcs = priv->crtc_funcs[drm_crtc_index(crtc)];
+
+	if (funcs && funcs->get_underflow_count)
+		return funcs->get_underflow_count(crtc);
+
+	return 0;
+}
+
+/*
+ * Stack @nr_planes planes showing @buffer scaled to @dst_w x @dst_h, then
+ * flip the top one between the two buffers. The blocking commit returns once
+ * the flip is done, so its duration is the cfg_done to frame start latency.
+ */
+static int rockchip_drm_bench_run(struct drm_device *dev, struct drm_crtc *crtc,
+				  struct drm_plane **planes, int nr_planes,
+				  struct rockchip_drm_direct_show_buffer **buffer,
+				  u32 dst_w, u32 dst_h,
+				  struct rockchip_drm_bench_result *result)
+{
+	struct rockchip_drm_direct_show_commit_info info = { 0 };
+	u32 vrefresh = drm_mode_vrefresh(&crtc->state->adjusted_mode);
+	u64 sum_us = 0, max_us = 0, us, bw;
+	u32 underflow;
+	ktime_t start;
+	int i, ret = 0;
+
+	info.crtc = crtc;
+	info.src_w = buffer[0]->width;
+	info.src_h = buffer[0]->height;
+	info.dst_w = dst_w;
+	info.dst_h = dst_h;
+
+	for (i = 0; i < nr_planes; i++) {
+		info.plane = planes[i];
+		info.buffer = buffer[0];
+		ret = rockchip_drm_direct_show_commit(dev, &info);
+		if (ret)
+			goto out;
+	}
+
+	underflow = rockchip_drm_bench_underflow(crtc);
+	for (i = 0; i < BENCH_FRAMES; i++) {
+		info.buffer = buffer[(i + 1) % USE_BUFFER_NUM];
+		start = ktime_get();
+		ret = rockchip_drm_direct_show_commit(dev, &info);
+		if (ret)
+			goto out;
+		us = ktime_us_delta(ktime_get(), start);
+		sum_us += us;
+		max_us = max(max_us, us);
+	}
+
+	/* the vop fetches every source pixel once per frame, whatever the scaling */
+	bw = (u64)info.src_w * info.src_h * buffer[0]->bpp / 8 * vrefresh * nr_planes;
+	result->lat_avg_us = div_u64(sum_us, BENCH_FRAMES);
+	result->lat_max_us = max_us;
+	result->underflow = rockchip_drm_bench_underflow(crtc) - underflow;
+	result->bw_mbyte = div_u64(bw, 1000000);
+out:
+	for (i = 0; i < nr_planes; i++)
+		rockchip_drm_direct_show_disable_plane(dev, planes[i]);
+
+	return ret;
+}
+
+static void rockchip_drm_bench_crtc(struct drm_device *dev, struct drm_crtc *crtc)
+{
+	struct drm_display_mode *mode = &crtc->state->adjusted_mode;
+	struct rockchip_drm_direct_show_buffer *buffer[USE_BUFFER_NUM];
+	struct drm_plane *planes[BENCH_MAX_PLANES];
+	struct rockchip_drm_bench_result result;
+	struct drm_plane *plane;
+	int nr_planes = 0, clean, n, i, j, k, b;
+	u32 format, dst_w, dst_h;
+
+	drm_for_each_plane(plane, dev) {
+		if (nr_planes == BENCH_MAX_PLANES)
+			break;
+		if (plane->type == DRM_PLANE_TYPE_CURSOR ||
+		    !(plane->possible_crtcs & drm_crtc_mask(crtc)))
+			continue;
+		planes[nr_planes++] = plane;
+	}
+
+	pr_info("bench %s %dx%d@%d, %d planes\n", crtc->name, mode->hdisplay,
+		mode->vdisplay, drm_mode_vrefresh(mode), nr_planes);
+
+	for (i = 0; i < ARRAY_SIZE(bench_sizes); i++) {
+		for (j = 0; j < ARRAY_SIZE(bench_formats); j++) {
+			format = bench_formats[j];
+			for (b = 0; b < USE_BUFFER_NUM; b++)
+				buffer[b] = rockchip_drm_bench_alloc_buffer(dev, bench_sizes[i].width,
+									    bench_sizes[i].height,
+									    format);
+			if (!buffer[0] || !buffer[1]) {
+				pr_info("bench %s %ux%u %p4cc: no buffer\n", crtc->name,
+					bench_sizes[i].width, bench_sizes[i].height, &format);
+				goto free;
+			}
+
+			for (k = 0; k < ARRAY_SIZE(bench_scales); k++) {
+				dst_w = bench_sizes[i].width * bench_scales[k].num / bench_scales[k].den;
+				dst_h = bench_sizes[i].height * bench_scales[k].num / bench_scales[k].den;
+				if (dst_w > mode->hdisplay || dst_h > mode->vdisplay)
+					continue;
+
+				clean = 0;
+				for (n = 1; n <= nr_planes; n++) {
+					if (rockchip_drm_bench_run(dev, crtc, planes, n, buffer,
+								   dst_w, dst_h, &result)) {
+						pr_info("bench %s %ux%u %p4cc %-4s planes:%d unsupported\n",
+							crtc->name, bench_sizes[i].width,
+							bench_sizes[i].height, &format,
+							bench_scales[k].name, n);
+						break;
+					}
+					pr_info("bench %s %ux%u %p4cc %-4s planes:%d cfg_done avg:%uus max:%uus underflow:%u bw:%uMB/s\n",
+						crtc->name, bench_sizes[i].width,
+						bench_sizes[i].height, &format, bench_scales[k].name,
+						n, result.lat_avg_us, result.lat_max_us,
+						result.underflow, result.bw_mbyte);
+					if (!result.underflow)
+						clean = n;
+				}
+				pr_info("bench %s %ux%u %p4cc %-4s => %d planes\n", crtc->name,
+					bench_sizes[i].width, bench_sizes[i].height, &format,
+					bench_scales[k].name, clean);
+			}
+free:
+			for (b = 0; b < USE_BUFFER_NUM; b++)
+				rockchip_drm_bench_free_buffer(dev, buffer[b]);
+		}
+	}
+}
+
+/*
+ * Qualify the layouts a board can show: for each active vp, report the
+ * flip latency, the underflows and the estimated fetch bandwidth of every
+ * plane count, format, scaling and source size combination, followed by
+ * the largest plane count which ran without underflow.
+ */
+static void rockchip_drm_self_test_bench(struct rockchip_drm_self_test *self_test)
+{
+	static int retry;
+	struct drm_device *dev = self_test->dev;
+	struct drm_crtc *crtc;
+	bool found = false;
+
+	drm_for_each_crtc(crtc, dev) {
+		if (crtc->state && crtc->state->active) {
+			found = true;
+			rockchip_drm_bench_crtc(dev, crtc);
+		}
+	}
+
+	/* wait for the display to come up */
+	if (!found && retry++ < BENCH_RETRY) {
+		msleep(100);
+		queue_work(self_test->workqueue, &self_test->commit_work);
+	}
+}
+
 static void rockchip_drm_self_test_commit(struct work_struct *work)
 {
 	struct rockchip_drm_self_test *self_test =
@@ -132,6 +382,11 @@ static void rockchip_drm_self_test_commit(struct work_struct *work)
 		return;
 	}
 
+	if (bench) {
+		rockchip_drm_self_test_bench(self_test);
+		return;
+	}
+
 	/* alloc buffer */
 	if (!self_test->drm_buffer[0]) {
 		ret = rockchip_drm_self_test_alloc_buffer(self_test);
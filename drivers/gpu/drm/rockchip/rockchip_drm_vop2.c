@@ -9,6 +9,7 @@
 #include <drm/drm_blend.h>
 #include <drm/drm_crtc.h>
 #include <drm/drm_crtc_helper.h>
+#include <drm/drm_damage_helper.h>
 #include <drm/drm_debugfs.h>
 #include <drm/drm_flip_work.h>
 #include <drm/drm_fourcc.h>
@@ -25,6 +26,7 @@
 #include <linux/debugfs.h>
 #include <linux/fixp-arith.h>
 #include <linux/iopoll.h>
+#include <linux/jhash.h>
 #include <linux/kernel.h>
 #include <linux/module.h>
 #include <linux/platform_device.h>
@@ -43,11 +45,13 @@
 #include <linux/delay.h>
 #include <linux/swab.h>
 #include <linux/sort.h>
+#include <linux/sync_file.h>
 #include <linux/rockchip/cpu.h>
 #include <linux/workqueue.h>
 #include <linux/types.h>
 #include <soc/rockchip/rockchip_csu.h>
 #include <soc/rockchip/rockchip_dmc.h>
+#include <soc/rockchip/rockchip_flight_recorder.h>
 #include <soc/rockchip/rockchip_opp_select.h>
 #include <soc/rockchip/rockchip_system_monitor.h>
 #include <soc/rockchip/rockchip-system-status.h>
@@ -74,6 +78,9 @@
 
 #define REG_GET(vop2, reg) ((vop2_readl(vop2, reg.offset) >> reg.shift) & reg.mask)
 
+#define WIN_REG_SET(x, win, off, reg, v) \
+		vop2_win_mask_write(x, win, off + reg.offset, reg.mask, reg.shift, v, reg.write_mask)
+
 #define VOP_CLUSTER_SET(x, win, name, v) \
 	do { \
 		if (win->regs->cluster) \
@@ -83,14 +90,14 @@
 #define VOP_AFBC_SET(x, win, name, v) \
 	do { \
 		if (win->regs->afbc) \
-			REG_SET(x, name, win->offset, win->regs->afbc->name, v, true); \
+			WIN_REG_SET(x, win, win->offset, win->regs->afbc->name, v); \
 	} while (0)
 
 #define VOP_WIN_SET(x, win, name, v) \
-		REG_SET(x, name, win->offset, VOP_WIN_NAME(win, name), v, true)
+		WIN_REG_SET(x, win, win->offset, VOP_WIN_NAME(win, name), v)
 
 #define VOP_SCL_SET(x, win, name, v) \
-		REG_SET(x, name, win->offset, win->regs->scl->name, v, true)
+		WIN_REG_SET(x, win, win->offset, win->regs->scl->name, v)
 
 #define VOP_CTRL_SET(x, name, v) \
 		REG_SET(x, name, 0, (x)->data->ctrl->name, v, false)
@@ -162,12 +169,17 @@
  * another one will run in next frame.
  */
 #define VOP2_WB_JOB_MAX      2
+/* buffers of a streaming writeback ring, see DRM_IOCTL_ROCKCHIP_WB_RING */
+#define VOP2_WB_RING_MAX     4
 #define VOP2_SYS_AXI_BUS_NUM 2
 
 #define VOP2_MAX_VP_OUTPUT_WIDTH	4096
 /* KHZ */
 #define VOP2_MAX_DCLK_RATE		600000
 
+/* hdrvivid tone lut banks per vp, must be at least 3 to keep the lru safe */
+#define VOP2_HDR_LUT_BANKS		4
+
 enum vop2_data_format {
 	VOP2_FMT_ARGB8888 = 0,
 	VOP2_FMT_RGB888_YUV444,
@@ -498,6 +510,12 @@ struct vop2_win {
 	 * @dci_lut_gem_obj: gem obj to store dci lut
 	 */
 	struct rockchip_gem_object *dci_lut_gem_obj;
+
+	/**
+	 * @regs_synced: the register backup of this window matches the
+	 * hardware, fields which are not changed by a commit skip the mmio write.
+	 */
+	bool regs_synced;
 };
 
 struct vop2_cluster {
@@ -527,6 +545,32 @@ struct vop2_wb_job {
 	uint32_t fs_vsync_cnt;
 };
 
+/*
+ * Streaming writeback: the hardware fills the ring buffers in turn, one
+ * per frame, without an atomic commit per frame. A buffer programmed at
+ * a frame start is latched at the next one and complete at the one after.
+ */
+struct vop2_wb_ring {
+	struct drm_framebuffer *fb[VOP2_WB_RING_MAX];
+	dma_addr_t yrgb_addr[VOP2_WB_RING_MAX];
+	dma_addr_t uv_addr[VOP2_WB_RING_MAX];
+	/* completion fence of the next fill, one timeline per buffer */
+	struct dma_fence *fence[VOP2_WB_RING_MAX];
+	u64 fence_context;
+	u32 fence_seqno[VOP2_WB_RING_MAX];
+	spinlock_t fence_lock;
+
+	uint8_t num;
+	uint8_t vp_id;
+	/* buffer latched at the last frame start and written now, or -1 */
+	int8_t writing;
+	/* buffer programmed at the last frame start, or -1 */
+	int8_t prog;
+	bool stopping;
+
+	struct drm_flip_work fb_unref_work;
+};
+
 struct vop2_wb {
 	uint8_t vp_id;
 	struct drm_writeback_connector conn;
@@ -541,6 +585,7 @@ struct vop2_wb {
 	 */
 	spinlock_t job_lock;
 
+	struct vop2_wb_ring ring;
 };
 
 struct vop2_dsc {
@@ -573,6 +618,46 @@ struct vop2_wb_connector_state {
 	uint8_t vp_id;
 };
 
+/*
+ * Latency histograms, bucket 0 counts everything below 128us and bucket n
+ * [128us << (n - 1), 128us << n), the last bucket collects the rest.
+ */
+#define VOP2_STATS_SHIFT	7
+#define VOP2_STATS_BUCKETS	10
+
+#define VOP2_MAX_REFRESH_RATE	144
+
+struct vop2_frame_stats {
+	ktime_t begin_time;
+	ktime_t cfg_done_time;
+	/**
+	 * @commit_hist: atomic_begin to cfg_done of each commit
+	 */
+	u32 commit_hist[VOP2_STATS_BUCKETS];
+	/**
+	 * @flip_hist: cfg_done to the vblank which sends the flip event
+	 */
+	u32 flip_hist[VOP2_STATS_BUCKETS];
+	u32 commits;
+	u32 flips;
+	/**
+	 * @missed: flip events sent at a frame start which did not take the
+	 * configuration, the done bit was still pending
+	 */
+	u32 missed;
+	/**
+	 * @min_margin: the least scan lines left before vblank at cfg_done
+	 */
+	u32 min_margin;
+	/**
+	 * @refresh_time_ms: time spent at each refresh rate, index 0 counts
+	 * the time the port is disabled or in self refresh
+	 */
+	u64 refresh_time_ms[VOP2_MAX_REFRESH_RATE + 1];
+	unsigned int refresh_rate;
+	ktime_t refresh_rate_since;
+};
+
 struct vop2_video_port {
 	struct rockchip_crtc rockchip_crtc;
 	struct rockchip_mcu_timing mcu_timing;
@@ -585,6 +670,8 @@ struct vop2_video_port {
 	bool xmirror_en;
 	bool need_reset_p2i_flag;
 	atomic_t post_buf_empty_flag;
+	/* number of POST_BUF_EMPTY (underflow) irqs since probe */
+	atomic_t post_buf_empty_count;
 	const struct vop2_video_port_regs *regs;
 
 	struct completion dsp_hold_completion;
@@ -720,10 +807,26 @@ struct vop2_video_port {
 	struct rockchip_gem_object *cubic_lut_gem_obj;
 
 	/**
-	 * @hdr_lut_gem_obj: gem obj to store hdr lut
+	 * @hdr_lut_gem_obj: gem obj to store hdr lut, VOP2_HDR_LUT_BANKS
+	 * tables of RK_HDRVIVID_TONE_SCA_AXI_TAB_LENGTH words
 	 */
 	struct rockchip_gem_object *hdr_lut_gem_obj;
 
+	/**
+	 * @hdr_lut_hash: jhash of the table held by each bank, 0 if empty
+	 */
+	u32 hdr_lut_hash[VOP2_HDR_LUT_BANKS];
+
+	/**
+	 * @hdr_lut_stamp: last use of each bank, for lru replacement
+	 */
+	u32 hdr_lut_stamp[VOP2_HDR_LUT_BANKS];
+
+	/**
+	 * @hdr_lut_seq: use counter feeding @hdr_lut_stamp
+	 */
+	u32 hdr_lut_seq;
+
 	/**
 	 * @cubic_lut: cubic look up table
 	 */
@@ -796,6 +899,10 @@ struct vop2_video_port {
 	 * @output_dclk_prop: vp max output dclk prop
 	 */
 	struct drm_property *output_dclk_prop;
+	/**
+	 * @bandwidth_prop: estimated line bandwidth of the last commit in MB/s
+	 */
+	struct drm_property *bandwidth_prop;
 
 	/**
 	 * @primary_plane_phy_id: vp primary plane phy id, the primary plane
@@ -805,11 +912,36 @@ struct vop2_video_port {
 
 	struct post_acm acm_info;
 	struct post_csc csc_info;
+	/**
+	 * @post_csc_coef: post csc coefficients calculated for @post_csc_key
+	 * and @post_csc_mode_key, reused until either of them changes
+	 */
+	struct post_csc_coef post_csc_coef;
+	struct post_csc post_csc_key;
+	struct post_csc_convert_mode post_csc_mode_key;
+	bool post_csc_coef_valid;
 
 	/**
 	 * @refresh_rate_change: indicate whether refresh rate change
 	 */
 	bool refresh_rate_change;
+	/**
+	 * @refresh_rate: refresh rate the video port is programmed to
+	 */
+	unsigned int refresh_rate;
+	/**
+	 * @vrr_idle: the refresh rate is lowered by the idle policy
+	 */
+	bool vrr_idle;
+	/**
+	 * @vrr_idle_work: lower the refresh rate once commits stop carrying damage
+	 */
+	struct delayed_work vrr_idle_work;
+	/**
+	 * @edpi_update_pending: registers changed since the last frame was
+	 * sent to a soft te command mode panel
+	 */
+	atomic_t edpi_update_pending;
 
 	/**
 	 * @acm_state_changed: indicate whether acm state change
@@ -824,6 +956,20 @@ struct vop2_video_port {
 	 * @irq: independent irq for each vp
 	 */
 	int irq;
+
+	struct vop2_frame_stats stats;
+
+	/**
+	 * @splice_load: per half load of the last commit in splice mode,
+	 * index 0 is the left vp
+	 */
+	struct {
+		u16 split_x;
+		u32 line_bw_mbyte[2];
+		u8 layers[2];
+		u8 scaled[2];
+		u8 afbc[2];
+	} splice_load;
 };
 
 struct vop2_extend_pll {
@@ -894,6 +1040,15 @@ struct vop2 {
 	 */
 	uint8_t active_vp_mask;
 	uint16_t port_mux_cfg;
+	/**
+	 * @pd_on_hist: time from power domain on request to status on
+	 */
+	u32 pd_on_hist[VOP2_STATS_BUCKETS];
+	/**
+	 * @pd_off_hist: time a power domain on request waits for the
+	 * previous off to complete
+	 */
+	u32 pd_off_hist[VOP2_STATS_BUCKETS];
 
 	uint32_t *regsbak;
 	struct resource *res;
@@ -1000,6 +1155,10 @@ static const struct drm_bus_format_enum_list drm_bus_format_enum_list[] = {
 
 static DRM_ENUM_NAME_FN(drm_get_bus_format_name, drm_bus_format_enum_list)
 static int vop2_devfreq_set_aclk(struct drm_crtc *crtc, enum rockchip_drm_vop_aclk_mode aclk_mode);
+static void vop2_wb_ring_cancel(struct vop2_video_port *vp);
+static void vop2_crtc_account_refresh_rate(struct vop2_video_port *vp, unsigned int rate);
+static int vop2_crtc_wb_ring(struct drm_crtc *crtc, struct drm_framebuffer **fbs, int num);
+static int vop2_crtc_wb_ring_fence(struct drm_crtc *crtc, u32 index);
 
 static inline struct vop2_video_port *to_vop2_video_port(struct drm_crtc *crtc)
 {
@@ -1010,6 +1169,11 @@ static inline struct vop2_video_port *to_vop2_video_port(struct drm_crtc *crtc)
 	return container_of(rockchip_crtc, struct vop2_video_port, rockchip_crtc);
 }
 
+static int vrr_idle_ms;
+module_param(vrr_idle_ms, int, 0644);
+MODULE_PARM_DESC(vrr_idle_ms,
+		 "Lower a variable refresh rate output to its min refresh rate after this many ms without damage, 0 to disable");
+
 static void vop2_lock(struct vop2 *vop2)
 {
 	mutex_lock(&vop2->vop2_lock);
@@ -1108,6 +1272,28 @@ static inline void vop2_mask_write(struct vop2 *vop2, uint32_t offset,
 		writel(v, vop2->regs + offset);
 }
 
+/*
+ * Most of the window registers are rewritten with the same value on every
+ * commit, only touch the hardware when the field differs from the backup.
+ */
+static inline void vop2_win_mask_write(struct vop2 *vop2, struct vop2_win *win,
+				       uint32_t offset, uint32_t mask, uint32_t shift,
+				       uint32_t v, bool write_mask)
+{
+	if (win->regs_synced && !write_mask && mask && vop2->regsbak &&
+	    ((vop2->regsbak[offset >> 2] >> shift) & mask) == (v & mask))
+		return;
+
+	vop2_mask_write(vop2, offset, mask, shift, v, write_mask, true);
+}
+
+static inline void vop2_stats_account(u32 *hist, ktime_t start, ktime_t end)
+{
+	u32 us = ktime_us_delta(end, start);
+
+	hist[min_t(int, fls(us >> VOP2_STATS_SHIFT), VOP2_STATS_BUCKETS - 1)]++;
+}
+
 static inline u32 vop2_line_to_time(struct drm_display_mode *mode, int line)
 {
 	u64 val = 1000000000ULL * mode->crtc_htotal * line;
@@ -1714,6 +1900,9 @@ static inline void vop2_cfg_done(struct drm_crtc *crtc)
 	struct vop2_video_port *vp = to_vop2_video_port(crtc);
 	struct vop2 *vop2 = vp->vop2;
 
+	atomic_set(&vp->edpi_update_pending, 1);
+	rk_fr_log(RK_FR_SRC_VOP2, RK_FR_EV_SUBMIT, vp->id, 0);
+
 	if (vop2->version == VOP_VERSION_RK3568)
 		return rk3568_vop2_cfg_done(crtc);
 	else
@@ -1795,13 +1984,18 @@ static void vop2_wait_power_domain_on(struct vop2_power_domain *pd)
 static void vop2_power_domain_on(struct vop2_power_domain *pd)
 {
 	struct vop2 *vop2 = pd->vop2;
+	ktime_t start, on;
 
 	if (!pd->on) {
 		dev_dbg(vop2->dev, "pd%d on\n", ffs(pd->data->id) - 1);
+		start = ktime_get();
 		vop2_wait_power_domain_off(pd);
+		on = ktime_get();
 		VOP_MODULE_SET(vop2, pd->data, pd, 0);
 		vop2_wait_power_domain_on(pd);
 		pd->on = true;
+		vop2_stats_account(vop2->pd_off_hist, start, on);
+		vop2_stats_account(vop2->pd_on_hist, on, ktime_get());
 	}
 }
 
@@ -1930,6 +2124,12 @@ static void vop2_win_disable(struct vop2_win *win, bool skip_splice_win)
 		win->splice_win = NULL;
 	}
 
+	/*
+	 * The window registers may be lost with its power domain, write all
+	 * of them again on the next enable.
+	 */
+	win->regs_synced = false;
+
 	if (VOP_WIN_GET(vop2, win, enable) || VOP_WIN_GET_REG_BAK(vop2, win, enable)) {
 		VOP_WIN_SET(vop2, win, enable, 0);
 		/*
@@ -3451,6 +3651,11 @@ static int vop2_wb_encoder_atomic_check(struct drm_encoder *encoder,
 	if (!conn_state->writeback_job || !conn_state->writeback_job->fb)
 		return 0;
 
+	if (READ_ONCE(vp->vop2->wb.ring.num)) {
+		DRM_DEBUG_KMS("writeback is streaming to a buffer ring\n");
+		return -EBUSY;
+	}
+
 	fb = conn_state->writeback_job->fb;
 	DRM_DEV_DEBUG(vp->vop2->dev, "%d x % d\n", fb->width, fb->height);
 
@@ -3516,14 +3721,27 @@ static const struct drm_connector_helper_funcs vop2_wb_connector_helper_funcs =
 };
 
 
+static void vop2_wb_ring_fb_unref_worker(struct drm_flip_work *work, void *val)
+{
+	drm_framebuffer_put(val);
+}
+
 static int vop2_wb_connector_init(struct vop2 *vop2, int nr_crtcs)
 {
 	const struct vop2_data *vop2_data = vop2->data;
+	struct vop2_wb_ring *ring = &vop2->wb.ring;
 	int ret;
 
 	vop2->wb.regs = vop2_data->wb->regs;
 	vop2->wb.conn.encoder.possible_crtcs = (1 << nr_crtcs) - 1;
 	spin_lock_init(&vop2->wb.job_lock);
+
+	spin_lock_init(&ring->fence_lock);
+	ring->fence_context = dma_fence_context_alloc(VOP2_WB_RING_MAX);
+	ring->writing = -1;
+	ring->prog = -1;
+	drm_flip_work_init(&ring->fb_unref_work, "wb_ring_fb_unref",
+			   vop2_wb_ring_fb_unref_worker);
 	drm_connector_helper_add(&vop2->wb.conn.base, &vop2_wb_connector_helper_funcs);
 
 	ret = drm_writeback_connector_init(vop2->drm_dev, &vop2->wb.conn,
@@ -3541,6 +3759,7 @@ static void vop2_wb_connector_destory(struct vop2 *vop2)
 {
 	drm_encoder_cleanup(&vop2->wb.conn.encoder);
 	drm_connector_cleanup(&vop2->wb.conn.base);
+	drm_flip_work_cleanup(&vop2->wb.ring.fb_unref_work);
 }
 
 static void vop2_wb_irqs_enable(struct vop2 *vop2)
@@ -3568,6 +3787,56 @@ static uint32_t vop2_read_and_clear_wb_irqs(struct vop2 *vop2)
 	return val;
 }
 
+static void vop2_wb_config(struct vop2 *vop2, struct drm_framebuffer *fb,
+			   struct vop2_wb_connector_state *wb_state,
+			   uint8_t r2y, bool one_frame_mode)
+{
+	struct vop2_wb *wb = &vop2->wb;
+	uint32_t fifo_throd;
+
+	fifo_throd = fb->pitches[0] >> 4;
+	if (fifo_throd >= vop2->data->wb->fifo_depth)
+		fifo_throd = vop2->data->wb->fifo_depth;
+
+	/*
+	 * the vp_id register config done immediately
+	 */
+	VOP_MODULE_SET(vop2, wb, vp_id, wb_state->vp_id);
+	VOP_MODULE_SET(vop2, wb, format, wb_state->format);
+	VOP_MODULE_SET(vop2, wb, yrgb_mst, wb_state->yrgb_addr);
+	VOP_MODULE_SET(vop2, wb, uv_mst, wb_state->uv_addr);
+	VOP_MODULE_SET(vop2, wb, fifo_throd, fifo_throd);
+	VOP_MODULE_SET(vop2, wb, scale_x_factor, wb_state->scale_x_factor);
+	VOP_MODULE_SET(vop2, wb, scale_x_en, wb_state->scale_x_en);
+	VOP_MODULE_SET(vop2, wb, scale_y_en, wb_state->scale_y_en);
+	VOP_MODULE_SET(vop2, wb, r2y_en, r2y);
+
+	/*
+	 * From rk3576, VOP writeback can support oneshot mode, and
+	 * at rk3576 writbeback oneshot mode must disable auto gating.
+	 */
+	if (!is_vop3(vop2) || vop2->version == VOP_VERSION_RK3528 ||
+	    vop2->version == VOP_VERSION_RK3562) {
+		VOP_MODULE_SET(vop2, wb, enable, 1);
+	} else {
+		VOP_MODULE_SET(vop2, wb, act_width, fb->width - 1);
+		VOP_MODULE_SET(vop2, wb, vir_stride, fb->pitches[0] >> 2);
+		VOP_MODULE_SET(vop2, wb, vir_stride_en, 1);
+		if (one_frame_mode) {
+			if (vop2->version == VOP_VERSION_RK3576)
+				VOP_MODULE_SET(vop2, wb, auto_gating, 0);
+			VOP_MODULE_SET(vop2, wb, one_frame_mode, 1);
+			vop2_write_reg_uncached(vop2, &wb->regs->enable, 1);
+		} else {
+			VOP_MODULE_SET(vop2, wb, one_frame_mode, 0);
+			VOP_MODULE_SET(vop2, wb, enable, 1);
+		}
+	}
+
+	vop2_wb_irqs_enable(vop2);
+	VOP_CTRL_SET(vop2, wb_dma_finish_and_en, 1);
+}
+
 static void vop2_wb_commit(struct drm_crtc *crtc)
 {
 	struct rockchip_crtc_state *vcstate = to_rockchip_crtc_state(crtc->state);
@@ -3578,7 +3847,6 @@ static void vop2_wb_commit(struct drm_crtc *crtc)
 	struct drm_connector_state *conn_state = wb_conn->base.state;
 	struct vop2_wb_connector_state *wb_state;
 	unsigned long flags;
-	uint32_t fifo_throd;
 	uint8_t r2y;
 
 	if (!conn_state)
@@ -3606,49 +3874,8 @@ static void vop2_wb_commit(struct drm_crtc *crtc)
 			wb->job_index = 0;
 		spin_unlock_irqrestore(&wb->job_lock, flags);
 
-		fifo_throd = fb->pitches[0] >> 4;
-		if (fifo_throd >= vop2->data->wb->fifo_depth)
-			fifo_throd = vop2->data->wb->fifo_depth;
 		r2y = !vcstate->yuv_overlay && fb->format->is_yuv;
-
-		/*
-		 * the vp_id register config done immediately
-		 */
-		VOP_MODULE_SET(vop2, wb, vp_id, wb_state->vp_id);
-		VOP_MODULE_SET(vop2, wb, format, wb_state->format);
-		VOP_MODULE_SET(vop2, wb, yrgb_mst, wb_state->yrgb_addr);
-		VOP_MODULE_SET(vop2, wb, uv_mst, wb_state->uv_addr);
-		VOP_MODULE_SET(vop2, wb, fifo_throd, fifo_throd);
-		VOP_MODULE_SET(vop2, wb, scale_x_factor, wb_state->scale_x_factor);
-		VOP_MODULE_SET(vop2, wb, scale_x_en, wb_state->scale_x_en);
-		VOP_MODULE_SET(vop2, wb, scale_y_en, wb_state->scale_y_en);
-		VOP_MODULE_SET(vop2, wb, r2y_en, r2y);
-
-		/*
-		 * From rk3576, VOP writeback can support oneshot mode, and
-		 * at rk3576 writbeback oneshot mode must disable auto gating.
-		 */
-		if (!is_vop3(vop2) || vop2->version == VOP_VERSION_RK3528 ||
-		    vop2->version == VOP_VERSION_RK3562) {
-			VOP_MODULE_SET(vop2, wb, enable, 1);
-		} else {
-			bool one_frame_mode = true;
-
-			VOP_MODULE_SET(vop2, wb, act_width, fb->width - 1);
-			VOP_MODULE_SET(vop2, wb, vir_stride, fb->pitches[0] >> 2);
-			VOP_MODULE_SET(vop2, wb, vir_stride_en, 1);
-			if (one_frame_mode) {
-				if (vop2->version == VOP_VERSION_RK3576)
-					VOP_MODULE_SET(vop2, wb, auto_gating, 0);
-				VOP_MODULE_SET(vop2, wb, one_frame_mode, 1);
-				vop2_write_reg_uncached(vop2, &wb->regs->enable, 1);
-			} else {
-				VOP_MODULE_SET(vop2, wb, enable, 1);
-			}
-		}
-
-		vop2_wb_irqs_enable(vop2);
-		VOP_CTRL_SET(vop2, wb_dma_finish_and_en, 1);
+		vop2_wb_config(vop2, fb, wb_state, r2y, true);
 	}
 }
 
@@ -4113,7 +4340,7 @@ static void vop2_initial(struct drm_crtc *crtc)
 	const struct vop2_data *vop2_data = vop2->data;
 	const struct vop2_video_port_data *vp_data = &vop2_data->vp[vp->id];
 	struct vop2_wb *wb = &vop2->wb;
-	int ret;
+	int ret, i;
 
 	if (vop2->enable_count == 0) {
 		ret = pm_runtime_get_sync(vop2->dev);
@@ -4138,6 +4365,8 @@ static void vop2_initial(struct drm_crtc *crtc)
 			rk3588_vop2_regsbak(vop2);
 		else
 			memcpy(vop2->regsbak, vop2->regs, vop2->len);
+		for (i = 0; i < vop2->registered_num_wins; i++)
+			vop2->win[i].regs_synced = false;
 
 		VOP_MODULE_SET(vop2, wb, axi_yrgb_id, 0xd);
 		VOP_MODULE_SET(vop2, wb, axi_uv_id, 0xe);
@@ -4795,6 +5024,10 @@ static void vop2_crtc_atomic_disable(struct drm_crtc *crtc,
 
 	WARN_ON(vp->event);
 
+	/* the idle work checks the state again, it must not be waited for here */
+	cancel_delayed_work(&vp->vrr_idle_work);
+	vop2_crtc_account_refresh_rate(vp, 0);
+
 	if (crtc->state->self_refresh_active) {
 		vop2_crtc_atomic_enter_psr(crtc, old_cstate);
 		goto out;
@@ -4802,6 +5035,7 @@ static void vop2_crtc_atomic_disable(struct drm_crtc *crtc,
 
 	vop2_lock(vop2);
 	DRM_DEV_INFO(vop2->dev, "Crtc atomic disable vp%d\n", vp->id);
+	vop2_wb_ring_cancel(vp);
 	VOP_MODULE_SET(vop2, vp, almost_full_or_en, 0);
 	VOP_MODULE_SET(vop2, vp, line_flag_or_en, 0);
 	drm_crtc_vblank_off(crtc);
@@ -5998,6 +6232,7 @@ static void vop2_win_atomic_update(struct vop2_win *win, struct drm_rect *src, s
 		VOP_CLUSTER_SET(vop2, win, frm_reset_en, 1);
 		VOP_CLUSTER_SET(vop2, win, dma_stride_4k_disable, 1);
 	}
+	win->regs_synced = true;
 	spin_unlock(&vop2->reg_lock);
 }
 
@@ -6122,10 +6357,110 @@ static void vop2_plane_atomic_update(struct drm_plane *plane, struct drm_atomic_
 #endif
 }
 
+/*
+ * Cursor planes and planes with ASYNC_COMMIT set may be updated without
+ * waiting for the vblank of a pending commit, the latest update before the
+ * next frame start wins. Only a new buffer and new coordinates are taken,
+ * anything which changes the overlay setup of the video port is refused.
+ */
+static int vop2_plane_atomic_async_check(struct drm_plane *plane,
+					 struct drm_atomic_state *state)
+{
+	struct drm_plane_state *new_pstate = drm_atomic_get_new_plane_state(state, plane);
+	struct drm_plane_state *pstate = plane->state;
+	struct vop2_plane_state *new_vpstate = to_vop2_plane_state(new_pstate);
+	struct vop2_plane_state *vpstate;
+	struct rockchip_crtc_state *vcstate;
+	struct drm_crtc *crtc = new_pstate->crtc;
+
+	if (!crtc || !pstate || !pstate->fb || !new_pstate->fb)
+		return -EINVAL;
+
+	if (plane != crtc->cursor && !new_vpstate->async_commit)
+		return -EINVAL;
+
+	if (pstate->crtc != crtc || !pstate->visible || !new_pstate->visible)
+		return -EINVAL;
+
+	vcstate = to_rockchip_crtc_state(crtc->state);
+	if (vcstate->splice_mode)
+		return -EINVAL;
+
+	vpstate = to_vop2_plane_state(pstate);
+	if (pstate->fb->format != new_pstate->fb->format ||
+	    pstate->fb->modifier != new_pstate->fb->modifier ||
+	    pstate->rotation != new_pstate->rotation ||
+	    pstate->alpha != new_pstate->alpha ||
+	    pstate->pixel_blend_mode != new_pstate->pixel_blend_mode ||
+	    vpstate->zpos != new_vpstate->zpos ||
+	    vpstate->eotf != new_vpstate->eotf ||
+	    vpstate->color_key != new_vpstate->color_key)
+		return -EINVAL;
+
+	return 0;
+}
+
+static void vop2_plane_atomic_async_update(struct drm_plane *plane,
+					   struct drm_atomic_state *state)
+{
+	struct drm_plane_state *new_pstate = drm_atomic_get_new_plane_state(state, plane);
+	struct vop2_plane_state *new_vpstate = to_vop2_plane_state(new_pstate);
+	struct vop2_plane_state *vpstate = to_vop2_plane_state(plane->state);
+	struct drm_crtc *crtc = plane->state->crtc;
+	struct vop2_video_port *vp = to_vop2_video_port(crtc);
+	struct vop2_win *win = to_vop2_win(plane);
+	struct vop2 *vop2 = win->vop2;
+	struct drm_framebuffer *old_fb = plane->state->fb;
+	unsigned long flags;
+
+	plane->state->crtc_x = new_pstate->crtc_x;
+	plane->state->crtc_y = new_pstate->crtc_y;
+	plane->state->crtc_h = new_pstate->crtc_h;
+	plane->state->crtc_w = new_pstate->crtc_w;
+	plane->state->src_x = new_pstate->src_x;
+	plane->state->src_y = new_pstate->src_y;
+	plane->state->src_h = new_pstate->src_h;
+	plane->state->src_w = new_pstate->src_w;
+	plane->state->src = new_pstate->src;
+	plane->state->dst = new_pstate->dst;
+	swap(plane->state->fb, new_pstate->fb);
+
+	/* derived by vop2_plane_atomic_check for the new buffer */
+	vpstate->src = new_vpstate->src;
+	vpstate->dest = new_vpstate->dest;
+	vpstate->yrgb_mst = new_vpstate->yrgb_mst;
+	vpstate->uv_mst = new_vpstate->uv_mst;
+	vpstate->fb_size = new_vpstate->fb_size;
+	vpstate->offset = new_vpstate->offset;
+
+	mutex_lock(&vop2->vop2_lock);
+	if (vop2->is_enabled) {
+		vop2_plane_atomic_update(plane, state);
+		spin_lock_irqsave(&vop2->irq_lock, flags);
+		vop2_cfg_done(crtc);
+		spin_unlock_irqrestore(&vop2->irq_lock, flags);
+
+		/*
+		 * The old buffer may still be scanned out until the next
+		 * frame start, release it from the vblank like a flip does.
+		 */
+		if (old_fb && plane->state->fb != old_fb) {
+			if (!vop2->skip_ref_fb)
+				drm_framebuffer_get(old_fb);
+			WARN_ON(drm_crtc_vblank_get(crtc) != 0);
+			drm_flip_work_queue(&vp->fb_unref_work, old_fb);
+			set_bit(VOP_PENDING_FB_UNREF, &vp->pending);
+		}
+	}
+	mutex_unlock(&vop2->vop2_lock);
+}
+
 static const struct drm_plane_helper_funcs vop2_plane_helper_funcs = {
 	.atomic_check = vop2_plane_atomic_check,
 	.atomic_update = vop2_plane_atomic_update,
 	.atomic_disable = vop2_plane_atomic_disable,
+	.atomic_async_check = vop2_plane_atomic_async_check,
+	.atomic_async_update = vop2_plane_atomic_async_update,
 };
 
 /**
@@ -7158,11 +7493,85 @@ static int vop2_cubic_lut_show(struct seq_file *s, void *data)
 	return 0;
 }
 
+static void vop2_stats_hist_show(struct seq_file *s, const char *name, const u32 *hist)
+{
+	int i;
+
+	DEBUG_PRINT("  %-18s", name);
+	for (i = 0; i < VOP2_STATS_BUCKETS; i++)
+		DEBUG_PRINT(" %8u", hist[i]);
+	DEBUG_PRINT("\n");
+}
+
+static int vop2_frame_stats_show(struct seq_file *s, void *data)
+{
+	struct drm_info_node *node = s->private;
+	struct vop2 *vop2 = node->info_ent->data;
+	int i, j;
+
+	DEBUG_PRINT("  %-18s", "us <");
+	for (i = 0; i < VOP2_STATS_BUCKETS - 1; i++)
+		DEBUG_PRINT(" %8u", 1 << (VOP2_STATS_SHIFT + i));
+	DEBUG_PRINT(" %8s\n", "more");
+
+	for (i = 0; i < vop2->data->nr_vps; i++) {
+		struct vop2_frame_stats *stats = &vop2->vps[i].stats;
+
+		DEBUG_PRINT("Video port%d: commits %u flips %u missed %u min margin %u lines\n",
+			    i, stats->commits, stats->flips, stats->missed, stats->min_margin);
+		vop2_stats_hist_show(s, "commit->cfg_done", stats->commit_hist);
+		vop2_stats_hist_show(s, "cfg_done->flip", stats->flip_hist);
+		for (j = 1; j <= VOP2_MAX_REFRESH_RATE; j++) {
+			u64 ms = stats->refresh_time_ms[j];
+
+			if (stats->refresh_rate_since && stats->refresh_rate == j)
+				ms += ktime_ms_delta(ktime_get(), stats->refresh_rate_since);
+			if (ms)
+				DEBUG_PRINT("  %3dHz: %llu ms\n", j, ms);
+		}
+	}
+
+	DEBUG_PRINT("Power domain:\n");
+	vop2_stats_hist_show(s, "wait off", vop2->pd_off_hist);
+	vop2_stats_hist_show(s, "on", vop2->pd_on_hist);
+
+	return 0;
+}
+
+static int vop2_splice_show(struct seq_file *s, void *data)
+{
+	struct drm_info_node *node = s->private;
+	struct vop2 *vop2 = node->info_ent->data;
+	int i, j;
+
+	for (i = 0; i < vop2->data->nr_vps; i++) {
+		struct vop2_video_port *vp = &vop2->vps[i];
+		struct rockchip_crtc_state *vcstate;
+
+		if (!vp->rockchip_crtc.crtc.state)
+			continue;
+		vcstate = to_rockchip_crtc_state(vp->rockchip_crtc.crtc.state);
+		if (!vcstate->splice_mode)
+			continue;
+
+		DEBUG_PRINT("Video port%d: split at x %u\n", i, vp->splice_load.split_x);
+		for (j = 0; j < 2; j++)
+			DEBUG_PRINT("  %-5s: %u MB/s, layers %u, scaled %u, afbc %u\n",
+				    j ? "right" : "left", vp->splice_load.line_bw_mbyte[j],
+				    vp->splice_load.layers[j], vp->splice_load.scaled[j],
+				    vp->splice_load.afbc[j]);
+	}
+
+	return 0;
+}
+
 #undef DEBUG_PRINT
 
 static struct drm_info_list vop2_debugfs_files[] = {
 	{ "gamma_lut", vop2_gamma_show, 0, NULL },
 	{ "cubic_lut", vop2_cubic_lut_show, 0, NULL },
+	{ "frame_stats", vop2_frame_stats_show, 0, NULL },
+	{ "splice", vop2_splice_show, 0, NULL },
 };
 
 static int vop2_crtc_debugfs_init(struct drm_minor *minor, struct drm_crtc *crtc)
@@ -7331,6 +7740,83 @@ static u64 vop2_calc_max_bandwidth(struct vop2_bandwidth *bw, int start,
 	return max_bandwidth;
 }
 
+/*
+ * In splice mode each vp fetches the layers of its own half of the screen
+ * within the same line time, so a half carrying most of the overlays needs
+ * up to twice the rate the whole screen average suggests. The split itself
+ * is fixed at hdisplay / 2 by the two vp timings, account the load of each
+ * half and return the line bandwidth of the heavier one.
+ */
+static u64 vop2_crtc_splice_bandwidth(struct drm_crtc *crtc,
+				      struct drm_crtc_state *crtc_state,
+				      int plane_num)
+{
+	struct vop2_video_port *vp = to_vop2_video_port(crtc);
+	struct drm_display_mode *adjusted_mode = &crtc_state->adjusted_mode;
+	uint16_t half_hdisplay = adjusted_mode->crtc_hdisplay >> 1;
+	uint16_t vdisplay = adjusted_mode->crtc_vdisplay;
+	struct drm_atomic_state *state = crtc_state->state;
+	struct vop2_bandwidth *pbandwidth[2];
+	struct drm_plane_state *pstate;
+	struct drm_plane *plane;
+	u64 line_bw[2] = { 0, 0 };
+	int cnt[2] = { 0, 0 };
+	int i, j;
+
+	memset(&vp->splice_load, 0, sizeof(vp->splice_load));
+	vp->splice_load.split_x = half_hdisplay;
+
+	pbandwidth[0] = kmalloc_array(plane_num * 2, sizeof(*pbandwidth[0]), GFP_KERNEL);
+	if (!pbandwidth[0])
+		return 0;
+	pbandwidth[1] = pbandwidth[0] + plane_num;
+
+	for_each_new_plane_in_state(state, plane, pstate, i) {
+		struct vop2_plane_state *vpstate;
+		int dst_w, part_w[2];
+		bool afbc, scaled;
+		size_t bandwidth;
+
+		if (!pstate || pstate->crtc != crtc || !pstate->fb)
+			continue;
+
+		vpstate = to_vop2_plane_state(pstate);
+		dst_w = drm_rect_width(&vpstate->dest);
+		if (dst_w <= 0)
+			continue;
+		part_w[0] = clamp_t(int, min_t(int, half_hdisplay, vpstate->dest.x2) -
+				    vpstate->dest.x1, 0, dst_w);
+		part_w[1] = dst_w - part_w[0];
+
+		afbc = rockchip_afbc(plane, pstate->fb->modifier);
+		scaled = (drm_rect_width(&vpstate->src) >> 16) != dst_w ||
+			 (drm_rect_height(&vpstate->src) >> 16) != drm_rect_height(&vpstate->dest);
+		bandwidth = vop2_plane_line_bandwidth(pstate) / (afbc ? 2 : 1);
+
+		for (j = 0; j < 2; j++) {
+			if (!part_w[j])
+				continue;
+			pbandwidth[j][cnt[j]].y1 = vpstate->dest.y1;
+			pbandwidth[j][cnt[j]].y2 = vpstate->dest.y2;
+			pbandwidth[j][cnt[j]++].bandwidth = (u64)bandwidth * part_w[j] / dst_w;
+			vp->splice_load.layers[j]++;
+			vp->splice_load.scaled[j] += scaled;
+			vp->splice_load.afbc[j] += afbc;
+		}
+	}
+
+	for (j = 0; j < 2; j++) {
+		sort(pbandwidth[j], cnt[j], sizeof(pbandwidth[j][0]), vop2_bandwidth_cmp, NULL);
+		line_bw[j] = vop2_calc_max_bandwidth(pbandwidth[j], 0, cnt[j], vdisplay);
+		line_bw[j] *= adjusted_mode->crtc_clock;
+		do_div(line_bw[j], adjusted_mode->crtc_htotal * 1000);
+		vp->splice_load.line_bw_mbyte[j] = line_bw[j];
+	}
+	kfree(pbandwidth[0]);
+
+	return max(line_bw[0], line_bw[1]);
+}
+
 static size_t vop2_crtc_bandwidth(struct drm_crtc *crtc,
 				  struct drm_crtc_state *crtc_state,
 				  struct dmcfreq_vop_info *vop_bw_info)
@@ -7416,37 +7902,115 @@ static size_t vop2_crtc_bandwidth(struct drm_crtc *crtc,
 	 */
 	line_bw_mbyte *= clock;
 	do_div(line_bw_mbyte, htotal * 1000);
+
+	if (to_rockchip_crtc_state(crtc_state)->splice_mode) {
+		u64 half_bw_mbyte = vop2_crtc_splice_bandwidth(crtc, crtc_state, plane_num);
+
+		line_bw_mbyte = max(line_bw_mbyte, half_bw_mbyte * 2);
+	}
 	vop_bw_info->line_bw_mbyte = line_bw_mbyte;
 
 	return 0;
 }
 
-static void vop2_crtc_close(struct drm_crtc *crtc)
+/*
+ * Estimate the peak line bandwidth of the planes the new crtc state will
+ * scan out, with the same model as vop2_crtc_bandwidth. The result is
+ * exported by the BANDWIDTH property so that the compositor can rank
+ * candidate layouts, and the most expensive plane is reported to help
+ * it decide which layer to move to the GPU or to scale down first.
+ */
+static u32 vop2_crtc_estimate_bandwidth(struct drm_crtc *crtc,
+					struct drm_crtc_state *crtc_state)
 {
-	struct vop2_video_port *vp = to_vop2_video_port(crtc);
-	struct vop2 *vop2 = vp->vop2;
-
-	if (!crtc)
-		return;
+	struct drm_display_mode *adjusted_mode = &crtc_state->adjusted_mode;
+	uint16_t htotal = adjusted_mode->crtc_htotal;
+	uint16_t vdisplay = adjusted_mode->crtc_vdisplay;
+	int clock = adjusted_mode->crtc_clock;
+	const struct drm_plane_state *pstate;
+	struct vop2_plane_state *vpstate;
+	struct vop2_bandwidth *pbandwidth;
+	struct drm_plane *plane, *max_plane = NULL;
+	size_t max_plane_bw = 0;
+	u64 line_bw_mbyte;
+	int plane_num, cnt = 0;
 
-	mutex_lock(&vop2->vop2_lock);
-	if (!vop2->is_enabled) {
-		mutex_unlock(&vop2->vop2_lock);
-		return;
-	}
+	plane_num = hweight32(crtc_state->plane_mask);
+	if (!crtc_state->active || !htotal || !vdisplay || !plane_num)
+		return 0;
 
-	vop2_disable_all_planes_for_crtc(crtc);
-	mutex_unlock(&vop2->vop2_lock);
-}
+	pbandwidth = kmalloc_array(plane_num, sizeof(*pbandwidth), GFP_KERNEL);
+	if (!pbandwidth)
+		return 0;
 
-static void vop2_crtc_te_handler(struct drm_crtc *crtc)
-{
-	struct vop2_video_port *vp = to_vop2_video_port(crtc);
-	struct vop2 *vop2 = vp->vop2;
+	drm_atomic_crtc_state_for_each_plane_state(plane, pstate, crtc_state) {
+		if (!pstate->fb || cnt >= plane_num)
+			continue;
+
+		vpstate = to_vop2_plane_state(pstate);
+		pbandwidth[cnt].y1 = vpstate->dest.y1;
+		pbandwidth[cnt].y2 = vpstate->dest.y2;
+		pbandwidth[cnt].bandwidth =
+			vop2_plane_line_bandwidth((struct drm_plane_state *)pstate);
+		if (rockchip_afbc(plane, pstate->fb->modifier))
+			pbandwidth[cnt].bandwidth /= 2;
+		if (pbandwidth[cnt].bandwidth > max_plane_bw) {
+			max_plane_bw = pbandwidth[cnt].bandwidth;
+			max_plane = plane;
+		}
+		cnt++;
+	}
+
+	sort(pbandwidth, cnt, sizeof(pbandwidth[0]), vop2_bandwidth_cmp, NULL);
+	line_bw_mbyte = vop2_calc_max_bandwidth(pbandwidth, 0, cnt, vdisplay);
+	kfree(pbandwidth);
+
+	line_bw_mbyte *= clock;
+	do_div(line_bw_mbyte, htotal * 1000);
+
+	if (max_plane)
+		drm_dbg_atomic(crtc->dev,
+			       "[CRTC:%d:%s] line bandwidth %llu MB/s, heaviest %s %zu bytes/line\n",
+			       crtc->base.id, crtc->name, line_bw_mbyte,
+			       max_plane->name, max_plane_bw);
+
+	return min_t(u64, line_bw_mbyte, U32_MAX);
+}
+
+static void vop2_crtc_close(struct drm_crtc *crtc)
+{
+	struct vop2_video_port *vp = to_vop2_video_port(crtc);
+	struct vop2 *vop2 = vp->vop2;
+
+	if (!crtc)
+		return;
+
+	mutex_lock(&vop2->vop2_lock);
+	if (!vop2->is_enabled) {
+		mutex_unlock(&vop2->vop2_lock);
+		return;
+	}
+
+	vop2_disable_all_planes_for_crtc(crtc);
+	mutex_unlock(&vop2->vop2_lock);
+}
+
+static void vop2_crtc_te_handler(struct drm_crtc *crtc)
+{
+	struct vop2_video_port *vp = to_vop2_video_port(crtc);
+	struct vop2 *vop2 = vp->vop2;
 
 	if (!crtc || !crtc->state->active)
 		return;
 
+	/*
+	 * A command mode panel keeps scanning its own frame memory, only send
+	 * a new frame when the registers changed or someone waits for vblank.
+	 */
+	if (!atomic_xchg(&vp->edpi_update_pending, 0) &&
+	    !atomic_read(&crtc->dev->vblank[drm_crtc_index(crtc)].refcount))
+		return;
+
 	VOP_MODULE_SET(vop2, vp, edpi_wms_fs, 1);
 }
 
@@ -7488,6 +8052,13 @@ static int vop2_crtc_set_color_bar(struct drm_crtc *crtc, enum rockchip_color_ba
 	return ret;
 }
 
+static u32 vop2_crtc_get_underflow_count(struct drm_crtc *crtc)
+{
+	struct vop2_video_port *vp = to_vop2_video_port(crtc);
+
+	return atomic_read(&vp->post_buf_empty_count);
+}
+
 static const struct rockchip_crtc_funcs private_crtc_funcs = {
 	.loader_protect = vop2_crtc_loader_protect,
 	.cancel_pending_vblank = vop2_crtc_cancel_pending_vblank,
@@ -7505,6 +8076,9 @@ static const struct rockchip_crtc_funcs private_crtc_funcs = {
 	.crtc_output_pre_disable = vop2_crtc_output_pre_disable,
 	.crtc_set_color_bar = vop2_crtc_set_color_bar,
 	.set_aclk = vop2_devfreq_set_aclk,
+	.wb_ring = vop2_crtc_wb_ring,
+	.wb_ring_fence = vop2_crtc_wb_ring_fence,
+	.get_underflow_count = vop2_crtc_get_underflow_count,
 };
 
 static bool vop2_crtc_mode_fixup(struct drm_crtc *crtc,
@@ -8626,10 +9200,15 @@ static void vop2_crtc_atomic_enable(struct drm_crtc *crtc, struct drm_atomic_sta
 
 	if (old_cstate && old_cstate->self_refresh_active) {
 		vop2_crtc_atomic_exit_psr(crtc, old_cstate);
+		vop2_crtc_account_refresh_rate(vp, vp->refresh_rate);
 
 		return;
 	}
 
+	vp->refresh_rate = drm_mode_vrefresh(adjusted_mode);
+	vp->vrr_idle = false;
+	vop2_crtc_account_refresh_rate(vp, vp->refresh_rate);
+
 	vop2->active_vp_mask |= BIT(vp->id);
 	vop2_set_system_status(vop2);
 	rockchip_request_late_resume();
@@ -9209,6 +9788,8 @@ static int vop2_crtc_atomic_check(struct drm_crtc *crtc,
 
 	vop2_update_post_csc_info(vp, new_vcstate, old_vcstate);
 
+	new_vcstate->line_bw_mbyte = vop2_crtc_estimate_bandwidth(crtc, new_crtc_state);
+
 	if (vop2_update_acm_info(vp, new_vcstate, old_vcstate) ||
 	    new_crtc_state->active_changed)
 		vp->acm_state_changed = true;
@@ -9242,6 +9823,53 @@ static void vop3_disable_dynamic_hdr(struct vop2_video_port *vp, uint8_t win_phy
 	vpstate->hdr2sdr_en = false;
 }
 
+/*
+ * The gamma curves are rewritten by every commit with metadata attached but
+ * rarely change, only touch the registers which differ. The register backup
+ * is reloaded from the hardware when the vop powers up.
+ */
+static void vop2_writel_table(struct vop2 *vop2, uint32_t offset,
+			      const uint32_t *tab, int len)
+{
+	int i;
+
+	for (i = 0; i < len; i++) {
+		if (vop2->regsbak[(offset >> 2) + i] != tab[i])
+			vop2_writel(vop2, offset + i * 4, tab[i]);
+	}
+}
+
+/*
+ * The tone lut is fetched by the lut dma while the frame is scanned out, so
+ * it must never be rewritten in place. Keep a few banks of recent tables:
+ * a table seen before is reused as is, a new one goes to the least recently
+ * used bank, which is neither the one being scanned out nor the pending one.
+ */
+static dma_addr_t vop3_get_hdr_lut_bank(struct vop2_video_port *vp, const uint32_t *tab)
+{
+	size_t size = RK_HDRVIVID_TONE_SCA_AXI_TAB_LENGTH * 4;
+	u32 *kvaddr = vp->hdr_lut_gem_obj->kvaddr;
+	u32 hash = jhash2(tab, RK_HDRVIVID_TONE_SCA_AXI_TAB_LENGTH, 0) ?: 1;
+	int i, bank = 0;
+
+	for (i = 0; i < VOP2_HDR_LUT_BANKS; i++) {
+		if (vp->hdr_lut_hash[i] == hash &&
+		    !memcmp(kvaddr + i * RK_HDRVIVID_TONE_SCA_AXI_TAB_LENGTH, tab, size)) {
+			bank = i;
+			goto out;
+		}
+		if ((s32)(vp->hdr_lut_stamp[i] - vp->hdr_lut_stamp[bank]) < 0)
+			bank = i;
+	}
+
+	memcpy(kvaddr + bank * RK_HDRVIVID_TONE_SCA_AXI_TAB_LENGTH, tab, size);
+	vp->hdr_lut_hash[bank] = hash;
+out:
+	vp->hdr_lut_stamp[bank] = ++vp->hdr_lut_seq;
+
+	return vp->hdr_lut_gem_obj->dma_addr + bank * size;
+}
+
 static void vop3_setup_hdrvivid(struct vop2_video_port *vp, uint8_t win_phys_id)
 {
 	struct vop2 *vop2 = vp->vop2;
@@ -9258,8 +9886,6 @@ static void vop3_setup_hdrvivid(struct vop2_video_port *vp, uint8_t win_phys_id)
 	struct rockchip_gem_object *lut_gem_obj;
 	bool have_sdr_layer = false;
 	uint32_t hdr_mode;
-	int i;
-	u32 *tone_lut_kvaddr;
 	dma_addr_t tone_lut_mst;
 
 	vp->hdr_en = false;
@@ -9372,19 +9998,19 @@ static void vop3_setup_hdrvivid(struct vop2_video_port *vp, uint8_t win_phys_id)
 
 	if (!vp->hdr_lut_gem_obj) {
 		lut_gem_obj = rockchip_gem_create_object(vop2->drm_dev,
-			RK_HDRVIVID_TONE_SCA_AXI_TAB_LENGTH * 4, true, 0);
+			RK_HDRVIVID_TONE_SCA_AXI_TAB_LENGTH * 4 * VOP2_HDR_LUT_BANKS,
+			true, 0);
 		if (IS_ERR(lut_gem_obj)) {
 			DRM_ERROR("create hdr lut obj failed\n");
 			return;
 		}
 		vp->hdr_lut_gem_obj = lut_gem_obj;
+		memset(vp->hdr_lut_hash, 0, sizeof(vp->hdr_lut_hash));
+		memset(vp->hdr_lut_stamp, 0, sizeof(vp->hdr_lut_stamp));
+		vp->hdr_lut_seq = 0;
 	}
 
-	tone_lut_kvaddr = (u32 *)vp->hdr_lut_gem_obj->kvaddr;
-	tone_lut_mst = vp->hdr_lut_gem_obj->dma_addr;
-
-	for (i = 0; i < RK_HDRVIVID_TONE_SCA_AXI_TAB_LENGTH; i++)
-		*tone_lut_kvaddr++ =  hdrvivid_data->tone_sca_axi_tab[i];
+	tone_lut_mst = vop3_get_hdr_lut_bank(vp, hdrvivid_data->tone_sca_axi_tab);
 
 	VOP_MODULE_SET(vop2, vp, lut_dma_rid, vp->lut_dma_rid - vp->id);
 	VOP_MODULE_SET(vop2, vp, hdr_lut_mode, 1);
@@ -9392,27 +10018,18 @@ static void vop3_setup_hdrvivid(struct vop2_video_port *vp, uint8_t win_phys_id)
 	VOP_MODULE_SET(vop2, vp, hdr_lut_update_en, 1);
 	VOP_CTRL_SET(vop2, lut_dma_en, 1);
 
-	for (i = 0; i < RK_HDRVIVID_GAMMA_CURVE_LENGTH; i++)
-		vop2_writel(vop2, RK3528_HDRGAMMA_CURVE + i * 4, hdrvivid_data->hdrgamma_curve[i]);
-
-	for (i = 0; i < RK_HDRVIVID_GAMMA_MDFVALUE_LENGTH; i++)
-		vop2_writel(vop2, RK3528_HDRGAMMA_MDFVALUE + i * 4,
-			    hdrvivid_data->hdrgamma_mdfvalue[i]);
-
-	for (i = 0; i < RK_SDR2HDR_INVGAMMA_CURVE_LENGTH; i++)
-		vop2_writel(vop2, RK3528_SDRINVGAMMA_CURVE + i * 4,
-			    hdrvivid_data->sdrinvgamma_curve[i]);
-
-	for (i = 0; i < RK_SDR2HDR_INVGAMMA_S_IDX_LENGTH; i++)
-		vop2_writel(vop2, RK3528_SDRINVGAMMA_STARTIDX + i * 4,
-			    hdrvivid_data->sdrinvgamma_startidx[i]);
-
-	for (i = 0; i < RK_SDR2HDR_INVGAMMA_C_IDX_LENGTH; i++)
-		vop2_writel(vop2, RK3528_SDRINVGAMMA_CHANGEIDX + i * 4,
-			    hdrvivid_data->sdrinvgamma_changeidx[i]);
-
-	for (i = 0; i < RK_SDR2HDR_SMGAIN_LENGTH; i++)
-		vop2_writel(vop2, RK3528_SDR_SMGAIN + i * 4, hdrvivid_data->sdr_smgain[i]);
+	vop2_writel_table(vop2, RK3528_HDRGAMMA_CURVE, hdrvivid_data->hdrgamma_curve,
+			  RK_HDRVIVID_GAMMA_CURVE_LENGTH);
+	vop2_writel_table(vop2, RK3528_HDRGAMMA_MDFVALUE, hdrvivid_data->hdrgamma_mdfvalue,
+			  RK_HDRVIVID_GAMMA_MDFVALUE_LENGTH);
+	vop2_writel_table(vop2, RK3528_SDRINVGAMMA_CURVE, hdrvivid_data->sdrinvgamma_curve,
+			  RK_SDR2HDR_INVGAMMA_CURVE_LENGTH);
+	vop2_writel_table(vop2, RK3528_SDRINVGAMMA_STARTIDX, hdrvivid_data->sdrinvgamma_startidx,
+			  RK_SDR2HDR_INVGAMMA_S_IDX_LENGTH);
+	vop2_writel_table(vop2, RK3528_SDRINVGAMMA_CHANGEIDX, hdrvivid_data->sdrinvgamma_changeidx,
+			  RK_SDR2HDR_INVGAMMA_C_IDX_LENGTH);
+	vop2_writel_table(vop2, RK3528_SDR_SMGAIN, hdrvivid_data->sdr_smgain,
+			  RK_SDR2HDR_SMGAIN_LENGTH);
 }
 
 static void vop3_setup_dynamic_hdr(struct vop2_video_port *vp, uint8_t win_phys_id)
@@ -10483,7 +11100,19 @@ static void rk3588_vop2_setup_hdr10_splice_layer_mixer(struct drm_crtc *crtc,
 	kfree(vop2_zpos_splice_hdr);
 }
 
-static void vop2_crtc_update_vrr(struct drm_crtc *crtc)
+static void vop2_crtc_account_refresh_rate(struct vop2_video_port *vp, unsigned int rate)
+{
+	struct vop2_frame_stats *stats = &vp->stats;
+	ktime_t now = ktime_get();
+
+	if (stats->refresh_rate_since)
+		stats->refresh_time_ms[stats->refresh_rate] += ktime_ms_delta(now,
+									     stats->refresh_rate_since);
+	stats->refresh_rate = min_t(unsigned int, rate, VOP2_MAX_REFRESH_RATE);
+	stats->refresh_rate_since = now;
+}
+
+static void vop2_crtc_set_refresh_rate(struct drm_crtc *crtc, unsigned int rate)
 {
 	struct rockchip_crtc_state *vcstate = to_rockchip_crtc_state(crtc->state);
 	struct vop2_video_port *vp = to_vop2_video_port(crtc);
@@ -10493,22 +11122,10 @@ static void vop2_crtc_update_vrr(struct drm_crtc *crtc)
 	unsigned int vrefresh;
 	unsigned int new_vtotal, vfp, new_vfp;
 
-	if (!vp->refresh_rate_change)
-		return;
-
-	if (!vcstate->min_refresh_rate || !vcstate->max_refresh_rate)
-		return;
-
-	if (vcstate->request_refresh_rate < vcstate->min_refresh_rate ||
-	    vcstate->request_refresh_rate > vcstate->max_refresh_rate) {
-		DRM_ERROR("invalid rate:%d\n", vcstate->request_refresh_rate);
-		return;
-	}
-
 	vrefresh = drm_mode_vrefresh(adjust_mode);
 
 	/* calculate new vfp for new refresh rate */
-	new_vtotal = adjust_mode->vtotal * vrefresh / vcstate->request_refresh_rate;
+	new_vtotal = adjust_mode->vtotal * vrefresh / rate;
 	vfp = adjust_mode->vsync_start -  adjust_mode->vdisplay;
 	new_vfp = vfp + new_vtotal - adjust_mode->vtotal;
 
@@ -10530,6 +11147,112 @@ static void vop2_crtc_update_vrr(struct drm_crtc *crtc)
 
 	/* config all connectors attach to this crtc */
 	rockchip_connector_update_vfp_for_vrr(crtc, adjust_mode, new_vfp);
+
+	vp->refresh_rate = rate;
+	vop2_crtc_account_refresh_rate(vp, rate);
+}
+
+static void vop2_crtc_update_vrr(struct drm_crtc *crtc)
+{
+	struct rockchip_crtc_state *vcstate = to_rockchip_crtc_state(crtc->state);
+	struct vop2_video_port *vp = to_vop2_video_port(crtc);
+
+	if (!vp->refresh_rate_change)
+		return;
+
+	if (!vcstate->min_refresh_rate || !vcstate->max_refresh_rate)
+		return;
+
+	if (vcstate->request_refresh_rate < vcstate->min_refresh_rate ||
+	    vcstate->request_refresh_rate > vcstate->max_refresh_rate) {
+		DRM_ERROR("invalid rate:%d\n", vcstate->request_refresh_rate);
+		return;
+	}
+
+	vop2_crtc_set_refresh_rate(crtc, vcstate->request_refresh_rate);
+	vp->vrr_idle = false;
+}
+
+static bool vop2_crtc_has_damage(struct drm_crtc *crtc, struct drm_atomic_state *state)
+{
+	struct drm_crtc_state *crtc_state = drm_atomic_get_new_crtc_state(state, crtc);
+	struct drm_plane_state *old_pstate, *new_pstate;
+	struct drm_plane *plane;
+	struct drm_rect damage;
+	int i;
+
+	if (drm_atomic_crtc_needs_modeset(crtc_state) || crtc_state->color_mgmt_changed)
+		return true;
+
+	for_each_oldnew_plane_in_state(state, plane, old_pstate, new_pstate, i) {
+		if (old_pstate->crtc != crtc && new_pstate->crtc != crtc)
+			continue;
+
+		if (old_pstate->visible != new_pstate->visible)
+			return true;
+
+		/* a plane without FB_DAMAGE_CLIPS is fully damaged */
+		if (drm_atomic_helper_damage_merged(old_pstate, new_pstate, &damage))
+			return true;
+	}
+
+	return false;
+}
+
+/*
+ * Restore the full refresh rate on a commit with damage and restart the
+ * idle timer, commits without damage let the timer expire.
+ */
+static void vop2_crtc_update_vrr_idle(struct drm_crtc *crtc, struct drm_atomic_state *state)
+{
+	struct rockchip_crtc_state *vcstate = to_rockchip_crtc_state(crtc->state);
+	struct vop2_video_port *vp = to_vop2_video_port(crtc);
+	unsigned int rate;
+	int idle_ms = READ_ONCE(vrr_idle_ms);
+
+	if (!vcstate->min_refresh_rate || !vcstate->max_refresh_rate)
+		return;
+
+	if (!vop2_crtc_has_damage(crtc, state))
+		return;
+
+	if (vp->vrr_idle) {
+		rate = vcstate->request_refresh_rate;
+		if (rate < vcstate->min_refresh_rate || rate > vcstate->max_refresh_rate)
+			rate = drm_mode_vrefresh(&crtc->state->adjusted_mode);
+		vop2_crtc_set_refresh_rate(crtc, rate);
+		vp->vrr_idle = false;
+	}
+
+	if (idle_ms > 0)
+		mod_delayed_work(system_wq, &vp->vrr_idle_work, msecs_to_jiffies(idle_ms));
+}
+
+static void vop2_crtc_vrr_idle_work(struct work_struct *work)
+{
+	struct vop2_video_port *vp = container_of(to_delayed_work(work),
+						  struct vop2_video_port, vrr_idle_work);
+	struct drm_crtc *crtc = &vp->rockchip_crtc.crtc;
+	struct vop2 *vop2 = vp->vop2;
+	struct rockchip_crtc_state *vcstate;
+
+	/* crtc->state can't be swapped while the crtc lock is held */
+	drm_modeset_lock(&crtc->mutex, NULL);
+	vop2_lock(vop2);
+	vcstate = to_rockchip_crtc_state(crtc->state);
+	/*
+	 * The vtotal of a variable refresh rate output takes effect immediately
+	 * (sw_dsp_vtotal_imd), so no cfg_done which may catch a half written
+	 * commit is needed here.
+	 */
+	if (vop2->is_enabled && crtc->state->active && !crtc->state->self_refresh_active &&
+	    !vp->vrr_idle && vcstate->min_refresh_rate && vcstate->max_refresh_rate &&
+	    vp->refresh_rate > vcstate->min_refresh_rate) {
+		vop2_crtc_set_refresh_rate(crtc, vcstate->min_refresh_rate);
+		vp->vrr_idle = true;
+	}
+	vop2_unlock(vop2);
+	drm_modeset_unlock(&crtc->mutex);
 }
 
 static bool post_sharp_enabled(struct drm_crtc *crtc)
@@ -10572,6 +11295,8 @@ static void vop2_crtc_atomic_begin(struct drm_crtc *crtc, struct drm_atomic_stat
 	bool hdr10_at_splice_mode = false;
 	struct rockchip_crtc_state *vcstate = to_rockchip_crtc_state(crtc->state);
 
+	vp->stats.begin_time = ktime_get();
+
 	/* sharp must work in yuv color space */
 	if (post_sharp_enabled(crtc))
 		vcstate->yuv_overlay = true;
@@ -10587,8 +11312,12 @@ static void vop2_crtc_atomic_begin(struct drm_crtc *crtc, struct drm_atomic_stat
 			goto out;
 	}
 
-	if (vop2->version == VOP_VERSION_RK3588)
+	if (vop2->version == VOP_VERSION_RK3588) {
+		vop2_lock(vop2);
 		vop2_crtc_update_vrr(crtc);
+		vop2_crtc_update_vrr_idle(crtc, state);
+		vop2_unlock(vop2);
+	}
 
 	/* Process cluster sub windows overlay. */
 	drm_atomic_crtc_for_each_plane(plane, crtc) {
@@ -10884,8 +11613,9 @@ static void vop3_post_csc_config(struct drm_crtc *crtc, struct post_acm *acm, st
 	struct vop2 *vop2 = vp->vop2;
 	struct drm_plane *plane;
 	struct drm_plane_state *pstate;
-	struct post_csc_coef csc_coef;
-	struct post_csc_convert_mode convert_mode;
+	struct post_csc_coef *csc_coef = &vp->post_csc_coef;
+	struct post_csc_convert_mode convert_mode = {};
+	struct post_csc csc_key = {};
 	bool acm_enable;
 	bool post_r2y_en = false;
 	bool post_csc_en = false;
@@ -10952,22 +11682,33 @@ static void vop3_post_csc_config(struct drm_crtc *crtc, struct post_acm *acm, st
 			convert_mode.color_encoding = pstate->color_encoding;
 		else
 			convert_mode.color_encoding = vcstate->color_encoding;
-		rockchip_calc_post_csc(csc, &csc_coef, &convert_mode);
-
-		VOP_MODULE_SET(vop2, vp, csc_coe00, csc_coef.csc_coef00);
-		VOP_MODULE_SET(vop2, vp, csc_coe01, csc_coef.csc_coef01);
-		VOP_MODULE_SET(vop2, vp, csc_coe02, csc_coef.csc_coef02);
-		VOP_MODULE_SET(vop2, vp, csc_coe10, csc_coef.csc_coef10);
-		VOP_MODULE_SET(vop2, vp, csc_coe11, csc_coef.csc_coef11);
-		VOP_MODULE_SET(vop2, vp, csc_coe12, csc_coef.csc_coef12);
-		VOP_MODULE_SET(vop2, vp, csc_coe20, csc_coef.csc_coef20);
-		VOP_MODULE_SET(vop2, vp, csc_coe21, csc_coef.csc_coef21);
-		VOP_MODULE_SET(vop2, vp, csc_coe22, csc_coef.csc_coef22);
-		VOP_MODULE_SET(vop2, vp, csc_offset0, csc_coef.csc_dc0);
-		VOP_MODULE_SET(vop2, vp, csc_offset1, csc_coef.csc_dc1);
-		VOP_MODULE_SET(vop2, vp, csc_offset2, csc_coef.csc_dc2);
-
-		range_type = csc_coef.range_type ? 0 : 1;
+
+		/* the coefficient calculation is costly, only redo it on change */
+		if (csc)
+			csc_key = *csc;
+		if (!vp->post_csc_coef_valid ||
+		    memcmp(&vp->post_csc_key, &csc_key, sizeof(csc_key)) ||
+		    memcmp(&vp->post_csc_mode_key, &convert_mode, sizeof(convert_mode))) {
+			rockchip_calc_post_csc(csc, csc_coef, &convert_mode);
+			vp->post_csc_key = csc_key;
+			vp->post_csc_mode_key = convert_mode;
+			vp->post_csc_coef_valid = true;
+		}
+
+		VOP_MODULE_SET(vop2, vp, csc_coe00, csc_coef->csc_coef00);
+		VOP_MODULE_SET(vop2, vp, csc_coe01, csc_coef->csc_coef01);
+		VOP_MODULE_SET(vop2, vp, csc_coe02, csc_coef->csc_coef02);
+		VOP_MODULE_SET(vop2, vp, csc_coe10, csc_coef->csc_coef10);
+		VOP_MODULE_SET(vop2, vp, csc_coe11, csc_coef->csc_coef11);
+		VOP_MODULE_SET(vop2, vp, csc_coe12, csc_coef->csc_coef12);
+		VOP_MODULE_SET(vop2, vp, csc_coe20, csc_coef->csc_coef20);
+		VOP_MODULE_SET(vop2, vp, csc_coe21, csc_coef->csc_coef21);
+		VOP_MODULE_SET(vop2, vp, csc_coe22, csc_coef->csc_coef22);
+		VOP_MODULE_SET(vop2, vp, csc_offset0, csc_coef->csc_dc0);
+		VOP_MODULE_SET(vop2, vp, csc_offset1, csc_coef->csc_dc1);
+		VOP_MODULE_SET(vop2, vp, csc_offset2, csc_coef->csc_dc2);
+
+		range_type = csc_coef->range_type ? 0 : 1;
 		range_type <<= convert_mode.is_input_yuv ? 0 : 1;
 		VOP_MODULE_SET(vop2, vp, csc_mode, range_type);
 	}
@@ -11045,9 +11786,10 @@ static void vop3_post_acm_config(struct drm_crtc *crtc, struct post_acm *acm)
 	writel(1, vop2->acm_regs + RK3528_ACM_FETCH_DONE);
 }
 
-static void vop2_post_sharp_config(struct drm_crtc *crtc)
+static void vop2_post_sharp_config(struct drm_crtc *crtc, struct drm_crtc_state *old_cstate)
 {
 	struct rockchip_crtc_state *vcstate = to_rockchip_crtc_state(crtc->state);
+	struct rockchip_crtc_state *old_vcstate = to_rockchip_crtc_state(old_cstate);
 	struct vop2_video_port *vp = to_vop2_video_port(crtc);
 	struct vop2 *vop2 = vp->vop2;
 	struct post_sharp *post_sharp;
@@ -11065,6 +11807,13 @@ static void vop2_post_sharp_config(struct drm_crtc *crtc)
 		return;
 	}
 
+	/* the registers still hold this blob, no need to write them again */
+	if (old_vcstate->sharp_en && old_vcstate->post_sharp_data == vcstate->post_sharp_data &&
+	    !drm_atomic_crtc_needs_modeset(crtc->state)) {
+		vcstate->sharp_en = true;
+		return;
+	}
+
 	post_sharp = (struct post_sharp *)vcstate->post_sharp_data->data;
 
 	for (i = 0; i < SHARP_REG_LENGTH / 4; i++)
@@ -11201,6 +11950,19 @@ static void vop2_wait_for_scan_timing_from_the_assigned_line(struct vop2_video_p
 			      wait_line, vcnt, ret);
 }
 
+static void vop2_frame_stats_commit(struct vop2_video_port *vp)
+{
+	struct vop2_frame_stats *stats = &vp->stats;
+	struct vop2 *vop2 = vp->vop2;
+	u16 vtotal = VOP_MODULE_GET(vop2, vp, dsp_vtotal);
+	u32 vcnt = vop2_read_vcnt(vp);
+	u32 margin = vtotal > vcnt ? vtotal - vcnt : 0;
+
+	vop2_stats_account(stats->commit_hist, stats->begin_time, stats->cfg_done_time);
+	if (!stats->commits++ || margin < stats->min_margin)
+		stats->min_margin = margin;
+}
+
 static void vop2_crtc_atomic_flush(struct drm_crtc *crtc, struct drm_atomic_state *state)
 {
 	struct rockchip_crtc_state *vcstate = to_rockchip_crtc_state(crtc->state);
@@ -11217,6 +11979,8 @@ static void vop2_crtc_atomic_flush(struct drm_crtc *crtc, struct drm_atomic_stat
 	struct drm_connector_state *conn_state = wb_conn->base.state;
 	bool wb_oneframe_mode = VOP_MODULE_GET(vop2, wb, one_frame_mode);
 
+	drm_object_property_set_value(&crtc->base, vp->bandwidth_prop, vcstate->line_bw_mbyte);
+
 	if (conn_state && conn_state->writeback_job && conn_state->writeback_job->fb && !wb_oneframe_mode) {
 		u16 vtotal = VOP_MODULE_GET(vop2, vp, dsp_vtotal);
 		u32 current_line = vop2_read_vcnt(vp);
@@ -11261,16 +12025,24 @@ static void vop2_crtc_atomic_flush(struct drm_crtc *crtc, struct drm_atomic_stat
 				vp->gamma_lut = crtc->state->gamma_lut->data;
 			vop2_crtc_atomic_gamma_set(crtc, crtc->state);
 		}
-		if (vcstate->cubic_lut_data || vp->cubic_lut) {
+		/*
+		 * color_mgmt_changed is set by any color property, only upload
+		 * the 3D lut again when its own blob changed.
+		 */
+		if ((vcstate->cubic_lut_data || vp->cubic_lut) &&
+		    (crtc->state->active_changed ||
+		     vcstate->cubic_lut_data != to_rockchip_crtc_state(old_cstate)->cubic_lut_data)) {
 			if (vcstate->cubic_lut_data)
 				vp->cubic_lut = vcstate->cubic_lut_data->data;
 			vop2_crtc_atomic_cubic_lut_set(crtc, crtc->state);
+		} else {
+			VOP_MODULE_SET(vop2, vp, cubic_lut_update_en, 0);
 		}
 	} else {
 		VOP_MODULE_SET(vop2, vp, cubic_lut_update_en, 0);
 	}
 
-	vop2_post_sharp_config(crtc);
+	vop2_post_sharp_config(crtc, old_cstate);
 
 	if (vcstate->line_flag)
 		vop2_crtc_enable_line_flag_event(crtc, vcstate->line_flag);
@@ -11280,12 +12052,15 @@ static void vop2_crtc_atomic_flush(struct drm_crtc *crtc, struct drm_atomic_stat
 	spin_lock_irqsave(&vop2->irq_lock, flags);
 	vop2_wb_commit(crtc);
 	vop2_cfg_done(crtc);
+	vp->stats.cfg_done_time = ktime_get();
 
 	if (vp->mcu_timing.mcu_pix_total)
 		VOP_MODULE_SET(vop2, vp, mcu_hold_mode, 0);
 
 	spin_unlock_irqrestore(&vop2->irq_lock, flags);
 
+	vop2_frame_stats_commit(vp);
+
 	/*
 	 * There is a (rather unlikely) possibility that a vblank interrupt
 	 * fired before we set the cfg_done bit. To avoid spuriously
@@ -11531,6 +12306,11 @@ static int vop2_crtc_atomic_get_property(struct drm_crtc *crtc,
 		return 0;
 	}
 
+	if (property == vp->bandwidth_prop) {
+		*val = vcstate->line_bw_mbyte;
+		return 0;
+	}
+
 	if (property == vp->hdr_ext_data_prop) {
 		*val = vcstate->hdr_ext_data ? vcstate->hdr_ext_data->base.id : 0;
 		return 0;
@@ -11717,10 +12497,19 @@ static void vop2_handle_vblank(struct vop2 *vop2, struct drm_crtc *crtc)
 {
 	struct drm_device *drm = vop2->drm_dev;
 	struct vop2_video_port *vp = to_vop2_video_port(crtc);
+	struct drm_vblank_crtc *vblank = &drm->vblank[drm_crtc_index(crtc)];
 	unsigned long flags;
 
+	/* let the gpu pace its dvfs windows to the display */
+	if (vblank->framedur_ns > 0)
+		rockchip_system_monitor_vsync(ktime_get(), vblank->framedur_ns);
+
 	spin_lock_irqsave(&drm->event_lock, flags);
 	if (vp->event) {
+		vop2_stats_account(vp->stats.flip_hist, vp->stats.cfg_done_time, ktime_get());
+		vp->stats.flips++;
+		if (!vop2_vp_done_bit_status(vp))
+			vp->stats.missed++;
 		drm_crtc_send_vblank_event(crtc, vp->event);
 		drm_crtc_vblank_put(crtc);
 		vp->event = NULL;
@@ -11783,6 +12572,302 @@ static void vop2_wb_disable(struct vop2_video_port *vp)
 	vop2_wb_cfg_done(vp);
 }
 
+static const char *vop2_wb_fence_get_driver_name(struct dma_fence *fence)
+{
+	return "rockchip-vop2";
+}
+
+static const char *vop2_wb_fence_get_timeline_name(struct dma_fence *fence)
+{
+	return "writeback-ring";
+}
+
+static const struct dma_fence_ops vop2_wb_fence_ops = {
+	.get_driver_name = vop2_wb_fence_get_driver_name,
+	.get_timeline_name = vop2_wb_fence_get_timeline_name,
+};
+
+/* called with job_lock held */
+static void vop2_wb_ring_signal(struct vop2_wb_ring *ring, int index, int error)
+{
+	struct dma_fence *fence = ring->fence[index];
+
+	if (!fence)
+		return;
+
+	ring->fence[index] = NULL;
+	if (error)
+		dma_fence_set_error(fence, error);
+	dma_fence_signal(fence);
+	dma_fence_put(fence);
+}
+
+/*
+ * Called with job_lock held, the caller commits fb_unref_work to drop the
+ * buffers once it has released the lock.
+ */
+static void vop2_wb_ring_release(struct vop2_wb_ring *ring)
+{
+	int i;
+
+	for (i = 0; i < ring->num; i++) {
+		vop2_wb_ring_signal(ring, i, -ECANCELED);
+		drm_flip_work_queue(&ring->fb_unref_work, ring->fb[i]);
+		ring->fb[i] = NULL;
+	}
+	ring->num = 0;
+	ring->writing = -1;
+	ring->prog = -1;
+	ring->stopping = false;
+}
+
+static void vop2_wb_ring_handler(struct vop2_video_port *vp)
+{
+	struct vop2 *vop2 = vp->vop2;
+	struct vop2_wb *wb = &vop2->wb;
+	struct vop2_wb_ring *ring = &wb->ring;
+	unsigned long flags;
+	bool release = false;
+	int next;
+
+	spin_lock_irqsave(&wb->job_lock, flags);
+	if (!ring->num || ring->vp_id != vp->id) {
+		spin_unlock_irqrestore(&wb->job_lock, flags);
+		return;
+	}
+
+	/* the buffer written during the last frame is complete */
+	if (ring->writing >= 0)
+		vop2_wb_ring_signal(ring, ring->writing, 0);
+
+	if (ring->stopping) {
+		/* writeback is disabled from this frame on */
+		vop2_wb_ring_release(ring);
+		release = true;
+	} else {
+		ring->writing = ring->prog;
+		next = (ring->prog + 1) % ring->num;
+		VOP_MODULE_SET(vop2, wb, yrgb_mst, ring->yrgb_addr[next]);
+		VOP_MODULE_SET(vop2, wb, uv_mst, ring->uv_addr[next]);
+		ring->prog = next;
+	}
+	spin_unlock_irqrestore(&wb->job_lock, flags);
+
+	if (release)
+		drm_flip_work_commit(&ring->fb_unref_work, system_unbound_wq);
+	else
+		vop2_wb_cfg_done(vp);
+}
+
+static void vop2_wb_ring_cancel(struct vop2_video_port *vp)
+{
+	struct vop2_wb *wb = &vp->vop2->wb;
+	struct vop2_wb_ring *ring = &wb->ring;
+	unsigned long flags;
+
+	spin_lock_irqsave(&wb->job_lock, flags);
+	if (!ring->num || ring->vp_id != vp->id) {
+		spin_unlock_irqrestore(&wb->job_lock, flags);
+		return;
+	}
+	vop2_wb_ring_release(ring);
+	spin_unlock_irqrestore(&wb->job_lock, flags);
+
+	vop2_wb_disable(vp);
+	drm_flip_work_commit(&ring->fb_unref_work, system_unbound_wq);
+}
+
+static int vop2_wb_ring_stop(struct vop2_video_port *vp)
+{
+	struct vop2_wb *wb = &vp->vop2->wb;
+	struct vop2_wb_ring *ring = &wb->ring;
+	unsigned long flags;
+
+	spin_lock_irqsave(&wb->job_lock, flags);
+	if (!ring->num || ring->vp_id != vp->id || ring->stopping) {
+		spin_unlock_irqrestore(&wb->job_lock, flags);
+		return -EINVAL;
+	}
+	ring->stopping = true;
+	spin_unlock_irqrestore(&wb->job_lock, flags);
+
+	/* the ring is released from the next frame start */
+	vop2_wb_disable(vp);
+
+	return 0;
+}
+
+/*
+ * Start streaming writeback of @crtc into @num buffers, or stop it if
+ * @num is 0. On success the ring owns the references of @fbs.
+ */
+static int vop2_crtc_wb_ring(struct drm_crtc *crtc, struct drm_framebuffer **fbs, int num)
+{
+	struct vop2_video_port *vp = to_vop2_video_port(crtc);
+	struct vop2 *vop2 = vp->vop2;
+	struct vop2_wb *wb = &vop2->wb;
+	struct vop2_wb_ring *ring = &wb->ring;
+	struct vop2_wb_connector_state cfg = {};
+	struct drm_connector_state *conn_state;
+	struct rockchip_crtc_state *vcstate;
+	struct drm_display_mode *mode;
+	struct drm_framebuffer *fb;
+	unsigned long flags;
+	uint8_t r2y;
+	int i, ret = 0;
+
+	if (num < 0 || num == 1 || num > VOP2_WB_RING_MAX)
+		return -EINVAL;
+
+	mutex_lock(&vop2->vop2_lock);
+	if (!num) {
+		ret = vop2_wb_ring_stop(vp);
+		goto out;
+	}
+
+	conn_state = wb->conn.base.state;
+	if (!vop2->is_enabled || !crtc->state->active ||
+	    !conn_state || conn_state->crtc != crtc) {
+		ret = -EINVAL;
+		goto out;
+	}
+
+	if (ring->num) {
+		ret = -EBUSY;
+		goto out;
+	}
+	for (i = 0; i < VOP2_WB_JOB_MAX; i++) {
+		if (wb->jobs[i].pending) {
+			ret = -EBUSY;
+			goto out;
+		}
+	}
+
+	vcstate = to_rockchip_crtc_state(crtc->state);
+	mode = &crtc->state->mode;
+	fb = fbs[0];
+	for (i = 1; i < num; i++) {
+		if (fbs[i]->width != fb->width || fbs[i]->height != fb->height ||
+		    fbs[i]->format != fb->format || fbs[i]->pitches[0] != fb->pitches[0]) {
+			DRM_DEBUG_KMS("writeback ring buffers must have the same layout\n");
+			ret = -EINVAL;
+			goto out;
+		}
+	}
+
+	if (!fb->format->is_yuv && is_yuv_output(vcstate->bus_format)) {
+		DRM_ERROR("YUV2RGB is not supported by writeback\n");
+		ret = -EINVAL;
+		goto out;
+	}
+
+	if ((fb->width > mode->hdisplay) ||
+	    ((fb->height < mode->vdisplay) &&
+	    (fb->height != (mode->vdisplay >> 1)))) {
+		DRM_DEBUG_KMS("Invalid framebuffer size %ux%u, Only support x scale down and 1/2 y scale down\n",
+			      fb->width, fb->height);
+		ret = -EINVAL;
+		goto out;
+	}
+
+	cfg.format = vop2_convert_wb_format(fb->format->format);
+	if (cfg.format < 0) {
+		DRM_DEBUG_KMS("Invalid pixel format %p4cc\n", &fb->format->format);
+		ret = -EINVAL;
+		goto out;
+	}
+	cfg.scale_x_factor = vop2_scale_factor(SCALE_DOWN, VOP2_SCALE_DOWN_BIL,
+					       mode->hdisplay, fb->width);
+	cfg.scale_x_en = (fb->width < mode->hdisplay) ? 1 : 0;
+	cfg.scale_y_en = (fb->height < mode->vdisplay) ? 1 : 0;
+	cfg.vp_id = vp->id;
+	r2y = !vcstate->yuv_overlay && fb->format->is_yuv;
+
+	spin_lock_irqsave(&wb->job_lock, flags);
+	for (i = 0; i < num; i++) {
+		ring->fb[i] = fbs[i];
+		ring->yrgb_addr[i] = to_rockchip_obj(fbs[i]->obj[0])->dma_addr +
+				     fbs[i]->offsets[0];
+		if (fb->format->is_yuv)
+			ring->uv_addr[i] = to_rockchip_obj(fbs[i]->obj[1])->dma_addr +
+					   fbs[i]->offsets[1];
+		else
+			ring->uv_addr[i] = 0;
+	}
+	ring->num = num;
+	ring->vp_id = vp->id;
+	ring->writing = -1;
+	ring->prog = 0;
+	ring->stopping = false;
+
+	cfg.yrgb_addr = ring->yrgb_addr[0];
+	cfg.uv_addr = ring->uv_addr[0];
+	vop2_wb_config(vop2, fb, &cfg, r2y, false);
+	spin_unlock_irqrestore(&wb->job_lock, flags);
+
+	vop2_wb_cfg_done(vp);
+	rockchip_drm_dbg(vop2->dev, VOP_DEBUG_WB, "Start wb ring of %d %ux%u buffers on vp%d\n",
+			 num, fb->width, fb->height, vp->id);
+out:
+	mutex_unlock(&vop2->vop2_lock);
+
+	return ret;
+}
+
+/*
+ * Return a sync_file fd which signals when the next fill of ring buffer
+ * @index is complete, or with -ECANCELED if the ring stops before.
+ */
+static int vop2_crtc_wb_ring_fence(struct drm_crtc *crtc, u32 index)
+{
+	struct vop2_video_port *vp = to_vop2_video_port(crtc);
+	struct vop2_wb *wb = &vp->vop2->wb;
+	struct vop2_wb_ring *ring = &wb->ring;
+	struct dma_fence *fence, *new_fence;
+	struct sync_file *sync_file;
+	unsigned long flags;
+	int fd;
+
+	new_fence = kzalloc(sizeof(*new_fence), GFP_KERNEL);
+	if (!new_fence)
+		return -ENOMEM;
+
+	spin_lock_irqsave(&wb->job_lock, flags);
+	if (!ring->num || ring->stopping || ring->vp_id != vp->id || index >= ring->num) {
+		spin_unlock_irqrestore(&wb->job_lock, flags);
+		kfree(new_fence);
+		return -EINVAL;
+	}
+
+	fence = ring->fence[index];
+	if (!fence) {
+		dma_fence_init(new_fence, &vop2_wb_fence_ops, &ring->fence_lock,
+			       ring->fence_context + index, ++ring->fence_seqno[index]);
+		ring->fence[index] = new_fence;
+		fence = new_fence;
+		new_fence = NULL;
+	}
+	dma_fence_get(fence);
+	spin_unlock_irqrestore(&wb->job_lock, flags);
+	kfree(new_fence);
+
+	fd = get_unused_fd_flags(O_CLOEXEC);
+	if (fd < 0)
+		goto out;
+
+	sync_file = sync_file_create(fence);
+	if (!sync_file) {
+		put_unused_fd(fd);
+		fd = -ENOMEM;
+		goto out;
+	}
+	fd_install(fd, sync_file->file);
+out:
+	dma_fence_put(fence);
+
+	return fd;
+}
+
 static void vop2_wb_handler(struct vop2_video_port *vp)
 {
 	struct vop2 *vop2 = vp->vop2;
@@ -11798,6 +12883,12 @@ static void vop2_wb_handler(struct vop2_video_port *vp)
 	wb_vp_id = VOP_MODULE_GET(vop2, wb, vp_id);
 	if (wb_vp_id != vp->id)
 		return;
+
+	if (READ_ONCE(wb->ring.num)) {
+		vop2_wb_ring_handler(vp);
+		return;
+	}
+
 	/*
 	 * The write back should work in one shot mode,
 	 * stop when write back complete in next vsync.
@@ -11877,9 +12968,10 @@ static irqreturn_t vop2_isr(int irq, void *data)
 #define ERROR_HANDLER(x) \
 	do { \
 		if (active_irqs & x##_INTR) {\
-			if (x##_INTR == POST_BUF_EMPTY_INTR) \
+			if (x##_INTR == POST_BUF_EMPTY_INTR) { \
+				atomic_inc(&vp->post_buf_empty_count); \
 				DRM_DEV_ERROR_RATELIMITED(vop2->dev, #x " irq err at vp%d\n", vp->id); \
-			else \
+			} else \
 				DRM_DEV_ERROR_RATELIMITED(vop2->dev, #x " irq err\n"); \
 			active_irqs &= ~x##_INTR; \
 			ret = IRQ_HANDLED; \
@@ -11944,6 +13036,7 @@ static irqreturn_t vop2_isr(int irq, void *data)
 
 		if (active_irqs & FS_FIELD_INTR) {
 			rockchip_drm_dbg(vop2->dev, VOP_DEBUG_VSYNC, "vsync_vp%d\n", vp->id);
+			rk_fr_log(RK_FR_SRC_VOP2, RK_FR_EV_IRQ, vp->id, vp_irqs[i]);
 			vop2_wb_handler(vp);
 			if (likely(!vp->skip_vsync) || (vp->layer_sel_update == false)) {
 				drm_crtc_handle_vblank(crtc);
@@ -12110,6 +13203,7 @@ static irqreturn_t vop3_vp_isr(int irq, void *data)
 	}
 
 	if (active_irqs & POST_BUF_EMPTY_INTR) {
+		atomic_inc(&vp->post_buf_empty_count);
 		DRM_DEV_ERROR_RATELIMITED(vop2->dev, "POST_BUF_EMPTY_INTR irq err at vp%d\n", vp->id);
 		active_irqs &= ~POST_BUF_EMPTY_INTR;
 		ret = IRQ_HANDLED;
@@ -12308,6 +13402,7 @@ static int vop2_plane_init(struct vop2 *vop2, struct vop2_win *win, unsigned lon
 	drm_plane_create_alpha_property(&win->base);
 	drm_plane_create_blend_mode_property(&win->base, blend_caps);
 	drm_plane_create_zpos_property(&win->base, win->win_id, 0, vop2->registered_num_wins - 1);
+	drm_plane_enable_fb_damage_clips(&win->base);
 	vop2_plane_create_name_property(vop2, win);
 	vop2_plane_create_feature_property(vop2, win);
 	if (win->feature & WIN_FEATURE_DCI)
@@ -12545,6 +13640,15 @@ static int vop2_crtc_create_feature_property(struct vop2 *vop2, struct drm_crtc
 	vp->output_dclk_prop = prop;
 	drm_object_attach_property(&crtc->base, vp->output_dclk_prop, 0);
 
+	prop = drm_property_create_range(vop2->drm_dev, DRM_MODE_PROP_IMMUTABLE, "BANDWIDTH",
+					 0, U32_MAX);
+	if (!prop) {
+		DRM_DEV_ERROR(vop2->dev, "create BANDWIDTH prop for vp%d failed\n", vp->id);
+		return -ENOMEM;
+	}
+	vp->bandwidth_prop = prop;
+	drm_object_attach_property(&crtc->base, vp->bandwidth_prop, 0);
+
 	return 0;
 }
 
@@ -12553,7 +13657,8 @@ static int vop2_crtc_create_vrr_property(struct vop2 *vop2, struct drm_crtc *crt
 	struct vop2_video_port *vp = to_vop2_video_port(crtc);
 	struct drm_property *prop;
 
-	prop = drm_property_create_range(vop2->drm_dev, 0, "variable refresh rate", 0, 144);
+	prop = drm_property_create_range(vop2->drm_dev, 0, "variable refresh rate", 0,
+					 VOP2_MAX_REFRESH_RATE);
 	if (!prop) {
 		DRM_DEV_ERROR(vop2->dev, "create vrr prop for vp%d failed\n", vp->id);
 		return -ENOMEM;
@@ -12561,7 +13666,8 @@ static int vop2_crtc_create_vrr_property(struct vop2 *vop2, struct drm_crtc *crt
 	vp->variable_refresh_rate_prop = prop;
 	drm_object_attach_property(&crtc->base, vp->variable_refresh_rate_prop, 0);
 
-	prop = drm_property_create_range(vop2->drm_dev, 0, "max refresh rate", 0, 144);
+	prop = drm_property_create_range(vop2->drm_dev, 0, "max refresh rate", 0,
+					 VOP2_MAX_REFRESH_RATE);
 	if (!prop) {
 		DRM_DEV_ERROR(vop2->dev, "create vrr prop for vp%d failed\n", vp->id);
 		return -ENOMEM;
@@ -12569,7 +13675,8 @@ static int vop2_crtc_create_vrr_property(struct vop2 *vop2, struct drm_crtc *crt
 	vp->max_refresh_rate_prop = prop;
 	drm_object_attach_property(&crtc->base, vp->max_refresh_rate_prop, 0);
 
-	prop = drm_property_create_range(vop2->drm_dev, 0, "min refresh rate", 0, 144);
+	prop = drm_property_create_range(vop2->drm_dev, 0, "min refresh rate", 0,
+					 VOP2_MAX_REFRESH_RATE);
 	if (!prop) {
 		DRM_DEV_ERROR(vop2->dev, "create vrr prop for vp%d failed\n", vp->id);
 		return -ENOMEM;
@@ -12874,6 +13981,7 @@ static int vop2_create_crtc(struct vop2 *vop2, uint8_t enabled_vp_mask)
 		drm_crtc_helper_add(crtc, &vop2_crtc_helper_funcs);
 
 		drm_flip_work_init(&vp->fb_unref_work, "fb_unref", vop2_fb_unref_worker);
+		INIT_DELAYED_WORK(&vp->vrr_idle_work, vop2_crtc_vrr_idle_work);
 
 		init_completion(&vp->dsp_hold_completion);
 		init_completion(&vp->line_flag_completion);
@@ -12992,6 +14100,7 @@ static void vop2_destroy_crtc(struct drm_crtc *crtc)
 {
 	struct vop2_video_port *vp = to_vop2_video_port(crtc);
 
+	cancel_delayed_work_sync(&vp->vrr_idle_work);
 	drm_self_refresh_helper_cleanup(crtc);
 	if (vp->hdr_lut_gem_obj)
 		rockchip_gem_free_object(&vp->hdr_lut_gem_obj->base);
@@ -53,8 +53,24 @@ struct vvop {
 	uint32_t crtc_mask;
 };
 
+/*
+ * Besides rgb, accept the layouts the video encoders read natively, so a
+ * headless output can be handed to the encoder without a conversion pass.
+ */
 static const u32 vvop_formats[] = {
 	DRM_FORMAT_XRGB8888,
+	DRM_FORMAT_ARGB8888,
+	DRM_FORMAT_XBGR8888,
+	DRM_FORMAT_ABGR8888,
+	DRM_FORMAT_RGB888,
+	DRM_FORMAT_BGR888,
+	DRM_FORMAT_RGB565,
+	DRM_FORMAT_NV12,
+	DRM_FORMAT_NV21,
+	DRM_FORMAT_NV16,
+	DRM_FORMAT_NV24,
+	DRM_FORMAT_YUYV,
+	DRM_FORMAT_UYVY,
 };
 
 #define drm_crtc_to_vvop_crtc(crtc) \
@@ -135,6 +151,34 @@ static void vvop_disable_vblank(struct drm_crtc *crtc)
 	hrtimer_try_to_cancel(&vcrtc->vblank_hrtimer);
 }
 
+/*
+ * Report the hrtimer expiry rather than the time the callback ran, so the
+ * vblank timestamps and page flip events follow the mode cadence exactly
+ * instead of carrying the timer latency, which consumers pacing an encoder
+ * from the flip events would otherwise see as jitter.
+ */
+static bool vvop_get_vblank_timestamp(struct drm_crtc *crtc, int *max_error,
+				      ktime_t *vblank_time, bool in_vblank_irq)
+{
+	struct vvop_crtc *vcrtc = drm_crtc_to_vvop_crtc(crtc);
+	struct drm_device *dev = crtc->dev;
+	struct drm_vblank_crtc *vblank = &dev->vblank[drm_crtc_index(crtc)];
+
+	if (!READ_ONCE(vblank->enabled)) {
+		*vblank_time = ktime_get();
+		return true;
+	}
+
+	*vblank_time = READ_ONCE(vcrtc->vblank_hrtimer.node.expires);
+	if (WARN_ON(*vblank_time == vblank->time))
+		return true;
+
+	/* the timer is forwarded before the vblank is handled */
+	*vblank_time -= vcrtc->period_ns;
+
+	return true;
+}
+
 static void vvop_connector_destroy(struct drm_connector *connector)
 {
 	drm_connector_unregister(connector);
@@ -396,6 +440,7 @@ static const struct drm_crtc_funcs vvop_crtc_funcs = {
 	.atomic_destroy_state	= drm_atomic_helper_crtc_destroy_state,
 	.enable_vblank		= vvop_enable_vblank,
 	.disable_vblank		= vvop_disable_vblank,
+	.get_vblank_timestamp	= vvop_get_vblank_timestamp,
 };
 
 static void vvop_crtc_atomic_enable(struct drm_crtc *crtc,
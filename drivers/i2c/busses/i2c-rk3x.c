@@ -101,6 +101,7 @@ enum {
 
 /* Constants */
 #define WAIT_TIMEOUT      200 /* ms */
+#define MAX_SPIN_US       2000 /* us */
 #define DEFAULT_SCL_RATE  (100 * 1000) /* Hz */
 
 /**
@@ -181,6 +182,33 @@ enum rk3x_i2c_state {
 	STATE_STOP
 };
 
+/* Upper bounds in us of the transfer latency histogram, last one is open */
+static const unsigned int rk3x_i2c_lat_bounds[] = { 100, 200, 500, 1000, 5000 };
+
+#define RK3X_I2C_LAT_BUCKETS (ARRAY_SIZE(rk3x_i2c_lat_bounds) + 1)
+
+/**
+ * struct rk3x_i2c_stats - transfer statistics of an adapter
+ * @xfers: number of i2c_transfer() calls
+ * @msgs: number of messages in those calls
+ * @errors: transfers failed with a NACK or bus error
+ * @timeouts: transfers which timed out
+ * @spin_done: transfers completed within the spin wait
+ * @total_us: sum of transfer latencies
+ * @max_us: worst transfer latency
+ * @hist: transfer latency histogram, see rk3x_i2c_lat_bounds
+ */
+struct rk3x_i2c_stats {
+	u64 xfers;
+	u64 msgs;
+	u64 errors;
+	u64 timeouts;
+	u64 spin_done;
+	u64 total_us;
+	u32 max_us;
+	u64 hist[RK3X_I2C_LAT_BUCKETS];
+};
+
 /**
  * struct rk3x_i2c_soc_data - SOC-specific data
  * @grf_offset: offset inside the grf regmap for setting the i2c type
@@ -205,6 +233,9 @@ struct rk3x_i2c_soc_data {
  * @lock: spinlock for the i2c bus
  * @wait: the waitqueue to wait for i2c transfer
  * @busy: the condition for the event to wait for
+ * @msgs: messages of the current transfer
+ * @num: number of messages in @msgs
+ * @msg_idx: index of the next message to start
  * @msg: current i2c message
  * @addr: addr of i2c slave device
  * @mode: mode of i2c transfer
@@ -215,6 +246,8 @@ struct rk3x_i2c_soc_data {
  * @i2c_restart_nb: make sure the i2c transfer to be finished
  * @system_restarting: true if system is restarting
  * @tb_cl: client for rockchip thunder boot service
+ * @spin_us: busy wait budget before sleeping on a transfer, 0 to always sleep
+ * @stats: transfer statistics
  */
 struct rk3x_i2c {
 	struct i2c_adapter adap;
@@ -240,6 +273,9 @@ struct rk3x_i2c {
 	bool busy;
 
 	/* Current message */
+	struct i2c_msg *msgs;
+	int num;
+	int msg_idx;
 	struct i2c_msg *msg;
 	u8 addr;
 	unsigned int mode;
@@ -255,10 +291,14 @@ struct rk3x_i2c {
 	bool system_restarting;
 	struct rk_tb_client tb_cl;
 	int irq;
+
+	unsigned int spin_us;
+	struct rk3x_i2c_stats stats;
 };
 
 static void rk3x_i2c_prepare_read(struct rk3x_i2c *i2c);
 static int rk3x_i2c_fill_transmit_buf(struct rk3x_i2c *i2c, bool sended);
+static void rk3x_i2c_start_next(struct rk3x_i2c *i2c);
 
 static inline void rk3x_i2c_wake_up(struct rk3x_i2c *i2c)
 {
@@ -400,11 +440,6 @@ static void rk3x_i2c_stop(struct rk3x_i2c *i2c, int error)
 		ctrl &= ~REG_CON_START;
 		i2c_writel(i2c, ctrl, REG_CON);
 	} else {
-		/* Signal rk3x_i2c_xfer to start the next message. */
-		i2c->busy = false;
-		i2c->state = STATE_IDLE;
-		i2c->msg = NULL;
-
 		/*
 		 * The HW is actually not capable of REPEATED START. But we can
 		 * get the intended effect by resetting its internal state
@@ -413,7 +448,21 @@ static void rk3x_i2c_stop(struct rk3x_i2c *i2c, int error)
 		ctrl = i2c_readl(i2c, REG_CON) & REG_CON_TUNING_MASK;
 		i2c_writel(i2c, ctrl, REG_CON);
 
-		/* signal that we are finished with the current msg */
+		/*
+		 * Start the next message right here instead of waking up
+		 * rk3x_i2c_xfer for it, so a transfer costs one wakeup no
+		 * matter how many messages it has.
+		 */
+		if (!error) {
+			rk3x_i2c_start_next(i2c);
+			return;
+		}
+
+		/* Signal rk3x_i2c_xfer that we stopped on the error. */
+		i2c->busy = false;
+		i2c->state = STATE_IDLE;
+		i2c->msg = NULL;
+
 		rk3x_i2c_wake_up(i2c);
 	}
 }
@@ -1170,6 +1219,21 @@ static int rk3x_i2c_setup(struct rk3x_i2c *i2c, struct i2c_msg *msgs, int num)
 	return ret;
 }
 
+/**
+ * rk3x_i2c_start_next - Setup and start the next queued message(s)
+ * @i2c: target controller data
+ *
+ * Must be called with i2c->lock held.
+ */
+static void rk3x_i2c_start_next(struct rk3x_i2c *i2c)
+{
+	i2c->msg_idx += rk3x_i2c_setup(i2c, i2c->msgs + i2c->msg_idx,
+				       i2c->num - i2c->msg_idx);
+	i2c->is_last_msg = i2c->msg_idx >= i2c->num;
+
+	rk3x_i2c_start(i2c);
+}
+
 static int rk3x_i2c_wait_xfer_poll(struct rk3x_i2c *i2c, unsigned long xfer_time)
 {
 	ktime_t timeout = ktime_add_ms(ktime_get(), xfer_time);
@@ -1183,6 +1247,49 @@ static int rk3x_i2c_wait_xfer_poll(struct rk3x_i2c *i2c, unsigned long xfer_time
 	return !i2c->busy;
 }
 
+/*
+ * Wait for the irq handler to finish the transfer without sleeping, this
+ * saves the scheduler wakeup latency for short, time critical transfers
+ * such as sensor exposure updates.
+ */
+static bool rk3x_i2c_wait_xfer_spin(struct rk3x_i2c *i2c, unsigned int us)
+{
+	ktime_t timeout = ktime_add_us(ktime_get(), us);
+
+	while (READ_ONCE(i2c->busy)) {
+		if (ktime_compare(ktime_get(), timeout) >= 0)
+			return false;
+		cpu_relax();
+	}
+
+	return true;
+}
+
+static void rk3x_i2c_update_stats(struct rk3x_i2c *i2c, int num, int ret,
+				  bool spun, ktime_t start)
+{
+	struct rk3x_i2c_stats *stats = &i2c->stats;
+	u32 us = ktime_us_delta(ktime_get(), start);
+	int i;
+
+	stats->xfers++;
+	stats->msgs += num;
+	if (ret == -ETIMEDOUT)
+		stats->timeouts++;
+	else if (ret < 0)
+		stats->errors++;
+	if (spun)
+		stats->spin_done++;
+
+	stats->total_us += us;
+	stats->max_us = max(stats->max_us, us);
+
+	for (i = 0; i < ARRAY_SIZE(rk3x_i2c_lat_bounds); i++)
+		if (us <= rk3x_i2c_lat_bounds[i])
+			break;
+	stats->hist[i]++;
+}
+
 /*
  * Reset i2c controller, reset all i2c registers.
  */
@@ -1205,7 +1312,10 @@ static int rk3x_i2c_xfer_common(struct i2c_adapter *adap,
 				struct i2c_msg *msgs, int num, bool polling)
 {
 	struct rk3x_i2c *i2c = (struct rk3x_i2c *)adap->algo_data;
+	unsigned long xfer_time = WAIT_TIMEOUT;
 	unsigned long timeout, flags;
+	bool spun = false;
+	ktime_t start;
 	u32 val, ipd = 0;
 	int ret = 0;
 	int i;
@@ -1213,76 +1323,65 @@ static int rk3x_i2c_xfer_common(struct i2c_adapter *adap,
 	if (i2c->suspended)
 		return -EACCES;
 
+	/*
+	 * All messages are queued at once and chained from the irq handler,
+	 * so wait for the sum of them.
+	 *
+	 * Transfer time in mSec = Total bits / transfer rate + interval time
+	 * Total bits = 9 bits per byte (including ACK bit) + Start & stop bits
+	 */
+	for (i = 0; i < num; i++) {
+		xfer_time += msgs[i].len / 64;
+		xfer_time += DIV_ROUND_CLOSEST(((msgs[i].len * 9) + 2) * MSEC_PER_SEC,
+					       i2c->t.bus_freq_hz);
+	}
+
+	start = ktime_get();
+
 	spin_lock_irqsave(&i2c->lock, flags);
 
 	clk_enable(i2c->clk);
 	clk_enable(i2c->pclk);
 
-	i2c->is_last_msg = false;
-
 	/*
 	 * Process msgs. We can handle more than one message at once (see
 	 * rk3x_i2c_setup()).
 	 */
-	for (i = 0; i < num; i += ret) {
-		unsigned long xfer_time = WAIT_TIMEOUT;
-		int len;
-
-		ret = rk3x_i2c_setup(i2c, msgs + i, num - i);
-		if (ret < 0) {
-			dev_err(i2c->dev, "rk3x_i2c_setup() failed\n");
-			break;
-		}
+	i2c->msgs = msgs;
+	i2c->num = num;
+	i2c->msg_idx = 0;
+	rk3x_i2c_start_next(i2c);
 
-		/*
-		 * Transfer time in mSec = Total bits / transfer rate + interval time
-		 * Total bits = 9 bits per byte (including ACK bit) + Start & stop bits
-		 */
-		if (ret == 2)
-			len = msgs[i + 1].len;
-		else
-			len = msgs[i].len;
-		xfer_time += len / 64;
-		xfer_time += DIV_ROUND_CLOSEST(((len * 9) + 2) * MSEC_PER_SEC,
-					       i2c->t.bus_freq_hz);
-
-		if (i + ret >= num)
-			i2c->is_last_msg = true;
-
-		rk3x_i2c_start(i2c);
-
-		spin_unlock_irqrestore(&i2c->lock, flags);
-
-		if (!polling) {
-			timeout = wait_event_timeout(i2c->wait, !i2c->busy,
-						     msecs_to_jiffies(xfer_time));
-		} else {
-			timeout = rk3x_i2c_wait_xfer_poll(i2c, xfer_time);
-		}
+	spin_unlock_irqrestore(&i2c->lock, flags);
 
-		spin_lock_irqsave(&i2c->lock, flags);
+	if (polling) {
+		timeout = rk3x_i2c_wait_xfer_poll(i2c, xfer_time);
+	} else if (i2c->spin_us && rk3x_i2c_wait_xfer_spin(i2c, i2c->spin_us)) {
+		timeout = 1;
+		spun = true;
+	} else {
+		timeout = wait_event_timeout(i2c->wait, !i2c->busy,
+					     msecs_to_jiffies(xfer_time));
+	}
 
-		if (timeout == 0) {
-			ipd = i2c_readl(i2c, REG_IPD);
-			dev_err(i2c->dev, "timeout, ipd: 0x%02x, state: %d\n",
-				ipd, i2c->state);
+	spin_lock_irqsave(&i2c->lock, flags);
 
-			/* Force a STOP condition without interrupt */
-			rk3x_i2c_disable_irq(i2c);
-			val = i2c_readl(i2c, REG_CON) & REG_CON_TUNING_MASK;
-			val |= REG_CON_EN | REG_CON_STOP;
-			i2c_writel(i2c, val, REG_CON);
+	if (timeout == 0) {
+		ipd = i2c_readl(i2c, REG_IPD);
+		dev_err(i2c->dev, "timeout, ipd: 0x%02x, state: %d\n",
+			ipd, i2c->state);
 
-			i2c->state = STATE_IDLE;
+		/* Force a STOP condition without interrupt */
+		rk3x_i2c_disable_irq(i2c);
+		val = i2c_readl(i2c, REG_CON) & REG_CON_TUNING_MASK;
+		val |= REG_CON_EN | REG_CON_STOP;
+		i2c_writel(i2c, val, REG_CON);
 
-			ret = -ETIMEDOUT;
-			break;
-		}
+		i2c->state = STATE_IDLE;
 
-		if (i2c->error) {
-			ret = i2c->error;
-			break;
-		}
+		ret = -ETIMEDOUT;
+	} else if (i2c->error) {
+		ret = i2c->error;
 	}
 
 	rk3x_i2c_disable_irq(i2c);
@@ -1291,6 +1390,8 @@ static int rk3x_i2c_xfer_common(struct i2c_adapter *adap,
 	clk_disable(i2c->pclk);
 	clk_disable(i2c->clk);
 
+	rk3x_i2c_update_stats(i2c, num, ret, spun, start);
+
 	spin_unlock_irqrestore(&i2c->lock, flags);
 
 	if ((ret == -ETIMEDOUT) && (ipd & REG_INT_SLV_HDSCL)) {
@@ -1436,6 +1537,79 @@ static u32 rk3x_i2c_func(struct i2c_adapter *adap)
 	return I2C_FUNC_I2C | I2C_FUNC_SMBUS_EMUL | I2C_FUNC_PROTOCOL_MANGLING;
 }
 
+static ssize_t stats_show(struct device *dev, struct device_attribute *attr,
+			  char *buf)
+{
+	struct rk3x_i2c *i2c = dev_get_drvdata(dev);
+	struct rk3x_i2c_stats stats;
+	unsigned long flags;
+	int i, len;
+
+	spin_lock_irqsave(&i2c->lock, flags);
+	stats = i2c->stats;
+	spin_unlock_irqrestore(&i2c->lock, flags);
+
+	len = sysfs_emit(buf, "xfers %llu msgs %llu errors %llu timeouts %llu spin_done %llu\n",
+			 stats.xfers, stats.msgs, stats.errors, stats.timeouts,
+			 stats.spin_done);
+	len += sysfs_emit_at(buf, len, "latency avg %llu max %u us\n",
+			     stats.xfers ? div64_u64(stats.total_us, stats.xfers) : 0,
+			     stats.max_us);
+	for (i = 0; i < ARRAY_SIZE(rk3x_i2c_lat_bounds); i++)
+		len += sysfs_emit_at(buf, len, "<=%uus: %llu\n",
+				     rk3x_i2c_lat_bounds[i], stats.hist[i]);
+	len += sysfs_emit_at(buf, len, ">%uus: %llu\n",
+			     rk3x_i2c_lat_bounds[i - 1], stats.hist[i]);
+
+	return len;
+}
+
+static ssize_t stats_store(struct device *dev, struct device_attribute *attr,
+			   const char *buf, size_t count)
+{
+	struct rk3x_i2c *i2c = dev_get_drvdata(dev);
+	unsigned long flags;
+
+	spin_lock_irqsave(&i2c->lock, flags);
+	memset(&i2c->stats, 0, sizeof(i2c->stats));
+	spin_unlock_irqrestore(&i2c->lock, flags);
+
+	return count;
+}
+static DEVICE_ATTR_RW(stats);
+
+static ssize_t spin_us_show(struct device *dev, struct device_attribute *attr,
+			    char *buf)
+{
+	struct rk3x_i2c *i2c = dev_get_drvdata(dev);
+
+	return sysfs_emit(buf, "%u\n", READ_ONCE(i2c->spin_us));
+}
+
+static ssize_t spin_us_store(struct device *dev, struct device_attribute *attr,
+			     const char *buf, size_t count)
+{
+	struct rk3x_i2c *i2c = dev_get_drvdata(dev);
+	unsigned int val;
+	int ret;
+
+	ret = kstrtouint(buf, 0, &val);
+	if (ret)
+		return ret;
+
+	WRITE_ONCE(i2c->spin_us, min_t(unsigned int, val, MAX_SPIN_US));
+
+	return count;
+}
+static DEVICE_ATTR_RW(spin_us);
+
+static struct attribute *rk3x_i2c_attrs[] = {
+	&dev_attr_stats.attr,
+	&dev_attr_spin_us.attr,
+	NULL,
+};
+ATTRIBUTE_GROUPS(rk3x_i2c);
+
 static const struct i2c_algorithm rk3x_i2c_algorithm = {
 	.master_xfer		= rk3x_i2c_xfer,
 	.master_xfer_atomic	= rk3x_i2c_xfer_polling,
@@ -1579,6 +1753,10 @@ static int rk3x_i2c_probe(struct platform_device *pdev)
 	spin_lock_init(&i2c->lock);
 	init_waitqueue_head(&i2c->wait);
 
+	/* Short time critical transfers, e.g. sensor exposure, can spin */
+	device_property_read_u32(&pdev->dev, "rockchip,spin-wait-us", &i2c->spin_us);
+	i2c->spin_us = min_t(unsigned int, i2c->spin_us, MAX_SPIN_US);
+
 	i2c->i2c_restart_nb.notifier_call = rk3x_i2c_restart_notify;
 	i2c->i2c_restart_nb.priority = 255;
 	ret = register_restart_handler(&i2c->i2c_restart_nb);
@@ -1747,6 +1925,7 @@ static struct platform_driver rk3x_i2c_driver = {
 		.name  = "rk3x-i2c",
 		.of_match_table = rk3x_i2c_match,
 		.pm = &rk3x_i2c_pm_ops,
+		.dev_groups = rk3x_i2c_groups,
 	},
 };
 
@@ -14,6 +14,7 @@
 #include <linux/clk.h>
 #include <linux/completion.h>
 #include <linux/delay.h>
+#include <linux/iopoll.h>
 #include <linux/reset.h>
 #include <linux/regulator/consumer.h>
 #include <linux/iio/buffer.h>
@@ -36,6 +37,7 @@
 #define SARADC_DLY_PU_SOC_MASK		0x3f
 
 #define SARADC_TIMEOUT			msecs_to_jiffies(100)
+#define SARADC_POLL_TIMEOUT_US		1000
 #define SARADC_MAX_CHANNELS		8
 
 /* v2 registers */
@@ -60,6 +62,7 @@ struct rockchip_saradc_data {
 	unsigned long			clk_rate;
 	void (*start)(struct rockchip_saradc *info, int chn);
 	int (*read)(struct rockchip_saradc *info);
+	bool (*done)(struct rockchip_saradc *info);
 	void (*power_down)(struct rockchip_saradc *info);
 };
 
@@ -68,6 +71,7 @@ struct rockchip_saradc {
 	struct clk		*pclk;
 	struct clk		*clk;
 	struct completion	completion;
+	int			irq;
 	struct regulator	*vref;
 	/* lock to protect against multiple access to the device */
 	struct mutex		lock;
@@ -153,6 +157,16 @@ static int rockchip_saradc_read(struct rockchip_saradc *info)
 	return info->data->read(info);
 }
 
+static bool rockchip_saradc_done_v1(struct rockchip_saradc *info)
+{
+	return readl_relaxed(info->regs + SARADC_CTRL) & SARADC_CTRL_IRQ_STATUS;
+}
+
+static bool rockchip_saradc_done_v2(struct rockchip_saradc *info)
+{
+	return readl_relaxed(info->regs + SARADC2_END_INT_ST) & 0x1;
+}
+
 static void rockchip_saradc_power_down_v1(struct rockchip_saradc *info)
 {
 	writel_relaxed(0, info->regs + SARADC_CTRL);
@@ -179,6 +193,32 @@ static int rockchip_saradc_conversion(struct rockchip_saradc *info,
 	return 0;
 }
 
+/*
+ * A conversion only takes some clock cycles of the converter clock, far
+ * less than an interrupt plus a wakeup of the waiting thread. The
+ * buffered path spins on the end status instead, with the irq masked.
+ */
+static int rockchip_saradc_conversion_poll(struct rockchip_saradc *info,
+					   struct iio_chan_spec const *chan)
+{
+	bool done;
+	int ret;
+
+	info->last_chan = chan;
+	rockchip_saradc_start(info, chan->channel);
+
+	ret = read_poll_timeout(info->data->done, done, done, 0,
+				SARADC_POLL_TIMEOUT_US, false, info);
+	if (ret)
+		return ret;
+
+	info->last_val = rockchip_saradc_read(info);
+	info->last_val &= GENMASK(chan->scan_type.realbits - 1, 0);
+	rockchip_saradc_power_down(info);
+
+	return 0;
+}
+
 static int rockchip_saradc_read_raw(struct iio_dev *indio_dev,
 				    struct iio_chan_spec const *chan,
 				    int *val, int *val2, long mask)
@@ -281,6 +321,7 @@ static const struct rockchip_saradc_data saradc_data = {
 	.clk_rate = 1000000,
 	.start = rockchip_saradc_start_v1,
 	.read = rockchip_saradc_read_v1,
+	.done = rockchip_saradc_done_v1,
 	.power_down = rockchip_saradc_power_down_v1,
 };
 
@@ -295,6 +336,7 @@ static const struct rockchip_saradc_data rk3066_tsadc_data = {
 	.clk_rate = 50000,
 	.start = rockchip_saradc_start_v1,
 	.read = rockchip_saradc_read_v1,
+	.done = rockchip_saradc_done_v1,
 	.power_down = rockchip_saradc_power_down_v1,
 };
 
@@ -313,6 +355,7 @@ static const struct rockchip_saradc_data rk3399_saradc_data = {
 	.clk_rate = 1000000,
 	.start = rockchip_saradc_start_v1,
 	.read = rockchip_saradc_read_v1,
+	.done = rockchip_saradc_done_v1,
 	.power_down = rockchip_saradc_power_down_v1,
 };
 
@@ -329,6 +372,7 @@ static const struct rockchip_saradc_data rk3528_saradc_data = {
 	.clk_rate = 1000000,
 	.start = rockchip_saradc_start_v2,
 	.read = rockchip_saradc_read_v2,
+	.done = rockchip_saradc_done_v2,
 };
 
 static const struct iio_chan_spec rockchip_rk3562_saradc_iio_channels[] = {
@@ -348,6 +392,7 @@ static const struct rockchip_saradc_data rk3562_saradc_data = {
 	.clk_rate = 1000000,
 	.start = rockchip_saradc_start_v2,
 	.read = rockchip_saradc_read_v2,
+	.done = rockchip_saradc_done_v2,
 };
 
 static const struct iio_chan_spec rockchip_rk3568_saradc_iio_channels[] = {
@@ -367,6 +412,7 @@ static const struct rockchip_saradc_data rk3568_saradc_data = {
 	.clk_rate = 1000000,
 	.start = rockchip_saradc_start_v1,
 	.read = rockchip_saradc_read_v1,
+	.done = rockchip_saradc_done_v1,
 	.power_down = rockchip_saradc_power_down_v1,
 };
 
@@ -387,6 +433,7 @@ static const struct rockchip_saradc_data rk3588_saradc_data = {
 	.clk_rate = 1000000,
 	.start = rockchip_saradc_start_v2,
 	.read = rockchip_saradc_read_v2,
+	.done = rockchip_saradc_done_v2,
 };
 
 static const struct iio_chan_spec rockchip_rv1106_saradc_iio_channels[] = {
@@ -400,6 +447,7 @@ static const struct rockchip_saradc_data rv1106_saradc_data = {
 	.clk_rate = 1000000,
 	.start = rockchip_saradc_start_v2,
 	.read = rockchip_saradc_read_v2,
+	.done = rockchip_saradc_done_v2,
 };
 
 static const struct of_device_id rockchip_saradc_match[] = {
@@ -476,15 +524,22 @@ static irqreturn_t rockchip_saradc_trigger_handler(int irq, void *p)
 		u16 values[SARADC_MAX_CHANNELS];
 		int64_t timestamp;
 	} data;
+	bool poll = info->data->done &&
+		    !IS_ENABLED(CONFIG_ROCKCHIP_SARADC_TEST_CHN);
 	int ret;
 	int i, j = 0;
 
 	mutex_lock(&info->lock);
+	if (poll)
+		disable_irq(info->irq);
 
 	for_each_set_bit(i, i_dev->active_scan_mask, i_dev->masklength) {
 		const struct iio_chan_spec *chan = &i_dev->channels[i];
 
-		ret = rockchip_saradc_conversion(info, chan);
+		if (poll)
+			ret = rockchip_saradc_conversion_poll(info, chan);
+		else
+			ret = rockchip_saradc_conversion(info, chan);
 		if (ret) {
 			rockchip_saradc_power_down(info);
 			goto out;
@@ -496,6 +551,8 @@ static irqreturn_t rockchip_saradc_trigger_handler(int irq, void *p)
 
 	iio_push_to_buffers_with_timestamp(i_dev, &data, iio_get_time_ns(i_dev));
 out:
+	if (poll)
+		enable_irq(info->irq);
 	mutex_unlock(&info->lock);
 
 	iio_trigger_notify_done(i_dev->trig);
@@ -650,6 +707,7 @@ static int rockchip_saradc_probe(struct platform_device *pdev)
 	irq = platform_get_irq(pdev, 0);
 	if (irq < 0)
 		return dev_err_probe(&pdev->dev, irq, "failed to get irq\n");
+	info->irq = irq;
 
 	ret = devm_request_irq(&pdev->dev, irq, rockchip_saradc_isr,
 			       0, dev_name(&pdev->dev), info);
@@ -45,6 +45,8 @@ struct av1d_iommu {
 	dma_addr_t dt_dma;
 	spinlock_t iommus_lock; /* lock for iommus list */
 	spinlock_t dt_lock; /* lock for modifying page directory table */
+	/* tables changed since the last tlb flush */
+	bool tlb_dirty;
 	/* for av1 iommu */
 	u64 *pta; /* page directory table */
 	dma_addr_t pta_dma;
@@ -266,22 +268,30 @@ static void av1_iommu_flush_tlb_all(struct iommu_domain *domain, struct device *
 	if (WARN_ON(!av1d_iommu))
 		return;
 
+	/*
+	 * The mmu only has a global flush and the decoder asks for one per
+	 * frame. Buffers stay mapped across frames, so skip the flush and
+	 * keep the tlb warm unless a mapping changed since the last one.
+	 */
+	if (!xchg(&av1d_iommu->tlb_dirty, false))
+		return;
+
 	spin_lock_irqsave(&av1d_iommu->iommus_lock, flags);
 	ret = pm_runtime_get_if_in_use(av1d_iommu->dev);
-	if (WARN_ON_ONCE(ret < 0)) {
+	if (WARN_ON_ONCE(ret < 0) || !ret) {
+		/* not flushed, retry on the next request */
+		WRITE_ONCE(av1d_iommu->tlb_dirty, true);
 		spin_unlock_irqrestore(&av1d_iommu->iommus_lock, flags);
 		return;
 	}
-	if (ret) {
-		WARN_ON(clk_bulk_enable(av1d_iommu->num_clocks, av1d_iommu->clocks));
-		for (i = 0; i < av1d_iommu->num_mmu; i++) {
-			writel(AV1_MMU_BIT_FLUSH,
-				av1d_iommu->bases[i] + AV1_MMU_FLUSH_BASE);
-			writel(0, av1d_iommu->bases[i] + AV1_MMU_FLUSH_BASE);
-		}
-		clk_bulk_disable(av1d_iommu->num_clocks, av1d_iommu->clocks);
-		pm_runtime_put(av1d_iommu->dev);
+	WARN_ON(clk_bulk_enable(av1d_iommu->num_clocks, av1d_iommu->clocks));
+	for (i = 0; i < av1d_iommu->num_mmu; i++) {
+		writel(AV1_MMU_BIT_FLUSH,
+			av1d_iommu->bases[i] + AV1_MMU_FLUSH_BASE);
+		writel(0, av1d_iommu->bases[i] + AV1_MMU_FLUSH_BASE);
 	}
+	clk_bulk_disable(av1d_iommu->num_clocks, av1d_iommu->clocks);
+	pm_runtime_put(av1d_iommu->dev);
 	spin_unlock_irqrestore(&av1d_iommu->iommus_lock, flags);
 }
 
@@ -524,6 +534,8 @@ static size_t av1_iommu_unmap(struct iommu_domain *domain, unsigned long _iova,
 	pte_addr = (u32 *)phys_to_virt(pt_phys) + av1_iova_pte_index(iova);
 	pte_dma = pt_phys + av1_iova_pte_index(iova) * sizeof(u32);
 	unmap_size = av1_iommu_unmap_iova(av1d_iommu, pte_addr, pte_dma, size);
+	if (unmap_size)
+		WRITE_ONCE(av1d_iommu->tlb_dirty, true);
 
 	spin_unlock_irqrestore(&av1d_iommu->dt_lock, flags);
 
@@ -557,6 +569,9 @@ static int av1_iommu_map(struct iommu_domain *domain, unsigned long _iova, phys_
 	pte_dma = av1_dte_pt_address(dte) + pte_index * sizeof(u32);
 	ret = av1_iommu_map_iova(av1d_iommu, pte_addr, pte_dma, iova,
 				   paddr, size, prot);
+	/* the mmu may hold stale table cachelines around the new range */
+	if (!ret)
+		WRITE_ONCE(av1d_iommu->tlb_dirty, true);
 
 	spin_unlock_irqrestore(&av1d_iommu->dt_lock, flags);
 
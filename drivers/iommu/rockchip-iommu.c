@@ -8,6 +8,7 @@
 
 #include <linux/clk.h>
 #include <linux/compiler.h>
+#include <linux/debugfs.h>
 #include <linux/delay.h>
 #include <linux/device.h>
 #include <linux/dma-mapping.h>
@@ -16,14 +17,17 @@
 #include <linux/io.h>
 #include <linux/iommu.h>
 #include <linux/iopoll.h>
+#include <linux/ktime.h>
 #include <linux/list.h>
 #include <linux/mm.h>
 #include <linux/module.h>
+#include <linux/mutex.h>
 #include <linux/init.h>
 #include <linux/of.h>
 #include <linux/of_platform.h>
 #include <linux/platform_device.h>
 #include <linux/pm_runtime.h>
+#include <linux/seq_file.h>
 #include <linux/slab.h>
 #include <linux/spinlock.h>
 #include <soc/rockchip/rockchip_iommu.h>
@@ -85,6 +89,30 @@
   */
 #define RK_IOMMU_PGSIZE_BITMAP 0x007ff000
 
+/*
+ * Unmapping more than this shoots down the entire iotlb with one command
+ * instead of one zap command per page.
+ */
+#define RK_IOMMU_ZAP_ALL_SIZE	SZ_1M
+
+/* Map/unmap accounting, shared by all iommus attached to a domain */
+struct rk_iommu_map_stats {
+	atomic64_t map;
+	atomic64_t map_pages;
+	atomic64_t unmap;
+	atomic64_t unmap_pages;
+};
+
+/* Per iommu accounting of the iotlb maintenance and faults */
+struct rk_iommu_stats {
+	atomic64_t zap_lines;
+	atomic64_t zap_cache;
+	atomic64_t stalls;
+	atomic64_t stall_ns;
+	atomic64_t page_faults;
+	atomic64_t bus_errors;
+};
+
 struct rk_iommu_domain {
 	struct list_head iommus;
 	u32 *dt; /* page directory table */
@@ -94,6 +122,7 @@ struct rk_iommu_domain {
 	bool shootdown_entire;
 	struct third_iommu_ops_wrap *opt_ops;
 	struct device *iommu_dev;
+	struct rk_iommu_map_stats stats;
 
 	struct iommu_domain domain;
 };
@@ -125,6 +154,18 @@ struct rk_iommu {
 	struct third_iommu_ops_wrap *opt_ops;
 	bool iommu_enabled;
 	bool need_res_map;
+	ktime_t stall_start;
+	struct rk_iommu_stats stats;
+};
+
+/*
+ * Iommus sharing a "rockchip,iommu-group" id put their masters into one
+ * iommu group, so that the masters of a pipeline use a single domain.
+ */
+struct rk_iommu_group {
+	struct list_head node; /* entry in rk_iommu_groups */
+	struct iommu_group *group;
+	u32 id;
 };
 
 struct rk_iommudata {
@@ -137,6 +178,8 @@ static struct device *dma_dev;
 static const struct rk_iommu_ops *rk_ops;
 static struct rk_iommu *rk_iommu_from_dev(struct device *dev);
 static char reserve_range[PAGE_SIZE] __aligned(PAGE_SIZE);
+static LIST_HEAD(rk_iommu_groups);
+static DEFINE_MUTEX(rk_iommu_groups_lock);
 static phys_addr_t res_page;
 
 static inline void rk_table_flush(struct rk_iommu_domain *dom, dma_addr_t dma,
@@ -354,6 +397,14 @@ static u32 rk_iova_pte_index(dma_addr_t iova)
 	return (u32)(iova & RK_IOVA_PTE_MASK) >> RK_IOVA_PTE_SHIFT;
 }
 
+/* Size of the range from iova which is covered by the page table of iova */
+static size_t rk_iova_pt_size(dma_addr_t iova, size_t size)
+{
+	size_t left = NUM_PT_ENTRIES * SPAGE_SIZE - (iova & ~RK_IOVA_DTE_MASK);
+
+	return min(size, left);
+}
+
 static u32 rk_iova_page_offset(dma_addr_t iova)
 {
 	return (u32)(iova & RK_IOVA_PAGE_MASK) >> RK_IOVA_PAGE_SHIFT;
@@ -396,6 +447,9 @@ static void rk_iommu_zap_lines(struct rk_iommu *iommu, dma_addr_t iova_start,
 		for (iova = iova_start; iova < iova_end; iova += SPAGE_SIZE)
 			rk_iommu_write(iommu->bases[i], RK_MMU_ZAP_ONE_LINE, iova);
 	}
+
+	atomic64_add(iommu->num_mmu * DIV_ROUND_UP(size, SPAGE_SIZE),
+		     &iommu->stats.zap_lines);
 }
 
 static bool rk_iommu_is_stall_active(struct rk_iommu *iommu)
@@ -450,6 +504,8 @@ static int rk_iommu_enable_stall(struct rk_iommu *iommu)
 		return 0;
 
 read_wa:
+	if (!iommu->stall_start)
+		iommu->stall_start = ktime_get();
 	rk_iommu_command(iommu, RK_MMU_CMD_ENABLE_STALL);
 	if (iommu->skip_read)
 		return 0;
@@ -478,10 +534,18 @@ static int rk_iommu_disable_stall(struct rk_iommu *iommu)
 	if (iommu->skip_read)
 		goto read_wa;
 
-	if (!rk_iommu_is_stall_active(iommu))
+	if (!rk_iommu_is_stall_active(iommu)) {
+		iommu->stall_start = 0;
 		return 0;
+	}
 
 read_wa:
+	if (iommu->stall_start) {
+		atomic64_inc(&iommu->stats.stalls);
+		atomic64_add(ktime_to_ns(ktime_sub(ktime_get(), iommu->stall_start)),
+			     &iommu->stats.stall_ns);
+		iommu->stall_start = 0;
+	}
 	rk_iommu_command(iommu, RK_MMU_CMD_DISABLE_STALL);
 	if (iommu->skip_read)
 		return 0;
@@ -696,6 +760,7 @@ static int rk_pagefault_done(struct rk_iommu *iommu)
 				(flags == IOMMU_FAULT_WRITE) ? "write" : "read");
 
 			log_iova(iommu, i, iova);
+			atomic64_inc(&iommu->stats.page_faults);
 
 			if (!iommu->master_handle_irq) {
 				/*
@@ -711,6 +776,7 @@ static int rk_pagefault_done(struct rk_iommu *iommu)
 			}
 
 			rk_iommu_base_command(iommu->bases[i], RK_MMU_CMD_ZAP_CACHE);
+			atomic64_inc(&iommu->stats.zap_cache);
 
 			/*
 			 * Master may clear the int_mask to prevent iommu
@@ -722,8 +788,10 @@ static int rk_pagefault_done(struct rk_iommu *iommu)
 				rk_iommu_base_command(iommu->bases[i], RK_MMU_CMD_PAGE_FAULT_DONE);
 		}
 
-		if (int_status & RK_MMU_IRQ_BUS_ERROR)
+		if (int_status & RK_MMU_IRQ_BUS_ERROR) {
 			dev_err(iommu->dev, "BUS_ERROR occurred at %pad\n", &iova);
+			atomic64_inc(&iommu->stats.bus_errors);
+		}
 
 		if (int_status & ~RK_MMU_IRQ_MASK)
 			dev_err(iommu->dev, "unexpected int_status: %#08x\n",
@@ -961,14 +1029,6 @@ static int rk_iommu_map_iova(struct rk_iommu_domain *rk_domain, u32 *pte_addr,
 
 	rk_table_flush(rk_domain, pte_dma, pte_total);
 
-	/*
-	 * Zap the first and last iova to evict from iotlb any previously
-	 * mapped cachelines holding stale values for its dte and pte.
-	 * We only zap the first and last iova, since only they could have
-	 * dte or pte shared with an existing mapping.
-	 */
-	rk_iommu_zap_iova_first_last(rk_domain, iova, size);
-
 	return 0;
 unwind:
 	/* Unmap the range of iovas that we just mapped */
@@ -983,91 +1043,152 @@ static int rk_iommu_map_iova(struct rk_iommu_domain *rk_domain, u32 *pte_addr,
 	return -EADDRINUSE;
 }
 
-static int rk_iommu_map(struct iommu_domain *domain, unsigned long _iova,
-			phys_addr_t paddr, size_t size, int prot, gfp_t gfp)
+static int rk_iommu_map_pages(struct iommu_domain *domain, unsigned long _iova,
+			      phys_addr_t paddr, size_t pgsize, size_t pgcount,
+			      int prot, gfp_t gfp, size_t *mapped)
 {
 	struct rk_iommu_domain *rk_domain = to_rk_domain(domain);
+	size_t size = pgsize * pgcount;
+	size_t done = 0, len;
 	unsigned long flags;
-	dma_addr_t pte_dma, iova = (dma_addr_t)_iova;
+	dma_addr_t pte_dma, iova;
 	u32 *page_table, *pte_addr;
 	u32 dte, pte_index;
-	int ret;
+	int ret = 0;
+
+	if (rk_domain->opt_ops && rk_domain->opt_ops->map) {
+		while (done < size) {
+			iova = (dma_addr_t)_iova + done;
+			len = rk_iova_pt_size(iova, size - done);
+			ret = rk_domain->opt_ops->map(domain, iova, paddr + done, len,
+						      prot, gfp, rk_domain->iommu_dev);
+			if (ret)
+				break;
+			done += len;
+		}
+		*mapped = done;
 
-	if (rk_domain->opt_ops && rk_domain->opt_ops->map)
-		return rk_domain->opt_ops->map(domain, _iova, paddr, size, prot,
-					       gfp, rk_domain->iommu_dev);
+		return ret;
+	}
 
 	spin_lock_irqsave(&rk_domain->dt_lock, flags);
 
 	/*
-	 * pgsize_bitmap specifies iova sizes that fit in one page table
-	 * (1024 4-KiB pages = 4 MiB).
-	 * So, size will always be 4096 <= size <= 4194304.
-	 * Since iommu_map() guarantees that both iova and size will be
-	 * aligned, we will always only be mapping from a single dte here.
+	 * Walk the range one page table (1024 4-KiB pages = 4 MiB) at a time,
+	 * the iotlb is only zapped once for the whole range by
+	 * rk_iommu_iotlb_sync_map().
 	 */
-	page_table = rk_dte_get_page_table(rk_domain, iova);
-	if (IS_ERR(page_table)) {
-		spin_unlock_irqrestore(&rk_domain->dt_lock, flags);
-		return PTR_ERR(page_table);
-	}
+	while (done < size) {
+		iova = (dma_addr_t)_iova + done;
+		len = rk_iova_pt_size(iova, size - done);
 
-	dte = rk_domain->dt[rk_iova_dte_index(iova)];
-	pte_index = rk_iova_pte_index(iova);
-	pte_addr = &page_table[pte_index];
-	pte_dma = rk_ops->pt_address(dte) + pte_index * sizeof(u32);
-	ret = rk_iommu_map_iova(rk_domain, pte_addr, pte_dma, iova,
-				paddr, size, prot);
+		page_table = rk_dte_get_page_table(rk_domain, iova);
+		if (IS_ERR(page_table)) {
+			ret = PTR_ERR(page_table);
+			break;
+		}
+
+		dte = rk_domain->dt[rk_iova_dte_index(iova)];
+		pte_index = rk_iova_pte_index(iova);
+		pte_addr = &page_table[pte_index];
+		pte_dma = rk_ops->pt_address(dte) + pte_index * sizeof(u32);
+		ret = rk_iommu_map_iova(rk_domain, pte_addr, pte_dma, iova,
+					paddr + done, len, prot);
+		if (ret)
+			break;
+		done += len;
+	}
 
 	spin_unlock_irqrestore(&rk_domain->dt_lock, flags);
 
+	atomic64_inc(&rk_domain->stats.map);
+	atomic64_add(done / SPAGE_SIZE, &rk_domain->stats.map_pages);
+
+	*mapped = done;
+
 	return ret;
 }
 
-static size_t rk_iommu_unmap(struct iommu_domain *domain, unsigned long _iova,
-			     size_t size, struct iommu_iotlb_gather *gather)
+static void rk_iommu_iotlb_sync_map(struct iommu_domain *domain,
+				    unsigned long iova, size_t size)
+{
+	struct rk_iommu_domain *rk_domain = to_rk_domain(domain);
+
+	if (rk_domain->opt_ops && rk_domain->opt_ops->map)
+		return;
+
+	/*
+	 * Zap the first and last iova to evict from iotlb any previously
+	 * mapped cachelines holding stale values for its dte and pte.
+	 * We only zap the first and last iova, since only they could have
+	 * dte or pte shared with an existing mapping.
+	 */
+	rk_iommu_zap_iova_first_last(rk_domain, iova, size);
+}
+
+static size_t rk_iommu_unmap_pages(struct iommu_domain *domain, unsigned long _iova,
+				   size_t pgsize, size_t pgcount,
+				   struct iommu_iotlb_gather *gather)
 {
 	struct rk_iommu_domain *rk_domain = to_rk_domain(domain);
+	size_t size = pgsize * pgcount;
+	size_t unmapped = 0, len, ret;
 	unsigned long flags;
-	dma_addr_t pte_dma, iova = (dma_addr_t)_iova;
+	dma_addr_t pte_dma, iova;
 	phys_addr_t pt_phys;
 	u32 dte;
 	u32 *pte_addr;
-	size_t unmap_size;
-	struct rk_iommu *iommu = rk_iommu_get(rk_domain);
+	struct rk_iommu *iommu;
 
-	if (rk_domain->opt_ops && rk_domain->opt_ops->unmap)
-		return rk_domain->opt_ops->unmap(domain, _iova, size, gather,
-						 rk_domain->iommu_dev);
+	if (rk_domain->opt_ops && rk_domain->opt_ops->unmap) {
+		while (unmapped < size) {
+			iova = (dma_addr_t)_iova + unmapped;
+			len = rk_iova_pt_size(iova, size - unmapped);
+			ret = rk_domain->opt_ops->unmap(domain, iova, len, gather,
+							rk_domain->iommu_dev);
+			unmapped += ret;
+			if (ret < len)
+				break;
+		}
+
+		return unmapped;
+	}
+
+	iommu = rk_iommu_get(rk_domain);
 
 	spin_lock_irqsave(&rk_domain->dt_lock, flags);
 
-	/*
-	 * pgsize_bitmap specifies iova sizes that fit in one page table
-	 * (1024 4-KiB pages = 4 MiB).
-	 * So, size will always be 4096 <= size <= 4194304.
-	 * Since iommu_unmap() guarantees that both iova and size will be
-	 * aligned, we will always only be unmapping from a single dte here.
-	 */
-	dte = rk_domain->dt[rk_iova_dte_index(iova)];
-	/* Just return 0 if iova is unmapped */
-	if (!rk_dte_is_pt_valid(dte)) {
-		spin_unlock_irqrestore(&rk_domain->dt_lock, flags);
-		return 0;
-	}
+	while (unmapped < size) {
+		iova = (dma_addr_t)_iova + unmapped;
+		len = rk_iova_pt_size(iova, size - unmapped);
 
-	pt_phys = rk_ops->pt_address(dte);
-	pte_addr = (u32 *)phys_to_virt(pt_phys) + rk_iova_pte_index(iova);
-	pte_dma = pt_phys + rk_iova_pte_index(iova) * sizeof(u32);
-	unmap_size = rk_iommu_unmap_iova(rk_domain, pte_addr, pte_dma, size,
-					 iommu);
+		/* Stop at the first iova which is unmapped */
+		dte = rk_domain->dt[rk_iova_dte_index(iova)];
+		if (!rk_dte_is_pt_valid(dte))
+			break;
+
+		pt_phys = rk_ops->pt_address(dte);
+		pte_addr = (u32 *)phys_to_virt(pt_phys) + rk_iova_pte_index(iova);
+		pte_dma = pt_phys + rk_iova_pte_index(iova) * sizeof(u32);
+		ret = rk_iommu_unmap_iova(rk_domain, pte_addr, pte_dma, len, iommu);
+		unmapped += ret;
+		if (ret < len)
+			break;
+	}
 
 	spin_unlock_irqrestore(&rk_domain->dt_lock, flags);
 
-	/* Shootdown iotlb entries for iova range that was just unmapped */
-	rk_iommu_zap_iova(rk_domain, iova, unmap_size);
+	atomic64_inc(&rk_domain->stats.unmap);
+	atomic64_add(unmapped / SPAGE_SIZE, &rk_domain->stats.unmap_pages);
+
+	/* The iotlb entries are shot down by rk_iommu_iotlb_sync() */
+	if (unmapped) {
+		if (iommu_iotlb_gather_is_disjoint(gather, _iova, unmapped))
+			iommu_iotlb_sync(domain, gather);
+		iommu_iotlb_gather_add_range(gather, _iova, unmapped);
+	}
 
-	return unmap_size;
+	return unmapped;
 }
 
 static void rk_iommu_flush_tlb_all(struct iommu_domain *domain)
@@ -1096,6 +1217,7 @@ static void rk_iommu_flush_tlb_all(struct iommu_domain *domain)
 			for (i = 0; i < iommu->num_mmu; i++)
 				rk_iommu_write(iommu->bases[i], RK_MMU_COMMAND,
 					       RK_MMU_CMD_ZAP_CACHE);
+			atomic64_add(iommu->num_mmu, &iommu->stats.zap_cache);
 			clk_bulk_disable(iommu->num_clocks, iommu->clocks);
 			pm_runtime_put(iommu->dev);
 		}
@@ -1103,6 +1225,25 @@ static void rk_iommu_flush_tlb_all(struct iommu_domain *domain)
 	spin_unlock_irqrestore(&rk_domain->iommus_lock, flags);
 }
 
+static void rk_iommu_iotlb_sync(struct iommu_domain *domain,
+				struct iommu_iotlb_gather *gather)
+{
+	struct rk_iommu_domain *rk_domain = to_rk_domain(domain);
+	size_t size;
+
+	if (rk_domain->opt_ops && rk_domain->opt_ops->unmap)
+		return;
+
+	if (gather->start > gather->end || rk_domain->shootdown_entire)
+		return;
+
+	size = gather->end - gather->start + 1;
+	if (size > RK_IOMMU_ZAP_ALL_SIZE)
+		rk_iommu_flush_tlb_all(domain);
+	else
+		rk_iommu_zap_iova(rk_domain, gather->start, size);
+}
+
 static struct rk_iommu *rk_iommu_from_dev(struct device *dev)
 {
 	struct rk_iommudata *data = dev_iommu_priv_get(dev);
@@ -1332,9 +1473,17 @@ static int rk_iommu_attach_device(struct iommu_domain *domain,
 
 	spin_lock_irqsave(&rk_domain->iommus_lock, flags);
 	list_add_tail(&iommu->node, &rk_domain->iommus);
+
+	/*
+	 * A domain shared by several iommus may only skip the per-line zap
+	 * if every attached iommu has its iotlb shot down by its master.
+	 */
+	if (list_is_singular(&rk_domain->iommus))
+		rk_domain->shootdown_entire = iommu->shootdown_entire;
+	else
+		rk_domain->shootdown_entire &= iommu->shootdown_entire;
 	spin_unlock_irqrestore(&rk_domain->iommus_lock, flags);
 
-	rk_domain->shootdown_entire = iommu->shootdown_entire;
 	ret = pm_runtime_get_if_in_use(iommu->dev);
 	if (!ret || WARN_ON_ONCE(ret < 0))
 		return 0;
@@ -1467,6 +1616,62 @@ static struct iommu_group *rk_iommu_device_group(struct device *dev)
 	return iommu_group_ref_get(iommu->group);
 }
 
+static void rk_iommu_group_release(void *iommu_data)
+{
+	struct rk_iommu_group *rk_group = iommu_data;
+
+	mutex_lock(&rk_iommu_groups_lock);
+	list_del(&rk_group->node);
+	mutex_unlock(&rk_iommu_groups_lock);
+
+	kfree(rk_group);
+}
+
+static struct iommu_group *rk_iommu_group_alloc(struct rk_iommu *iommu)
+{
+	struct rk_iommu_group *rk_group;
+	struct iommu_group *group;
+	u32 id;
+
+	if (iommu->opt_ops ||
+	    device_property_read_u32(iommu->dev, "rockchip,iommu-group", &id))
+		return iommu_group_alloc();
+
+	mutex_lock(&rk_iommu_groups_lock);
+
+	list_for_each_entry(rk_group, &rk_iommu_groups, node) {
+		if (rk_group->id == id) {
+			group = iommu_group_ref_get(rk_group->group);
+			goto out_unlock;
+		}
+	}
+
+	rk_group = kzalloc(sizeof(*rk_group), GFP_KERNEL);
+	if (!rk_group) {
+		group = ERR_PTR(-ENOMEM);
+		goto out_unlock;
+	}
+
+	group = iommu_group_alloc();
+	if (IS_ERR(group)) {
+		kfree(rk_group);
+		goto out_unlock;
+	}
+
+	rk_group->id = id;
+	rk_group->group = group;
+	list_add_tail(&rk_group->node, &rk_iommu_groups);
+	iommu_group_set_iommudata(group, rk_group, rk_iommu_group_release);
+
+out_unlock:
+	mutex_unlock(&rk_iommu_groups_lock);
+
+	if (!IS_ERR(group))
+		dev_dbg(iommu->dev, "use shared iommu group %u\n", id);
+
+	return group;
+}
+
 static bool rk_iommu_is_attach_deferred(struct device *dev)
 {
 	struct rk_iommudata *data = dev_iommu_priv_get(dev);
@@ -1522,6 +1727,7 @@ void rockchip_iommu_unmask_irq(struct device *dev)
 	for (i = 0; i < iommu->num_mmu; i++) {
 		/* Need to zap tlb in case of mapping during pagefault */
 		rk_iommu_base_command(iommu->bases[i], RK_MMU_CMD_ZAP_CACHE);
+		atomic64_inc(&iommu->stats.zap_cache);
 		rk_iommu_write(iommu->bases[i], RK_MMU_INT_MASK, RK_MMU_IRQ_MASK);
 		/* Leave iommu in pagefault state until mapping finished */
 		rk_iommu_base_command(iommu->bases[i], RK_MMU_CMD_PAGE_FAULT_DONE);
@@ -1541,14 +1747,64 @@ static const struct iommu_ops rk_iommu_ops = {
 	.default_domain_ops = &(const struct iommu_domain_ops) {
 		.attach_dev	= rk_iommu_attach_device,
 		.detach_dev	= rk_iommu_detach_device,
-		.map		= rk_iommu_map,
-		.unmap		= rk_iommu_unmap,
+		.map_pages	= rk_iommu_map_pages,
+		.unmap_pages	= rk_iommu_unmap_pages,
 		.flush_iotlb_all= rk_iommu_flush_tlb_all,
+		.iotlb_sync_map	= rk_iommu_iotlb_sync_map,
+		.iotlb_sync	= rk_iommu_iotlb_sync,
 		.iova_to_phys	= rk_iommu_iova_to_phys,
 		.free		= rk_iommu_domain_free,
 	}
 };
 
+#ifdef CONFIG_IOMMU_DEBUGFS
+static struct dentry *rk_iommu_debugfs_dir;
+
+static int rk_iommu_stats_show(struct seq_file *s, void *data)
+{
+	struct rk_iommu *iommu = s->private;
+	struct rk_iommu_stats *stats = &iommu->stats;
+	struct rk_iommu_domain *rk_domain;
+
+	seq_printf(s, "zap_lines: %lld\n", atomic64_read(&stats->zap_lines));
+	seq_printf(s, "zap_cache: %lld\n", atomic64_read(&stats->zap_cache));
+	seq_printf(s, "stalls: %lld\n", atomic64_read(&stats->stalls));
+	seq_printf(s, "stall_us: %lld\n",
+		   div_u64(atomic64_read(&stats->stall_ns), NSEC_PER_USEC));
+	seq_printf(s, "page_faults: %lld\n", atomic64_read(&stats->page_faults));
+	seq_printf(s, "bus_errors: %lld\n", atomic64_read(&stats->bus_errors));
+
+	/* The map counters belong to the domain, which may be shared */
+	if (!iommu->domain)
+		return 0;
+
+	rk_domain = to_rk_domain(iommu->domain);
+	seq_printf(s, "map: %lld\n", atomic64_read(&rk_domain->stats.map));
+	seq_printf(s, "map_pages: %lld\n",
+		   atomic64_read(&rk_domain->stats.map_pages));
+	seq_printf(s, "unmap: %lld\n", atomic64_read(&rk_domain->stats.unmap));
+	seq_printf(s, "unmap_pages: %lld\n",
+		   atomic64_read(&rk_domain->stats.unmap_pages));
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(rk_iommu_stats);
+
+static void rk_iommu_debugfs_init(struct rk_iommu *iommu)
+{
+	if (!rk_iommu_debugfs_dir)
+		rk_iommu_debugfs_dir = debugfs_create_dir("rockchip",
+							  iommu_debugfs_dir);
+
+	debugfs_create_file(dev_name(iommu->dev), 0444, rk_iommu_debugfs_dir,
+			    iommu, &rk_iommu_stats_fops);
+}
+#else
+static inline void rk_iommu_debugfs_init(struct rk_iommu *iommu)
+{
+}
+#endif
+
 static int rk_iommu_probe(struct platform_device *pdev)
 {
 	struct device *dev = &pdev->dev;
@@ -1641,7 +1897,7 @@ static int rk_iommu_probe(struct platform_device *pdev)
 		return err;
 
 alloc_group:
-	iommu->group = iommu_group_alloc();
+	iommu->group = rk_iommu_group_alloc(iommu);
 	if (IS_ERR(iommu->group)) {
 		err = PTR_ERR(iommu->group);
 		goto err_unprepare_clocks;
@@ -1701,6 +1957,8 @@ static int rk_iommu_probe(struct platform_device *pdev)
 
 	dma_set_mask_and_coherent(dev, rk_ops->dma_bit_mask);
 
+	rk_iommu_debugfs_init(iommu);
+
 	return 0;
 err_pm_disable:
 	pm_runtime_disable(dev);
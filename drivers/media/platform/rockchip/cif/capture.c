@@ -770,6 +770,7 @@ static int rkcif_output_fmt_check(struct rkcif_stream *stream,
 }
 
 static int rkcif_stop_dma_capture(struct rkcif_stream *stream);
+static void rkcif_tasklet_handle(unsigned long data);
 
 struct rkcif_rx_buffer *to_cif_rx_buf(struct rkisp_rx_buf *dbufs)
 {
@@ -5167,10 +5168,12 @@ void rkcif_free_rx_buf(struct rkcif_stream *stream, int buf_num)
 		if (buf->dbufs.is_init)
 			v4l2_subdev_call(sd, core, ioctl,
 					 RKISP_VICAP_CMD_RX_BUFFER_FREE, &buf->dbufs);
-		if (!dev->is_thunderboot)
-			rkcif_free_buffer(dev, &buf->dummy);
-		else
+		if (dev->is_thunderboot)
 			list_add_tail(&buf->list_free, &priv->buf_free_list);
+		else if (rkcif_rx_buf_pool && buf->dummy.mem_priv)
+			buf->dummy.is_free = true;
+		else
+			rkcif_free_buffer(dev, &buf->dummy);
 		atomic_dec(&stream->buf_cnt);
 		stream->total_buf_num--;
 	}
@@ -5185,6 +5188,61 @@ void rkcif_free_rx_buf(struct rkcif_stream *stream, int buf_num)
 		 "free rx_buf, buf_num %d\n", buf_num);
 }
 
+/*
+ * The rx buffers released by rkcif_free_rx_buf() stay allocated in
+ * stream->rx_buf[] while rkcif_rx_buf_pool is set, so that a restart
+ * of the toisp stream, e.g. for a sensor mode switch, can skip the
+ * allocation. The pool is dropped at power off.
+ */
+void rkcif_free_rx_buf_pool(struct rkcif_stream *stream)
+{
+	struct rkcif_device *dev = stream->cifdev;
+	struct rkcif_rx_buffer *buf;
+	int i;
+
+	for (i = 0; i < RKISP_VICAP_BUF_CNT_MAX; i++) {
+		buf = &stream->rx_buf[i];
+		if (buf->dummy.is_free && buf->dummy.mem_priv)
+			rkcif_free_buffer(dev, &buf->dummy);
+	}
+	stream->rx_pool_size = 0;
+}
+
+int rkcif_get_rx_buf_pool_cnt(struct rkcif_stream *stream)
+{
+	int i, cnt = 0;
+
+	for (i = 0; i < RKISP_VICAP_BUF_CNT_MAX; i++) {
+		if (stream->rx_buf[i].dummy.is_free &&
+		    stream->rx_buf[i].dummy.mem_priv)
+			cnt++;
+	}
+	return cnt;
+}
+
+static bool rkcif_get_rx_buf_from_pool(struct rkcif_stream *stream,
+				       struct rkcif_rx_buffer *buf, u32 size)
+{
+	struct rkcif_device *dev = stream->cifdev;
+	struct rkcif_dummy_buffer dummy;
+
+	if (!buf->dummy.is_free || !buf->dummy.mem_priv)
+		return false;
+
+	if (!rkcif_rx_buf_pool || dev->is_thunderboot ||
+	    dev->is_rtt_suspend || dev->is_aov_reserved ||
+	    buf->dummy.size < PAGE_ALIGN(size)) {
+		rkcif_free_buffer(dev, &buf->dummy);
+		return false;
+	}
+
+	dummy = buf->dummy;
+	memset(buf, 0, sizeof(*buf));
+	buf->dummy = dummy;
+	buf->dbufs.dbuf = dummy.dbuf;
+	return true;
+}
+
 static void rkcif_get_resmem_head(struct rkcif_device *cif_dev);
 int rkcif_init_rx_buf(struct rkcif_stream *stream, int buf_num)
 {
@@ -5193,6 +5251,7 @@ int rkcif_init_rx_buf(struct rkcif_stream *stream, int buf_num)
 	struct rkcif_dummy_buffer *dummy;
 	struct rkcif_rx_buffer *buf;
 	struct sditf_priv *priv = dev->sditf[0];
+	u32 size = pixm->plane_fmt[0].sizeimage;
 	int frm_type = 0;
 	int i = 0;
 	int ret = 0;
@@ -5203,6 +5262,9 @@ int rkcif_init_rx_buf(struct rkcif_stream *stream, int buf_num)
 	if (buf_num > RKISP_VICAP_BUF_CNT_MAX)
 		return -EINVAL;
 
+	if (size > stream->rx_pool_size)
+		stream->rx_pool_size = size;
+
 	if (dev->hdr.hdr_mode == NO_HDR) {
 		if (stream->id == 0)
 			frm_type = BUF_SHORT;
@@ -5227,12 +5289,20 @@ int rkcif_init_rx_buf(struct rkcif_stream *stream, int buf_num)
 	}
 	while (true) {
 		buf = &stream->rx_buf[i];
-		memset(buf, 0, sizeof(*buf));
-		dummy = &buf->dummy;
-		dummy->size = pixm->plane_fmt[0].sizeimage;
-		dummy->is_need_vaddr = true;
-		dummy->is_need_dbuf = true;
-		if (dev->is_thunderboot || dev->is_rtt_suspend || dev->is_aov_reserved) {
+		if (rkcif_get_rx_buf_from_pool(stream, buf, size)) {
+			dummy = &buf->dummy;
+		} else {
+			memset(buf, 0, sizeof(*buf));
+			dummy = &buf->dummy;
+			dummy->size = size;
+			dummy->is_need_vaddr = true;
+			dummy->is_need_dbuf = true;
+		}
+		if (dummy->mem_priv) {
+			v4l2_dbg(1, rkcif_debug, &dev->v4l2_dev,
+				 "stream[%d] reuse rx_buf[%d] size 0x%x\n",
+				 stream->id, i, dummy->size);
+		} else if (dev->is_thunderboot || dev->is_rtt_suspend || dev->is_aov_reserved) {
 			if (i == 0)
 				rkcif_get_resmem_head(dev);
 			buf->buf_idx = i;
@@ -5249,6 +5319,9 @@ int rkcif_init_rx_buf(struct rkcif_stream *stream, int buf_num)
 					  "stream[%d] buf addr 0x%llx\n",
 					  stream->id, (u64)dummy->dma_addr);
 		} else {
+			/* size by the largest mode seen so it can be reused */
+			if (rkcif_rx_buf_pool)
+				dummy->size = stream->rx_pool_size;
 			ret = rkcif_alloc_buffer(dev, dummy);
 			if (ret) {
 				stream->rx_buf_num = i;
@@ -5809,8 +5882,11 @@ void rkcif_do_stop_stream(struct rkcif_stream *stream,
 			rkcif_destroy_dummy_buf(stream);
 	}
 	if (mode == RKCIF_STREAM_MODE_CAPTURE) {
+		/* deliver the frames held for a batch */
+		rkcif_tasklet_handle((unsigned long)stream);
 		tasklet_disable(&stream->vb_done_tasklet);
 		INIT_LIST_HEAD(&stream->vb_done_list);
+		stream->vb_done_cnt = 0;
 	}
 
 	if (mode == stream->cur_stream_mode)
@@ -8329,6 +8405,14 @@ static long rkcif_ioctl_default(struct file *file, void *fh,
 		fps = *(struct rkcif_fps *)arg;
 		rkcif_set_fps(stream, &fps);
 		break;
+	case RKCIF_CMD_SET_BATCH_NUM:
+		if (*(unsigned int *)arg > RKCIF_MAX_BATCH_NUM)
+			return -EINVAL;
+		stream->batch_num = *(unsigned int *)arg;
+		break;
+	case RKCIF_CMD_GET_BATCH_NUM:
+		*(unsigned int *)arg = stream->batch_num;
+		break;
 	case RKCIF_CMD_SET_RESET:
 		reset_src = *(int *)arg;
 		return rkcif_do_reset_work(dev, reset_src);
@@ -8558,6 +8642,7 @@ static void rkcif_tasklet_handle(unsigned long data)
 
 	spin_lock_irqsave(&stream->vbq_lock, flags);
 	list_replace_init(&stream->vb_done_list, &local_list);
+	stream->vb_done_cnt = 0;
 	spin_unlock_irqrestore(&stream->vbq_lock, flags);
 
 	while (!list_empty(&local_list)) {
@@ -8575,13 +8660,21 @@ static void rkcif_tasklet_handle(unsigned long data)
 void rkcif_vb_done_tasklet(struct rkcif_stream *stream, struct rkcif_buffer *buf)
 {
 	unsigned long flags = 0;
+	bool is_hold;
 
 	if (!stream || !buf)
 		return;
 	spin_lock_irqsave(&stream->vbq_lock, flags);
 	list_add_tail(&buf->queue, &stream->vb_done_list);
+	/*
+	 * hold the frames until a batch is complete, but not when no buffer
+	 * is left for capture, userspace needs them back to queue again.
+	 */
+	is_hold = ++stream->vb_done_cnt < stream->batch_num &&
+		  !list_empty(&stream->buf_head);
 	spin_unlock_irqrestore(&stream->vbq_lock, flags);
-	tasklet_schedule(&stream->vb_done_tasklet);
+	if (!is_hold)
+		tasklet_schedule(&stream->vb_done_tasklet);
 }
 
 static void rkcif_unregister_stream_vdev(struct rkcif_stream *stream)
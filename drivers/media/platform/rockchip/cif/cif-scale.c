@@ -1176,8 +1176,6 @@ static void rkcif_scale_vb_done_oneframe(struct rkcif_scale_vdev *scale_vdev,
 				      scale_vdev->pixm.plane_fmt[i].sizeimage);
 	}
 
-	vb_done->vb2_buf.timestamp = rkcif_time_get_ns(scale_vdev->cifdev);
-
 	vb2_buffer_done(&vb_done->vb2_buf, VB2_BUF_STATE_DONE);
 	v4l2_dbg(3, rkcif_debug, &scale_vdev->cifdev->v4l2_dev,
 		 "sub_stream[%d] vb done, index: %d, sequence %d\n", scale_vdev->ch,
@@ -1208,7 +1206,11 @@ static void rkcif_scale_update_stream(struct rkcif_scale_vdev *scale_vdev, int c
 		scale_vdev->frame_idx = scale_vdev->stream->frame_idx;
 	if (active_buf && (!ret)) {
 		vb_done = &active_buf->vb;
-		vb_done->vb2_buf.timestamp = ktime_get_ns();
+		/*
+		 * Stamp like the full resolution frame it was scaled from, so
+		 * both can be paired by sequence and timestamp.
+		 */
+		vb_done->vb2_buf.timestamp = scale_vdev->stream->readout.fs_timestamp;
 		vb_done->sequence = scale_vdev->frame_idx - 1;
 		rkcif_scale_vb_done_oneframe(scale_vdev, vb_done);
 	}
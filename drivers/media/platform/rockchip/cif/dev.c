@@ -36,6 +36,10 @@ int rkcif_debug;
 module_param_named(debug, rkcif_debug, int, 0644);
 MODULE_PARM_DESC(debug, "Debug level (0-1)");
 
+bool rkcif_rx_buf_pool = true;
+module_param_named(rx_buf_pool, rkcif_rx_buf_pool, bool, 0644);
+MODULE_PARM_DESC(rx_buf_pool, "Keep toisp rx buffers allocated across stream restart");
+
 static char rkcif_version[RKCIF_VERNO_LEN];
 module_param_string(version, rkcif_version, RKCIF_VERNO_LEN, 0444);
 MODULE_PARM_DESC(version, "version number");
@@ -210,6 +210,7 @@ struct rkcif_tools_buffer {
 };
 
 extern int rkcif_debug;
+extern bool rkcif_rx_buf_pool;
 
 /*
  * struct rkcif_sensor_info - Sensor infomations
@@ -560,12 +561,15 @@ struct rkcif_stream {
 	struct list_head		rx_buf_head;
 	int				total_buf_num;
 	int				rx_buf_num;
+	u32				rx_pool_size;
 	u64				line_int_cnt;
 	int				lack_buf_cnt;
 	unsigned int			buf_wake_up_cnt;
 	struct rkcif_skip_info		skip_info;
 	struct tasklet_struct		vb_done_tasklet;
 	struct list_head		vb_done_list;
+	unsigned int			vb_done_cnt;
+	unsigned int			batch_num;
 	int				last_rx_buf_idx;
 	int				last_frame_idx;
 	int				new_fource_idx;
@@ -1036,6 +1040,8 @@ void rkcif_vb_done_oneframe(struct rkcif_stream *stream,
 
 int rkcif_init_rx_buf(struct rkcif_stream *stream, int buf_num);
 void rkcif_free_rx_buf(struct rkcif_stream *stream, int buf_num);
+void rkcif_free_rx_buf_pool(struct rkcif_stream *stream);
+int rkcif_get_rx_buf_pool_cnt(struct rkcif_stream *stream);
 
 int rkcif_set_fmt(struct rkcif_stream *stream,
 		       struct v4l2_pix_format_mplane *pixm,
@@ -371,6 +371,16 @@ static void rkcif_show_format(struct rkcif_device *dev, struct seq_file *f)
 			   dev->stream[1].total_buf_num,
 			   dev->stream[2].total_buf_num,
 			   dev->stream[3].total_buf_num);
+		seq_printf(f, "rx_buf in use/pool: %d/%d %d/%d %d/%d size 0x%x 0x%x 0x%x\n",
+			   dev->stream[0].rx_buf_num,
+			   rkcif_get_rx_buf_pool_cnt(&dev->stream[0]),
+			   dev->stream[1].rx_buf_num,
+			   rkcif_get_rx_buf_pool_cnt(&dev->stream[1]),
+			   dev->stream[2].rx_buf_num,
+			   rkcif_get_rx_buf_pool_cnt(&dev->stream[2]),
+			   dev->stream[0].rx_pool_size,
+			   dev->stream[1].rx_pool_size,
+			   dev->stream[2].rx_pool_size);
 	}
 }
 
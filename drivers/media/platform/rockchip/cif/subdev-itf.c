@@ -963,6 +963,9 @@ static int sditf_s_power(struct v4l2_subdev *sd, int on)
 			v4l2_pipeline_pm_put(&node->vdev.entity);
 			pm_runtime_put_sync(cif_dev->dev);
 			priv->mode.rdbk_mode = RKISP_VICAP_RDBK_AIQ;
+			rkcif_free_rx_buf_pool(&cif_dev->stream[0]);
+			rkcif_free_rx_buf_pool(&cif_dev->stream[1]);
+			rkcif_free_rx_buf_pool(&cif_dev->stream[2]);
 		}
 		v4l2_dbg(1, rkcif_debug, &node->vdev, "s_power %d, entity use_count %d\n",
 			  on, node->vdev.entity.use_count);
@@ -60,6 +60,15 @@ static bool low_latency;
 module_param(low_latency, bool, 0644);
 MODULE_PARM_DESC(low_latency, "low_latency en(0-1)");
 
+/*
+ * In low latency mode the buffer is returned when this many lines of the
+ * frame are written, with a fence in timecode.userbits signaled at frame
+ * end. 0 uses the default of 10 lines for 60fps and 2/3 of frame else.
+ */
+static int low_latency_line;
+module_param(low_latency_line, int, 0644);
+MODULE_PARM_DESC(low_latency_line, "low_latency line flag num, 0: default");
+
 #define	RK_HDMIRX_DRVNAME		"rk_hdmirx"
 #define EDID_NUM_BLOCKS_MAX		2
 #define EDID_BLOCK_SIZE			128
@@ -75,6 +84,11 @@ MODULE_PARM_DESC(low_latency, "low_latency en(0-1)");
 #define RK_IRQ_HDMIRX_HDMI		210
 #define FILTER_FRAME_CNT		6
 #define CPU_LIMIT_FREQ_KHZ		1200000
+#define CPU_LIMIT_FREQ_MIN_KHZ		408000
+#define CPU_LIMIT_FREQ_MAX_KHZ		1800000
+#define CPU_LIMIT_FREQ_STEP_KHZ		200000
+/* pixel clock of 4K60 that CPU_LIMIT_FREQ_KHZ was tuned for */
+#define CPU_LIMIT_REF_PIXCLK_KHZ	594000
 #define WAIT_PHY_REG_TIME		50
 #define WAIT_TIMER_LOCK_TIME		50
 #define WAIT_SIGNAL_LOCK_TIME		600 /* if 5V present: 7ms each time */
@@ -279,6 +293,10 @@ struct rk_hdmirx_dev {
 	u32 cur_color_space;
 	u32 color_depth;
 	u32 cpu_freq_khz;
+	u32 cpu_freq_boost_khz;
+	u64 line_flag_ns;
+	u32 line_flag_avg_ns;
+	atomic_t line_flag_late_cnt;
 	u32 bound_cpu;
 	u32 phy_cpuid;
 	u32 fps;
@@ -306,6 +324,7 @@ static void hdmirx_audio_handle_plugged_change(struct rk_hdmirx_dev *hdmirx_dev,
 static void hdmirx_audio_interrupts_setup(struct rk_hdmirx_dev *hdmirx_dev, bool en);
 static int hdmirx_set_cpu_limit_freq(struct rk_hdmirx_dev *hdmirx_dev);
 static void hdmirx_cancel_cpu_limit_freq(struct rk_hdmirx_dev *hdmirx_dev);
+static void hdmirx_update_cpu_limit_freq(struct rk_hdmirx_dev *hdmirx_dev);
 static void hdmirx_plugout(struct rk_hdmirx_dev *hdmirx_dev);
 static void process_signal_change(struct rk_hdmirx_dev *hdmirx_dev);
 static void hdmirx_interrupts_setup(struct rk_hdmirx_dev *hdmirx_dev, bool en);
@@ -2361,7 +2380,9 @@ static int hdmirx_start_streaming(struct vb2_queue *queue, unsigned int count)
 		else
 			line_flag = bt->height;
 
-		if (low_latency && hdmirx_dev->fps >= 59)
+		if (low_latency && low_latency_line > 0)
+			delay_line = clamp(low_latency_line, 1, line_flag - 1);
+		else if (low_latency && hdmirx_dev->fps >= 59)
 			delay_line = 10;
 		else
 			delay_line = line_flag * 2 / 3;
@@ -3063,6 +3084,23 @@ static void line_flag_int_handler(struct rk_hdmirx_dev *hdmirx_dev, bool *handle
 	struct v4l2_bt_timings *bt = &timings.bt;
 	u32 dma_cfg6;
 	struct vb2_v4l2_buffer *vb_done = NULL;
+	u64 ns = ktime_get_ns();
+	u32 interval;
+
+	/* a late line flag irq means the cpu is too slow to serve the dma */
+	if (hdmirx_dev->line_flag_ns) {
+		interval = min_t(u64, ns - hdmirx_dev->line_flag_ns, NSEC_PER_SEC);
+		if (hdmirx_dev->line_flag_avg_ns &&
+		    interval > hdmirx_dev->line_flag_avg_ns +
+			       hdmirx_dev->line_flag_avg_ns / 8)
+			atomic_inc(&hdmirx_dev->line_flag_late_cnt);
+		if (hdmirx_dev->line_flag_avg_ns)
+			hdmirx_dev->line_flag_avg_ns = (hdmirx_dev->line_flag_avg_ns * 7 +
+							interval) / 8;
+		else
+			hdmirx_dev->line_flag_avg_ns = interval;
+	}
+	hdmirx_dev->line_flag_ns = ns;
 
 	stream->line_flag_int_cnt++;
 	if (!(stream->irq_stat) && !(stream->irq_stat & HDMIRX_DMA_IDLE_INT))
@@ -3288,6 +3326,8 @@ static void hdmirx_plugin(struct rk_hdmirx_dev *hdmirx_dev)
 	schedule_delayed_work_on(hdmirx_dev->bound_cpu,
 		&hdmirx_dev->delayed_work_heartbeat, msecs_to_jiffies(10));
 	sip_wdt_config(WDT_START, 0, 0, 0);
+	hdmirx_dev->cpu_freq_boost_khz = 0;
+	hdmirx_dev->cpu_freq_khz = CPU_LIMIT_FREQ_KHZ;
 	hdmirx_set_cpu_limit_freq(hdmirx_dev);
 	hdmirx_interrupts_setup(hdmirx_dev, false);
 	hdmirx_submodule_init(hdmirx_dev);
@@ -3306,6 +3346,7 @@ static void hdmirx_plugin(struct rk_hdmirx_dev *hdmirx_dev)
 					 msecs_to_jiffies(1000));
 		return;
 	}
+	hdmirx_update_cpu_limit_freq(hdmirx_dev);
 	hdmirx_dma_config(hdmirx_dev);
 	hdmirx_interrupts_setup(hdmirx_dev, true);
 	extcon_set_state_sync(hdmirx_dev->extcon, EXTCON_JACK_VIDEO_IN, true);
@@ -3337,6 +3378,8 @@ static void hdmirx_plugout(struct rk_hdmirx_dev *hdmirx_dev)
 	cancel_delayed_work(&hdmirx_dev->delayed_work_audio);
 	cpu_latency_qos_update_request(&hdmirx_dev->pm_qos, PM_QOS_DEFAULT_VALUE);
 	hdmirx_cancel_cpu_limit_freq(hdmirx_dev);
+	hdmirx_dev->line_flag_ns = 0;
+	hdmirx_dev->line_flag_avg_ns = 0;
 	cancel_delayed_work(&hdmirx_dev->delayed_work_heartbeat);
 	flush_work(&hdmirx_dev->work_wdt_config);
 	sip_wdt_config(WDT_STOP, 0, 0, 0);
@@ -3737,6 +3780,7 @@ static void hdmirx_delayed_work_res_change(struct work_struct *work)
 						 &hdmirx_dev->delayed_work_hotplug,
 						 msecs_to_jiffies(1000));
 		} else {
+			hdmirx_update_cpu_limit_freq(hdmirx_dev);
 			hdmirx_dma_config(hdmirx_dev);
 			hdmirx_interrupts_setup(hdmirx_dev, true);
 			hdmirx_audio_handle_plugged_change(hdmirx_dev, 1);
@@ -3753,6 +3797,7 @@ static void hdmirx_delayed_work_heartbeat(struct work_struct *work)
 
 	queue_work_on(hdmirx_dev->wdt_cfg_bound_cpu,  system_highpri_wq,
 			&hdmirx_dev->work_wdt_config);
+	hdmirx_update_cpu_limit_freq(hdmirx_dev);
 	schedule_delayed_work_on(hdmirx_dev->bound_cpu,
 			&hdmirx_dev->delayed_work_heartbeat, HZ);
 }
@@ -4535,6 +4580,9 @@ static int hdmirx_status_show(struct seq_file *s, void *v)
 	else
 		seq_puts(s, "Unknown\n");
 
+	seq_printf(s, "CPU Freq Floor: %u kHz (boost %u kHz)\n",
+		   hdmirx_dev->cpu_freq_khz, hdmirx_dev->cpu_freq_boost_khz);
+
 	return 0;
 }
 
@@ -4602,6 +4650,55 @@ static int hdmirx_set_cpu_limit_freq(struct rk_hdmirx_dev *hdmirx_dev)
 	return 0;
 }
 
+/*
+ * The cpu freq floor scales with the pixel clock and color depth from
+ * CPU_LIMIT_FREQ_KHZ at 4K60 8bit, and steps up while the line flag irq
+ * is late, then back down once it is served in time again.
+ */
+static u32 hdmirx_calc_cpu_limit_freq(struct rk_hdmirx_dev *hdmirx_dev)
+{
+	struct v4l2_bt_timings *bt = &hdmirx_dev->timings.bt;
+	u64 khz;
+
+	if (!hdmirx_dev->get_timing || !bt->pixelclock)
+		return CPU_LIMIT_FREQ_KHZ;
+
+	khz = div_u64(bt->pixelclock, 1000) * CPU_LIMIT_FREQ_KHZ;
+	khz = div_u64(khz, CPU_LIMIT_REF_PIXCLK_KHZ);
+	if (hdmirx_dev->color_depth > 24)
+		khz = div_u64(khz * hdmirx_dev->color_depth, 24);
+	khz += hdmirx_dev->cpu_freq_boost_khz;
+
+	return clamp_t(u64, khz, CPU_LIMIT_FREQ_MIN_KHZ, CPU_LIMIT_FREQ_MAX_KHZ);
+}
+
+static void hdmirx_update_cpu_limit_freq(struct rk_hdmirx_dev *hdmirx_dev)
+{
+	struct v4l2_device *v4l2_dev = &hdmirx_dev->v4l2_dev;
+	u32 late_cnt, khz;
+
+	if (!hdmirx_dev->freq_qos_add)
+		return;
+
+	late_cnt = atomic_xchg(&hdmirx_dev->line_flag_late_cnt, 0);
+	if (late_cnt) {
+		if (hdmirx_dev->cpu_freq_boost_khz < CPU_LIMIT_FREQ_MAX_KHZ)
+			hdmirx_dev->cpu_freq_boost_khz += CPU_LIMIT_FREQ_STEP_KHZ;
+	} else if (hdmirx_dev->cpu_freq_boost_khz) {
+		hdmirx_dev->cpu_freq_boost_khz -= min_t(u32, CPU_LIMIT_FREQ_STEP_KHZ / 4,
+							hdmirx_dev->cpu_freq_boost_khz);
+	}
+
+	khz = hdmirx_calc_cpu_limit_freq(hdmirx_dev);
+	if (khz == hdmirx_dev->cpu_freq_khz)
+		return;
+
+	v4l2_dbg(1, debug, v4l2_dev, "%s: cpu freq %u -> %u khz, late:%u\n",
+		 __func__, hdmirx_dev->cpu_freq_khz, khz, late_cnt);
+	hdmirx_dev->cpu_freq_khz = khz;
+	freq_qos_update_request(&hdmirx_dev->min_sta_freq_req, khz);
+}
+
 static void hdmirx_cancel_cpu_limit_freq(struct rk_hdmirx_dev *hdmirx_dev)
 {
 	if (hdmirx_dev->freq_qos_add)
@@ -2,6 +2,8 @@
 /* Copyright (c) 2020 Rockchip Electronics Co., Ltd. */
 
 #include <linux/delay.h>
+#include <linux/dma-fence.h>
+#include <linux/dma-resv.h>
 #include <linux/pm_runtime.h>
 #include <media/v4l2-common.h>
 #include <media/v4l2-event.h>
@@ -13,6 +15,9 @@
 #include "regs.h"
 #include "rkisp_tb_helper.h"
 
+#define CREATE_TRACE_POINTS
+#include "rkisp_trace.h"
+
 #define STREAM_MIN_MP_SP_INPUT_WIDTH		STREAM_MIN_RSZ_OUTPUT_WIDTH
 #define STREAM_MIN_MP_SP_INPUT_HEIGHT		STREAM_MIN_RSZ_OUTPUT_HEIGHT
 
@@ -879,11 +884,104 @@ int rkisp_fh_open(struct file *filp)
 	return ret;
 }
 
+static const char *rkisp_fence_get_driver_name(struct dma_fence *fence)
+{
+	return DRIVER_NAME;
+}
+
+static const char *rkisp_fence_get_timeline_name(struct dma_fence *fence)
+{
+	return "rkisp_out";
+}
+
+static const struct dma_fence_ops rkisp_fence_ops = {
+	.get_driver_name = rkisp_fence_get_driver_name,
+	.get_timeline_name = rkisp_fence_get_timeline_name,
+};
+
+static void rkisp_buf_fence_signal(struct rkisp_buffer *buf, int error)
+{
+	struct dma_fence *fence = xchg(&buf->out_fence, NULL);
+
+	if (!fence)
+		return;
+	if (error)
+		dma_fence_set_error(fence, error);
+	dma_fence_signal(fence);
+	dma_fence_put(fence);
+}
+
+static void rkisp_stream_fence_flush(struct rkisp_stream *stream)
+{
+	struct vb2_queue *q = &stream->vnode.buf_queue;
+	struct vb2_buffer *vb;
+	u32 i;
+
+	for (i = 0; i < q->num_buffers; i++) {
+		vb = vb2_get_buffer(q, i);
+		if (vb)
+			rkisp_buf_fence_signal(to_rkisp_buffer(to_vb2_v4l2_buffer(vb)),
+					       -ECANCELED);
+	}
+}
+
+/* attach a write fence to the dmabuf before it is handed to the hardware */
+static void rkisp_buf_fence_attach(struct rkisp_stream *stream,
+				   struct v4l2_buffer *p)
+{
+	struct vb2_queue *q = &stream->vnode.buf_queue;
+	struct dma_fence *fence;
+	struct vb2_buffer *vb;
+	struct dma_buf *dbuf;
+	unsigned long flags;
+	int fd, ret;
+
+	if (!stream->out_fence_en || p->memory != V4L2_MEMORY_DMABUF)
+		return;
+	vb = vb2_get_buffer(q, p->index);
+	if (!vb || vb->state != VB2_BUF_STATE_DEQUEUED)
+		return;
+	if (V4L2_TYPE_IS_MULTIPLANAR(p->type)) {
+		if (!p->length)
+			return;
+		fd = p->m.planes[0].m.fd;
+	} else {
+		fd = p->m.fd;
+	}
+	dbuf = dma_buf_get(fd);
+	if (IS_ERR(dbuf))
+		return;
+	fence = kzalloc(sizeof(*fence), GFP_KERNEL);
+	if (!fence)
+		goto put_dbuf;
+	spin_lock_irqsave(&stream->fence_lock, flags);
+	dma_fence_init(fence, &rkisp_fence_ops, &stream->fence_lock,
+		       stream->fence_ctx, ++stream->fence_seqno);
+	spin_unlock_irqrestore(&stream->fence_lock, flags);
+
+	dma_resv_lock(dbuf->resv, NULL);
+	ret = dma_resv_reserve_fences(dbuf->resv, 1);
+	if (!ret)
+		dma_resv_add_fence(dbuf->resv, fence, DMA_RESV_USAGE_WRITE);
+	dma_resv_unlock(dbuf->resv);
+	if (ret) {
+		dma_fence_put(fence);
+		goto put_dbuf;
+	}
+	/* the reference of dma_fence_init is kept until signaled */
+	rkisp_buf_fence_signal(to_rkisp_buffer(to_vb2_v4l2_buffer(vb)), -ECANCELED);
+	to_rkisp_buffer(to_vb2_v4l2_buffer(vb))->out_fence = fence;
+put_dbuf:
+	dma_buf_put(dbuf);
+}
+
 int rkisp_fop_release(struct file *file)
 {
 	struct rkisp_stream *stream = video_drvdata(file);
 	int ret;
 
+	if (stream->vnode.vdev.queue->owner == file->private_data)
+		rkisp_stream_fence_flush(stream);
 	ret = vb2_fop_release(file);
 	if (!ret)
 		v4l2_pipeline_pm_put(&stream->vnode.vdev.entity);
@@ -1334,6 +1432,9 @@ static long rkisp_ioctl_default(struct file *file, void *fh,
 	case RKISP_CMD_SET_IQTOOL_CONN_ID:
 		ret = rkisp_set_iqtool_connect_id(stream, *(int *)arg);
 		break;
+	case RKISP_CMD_SET_OUT_FENCE:
+		stream->out_fence_en = !!*(int *)arg;
+		break;
 	default:
 		ret = -EINVAL;
 	}
@@ -1595,16 +1696,71 @@ static int rkisp_querycap(struct file *file, void *priv,
 	return 0;
 }
 
+static int rkisp_ioctl_qbuf(struct file *file, void *priv,
+			    struct v4l2_buffer *p)
+{
+	struct rkisp_stream *stream = video_drvdata(file);
+	struct vb2_buffer *vb;
+	int ret;
+
+	if (vb2_queue_is_busy(stream->vnode.vdev.queue, file))
+		return -EBUSY;
+	rkisp_buf_fence_attach(stream, p);
+	ret = vb2_ioctl_qbuf(file, priv, p);
+	if (ret) {
+		vb = vb2_get_buffer(&stream->vnode.buf_queue, p->index);
+		if (vb && vb->state == VB2_BUF_STATE_DEQUEUED)
+			rkisp_buf_fence_signal(to_rkisp_buffer(to_vb2_v4l2_buffer(vb)), ret);
+	}
+	return ret;
+}
+
+static int rkisp_ioctl_dqbuf(struct file *file, void *priv,
+			     struct v4l2_buffer *p)
+{
+	struct rkisp_stream *stream = video_drvdata(file);
+	struct vb2_buffer *vb;
+	u32 us;
+	int ret;
+
+	ret = vb2_ioctl_dqbuf(file, priv, p);
+	if (ret)
+		return ret;
+
+	vb = vb2_get_buffer(&stream->vnode.buf_queue, p->index);
+	if (!vb)
+		return 0;
+	/* completed without the buf done tasklet */
+	rkisp_buf_fence_signal(to_rkisp_buffer(to_vb2_v4l2_buffer(vb)),
+			       p->flags & V4L2_BUF_FLAG_ERROR ? -EIO : 0);
+	us = rkisp_stream_lat_record(stream, stream->lat.dqbuf, vb->timestamp);
+	trace_rkisp_buf_dqbuf(stream->ispdev->dev_id, stream->id,
+			      p->sequence, us);
+	return 0;
+}
+
+static int rkisp_ioctl_streamoff(struct file *file, void *priv,
+				 enum v4l2_buf_type type)
+{
+	struct rkisp_stream *stream = video_drvdata(file);
+	int ret;
+
+	ret = vb2_ioctl_streamoff(file, priv, type);
+	if (!ret)
+		rkisp_stream_fence_flush(stream);
+	return ret;
+}
+
 static const struct v4l2_ioctl_ops rkisp_v4l2_ioctl_ops = {
 	.vidioc_reqbufs = vb2_ioctl_reqbufs,
 	.vidioc_querybuf = vb2_ioctl_querybuf,
 	.vidioc_create_bufs = vb2_ioctl_create_bufs,
-	.vidioc_qbuf = vb2_ioctl_qbuf,
+	.vidioc_qbuf = rkisp_ioctl_qbuf,
 	.vidioc_expbuf = vb2_ioctl_expbuf,
-	.vidioc_dqbuf = vb2_ioctl_dqbuf,
+	.vidioc_dqbuf = rkisp_ioctl_dqbuf,
 	.vidioc_prepare_buf = vb2_ioctl_prepare_buf,
 	.vidioc_streamon = vb2_ioctl_streamon,
-	.vidioc_streamoff = vb2_ioctl_streamoff,
+	.vidioc_streamoff = rkisp_ioctl_streamoff,
 	.vidioc_enum_input = rkisp_enum_input,
 	.vidioc_try_fmt_vid_cap_mplane = rkisp_try_fmt_vid_cap_mplane,
 	.vidioc_enum_fmt_vid_cap = rkisp_enum_fmt_vid_cap_mplane,
@@ -1618,6 +1774,35 @@ static const struct v4l2_ioctl_ops rkisp_v4l2_ioctl_ops = {
 	.vidioc_default = rkisp_ioctl_default,
 };
 
+/* record the latency from the frame start timestamp, return it in us */
+static u32 rkisp_stream_lat_record(struct rkisp_stream *stream,
+				   u32 *hist, u64 timestamp)
+{
+	u64 ns = rkisp_time_get_ns(stream->ispdev);
+	u32 us = ns > timestamp ? div_u64(ns - timestamp, 1000) : 0;
+
+	hist[min_t(u32, us ? ilog2(us) : 0, RKISP_LAT_BUCKETS - 1)]++;
+	return us;
+}
+
+/* upper bound in us of the bucket holding pct percent of the samples */
+u32 rkisp_stream_lat_pct(const u32 *hist, u32 pct)
+{
+	u64 total = 0, sum = 0;
+	int i;
+
+	for (i = 0; i < RKISP_LAT_BUCKETS; i++)
+		total += hist[i];
+	if (!total)
+		return 0;
+	for (i = 0; i < RKISP_LAT_BUCKETS; i++) {
+		sum += hist[i];
+		if (sum * 100 >= total * pct)
+			break;
+	}
+	return 1U << (min(i, RKISP_LAT_BUCKETS - 1) + 1);
+}
+
 static void rkisp_buf_done_task(unsigned long arg)
 {
 	struct rkisp_stream *stream = (struct rkisp_stream *)arg;
@@ -1631,6 +1816,7 @@ static void rkisp_buf_done_task(unsigned long arg)
 
 	while (!list_empty(&local_list)) {
 		u64 *data;
+		u32 us;
 
 		buf = list_first_entry(&local_list,
 				       struct rkisp_buffer, queue);
@@ -1643,6 +1829,11 @@ static void rkisp_buf_done_task(unsigned long arg)
 			v4l2_dbg(0, rkisp_debug, &stream->ispdev->v4l2_dev,
 				 "seq:%d data no update:%llx %llx\n",
 				 buf->vb.sequence, *data, *(data + 1));
+		us = rkisp_stream_lat_record(stream, stream->lat.done,
+					     buf->vb.vb2_buf.timestamp);
+		trace_rkisp_buf_done(stream->ispdev->dev_id, stream->id,
+				     buf->vb.sequence, us);
+		rkisp_buf_fence_signal(buf, stream->streaming ? 0 : -ECANCELED);
 		vb2_buffer_done(&buf->vb.vb2_buf,
 				stream->streaming ? VB2_BUF_STATE_DONE : VB2_BUF_STATE_ERROR);
 	}
@@ -1756,6 +1947,8 @@ int rkisp_register_stream_vdev(struct rkisp_stream *stream)
 	if (ret < 0)
 		goto unreg;
 	INIT_LIST_HEAD(&stream->buf_done_list);
+	spin_lock_init(&stream->fence_lock);
+	stream->fence_ctx = dma_fence_context_alloc(1);
 	tasklet_init(&stream->buf_done_tasklet,
 		     rkisp_buf_done_task,
 		     (unsigned long)stream);
@@ -253,6 +253,18 @@ struct rockit_isp_ops {
 			   bool try);
 };
 
+#define RKISP_LAT_BUCKETS	20
+
+/*
+ * struct rkisp_stream_lat - frame latency histogram of stream
+ * @done: latency from frame start to buffer done, bucket i for [2^i, 2^(i+1)) us
+ * @dqbuf: latency from frame start to buffer dequeue
+ */
+struct rkisp_stream_lat {
+	u32 done[RKISP_LAT_BUCKETS];
+	u32 dqbuf[RKISP_LAT_BUCKETS];
+};
+
 /*
  * struct rkisp_stream - ISP capture video device
  *
@@ -307,6 +319,11 @@ struct rkisp_stream {
 	unsigned int burst;
 	atomic_t sequence;
 	struct frame_debug_info dbg;
+	struct rkisp_stream_lat lat;
+	spinlock_t fence_lock;
+	u64 fence_ctx;
+	u32 fence_seqno;
+	bool out_fence_en;
 	int conn_id;
 	u32 memory;
 	u32 skip_frame;
@@ -366,4 +383,5 @@ int rkisp_get_tb_stream_info(struct rkisp_stream *stream,
 			     struct rkisp_tb_stream_info *info);
 int rkisp_free_tb_stream_buf(struct rkisp_stream *stream);
 int rkisp_stream_buf_cnt(struct rkisp_stream *stream);
+u32 rkisp_stream_lat_pct(const u32 *hist, u32 pct);
 #endif /* _RKISP_PATH_VIDEO_H */
@@ -12,6 +12,7 @@
 #include <media/videobuf2-dma-sg.h>
 #include "dev.h"
 #include "regs.h"
+#include "rkisp_trace.h"
 
 #define CIF_ISP_REQ_BUFS_MIN 0
 
@@ -1008,6 +1009,8 @@ static int mi_frame_end(struct rkisp_stream *stream, u32 state)
 		stream->dbg.timestamp = ns;
 		stream->dbg.id = buf->vb.sequence;
 		stream->dbg.delay = ns - dev->isp_sdev.frm_timestamp;
+		trace_rkisp_mi_done(dev->dev_id, stream->id, buf->vb.sequence,
+				    stream->dbg.delay / 1000);
 
 		if (vir->streaming && vir->conn_id == stream->id) {
 			spin_lock_irqsave(&vir->vbq_lock, lock_flags);
@@ -1471,6 +1474,7 @@ rkisp_start_streaming(struct vb2_queue *queue, unsigned int count)
 	}
 
 	memset(&stream->dbg, 0, sizeof(stream->dbg));
+	memset(&stream->lat, 0, sizeof(stream->lat));
 	atomic_inc(&dev->cap_dev.refcnt);
 	if (!dev->isp_inp || !stream->linked) {
 		v4l2_err(v4l2_dev, "check %s link or isp input\n", node->vdev.name);
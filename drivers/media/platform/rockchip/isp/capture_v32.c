@@ -12,6 +12,7 @@
 #include <media/videobuf2-dma-sg.h>
 #include "dev.h"
 #include "regs.h"
+#include "rkisp_trace.h"
 
 /*			ISP32
  *        |--mainpath----[wrap]--------->enc(or ddr)
@@ -1585,6 +1586,8 @@ static int mi_frame_end(struct rkisp_stream *stream, u32 state)
 		stream->dbg.delay = ns - dev->isp_sdev.frm_timestamp;
 		stream->dbg.timestamp = ns;
 		stream->dbg.id = i;
+		trace_rkisp_mi_done(dev->dev_id, stream->id, i,
+				    stream->dbg.delay / 1000);
 
 		if (vb2_buf->memory) {
 			if (vir->streaming && vir->conn_id == stream->id) {
@@ -2112,6 +2115,7 @@ rkisp_start_streaming(struct vb2_queue *queue, unsigned int count)
 	}
 
 	memset(&stream->dbg, 0, sizeof(stream->dbg));
+	memset(&stream->lat, 0, sizeof(stream->lat));
 
 	if (stream->id == RKISP_STREAM_LUMA) {
 		tasklet_enable(&dev->cap_dev.rd_tasklet);
@@ -2458,6 +2462,8 @@ void rkisp_mi_v32_isr(u32 mis_val, struct rkisp_device *dev)
 			stream->dbg.delay = ns - dev->isp_sdev.frm_timestamp;
 			stream->dbg.timestamp = ns;
 			stream->dbg.id = seq;
+			trace_rkisp_mi_done(dev->dev_id, stream->id, seq,
+					    stream->dbg.delay / 1000);
 		} else {
 			mi_frame_end(stream, FRAME_IRQ);
 		}
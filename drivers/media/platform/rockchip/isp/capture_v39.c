@@ -12,6 +12,7 @@
 #include <media/videobuf2-dma-sg.h>
 #include "dev.h"
 #include "regs.h"
+#include "rkisp_trace.h"
 
 /*			ISP39
  *        /M|--->|-->mainpath------------------->ddr
@@ -1097,6 +1098,8 @@ static int mi_frame_end(struct rkisp_stream *stream, u32 state)
 		stream->dbg.delay = ns - dev->isp_sdev.frm_timestamp;
 		stream->dbg.timestamp = ns;
 		stream->dbg.id = i;
+		trace_rkisp_mi_done(dev->dev_id, stream->id, i,
+				    stream->dbg.delay / 1000);
 
 		if (vir->streaming && vir->conn_id == stream->id) {
 			spin_lock_irqsave(&vir->vbq_lock, lock_flags);
@@ -1552,6 +1555,7 @@ rkisp_start_streaming(struct vb2_queue *queue, unsigned int count)
 	}
 
 	memset(&stream->dbg, 0, sizeof(stream->dbg));
+	memset(&stream->lat, 0, sizeof(stream->lat));
 
 	atomic_inc(&dev->cap_dev.refcnt);
 	if (!dev->isp_inp || !stream->linked) {
@@ -120,6 +120,7 @@ struct rkisp_buffer {
 	u32 buff_addr[VIDEO_MAX_PLANES];
 	int dev_id;
 	void *other;
+	struct dma_fence *out_fence;
 };
 
 struct rkisp_dummy_buffer {
@@ -142,6 +143,8 @@ extern int rkisp_debug;
 extern bool rkisp_monitor;
 extern bool rkisp_irq_dbg;
 extern bool rkisp_buf_dbg;
+extern bool rkisp_bay3d_keep;
+extern bool rkisp_mesh_keep;
 extern u64 rkisp_debug_reg;
 extern struct platform_driver rkisp_plat_drv;
 
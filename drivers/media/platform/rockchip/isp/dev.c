@@ -71,6 +71,14 @@ bool rkisp_buf_dbg;
 module_param_named(buf_dbg, rkisp_buf_dbg, bool, 0644);
 MODULE_PARM_DESC(buf_dbg, "rkisp check output buf");
 
+bool rkisp_bay3d_keep = true;
+module_param_named(bay3d_keep, rkisp_bay3d_keep, bool, 0644);
+MODULE_PARM_DESC(bay3d_keep, "rkisp keep bay3d buf over stream restart");
+
+bool rkisp_mesh_keep = true;
+module_param_named(mesh_keep, rkisp_mesh_keep, bool, 0644);
+MODULE_PARM_DESC(mesh_keep, "rkisp keep mesh buf over stream restart");
+
 static bool rkisp_rdbk_auto;
 module_param_named(rdbk_auto, rkisp_rdbk_auto, bool, 0644);
 MODULE_PARM_DESC(irq_dbg, "rkisp and vicap auto readback mode");
@@ -320,6 +328,26 @@ static int rkisp_pipeline_close(struct rkisp_pipeline *p)
 	return 0;
 }
 
+/*
+ * vote ddr bandwidth for the running pipeline: raw input plus the yuv
+ * outputs, estimated as 4 bytes per input pixel.
+ */
+static void rkisp_dmc_bw_update(struct rkisp_device *dev, bool on)
+{
+	u64 mbyte = 0;
+	u32 fps;
+
+	if (on) {
+		fps = dev->hw_dev->isp_size[dev->dev_id].fps;
+		if (!fps)
+			fps = 30;
+		mbyte = (u64)dev->isp_sdev.in_crop.width *
+			dev->isp_sdev.in_crop.height * fps * 4;
+		mbyte = div_u64(mbyte, 1000000);
+	}
+	rockchip_dmcfreq_bw_req_update(&dev->dmc_bw_req, mbyte);
+}
+
 /*
  * stream-on order: isp_subdev, mipi dphy, sensor
  * stream-off order: mipi dphy, sensor, isp_subdev
@@ -337,6 +365,7 @@ static int rkisp_pipeline_set_stream(struct rkisp_pipeline *p, bool on)
 		if (dev->vs_irq >= 0)
 			enable_irq(dev->vs_irq);
 		rockchip_set_system_status(SYS_STATUS_ISP);
+		rkisp_dmc_bw_update(dev, true);
 		ret = v4l2_subdev_call(&dev->isp_sdev.sd, video, s_stream, true);
 		if (ret < 0)
 			goto err;
@@ -375,6 +404,7 @@ static int rkisp_pipeline_set_stream(struct rkisp_pipeline *p, bool on)
 			disable_irq(dev->vs_irq);
 		v4l2_subdev_call(&dev->isp_sdev.sd, video, s_stream, false);
 		rockchip_clear_system_status(SYS_STATUS_ISP);
+		rkisp_dmc_bw_update(dev, false);
 	}
 
 	return 0;
@@ -385,6 +415,7 @@ static int rkisp_pipeline_set_stream(struct rkisp_pipeline *p, bool on)
 	v4l2_subdev_call(&dev->isp_sdev.sd, video, s_stream, false);
 err:
 	rockchip_clear_system_status(SYS_STATUS_ISP);
+	rkisp_dmc_bw_update(dev, false);
 	atomic_dec_return(&p->stream_cnt);
 	return ret;
 }
@@ -957,6 +988,7 @@ static int rkisp_plat_probe(struct platform_device *pdev)
 	of_property_read_u32(dev->of_node, "wait-line", &rkisp_wait_line);
 
 	rkisp_proc_init(isp_dev);
+	rockchip_dmcfreq_bw_req_add(&isp_dev->dmc_bw_req, isp_dev->name);
 
 	mutex_lock(&rkisp_dev_mutex);
 	list_add_tail(&isp_dev->list, &rkisp_device_list);
@@ -981,6 +1013,7 @@ static int rkisp_plat_remove(struct platform_device *pdev)
 	pm_runtime_disable(&pdev->dev);
 
 	rkisp_proc_cleanup(isp_dev);
+	rockchip_dmcfreq_bw_req_remove(&isp_dev->dmc_bw_req);
 	media_device_unregister(&isp_dev->media_dev);
 	v4l2_async_nf_unregister(&isp_dev->notifier);
 	v4l2_async_nf_cleanup(&isp_dev->notifier);
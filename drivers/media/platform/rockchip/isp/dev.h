@@ -35,6 +35,8 @@
 #ifndef _RKISP_DEV_H
 #define _RKISP_DEV_H
 
+#include <soc/rockchip/rockchip_dmc.h>
+
 #include "capture.h"
 #include "csi.h"
 #include "dmarx.h"
@@ -195,6 +197,25 @@ struct rkisp_hdr {
 	struct rkisp_dummy_buffer dummy_buf[HDR_DMA_MAX][HDR_MAX_DUMMY_BUF];
 };
 
+/*
+ * struct rkisp_rdbk_sched_info - readback scheduling of a virtual isp
+ * @start_ns: time the running frame is triggered, 0 if not running
+ * @last_ns: time the last frame is triggered, for the fps deadline
+ * @window_ns: start of the current load window
+ * @busy_ns: hardware busy time in the current load window
+ */
+struct rkisp_rdbk_sched_info {
+	u32 priority;
+	u32 fps;
+	u64 start_ns;
+	u64 last_ns;
+	u64 window_ns;
+	u64 busy_ns;
+	u32 frame_cnt;
+	u32 busy;
+	u32 last_frame_cnt;
+};
+
 /*
  * struct rkisp_device - ISP platform device
  * @base_addr: base register address
@@ -232,6 +253,7 @@ struct rkisp_device {
 	struct rkisp_pdaf_vdev pdaf_vdev;
 	struct rkisp_procfs procfs;
 	struct rkisp_pipeline pipe;
+	struct dmcfreq_bw_req dmc_bw_req;
 	enum rkisp_isp_ver isp_ver;
 	struct rkisp_emd_data emd_data_fifo[RKISP_EMDDATA_FIFO_MAX];
 	unsigned int emd_data_idx;
@@ -281,6 +303,7 @@ struct rkisp_device {
 	int rdbk_cnt_x3;
 	u32 rd_mode;
 	int sw_rd_cnt;
+	struct rkisp_rdbk_sched_info rdbk_sched;
 
 	struct rkisp_rx_buf_pool pv_pool[RKISP_RX_BUF_POOL_MAX];
 
@@ -1279,6 +1279,7 @@ static int rkisp_hw_probe(struct platform_device *pdev)
 	hw_dev->pre_dev_id = -1;
 	hw_dev->is_multi_overflow = false;
 	mutex_init(&hw_dev->dev_lock);
+	mutex_init(&hw_dev->bay3d_lock);
 	spin_lock_init(&hw_dev->rdbk_lock);
 	atomic_set(&hw_dev->refcnt, 0);
 	spin_lock_init(&hw_dev->buf_lock);
@@ -1317,6 +1318,7 @@ static int rkisp_hw_remove(struct platform_device *pdev)
 	rkisp_put_sram(hw_dev);
 	pm_runtime_disable(&pdev->dev);
 	mutex_destroy(&hw_dev->dev_lock);
+	mutex_destroy(&hw_dev->bay3d_lock);
 	return 0;
 }
 
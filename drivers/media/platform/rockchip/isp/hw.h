@@ -72,6 +72,8 @@ struct rkisp_hw_dev {
 	struct max_input max_in;
 	/* lock for multi dev */
 	struct mutex dev_lock;
+	/* lock for bay3d buf of multi dev, see rkisp_params_alloc_bay3d_buf */
+	struct mutex bay3d_lock;
 	spinlock_t rdbk_lock;
 	atomic_t refcnt;
 
@@ -274,6 +274,7 @@ rkisp_params_vb2_start_streaming(struct vb2_queue *queue, unsigned int count)
 	params_vdev->hdrtmo_en = false;
 	params_vdev->afaemode_en = false;
 	params_vdev->cur_buf = NULL;
+	memset(&params_vdev->cfg_stat, 0, sizeof(params_vdev->cfg_stat));
 	spin_lock_irqsave(&params_vdev->config_lock, flags);
 	params_vdev->streamon = true;
 	spin_unlock_irqrestore(&params_vdev->config_lock, flags);
@@ -383,6 +384,15 @@ static int rkisp_init_params_vdev(struct rkisp_isp_params_vdev *params_vdev)
 
 static void rkisp_uninit_params_vdev(struct rkisp_isp_params_vdev *params_vdev)
 {
+	struct rkisp_hw_dev *hw = params_vdev->dev->hw_dev;
+
+	if (params_vdev->ops && params_vdev->ops->free_bay3d_buf) {
+		mutex_lock(&hw->bay3d_lock);
+		params_vdev->ops->free_bay3d_buf(params_vdev);
+		params_vdev->is_bay3d_kept = false;
+		mutex_unlock(&hw->bay3d_lock);
+	}
+
 	if (params_vdev->dev->isp_ver <= ISP_V13)
 		rkisp_uninit_params_vdev_v1x(params_vdev);
 	else if (params_vdev->dev->isp_ver == ISP_V21)
@@ -422,7 +432,47 @@ void rkisp_params_cfgsram(struct rkisp_isp_params_vdev *params_vdev,
 void rkisp_params_isr(struct rkisp_isp_params_vdev *params_vdev,
 		      u32 isp_mis)
 {
+	struct rkisp_params_cfg_stat *stat = &params_vdev->cfg_stat;
+	u64 ns = ktime_get_ns();
+
 	params_vdev->ops->isr_hdl(params_vdev, isp_mis);
+
+	stat->isr_us = div_u64(ktime_get_ns() - ns, 1000);
+	if (stat->isr_us > stat->isr_max_us)
+		stat->isr_max_us = stat->isr_us;
+}
+
+/*
+ * Clear the modules of module_cfg_update whose config block is the same as
+ * the last one written, and save the blocks to write to last_params.
+ * last_valid is the mask of modules with a valid block in last_params, the
+ * modules not in blk are always kept.
+ */
+u64 rkisp_params_cfg_diff(struct rkisp_isp_params_vdev *params_vdev,
+			  const struct rkisp_params_module_blk *blk, int num,
+			  const void *new_params, void *last_params,
+			  u64 module_cfg_update, u64 *last_valid)
+{
+	struct rkisp_params_cfg_stat *stat = &params_vdev->cfg_stat;
+	int i;
+
+	for (i = 0; i < num; i++, blk++) {
+		if (!(module_cfg_update & blk->module))
+			continue;
+		if ((*last_valid & blk->module) &&
+		    !memcmp(new_params + blk->offset,
+			    last_params + blk->offset, blk->size)) {
+			module_cfg_update &= ~blk->module;
+			stat->cfg_skip++;
+			continue;
+		}
+		memcpy(last_params + blk->offset,
+		       new_params + blk->offset, blk->size);
+		*last_valid |= blk->module;
+		stat->cfg_write++;
+	}
+
+	return module_cfg_update;
 }
 
 /* Not called when the camera active, thus not isr protection. */
@@ -596,3 +646,86 @@ void rkisp_unregister_params_vdev(struct rkisp_isp_params_vdev *params_vdev)
 	vb2_queue_release(vdev->queue);
 	rkisp_uninit_params_vdev(params_vdev);
 }
+
+/*
+ * The bay3d iir/cur buffers are the biggest ones of the isp and are sized
+ * by the input, so a stopped stream keeps them for the next stream on. If
+ * an alloc fails, the buffers kept by the other stopped devs of the same hw
+ * (virtual isp in readback mode) are dropped and the alloc retried. The
+ * buffers of a running dev hold its temporal reference and are never
+ * shared. Called with hw->bay3d_lock held.
+ */
+int rkisp_params_alloc_bay3d_buf(struct rkisp_isp_params_vdev *params_vdev,
+				 struct rkisp_dummy_buffer *buf)
+{
+	struct rkisp_device *dev = params_vdev->dev;
+	struct rkisp_hw_dev *hw = dev->hw_dev;
+	struct rkisp_isp_params_vdev *other;
+	bool is_reclaim = false;
+	u32 size = buf->size;
+	int i, ret;
+
+	ret = rkisp_alloc_buffer(dev, buf);
+	if (!ret)
+		return 0;
+
+	for (i = 0; i < hw->dev_num; i++) {
+		if (!hw->isp[i] || hw->isp[i] == dev)
+			continue;
+		other = &hw->isp[i]->params_vdev;
+		if (!other->is_bay3d_kept || !other->ops ||
+		    !other->ops->free_bay3d_buf)
+			continue;
+		other->ops->free_bay3d_buf(other);
+		other->is_bay3d_kept = false;
+		is_reclaim = true;
+		v4l2_dbg(1, rkisp_debug, &dev->v4l2_dev,
+			 "reclaim bay3d buf of %s\n", hw->isp[i]->name);
+	}
+	if (!is_reclaim)
+		return ret;
+
+	buf->size = size;
+	return rkisp_alloc_buffer(dev, buf);
+}
+
+void rkisp_params_keep_bay3d_buf(struct rkisp_isp_params_vdev *params_vdev)
+{
+	struct rkisp_hw_dev *hw = params_vdev->dev->hw_dev;
+
+	if (!params_vdev->ops->free_bay3d_buf)
+		return;
+
+	mutex_lock(&hw->bay3d_lock);
+	if (rkisp_bay3d_keep) {
+		params_vdev->is_bay3d_kept = true;
+	} else {
+		params_vdev->ops->free_bay3d_buf(params_vdev);
+		params_vdev->is_bay3d_kept = false;
+	}
+	mutex_unlock(&hw->bay3d_lock);
+}
+
+/*
+ * Mesh buffers are kept over stream restarts (see rkisp_mesh_keep), so a
+ * restart or a mode toggle back to the same sensor and size finds its
+ * mesh still resident: the mesh head keeps its state and the user can
+ * skip the upload. Returns true on such a hit, else records the new key.
+ */
+bool rkisp_params_mesh_key_check(struct rkisp_isp_params_vdev *params_vdev,
+				 struct rkisp_mesh_key *key,
+				 const struct rkisp_meshbuf_size *meshsize)
+{
+	struct rkisp_sensor_info *sensor = params_vdev->dev->active_sensor;
+	struct rkisp_mesh_key new = {
+		.width = meshsize->meas_width,
+		.height = meshsize->meas_height,
+	};
+
+	if (sensor && sensor->sd)
+		strscpy(new.sensor, sensor->sd->name, sizeof(new.sensor));
+	if (!memcmp(&new, key, sizeof(new)))
+		return true;
+	*key = new;
+	return false;
+}
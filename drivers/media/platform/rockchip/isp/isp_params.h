@@ -25,6 +25,38 @@ enum rkisp_params_type {
 	RKISP_PARAMS_SHD,
 };
 
+/*
+ * struct rkisp_params_module_blk - config block of one module in a params struct
+ *
+ * Used to drop the modules of module_cfg_update whose config is the same as
+ * the one already written, see rkisp_params_cfg_diff().
+ */
+struct rkisp_params_module_blk {
+	u64 module;
+	u32 offset;
+	u32 size;
+};
+
+#define RKISP_PARAMS_MODULE_BLK(_module, _type, _member) {	\
+	.module = _module,					\
+	.offset = offsetof(_type, _member),			\
+	.size = sizeof_field(_type, _member),			\
+}
+
+struct rkisp_params_cfg_stat {
+	u64 cfg_write;
+	u64 cfg_skip;
+	u32 isr_us;
+	u32 isr_max_us;
+};
+
+/* what a resident mesh buffer was set up for */
+struct rkisp_mesh_key {
+	char sensor[V4L2_SUBDEV_NAME_SIZE];
+	u32 width;
+	u32 height;
+};
+
 struct rkisp_isp_params_vdev;
 struct rkisp_isp_params_ops {
 	void (*save_first_param)(struct rkisp_isp_params_vdev *params_vdev, void *param);
@@ -45,6 +77,7 @@ struct rkisp_isp_params_ops {
 	int (*info2ddr_cfg)(struct rkisp_isp_params_vdev *params_vdev, void *arg);
 	void (*get_bay3d_buffd)(struct rkisp_isp_params_vdev *params_vdev,
 				struct rkisp_bay3dbuf_info *bay3dbuf);
+	void (*free_bay3d_buf)(struct rkisp_isp_params_vdev *params_vdev);
 };
 
 /*
@@ -92,6 +125,10 @@ struct rkisp_isp_params_vdev {
 
 	bool is_subs_evt;
 	bool is_first_cfg;
+	/* bay3d buf left from the last stream, reclaimable by other dev */
+	bool is_bay3d_kept;
+
+	struct rkisp_params_cfg_stat cfg_stat;
 };
 
 static inline void
@@ -142,6 +179,11 @@ void rkisp_unregister_params_vdev(struct rkisp_isp_params_vdev *params_vdev);
 
 void rkisp_params_isr(struct rkisp_isp_params_vdev *params_vdev, u32 isp_mis);
 
+u64 rkisp_params_cfg_diff(struct rkisp_isp_params_vdev *params_vdev,
+			  const struct rkisp_params_module_blk *blk, int num,
+			  const void *new_params, void *last_params,
+			  u64 module_cfg_update, u64 *last_valid);
+
 void rkisp_params_cfg(struct rkisp_isp_params_vdev *params_vdev, u32 frame_id);
 
 void rkisp_params_cfgsram(struct rkisp_isp_params_vdev *params_vdev, bool is_check, bool is_reset);
@@ -153,4 +195,10 @@ bool rkisp_params_check_bigmode(struct rkisp_isp_params_vdev *params_vdev);
 int rkisp_params_info2ddr_cfg(struct rkisp_isp_params_vdev *params_vdev, void *arg);
 void rkisp_params_get_bay3d_buffd(struct rkisp_isp_params_vdev *params_vdev,
 				  struct rkisp_bay3dbuf_info *bay3dbuf);
+int rkisp_params_alloc_bay3d_buf(struct rkisp_isp_params_vdev *params_vdev,
+				 struct rkisp_dummy_buffer *buf);
+void rkisp_params_keep_bay3d_buf(struct rkisp_isp_params_vdev *params_vdev);
+bool rkisp_params_mesh_key_check(struct rkisp_isp_params_vdev *params_vdev,
+				 struct rkisp_mesh_key *key,
+				 const struct rkisp_meshbuf_size *meshsize);
 #endif /* _RKISP_ISP_PARAM_H */
@@ -4466,7 +4466,7 @@ rkisp_alloc_internal_buf(struct rkisp_isp_params_vdev *params_vdev,
 		}
 		if (is_alloc) {
 			priv_val->buf_3dnr_iir.size = val;
-			ret = rkisp_alloc_buffer(dev, &priv_val->buf_3dnr_iir);
+			ret = rkisp_params_alloc_bay3d_buf(params_vdev, &priv_val->buf_3dnr_iir);
 			if (ret) {
 				dev_err(dev->dev, "alloc bay3d iir buf fail:%d\n", ret);
 				goto err_3dnr;
@@ -4489,7 +4489,7 @@ rkisp_alloc_internal_buf(struct rkisp_isp_params_vdev *params_vdev,
 		}
 		if (is_alloc) {
 			priv_val->buf_3dnr_ds.size = val;
-			ret = rkisp_alloc_buffer(dev, &priv_val->buf_3dnr_ds);
+			ret = rkisp_params_alloc_bay3d_buf(params_vdev, &priv_val->buf_3dnr_ds);
 			if (ret) {
 				rkisp_free_buffer(dev, &priv_val->buf_3dnr_iir);
 				dev_err(dev->dev, "alloc bay3d ds buf fail:%d\n", ret);
@@ -4519,7 +4519,7 @@ rkisp_alloc_internal_buf(struct rkisp_isp_params_vdev *params_vdev,
 		}
 		if (val > dev->hw_dev->sram.size && is_alloc) {
 			priv_val->buf_3dnr_cur.size = val;
-			ret = rkisp_alloc_buffer(dev, &priv_val->buf_3dnr_cur);
+			ret = rkisp_params_alloc_bay3d_buf(params_vdev, &priv_val->buf_3dnr_cur);
 			if (ret) {
 				rkisp_free_buffer(dev, &priv_val->buf_3dnr_iir);
 				rkisp_free_buffer(dev, &priv_val->buf_3dnr_ds);
@@ -4933,6 +4933,79 @@ rkisp_params_check_bigmode_v32(struct rkisp_isp_params_vdev *params_vdev)
 	return ispdev->is_bigmode = is_bigmode;
 }
 
+/*
+ * Modules whose config is the same as the one already written are dropped
+ * from module_cfg_update, to shorten the params isr. The config of lsc,
+ * 3dlut, ldch and cac goes with a buffer handshake, and rawae0/3 may be
+ * skipped by afaemode, so they are always written.
+ */
+#define ISP32_BLK(module, member) \
+	RKISP_PARAMS_MODULE_BLK(module, struct isp32_isp_params_cfg, member)
+
+static const struct rkisp_params_module_blk isp32_module_blk[] = {
+	ISP32_BLK(ISP32_MODULE_RAWAF, meas.rawaf),
+	ISP32_BLK(ISP32_MODULE_RAWAE1, meas.rawae1),
+	ISP32_BLK(ISP32_MODULE_RAWAE2, meas.rawae2),
+	ISP32_BLK(ISP32_MODULE_RAWHIST0, meas.rawhist0),
+	ISP32_BLK(ISP32_MODULE_RAWHIST1, meas.rawhist1),
+	ISP32_BLK(ISP32_MODULE_RAWHIST2, meas.rawhist2),
+	ISP32_BLK(ISP32_MODULE_RAWHIST3, meas.rawhist3),
+	ISP32_BLK(ISP32_MODULE_RAWAWB, meas.rawawb),
+	ISP32_BLK(ISP32_MODULE_DPCC, others.dpcc_cfg),
+	ISP32_BLK(ISP32_MODULE_BLS, others.bls_cfg),
+	ISP32_BLK(ISP32_MODULE_SDG, others.sdg_cfg),
+	ISP32_BLK(ISP32_MODULE_AWB_GAIN, others.awb_gain_cfg),
+	ISP32_BLK(ISP32_MODULE_DEBAYER, others.debayer_cfg),
+	ISP32_BLK(ISP32_MODULE_CCM, others.ccm_cfg),
+	ISP32_BLK(ISP32_MODULE_GOC, others.gammaout_cfg),
+	ISP32_BLK(ISP3X_MODULE_CSM, others.csm_cfg),
+	ISP32_BLK(ISP3X_MODULE_CGC, others.cgc_cfg),
+	ISP32_BLK(ISP32_MODULE_CPROC, others.cproc_cfg),
+	ISP32_BLK(ISP32_MODULE_IE, others.ie_cfg),
+	ISP32_BLK(ISP32_MODULE_HDRMGE, others.hdrmge_cfg),
+	ISP32_BLK(ISP32_MODULE_DRC, others.drc_cfg),
+	ISP32_BLK(ISP32_MODULE_GIC, others.gic_cfg),
+	ISP32_BLK(ISP32_MODULE_DHAZ, others.dhaz_cfg),
+	ISP32_BLK(ISP32_MODULE_YNR, others.ynr_cfg),
+	ISP32_BLK(ISP32_MODULE_CNR, others.cnr_cfg),
+	ISP32_BLK(ISP32_MODULE_SHARP, others.sharp_cfg),
+	ISP32_BLK(ISP32_MODULE_BAYNR, others.baynr_cfg),
+	ISP32_BLK(ISP32_MODULE_BAY3D, others.bay3d_cfg),
+	ISP32_BLK(ISP32_MODULE_GAIN, others.gain_cfg),
+	ISP32_BLK(ISP32_MODULE_VSM, others.vsm_cfg),
+};
+
+static void
+isp32_params_cfg_diff(struct rkisp_isp_params_vdev *params_vdev,
+		      struct isp32_isp_params_cfg *new_params,
+		      enum rkisp_params_type type, u32 id)
+{
+	struct rkisp_isp_params_val_v32 *priv_val = params_vdev->priv_val;
+	u64 shd = ISP32_MODULE_HDRMGE | ISP32_MODULE_DRC;
+	u64 *valid = &priv_val->last_cfg_valid[id];
+	u64 update = new_params->module_cfg_update;
+	u64 keep = 0;
+
+	if (!priv_val->last_params)
+		return;
+
+	/* hdrmge and drc are written in two parts for hdr readback */
+	if (type != RKISP_PARAMS_ALL) {
+		keep = update & shd;
+		*valid &= ~keep;
+		if (type == RKISP_PARAMS_SHD)
+			return;
+		update &= ~shd;
+	}
+	if (update & ISP32_MODULE_FORCE)
+		*valid = 0;
+	update = rkisp_params_cfg_diff(params_vdev, isp32_module_blk,
+				       ARRAY_SIZE(isp32_module_blk),
+				       new_params, priv_val->last_params + id,
+				       update, valid);
+	new_params->module_cfg_update = update | keep;
+}
+
 /* Not called when the camera active, thus not isr protection. */
 static void
 rkisp_params_first_cfg_v32(struct rkisp_isp_params_vdev *params_vdev)
@@ -4954,10 +5027,12 @@ rkisp_params_first_cfg_v32(struct rkisp_isp_params_vdev *params_vdev)
 	priv_val->lsc_en = 0;
 	priv_val->mge_en = 0;
 	priv_val->lut3d_en = 0;
+	memset(priv_val->last_cfg_valid, 0, sizeof(priv_val->last_cfg_valid));
 	if (dev->is_bigmode)
 		rkisp_unite_set_bits(dev, ISP3X_ISP_CTRL1, 0,
 				     ISP3X_BIGMODE_MANUAL | ISP3X_BIGMODE_FORCE_EN, false);
 	for (i = 0; i < dev->unite_div; i++) {
+		isp32_params_cfg_diff(params_vdev, params + i, RKISP_PARAMS_ALL, i);
 		__isp_isr_meas_config(params_vdev, params + i, RKISP_PARAMS_ALL, i);
 		__isp_isr_other_config(params_vdev, params + i, RKISP_PARAMS_ALL, i);
 		__isp_isr_other_en(params_vdev, params + i, RKISP_PARAMS_ALL, i);
@@ -4983,8 +5058,13 @@ rkisp_params_first_cfg_v32(struct rkisp_isp_params_vdev *params_vdev)
 
 static void rkisp_save_first_param_v32(struct rkisp_isp_params_vdev *params_vdev, void *param)
 {
+	struct rkisp_hw_dev *hw = params_vdev->dev->hw_dev;
+
 	memcpy(params_vdev->isp32_params, param, params_vdev->vdev_fmt.fmt.meta.buffersize);
+	mutex_lock(&hw->bay3d_lock);
+	params_vdev->is_bay3d_kept = false;
 	rkisp_alloc_internal_buf(params_vdev, params_vdev->isp32_params);
+	mutex_unlock(&hw->bay3d_lock);
 }
 
 static void rkisp_clear_first_param_v32(struct rkisp_isp_params_vdev *params_vdev)
@@ -5000,6 +5080,7 @@ static void rkisp_deinit_mesh_buf(struct rkisp_isp_params_vdev *params_vdev,
 {
 	struct rkisp_isp_params_val_v32 *priv_val;
 	struct rkisp_dummy_buffer *buf;
+	struct rkisp_mesh_key *key;
 	int i;
 
 	priv_val = params_vdev->priv_val;
@@ -5009,15 +5090,18 @@ static void rkisp_deinit_mesh_buf(struct rkisp_isp_params_vdev *params_vdev,
 	switch (module_id) {
 	case ISP32_MODULE_CAC:
 		buf = priv_val->buf_cac[id];
+		key = &priv_val->mesh_key[1][id];
 		break;
 	case ISP32_MODULE_LDCH:
 	default:
 		buf = priv_val->buf_ldch[id];
+		key = &priv_val->mesh_key[0][id];
 		break;
 	}
 
 	for (i = 0; i < ISP32_MESH_BUF_NUM; i++)
 		rkisp_free_buffer(params_vdev->dev, buf + i);
+	memset(key, 0, sizeof(*key));
 }
 
 static int rkisp_init_mesh_buf(struct rkisp_isp_params_vdev *params_vdev,
@@ -5028,12 +5112,13 @@ static int rkisp_init_mesh_buf(struct rkisp_isp_params_vdev *params_vdev,
 	struct rkisp_isp_params_val_v32 *priv_val;
 	struct isp2x_mesh_head *mesh_head;
 	struct rkisp_dummy_buffer *buf;
+	struct rkisp_mesh_key *key;
 	u32 mesh_w = meshsize->meas_width;
 	u32 mesh_h = meshsize->meas_height;
 	u32 mesh_size, buf_size;
 	int i, ret, buf_cnt = meshsize->buf_cnt;
 	int id = meshsize->unite_isp_id;
-	bool is_alloc;
+	bool is_alloc, is_hit;
 
 	priv_val = params_vdev->priv_val;
 	if (!priv_val) {
@@ -5045,6 +5130,7 @@ static int rkisp_init_mesh_buf(struct rkisp_isp_params_vdev *params_vdev,
 	case ISP32_MODULE_CAC:
 		priv_val->buf_cac_idx[id] = 0;
 		buf = priv_val->buf_cac[id];
+		key = &priv_val->mesh_key[1][id];
 		mesh_w = (mesh_w + 62) / 64 * 9;
 		mesh_h = (mesh_h + 62) / 64 * 2;
 		mesh_size = mesh_w * 4 * mesh_h;
@@ -5053,6 +5139,7 @@ static int rkisp_init_mesh_buf(struct rkisp_isp_params_vdev *params_vdev,
 	default:
 		priv_val->buf_ldch_idx[id] = 0;
 		buf = priv_val->buf_ldch[id];
+		key = &priv_val->mesh_key[0][id];
 		mesh_w = ((mesh_w + 15) / 16 + 2) / 2;
 		mesh_h = (mesh_h + 7) / 8 + 1;
 		mesh_size = mesh_w * 4 * mesh_h;
@@ -5062,6 +5149,7 @@ static int rkisp_init_mesh_buf(struct rkisp_isp_params_vdev *params_vdev,
 	if (buf_cnt <= 0 || buf_cnt > ISP32_MESH_BUF_NUM)
 		buf_cnt = ISP32_MESH_BUF_NUM;
 	buf_size = PAGE_ALIGN(mesh_size + ALIGN(sizeof(struct isp2x_mesh_head), 16));
+	is_hit = rkisp_params_mesh_key_check(params_vdev, key, meshsize);
 	for (i = 0; i < buf_cnt; i++) {
 		buf->is_need_vaddr = true;
 		buf->is_need_dbuf = true;
@@ -5072,6 +5160,11 @@ static int rkisp_init_mesh_buf(struct rkisp_isp_params_vdev *params_vdev,
 				rkisp_free_buffer(params_vdev->dev, buf);
 			} else {
 				is_alloc = false;
+				/* same sensor and size, the table is still valid */
+				if (!is_hit) {
+					mesh_head = (struct isp2x_mesh_head *)buf->vaddr;
+					mesh_head->stat = MESH_BUF_INIT;
+				}
 				buf->dma_fd = dma_buf_fd(buf->dbuf, O_CLOEXEC);
 				if (buf->dma_fd < 0)
 					goto err;
@@ -5301,6 +5394,19 @@ rkisp_params_get_bay3d_buffd_v32(struct rkisp_isp_params_vdev *params_vdev,
 	bay3dbuf->u.v32.ds_size = buf->size;
 }
 
+static void
+rkisp_params_free_bay3d_buf_v32(struct rkisp_isp_params_vdev *params_vdev)
+{
+	struct rkisp_device *ispdev = params_vdev->dev;
+	struct rkisp_isp_params_val_v32 *priv_val = params_vdev->priv_val;
+
+	if (!priv_val)
+		return;
+	rkisp_free_buffer(ispdev, &priv_val->buf_3dnr_iir);
+	rkisp_free_buffer(ispdev, &priv_val->buf_3dnr_cur);
+	rkisp_free_buffer(ispdev, &priv_val->buf_3dnr_ds);
+}
+
 static void
 rkisp_params_stream_stop_v32(struct rkisp_isp_params_vdev *params_vdev)
 {
@@ -5310,9 +5416,7 @@ rkisp_params_stream_stop_v32(struct rkisp_isp_params_vdev *params_vdev)
 
 	priv_val = (struct rkisp_isp_params_val_v32 *)params_vdev->priv_val;
 	rkisp_free_buffer(ispdev, &priv_val->buf_frm);
-	rkisp_free_buffer(ispdev, &priv_val->buf_3dnr_iir);
-	rkisp_free_buffer(ispdev, &priv_val->buf_3dnr_cur);
-	rkisp_free_buffer(ispdev, &priv_val->buf_3dnr_ds);
+	rkisp_params_keep_bay3d_buf(params_vdev);
 	for (i = 0; i < ISP32_LSC_LUT_BUF_NUM; i++)
 		rkisp_free_buffer(ispdev, &priv_val->buf_lsclut[i]);
 	for (i = 0; i < RKISP_STATS_DDR_BUF_NUM; i++)
@@ -5333,6 +5437,10 @@ rkisp_params_fop_release_v32(struct rkisp_isp_params_vdev *params_vdev)
 {
 	int id;
 
+	/* resident until uninit, reused if sensor and size match */
+	if (rkisp_mesh_keep)
+		return;
+
 	for (id = 0; id < params_vdev->dev->unite_div; id++) {
 		rkisp_deinit_mesh_buf(params_vdev, ISP32_MODULE_LDCH, id);
 		rkisp_deinit_mesh_buf(params_vdev, ISP32_MODULE_CAC, id);
@@ -5417,6 +5525,8 @@ rkisp_params_cfg_v32(struct rkisp_isp_params_vdev *params_vdev,
 				/* update en immediately */
 				if (new_params->module_en_update ||
 				    (new_params->module_cfg_update & ISP32_MODULE_FORCE)) {
+					isp32_params_cfg_diff(params_vdev,
+							      new_params, RKISP_PARAMS_ALL, i);
 					__isp_isr_meas_config(params_vdev,
 							      new_params, RKISP_PARAMS_ALL, i);
 					__isp_isr_other_config(params_vdev,
@@ -5448,6 +5558,7 @@ rkisp_params_cfg_v32(struct rkisp_isp_params_vdev *params_vdev,
 
 	new_params = (struct isp32_isp_params_cfg *)(cur_buf->vaddr[0]);
 	for (i = 0; i < dev->unite_div; i++) {
+		isp32_params_cfg_diff(params_vdev, new_params, type, i);
 		__isp_isr_meas_config(params_vdev, new_params, type, i);
 		__isp_isr_other_config(params_vdev, new_params, type, i);
 		__isp_isr_other_en(params_vdev, new_params, type, i);
@@ -5519,6 +5630,7 @@ static struct rkisp_isp_params_ops rkisp_isp_params_ops_tbl = {
 	.set_meshbuf_size = rkisp_params_set_meshbuf_size_v32,
 	.free_meshbuf = rkisp_params_free_meshbuf_v32,
 	.stream_stop = rkisp_params_stream_stop_v32,
+	.free_bay3d_buf = rkisp_params_free_bay3d_buf_v32,
 	.fop_release = rkisp_params_fop_release_v32,
 	.check_bigmode = rkisp_params_check_bigmode_v32,
 	.info2ddr_cfg = rkisp_params_info2ddr_cfg_v32,
@@ -5542,6 +5654,8 @@ int rkisp_init_params_vdev_v32(struct rkisp_isp_params_vdev *params_vdev)
 		kfree(priv_val);
 		return -ENOMEM;
 	}
+	/* not fatal, all the modules are written without it */
+	priv_val->last_params = vmalloc(size);
 
 	params_vdev->priv_val = (void *)priv_val;
 	params_vdev->ops = &rkisp_isp_params_ops_tbl;
@@ -5559,11 +5673,17 @@ int rkisp_init_params_vdev_v32(struct rkisp_isp_params_vdev *params_vdev)
 void rkisp_uninit_params_vdev_v32(struct rkisp_isp_params_vdev *params_vdev)
 {
 	struct rkisp_isp_params_val_v32 *priv_val = params_vdev->priv_val;
+	int id;
 
 	if (params_vdev->isp32_params)
 		vfree(params_vdev->isp32_params);
 	if (priv_val) {
+		for (id = 0; id < ISP_UNITE_MAX; id++) {
+			rkisp_deinit_mesh_buf(params_vdev, ISP32_MODULE_LDCH, id);
+			rkisp_deinit_mesh_buf(params_vdev, ISP32_MODULE_CAC, id);
+		}
 		tasklet_kill(&priv_val->lsc_tasklet);
+		vfree(priv_val->last_params);
 		kfree(priv_val);
 		params_vdev->priv_val = NULL;
 	}
@@ -184,6 +184,9 @@ struct rkisp_isp_params_val_v32 {
 	struct rkisp_dummy_buffer buf_cac[ISP_UNITE_MAX][ISP3X_MESH_BUF_NUM];
 	u32 buf_cac_idx[ISP_UNITE_MAX];
 
+	/* ldch, cac */
+	struct rkisp_mesh_key mesh_key[2][ISP_UNITE_MAX];
+
 	struct rkisp_dummy_buffer buf_lsclut[ISP32_LSC_LUT_BUF_NUM];
 	u32 buf_lsclut_idx;
 
@@ -212,6 +215,10 @@ struct rkisp_isp_params_val_v32 {
 	bool is_bigmode;
 	bool is_lo8x8;
 	bool is_sram;
+
+	/* last written module configs, see isp32_params_cfg_diff() */
+	struct isp32_isp_params_cfg *last_params;
+	u64 last_cfg_valid[ISP_UNITE_MAX];
 };
 
 #if IS_ENABLED(CONFIG_VIDEO_ROCKCHIP_ISP_VERSION_V32)
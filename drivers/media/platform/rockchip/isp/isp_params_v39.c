@@ -4173,7 +4173,7 @@ rkisp_alloc_internal_buf(struct rkisp_isp_params_vdev *params_vdev,
 		}
 		if (is_alloc) {
 			priv_val->buf_3dnr_iir.size = val;
-			ret = rkisp_alloc_buffer(dev, &priv_val->buf_3dnr_iir);
+			ret = rkisp_params_alloc_bay3d_buf(params_vdev, &priv_val->buf_3dnr_iir);
 			if (ret) {
 				dev_err(dev->dev, "alloc bay3d iir buf fail:%d\n", ret);
 				goto err_3dnr_iir;
@@ -4189,7 +4189,7 @@ rkisp_alloc_internal_buf(struct rkisp_isp_params_vdev *params_vdev,
 		}
 		if (is_alloc) {
 			priv_val->buf_aiisp.size = val;
-			ret = rkisp_alloc_buffer(dev, &priv_val->buf_aiisp);
+			ret = rkisp_params_alloc_bay3d_buf(params_vdev, &priv_val->buf_aiisp);
 			if (ret) {
 				dev_err(dev->dev, "alloc aiisp buf fail:%d\n", ret);
 				goto free_3dnr_iir;
@@ -4209,7 +4209,7 @@ rkisp_alloc_internal_buf(struct rkisp_isp_params_vdev *params_vdev,
 		}
 		if (is_alloc) {
 			priv_val->buf_gain.size = val;
-			ret = rkisp_alloc_buffer(dev, &priv_val->buf_gain);
+			ret = rkisp_params_alloc_bay3d_buf(params_vdev, &priv_val->buf_gain);
 			if (ret) {
 				dev_err(dev->dev, "alloc gain buf fail:%d\n", ret);
 				goto free_aiisp;
@@ -4239,7 +4239,7 @@ rkisp_alloc_internal_buf(struct rkisp_isp_params_vdev *params_vdev,
 		}
 		if (is_alloc) {
 			priv_val->buf_3dnr_cur.size = size;
-			ret = rkisp_alloc_buffer(dev, &priv_val->buf_3dnr_cur);
+			ret = rkisp_params_alloc_bay3d_buf(params_vdev, &priv_val->buf_3dnr_cur);
 			if (ret) {
 				dev_err(dev->dev, "alloc yuvme cur buf fail:%d\n", ret);
 				goto free_gain;
@@ -4512,8 +4512,13 @@ rkisp_params_first_cfg_v39(struct rkisp_isp_params_vdev *params_vdev)
 
 static void rkisp_save_first_param_v39(struct rkisp_isp_params_vdev *params_vdev, void *param)
 {
+	struct rkisp_hw_dev *hw = params_vdev->dev->hw_dev;
+
 	memcpy(params_vdev->isp39_params, param, params_vdev->vdev_fmt.fmt.meta.buffersize);
+	mutex_lock(&hw->bay3d_lock);
+	params_vdev->is_bay3d_kept = false;
 	rkisp_alloc_internal_buf(params_vdev, params_vdev->isp39_params);
+	mutex_unlock(&hw->bay3d_lock);
 }
 
 static void rkisp_clear_first_param_v39(struct rkisp_isp_params_vdev *params_vdev)
@@ -4529,6 +4534,7 @@ static void rkisp_deinit_mesh_buf(struct rkisp_isp_params_vdev *params_vdev,
 {
 	struct rkisp_isp_params_val_v39 *priv_val;
 	struct rkisp_dummy_buffer *buf;
+	struct rkisp_mesh_key *key;
 	int i;
 
 	priv_val = params_vdev->priv_val;
@@ -4538,18 +4544,22 @@ static void rkisp_deinit_mesh_buf(struct rkisp_isp_params_vdev *params_vdev,
 	switch (module_id) {
 	case ISP39_MODULE_CAC:
 		buf = priv_val->buf_cac[id];
+		key = &priv_val->mesh_key[2][id];
 		break;
 	case ISP39_MODULE_LDCV:
 		buf = priv_val->buf_ldcv[id];
+		key = &priv_val->mesh_key[1][id];
 		break;
 	case ISP39_MODULE_LDCH:
 	default:
 		buf = priv_val->buf_ldch[id];
+		key = &priv_val->mesh_key[0][id];
 		break;
 	}
 
 	for (i = 0; i < ISP39_MESH_BUF_NUM; i++)
 		rkisp_free_buffer(params_vdev->dev, buf + i);
+	memset(key, 0, sizeof(*key));
 }
 
 static int rkisp_init_mesh_buf(struct rkisp_isp_params_vdev *params_vdev,
@@ -4560,12 +4570,13 @@ static int rkisp_init_mesh_buf(struct rkisp_isp_params_vdev *params_vdev,
 	struct rkisp_isp_params_val_v39 *priv_val;
 	struct isp2x_mesh_head *mesh_head;
 	struct rkisp_dummy_buffer *buf;
+	struct rkisp_mesh_key *key;
 	u32 mesh_w = meshsize->meas_width;
 	u32 mesh_h = meshsize->meas_height;
 	u32 mesh_size, buf_size;
 	int i, ret, buf_cnt = meshsize->buf_cnt;
 	int id = meshsize->unite_isp_id;
-	bool is_alloc;
+	bool is_alloc, is_hit;
 
 	priv_val = params_vdev->priv_val;
 	if (!priv_val) {
@@ -4577,6 +4588,7 @@ static int rkisp_init_mesh_buf(struct rkisp_isp_params_vdev *params_vdev,
 	case ISP39_MODULE_CAC:
 		priv_val->buf_cac_idx[id] = 0;
 		buf = priv_val->buf_cac[id];
+		key = &priv_val->mesh_key[2][id];
 		mesh_w = (mesh_w + 62) / 64 * 9;
 		mesh_h = (mesh_h + 62) / 64 * 2;
 		mesh_size = mesh_w * 4 * mesh_h;
@@ -4584,6 +4596,7 @@ static int rkisp_init_mesh_buf(struct rkisp_isp_params_vdev *params_vdev,
 	case ISP39_MODULE_LDCV:
 		priv_val->buf_ldcv_idx[id] = 0;
 		buf = priv_val->buf_ldcv[id];
+		key = &priv_val->mesh_key[1][id];
 		mesh_w = (((mesh_w + 15) / 16 + 1) + 1) / 2 * 2;
 		mesh_h = (mesh_h + 7) / 8 + 1;
 		mesh_size = (mesh_w * mesh_h + 3) / 4 * 4 * 2;
@@ -4592,6 +4605,7 @@ static int rkisp_init_mesh_buf(struct rkisp_isp_params_vdev *params_vdev,
 	default:
 		priv_val->buf_ldch_idx[id] = 0;
 		buf = priv_val->buf_ldch[id];
+		key = &priv_val->mesh_key[0][id];
 		mesh_w = ((mesh_w + 15) / 16 + 2) / 2;
 		mesh_h = (mesh_h + 7) / 8 + 1;
 		mesh_size = mesh_w * 4 * mesh_h;
@@ -4601,6 +4615,7 @@ static int rkisp_init_mesh_buf(struct rkisp_isp_params_vdev *params_vdev,
 	if (buf_cnt <= 0 || buf_cnt > ISP39_MESH_BUF_NUM)
 		buf_cnt = ISP39_MESH_BUF_NUM;
 	buf_size = PAGE_ALIGN(mesh_size + ALIGN(sizeof(struct isp2x_mesh_head), 16));
+	is_hit = rkisp_params_mesh_key_check(params_vdev, key, meshsize);
 	for (i = 0; i < buf_cnt; i++) {
 		buf->is_need_vaddr = true;
 		buf->is_need_dbuf = true;
@@ -4611,6 +4626,11 @@ static int rkisp_init_mesh_buf(struct rkisp_isp_params_vdev *params_vdev,
 				rkisp_free_buffer(params_vdev->dev, buf);
 			} else {
 				is_alloc = false;
+				/* same sensor and size, the table is still valid */
+				if (!is_hit) {
+					mesh_head = (struct isp2x_mesh_head *)buf->vaddr;
+					mesh_head->stat = MESH_BUF_INIT;
+				}
 				buf->dma_fd = dma_buf_fd(buf->dbuf, O_CLOEXEC);
 				if (buf->dma_fd < 0)
 					goto err;
@@ -4850,6 +4870,20 @@ rkisp_params_get_bay3d_buffd_v39(struct rkisp_isp_params_vdev *params_vdev,
 	bay3dbuf->u.v39.aiisp_size = buf->size;
 }
 
+static void
+rkisp_params_free_bay3d_buf_v39(struct rkisp_isp_params_vdev *params_vdev)
+{
+	struct rkisp_device *ispdev = params_vdev->dev;
+	struct rkisp_isp_params_val_v39 *priv_val = params_vdev->priv_val;
+
+	if (!priv_val)
+		return;
+	rkisp_free_buffer(ispdev, &priv_val->buf_gain);
+	rkisp_free_buffer(ispdev, &priv_val->buf_aiisp);
+	rkisp_free_buffer(ispdev, &priv_val->buf_3dnr_iir);
+	rkisp_free_buffer(ispdev, &priv_val->buf_3dnr_cur);
+}
+
 static void
 rkisp_params_stream_stop_v39(struct rkisp_isp_params_vdev *params_vdev)
 {
@@ -4859,10 +4893,7 @@ rkisp_params_stream_stop_v39(struct rkisp_isp_params_vdev *params_vdev)
 
 	priv_val = (struct rkisp_isp_params_val_v39 *)params_vdev->priv_val;
 	rkisp_free_buffer(ispdev, &priv_val->buf_frm);
-	rkisp_free_buffer(ispdev, &priv_val->buf_gain);
-	rkisp_free_buffer(ispdev, &priv_val->buf_aiisp);
-	rkisp_free_buffer(ispdev, &priv_val->buf_3dnr_iir);
-	rkisp_free_buffer(ispdev, &priv_val->buf_3dnr_cur);
+	rkisp_params_keep_bay3d_buf(params_vdev);
 	for (i = 0; i < ISP39_LSC_LUT_BUF_NUM; i++)
 		rkisp_free_buffer(ispdev, &priv_val->buf_lsclut[i]);
 	for (i = 0; i < RKISP_STATS_DDR_BUF_NUM; i++)
@@ -4883,6 +4914,10 @@ rkisp_params_fop_release_v39(struct rkisp_isp_params_vdev *params_vdev)
 {
 	int id;
 
+	/* resident until uninit, reused if sensor and size match */
+	if (rkisp_mesh_keep)
+		return;
+
 	for (id = 0; id < params_vdev->dev->unite_div; id++) {
 		rkisp_deinit_mesh_buf(params_vdev, ISP39_MODULE_LDCH, id);
 		rkisp_deinit_mesh_buf(params_vdev, ISP39_MODULE_LDCV, id);
@@ -5083,6 +5118,7 @@ static struct rkisp_isp_params_ops rkisp_isp_params_ops_tbl = {
 	.set_meshbuf_size = rkisp_params_set_meshbuf_size_v39,
 	.free_meshbuf = rkisp_params_free_meshbuf_v39,
 	.stream_stop = rkisp_params_stream_stop_v39,
+	.free_bay3d_buf = rkisp_params_free_bay3d_buf_v39,
 	.fop_release = rkisp_params_fop_release_v39,
 	.check_bigmode = rkisp_params_check_bigmode_v39,
 	.info2ddr_cfg = rkisp_params_info2ddr_cfg_v39,
@@ -5120,10 +5156,16 @@ int rkisp_init_params_vdev_v39(struct rkisp_isp_params_vdev *params_vdev)
 void rkisp_uninit_params_vdev_v39(struct rkisp_isp_params_vdev *params_vdev)
 {
 	struct rkisp_isp_params_val_v39 *priv_val = params_vdev->priv_val;
+	int id;
 
 	if (params_vdev->isp39_params)
 		vfree(params_vdev->isp39_params);
 	if (priv_val) {
+		for (id = 0; id < ISP_UNITE_MAX; id++) {
+			rkisp_deinit_mesh_buf(params_vdev, ISP39_MODULE_LDCH, id);
+			rkisp_deinit_mesh_buf(params_vdev, ISP39_MODULE_LDCV, id);
+			rkisp_deinit_mesh_buf(params_vdev, ISP39_MODULE_CAC, id);
+		}
 		kfree(priv_val);
 		params_vdev->priv_val = NULL;
 	}
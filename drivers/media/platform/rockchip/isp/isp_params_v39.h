@@ -166,6 +166,9 @@ struct rkisp_isp_params_val_v39 {
 	struct rkisp_dummy_buffer buf_cac[ISP_UNITE_MAX][ISP39_MESH_BUF_NUM];
 	u32 buf_cac_idx[ISP_UNITE_MAX];
 
+	/* ldch, ldcv, cac */
+	struct rkisp_mesh_key mesh_key[3][ISP_UNITE_MAX];
+
 	struct rkisp_dummy_buffer buf_lsclut[ISP39_LSC_LUT_BUF_NUM];
 	u32 buf_lsclut_idx;
 
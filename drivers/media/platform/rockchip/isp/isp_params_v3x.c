@@ -4390,6 +4390,79 @@ rkisp_params_get_bay3d_buffd_v3x(struct rkisp_isp_params_vdev *params_vdev,
 	bay3dbuf->u.v30.ds_size = buf->size;
 }
 
+/*
+ * Modules whose config is the same as the one already written are dropped
+ * from module_cfg_update, to shorten the params isr. The config of lsc,
+ * 3dlut, ldch and cac goes with a buffer handshake, and rawae3 may be
+ * skipped by afaemode, so they are always written.
+ */
+#define ISP3X_BLK(module, member) \
+	RKISP_PARAMS_MODULE_BLK(module, struct isp3x_isp_params_cfg, member)
+
+static const struct rkisp_params_module_blk isp3x_module_blk[] = {
+	ISP3X_BLK(ISP3X_MODULE_RAWAF, meas.rawaf),
+	ISP3X_BLK(ISP3X_MODULE_RAWAE0, meas.rawae0),
+	ISP3X_BLK(ISP3X_MODULE_RAWAE1, meas.rawae1),
+	ISP3X_BLK(ISP3X_MODULE_RAWAE2, meas.rawae2),
+	ISP3X_BLK(ISP3X_MODULE_RAWHIST0, meas.rawhist0),
+	ISP3X_BLK(ISP3X_MODULE_RAWHIST1, meas.rawhist1),
+	ISP3X_BLK(ISP3X_MODULE_RAWHIST2, meas.rawhist2),
+	ISP3X_BLK(ISP3X_MODULE_RAWHIST3, meas.rawhist3),
+	ISP3X_BLK(ISP3X_MODULE_RAWAWB, meas.rawawb),
+	ISP3X_BLK(ISP3X_MODULE_DPCC, others.dpcc_cfg),
+	ISP3X_BLK(ISP3X_MODULE_BLS, others.bls_cfg),
+	ISP3X_BLK(ISP3X_MODULE_SDG, others.sdg_cfg),
+	ISP3X_BLK(ISP3X_MODULE_AWB_GAIN, others.awb_gain_cfg),
+	ISP3X_BLK(ISP3X_MODULE_DEBAYER, others.debayer_cfg),
+	ISP3X_BLK(ISP3X_MODULE_CCM, others.ccm_cfg),
+	ISP3X_BLK(ISP3X_MODULE_GOC, others.gammaout_cfg),
+	ISP3X_BLK(ISP3X_MODULE_CSM, others.csm_cfg),
+	ISP3X_BLK(ISP3X_MODULE_CGC, others.cgc_cfg),
+	ISP3X_BLK(ISP3X_MODULE_CPROC, others.cproc_cfg),
+	ISP3X_BLK(ISP3X_MODULE_IE, others.ie_cfg),
+	ISP3X_BLK(ISP3X_MODULE_HDRMGE, others.hdrmge_cfg),
+	ISP3X_BLK(ISP3X_MODULE_DRC, others.drc_cfg),
+	ISP3X_BLK(ISP3X_MODULE_GIC, others.gic_cfg),
+	ISP3X_BLK(ISP3X_MODULE_DHAZ, others.dhaz_cfg),
+	ISP3X_BLK(ISP3X_MODULE_YNR, others.ynr_cfg),
+	ISP3X_BLK(ISP3X_MODULE_CNR, others.cnr_cfg),
+	ISP3X_BLK(ISP3X_MODULE_SHARP, others.sharp_cfg),
+	ISP3X_BLK(ISP3X_MODULE_BAYNR, others.baynr_cfg),
+	ISP3X_BLK(ISP3X_MODULE_BAY3D, others.bay3d_cfg),
+	ISP3X_BLK(ISP3X_MODULE_GAIN, others.gain_cfg),
+};
+
+static void
+isp3x_params_cfg_diff(struct rkisp_isp_params_vdev *params_vdev,
+		      struct isp3x_isp_params_cfg *new_params,
+		      enum rkisp_params_type type, u32 id)
+{
+	struct rkisp_isp_params_val_v3x *priv_val = params_vdev->priv_val;
+	u64 shd = ISP3X_MODULE_HDRMGE | ISP3X_MODULE_DRC;
+	u64 *valid = &priv_val->last_cfg_valid[id];
+	u64 update = new_params->module_cfg_update;
+	u64 keep = 0;
+
+	if (!priv_val->last_params)
+		return;
+
+	/* hdrmge and drc are written in two parts for hdr readback */
+	if (type != RKISP_PARAMS_ALL) {
+		keep = update & shd;
+		*valid &= ~keep;
+		if (type == RKISP_PARAMS_SHD)
+			return;
+		update &= ~shd;
+	}
+	if (update & ISP3X_MODULE_FORCE)
+		*valid = 0;
+	update = rkisp_params_cfg_diff(params_vdev, isp3x_module_blk,
+				       ARRAY_SIZE(isp3x_module_blk),
+				       new_params, priv_val->last_params + id,
+				       update, valid);
+	new_params->module_cfg_update = update | keep;
+}
+
 /* Not called when the camera active, thus not isr protection. */
 static void
 rkisp_params_first_cfg_v3x(struct rkisp_isp_params_vdev *params_vdev)
@@ -4411,10 +4484,12 @@ rkisp_params_first_cfg_v3x(struct rkisp_isp_params_vdev *params_vdev)
 	priv_val->lsc_en = 0;
 	priv_val->mge_en = 0;
 	priv_val->lut3d_en = 0;
+	memset(priv_val->last_cfg_valid, 0, sizeof(priv_val->last_cfg_valid));
 	if (dev->is_bigmode)
 		rkisp_unite_set_bits(dev, ISP3X_ISP_CTRL1, 0,
 				     ISP3X_BIGMODE_MANUAL | ISP3X_BIGMODE_FORCE_EN, false);
 	for (i = 0; i < dev->unite_div; i++) {
+		isp3x_params_cfg_diff(params_vdev, params + i, RKISP_PARAMS_ALL, i);
 		__isp_isr_meas_config(params_vdev, params + i, RKISP_PARAMS_ALL, i);
 		__isp_isr_other_config(params_vdev, params + i, RKISP_PARAMS_ALL, i);
 		__isp_isr_other_en(params_vdev, params + i, RKISP_PARAMS_ALL, i);
@@ -4704,6 +4779,7 @@ rkisp_params_cfg_v3x(struct rkisp_isp_params_vdev *params_vdev,
 			else if (new_params->module_en_update ||
 				 (new_params->module_cfg_update & ISP3X_MODULE_FORCE)) {
 				/* update en immediately */
+				isp3x_params_cfg_diff(params_vdev, new_params, type, 0);
 				__isp_isr_meas_config(params_vdev, new_params, type, 0);
 				__isp_isr_other_config(params_vdev, new_params, type, 0);
 				__isp_isr_other_en(params_vdev, new_params, type, 0);
@@ -4712,6 +4788,7 @@ rkisp_params_cfg_v3x(struct rkisp_isp_params_vdev *params_vdev,
 				if (hw_dev->unite) {
 					struct isp3x_isp_params_cfg *params = new_params + 1;
 
+					isp3x_params_cfg_diff(params_vdev, params, type, 1);
 					__isp_isr_meas_config(params_vdev, params, type, 1);
 					__isp_isr_other_config(params_vdev, params, type, 1);
 					__isp_isr_other_en(params_vdev, params, type, 1);
@@ -4741,11 +4818,13 @@ rkisp_params_cfg_v3x(struct rkisp_isp_params_vdev *params_vdev,
 
 	new_params = (struct isp3x_isp_params_cfg *)(cur_buf->vaddr[0]);
 	if (hw_dev->unite) {
+		isp3x_params_cfg_diff(params_vdev, new_params + 1, type, 1);
 		__isp_isr_meas_config(params_vdev, new_params + 1, type, 1);
 		__isp_isr_other_config(params_vdev, new_params + 1, type, 1);
 		__isp_isr_other_en(params_vdev, new_params + 1, type, 1);
 		__isp_isr_meas_en(params_vdev, new_params + 1, type, 1);
 	}
+	isp3x_params_cfg_diff(params_vdev, new_params, type, 0);
 	__isp_isr_meas_config(params_vdev, new_params, type, 0);
 	__isp_isr_other_config(params_vdev, new_params, type, 0);
 	__isp_isr_other_en(params_vdev, new_params, type, 0);
@@ -4841,6 +4920,8 @@ int rkisp_init_params_vdev_v3x(struct rkisp_isp_params_vdev *params_vdev)
 		kfree(priv_val);
 		return -ENOMEM;
 	}
+	/* not fatal, all the modules are written without it */
+	priv_val->last_params = vmalloc(size);
 
 	params_vdev->priv_val = (void *)priv_val;
 	params_vdev->ops = &rkisp_isp_params_ops_tbl;
@@ -4861,6 +4942,7 @@ void rkisp_uninit_params_vdev_v3x(struct rkisp_isp_params_vdev *params_vdev)
 		vfree(params_vdev->isp3x_params);
 	if (priv_val) {
 		tasklet_kill(&priv_val->lsc_tasklet);
+		vfree(priv_val->last_params);
 		kfree(priv_val);
 		params_vdev->priv_val = NULL;
 	}
@@ -195,6 +195,10 @@ struct rkisp_isp_params_val_v3x {
 	bool mge_en;
 	bool lut3d_en;
 	bool bay3d_en;
+
+	/* last written module configs, see isp3x_params_cfg_diff() */
+	struct isp3x_isp_params_cfg *last_params;
+	u64 last_cfg_valid[ISP_UNITE_MAX];
 };
 
 #if IS_ENABLED(CONFIG_VIDEO_ROCKCHIP_ISP_VERSION_V30)
@@ -381,7 +381,7 @@ void rkisp_pdaf_isr(struct rkisp_device *dev)
 		spin_lock_irqsave(&pdaf_vdev->vbq_lock, flags);
 		list_add_tail(&buf->queue, &pdaf_vdev->buf_done_list);
 		spin_unlock_irqrestore(&pdaf_vdev->vbq_lock, flags);
-		tasklet_schedule(&pdaf_vdev->buf_done_tasklet);
+		tasklet_hi_schedule(&pdaf_vdev->buf_done_tasklet);
 	}
 }
 
@@ -2,6 +2,8 @@
 /* Copyright (c) 2019 Fuzhou Rockchip Electronics Co., Ltd. */
 
 #include <linux/kfifo.h>
+#include <linux/rk-isp2-config.h>
+#include <linux/vmalloc.h>
 #include <media/v4l2-common.h>
 #include <media/v4l2-ioctl.h>
 #include <media/videobuf2-core.h>
@@ -102,19 +104,132 @@ static int rkisp_stats_fh_open(struct file *filp)
 	return ret;
 }
 
+static void rkisp_stats_ring_free(struct rkisp_isp_stats_vdev *stats)
+{
+	unsigned long flags;
+	void *ring;
+
+	spin_lock_irqsave(&stats->ring_lock, flags);
+	ring = stats->ring;
+	stats->ring = NULL;
+	spin_unlock_irqrestore(&stats->ring_lock, flags);
+
+	vfree(ring);
+}
+
+static int rkisp_stats_ring_mmap(struct rkisp_isp_stats_vdev *stats,
+				 struct vm_area_struct *vma)
+{
+	struct rkisp_stats_ring_header *hdr;
+	u32 data_size = 0, slot_size, size;
+	unsigned long flags;
+	int ret;
+
+	if (vma->vm_flags & VM_WRITE)
+		return -EPERM;
+	vma->vm_flags &= ~VM_MAYWRITE;
+
+	mutex_lock(&stats->dev->iqlock);
+	if (!stats->ring) {
+		stats->ops->get_stat_size(stats, &data_size);
+		slot_size = ALIGN(sizeof(struct rkisp_stats_ring_slot) + data_size,
+				  SMP_CACHE_BYTES);
+		size = PAGE_ALIGN(SMP_CACHE_BYTES + slot_size * RKISP_STATS_RING_SLOTS);
+
+		hdr = vmalloc_user(size);
+		if (!hdr) {
+			ret = -ENOMEM;
+			goto unlock;
+		}
+		hdr->slot_num = RKISP_STATS_RING_SLOTS;
+		hdr->slot_offset = SMP_CACHE_BYTES;
+		hdr->slot_size = slot_size;
+		hdr->data_size = data_size;
+
+		spin_lock_irqsave(&stats->ring_lock, flags);
+		stats->ring_head = 0;
+		stats->ring_slot_size = slot_size;
+		stats->ring_data_size = data_size;
+		stats->ring = hdr;
+		spin_unlock_irqrestore(&stats->ring_lock, flags);
+	}
+
+	vma->vm_pgoff = 0;
+	ret = remap_vmalloc_range(vma, stats->ring, 0);
+unlock:
+	mutex_unlock(&stats->dev->iqlock);
+
+	return ret;
+}
+
+/*
+ * Publish the stats of a frame to the ring, the slot seq is odd while it is
+ * written so that readers can detect a torn read without any lock.
+ */
+void rkisp_stats_ring_write(struct rkisp_isp_stats_vdev *stats_vdev,
+			    const void *stat, u32 size, u32 frame_id,
+			    u64 timestamp)
+{
+	struct rkisp_stats_ring_header *hdr;
+	struct rkisp_stats_ring_slot *slot;
+	unsigned long flags;
+	u32 head;
+
+	if (!READ_ONCE(stats_vdev->ring) || !stat)
+		return;
+
+	spin_lock_irqsave(&stats_vdev->ring_lock, flags);
+	hdr = stats_vdev->ring;
+	if (!hdr || size > stats_vdev->ring_data_size)
+		goto unlock;
+
+	head = stats_vdev->ring_head;
+	slot = (void *)hdr + SMP_CACHE_BYTES +
+	       (head % RKISP_STATS_RING_SLOTS) * stats_vdev->ring_slot_size;
+
+	WRITE_ONCE(slot->seq, slot->seq + 1);
+	smp_wmb();
+	slot->frame_id = frame_id;
+	slot->timestamp = timestamp;
+	slot->size = size;
+	memcpy(slot->data, stat, size);
+	smp_wmb();
+	WRITE_ONCE(slot->seq, slot->seq + 1);
+
+	stats_vdev->ring_head = head + 1;
+	smp_store_release(&hdr->head, head + 1);
+unlock:
+	spin_unlock_irqrestore(&stats_vdev->ring_lock, flags);
+}
+
+static int rkisp_stats_fop_mmap(struct file *file, struct vm_area_struct *vma)
+{
+	struct rkisp_isp_stats_vdev *stats = video_drvdata(file);
+
+	if (vma->vm_pgoff == RKISP_STATS_RING_OFFSET >> PAGE_SHIFT)
+		return rkisp_stats_ring_mmap(stats, vma);
+
+	return vb2_fop_mmap(file, vma);
+}
+
 static int rkisp_stats_fop_release(struct file *file)
 {
 	struct rkisp_isp_stats_vdev *stats = video_drvdata(file);
+	bool last = v4l2_fh_is_singular_file(file);
 	int ret;
 
 	ret = vb2_fop_release(file);
-	if (!ret)
+	if (!ret) {
+		/* A mapping holds its file, so the ring is no longer mapped */
+		if (last)
+			rkisp_stats_ring_free(stats);
 		v4l2_pipeline_pm_put(&stats->vnode.vdev.entity);
+	}
 	return ret;
 }
 
 struct v4l2_file_operations rkisp_stats_fops = {
-	.mmap = vb2_fop_mmap,
+	.mmap = rkisp_stats_fop_mmap,
 	.unlocked_ioctl = video_ioctl2,
 	.poll = vb2_fop_poll,
 	.open = rkisp_stats_fh_open,
@@ -377,6 +492,7 @@ int rkisp_register_stats_vdev(struct rkisp_isp_stats_vdev *stats_vdev,
 	INIT_LIST_HEAD(&stats_vdev->stat);
 	spin_lock_init(&stats_vdev->irq_lock);
 	spin_lock_init(&stats_vdev->rd_lock);
+	spin_lock_init(&stats_vdev->ring_lock);
 
 	strlcpy(vdev->name, STATS_NAME, sizeof(vdev->name));
 
@@ -445,6 +561,7 @@ void rkisp_unregister_stats_vdev(struct rkisp_isp_stats_vdev *stats_vdev)
 
 	kfifo_free(&stats_vdev->rd_kfifo);
 	tasklet_kill(&stats_vdev->rd_tasklet);
+	rkisp_stats_ring_free(stats_vdev);
 	video_unregister_device(vdev);
 	media_entity_cleanup(&vdev->entity);
 	vb2_queue_release(vdev->queue);
@@ -77,6 +77,13 @@ struct rkisp_isp_stats_vdev {
 
 	bool af_meas_done_next;
 	bool ae_meas_done_next;
+
+	/* mmap-able ring of the latest stats, see RKISP_STATS_RING_OFFSET */
+	spinlock_t ring_lock;
+	void *ring;
+	u32 ring_head;
+	u32 ring_slot_size;
+	u32 ring_data_size;
 };
 
 void rkisp_stats_rdbk_enable(struct rkisp_isp_stats_vdev *stats_vdev, bool en);
@@ -87,6 +94,10 @@ void rkisp_stats_next_ddr_config(struct rkisp_isp_stats_vdev *stats_vdev);
 void rkisp_stats_isr(struct rkisp_isp_stats_vdev *stats_vdev,
 		     u32 isp_ris, u32 isp3a_ris);
 
+void rkisp_stats_ring_write(struct rkisp_isp_stats_vdev *stats_vdev,
+			    const void *stat, u32 size, u32 frame_id,
+			    u64 timestamp);
+
 int rkisp_register_stats_vdev(struct rkisp_isp_stats_vdev *stats_vdev,
 			       struct v4l2_device *v4l2_dev,
 			       struct rkisp_device *dev);
@@ -317,6 +317,9 @@ rkisp1_stats_send_meas_v1x(struct rkisp_isp_stats_vdev *stats_vdev,
 			      sizeof(struct rkisp1_stat_buffer));
 	cur_buf->vb.sequence = cur_frame_id;
 	cur_buf->vb.vb2_buf.timestamp = meas_work->timestamp;
+	rkisp_stats_ring_write(stats_vdev, cur_stat_buf,
+			       sizeof(struct rkisp1_stat_buffer),
+			       cur_frame_id, meas_work->timestamp);
 	vb2_buffer_done(&cur_buf->vb.vb2_buf, VB2_BUF_STATE_DONE);
 }
 
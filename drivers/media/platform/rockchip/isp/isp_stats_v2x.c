@@ -1272,6 +1272,9 @@ rkisp_stats_send_meas_v2x(struct rkisp_isp_stats_vdev *stats_vdev,
 			if (tmp_statsbuf)
 				memcpy(tmp_statsbuf, cur_stat_buf, sizeof(*cur_stat_buf));
 		}
+		rkisp_stats_ring_write(stats_vdev, cur_stat_buf,
+				       sizeof(struct rkisp_isp2x_stat_buffer),
+				       cur_frame_id, meas_work->timestamp);
 		vb2_buffer_done(&cur_buf->vb.vb2_buf, VB2_BUF_STATE_DONE);
 	}
 }
@@ -660,7 +660,13 @@ rkisp_stats_send_meas(struct rkisp_isp_stats_vdev *stats_vdev,
 		vb2_set_plane_payload(&cur_buf->vb.vb2_buf, 0, size);
 		cur_buf->vb.sequence = cur_frame_id;
 		cur_buf->vb.vb2_buf.timestamp = meas_work->timestamp;
+		rkisp_stats_ring_write(stats_vdev, cur_buf->vaddr[0], size,
+				       cur_frame_id, meas_work->timestamp);
 		vb2_buffer_done(&cur_buf->vb.vb2_buf, VB2_BUF_STATE_DONE);
+	} else if (is_dummy && cur_stat_buf) {
+		/* No buffer queued, the ring still gets the ddr stats */
+		rkisp_stats_ring_write(stats_vdev, cur_stat_buf, size,
+				       cur_frame_id, meas_work->timestamp);
 	}
 	v4l2_dbg(4, rkisp_debug, &dev->v4l2_dev,
 		 "%s id:%d seq:%d params_id:%d ris:0x%x buf:%p meas_type:0x%x\n",
@@ -979,6 +985,8 @@ rkisp_stats_send_meas_lite(struct rkisp_isp_stats_vdev *stats_vdev,
 		vb2_set_plane_payload(&cur_buf->vb.vb2_buf, 0, size);
 		cur_buf->vb.sequence = cur_frame_id;
 		cur_buf->vb.vb2_buf.timestamp = meas_work->timestamp;
+		rkisp_stats_ring_write(stats_vdev, cur_buf->vaddr[0], size,
+				       cur_frame_id, meas_work->timestamp);
 		vb2_buffer_done(&cur_buf->vb.vb2_buf, VB2_BUF_STATE_DONE);
 		stats_vdev->cur_buf = NULL;
 	}
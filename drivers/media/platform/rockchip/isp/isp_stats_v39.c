@@ -314,6 +314,8 @@ rkisp_stats_send_meas_v39(struct rkisp_isp_stats_vdev *stats_vdev,
 		vb2_set_plane_payload(&cur_buf->vb.vb2_buf, 0, size);
 		cur_buf->vb.sequence = cur_frame_id;
 		cur_buf->vb.vb2_buf.timestamp = meas_work->timestamp;
+		rkisp_stats_ring_write(stats_vdev, cur_buf->vaddr[0], size,
+				       cur_frame_id, meas_work->timestamp);
 		vb2_buffer_done(&cur_buf->vb.vb2_buf, VB2_BUF_STATE_DONE);
 	}
 	v4l2_dbg(4, rkisp_debug, &stats_vdev->dev->v4l2_dev,
@@ -345,8 +347,6 @@ rkisp_stats_isr_v39(struct rkisp_isp_stats_vdev *stats_vdev,
 				 isp_mis_tmp, isp3a_ris);
 	}
 
-	rkisp_pdaf_isr(stats_vdev->dev);
-
 	if (isp_ris & ISP3X_FRAME) {
 		work.readout = RKISP_ISP_READOUT_MEAS;
 		work.frame_id = cur_frame_id;
@@ -12,6 +12,7 @@
 #include "regs_v2x.h"
 #include "isp_params_v3x.h"
 #include "isp_params_v32.h"
+#include "isp_params_v39.h"
 
 #ifdef CONFIG_PROC_FS
 
@@ -742,6 +743,12 @@ static void isp32_show(struct rkisp_device *dev, struct seq_file *p)
 		   (val & 1) ? "ON" : "OFF", val, tmp, !!(val & BIT(1)), !!(val & BIT(13)),
 		   (tmp & BIT(4)) ? "lo4x4" : ((tmp & BIT(3)) ? "lo4x8" : "lo8x8"),
 		   priv->is_sram ? "sram" : "ddr");
+	/* bwsaving stores the iir at 3/4, saved on both write and read */
+	seq_printf(p, "%-10s iir:%uK ds:%uK cur:%uK kept:%d bwsaving:~%uK/frame\n",
+		   "BAY3DBUF", priv->buf_3dnr_iir.size / 1024,
+		   priv->buf_3dnr_ds.size / 1024, priv->buf_3dnr_cur.size / 1024,
+		   dev->params_vdev.is_bay3d_kept,
+		   (val & BIT(13)) ? priv->bay3d_iir_size * 2 / 3 / 1024 : 0);
 	val = rkisp_read(dev, ISP3X_YNR_GLOBAL_CTRL, false);
 	seq_printf(p, "%-10s %s(0x%x)\n", "YNR", (val & 1) ? "ON" : "OFF", val);
 	val = rkisp_read(dev, ISP3X_CNR_CTRL, false);
@@ -830,6 +837,7 @@ static void isp32_show(struct rkisp_device *dev, struct seq_file *p)
 
 static void isp39_show(struct rkisp_device *dev, struct seq_file *p)
 {
+	struct rkisp_isp_params_val_v39 *priv = dev->params_vdev.priv_val;
 	u32 full_range_flg = CIF_ISP_CTRL_ISP_CSM_Y_FULL_ENA | CIF_ISP_CTRL_ISP_CSM_C_FULL_ENA;
 	static const char * const effect[] = { "OFF", "BLACKWHITE" };
 	u32 val, val1, val2;
@@ -874,6 +882,10 @@ static void isp39_show(struct rkisp_device *dev, struct seq_file *p)
 	val2 = rkisp_read(dev, ISP39_BAY3D_CTRL2, false);
 	seq_printf(p, "%-10s %s(0x%x 0x%x 0x%x)\n", "BAY3D",
 		   (val & 1) ? "ON" : "OFF", val, val1, val2);
+	seq_printf(p, "%-10s iir:%uK gain:%uK aiisp:%uK cur:%uK kept:%d\n",
+		   "BAY3DBUF", priv->buf_3dnr_iir.size / 1024,
+		   priv->buf_gain.size / 1024, priv->buf_aiisp.size / 1024,
+		   priv->buf_3dnr_cur.size / 1024, dev->params_vdev.is_bay3d_kept);
 	val = rkisp_read(dev, ISP3X_YNR_GLOBAL_CTRL, false);
 	seq_printf(p, "%-10s %s(0x%x)\n", "YNR", (val & 1) ? "ON" : "OFF", val);
 	val = rkisp_read(dev, ISP3X_CNR_CTRL, false);
@@ -1060,8 +1072,32 @@ static int isp_show(struct seq_file *p, void *v)
 			   stream->dbg.delay / 1000 / 1000,
 			   stream->dbg.frameloss,
 			   rkisp_stream_buf_cnt(stream));
+		seq_printf(p, "%-10s %s done(p50:%uus p90:%uus p99:%uus) dqbuf(p50:%uus p90:%uus p99:%uus)\n",
+			   "Latency",
+			   stream->vnode.vdev.name,
+			   rkisp_stream_lat_pct(stream->lat.done, 50),
+			   rkisp_stream_lat_pct(stream->lat.done, 90),
+			   rkisp_stream_lat_pct(stream->lat.done, 99),
+			   rkisp_stream_lat_pct(stream->lat.dqbuf, 50),
+			   rkisp_stream_lat_pct(stream->lat.dqbuf, 90),
+			   rkisp_stream_lat_pct(stream->lat.dqbuf, 99));
 	}
 
+	seq_printf(p, "%-10s Write:%llu Skip:%llu Isr:%uus MaxIsr:%uus\n",
+		   "Params",
+		   dev->params_vdev.cfg_stat.cfg_write,
+		   dev->params_vdev.cfg_stat.cfg_skip,
+		   dev->params_vdev.cfg_stat.isr_us,
+		   dev->params_vdev.cfg_stat.isr_max_us);
+	if (IS_HDR_RDBK(dev->rd_mode))
+		seq_printf(p, "%-10s Prio:%u Fps:%u Busy:%u.%u%% Cnt:%u\n",
+			   "RdbkSched",
+			   dev->rdbk_sched.priority,
+			   dev->rdbk_sched.fps,
+			   dev->rdbk_sched.busy / 10,
+			   dev->rdbk_sched.busy % 10,
+			   dev->rdbk_sched.last_frame_cnt);
+
 	switch (dev->isp_ver) {
 	case ISP_V20:
 		if (IS_ENABLED(CONFIG_VIDEO_ROCKCHIP_ISP_VERSION_V20))
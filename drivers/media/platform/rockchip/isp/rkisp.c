@@ -52,6 +52,7 @@
 #include "isp_external.h"
 #include "regs.h"
 #include "rkisp_tb_helper.h"
+#include "rkisp_trace.h"
 
 #define ISP_V4L2_EVENT_ELEMS 4
 
@@ -920,6 +921,62 @@ static void rkisp_fast_switch_rx_buf(struct rkisp_device *dev, bool is_current)
 	}
 }
 
+/* account load of the device by window of one second, with hw rdbk_lock */
+static void rkisp_rdbk_sched_update(struct rkisp_device *dev, u64 now)
+{
+	struct rkisp_rdbk_sched_info *sched = &dev->rdbk_sched;
+	u64 window = now - sched->window_ns;
+
+	if (window < NSEC_PER_SEC)
+		return;
+	/* no frame in the last windows */
+	if (window >= 2 * NSEC_PER_SEC) {
+		sched->busy = 0;
+		sched->last_frame_cnt = 0;
+	} else {
+		sched->busy = div64_u64(sched->busy_ns * 1000, window);
+		sched->last_frame_cnt = sched->frame_cnt;
+	}
+	sched->window_ns = now;
+	sched->busy_ns = 0;
+	sched->frame_cnt = 0;
+}
+
+static void rkisp_rdbk_sched_end(struct rkisp_device *dev, u64 now)
+{
+	struct rkisp_rdbk_sched_info *sched = &dev->rdbk_sched;
+
+	if (!sched->start_ns)
+		return;
+	sched->busy_ns += now - sched->start_ns;
+	sched->frame_cnt++;
+	sched->start_ns = 0;
+	rkisp_rdbk_sched_update(dev, now);
+}
+
+/*
+ * Return true if device a is handled before device b. Higher priority first,
+ * then earliest deadline by the fps target with a device without target due
+ * now, then the longest fifo as without any schedule setting.
+ */
+static bool rkisp_rdbk_sched_before(struct rkisp_device *a, int a_len,
+				    struct rkisp_device *b, int b_len, u64 now)
+{
+	struct rkisp_rdbk_sched_info *sa = &a->rdbk_sched;
+	struct rkisp_rdbk_sched_info *sb = &b->rdbk_sched;
+	u64 da, db;
+
+	if (sa->priority != sb->priority)
+		return sa->priority > sb->priority;
+	if (sa->fps || sb->fps) {
+		da = sa->fps ? sa->last_ns + div_u64(NSEC_PER_SEC, sa->fps) : now;
+		db = sb->fps ? sb->last_ns + div_u64(NSEC_PER_SEC, sb->fps) : now;
+		if (da != db)
+			return da < db;
+	}
+	return a_len > b_len;
+}
+
 static void rkisp_rdbk_trigger_handle(struct rkisp_device *dev, u32 cmd)
 {
 	struct rkisp_hw_dev *hw = dev->hw_dev;
@@ -930,6 +987,7 @@ static void rkisp_rdbk_trigger_handle(struct rkisp_device *dev, u32 cmd)
 	int len[DEV_MAX] = { 0 };
 	u32 mode = 0;
 	bool is_try = false;
+	u64 now = ktime_get_ns();
 
 	spin_lock_irqsave(&hw->rdbk_lock, lock_flags);
 	if (cmd == T_CMD_END) {
@@ -950,6 +1008,7 @@ static void rkisp_rdbk_trigger_handle(struct rkisp_device *dev, u32 cmd)
 		}
 		hw->is_idle = true;
 		hw->pre_dev_id = dev->dev_id;
+		rkisp_rdbk_sched_end(dev, now);
 	}
 	if (hw->is_shutdown)
 		hw->is_idle = false;
@@ -971,7 +1030,8 @@ static void rkisp_rdbk_trigger_handle(struct rkisp_device *dev, u32 cmd)
 		    (isp && (!(isp->isp_state & ISP_START) || isp->is_suspend)))
 			continue;
 		rkisp_rdbk_trigger_event(isp, T_CMD_LEN, &len[i]);
-		if (max < len[i]) {
+		if (len[i] &&
+		    (!max || rkisp_rdbk_sched_before(isp, len[i], hw->isp[id], max, now))) {
 			max = len[i];
 			id = i;
 		}
@@ -1000,6 +1060,10 @@ static void rkisp_rdbk_trigger_handle(struct rkisp_device *dev, u32 cmd)
 		times = t.times;
 		hw->cur_dev_id = id;
 		hw->is_idle = false;
+		isp->rdbk_sched.start_ns = now;
+		isp->rdbk_sched.last_ns = now;
+		if (!isp->rdbk_sched.window_ns)
+			isp->rdbk_sched.window_ns = now;
 		/* this frame will read count by isp */
 		isp->sw_rd_cnt = 0;
 		isp->is_frame_double = false;
@@ -1046,6 +1110,39 @@ static void rkisp_rdbk_trigger_handle(struct rkisp_device *dev, u32 cmd)
 		rkisp_trigger_read_back(isp, times, mode, is_try);
 }
 
+static int rkisp_set_rdbk_sched(struct rkisp_device *dev,
+				struct rkisp_rdbk_sched *arg)
+{
+	struct rkisp_hw_dev *hw = dev->hw_dev;
+	unsigned long lock_flags = 0;
+
+	if (arg->fps > 1000)
+		return -EINVAL;
+
+	spin_lock_irqsave(&hw->rdbk_lock, lock_flags);
+	dev->rdbk_sched.priority = arg->priority;
+	dev->rdbk_sched.fps = arg->fps;
+	spin_unlock_irqrestore(&hw->rdbk_lock, lock_flags);
+	return 0;
+}
+
+static int rkisp_get_rdbk_sched(struct rkisp_device *dev,
+				struct rkisp_rdbk_sched *arg)
+{
+	struct rkisp_hw_dev *hw = dev->hw_dev;
+	unsigned long lock_flags = 0;
+
+	spin_lock_irqsave(&hw->rdbk_lock, lock_flags);
+	if (dev->rdbk_sched.window_ns)
+		rkisp_rdbk_sched_update(dev, ktime_get_ns());
+	arg->priority = dev->rdbk_sched.priority;
+	arg->fps = dev->rdbk_sched.fps;
+	arg->busy = dev->rdbk_sched.busy;
+	arg->frame_cnt = dev->rdbk_sched.last_frame_cnt;
+	spin_unlock_irqrestore(&hw->rdbk_lock, lock_flags);
+	return 0;
+}
+
 int rkisp_rdbk_trigger_event(struct rkisp_device *dev, u32 cmd, void *arg)
 {
 	struct kfifo *fifo = &dev->rdbk_kfifo;
@@ -2123,6 +2220,13 @@ static int rkisp_isp_stop(struct rkisp_device *dev)
 	dev->hdr.op_mode = 0;
 	dev->sw_rd_cnt = 0;
 	dev->stats_vdev.rdbk_drop = false;
+	/* keep the schedule setting, drop the load of this stream */
+	dev->rdbk_sched.start_ns = 0;
+	dev->rdbk_sched.window_ns = 0;
+	dev->rdbk_sched.busy_ns = 0;
+	dev->rdbk_sched.frame_cnt = 0;
+	dev->rdbk_sched.busy = 0;
+	dev->rdbk_sched.last_frame_cnt = 0;
 	rkisp_set_state(&dev->isp_state, ISP_STOP);
 
 	if (dev->isp_ver >= ISP_V20)
@@ -3461,6 +3565,8 @@ rkisp_isp_queue_event_sof(struct rkisp_isp_subdev *isp)
 			atomic_inc_return(&isp->frm_sync_seq) - 1,
 	};
 
+	trace_rkisp_sof(sd_to_isp_dev(&isp->sd)->dev_id,
+			event.u.frame_sync.frame_sequence);
 	v4l2_event_queue(isp->sd.devnode, &event);
 }
 
@@ -3861,6 +3967,12 @@ static long rkisp_ioctl(struct v4l2_subdev *sd, unsigned int cmd, void *arg)
 	case RKISP_CMD_AIISP_RD_START:
 		rkisp_aiisp_rd_start(isp_dev);
 		break;
+	case RKISP_CMD_SET_RDBK_SCHED:
+		ret = rkisp_set_rdbk_sched(isp_dev, arg);
+		break;
+	case RKISP_CMD_GET_RDBK_SCHED:
+		ret = rkisp_get_rdbk_sched(isp_dev, arg);
+		break;
 	default:
 		ret = -ENOIOCTLCMD;
 	}
@@ -3950,6 +4062,14 @@ static long rkisp_compat_ioctl32(struct v4l2_subdev *sd,
 		size = sizeof(struct rkisp_aiisp_cfg);
 		cp_t_us = true;
 		break;
+	case RKISP_CMD_SET_RDBK_SCHED:
+		size = sizeof(struct rkisp_rdbk_sched);
+		cp_f_us = true;
+		break;
+	case RKISP_CMD_GET_RDBK_SCHED:
+		size = sizeof(struct rkisp_rdbk_sched);
+		cp_t_us = true;
+		break;
 	default:
 		return -ENOIOCTLCMD;
 	}
@@ -4392,6 +4512,23 @@ void rkisp_isp_isr(unsigned int isp_mis,
 	v4l2_dbg(3, rkisp_debug, &dev->v4l2_dev,
 		 "isp isr:0x%x, 0x%x\n", isp_mis, isp3a_mis);
 	dev->isp_isr_cnt++;
+	/*
+	 * pdaf is checked on every isp irq ahead of the stream and 3a
+	 * handling, focus loops wait on it and it is not bound to the
+	 * frame end which gates the 3a stats.
+	 */
+	if (dev->pdaf_vdev.streaming)
+		rkisp_pdaf_isr(dev);
+	if ((isp_mis & (CIF_ISP_V_START | CIF_ISP_FRAME)) &&
+	    (trace_rkisp_isp_start_enabled() || trace_rkisp_isp_end_enabled())) {
+		u32 seq;
+
+		rkisp_dmarx_get_frame(dev, &seq, NULL, NULL, true);
+		if (isp_mis & CIF_ISP_V_START)
+			trace_rkisp_isp_start(dev->dev_id, seq);
+		if (isp_mis & CIF_ISP_FRAME)
+			trace_rkisp_isp_end(dev->dev_id, seq);
+	}
 	/* start edge of v_sync */
 	if (isp_mis & CIF_ISP_V_START) {
 		if (dev->hw_dev->monitor.is_en) {
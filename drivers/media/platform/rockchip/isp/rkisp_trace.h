@@ -0,0 +1,90 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/* Copyright (c) 2024 Rockchip Electronics Co., Ltd. */
+
+#if !defined(_RKISP_TRACE_H) || defined(TRACE_HEADER_MULTI_READ)
+#define _RKISP_TRACE_H
+
+#include <linux/types.h>
+#include <linux/tracepoint.h>
+
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM rkisp
+#define TRACE_INCLUDE_FILE rkisp_trace
+
+DECLARE_EVENT_CLASS(rkisp_frame,
+	TP_PROTO(int dev_id, u32 seq),
+	TP_ARGS(dev_id, seq),
+
+	TP_STRUCT__entry(
+		__field(int, dev_id)
+		__field(u32, seq)
+	),
+
+	TP_fast_assign(
+		__entry->dev_id = dev_id;
+		__entry->seq = seq;
+	),
+
+	TP_printk("dev=%d seq=%u", __entry->dev_id, __entry->seq)
+);
+
+DEFINE_EVENT(rkisp_frame, rkisp_sof,
+	TP_PROTO(int dev_id, u32 seq),
+	TP_ARGS(dev_id, seq)
+);
+
+DEFINE_EVENT(rkisp_frame, rkisp_isp_start,
+	TP_PROTO(int dev_id, u32 seq),
+	TP_ARGS(dev_id, seq)
+);
+
+DEFINE_EVENT(rkisp_frame, rkisp_isp_end,
+	TP_PROTO(int dev_id, u32 seq),
+	TP_ARGS(dev_id, seq)
+);
+
+DECLARE_EVENT_CLASS(rkisp_buf,
+	TP_PROTO(int dev_id, int stream_id, u32 seq, u32 latency_us),
+	TP_ARGS(dev_id, stream_id, seq, latency_us),
+
+	TP_STRUCT__entry(
+		__field(int, dev_id)
+		__field(int, stream_id)
+		__field(u32, seq)
+		__field(u32, latency_us)
+	),
+
+	TP_fast_assign(
+		__entry->dev_id = dev_id;
+		__entry->stream_id = stream_id;
+		__entry->seq = seq;
+		__entry->latency_us = latency_us;
+	),
+
+	TP_printk("dev=%d stream=%d seq=%u latency=%uus",
+		  __entry->dev_id, __entry->stream_id, __entry->seq,
+		  __entry->latency_us)
+);
+
+/* latency from the frame start of the buffer */
+DEFINE_EVENT(rkisp_buf, rkisp_mi_done,
+	TP_PROTO(int dev_id, int stream_id, u32 seq, u32 latency_us),
+	TP_ARGS(dev_id, stream_id, seq, latency_us)
+);
+
+DEFINE_EVENT(rkisp_buf, rkisp_buf_done,
+	TP_PROTO(int dev_id, int stream_id, u32 seq, u32 latency_us),
+	TP_ARGS(dev_id, stream_id, seq, latency_us)
+);
+
+DEFINE_EVENT(rkisp_buf, rkisp_buf_dqbuf,
+	TP_PROTO(int dev_id, int stream_id, u32 seq, u32 latency_us),
+	TP_ARGS(dev_id, stream_id, seq, latency_us)
+);
+
+#endif /* _RKISP_TRACE_H */
+
+/* This part must be outside protection */
+#undef TRACE_INCLUDE_PATH
+#define TRACE_INCLUDE_PATH .
+#include <trace/define_trace.h>
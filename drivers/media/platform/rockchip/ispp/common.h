@@ -5,6 +5,7 @@
 #define _RKISPP_COMMON_H
 
 #include <linux/clk.h>
+#include <linux/dma-fence.h>
 #include <linux/mutex.h>
 #include <media/media-device.h>
 #include <media/media-entity.h>
@@ -68,6 +69,9 @@ struct rkispp_buffer {
 		u32 buff_addr[VIDEO_MAX_PLANES];
 		void *vaddr[VIDEO_MAX_PLANES];
 	};
+	/* write fence of input dmabuf still being written */
+	struct dma_fence *in_fence;
+	struct dma_fence_cb fence_cb;
 };
 
 struct rkispp_dummy_buffer {
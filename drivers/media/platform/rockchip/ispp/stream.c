@@ -3,6 +3,8 @@
 
 #include <linux/clk.h>
 #include <linux/delay.h>
+#include <linux/dma-fence.h>
+#include <linux/dma-resv.h>
 #include <linux/pm_runtime.h>
 #include <linux/slab.h>
 #include <media/v4l2-common.h>
@@ -893,6 +895,121 @@ static int rkispp_queue_setup(struct vb2_queue *queue,
 	return 0;
 }
 
+static void rkispp_buf_enqueue(struct rkispp_stream *stream,
+			       struct rkispp_buffer *isppbuf)
+{
+	struct vb2_buffer *vb = &isppbuf->vb.vb2_buf;
+	struct rkispp_device *dev = stream->isppdev;
+	struct rkispp_stream_vdev *vdev = &dev->stream_vdev;
+	unsigned long lock_flags = 0;
+	int i;
+
+	spin_lock_irqsave(&stream->vbq_lock, lock_flags);
+	if (stream->type == STREAM_OUTPUT ||
+	    (stream->id == STREAM_II && !stream->streaming)) {
+		list_add_tail(&isppbuf->queue, &stream->buf_queue);
+	} else {
+		i = vb->index;
+		vdev->input[i].priv = isppbuf;
+		vdev->input[i].index = dev->dev_id;
+		vdev->input[i].frame_timestamp = vb->timestamp;
+		vdev->input[i].frame_id = ++dev->ispp_sdev.frm_sync_seq;
+		rkispp_event_handle(dev, CMD_QUEUE_DMABUF, &vdev->input[i]);
+	}
+	spin_unlock_irqrestore(&stream->vbq_lock, lock_flags);
+}
+
+static void rkispp_buf_fence_cb(struct dma_fence *fence, struct dma_fence_cb *cb)
+{
+	struct rkispp_buffer *isppbuf = container_of(cb, struct rkispp_buffer, fence_cb);
+	struct rkispp_stream *stream = isppbuf->vb.vb2_buf.vb2_queue->drv_priv;
+	unsigned long lock_flags = 0;
+	bool is_own = false;
+	int error = fence->error;
+
+	spin_lock_irqsave(&stream->vbq_lock, lock_flags);
+	if (isppbuf->in_fence == fence) {
+		isppbuf->in_fence = NULL;
+		is_own = true;
+	}
+	spin_unlock_irqrestore(&stream->vbq_lock, lock_flags);
+	if (!is_own)
+		return;
+	dma_fence_put(fence);
+
+	/* buffer left active is returned by destroy_buf_queue */
+	if (!stream->streaming || stream->stopping)
+		return;
+	if (error) {
+		v4l2_dbg(1, rkispp_debug, &stream->isppdev->v4l2_dev,
+			 "input buf:%d fence error:%d\n",
+			 isppbuf->vb.vb2_buf.index, error);
+		vb2_buffer_done(&isppbuf->vb.vb2_buf, VB2_BUF_STATE_ERROR);
+		return;
+	}
+	rkispp_buf_enqueue(stream, isppbuf);
+}
+
+/*
+ * The input dmabuf may be imported while the producer, e.g. rkisp with
+ * out fence enabled, is still writing it. Start processing from the
+ * fence callback instead of userspace waiting for the producer.
+ */
+static bool rkispp_buf_wait_fence(struct rkispp_stream *stream,
+				  struct rkispp_buffer *isppbuf)
+{
+	struct vb2_buffer *vb = &isppbuf->vb.vb2_buf;
+	struct dma_buf *dbuf = vb->planes[0].dbuf;
+	struct dma_fence *fence = NULL;
+	unsigned long lock_flags = 0;
+	int ret;
+
+	if (vb->memory != VB2_MEMORY_DMABUF || !dbuf)
+		return false;
+	ret = dma_resv_get_singleton(dbuf->resv, DMA_RESV_USAGE_WRITE, &fence);
+	if (ret || !fence)
+		return false;
+
+	spin_lock_irqsave(&stream->vbq_lock, lock_flags);
+	isppbuf->in_fence = fence;
+	spin_unlock_irqrestore(&stream->vbq_lock, lock_flags);
+	ret = dma_fence_add_callback(fence, &isppbuf->fence_cb, rkispp_buf_fence_cb);
+	if (!ret)
+		return true;
+
+	/* already signaled */
+	spin_lock_irqsave(&stream->vbq_lock, lock_flags);
+	isppbuf->in_fence = NULL;
+	spin_unlock_irqrestore(&stream->vbq_lock, lock_flags);
+	dma_fence_put(fence);
+	return false;
+}
+
+static void rkispp_buf_cancel_fence(struct rkispp_stream *stream,
+				    struct rkispp_buffer *isppbuf)
+{
+	struct dma_fence *fence;
+	unsigned long lock_flags = 0;
+	bool is_own = false;
+
+	spin_lock_irqsave(&stream->vbq_lock, lock_flags);
+	fence = dma_fence_get(isppbuf->in_fence);
+	spin_unlock_irqrestore(&stream->vbq_lock, lock_flags);
+	if (!fence)
+		return;
+
+	dma_fence_remove_callback(fence, &isppbuf->fence_cb);
+	spin_lock_irqsave(&stream->vbq_lock, lock_flags);
+	if (isppbuf->in_fence == fence) {
+		isppbuf->in_fence = NULL;
+		is_own = true;
+	}
+	spin_unlock_irqrestore(&stream->vbq_lock, lock_flags);
+	if (is_own)
+		dma_fence_put(fence);
+	dma_fence_put(fence);
+}
+
 static void rkispp_buf_queue(struct vb2_buffer *vb)
 {
 	struct vb2_v4l2_buffer *vbuf = to_vb2_v4l2_buffer(vb);
@@ -900,10 +1017,8 @@ static void rkispp_buf_queue(struct vb2_buffer *vb)
 	struct vb2_queue *queue = vb->vb2_queue;
 	struct rkispp_stream *stream = queue->drv_priv;
 	struct rkispp_device *dev = stream->isppdev;
-	struct rkispp_stream_vdev *vdev = &dev->stream_vdev;
 	struct v4l2_pix_format_mplane *pixm = &stream->out_fmt;
 	struct capture_fmt *cap_fmt = &stream->out_cap_fmt;
-	unsigned long lock_flags = 0;
 	u32 height, size, offset;
 	struct sg_table *sgt;
 	int i;
@@ -944,19 +1059,10 @@ static void rkispp_buf_queue(struct vb2_buffer *vb)
 		 "%s stream:%d buf:0x%x\n", __func__,
 		 stream->id, isppbuf->buff_addr[0]);
 
-	spin_lock_irqsave(&stream->vbq_lock, lock_flags);
-	if (stream->type == STREAM_OUTPUT ||
-	    (stream->id == STREAM_II && !stream->streaming)) {
-		list_add_tail(&isppbuf->queue, &stream->buf_queue);
-	} else {
-		i = vb->index;
-		vdev->input[i].priv = isppbuf;
-		vdev->input[i].index = dev->dev_id;
-		vdev->input[i].frame_timestamp = vb->timestamp;
-		vdev->input[i].frame_id = ++dev->ispp_sdev.frm_sync_seq;
-		rkispp_event_handle(dev, CMD_QUEUE_DMABUF, &vdev->input[i]);
-	}
-	spin_unlock_irqrestore(&stream->vbq_lock, lock_flags);
+	if (stream->id == STREAM_II && stream->streaming &&
+	    rkispp_buf_wait_fence(stream, isppbuf))
+		return;
+	rkispp_buf_enqueue(stream, isppbuf);
 }
 
 static void rkispp_stream_stop(struct rkispp_stream *stream)
@@ -1002,6 +1108,12 @@ static void destroy_buf_queue(struct rkispp_stream *stream,
 	struct rkispp_buffer *buf;
 	u32 i;
 
+	if (stream->id == STREAM_II) {
+		for (i = 0; i < queue->num_buffers; ++i)
+			rkispp_buf_cancel_fence(stream,
+				to_rkispp_buffer(to_vb2_v4l2_buffer(queue->bufs[i])));
+	}
+
 	spin_lock_irqsave(&stream->vbq_lock, lock_flags);
 	if (stream->curr_buf) {
 		list_add_tail(&stream->curr_buf->queue, &stream->buf_queue);
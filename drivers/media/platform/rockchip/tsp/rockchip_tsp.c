@@ -70,6 +70,19 @@
 
 static struct tsp_dev *tdev;
 
+/*
+ * TS data is polled every tick. Hand it over once a batch of packets has
+ * accumulated, or the oldest data waited ts_batch_ms, instead of calling back
+ * with whatever trickled in since the last tick.
+ */
+static uint ts_batch_packets = 32;
+module_param(ts_batch_packets, uint, 0644);
+MODULE_PARM_DESC(ts_batch_packets, "TS packets to accumulate before delivery, 0 to disable");
+
+static uint ts_batch_ms = 10;
+module_param(ts_batch_ms, uint, 0644);
+MODULE_PARM_DESC(ts_batch_ms, "max time in ms TS data is held back for batching");
+
 static void rockchip_ts_filter_config(struct tsp_dev *dev,
 				      struct tsp_ctx *ctx);
 static void rockchip_demux_dma_config(struct tsp_dev *dev,
@@ -471,6 +484,23 @@ static u8 *rockchip_handle_ts_head(struct tsp_ctx *ctx)
 	return read_addr;
 }
 
+static bool rockchip_ts_batch_ready(struct tsp_ctx *ctx)
+{
+	uint pending, batch;
+
+	if (ctx->write >= ctx->read)
+		pending = ctx->write - ctx->read;
+	else
+		pending = ctx->buf_len - (ctx->read - ctx->write);
+
+	/* never hold back more than a quarter ring, the dma must not catch up */
+	batch = min_t(uint, ts_batch_packets * PACKET_SIZE, ctx->buf_len / 4);
+	if (pending >= batch)
+		return true;
+
+	return time_after_eq(jiffies, ctx->last_feed + msecs_to_jiffies(ts_batch_ms));
+}
+
 void rockchip_tsp_reset_regs(struct tsp_dev *dev)
 {
 	unsigned long flags;
@@ -575,17 +605,19 @@ static void rockchip_feed_ts_buf(struct tsp_dev *dev)
 				goto error;
 			}
 
-			if (ctx->write > ctx->read) {
+			if (ctx->write != ctx->read) {
 #ifdef TSP_DESCRAM_TIMER_CHECK
 				tsp_live_no_data_interval = 0;
 #endif
 				tsp_normal_no_data_interval = 0;
+				if (!rockchip_ts_batch_ready(ctx))
+					continue;
+				ctx->last_feed = jiffies;
+			}
+
+			if (ctx->write > ctx->read) {
 				ctx->read = (u8 *)rockchip_handle_ts_data(ctx);
 			} else if (ctx->write < ctx->read) {
-#ifdef TSP_DESCRAM_TIMER_CHECK
-				tsp_live_no_data_interval = 0;
-#endif
-				tsp_normal_no_data_interval = 0;
 				/* tail */
 				ctx->read = rockchip_handle_ts_tail(ctx);
 
@@ -966,6 +998,7 @@ int rockchip_tsp_start_channel(struct rockchip_tsp_channel_info *info)
 	ctx->pid = info->pid;
 	ctx->index = info->index;
 	ctx->get_data_callback = info->get_data_callback;
+	ctx->last_feed = jiffies;
 	type = info->type;
 
 	if (type == TSP_DMX_TYPE_TS) {
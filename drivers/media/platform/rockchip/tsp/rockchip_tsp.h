@@ -181,6 +181,8 @@ struct tsp_ctx {
 	u8 filter_byte[TSP_DMX_FILTER_SIZE];
 	u8 filter_mask[TSP_DMX_FILTER_SIZE];
 	void (*get_data_callback)(const u8 *buf, size_t count, u16 pid);
+	/* jiffies of the last delivery to get_data_callback */
+	unsigned long last_feed;
 	struct list_head pid_list;
 };
 
@@ -3,6 +3,9 @@
 
 #include <linux/clk.h>
 #include <linux/delay.h>
+#include <linux/dma-fence.h>
+#include <linux/file.h>
+#include <linux/sync_file.h>
 #include <media/v4l2-device.h>
 #include <media/v4l2-fh.h>
 #include <media/v4l2-ioctl.h>
@@ -21,6 +24,15 @@ struct rkvpss_output_ch {
 	u32 c_offs;
 };
 
+struct rkvpss_ofl_batch_job {
+	struct work_struct work;
+	struct rkvpss_offline_dev *ofl;
+	struct file *file;
+	struct dma_fence *fence;
+	int frame_num;
+	struct rkvpss_frame_cfg cfg[];
+};
+
 struct rkvpss_offline_buf {
 	struct list_head list;
 	struct vb2_buffer vb;
@@ -1219,6 +1231,130 @@ static int rkvpss_ofl_run(struct file *file, struct rkvpss_frame_cfg *cfg)
 	return -ENOMEM;
 }
 
+static const char *rkvpss_fence_get_driver_name(struct dma_fence *fence)
+{
+	return "rkvpss";
+}
+
+static const char *rkvpss_fence_get_timeline_name(struct dma_fence *fence)
+{
+	return "rkvpss_ofl";
+}
+
+static const struct dma_fence_ops rkvpss_fence_ops = {
+	.get_driver_name = rkvpss_fence_get_driver_name,
+	.get_timeline_name = rkvpss_fence_get_timeline_name,
+};
+
+static int rkvpss_ofl_batch_run(struct file *file, struct rkvpss_frame_cfg *cfg,
+				int frame_num, int *done_num)
+{
+	int i, ret = 0;
+
+	for (i = 0; i < frame_num; i++) {
+		ret = rkvpss_ofl_run(file, &cfg[i]);
+		if (ret)
+			break;
+	}
+	if (done_num)
+		*done_num = i;
+	return ret;
+}
+
+static void rkvpss_ofl_batch_work(struct work_struct *work)
+{
+	struct rkvpss_ofl_batch_job *job =
+		container_of(work, struct rkvpss_ofl_batch_job, work);
+	struct rkvpss_offline_dev *ofl = job->ofl;
+	int ret;
+
+	mutex_lock(&ofl->apilock);
+	ret = rkvpss_ofl_batch_run(job->file, job->cfg, job->frame_num, NULL);
+	mutex_unlock(&ofl->apilock);
+
+	if (ret)
+		dma_fence_set_error(job->fence, ret);
+	dma_fence_signal(job->fence);
+	dma_fence_put(job->fence);
+	fput(job->file);
+	kfree(job);
+}
+
+static int rkvpss_ofl_batch_async(struct file *file, struct rkvpss_frame_batch *batch)
+{
+	struct rkvpss_offline_dev *ofl = video_drvdata(file);
+	struct rkvpss_ofl_batch_job *job;
+	struct sync_file *sync_file;
+	unsigned long flags;
+	int fd, ret;
+
+	job = kzalloc(struct_size(job, cfg, batch->frame_num), GFP_KERNEL);
+	if (!job)
+		return -ENOMEM;
+	if (copy_from_user(job->cfg, u64_to_user_ptr(batch->frames),
+			   batch->frame_num * sizeof(job->cfg[0]))) {
+		ret = -EFAULT;
+		goto free_job;
+	}
+	job->fence = kzalloc(sizeof(*job->fence), GFP_KERNEL);
+	if (!job->fence) {
+		ret = -ENOMEM;
+		goto free_job;
+	}
+	spin_lock_irqsave(&ofl->fence_lock, flags);
+	dma_fence_init(job->fence, &rkvpss_fence_ops, &ofl->fence_lock,
+		       ofl->fence_ctx, ++ofl->fence_seqno);
+	spin_unlock_irqrestore(&ofl->fence_lock, flags);
+
+	fd = get_unused_fd_flags(O_CLOEXEC);
+	if (fd < 0) {
+		ret = fd;
+		goto put_fence;
+	}
+	sync_file = sync_file_create(job->fence);
+	if (!sync_file) {
+		put_unused_fd(fd);
+		ret = -ENOMEM;
+		goto put_fence;
+	}
+	fd_install(fd, sync_file->file);
+	batch->fence_fd = fd;
+	batch->done_num = 0;
+
+	job->ofl = ofl;
+	job->file = get_file(file);
+	job->frame_num = batch->frame_num;
+	INIT_WORK(&job->work, rkvpss_ofl_batch_work);
+	queue_work(ofl->batch_wq, &job->work);
+	return 0;
+put_fence:
+	dma_fence_put(job->fence);
+free_job:
+	kfree(job);
+	return ret;
+}
+
+static int rkvpss_ofl_batch(struct file *file, struct rkvpss_frame_batch *batch)
+{
+	struct rkvpss_frame_cfg *cfg;
+	int ret;
+
+	if (batch->frame_num <= 0 || batch->frame_num > RKVPSS_FRAME_BATCH_MAX)
+		return -EINVAL;
+
+	batch->fence_fd = -1;
+	if (batch->flags & RKVPSS_BATCH_ASYNC)
+		return rkvpss_ofl_batch_async(file, batch);
+
+	cfg = memdup_user(u64_to_user_ptr(batch->frames),
+			  batch->frame_num * sizeof(*cfg));
+	if (IS_ERR(cfg))
+		return PTR_ERR(cfg);
+	ret = rkvpss_ofl_batch_run(file, cfg, batch->frame_num, &batch->done_num);
+	kfree(cfg);
+	return ret;
+}
+
 static int rkvpss_module_get(struct file *file,
 			     struct rkvpss_module_sel *get)
 {
@@ -1294,6 +1430,9 @@ static long rkvpss_ofl_ioctl(struct file *file, void *fh,
 	case RKVPSS_CMD_FRAME_HANDLE:
 		ret = rkvpss_ofl_run(file, arg);
 		break;
+	case RKVPSS_CMD_FRAME_BATCH:
+		ret = rkvpss_ofl_batch(file, arg);
+		break;
 	case RKVPSS_CMD_BUF_ADD:
 		ret = rkvpss_ofl_buf_add(file, arg);
 		break;
@@ -1390,6 +1529,14 @@ int rkvpss_register_offline(struct rkvpss_hw_dev *hw)
 	if (ret)
 		return ret;
 
+	ofl->batch_wq = alloc_ordered_workqueue("rkvpss_ofl", 0);
+	if (!ofl->batch_wq) {
+		ret = -ENOMEM;
+		goto unreg_v4l2_dev;
+	}
+	spin_lock_init(&ofl->fence_lock);
+	ofl->fence_ctx = dma_fence_context_alloc(1);
+
 	mutex_init(&ofl->apilock);
 	ofl->vfd = offline_videodev;
 	ofl->mode_sel_en = true;
@@ -1410,12 +1557,15 @@ int rkvpss_register_offline(struct rkvpss_hw_dev *hw)
 	return 0;
 unreg_v4l2:
 	mutex_destroy(&ofl->apilock);
+	destroy_workqueue(ofl->batch_wq);
+unreg_v4l2_dev:
 	v4l2_device_unregister(v4l2_dev);
 	return ret;
 }
 
 void rkvpss_unregister_offline(struct rkvpss_hw_dev *hw)
 {
+	destroy_workqueue(hw->ofl_dev.batch_wq);
 	mutex_destroy(&hw->ofl_dev.apilock);
 	video_unregister_device(&hw->ofl_dev.vfd);
 	v4l2_device_unregister(&hw->ofl_dev.v4l2_dev);
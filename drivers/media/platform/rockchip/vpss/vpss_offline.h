@@ -56,6 +56,10 @@ struct rkvpss_offline_dev {
 	struct list_head cfginfo_list;
 	struct mutex ofl_lock;
 	struct rkvpss_dev_rate dev_rate[DEV_NUM_MAX];
+	struct workqueue_struct *batch_wq;
+	spinlock_t fence_lock;
+	u64 fence_ctx;
+	u32 fence_seqno;
 	bool mode_sel_en;
 };
 
@@ -173,6 +173,26 @@ static const struct regmap_access_table rk628_csi_readable_table = {
 	.n_yes_ranges   = ARRAY_SIZE(rk628_csi_readable_ranges),
 };
 
+/*
+ * Status registers and the hiword-mask ones: a cached hiword value would hand
+ * the write-enable bits back to the next read-modify-write.
+ */
+static const struct regmap_range rk628_grf_volatile_ranges[] = {
+	regmap_reg_range(GRF_SCALER_CON0, GRF_SCALER_CON0),
+	regmap_reg_range(GRF_CSC_CTRL_CON, GRF_LVDS_TX_CON),
+	regmap_reg_range(GRF_RGB_DEC_CON1, GRF_RGB_ENC_CON),
+	regmap_reg_range(GRF_DPHY0_STATUS, GRF_DPHY0_STATUS),
+	regmap_reg_range(GRF_DPHY1_STATUS, GRF_GPIO_SR_CON),
+	regmap_reg_range(GRF_INTR0_EN, GRF_SYSTEM_STATUS4),
+	regmap_reg_range(GRF_RGB_RX_DBG_MEAS0, GRF_RGB_RX_DBG_MEAS4),
+	regmap_reg_range(GRF_SOC_VERSION, GRF_MAX_REGISTER),
+};
+
+static const struct regmap_access_table rk628_grf_volatile_table = {
+	.yes_ranges     = rk628_grf_volatile_ranges,
+	.n_yes_ranges   = ARRAY_SIZE(rk628_grf_volatile_ranges),
+};
+
 static const struct regmap_range rk628_hdmi_volatile_reg_ranges[] = {
 	regmap_reg_range(HDMI_SYS_CTRL, HDMI_MAX_REG),
 };
@@ -227,6 +247,8 @@ static const struct regmap_config rk628_regmap_config[RK628_DEV_MAX] = {
 		.max_register = GRF_MAX_REGISTER,
 		.reg_format_endian = REGMAP_ENDIAN_NATIVE,
 		.val_format_endian = REGMAP_ENDIAN_NATIVE,
+		.cache_type = REGCACHE_RBTREE,
+		.volatile_table = &rk628_grf_volatile_table,
 	},
 	[RK628_DEV_CRU] = {
 		.name = "cru",
@@ -380,9 +402,19 @@ static const struct regmap_config rk628_regmap_config[RK628_DEV_MAX] = {
 	},
 };
 
+/* the chip comes out of reset with its defaults, forget what was cached */
+static void rk628_cache_drop(struct rk628 *rk628)
+{
+	struct regmap *grf = rk628->regmap[RK628_DEV_GRF];
+
+	if (grf)
+		regcache_drop_region(grf, 0, GRF_MAX_REGISTER);
+}
+
 static void rk628_power_on(struct rk628 *rk628, bool on)
 {
 	if (!rk628->display_enabled && on) {
+		rk628_cache_drop(rk628);
 		gpiod_set_value(rk628->enable_gpio, 1);
 		usleep_range(10000, 11000);
 		gpiod_set_value(rk628->reset_gpio, 0);
@@ -396,6 +428,7 @@ static void rk628_power_on(struct rk628 *rk628, bool on)
 	if (!on) {
 		gpiod_set_value(rk628->reset_gpio, 1);
 		gpiod_set_value(rk628->enable_gpio, 0);
+		rk628_cache_drop(rk628);
 	}
 }
 
@@ -482,6 +515,12 @@ static void rk628_display_enable(struct rk628 *rk628)
 		rk628_hdmitx_enable(rk628);
 
 	rk628->display_enabled = true;
+
+	if (rk628->resume_start) {
+		dev_info(rk628->dev, "resume to display enable: %lld ms\n",
+			 ktime_ms_delta(ktime_get(), rk628->resume_start));
+		rk628->resume_start = 0;
+	}
 }
 
 static void rk628_set_hdmirx_irq(struct rk628 *rk628, u32 reg, bool enable)
@@ -543,6 +582,7 @@ static int rk628_fb_notifier_callback(struct notifier_block *nb,
 
 	switch (*blank) {
 	case FB_BLANK_UNBLANK:
+		rk628->resume_start = ktime_get();
 		rk628_power_on(rk628, true);
 		rk628_pwr_consumption_init(rk628);
 		rk628_cru_init(rk628);
@@ -1549,6 +1589,7 @@ static int rk628_resume(struct device *dev)
 {
 	struct rk628 *rk628 = dev_get_drvdata(dev);
 
+	rk628->resume_start = ktime_get();
 	rk628_power_on(rk628, true);
 	rk628_pwr_consumption_init(rk628);
 	rk628_cru_init(rk628);
@@ -11,6 +11,7 @@
 #include <linux/clk.h>
 #include <linux/delay.h>
 #include <linux/device.h>
+#include <linux/ktime.h>
 #include <linux/notifier.h>
 #include <linux/regmap.h>
 #include <linux/version.h>
@@ -582,6 +583,7 @@ struct rk628 {
 	u32 version;
 	struct rk628_rgb rgb;
 	int old_blank;
+	ktime_t resume_start;
 };
 
 static inline bool rk628_input_is_hdmi(struct rk628 *rk628)
@@ -6,12 +6,14 @@
 #include <linux/module.h>
 #include <linux/platform_device.h>
 #include <linux/clk.h>
+#include <linux/crc32.h>
 #include <linux/mmc/host.h>
 #include <linux/of_address.h>
 #include <linux/mmc/slot-gpio.h>
 #include <linux/pm_runtime.h>
 #include <linux/rockchip/cpu.h>
 #include <linux/slab.h>
+#include <linux/soc/rockchip/rk_vendor_storage.h>
 
 #include "dw_mmc.h"
 #include "dw_mmc-pltfm.h"
@@ -31,6 +33,22 @@
 
 static const unsigned int freqs[] = { 100000, 200000, 300000, 400000 };
 
+#define TUNING_CACHE_TAG	0x544E4D44 /* "DMNT" */
+#define TUNING_CACHE_MAX	8
+#define TUNING_CACHE_VERIFY	3
+
+struct dw_mci_tuning_entry {
+	u32 key;
+	u32 phase;
+} __packed;
+
+struct dw_mci_tuning_cache {
+	u32 tag;
+	struct dw_mci_tuning_entry entry[TUNING_CACHE_MAX];
+} __packed;
+
+static DEFINE_MUTEX(tuning_cache_lock);
+
 struct dw_mci_rockchip_priv_data {
 	struct clk		*drv_clk;
 	struct clk		*sample_clk;
@@ -40,6 +58,8 @@ struct dw_mci_rockchip_priv_data {
 	int			usrid;
 	int			last_degree;
 	u32			f_min;
+	u32			tuning_key;	/* key of tuning_phase, 0 if none */
+	int			tuning_phase;
 };
 
 /*
@@ -322,7 +342,7 @@ static int dw_mci_v2_execute_tuning(struct dw_mci_slot *slot, u32 opcode)
 	return 0;
 }
 
-static int dw_mci_rk3288_execute_tuning(struct dw_mci_slot *slot, u32 opcode)
+static int dw_mci_rk3288_sweep_tuning(struct dw_mci_slot *slot, u32 opcode)
 {
 	struct dw_mci *host = slot->host;
 	struct dw_mci_rockchip_priv_data *priv = host->priv;
@@ -340,11 +360,6 @@ static int dw_mci_rk3288_execute_tuning(struct dw_mci_slot *slot, u32 opcode)
 	int longest_range = -1;
 	int middle_phase, real_middle_phase;
 
-	if (IS_ERR(priv->sample_clk)) {
-		dev_err(host->dev, "Tuning clock (sample_clk) not defined.\n");
-		return -EIO;
-	}
-
 	if (priv->use_v2_tuning) {
 		if (!dw_mci_v2_execute_tuning(slot, opcode))
 			return 0;
@@ -485,6 +500,169 @@ static int dw_mci_rk3288_execute_tuning(struct dw_mci_slot *slot, u32 opcode)
 	return ret;
 }
 
+static int dw_mci_rk3288_get_sample_phase(struct dw_mci *host)
+{
+	struct dw_mci_rockchip_priv_data *priv = host->priv;
+
+	if (priv->usrid == USRID_INTER_PHASE)
+		return rockchip_mmc_get_phase(host, true);
+
+	return clk_get_phase(priv->sample_clk);
+}
+
+static void dw_mci_rk3288_set_sample_phase(struct dw_mci *host, int degrees)
+{
+	struct dw_mci_rockchip_priv_data *priv = host->priv;
+
+	if (priv->usrid == USRID_INTER_PHASE)
+		rockchip_mmc_set_phase(host, true, degrees);
+	else
+		clk_set_phase(priv->sample_clk, degrees);
+}
+
+/* One entry per controller, card clock and timing */
+static u32 dw_mci_rk3288_tuning_key(struct dw_mci_slot *slot, u32 opcode)
+{
+	struct mmc_ios *ios = &slot->mmc->ios;
+	u32 key;
+
+	key = crc32(0, dev_name(slot->host->dev), strlen(dev_name(slot->host->dev)));
+	key = crc32(key, &ios->clock, sizeof(ios->clock));
+	key = crc32(key, &ios->timing, sizeof(ios->timing));
+	key = crc32(key, &opcode, sizeof(opcode));
+
+	return key ? key : 1;
+}
+
+static bool dw_mci_rk3288_tuning_cache_get(u32 key, int *phase)
+{
+	struct dw_mci_tuning_cache *cache;
+	bool found = false;
+	int i;
+
+	if (!is_rk_vendor_ready())
+		return false;
+
+	cache = kzalloc(sizeof(*cache), GFP_KERNEL);
+	if (!cache)
+		return false;
+
+	mutex_lock(&tuning_cache_lock);
+	if (rk_vendor_read(MMC_TUNING_CACHE_ID, cache, sizeof(*cache)) != sizeof(*cache) ||
+	    cache->tag != TUNING_CACHE_TAG)
+		goto out;
+	for (i = 0; i < TUNING_CACHE_MAX; i++) {
+		if (cache->entry[i].key == key) {
+			*phase = cache->entry[i].phase;
+			found = true;
+			break;
+		}
+	}
+out:
+	mutex_unlock(&tuning_cache_lock);
+	kfree(cache);
+
+	return found;
+}
+
+static void dw_mci_rk3288_tuning_cache_put(u32 key, int phase)
+{
+	struct dw_mci_tuning_cache *cache;
+	int i, slot = -1;
+
+	if (!is_rk_vendor_ready())
+		return;
+
+	cache = kzalloc(sizeof(*cache), GFP_KERNEL);
+	if (!cache)
+		return;
+
+	mutex_lock(&tuning_cache_lock);
+	if (rk_vendor_read(MMC_TUNING_CACHE_ID, cache, sizeof(*cache)) != sizeof(*cache) ||
+	    cache->tag != TUNING_CACHE_TAG) {
+		memset(cache, 0, sizeof(*cache));
+		cache->tag = TUNING_CACHE_TAG;
+	}
+	for (i = 0; i < TUNING_CACHE_MAX; i++) {
+		if (cache->entry[i].key == key) {
+			slot = i;
+			break;
+		}
+		if (slot < 0 && !cache->entry[i].key)
+			slot = i;
+	}
+	/* Table full, recycle the oldest entry */
+	if (slot < 0) {
+		memmove(&cache->entry[0], &cache->entry[1],
+			sizeof(cache->entry[0]) * (TUNING_CACHE_MAX - 1));
+		slot = TUNING_CACHE_MAX - 1;
+	}
+	if (cache->entry[slot].key != key || cache->entry[slot].phase != phase) {
+		cache->entry[slot].key = key;
+		cache->entry[slot].phase = phase;
+		rk_vendor_write_buffered(MMC_TUNING_CACHE_ID, cache,
+					 sizeof(*cache));
+	}
+	mutex_unlock(&tuning_cache_lock);
+	kfree(cache);
+}
+
+/* Re-check a previously good phase with a few tuning blocks */
+static int dw_mci_rk3288_cached_tuning(struct dw_mci_slot *slot, u32 opcode, u32 key)
+{
+	struct dw_mci *host = slot->host;
+	struct dw_mci_rockchip_priv_data *priv = host->priv;
+	int phase, i;
+
+	if (priv->tuning_key == key) {
+		phase = priv->tuning_phase;
+	} else if (!dw_mci_rk3288_tuning_cache_get(key, &phase)) {
+		return -ENOENT;
+	}
+
+	dw_mci_rk3288_set_sample_phase(host, phase);
+	for (i = 0; i < TUNING_CACHE_VERIFY; i++) {
+		if (mmc_send_tuning(slot->mmc, opcode, NULL)) {
+			dev_dbg(host->dev, "cached phase %d failed, full tuning\n", phase);
+			return -EIO;
+		}
+	}
+
+	priv->tuning_key = key;
+	priv->tuning_phase = phase;
+	priv->last_degree = phase;
+	dev_dbg(host->dev, "Use cached tuning phase %d\n", phase);
+
+	return 0;
+}
+
+static int dw_mci_rk3288_execute_tuning(struct dw_mci_slot *slot, u32 opcode)
+{
+	struct dw_mci *host = slot->host;
+	struct dw_mci_rockchip_priv_data *priv = host->priv;
+	u32 key;
+	int ret;
+
+	if (IS_ERR(priv->sample_clk)) {
+		dev_err(host->dev, "Tuning clock (sample_clk) not defined.\n");
+		return -EIO;
+	}
+
+	key = dw_mci_rk3288_tuning_key(slot, opcode);
+	if (!dw_mci_rk3288_cached_tuning(slot, opcode, key))
+		return 0;
+
+	ret = dw_mci_rk3288_sweep_tuning(slot, opcode);
+	if (ret)
+		return ret;
+
+	priv->tuning_key = key;
+	priv->tuning_phase = dw_mci_rk3288_get_sample_phase(host);
+	dw_mci_rk3288_tuning_cache_put(key, priv->tuning_phase);
+
+	return 0;
+}
+
 static int dw_mci_rk3288_parse_dt(struct dw_mci *host)
 {
 	struct device_node *np = host->dev->of_node;
@@ -64,6 +64,7 @@
 				 SDMMC_IDMAC_INT_TI)
 
 #define DESC_RING_BUF_SZ	PAGE_SIZE
+#define DESC_RING_NUM		2
 
 struct idmac_desc_64addr {
 	u32		des0;	/* Control Descriptor */
@@ -537,24 +538,35 @@ static void dw_mci_dmac_complete_dma(void *arg)
 		del_timer(&host->xfer_timer);
 }
 
-static int dw_mci_idmac_init(struct dw_mci *host)
+static inline void *dw_mci_idmac_ring(struct dw_mci *host, unsigned int idx)
+{
+	return host->sg_cpu + idx * DESC_RING_BUF_SZ;
+}
+
+static inline dma_addr_t dw_mci_idmac_ring_dma(struct dw_mci *host,
+					       unsigned int idx)
+{
+	return host->sg_dma + idx * DESC_RING_BUF_SZ;
+}
+
+static void dw_mci_idmac_link_ring(struct dw_mci *host, unsigned int idx)
 {
+	dma_addr_t ring_dma = dw_mci_idmac_ring_dma(host, idx);
 	int i;
 
+	memset(dw_mci_idmac_ring(host, idx), 0, DESC_RING_BUF_SZ);
+
 	if (host->dma_64bit_address == 1) {
 		struct idmac_desc_64addr *p;
-		/* Number of descriptors in the ring buffer */
-		host->ring_size =
-			DESC_RING_BUF_SZ / sizeof(struct idmac_desc_64addr);
 
 		/* Forward link the descriptor list */
-		for (i = 0, p = host->sg_cpu; i < host->ring_size - 1;
-								i++, p++) {
-			p->des6 = (host->sg_dma +
+		for (i = 0, p = dw_mci_idmac_ring(host, idx);
+		     i < host->ring_size - 1; i++, p++) {
+			p->des6 = (ring_dma +
 					(sizeof(struct idmac_desc_64addr) *
 							(i + 1))) & 0xffffffff;
 
-			p->des7 = (u64)(host->sg_dma +
+			p->des7 = (u64)(ring_dma +
 					(sizeof(struct idmac_desc_64addr) *
 							(i + 1))) >> 32;
 			/* Initialize reserved and buffer size fields to "0" */
@@ -565,30 +577,57 @@ static int dw_mci_idmac_init(struct dw_mci *host)
 		}
 
 		/* Set the last descriptor as the end-of-ring descriptor */
-		p->des6 = host->sg_dma & 0xffffffff;
-		p->des7 = (u64)host->sg_dma >> 32;
+		p->des6 = ring_dma & 0xffffffff;
+		p->des7 = (u64)ring_dma >> 32;
 		p->des0 = IDMAC_DES0_ER;
-
 	} else {
 		struct idmac_desc *p;
-		/* Number of descriptors in the ring buffer */
-		host->ring_size =
-			DESC_RING_BUF_SZ / sizeof(struct idmac_desc);
 
 		/* Forward link the descriptor list */
-		for (i = 0, p = host->sg_cpu;
+		for (i = 0, p = dw_mci_idmac_ring(host, idx);
 		     i < host->ring_size - 1;
 		     i++, p++) {
-			p->des3 = cpu_to_le32(host->sg_dma +
+			p->des3 = cpu_to_le32(ring_dma +
 					(sizeof(struct idmac_desc) * (i + 1)));
 			p->des0 = 0;
 			p->des1 = 0;
 		}
 
 		/* Set the last descriptor as the end-of-ring descriptor */
-		p->des3 = cpu_to_le32(host->sg_dma);
+		p->des3 = cpu_to_le32(ring_dma);
 		p->des0 = cpu_to_le32(IDMAC_DES0_ER);
 	}
+}
+
+static void dw_mci_idmac_set_ring(struct dw_mci *host, unsigned int idx)
+{
+	dma_addr_t ring_dma = dw_mci_idmac_ring_dma(host, idx);
+
+	if (host->dma_64bit_address == 1) {
+		mci_writel(host, DBADDRL, ring_dma & 0xffffffff);
+		mci_writel(host, DBADDRU, (u64)ring_dma >> 32);
+	} else {
+		mci_writel(host, DBADDR, ring_dma);
+	}
+
+	host->ring_cur = idx;
+}
+
+static int dw_mci_idmac_init(struct dw_mci *host)
+{
+	unsigned int i;
+
+	/* Number of descriptors in each ring buffer */
+	if (host->dma_64bit_address == 1)
+		host->ring_size =
+			DESC_RING_BUF_SZ / sizeof(struct idmac_desc_64addr);
+	else
+		host->ring_size =
+			DESC_RING_BUF_SZ / sizeof(struct idmac_desc);
+
+	for (i = 0; i < DESC_RING_NUM; i++)
+		dw_mci_idmac_link_ring(host, i);
+	host->ring_data = NULL;
 
 	dw_mci_idmac_reset(host);
 
@@ -597,34 +636,30 @@ static int dw_mci_idmac_init(struct dw_mci *host)
 		mci_writel(host, IDSTS64, IDMAC_INT_CLR);
 		mci_writel(host, IDINTEN64, SDMMC_IDMAC_INT_NI |
 				SDMMC_IDMAC_INT_RI | SDMMC_IDMAC_INT_TI);
-
-		/* Set the descriptor base address */
-		mci_writel(host, DBADDRL, host->sg_dma & 0xffffffff);
-		mci_writel(host, DBADDRU, (u64)host->sg_dma >> 32);
-
 	} else {
 		/* Mask out interrupts - get Tx & Rx complete only */
 		mci_writel(host, IDSTS, IDMAC_INT_CLR);
 		mci_writel(host, IDINTEN, SDMMC_IDMAC_INT_NI |
 				SDMMC_IDMAC_INT_RI | SDMMC_IDMAC_INT_TI);
-
-		/* Set the descriptor base address */
-		mci_writel(host, DBADDR, host->sg_dma);
 	}
 
+	/* Set the descriptor base address */
+	dw_mci_idmac_set_ring(host, 0);
+
 	return 0;
 }
 
 static inline int dw_mci_prepare_desc64(struct dw_mci *host,
 					 struct mmc_data *data,
-					 unsigned int sg_len)
+					 unsigned int sg_len,
+					 unsigned int idx)
 {
 	unsigned int desc_len;
 	struct idmac_desc_64addr *desc_first, *desc_last, *desc;
 	u32 val;
 	int i;
 
-	desc_first = desc_last = desc = host->sg_cpu;
+	desc_first = desc_last = desc = dw_mci_idmac_ring(host, idx);
 
 	for (i = 0; i < sg_len; i++) {
 		unsigned int length = sg_dma_len(&data->sg[i]);
@@ -679,24 +714,22 @@ static inline int dw_mci_prepare_desc64(struct dw_mci *host,
 
 	return 0;
 err_own_bit:
-	/* restore the descriptor chain as it's polluted */
 	dev_dbg(host->dev, "descriptor is still owned by IDMAC.\n");
-	memset(host->sg_cpu, 0, DESC_RING_BUF_SZ);
-	dw_mci_idmac_init(host);
 	return -EINVAL;
 }
 
 
 static inline int dw_mci_prepare_desc32(struct dw_mci *host,
 					 struct mmc_data *data,
-					 unsigned int sg_len)
+					 unsigned int sg_len,
+					 unsigned int idx)
 {
 	unsigned int desc_len;
 	struct idmac_desc *desc_first, *desc_last, *desc;
 	u32 val;
 	int i;
 
-	desc_first = desc_last = desc = host->sg_cpu;
+	desc_first = desc_last = desc = dw_mci_idmac_ring(host, idx);
 
 	for (i = 0; i < sg_len; i++) {
 		unsigned int length = sg_dma_len(&data->sg[i]);
@@ -760,25 +793,64 @@ static inline int dw_mci_prepare_desc32(struct dw_mci *host,
 
 	return 0;
 err_own_bit:
-	/* restore the descriptor chain as it's polluted */
 	dev_dbg(host->dev, "descriptor is still owned by IDMAC.\n");
-	memset(host->sg_cpu, 0, DESC_RING_BUF_SZ);
-	dw_mci_idmac_init(host);
 	return -EINVAL;
 }
 
+static int dw_mci_idmac_prepare_ring(struct dw_mci *host,
+				     struct mmc_data *data,
+				     unsigned int sg_len,
+				     unsigned int idx)
+{
+	if (host->dma_64bit_address == 1)
+		return dw_mci_prepare_desc64(host, data, sg_len, idx);
+
+	return dw_mci_prepare_desc32(host, data, sg_len, idx);
+}
+
+/*
+ * Build the descriptor chain of a pre-mapped request into the ring that
+ * the running transfer is not using, so that start_dma() only needs to
+ * point DBADDR at it. Called with host->lock held.
+ */
+static void dw_mci_idmac_prepare_next(struct dw_mci *host,
+				      struct mmc_data *data,
+				      unsigned int sg_len)
+{
+	unsigned int idx = host->ring_cur ^ 1;
+
+	if (host->ring_data)
+		return;
+
+	if (dw_mci_idmac_prepare_ring(host, data, sg_len, idx)) {
+		/* The idle ring is not live, relinking it is enough */
+		dw_mci_idmac_link_ring(host, idx);
+		return;
+	}
+
+	host->ring_data = data;
+}
+
 static int dw_mci_idmac_start_dma(struct dw_mci *host, unsigned int sg_len)
 {
+	struct mmc_data *data = host->data;
+	unsigned int idx = host->ring_cur ^ 1;
 	u32 temp;
-	int ret;
+	int ret = 0;
 
-	if (host->dma_64bit_address == 1)
-		ret = dw_mci_prepare_desc64(host, host->data, sg_len);
-	else
-		ret = dw_mci_prepare_desc32(host, host->data, sg_len);
+	if (host->ring_data != data ||
+	    data->host_cookie != COOKIE_PRE_MAPPED) {
+		if (host->ring_data)
+			dw_mci_idmac_link_ring(host, idx);
+		ret = dw_mci_idmac_prepare_ring(host, data, sg_len, idx);
+	}
+	host->ring_data = NULL;
 
-	if (ret)
+	if (ret) {
+		/* restore the descriptor chain as it's polluted */
+		dw_mci_idmac_init(host);
 		goto out;
+	}
 
 	/* drain writebuffer */
 	wmb();
@@ -787,6 +859,9 @@ static int dw_mci_idmac_start_dma(struct dw_mci *host, unsigned int sg_len)
 	dw_mci_ctrl_reset(host, SDMMC_CTRL_DMA_RESET);
 	dw_mci_idmac_reset(host);
 
+	/* Fetch from the ring holding this request's descriptors */
+	dw_mci_idmac_set_ring(host, idx);
+
 	/* Select IDMAC interface */
 	temp = mci_readl(host, CTRL);
 	temp |= SDMMC_CTRL_USE_IDMAC;
@@ -961,17 +1036,27 @@ static void dw_mci_pre_req(struct mmc_host *mmc,
 			   struct mmc_request *mrq)
 {
 	struct dw_mci_slot *slot = mmc_priv(mmc);
+	struct dw_mci *host = slot->host;
 	struct mmc_data *data = mrq->data;
+	int sg_len;
 
-	if (!slot->host->use_dma || !data)
+	if (!host->use_dma || !data)
 		return;
 
 	/* This data might be unmapped at this time */
 	data->host_cookie = COOKIE_UNMAPPED;
 
-	if (dw_mci_pre_dma_transfer(slot->host, mrq->data,
-				COOKIE_PRE_MAPPED) < 0)
+	sg_len = dw_mci_pre_dma_transfer(host, mrq->data, COOKIE_PRE_MAPPED);
+	if (sg_len < 0) {
 		data->host_cookie = COOKIE_UNMAPPED;
+		return;
+	}
+
+	if (host->use_dma == TRANS_MODE_IDMAC) {
+		spin_lock_bh(&host->lock);
+		dw_mci_idmac_prepare_next(host, data, sg_len);
+		spin_unlock_bh(&host->lock);
+	}
 }
 
 static void dw_mci_post_req(struct mmc_host *mmc,
@@ -979,11 +1064,21 @@ static void dw_mci_post_req(struct mmc_host *mmc,
 			    int err)
 {
 	struct dw_mci_slot *slot = mmc_priv(mmc);
+	struct dw_mci *host = slot->host;
 	struct mmc_data *data = mrq->data;
 
-	if (!slot->host->use_dma || !data)
+	if (!host->use_dma || !data)
 		return;
 
+	if (host->use_dma == TRANS_MODE_IDMAC && host->ring_data == data) {
+		spin_lock_bh(&host->lock);
+		if (host->ring_data == data) {
+			dw_mci_idmac_link_ring(host, host->ring_cur ^ 1);
+			host->ring_data = NULL;
+		}
+		spin_unlock_bh(&host->lock);
+	}
+
 	if (data->host_cookie != COOKIE_UNMAPPED)
 		dma_unmap_sg(slot->host->dev,
 			     data->sg,
@@ -3191,7 +3286,8 @@ static void dw_mci_init_dma(struct dw_mci *host)
 
 		/* Alloc memory for sg translation */
 		host->sg_cpu = dmam_alloc_coherent(host->dev,
-						   DESC_RING_BUF_SZ,
+						   DESC_RING_BUF_SZ *
+						   DESC_RING_NUM,
 						   &host->sg_dma, GFP_KERNEL);
 		if (!host->sg_cpu) {
 			dev_err(host->dev,
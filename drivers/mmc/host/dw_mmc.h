@@ -80,6 +80,8 @@ struct dw_mci_dma_slave {
  * @dma_ops: Pointer to platform-specific DMA callbacks.
  * @cmd_status: Snapshot of SR taken upon completion of the current
  * @ring_size: Buffer size for idma descriptors.
+ * @ring_cur: Index of the idma descriptor ring loaded into DBADDR.
+ * @ring_data: Request whose descriptors are already built in the idle ring.
  *	command. Only valid when EVENT_CMD_COMPLETE is pending.
  * @dms: structure of slave-dma private data.
  * @phy_regs: physical address of controller's register map
@@ -184,6 +186,8 @@ struct dw_mci {
 	const struct dw_mci_dma_ops	*dma_ops;
 	/* For idmac */
 	unsigned int		ring_size;
+	unsigned int		ring_cur;
+	struct mmc_data		*ring_data;
 
 	/* For edmac */
 	struct dw_mci_dma_slave *dms;
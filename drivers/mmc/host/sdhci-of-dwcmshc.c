@@ -21,6 +21,7 @@
 #include <linux/sizes.h>
 
 #include "sdhci-pltfm.h"
+#include "cqhci.h"
 #include "mmc_hsq.h"
 
 #define SDHCI_DWCMSHC_ARG2_STUFF	GENMASK(31, 16)
@@ -38,6 +39,13 @@
 #define DWCMSHC_ENHANCED_STROBE		BIT(8)
 #define DWCMSHC_EMMC_ATCTRL		0x40
 
+/* DWC IP vendor area 2 pointer, the CQE register block */
+#define DWCMSHC_P_VENDOR_AREA2		0xea
+
+#define DWCMSHC_SDHCI_CQE_TRNS_MODE	(SDHCI_TRNS_MULTI | \
+					 SDHCI_TRNS_BLK_CNT_EN | \
+					 SDHCI_TRNS_DMA)
+
 /* Rockchip specific Registers */
 #define DWCMSHC_EMMC_DLL_CTRL		0x800
 #define DWCMSHC_EMMC_DLL_RXCLK		0x804
@@ -95,6 +103,7 @@ struct dwcmshc_driver_data {
 #define RK_DLL_CMD_OUT		BIT(1)
 #define RK_RXCLK_NO_INVERTER	BIT(2)
 #define RK_TAP_VALUE_SEL	BIT(3)
+#define RK_CQE			BIT(4)
 
 	u8 hs200_tx_tap;
 	u8 hs400_tx_tap;
@@ -118,6 +127,8 @@ struct rk35xx_priv {
 struct dwcmshc_priv {
 	struct clk	*bus_clk;
 	int vendor_specific_area1; /* P_VENDOR_SPECIFIC_AREA reg */
+	int vendor_specific_area2; /* P_VENDOR_SPECIFIC_AREA2 reg */
+	bool cqe_en; /* CQE in use, otherwise host software queue */
 	void *priv; /* pointer to SoC private stuff */
 };
 
@@ -376,6 +387,9 @@ static void rk35xx_sdhci_reset(struct sdhci_host *host, u8 mask)
 	struct dwcmshc_priv *dwc_priv = sdhci_pltfm_priv(pltfm_host);
 	struct rk35xx_priv *priv = dwc_priv->priv;
 
+	if (dwc_priv->cqe_en && (mask & SDHCI_RESET_ALL))
+		cqhci_deactivate(host->mmc);
+
 	if (mask & SDHCI_RESET_ALL && priv->reset) {
 		reset_control_assert(priv->reset);
 		udelay(1);
@@ -387,12 +401,174 @@ static void rk35xx_sdhci_reset(struct sdhci_host *host, u8 mask)
 
 static void sdhci_dwcmshc_request_done(struct sdhci_host *host, struct mmc_request *mrq)
 {
-	if (mmc_hsq_finalize_request(host->mmc, mrq))
+	struct sdhci_pltfm_host *pltfm_host = sdhci_priv(host);
+	struct dwcmshc_priv *dwc_priv = sdhci_pltfm_priv(pltfm_host);
+
+	if (!dwc_priv->cqe_en && mmc_hsq_finalize_request(host->mmc, mrq))
 		return;
 
 	mmc_request_done(host->mmc, mrq);
 }
 
+static u32 dwcmshc_cqe_irq_handler(struct sdhci_host *host, u32 intmask)
+{
+	int cmd_error = 0;
+	int data_error = 0;
+
+	if (!sdhci_cqe_irq(host, intmask, &cmd_error, &data_error))
+		return intmask;
+
+	cqhci_irq(host->mmc, intmask, cmd_error, data_error);
+
+	return 0;
+}
+
+static void dwcmshc_cqe_pre_enable(struct mmc_host *mmc)
+{
+	struct sdhci_host *host = mmc_priv(mmc);
+	struct sdhci_pltfm_host *pltfm_host = sdhci_priv(host);
+	struct dwcmshc_priv *dwc_priv = sdhci_pltfm_priv(pltfm_host);
+	u32 reg;
+
+	reg = sdhci_readl(host, dwc_priv->vendor_specific_area2 + CQHCI_CFG);
+	reg |= CQHCI_ENABLE;
+	sdhci_writel(host, reg, dwc_priv->vendor_specific_area2 + CQHCI_CFG);
+}
+
+static void dwcmshc_cqe_enable(struct mmc_host *mmc)
+{
+	struct sdhci_host *host = mmc_priv(mmc);
+	u8 ctrl;
+
+	sdhci_writew(host, DWCMSHC_SDHCI_CQE_TRNS_MODE, SDHCI_TRANSFER_MODE);
+
+	sdhci_cqe_enable(mmc);
+
+	/*
+	 * With Host Version 4 Enable set, DMA_SEL must select ADMA2 only,
+	 * the addressing width comes from Host Control 2.
+	 */
+	ctrl = sdhci_readb(host, SDHCI_HOST_CONTROL);
+	ctrl &= ~SDHCI_CTRL_DMA_MASK;
+	ctrl |= SDHCI_CTRL_ADMA32;
+	sdhci_writeb(host, ctrl, SDHCI_HOST_CONTROL);
+}
+
+static void dwcmshc_cqe_disable(struct mmc_host *mmc, bool recovery)
+{
+	struct sdhci_host *host = mmc_priv(mmc);
+	unsigned long flags;
+	u32 ctrl;
+
+	/*
+	 * Command complete is latched while CQE runs, clear it so halting
+	 * or disabling CQE doesn't raise a stale legacy interrupt.
+	 */
+	spin_lock_irqsave(&host->lock, flags);
+	ctrl = sdhci_readl(host, SDHCI_INT_ENABLE);
+	ctrl |= SDHCI_INT_RESPONSE;
+	sdhci_writel(host, ctrl, SDHCI_INT_ENABLE);
+	sdhci_writel(host, SDHCI_INT_RESPONSE, SDHCI_INT_STATUS);
+	spin_unlock_irqrestore(&host->lock, flags);
+
+	sdhci_cqe_disable(mmc, recovery);
+}
+
+static void dwcmshc_cqe_post_disable(struct mmc_host *mmc)
+{
+	struct sdhci_host *host = mmc_priv(mmc);
+	struct sdhci_pltfm_host *pltfm_host = sdhci_priv(host);
+	struct dwcmshc_priv *dwc_priv = sdhci_pltfm_priv(pltfm_host);
+	u32 reg;
+
+	reg = sdhci_readl(host, dwc_priv->vendor_specific_area2 + CQHCI_CFG);
+	reg &= ~CQHCI_ENABLE;
+	sdhci_writel(host, reg, dwc_priv->vendor_specific_area2 + CQHCI_CFG);
+}
+
+/* Same 128MB boundary split as dwcmshc_adma_write_desc() */
+static void dwcmshc_cqe_set_tran_desc(struct cqhci_host *cq_host, u8 **desc,
+				      dma_addr_t addr, int len, bool end, bool dma64)
+{
+	int tmplen, offset;
+
+	if (likely(!len || BOUNDARY_OK(addr, len))) {
+		cqhci_set_tran_desc(*desc, addr, len, end, dma64);
+		return;
+	}
+
+	offset = addr & (SZ_128M - 1);
+	tmplen = SZ_128M - offset;
+	cqhci_set_tran_desc(*desc, addr, tmplen, false, dma64);
+
+	addr += tmplen;
+	len -= tmplen;
+	*desc += cq_host->trans_desc_len;
+	cqhci_set_tran_desc(*desc, addr, len, end, dma64);
+}
+
+static void dwcmshc_cqhci_dumpregs(struct mmc_host *mmc)
+{
+	sdhci_dumpregs(mmc_priv(mmc));
+}
+
+static const struct cqhci_host_ops dwcmshc_cqhci_ops = {
+	.pre_enable	= dwcmshc_cqe_pre_enable,
+	.enable		= dwcmshc_cqe_enable,
+	.disable	= dwcmshc_cqe_disable,
+	.post_disable	= dwcmshc_cqe_post_disable,
+	.dumpregs	= dwcmshc_cqhci_dumpregs,
+	.set_tran_desc	= dwcmshc_cqe_set_tran_desc,
+};
+
+static int dwcmshc_cqhci_init(struct sdhci_host *host, struct dwcmshc_priv *dwc_priv,
+			      u32 extra)
+{
+	struct device *dev = mmc_dev(host->mmc);
+	struct cqhci_host *cq_host;
+	bool dma64;
+	u16 clk;
+	int err;
+
+	if (!(host->flags & SDHCI_USE_ADMA))
+		return -EINVAL;
+
+	cq_host = devm_kzalloc(dev, sizeof(*cq_host), GFP_KERNEL);
+	if (!cq_host)
+		return -ENOMEM;
+
+	/* Vendor area 2 is only reachable with the internal clock running */
+	clk = sdhci_readw(host, SDHCI_CLOCK_CONTROL);
+	sdhci_writew(host, clk | SDHCI_CLOCK_INT_EN, SDHCI_CLOCK_CONTROL);
+
+	dwc_priv->vendor_specific_area2 = sdhci_readw(host, DWCMSHC_P_VENDOR_AREA2);
+
+	cq_host->mmio = host->ioaddr + dwc_priv->vendor_specific_area2;
+	cq_host->ops = &dwcmshc_cqhci_ops;
+
+	dma64 = host->flags & SDHCI_USE_64_BIT_DMA;
+	if (dma64)
+		cq_host->caps |= CQHCI_TASK_DESC_SZ_128;
+
+	/*
+	 * A segment split at a 128MB boundary takes an extra descriptor
+	 * from the per-tag table, which is sized by max_segs.
+	 */
+	if (host->mmc->max_segs > extra)
+		host->mmc->max_segs -= extra;
+
+	err = cqhci_init(cq_host, host->mmc, dma64);
+	if (err) {
+		host->mmc->max_segs += extra;
+		sdhci_writew(host, clk, SDHCI_CLOCK_CONTROL);
+		return err;
+	}
+
+	dwc_priv->cqe_en = true;
+
+	return 0;
+}
+
 static const struct sdhci_ops sdhci_dwcmshc_ops = {
 	.set_clock		= sdhci_set_clock,
 	.set_bus_width		= sdhci_set_bus_width,
@@ -410,6 +586,7 @@ static const struct sdhci_ops sdhci_dwcmshc_rk35xx_ops = {
 	.reset			= rk35xx_sdhci_reset,
 	.adma_write_desc	= dwcmshc_adma_write_desc,
 	.request_done		= sdhci_dwcmshc_request_done,
+	.irq			= dwcmshc_cqe_irq_handler,
 };
 
 static const struct sdhci_pltfm_data sdhci_dwcmshc_pdata = {
@@ -536,7 +713,7 @@ static const struct dwcmshc_driver_data rk3562_drvdata = {
 
 static const struct dwcmshc_driver_data rk3576_drvdata = {
 	.pdata = &sdhci_dwcmshc_rk35xx_pdata,
-	.flags = RK_PLATFROM | RK_DLL_CMD_OUT | RK_TAP_VALUE_SEL,
+	.flags = RK_PLATFROM | RK_DLL_CMD_OUT | RK_TAP_VALUE_SEL | RK_CQE,
 	.hs200_tx_tap = 16,
 	.hs400_tx_tap = 7,
 	.hs400_cmd_tap = 7,
@@ -593,6 +770,7 @@ static int dwcmshc_probe(struct platform_device *pdev)
 	const struct sdhci_pltfm_data *pltfm_data;
 	const struct dwcmshc_driver_data *drv_data;
 	struct mmc_hsq *hsq;
+	bool use_cqe;
 	int err;
 	u32 extra;
 
@@ -647,15 +825,11 @@ static int dwcmshc_probe(struct platform_device *pdev)
 	host->mmc_host_ops.request = dwcmshc_request;
 	host->mmc_host_ops.hs400_enhanced_strobe = dwcmshc_hs400_enhanced_strobe;
 
-	hsq = devm_kzalloc(&pdev->dev, sizeof(*hsq), GFP_KERNEL);
-	if (!hsq) {
-		err = -ENOMEM;
-		goto err_clk;
-	}
-
-	err = mmc_hsq_init(hsq, host->mmc);
-	if (err)
-		goto err_clk;
+	/* Variants with CQE errata keep the host software queue */
+	use_cqe = (drv_data->flags & RK_CQE) &&
+		  device_property_read_bool(dev, "supports-cqe");
+	if (use_cqe)
+		host->mmc->caps2 |= MMC_CAP2_CQE | MMC_CAP2_CQE_DCMD;
 
 	if (drv_data->flags & RK_PLATFROM) {
 		rk_priv = devm_kzalloc(&pdev->dev, sizeof(struct rk35xx_priv), GFP_KERNEL);
@@ -688,6 +862,26 @@ static int dwcmshc_probe(struct platform_device *pdev)
 	if (rk_priv)
 		dwcmshc_rk35xx_postinit(host, priv);
 
+	if (use_cqe) {
+		err = dwcmshc_cqhci_init(host, priv, extra);
+		if (err) {
+			dev_warn(dev, "failed to setup CQE %d, use software queue\n", err);
+			host->mmc->caps2 &= ~(MMC_CAP2_CQE | MMC_CAP2_CQE_DCMD);
+		}
+	}
+
+	if (!priv->cqe_en) {
+		hsq = devm_kzalloc(&pdev->dev, sizeof(*hsq), GFP_KERNEL);
+		if (!hsq) {
+			err = -ENOMEM;
+			goto err_setup_host;
+		}
+
+		err = mmc_hsq_init(hsq, host->mmc);
+		if (err)
+			goto err_setup_host;
+	}
+
 	err = __sdhci_add_host(host);
 	if (err)
 		goto err_setup_host;
@@ -750,7 +944,13 @@ static int dwcmshc_suspend(struct device *dev)
 	struct rk35xx_priv *rk_priv = priv->priv;
 	int ret;
 
-	mmc_hsq_suspend(host->mmc);
+	if (priv->cqe_en) {
+		ret = cqhci_suspend(host->mmc);
+		if (ret)
+			return ret;
+	} else {
+		mmc_hsq_suspend(host->mmc);
+	}
 
 	ret = sdhci_suspend_host(host);
 	if (ret)
@@ -796,6 +996,9 @@ static int dwcmshc_resume(struct device *dev)
 	if (ret)
 		return ret;
 
+	if (priv->cqe_en)
+		return cqhci_resume(host->mmc);
+
 	return mmc_hsq_resume(host->mmc);
 }
 
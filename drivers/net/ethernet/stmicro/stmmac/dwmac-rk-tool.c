@@ -9,6 +9,7 @@
 #include <linux/if_ether.h>
 #include <linux/if.h>
 #include <linux/dma-mapping.h>
+#include <linux/kernel_stat.h>
 #include <linux/of_device.h>
 #include <linux/slab.h>
 #include <linux/prefetch.h>
@@ -1563,6 +1564,90 @@ static ssize_t phy_lb_scan_store(struct device *dev,
 }
 static DEVICE_ATTR_WO(phy_lb_scan);
 
+static const struct {
+	const char *name;
+	bool axi_low;
+	bool csu_release;
+} dwmac_rk_bench_profiles[] = {
+	{ "default", false, false },
+	{ "axi-low", true, false },
+	{ "csu", false, true },
+	{ "axi-low+csu", true, true },
+};
+
+static void dwmac_rk_bench_sample(struct net_device *ndev, u64 *bytes,
+				  u64 *busy)
+{
+	struct rtnl_link_stats64 stats;
+	struct kernel_cpustat kcs;
+	int cpu;
+
+	dev_get_stats(ndev, &stats);
+	*bytes = stats.rx_bytes + stats.tx_bytes;
+
+	*busy = 0;
+	for_each_online_cpu(cpu) {
+		kcpustat_cpu_fetch(&kcs, cpu);
+		*busy += kcs.cpustat[CPUTIME_USER] + kcs.cpustat[CPUTIME_NICE] +
+			 kcs.cpustat[CPUTIME_SYSTEM] + kcs.cpustat[CPUTIME_IRQ] +
+			 kcs.cpustat[CPUTIME_SOFTIRQ];
+	}
+}
+
+/* Sweep the speed dependent AXI/CSU settings under live traffic, the
+ * load (e.g. iperf) has to be generated while the bench runs.
+ */
+static ssize_t speed_bench_store(struct device *dev,
+				 struct device_attribute *attr,
+				 const char *buf, size_t count)
+{
+	struct net_device *ndev = dev_get_drvdata(dev);
+	struct stmmac_priv *priv = netdev_priv(ndev);
+	u64 bytes0, bytes1, busy0, busy1, wall, mbps, cpu;
+	unsigned int ms;
+	ktime_t start;
+	int i, ret;
+
+	ret = kstrtouint(buf, 0, &ms);
+	if (ret || !ms)
+		return -EINVAL;
+
+	if (!netif_running(ndev) || !netif_carrier_ok(ndev)) {
+		pr_warn("Speed bench needs the link up\n");
+		return -ENETDOWN;
+	}
+
+	pr_info("Speed bench at %d Mbps, %u ms per setting\n", priv->speed, ms);
+
+	for (i = 0; i < ARRAY_SIZE(dwmac_rk_bench_profiles); i++) {
+		if (dwmac_rk_set_speed_tuning(priv,
+					      dwmac_rk_bench_profiles[i].axi_low,
+					      dwmac_rk_bench_profiles[i].csu_release)) {
+			pr_info("%-12s: not supported\n",
+				dwmac_rk_bench_profiles[i].name);
+			continue;
+		}
+
+		start = ktime_get();
+		dwmac_rk_bench_sample(ndev, &bytes0, &busy0);
+		msleep(ms);
+		dwmac_rk_bench_sample(ndev, &bytes1, &busy1);
+		wall = ktime_to_ns(ktime_sub(ktime_get(), start));
+
+		mbps = div64_u64((bytes1 - bytes0) * 8 * 1000, wall);
+		cpu = div64_u64((busy1 - busy0) * 1000,
+				wall * num_online_cpus());
+		pr_info("%-12s: %llu Mbps, cpu %llu.%llu%%\n",
+			dwmac_rk_bench_profiles[i].name, mbps, cpu / 10,
+			cpu % 10);
+	}
+
+	dwmac_rk_restore_speed_tuning(priv);
+
+	return count;
+}
+static DEVICE_ATTR_WO(speed_bench);
+
 int dwmac_rk_create_loopback_sysfs(struct device *device)
 {
 	int ret;
@@ -1583,8 +1668,15 @@ int dwmac_rk_create_loopback_sysfs(struct device *device)
 	if (ret)
 		goto remove_phy_lb;
 
+	ret = device_create_file(device, &dev_attr_speed_bench);
+	if (ret)
+		goto remove_phy_lb_scan;
+
 	return 0;
 
+remove_phy_lb_scan:
+	device_remove_file(device, &dev_attr_phy_lb_scan);
+
 remove_rgmii_delayline:
 	device_remove_file(device, &dev_attr_rgmii_delayline);
 
@@ -1603,6 +1695,7 @@ int dwmac_rk_remove_loopback_sysfs(struct device *device)
 	device_remove_file(device, &dev_attr_mac_lb);
 	device_remove_file(device, &dev_attr_phy_lb);
 	device_remove_file(device, &dev_attr_phy_lb_scan);
+	device_remove_file(device, &dev_attr_speed_bench);
 
 	return 0;
 }
@@ -12,6 +12,9 @@
 void dwmac_rk_set_rgmii_delayline(struct stmmac_priv *priv, int tx_delay, int rx_delay);
 void dwmac_rk_get_rgmii_delayline(struct stmmac_priv *priv, int *tx_delay, int *rx_delay);
 int dwmac_rk_get_phy_interface(struct stmmac_priv *priv);
+int dwmac_rk_set_speed_tuning(struct stmmac_priv *priv, bool axi_low,
+			      bool csu_release);
+void dwmac_rk_restore_speed_tuning(struct stmmac_priv *priv);
 
 #ifdef CONFIG_DWMAC_ROCKCHIP_TOOL
 int dwmac_rk_create_loopback_sysfs(struct device *dev);
@@ -86,6 +86,12 @@ struct rk_priv_data {
 
 	struct csu_clk *csu_aclk;
 	struct csu_clk *csu_pclk;
+	bool csu_low_speed;
+	bool csu_released;
+
+	/* AXI settings used while the link runs at 10/100 */
+	struct stmmac_axi *axi_low;
+	int speed;
 };
 
 /* XPCS */
@@ -2527,9 +2533,79 @@ static int rk_gmac_csu_init(struct plat_stmmacenet_data *plat)
 	if (IS_ERR(bsp_priv->csu_pclk))
 		bsp_priv->csu_pclk = NULL;
 
+	/* Let the CSU scale the bus clocks down while at 10/100 */
+	if (bsp_priv->csu_aclk || bsp_priv->csu_pclk)
+		bsp_priv->csu_low_speed =
+			of_property_read_bool(dev->of_node,
+					      "rockchip,csu-low-speed");
+
 	return 0;
 }
 
+static void rk_gmac_csu_release(struct rk_priv_data *bsp_priv, bool release)
+{
+	if (bsp_priv->csu_released == release)
+		return;
+
+	if (release) {
+		rockchip_csu_enable(bsp_priv->csu_aclk);
+		rockchip_csu_enable(bsp_priv->csu_pclk);
+	} else {
+		rockchip_csu_disable(bsp_priv->csu_aclk);
+		rockchip_csu_disable(bsp_priv->csu_pclk);
+	}
+	bsp_priv->csu_released = release;
+}
+
+static void rk_gmac_axi_init(struct plat_stmmacenet_data *plat)
+{
+	struct rk_priv_data *bsp_priv = plat->bsp_priv;
+	struct device *dev = &bsp_priv->pdev->dev;
+	struct device_node *np;
+	struct stmmac_axi *axi;
+
+	/* The bus mode is only restored if the core programs it too */
+	if (!plat->axi)
+		return;
+
+	np = of_parse_phandle(dev->of_node, "rockchip,axi-low-speed-config", 0);
+	if (!np)
+		return;
+
+	axi = devm_kmemdup(dev, plat->axi, sizeof(*axi), GFP_KERNEL);
+	if (!axi) {
+		of_node_put(np);
+		return;
+	}
+
+	of_property_read_u32(np, "snps,wr_osr_lmt", &axi->axi_wr_osr_lmt);
+	of_property_read_u32(np, "snps,rd_osr_lmt", &axi->axi_rd_osr_lmt);
+	if (of_find_property(np, "snps,blen", NULL)) {
+		memset(axi->axi_blen, 0, sizeof(axi->axi_blen));
+		of_property_read_u32_array(np, "snps,blen", axi->axi_blen,
+					   AXI_BLEN);
+	}
+	of_node_put(np);
+
+	bsp_priv->axi_low = axi;
+}
+
+static void rk_gmac_speed_tuning(struct rk_priv_data *bsp_priv, bool axi_low,
+				 bool csu_release)
+{
+	struct net_device *ndev = dev_get_drvdata(&bsp_priv->pdev->dev);
+	struct stmmac_priv *priv;
+
+	if (bsp_priv->axi_low && ndev) {
+		priv = netdev_priv(ndev);
+		stmmac_axi(priv, priv->ioaddr,
+			   axi_low ? bsp_priv->axi_low : priv->plat->axi);
+	}
+
+	if (bsp_priv->clk_enabled)
+		rk_gmac_csu_release(bsp_priv, csu_release);
+}
+
 static int gmac_clk_enable(struct rk_priv_data *bsp_priv, bool enable)
 {
 	int phy_iface = bsp_priv->phy_iface;
@@ -2614,8 +2690,11 @@ static int gmac_clk_enable(struct rk_priv_data *bsp_priv, bool enable)
 
 			clk_disable_unprepare(bsp_priv->clk_xpcs_eee);
 
-			rockchip_csu_enable(bsp_priv->csu_aclk);
-			rockchip_csu_enable(bsp_priv->csu_pclk);
+			if (!bsp_priv->csu_released) {
+				rockchip_csu_enable(bsp_priv->csu_aclk);
+				rockchip_csu_enable(bsp_priv->csu_pclk);
+			}
+			bsp_priv->csu_released = false;
 
 			/**
 			 * if (!IS_ERR(bsp_priv->clk_mac))
@@ -2920,6 +2999,10 @@ static void rk_fix_speed(void *priv, unsigned int speed)
 	default:
 		dev_err(dev, "unsupported interface %d", bsp_priv->phy_iface);
 	}
+
+	bsp_priv->speed = speed;
+	rk_gmac_speed_tuning(bsp_priv, speed < SPEED_1000,
+			     speed < SPEED_1000 && bsp_priv->csu_low_speed);
 }
 
 static int rk_integrated_phy_power(void *priv, bool up)
@@ -2969,6 +3052,30 @@ int dwmac_rk_get_phy_interface(struct stmmac_priv *priv)
 }
 EXPORT_SYMBOL(dwmac_rk_get_phy_interface);
 
+int dwmac_rk_set_speed_tuning(struct stmmac_priv *priv, bool axi_low,
+			      bool csu_release)
+{
+	struct rk_priv_data *bsp_priv = priv->plat->bsp_priv;
+
+	if ((axi_low && !bsp_priv->axi_low) ||
+	    (csu_release && !bsp_priv->csu_aclk && !bsp_priv->csu_pclk))
+		return -EOPNOTSUPP;
+
+	rk_gmac_speed_tuning(bsp_priv, axi_low, csu_release);
+
+	return 0;
+}
+EXPORT_SYMBOL(dwmac_rk_set_speed_tuning);
+
+void dwmac_rk_restore_speed_tuning(struct stmmac_priv *priv)
+{
+	struct rk_priv_data *bsp_priv = priv->plat->bsp_priv;
+	bool low = bsp_priv->speed && bsp_priv->speed < SPEED_1000;
+
+	rk_gmac_speed_tuning(bsp_priv, low, low && bsp_priv->csu_low_speed);
+}
+EXPORT_SYMBOL(dwmac_rk_restore_speed_tuning);
+
 static void rk_get_eth_addr(void *priv, unsigned char *addr)
 {
 	struct rk_priv_data *bsp_priv = priv;
@@ -3050,6 +3157,7 @@ static int rk_gmac_probe(struct platform_device *pdev)
 	}
 
 	rk_gmac_csu_init(plat_dat);
+	rk_gmac_axi_init(plat_dat);
 
 	ret = rk_gmac_clk_init(plat_dat);
 	if (ret)
@@ -296,6 +296,9 @@ enum power_event {
 #define GMAC_HI_REG_AE			BIT(31)
 
 /* L3/L4 Filters regs */
+#define GMAC_DMCHEN0			BIT(28)
+#define GMAC_DMCHN0			GENMASK(27, 24)
+#define GMAC_DMCHN0_SHIFT		24
 #define GMAC_L4DPIM0			BIT(21)
 #define GMAC_L4DPM0			BIT(20)
 #define GMAC_L4SPIM0			BIT(19)
@@ -336,6 +339,7 @@ enum power_event {
 #define MTL_RXQ_DMA_Q04MDMACH(x)	((x) << 0)
 #define MTL_RXQ_DMA_QXMDMACH_MASK(x)	GENMASK(11 + (8 * ((x) - 1)), 8 * (x))
 #define MTL_RXQ_DMA_QXMDMACH(chan, q)	((chan) << (8 * (q)))
+#define MTL_RXQ_DMA_Q0DDMACH		BIT(4)
 
 #define MTL_CHAN_BASE_ADDR		0x00000d00
 #define MTL_CHAN_BASE_OFFSET		0x40
@@ -1098,13 +1098,13 @@ static int dwmac4_config_l4_filter(struct mac_device_info *hw, u32 filter_no,
 		value &= ~GMAC_L4PEN0;
 	}
 
-	value &= ~(GMAC_L4SPM0 | GMAC_L4SPIM0);
-	value &= ~(GMAC_L4DPM0 | GMAC_L4DPIM0);
 	if (sa) {
+		value &= ~(GMAC_L4SPM0 | GMAC_L4SPIM0);
 		value |= GMAC_L4SPM0;
 		if (inv)
 			value |= GMAC_L4SPIM0;
 	} else {
+		value &= ~(GMAC_L4DPM0 | GMAC_L4DPIM0);
 		value |= GMAC_L4DPM0;
 		if (inv)
 			value |= GMAC_L4DPIM0;
@@ -1112,10 +1112,14 @@ static int dwmac4_config_l4_filter(struct mac_device_info *hw, u32 filter_no,
 
 	writel(value, ioaddr + GMAC_L3L4_CTRL(filter_no));
 
+	/* Keep the other port so one filter can match both */
+	value = readl(ioaddr + GMAC_L4_ADDR(filter_no));
 	if (sa) {
-		value = match & GMAC_L4SP0;
+		value &= ~GMAC_L4SP0;
+		value |= match & GMAC_L4SP0;
 	} else {
-		value = (match << GMAC_L4DP0_SHIFT) & GMAC_L4DP0;
+		value &= ~GMAC_L4DP0;
+		value |= (match << GMAC_L4DP0_SHIFT) & GMAC_L4DP0;
 	}
 
 	writel(value, ioaddr + GMAC_L4_ADDR(filter_no));
@@ -1126,6 +1130,41 @@ static int dwmac4_config_l4_filter(struct mac_device_info *hw, u32 filter_no,
 	return 0;
 }
 
+static int dwmac4_config_l3l4_dma_chan(struct mac_device_info *hw,
+				       u32 filter_no, bool en, u32 chan)
+{
+	void __iomem *ioaddr = hw->pcsr;
+	u32 value;
+
+	value = readl(ioaddr + GMAC_L3L4_CTRL(filter_no));
+	value &= ~(GMAC_DMCHEN0 | GMAC_DMCHN0);
+	if (en)
+		value |= GMAC_DMCHEN0 |
+			 ((chan << GMAC_DMCHN0_SHIFT) & GMAC_DMCHN0);
+	writel(value, ioaddr + GMAC_L3L4_CTRL(filter_no));
+
+	if (!en)
+		return 0;
+
+	/* Steering only picks the DMA channel, unmatched packets must
+	 * still be received.
+	 */
+	value = readl(ioaddr + GMAC_PACKET_FILTER);
+	value &= ~GMAC_PACKET_FILTER_IPFE;
+	writel(value, ioaddr + GMAC_PACKET_FILTER);
+
+	/* Let queue 0 follow the filter channel. Only done while queue 0
+	 * is mapped to channel 0, which is also the default DA channel.
+	 */
+	value = readl(ioaddr + MTL_RXQ_DMA_MAP0);
+	if (!(value & MTL_RXQ_DMA_Q04MDMACH_MASK)) {
+		value |= MTL_RXQ_DMA_Q0DDMACH;
+		writel(value, ioaddr + MTL_RXQ_DMA_MAP0);
+	}
+
+	return 0;
+}
+
 #ifdef CONFIG_STMMAC_FULL
 const struct stmmac_ops dwmac4_ops = {
 	.core_init = dwmac4_core_init,
@@ -1210,6 +1249,7 @@ const struct stmmac_ops dwmac410_ops = {
 	.set_arp_offload = dwmac4_set_arp_offload,
 	.config_l3_filter = dwmac4_config_l3_filter,
 	.config_l4_filter = dwmac4_config_l4_filter,
+	.config_l3l4_dma_chan = dwmac4_config_l3l4_dma_chan,
 #ifdef CONFIG_STMMAC_FULL
 	.est_configure = dwmac5_est_configure,
 	.est_irq_status = dwmac5_est_irq_status,
@@ -1265,6 +1305,7 @@ const struct stmmac_ops dwmac510_ops = {
 	.set_arp_offload = dwmac4_set_arp_offload,
 	.config_l3_filter = dwmac4_config_l3_filter,
 	.config_l4_filter = dwmac4_config_l4_filter,
+	.config_l3l4_dma_chan = dwmac4_config_l3l4_dma_chan,
 	.est_configure = dwmac5_est_configure,
 	.est_irq_status = dwmac5_est_irq_status,
 	.fpe_configure = dwmac5_fpe_configure,
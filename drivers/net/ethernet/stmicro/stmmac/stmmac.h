@@ -12,6 +12,7 @@
 #define STMMAC_RESOURCE_NAME   "stmmaceth"
 
 #include <linux/clk.h>
+#include <linux/dim.h>
 #include <linux/hrtimer.h>
 #include <linux/if_vlan.h>
 #include <linux/stmmac.h>
@@ -90,6 +91,7 @@ struct stmmac_rx_buffer {
 	};
 	struct page *sec_page;
 	dma_addr_t sec_addr;
+	__u32 sec_offset;
 };
 
 struct stmmac_rx_queue {
@@ -98,6 +100,8 @@ struct stmmac_rx_queue {
 	struct xdp_rxq_info xdp_rxq;
 	struct xsk_buff_pool *xsk_pool;
 	struct page_pool *page_pool;
+	/* Non-zero when RX buffers are carved from shared pool pages */
+	unsigned int frag_size;
 	struct stmmac_rx_buffer *buf_pool;
 	struct stmmac_priv *priv_data;
 	struct dma_extended_desc *dma_erx;
@@ -123,6 +127,16 @@ struct stmmac_channel {
 	struct stmmac_priv *priv_data;
 	spinlock_t lock;
 	u32 index;
+
+	/* Dynamic interrupt moderation, samples taken from the napi polls */
+	struct dim rx_dim;
+	struct dim tx_dim;
+	u64 rx_dim_packets;
+	u64 rx_dim_bytes;
+	u64 tx_dim_packets;
+	u64 tx_dim_bytes;
+	u16 rx_dim_events;
+	u16 tx_dim_events;
 };
 
 struct stmmac_tc_entry {
@@ -170,6 +184,9 @@ struct stmmac_flow_entry {
 	int in_use;
 	int idx;
 	int is_l4;
+	/* Installed through ethtool ntuple to steer a flow to a queue */
+	bool is_ntuple;
+	struct ethtool_rx_flow_spec fs;
 };
 
 /* Rx Frame Steering */
@@ -267,6 +284,8 @@ struct stmmac_priv {
 	u32 systime_flags;
 	u32 adv_ts;
 	int use_riwt;
+	bool rx_dim_enabled;
+	bool tx_dim_enabled;
 	int irq_wake;
 	rwlock_t ptp_lock;
 	/* Protects auxiliary snapshot registers from concurrent access. */
@@ -339,10 +358,15 @@ int stmmac_xpcs_setup(struct mii_bus *mii);
 
 #ifdef CONFIG_STMMAC_ETHTOOL
 void stmmac_set_ethtool_ops(struct net_device *netdev);
+void stmmac_restore_ntuple_rules(struct stmmac_priv *priv);
 #else
 static inline void stmmac_set_ethtool_ops(struct net_device *netdev)
 {
 }
+
+static inline void stmmac_restore_ntuple_rules(struct stmmac_priv *priv)
+{
+}
 #endif
 
 int stmmac_init_tstamp_counter(struct stmmac_priv *priv, u32 systime_flags);
@@ -356,6 +380,7 @@ int stmmac_dvr_remove(struct device *dev);
 int stmmac_dvr_probe(struct device *device,
 		     struct plat_stmmacenet_data *plat_dat,
 		     struct stmmac_resources *res);
+u32 stmmac_usec2riwt(u32 usec, struct stmmac_priv *priv);
 void stmmac_disable_eee_mode(struct stmmac_priv *priv);
 bool stmmac_eee_init(struct stmmac_priv *priv);
 int stmmac_reinit_queues(struct net_device *dev, u32 rx_cnt, u32 tx_cnt);
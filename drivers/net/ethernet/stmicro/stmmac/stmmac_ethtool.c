@@ -824,19 +824,6 @@ static int stmmac_ethtool_op_set_eee(struct net_device *dev,
 	return 0;
 }
 
-static u32 stmmac_usec2riwt(u32 usec, struct stmmac_priv *priv)
-{
-	unsigned long clk = clk_get_rate(priv->plat->stmmac_clk);
-
-	if (!clk) {
-		clk = priv->plat->clk_ref_rate;
-		if (!clk)
-			return 0;
-	}
-
-	return (usec * (clk / 1000000)) / 256;
-}
-
 static u32 stmmac_riwt2usec(u32 riwt, struct stmmac_priv *priv)
 {
 	unsigned long clk = clk_get_rate(priv->plat->stmmac_clk);
@@ -876,6 +863,9 @@ static int __stmmac_get_coalesce(struct net_device *dev,
 		ec->tx_max_coalesced_frames = 0;
 	}
 
+	ec->use_adaptive_rx_coalesce = priv->rx_dim_enabled;
+	ec->use_adaptive_tx_coalesce = priv->tx_dim_enabled;
+
 	if (priv->use_riwt && queue < rx_cnt) {
 		ec->rx_max_coalesced_frames = priv->rx_coal_frames[queue];
 		ec->rx_coalesce_usecs = stmmac_riwt2usec(priv->rx_riwt[queue],
@@ -922,6 +912,12 @@ static int __stmmac_set_coalesce(struct net_device *dev,
 	else if (queue >= max_cnt)
 		return -EINVAL;
 
+	/* dim drives the rx watchdog, so it needs riwt as well */
+	if (ec->use_adaptive_rx_coalesce && !priv->use_riwt)
+		return -EOPNOTSUPP;
+	priv->rx_dim_enabled = ec->use_adaptive_rx_coalesce;
+	priv->tx_dim_enabled = ec->use_adaptive_tx_coalesce;
+
 	if (priv->use_riwt && (ec->rx_coalesce_usecs > 0)) {
 		rx_riwt = stmmac_usec2riwt(ec->rx_coalesce_usecs, priv);
 
@@ -988,15 +984,200 @@ static int stmmac_set_per_queue_coalesce(struct net_device *dev, u32 queue,
 	return __stmmac_set_coalesce(dev, ec, queue);
 }
 
+static int stmmac_ntuple_check(struct stmmac_priv *priv,
+			       struct ethtool_rx_flow_spec *fs)
+{
+	struct ethtool_tcpip4_spec *mask = &fs->m_u.tcp_ip4_spec;
+
+	if (fs->flow_type != TCP_V4_FLOW && fs->flow_type != UDP_V4_FLOW)
+		return -EOPNOTSUPP;
+
+	if (fs->ring_cookie == RX_CLS_FLOW_DISC ||
+	    ethtool_get_flow_spec_ring_vf(fs->ring_cookie))
+		return -EOPNOTSUPP;
+
+	if (ethtool_get_flow_spec_ring(fs->ring_cookie) >=
+	    priv->plat->rx_queues_to_use)
+		return -EINVAL;
+
+	/* L3/L4 filters only do exact address and port matches */
+	if ((mask->ip4src && mask->ip4src != htonl(~0)) ||
+	    (mask->ip4dst && mask->ip4dst != htonl(~0)) ||
+	    (mask->psrc && mask->psrc != htons(~0)) ||
+	    (mask->pdst && mask->pdst != htons(~0)) || mask->tos)
+		return -EOPNOTSUPP;
+
+	if (!mask->ip4src && !mask->ip4dst && !mask->psrc && !mask->pdst)
+		return -EINVAL;
+
+	return 0;
+}
+
+static int stmmac_ntuple_program(struct stmmac_priv *priv,
+				 struct stmmac_flow_entry *entry)
+{
+	struct ethtool_tcpip4_spec *key = &entry->fs.h_u.tcp_ip4_spec;
+	struct ethtool_tcpip4_spec *mask = &entry->fs.m_u.tcp_ip4_spec;
+	bool udp = entry->fs.flow_type == UDP_V4_FLOW;
+	u32 queue = ethtool_get_flow_spec_ring(entry->fs.ring_cookie);
+	int ret;
+
+	if (mask->ip4src) {
+		ret = stmmac_config_l3_filter(priv, priv->hw, entry->idx, true,
+					      false, true, false,
+					      ntohl(key->ip4src));
+		if (ret)
+			return ret;
+	}
+
+	if (mask->ip4dst) {
+		ret = stmmac_config_l3_filter(priv, priv->hw, entry->idx, true,
+					      false, false, false,
+					      ntohl(key->ip4dst));
+		if (ret)
+			return ret;
+	}
+
+	if (mask->psrc) {
+		ret = stmmac_config_l4_filter(priv, priv->hw, entry->idx, true,
+					      udp, true, false,
+					      ntohs(key->psrc));
+		if (ret)
+			return ret;
+	}
+
+	if (mask->pdst) {
+		ret = stmmac_config_l4_filter(priv, priv->hw, entry->idx, true,
+					      udp, false, false,
+					      ntohs(key->pdst));
+		if (ret)
+			return ret;
+	}
+
+	return stmmac_config_l3l4_dma_chan(priv, priv->hw, entry->idx, true,
+					   priv->plat->rx_queues_cfg[queue].chan);
+}
+
+static void stmmac_ntuple_clear(struct stmmac_priv *priv,
+				struct stmmac_flow_entry *entry)
+{
+	stmmac_config_l3_filter(priv, priv->hw, entry->idx, false,
+				false, false, false, 0);
+	entry->in_use = false;
+	entry->is_ntuple = false;
+}
+
+static int stmmac_add_ntuple(struct stmmac_priv *priv,
+			     struct ethtool_rx_flow_spec *fs)
+{
+	struct stmmac_flow_entry *entry;
+	int i, ret;
+
+	if (!priv->flow_entries || !priv->hw->mac->config_l3l4_dma_chan)
+		return -EOPNOTSUPP;
+
+	if (fs->location >= priv->flow_entries_max)
+		return -EINVAL;
+
+	ret = stmmac_ntuple_check(priv, fs);
+	if (ret)
+		return ret;
+
+	/* tc flower filters drop unmatched packets, steering must not */
+	for (i = 0; i < priv->flow_entries_max; i++) {
+		entry = &priv->flow_entries[i];
+		if (entry->in_use && !entry->is_ntuple)
+			return -EBUSY;
+	}
+
+	entry = &priv->flow_entries[fs->location];
+	if (entry->in_use)
+		stmmac_ntuple_clear(priv, entry);
+
+	entry->fs = *fs;
+	ret = stmmac_ntuple_program(priv, entry);
+	if (ret) {
+		stmmac_ntuple_clear(priv, entry);
+		return ret;
+	}
+
+	entry->in_use = true;
+	entry->is_ntuple = true;
+	return 0;
+}
+
+static int stmmac_del_ntuple(struct stmmac_priv *priv, u32 location)
+{
+	struct stmmac_flow_entry *entry;
+
+	if (location >= priv->flow_entries_max)
+		return -EINVAL;
+
+	entry = &priv->flow_entries[location];
+	if (!entry->in_use || !entry->is_ntuple)
+		return -ENOENT;
+
+	stmmac_ntuple_clear(priv, entry);
+	return 0;
+}
+
+void stmmac_restore_ntuple_rules(struct stmmac_priv *priv)
+{
+	int i;
+
+	for (i = 0; i < priv->flow_entries_max; i++) {
+		struct stmmac_flow_entry *entry = &priv->flow_entries[i];
+
+		if (entry->in_use && entry->is_ntuple &&
+		    stmmac_ntuple_program(priv, entry))
+			netdev_warn(priv->dev, "failed to restore rule %d\n", i);
+	}
+}
+
+static int stmmac_get_ntuple_rules(struct stmmac_priv *priv,
+				   struct ethtool_rxnfc *rxnfc, u32 *rule_locs)
+{
+	u32 cnt = 0;
+	int i;
+
+	for (i = 0; i < priv->flow_entries_max; i++) {
+		if (!priv->flow_entries[i].is_ntuple)
+			continue;
+		if (rule_locs) {
+			if (cnt == rxnfc->rule_cnt)
+				return -EMSGSIZE;
+			rule_locs[cnt] = i;
+		}
+		cnt++;
+	}
+
+	rxnfc->rule_cnt = cnt;
+	rxnfc->data = priv->flow_entries_max;
+	return 0;
+}
+
 static int stmmac_get_rxnfc(struct net_device *dev,
 			    struct ethtool_rxnfc *rxnfc, u32 *rule_locs)
 {
 	struct stmmac_priv *priv = netdev_priv(dev);
+	struct stmmac_flow_entry *entry;
 
 	switch (rxnfc->cmd) {
 	case ETHTOOL_GRXRINGS:
 		rxnfc->data = priv->plat->rx_queues_to_use;
 		break;
+	case ETHTOOL_GRXCLSRLCNT:
+		return stmmac_get_ntuple_rules(priv, rxnfc, NULL);
+	case ETHTOOL_GRXCLSRLALL:
+		return stmmac_get_ntuple_rules(priv, rxnfc, rule_locs);
+	case ETHTOOL_GRXCLSRULE:
+		if (rxnfc->fs.location >= priv->flow_entries_max)
+			return -EINVAL;
+		entry = &priv->flow_entries[rxnfc->fs.location];
+		if (!entry->is_ntuple)
+			return -ENOENT;
+		rxnfc->fs = entry->fs;
+		break;
 	default:
 		return -EOPNOTSUPP;
 	}
@@ -1004,6 +1185,21 @@ static int stmmac_get_rxnfc(struct net_device *dev,
 	return 0;
 }
 
+static int stmmac_set_rxnfc(struct net_device *dev,
+			    struct ethtool_rxnfc *rxnfc)
+{
+	struct stmmac_priv *priv = netdev_priv(dev);
+
+	switch (rxnfc->cmd) {
+	case ETHTOOL_SRXCLSRLINS:
+		return stmmac_add_ntuple(priv, &rxnfc->fs);
+	case ETHTOOL_SRXCLSRLDEL:
+		return stmmac_del_ntuple(priv, rxnfc->fs.location);
+	default:
+		return -EOPNOTSUPP;
+	}
+}
+
 static u32 stmmac_get_rxfh_key_size(struct net_device *dev)
 {
 	struct stmmac_priv *priv = netdev_priv(dev);
@@ -1156,7 +1352,8 @@ static int stmmac_set_tunable(struct net_device *dev,
 
 static const struct ethtool_ops stmmac_ethtool_ops = {
 	.supported_coalesce_params = ETHTOOL_COALESCE_USECS |
-				     ETHTOOL_COALESCE_MAX_FRAMES,
+				     ETHTOOL_COALESCE_MAX_FRAMES |
+				     ETHTOOL_COALESCE_USE_ADAPTIVE,
 	.begin = stmmac_check_if_running,
 	.get_drvinfo = stmmac_ethtool_getdrvinfo,
 	.get_msglevel = stmmac_ethtool_getmsglevel,
@@ -1178,6 +1375,7 @@ static const struct ethtool_ops stmmac_ethtool_ops = {
 	.set_eee = stmmac_ethtool_op_set_eee,
 	.get_sset_count	= stmmac_get_sset_count,
 	.get_rxnfc = stmmac_get_rxnfc,
+	.set_rxnfc = stmmac_set_rxnfc,
 	.get_rxfh_key_size = stmmac_get_rxfh_key_size,
 	.get_rxfh_indir_size = stmmac_get_rxfh_indir_size,
 	.get_rxfh = stmmac_get_rxfh,
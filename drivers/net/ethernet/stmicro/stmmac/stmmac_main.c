@@ -221,10 +221,14 @@ static void __stmmac_disable_all_queues(struct stmmac_priv *priv)
 			continue;
 		}
 
-		if (queue < rx_queues_cnt)
+		if (queue < rx_queues_cnt) {
 			napi_disable(&ch->rx_napi);
-		if (queue < tx_queues_cnt)
+			cancel_work_sync(&ch->rx_dim.work);
+		}
+		if (queue < tx_queues_cnt) {
 			napi_disable(&ch->tx_napi);
+			cancel_work_sync(&ch->tx_dim.work);
+		}
 	}
 }
 
@@ -1427,6 +1431,17 @@ static void stmmac_clear_descriptors(struct stmmac_priv *priv,
 		stmmac_clear_tx_descriptors(priv, dma_conf, queue);
 }
 
+static struct page *stmmac_rx_page_alloc(struct stmmac_rx_queue *rx_q,
+					 unsigned int *offset, gfp_t gfp)
+{
+	if (rx_q->frag_size)
+		return page_pool_alloc_frag(rx_q->page_pool, offset,
+					    rx_q->frag_size, gfp);
+
+	*offset = 0;
+	return page_pool_alloc_pages(rx_q->page_pool, gfp);
+}
+
 /**
  * stmmac_init_rx_buffers - init the RX descriptor buffer.
  * @priv: driver private structure
@@ -1446,23 +1461,26 @@ static int stmmac_init_rx_buffers(struct stmmac_priv *priv,
 	struct stmmac_rx_queue *rx_q = &dma_conf->rx_queue[queue];
 	struct stmmac_rx_buffer *buf = &rx_q->buf_pool[i];
 	gfp_t gfp = (GFP_ATOMIC | __GFP_NOWARN);
+	unsigned int offset;
 
 	if (priv->dma_cap.host_dma_width <= 32)
 		gfp |= GFP_DMA32;
 
 	if (!buf->page) {
-		buf->page = page_pool_alloc_pages(rx_q->page_pool, gfp);
+		buf->page = stmmac_rx_page_alloc(rx_q, &offset, gfp);
 		if (!buf->page)
 			return -ENOMEM;
-		buf->page_offset = stmmac_rx_offset(priv);
+		buf->page_offset = offset + stmmac_rx_offset(priv);
 	}
 
 	if (priv->sph && !buf->sec_page) {
-		buf->sec_page = page_pool_alloc_pages(rx_q->page_pool, gfp);
+		buf->sec_page = stmmac_rx_page_alloc(rx_q, &buf->sec_offset,
+						     gfp);
 		if (!buf->sec_page)
 			return -ENOMEM;
 
-		buf->sec_addr = page_pool_get_dma_addr(buf->sec_page);
+		buf->sec_addr = page_pool_get_dma_addr(buf->sec_page) +
+				buf->sec_offset;
 		stmmac_set_desc_sec_addr(priv, p, buf->sec_addr, true);
 	} else {
 		buf->sec_page = NULL;
@@ -2016,7 +2034,7 @@ static int __alloc_dma_rx_desc_resources(struct stmmac_priv *priv,
 	struct stmmac_channel *ch = &priv->channel[queue];
 	bool xdp_prog = stmmac_xdp_is_enabled(priv);
 	struct page_pool_params pp_params = { 0 };
-	unsigned int num_pages;
+	unsigned int num_pages, frag_size;
 	unsigned int napi_id;
 	int ret;
 
@@ -2033,6 +2051,18 @@ static int __alloc_dma_rx_desc_resources(struct stmmac_priv *priv,
 	pp_params.offset = stmmac_rx_offset(priv);
 	pp_params.max_len = STMMAC_MAX_RX_BUF_SIZE(num_pages);
 
+	/* Share each page between several RX buffers when they fit, each
+	 * slot keeping room for the skb_shared_info of a built skb.
+	 */
+	frag_size = SKB_DATA_ALIGN(stmmac_rx_offset(priv) +
+				   dma_conf->dma_buf_sz) +
+		    SKB_DATA_ALIGN(sizeof(struct skb_shared_info));
+	rx_q->frag_size = 0;
+	if (!xdp_prog && num_pages == 1 && frag_size <= PAGE_SIZE / 2) {
+		pp_params.flags |= PP_FLAG_PAGE_FRAG;
+		rx_q->frag_size = frag_size;
+	}
+
 	rx_q->page_pool = page_pool_create(&pp_params);
 	if (IS_ERR(rx_q->page_pool)) {
 		ret = PTR_ERR(rx_q->page_pool);
@@ -2661,6 +2691,8 @@ static int stmmac_tx_clean(struct stmmac_priv *priv, int budget, u32 queue)
 
 	netdev_tx_completed_queue(netdev_get_tx_queue(priv->dev, queue),
 				  pkts_compl, bytes_compl);
+	priv->channel[queue].tx_dim_packets += pkts_compl;
+	priv->channel[queue].tx_dim_bytes += bytes_compl;
 
 	if (unlikely(netif_tx_queue_stopped(netdev_get_tx_queue(priv->dev,
 								queue))) &&
@@ -3045,12 +3077,21 @@ static void stmmac_init_coalesce(struct stmmac_priv *priv)
 		priv->tx_coal_frames[chan] = STMMAC_TX_FRAMES;
 		priv->tx_coal_timer[chan] = STMMAC_COAL_TX_TIMER;
 
+		/* Low latency queues complete every frame */
+		if (priv->plat->tx_queues_cfg[chan].low_latency)
+			priv->tx_coal_frames[chan] = 1;
+
 		hrtimer_init(&tx_q->txtimer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
 		tx_q->txtimer.function = stmmac_tx_timer;
 	}
 
-	for (chan = 0; chan < rx_channel_count; chan++)
+	for (chan = 0; chan < rx_channel_count; chan++) {
 		priv->rx_coal_frames[chan] = STMMAC_RX_FRAMES;
+
+		/* Interrupt per frame, without the RX watchdog delay */
+		if (priv->plat->rx_queues_cfg[chan].low_latency)
+			priv->rx_coal_frames[chan] = 1;
+	}
 }
 
 static void stmmac_set_rings_length(struct stmmac_priv *priv)
@@ -3255,6 +3296,10 @@ static void stmmac_mtl_configuration(struct stmmac_priv *priv)
 	/* Receive Side Scaling */
 	if (rx_queues_count > 1)
 		stmmac_mac_config_rss(priv);
+
+	/* Flow steering rules are lost over the MAC reset */
+	if (rx_queues_count > 1)
+		stmmac_restore_ntuple_rules(priv);
 }
 
 static void stmmac_safety_feat_configuration(struct stmmac_priv *priv)
@@ -3385,7 +3430,9 @@ static int stmmac_hw_setup(struct net_device *dev, bool ptp_register)
 		u32 queue;
 
 		for (queue = 0; queue < rx_cnt; queue++) {
-			if (!priv->rx_riwt[queue])
+			if (priv->plat->rx_queues_cfg[queue].low_latency)
+				priv->rx_riwt[queue] = 0;
+			else if (!priv->rx_riwt[queue])
 				priv->rx_riwt[queue] = DEF_DMA_RIWT;
 
 			stmmac_rx_watchdog(priv, priv->ioaddr,
@@ -4149,6 +4196,8 @@ static netdev_tx_t stmmac_tso_xmit(struct sk_buff *skb, struct net_device *dev)
 				   "%s: Tx Ring full when queue awake\n",
 				   __func__);
 		}
+		/* Kick frames batched behind an earlier xmit_more */
+		stmmac_flush_tx_descriptors(priv, queue);
 		return NETDEV_TX_BUSY;
 	}
 
@@ -4328,15 +4377,18 @@ static netdev_tx_t stmmac_tso_xmit(struct sk_buff *skb, struct net_device *dev)
 		print_pkt(skb->data, skb_headlen(skb));
 	}
 
-	netdev_tx_sent_queue(netdev_get_tx_queue(dev, queue), skb->len);
-
-	stmmac_flush_tx_descriptors(priv, queue);
-	stmmac_tx_timer_arm(priv, queue);
+	/* Defer the tail pointer write while the stack has more frames */
+	if (__netdev_tx_sent_queue(netdev_get_tx_queue(dev, queue), skb->len,
+				   netdev_xmit_more())) {
+		stmmac_flush_tx_descriptors(priv, queue);
+		stmmac_tx_timer_arm(priv, queue);
+	}
 
 	return NETDEV_TX_OK;
 
 dma_map_err:
 	dev_err(priv->device, "Tx dma map failed\n");
+	stmmac_flush_tx_descriptors(priv, queue);
 	dev_kfree_skb(skb);
 	priv->dev->stats.tx_dropped++;
 	return NETDEV_TX_OK;
@@ -4389,6 +4441,8 @@ static netdev_tx_t stmmac_xmit(struct sk_buff *skb, struct net_device *dev)
 				   "%s: Tx Ring full when queue awake\n",
 				   __func__);
 		}
+		/* Kick frames batched behind an earlier xmit_more */
+		stmmac_flush_tx_descriptors(priv, queue);
 		return NETDEV_TX_BUSY;
 	}
 
@@ -4569,17 +4623,21 @@ static netdev_tx_t stmmac_xmit(struct sk_buff *skb, struct net_device *dev)
 
 	stmmac_set_tx_owner(priv, first);
 
-	netdev_tx_sent_queue(netdev_get_tx_queue(dev, queue), skb->len);
-
-	stmmac_enable_dma_transmission(priv, priv->ioaddr);
-
-	stmmac_flush_tx_descriptors(priv, queue);
-	stmmac_tx_timer_arm(priv, queue);
+	/* Defer the doorbell while the stack has more frames queued, the
+	 * last one of the batch flushes all their descriptors at once.
+	 */
+	if (__netdev_tx_sent_queue(netdev_get_tx_queue(dev, queue), skb->len,
+				   netdev_xmit_more())) {
+		stmmac_enable_dma_transmission(priv, priv->ioaddr);
+		stmmac_flush_tx_descriptors(priv, queue);
+		stmmac_tx_timer_arm(priv, queue);
+	}
 
 	return NETDEV_TX_OK;
 
 dma_map_err:
 	netdev_err(priv->dev, "Tx DMA map failed\n");
+	stmmac_flush_tx_descriptors(priv, queue);
 	dev_kfree_skb(skb);
 	priv->dev->stats.tx_dropped++;
 	return NETDEV_TX_OK;
@@ -4625,6 +4683,7 @@ static inline void stmmac_rx_refill(struct stmmac_priv *priv, u32 queue)
 
 	while (dirty-- > 0) {
 		struct stmmac_rx_buffer *buf = &rx_q->buf_pool[entry];
+		unsigned int offset;
 		struct dma_desc *p;
 		bool use_rx_wd;
 
@@ -4634,17 +4693,21 @@ static inline void stmmac_rx_refill(struct stmmac_priv *priv, u32 queue)
 			p = rx_q->dma_rx + entry;
 
 		if (!buf->page) {
-			buf->page = page_pool_alloc_pages(rx_q->page_pool, gfp);
+			buf->page = stmmac_rx_page_alloc(rx_q, &offset, gfp);
 			if (!buf->page)
 				break;
+			buf->page_offset = offset + stmmac_rx_offset(priv);
 		}
 
 		if (priv->sph && !buf->sec_page) {
-			buf->sec_page = page_pool_alloc_pages(rx_q->page_pool, gfp);
+			buf->sec_page = stmmac_rx_page_alloc(rx_q,
+							     &buf->sec_offset,
+							     gfp);
 			if (!buf->sec_page)
 				break;
 
-			buf->sec_addr = page_pool_get_dma_addr(buf->sec_page);
+			buf->sec_addr = page_pool_get_dma_addr(buf->sec_page) +
+					buf->sec_offset;
 		}
 
 		buf->addr = page_pool_get_dma_addr(buf->page) + buf->page_offset;
@@ -5127,12 +5190,15 @@ static int stmmac_rx_zc(struct stmmac_priv *priv, int limit, u32 queue)
 			continue;
 		}
 
-		/* XSK pool expects RX frame 1:1 mapped to XSK buffer */
-		if (likely(status & rx_not_ls)) {
+		/* XSK pool expects RX frame 1:1 mapped to XSK buffer, so a
+		 * frame spanning several descriptors is dropped as a whole.
+		 */
+		if (unlikely(status & rx_not_ls)) {
 			xsk_buff_free(buf->xdp);
 			buf->xdp = NULL;
 			dirty++;
-			count++;
+			error = 1;
+			priv->dev->stats.rx_length_errors++;
 			goto read_again;
 		}
 
@@ -5204,6 +5270,65 @@ static int stmmac_rx_zc(struct stmmac_priv *priv, int limit, u32 queue)
  * Description :  this the function called by the napi poll method.
  * It gets all the frames inside the ring.
  */
+/**
+ * stmmac_rx_build_skb - build the skb head for the first RX buffer
+ * @priv: driver private structure
+ * @rx_q: RX queue the buffer belongs to
+ * @buf: RX buffer holding the frame head
+ * @xdp: XDP view of the buffer after any program ran
+ * Description: frames above the copybreak get their skb built in place
+ * on the pool page, which then returns to the pool when the skb is freed.
+ * Small frames, or buffers without tailroom for skb_shared_info, are
+ * copied so the page can be recycled right away.
+ */
+static struct sk_buff *stmmac_rx_build_skb(struct stmmac_priv *priv,
+					   struct stmmac_rx_queue *rx_q,
+					   struct stmmac_rx_buffer *buf,
+					   struct xdp_buff *xdp)
+{
+	struct stmmac_channel *ch = &priv->channel[rx_q->queue_index];
+	unsigned int len = xdp->data_end - xdp->data;
+	unsigned int truesize, headroom, tailroom;
+	struct sk_buff *skb;
+	void *head;
+
+	if (len > priv->rx_copybreak) {
+		truesize = rx_q->frag_size ? :
+			   DIV_ROUND_UP(priv->dma_conf.dma_buf_sz, PAGE_SIZE) *
+			   PAGE_SIZE;
+		headroom = stmmac_rx_offset(priv);
+		head = page_address(buf->page) + buf->page_offset - headroom;
+
+		/* skb_shared_info must stay clear of what the DMA may write */
+		tailroom = SKB_DATA_ALIGN(sizeof(struct skb_shared_info));
+
+		if (headroom + priv->dma_conf.dma_buf_sz + tailroom <= truesize) {
+			skb = napi_build_skb(head, truesize);
+			if (skb) {
+				skb_reserve(skb, xdp->data - head);
+				skb_put(skb, len);
+				skb_mark_for_recycle(skb);
+				buf->page = NULL;
+				return skb;
+			}
+		}
+	}
+
+	skb = napi_alloc_skb(&ch->rx_napi, len);
+	if (!skb)
+		return NULL;
+
+	/* XDP program may adjust header */
+	skb_copy_to_linear_data(skb, xdp->data, len);
+	skb_put(skb, len);
+
+	/* Data payload copied into SKB, page ready for recycle */
+	page_pool_recycle_direct(rx_q->page_pool, buf->page);
+	buf->page = NULL;
+
+	return skb;
+}
+
 static int stmmac_rx(struct stmmac_priv *priv, int limit, u32 queue)
 {
 	struct stmmac_rx_queue *rx_q = &priv->dma_conf.rx_queue[queue];
@@ -5311,7 +5436,7 @@ static int stmmac_rx(struct stmmac_priv *priv, int limit, u32 queue)
 
 		prefetch(page_address(buf->page) + buf->page_offset);
 		if (buf->sec_page)
-			prefetch(page_address(buf->sec_page));
+			prefetch(page_address(buf->sec_page) + buf->sec_offset);
 
 		buf1_len = stmmac_rx_buf1_len(priv, p, status, len);
 		len += buf1_len;
@@ -5385,20 +5510,12 @@ static int stmmac_rx(struct stmmac_priv *priv, int limit, u32 queue)
 			/* XDP program may expand or reduce tail */
 			buf1_len = xdp.data_end - xdp.data;
 
-			skb = napi_alloc_skb(&ch->rx_napi, buf1_len);
+			skb = stmmac_rx_build_skb(priv, rx_q, buf, &xdp);
 			if (!skb) {
 				priv->dev->stats.rx_dropped++;
 				count++;
 				goto drain_data;
 			}
-
-			/* XDP program may adjust header */
-			skb_copy_to_linear_data(skb, xdp.data, buf1_len);
-			skb_put(skb, buf1_len);
-
-			/* Data payload copied into SKB, page ready for recycle */
-			page_pool_recycle_direct(rx_q->page_pool, buf->page);
-			buf->page = NULL;
 		} else if (buf1_len) {
 			dma_sync_single_for_cpu(priv->device, buf->addr,
 						buf1_len, dma_dir);
@@ -5406,8 +5523,10 @@ static int stmmac_rx(struct stmmac_priv *priv, int limit, u32 queue)
 					buf->page, buf->page_offset, buf1_len,
 					priv->dma_conf.dma_buf_sz);
 
-			/* Data payload appended into SKB */
-			page_pool_release_page(rx_q->page_pool, buf->page);
+			/* Data payload appended into SKB, page returns to
+			 * the pool once the SKB is freed.
+			 */
+			skb_mark_for_recycle(skb);
 			buf->page = NULL;
 		}
 
@@ -5415,11 +5534,11 @@ static int stmmac_rx(struct stmmac_priv *priv, int limit, u32 queue)
 			dma_sync_single_for_cpu(priv->device, buf->sec_addr,
 						buf2_len, dma_dir);
 			skb_add_rx_frag(skb, skb_shinfo(skb)->nr_frags,
-					buf->sec_page, 0, buf2_len,
-					priv->dma_conf.dma_buf_sz);
+					buf->sec_page, buf->sec_offset,
+					buf2_len, priv->dma_conf.dma_buf_sz);
 
 			/* Data payload appended into SKB */
-			page_pool_release_page(rx_q->page_pool, buf->sec_page);
+			skb_mark_for_recycle(skb);
 			buf->sec_page = NULL;
 		}
 
@@ -5449,9 +5568,12 @@ static int stmmac_rx(struct stmmac_priv *priv, int limit, u32 queue)
 
 		priv->dev->stats.rx_packets++;
 		priv->dev->stats.rx_bytes += len;
+		ch->rx_dim_bytes += len;
 		count++;
 	}
 
+	ch->rx_dim_packets += count;
+
 	if (status & rx_not_ls || skb) {
 		rx_q->state_saved = true;
 		rx_q->state.skb = skb;
@@ -5469,6 +5591,76 @@ static int stmmac_rx(struct stmmac_priv *priv, int limit, u32 queue)
 	return count;
 }
 
+u32 stmmac_usec2riwt(u32 usec, struct stmmac_priv *priv)
+{
+	unsigned long clk = clk_get_rate(priv->plat->stmmac_clk);
+
+	if (!clk) {
+		clk = priv->plat->clk_ref_rate;
+		if (!clk)
+			return 0;
+	}
+
+	return (usec * (clk / 1000000)) / 256;
+}
+
+static void stmmac_rx_dim_work(struct work_struct *work)
+{
+	struct dim *dim = container_of(work, struct dim, work);
+	struct stmmac_channel *ch =
+		container_of(dim, struct stmmac_channel, rx_dim);
+	struct stmmac_priv *priv = ch->priv_data;
+	struct dim_cq_moder moder;
+	u32 riwt;
+
+	moder = net_dim_get_rx_moderation(dim->mode, dim->profile_ix);
+	riwt = clamp_t(u32, stmmac_usec2riwt(moder.usec, priv),
+		       MIN_DMA_RIWT, MAX_DMA_RIWT);
+
+	priv->rx_riwt[ch->index] = riwt;
+	priv->rx_coal_frames[ch->index] = moder.pkts;
+	stmmac_rx_watchdog(priv, priv->ioaddr, riwt, ch->index);
+
+	dim->state = DIM_START_MEASURE;
+}
+
+static void stmmac_tx_dim_work(struct work_struct *work)
+{
+	struct dim *dim = container_of(work, struct dim, work);
+	struct stmmac_channel *ch =
+		container_of(dim, struct stmmac_channel, tx_dim);
+	struct stmmac_priv *priv = ch->priv_data;
+	struct dim_cq_moder moder;
+
+	moder = net_dim_get_tx_moderation(dim->mode, dim->profile_ix);
+
+	priv->tx_coal_timer[ch->index] = max_t(u32, moder.usec, 1);
+	priv->tx_coal_frames[ch->index] = clamp_t(u32, moder.pkts, 1,
+						  STMMAC_TX_MAX_FRAMES);
+
+	dim->state = DIM_START_MEASURE;
+}
+
+static void stmmac_rx_dim_update(struct stmmac_channel *ch)
+{
+	struct dim_sample sample = {};
+
+	ch->rx_dim_events++;
+	dim_update_sample(ch->rx_dim_events, ch->rx_dim_packets,
+			  ch->rx_dim_bytes, &sample);
+	net_dim(&ch->rx_dim, sample);
+}
+
+static void stmmac_tx_dim_update(struct stmmac_channel *ch)
+{
+	struct dim_sample sample = {};
+
+	ch->tx_dim_events++;
+	dim_update_sample(ch->tx_dim_events, ch->tx_dim_packets,
+			  ch->tx_dim_bytes, &sample);
+	net_dim(&ch->tx_dim, sample);
+}
+
 static int stmmac_napi_poll_rx(struct napi_struct *napi, int budget)
 {
 	struct stmmac_channel *ch =
@@ -5480,9 +5672,16 @@ static int stmmac_napi_poll_rx(struct napi_struct *napi, int budget)
 	priv->xstats.napi_poll++;
 
 	work_done = stmmac_rx(priv, budget, chan);
+	/* napi_complete_done() returns false while a busy poller owns the
+	 * NAPI or hard irqs are deferred, the IRQ then stays masked.
+	 */
 	if (work_done < budget && napi_complete_done(napi, work_done)) {
 		unsigned long flags;
 
+		if (priv->rx_dim_enabled &&
+		    !priv->plat->rx_queues_cfg[chan].low_latency)
+			stmmac_rx_dim_update(ch);
+
 		spin_lock_irqsave(&ch->lock, flags);
 		stmmac_enable_dma_irq(priv, priv->ioaddr, chan, 1, 0);
 		spin_unlock_irqrestore(&ch->lock, flags);
@@ -5507,6 +5706,10 @@ static int stmmac_napi_poll_tx(struct napi_struct *napi, int budget)
 	if (work_done < budget && napi_complete_done(napi, work_done)) {
 		unsigned long flags;
 
+		if (priv->tx_dim_enabled &&
+		    !priv->plat->tx_queues_cfg[chan].low_latency)
+			stmmac_tx_dim_update(ch);
+
 		spin_lock_irqsave(&ch->lock, flags);
 		stmmac_enable_dma_irq(priv, priv->ioaddr, chan, 0, 1);
 		spin_unlock_irqrestore(&ch->lock, flags);
@@ -6957,6 +7160,10 @@ static void stmmac_napi_add(struct net_device *dev)
 		ch->priv_data = priv;
 		ch->index = queue;
 		spin_lock_init(&ch->lock);
+		INIT_WORK(&ch->rx_dim.work, stmmac_rx_dim_work);
+		INIT_WORK(&ch->tx_dim.work, stmmac_tx_dim_work);
+		ch->rx_dim.mode = DIM_CQ_PERIOD_MODE_START_FROM_EQE;
+		ch->tx_dim.mode = DIM_CQ_PERIOD_MODE_START_FROM_EQE;
 
 		if (queue < priv->plat->rx_queues_to_use) {
 			netif_napi_add_weight(dev, &ch->rx_napi,
@@ -7252,6 +7459,11 @@ int stmmac_dvr_probe(struct device *device,
 		ndev->hw_features |= NETIF_F_HW_TC;
 	}
 
+	/* Flow steering through the L3/L4 filters */
+	if (priv->flow_entries && priv->hw->mac->config_l3l4_dma_chan &&
+	    priv->plat->rx_queues_to_use > 1)
+		ndev->hw_features |= NETIF_F_NTUPLE;
+
 	if ((priv->plat->tso_en) && (priv->dma_cap.tsoen)) {
 		ndev->hw_features |= NETIF_F_TSO | NETIF_F_TSO6;
 		if (priv->plat->has_gmac4)
@@ -212,6 +212,9 @@ static int stmmac_mtl_setup(struct platform_device *pdev,
 		else
 			plat->rx_queues_cfg[queue].pkt_route = 0x0;
 
+		plat->rx_queues_cfg[queue].low_latency =
+			of_property_read_bool(q_node, "snps,low-latency");
+
 		queue++;
 	}
 	if (queue != plat->rx_queues_to_use) {
@@ -276,6 +279,9 @@ static int stmmac_mtl_setup(struct platform_device *pdev,
 			plat->tx_queues_cfg[queue].use_prio = true;
 		}
 
+		plat->tx_queues_cfg[queue].low_latency =
+			of_property_read_bool(q_node, "snps,low-latency");
+
 		queue++;
 	}
 	if (queue != plat->tx_queues_to_use) {
@@ -122,15 +122,20 @@ static int stmmac_adjust_time(struct ptp_clock_info *ptp, s64 delta)
 }
 
 /**
- * stmmac_get_time
+ * stmmac_get_timex
  *
  * @ptp: pointer to ptp_clock_info structure
  * @ts: pointer to hold time/result
+ * @sts: system timestamps taken around the hardware read, may be NULL
  *
  * Description: this function will read the current time from the
- * hardware clock and store it in @ts.
+ * hardware clock and store it in @ts. The system clock is sampled right
+ * before and after the register reads, so PTP_SYS_OFFSET_EXTENDED users
+ * (phc2sys, or a camera rig lining up frame timestamps across boards)
+ * get the PHC to system time offset with the MMIO latency bounded.
  */
-static int stmmac_get_time(struct ptp_clock_info *ptp, struct timespec64 *ts)
+static int stmmac_get_timex(struct ptp_clock_info *ptp, struct timespec64 *ts,
+			    struct ptp_system_timestamp *sts)
 {
 	struct stmmac_priv *priv =
 	    container_of(ptp, struct stmmac_priv, ptp_clock_ops);
@@ -138,7 +143,9 @@ static int stmmac_get_time(struct ptp_clock_info *ptp, struct timespec64 *ts)
 	u64 ns = 0;
 
 	read_lock_irqsave(&priv->ptp_lock, flags);
+	ptp_read_system_prets(sts);
 	stmmac_get_systime(priv, priv->ptpaddr, &ns);
+	ptp_read_system_postts(sts);
 	read_unlock_irqrestore(&priv->ptp_lock, flags);
 
 	*ts = ns_to_timespec64(ns);
@@ -146,6 +153,20 @@ static int stmmac_get_time(struct ptp_clock_info *ptp, struct timespec64 *ts)
 	return 0;
 }
 
+/**
+ * stmmac_get_time
+ *
+ * @ptp: pointer to ptp_clock_info structure
+ * @ts: pointer to hold time/result
+ *
+ * Description: this function will read the current time from the
+ * hardware clock and store it in @ts.
+ */
+static int stmmac_get_time(struct ptp_clock_info *ptp, struct timespec64 *ts)
+{
+	return stmmac_get_timex(ptp, ts, NULL);
+}
+
 /**
  * stmmac_set_time
  *
@@ -275,6 +296,7 @@ static struct ptp_clock_info stmmac_ptp_clock_ops = {
 	.adjfreq = stmmac_adjust_freq,
 	.adjtime = stmmac_adjust_time,
 	.gettime64 = stmmac_get_time,
+	.gettimex64 = stmmac_get_timex,
 	.settime64 = stmmac_set_time,
 	.enable = stmmac_enable,
 	.getcrosststamp = stmmac_getcrosststamp,
@@ -591,6 +591,11 @@ static int tc_add_flow(struct stmmac_priv *priv,
 	struct flow_rule *rule = flow_cls_offload_flow_rule(cls);
 	int i, ret;
 
+	for (i = 0; i < priv->flow_entries_max; i++) {
+		if (priv->flow_entries[i].is_ntuple)
+			return -EBUSY;
+	}
+
 	if (!entry) {
 		entry = tc_find_flow(priv, cls, true);
 		if (!entry)
@@ -164,6 +164,9 @@ static int dhdsdio_resume(void *context);
 
 #define MAX_RX_DATASZ	2048	/* XXX Should be based on PKTGET limits? */
 
+/* Glom size histogram buckets: 1, 2-3, 4-7, 8-15, 16-31, 32+ pkts */
+#define DHD_GLOM_HIST_BUCKETS	6
+
 /* Maximum milliseconds to wait for firmware to come up */
 #ifdef BCMQT
 #define DHD_WAIT_READSHARED  30000
@@ -509,6 +512,9 @@ typedef struct dhd_bus {
 	fwpkg_info_t fwpkg;     /* combined fw package info structure */
 	uint		txglomframes;	/* Number of tx glom frames (superframes) */
 	uint		txglompkts;		/* Number of packets from tx glom frames */
+	uint		txglombytes;	/* Number of bytes from tx glom frames */
+	uint		rxglom_hist[DHD_GLOM_HIST_BUCKETS];	/* rx pkts per glom */
+	uint		txglom_hist[DHD_GLOM_HIST_BUCKETS];	/* tx pkts per glom */
 #ifdef PKT_STATICS
 	struct pkt_statics tx_statics;
 #endif
@@ -2941,6 +2947,16 @@ static int dhdsdio_txpkt(dhd_bus_t *bus, uint chan, void** pkts, int num_pkt, bo
 	return ret;
 }
 
+static void
+dhdsdio_glom_hist(uint *hist, uint num)
+{
+	uint bucket = 0;
+
+	while ((num >>= 1) && bucket < DHD_GLOM_HIST_BUCKETS - 1)
+		bucket++;
+	hist[bucket]++;
+}
+
 static uint
 dhdsdio_sendfromq(dhd_bus_t *bus, uint maxframes)
 {
@@ -3043,6 +3059,8 @@ dhdsdio_sendfromq(dhd_bus_t *bus, uint maxframes)
 			dhd->dstats.tx_bytes += datalen;
 			bus->txglomframes++;
 			bus->txglompkts += num_pkt;
+			bus->txglombytes += datalen;
+			dhdsdio_glom_hist(bus->txglom_hist, num_pkt);
 #ifdef PKT_STATICS
 			bus->tx_statics.glom_cnt_us[num_pkt-1] =
 				(bus->tx_statics.glom_cnt[num_pkt-1]*bus->tx_statics.glom_cnt_us[num_pkt-1]
@@ -3606,6 +3624,13 @@ dhd_dump_pct(struct bcmstrbuf *strbuf, char *desc, uint num, uint div)
 	}
 }
 
+static void
+dhdsdio_dump_glom_hist(struct bcmstrbuf *strbuf, const char *name, uint *hist)
+{
+	bcm_bprintf(strbuf, "%s pkts/glom: 1 %u, 2-3 %u, 4-7 %u, 8-15 %u, 16-31 %u, 32+ %u\n",
+	            name, hist[0], hist[1], hist[2], hist[3], hist[4], hist[5]);
+}
+
 void
 dhd_bus_dump(dhd_pub_t *dhdp, struct bcmstrbuf *strbuf)
 {
@@ -3739,6 +3764,10 @@ dhd_bus_dump(dhd_pub_t *dhdp, struct bcmstrbuf *strbuf)
 	dhd_dump_pct(strbuf, ", pkts/glom", bus->txglompkts, bus->txglomframes);
 	bcm_bprintf(strbuf, "\n");
 	bcm_bprintf(strbuf, "txglomframes %u, txglompkts %u\n", bus->txglomframes, bus->txglompkts);
+	dhd_dump_pct(strbuf, "Tx: bytes/glom", bus->txglombytes, bus->txglomframes);
+	bcm_bprintf(strbuf, "\n");
+	dhdsdio_dump_glom_hist(strbuf, "Rx", bus->rxglom_hist);
+	dhdsdio_dump_glom_hist(strbuf, "Tx", bus->txglom_hist);
 	bcm_bprintf(strbuf, "\n");
 }
 
@@ -3756,7 +3785,9 @@ dhd_bus_clearcounts(dhd_pub_t *dhdp)
 	bus->tx_sderrs = bus->fc_rcvd = bus->fc_xoff = bus->fc_xon = 0;
 	bus->rxglomfail = bus->rxglomframes = bus->rxglompkts = 0;
 	bus->f2rxhdrs = bus->f2rxdata = bus->f2txdata = bus->f1regdata = 0;
-	bus->txglomframes = bus->txglompkts = 0;
+	bus->txglomframes = bus->txglompkts = bus->txglombytes = 0;
+	bzero(bus->rxglom_hist, sizeof(bus->rxglom_hist));
+	bzero(bus->txglom_hist, sizeof(bus->txglom_hist));
 }
 
 #ifdef SDTEST
@@ -7345,6 +7376,7 @@ dhdsdio_rxglom(dhd_bus_t *bus, uint8 rxseq)
 		}
 		bus->rxglomframes++;
 		bus->rxglompkts += num;
+		dhdsdio_glom_hist(bus->rxglom_hist, num);
 	}
 	return num;
 }
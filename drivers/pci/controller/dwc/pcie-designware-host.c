@@ -118,7 +118,54 @@ static void dw_pci_setup_msi_msg(struct irq_data *d, struct msi_msg *msg)
 static int dw_pci_msi_set_affinity(struct irq_data *d,
 				   const struct cpumask *mask, bool force)
 {
-	return -EINVAL;
+	struct dw_pcie_rp *pp = irq_data_get_irq_chip_data(d);
+	unsigned int ctrl = d->hwirq / MAX_MSI_IRQS_PER_CTRL;
+	unsigned long flags;
+
+	if (!pp->msi_spread)
+		return -EINVAL;
+
+	/*
+	 * All vectors of a controller block are demultiplexed by its parent
+	 * IRQ, so steer that one. Its descriptor can't be locked while ours
+	 * is held, leave that to a work item.
+	 */
+	raw_spin_lock_irqsave(&pp->lock, flags);
+	cpumask_copy(&pp->msi_parent_mask[ctrl], mask);
+	__set_bit(ctrl, &pp->msi_parent_dirty);
+	raw_spin_unlock_irqrestore(&pp->lock, flags);
+	schedule_work(&pp->msi_affinity_work);
+
+	irq_data_update_effective_affinity(d, mask);
+
+	return IRQ_SET_MASK_OK_DONE;
+}
+
+static void dw_pcie_msi_affinity_work(struct work_struct *work)
+{
+	struct dw_pcie_rp *pp = container_of(work, struct dw_pcie_rp,
+					     msi_affinity_work);
+	cpumask_var_t mask;
+	unsigned long flags;
+	u32 ctrl;
+
+	if (!alloc_cpumask_var(&mask, GFP_KERNEL))
+		return;
+
+	for (ctrl = 0; ctrl < MAX_MSI_CTRLS; ctrl++) {
+		raw_spin_lock_irqsave(&pp->lock, flags);
+		if (!__test_and_clear_bit(ctrl, &pp->msi_parent_dirty)) {
+			raw_spin_unlock_irqrestore(&pp->lock, flags);
+			continue;
+		}
+		cpumask_copy(mask, &pp->msi_parent_mask[ctrl]);
+		raw_spin_unlock_irqrestore(&pp->lock, flags);
+
+		if (pp->msi_irq[ctrl] > 0)
+			irq_set_affinity(pp->msi_irq[ctrl], mask);
+	}
+
+	free_cpumask_var(mask);
 }
 
 static void dw_pci_bottom_mask(struct irq_data *d)
@@ -181,6 +228,44 @@ static struct irq_chip dw_pci_msi_bottom_irq_chip = {
 	.irq_unmask = dw_pci_bottom_unmask,
 };
 
+static int dw_pcie_msi_alloc_bit(struct dw_pcie_rp *pp, unsigned int nr_irqs)
+{
+	u32 ctrl, num_ctrls, start, end, used, best_used = U32_MAX;
+	int bit, i, best = -ENOSPC;
+
+	if (!pp->msi_spread || nr_irqs > 1)
+		return bitmap_find_free_region(pp->msi_irq_in_use,
+					       pp->num_vectors,
+					       order_base_2(nr_irqs));
+
+	/* Single vectors (MSI-X) go to the least loaded controller block */
+	num_ctrls = DIV_ROUND_UP(pp->num_vectors, MAX_MSI_IRQS_PER_CTRL);
+	for (ctrl = 0; ctrl < num_ctrls; ctrl++) {
+		start = ctrl * MAX_MSI_IRQS_PER_CTRL;
+		end = min_t(u32, start + MAX_MSI_IRQS_PER_CTRL,
+			    pp->num_vectors);
+
+		bit = find_next_zero_bit(pp->msi_irq_in_use, end, start);
+		if (bit >= end)
+			continue;
+
+		used = 0;
+		for (i = find_next_bit(pp->msi_irq_in_use, end, start);
+		     i < end;
+		     i = find_next_bit(pp->msi_irq_in_use, end, i + 1))
+			used++;
+		if (used < best_used) {
+			best_used = used;
+			best = bit;
+		}
+	}
+
+	if (best >= 0)
+		__set_bit(best, pp->msi_irq_in_use);
+
+	return best;
+}
+
 static int dw_pcie_irq_domain_alloc(struct irq_domain *domain,
 				    unsigned int virq, unsigned int nr_irqs,
 				    void *args)
@@ -192,8 +277,7 @@ static int dw_pcie_irq_domain_alloc(struct irq_domain *domain,
 
 	raw_spin_lock_irqsave(&pp->lock, flags);
 
-	bit = bitmap_find_free_region(pp->msi_irq_in_use, pp->num_vectors,
-				      order_base_2(nr_irqs));
+	bit = dw_pcie_msi_alloc_bit(pp, nr_irqs);
 
 	raw_spin_unlock_irqrestore(&pp->lock, flags);
 
@@ -265,6 +349,9 @@ static void dw_pcie_free_msi(struct dw_pcie_rp *pp)
 							 NULL, NULL);
 	}
 
+	if (pp->msi_spread)
+		cancel_work_sync(&pp->msi_affinity_work);
+
 	irq_domain_remove(pp->msi_domain);
 	irq_domain_remove(pp->irq_domain);
 }
@@ -355,6 +442,18 @@ static int dw_pcie_msi_host_init(struct dw_pcie_rp *pp)
 
 	dev_dbg(dev, "Using %d MSI vectors\n", pp->num_vectors);
 
+	/* Spreading needs a parent IRQ per controller block */
+	if (pp->msi_spread) {
+		for (ctrl = 0; ctrl < num_ctrls; ctrl++)
+			if (pp->msi_irq[ctrl] <= 0)
+				break;
+		if (num_ctrls < 2 || ctrl < num_ctrls)
+			pp->msi_spread = false;
+		else
+			INIT_WORK(&pp->msi_affinity_work,
+				  dw_pcie_msi_affinity_work);
+	}
+
 	pp->msi_irq_chip = &dw_pci_msi_bottom_irq_chip;
 
 	ret = dw_pcie_allocate_domains(pp);
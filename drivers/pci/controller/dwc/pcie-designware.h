@@ -232,6 +232,8 @@ struct dw_pcie_host_ops {
 struct dw_pcie_rp {
 	bool			has_msi_ctrl:1;
 	bool			cfg0_io_shared:1;
+	/* spread vectors over split "msiX" IRQs and steer those */
+	bool			msi_spread:1;
 	u64			cfg0_base;
 	void __iomem		*va_cfg0_base;
 	u32			cfg0_size;
@@ -250,6 +252,9 @@ struct dw_pcie_rp {
 	struct pci_host_bridge  *bridge;
 	raw_spinlock_t		lock;
 	DECLARE_BITMAP(msi_irq_in_use, MAX_MSI_IRQS);
+	struct cpumask		msi_parent_mask[MAX_MSI_CTRLS];
+	unsigned long		msi_parent_dirty;
+	struct work_struct	msi_affinity_work;
 };
 
 struct dw_pcie_ep_ops {
@@ -13,6 +13,8 @@ struct dma_trx_obj *pcie_dw_dmatest_register(struct device *dev, bool irq_en);
 void pcie_dw_dmatest_unregister(struct dma_trx_obj *obj);
 int pcie_dw_wired_dma_frombus_block(struct dma_trx_obj *obj, u32 chn, u64 local_paddr, u64 bus_paddr, u32 size);
 int pcie_dw_wired_dma_tobus_block(struct dma_trx_obj *obj, u32 chn, u64 bus_paddr, u64 local_paddr, u32 size);
+int pcie_dw_local_dma_frombus_block(struct dma_trx_obj *obj, u32 chn, u64 local_paddr, u64 bus_paddr, u32 size);
+int pcie_dw_local_dma_tobus_block(struct dma_trx_obj *obj, u32 chn, u64 bus_paddr, u64 local_paddr, u32 size);
 #else
 static inline struct dma_trx_obj *pcie_dw_dmatest_register(struct device *dev, bool irq_en)
 {
@@ -30,6 +32,16 @@ static inline int pcie_dw_wired_dma_tobus_block(struct dma_trx_obj *obj, u32 chn
 {
 	return -1;
 }
+
+static inline int pcie_dw_local_dma_frombus_block(struct dma_trx_obj *obj, u32 chn, u64 local_paddr, u64 bus_paddr, u32 size)
+{
+	return -1;
+}
+
+static inline int pcie_dw_local_dma_tobus_block(struct dma_trx_obj *obj, u32 chn, u64 bus_paddr, u64 local_paddr, u32 size)
+{
+	return -1;
+}
 #endif
 
 #endif
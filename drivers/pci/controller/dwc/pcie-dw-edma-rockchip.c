@@ -0,0 +1,354 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * DMA engine provider for the eDMA embedded in the Rockchip DesignWare
+ * PCIe controller.
+ *
+ * Each hardware read / write channel is exposed as one slave channel.
+ * Scatterlists are turned into a linked list in coherent memory and
+ * handed to the engine in LL mode, so a whole transfer costs a single
+ * doorbell and a single done interrupt instead of one per block.
+ *
+ * Copyright (C) 2023 Rockchip Electronics Co., Ltd.
+ */
+
+#include <linux/dma-mapping.h>
+#include <linux/dmaengine.h>
+#include <linux/err.h>
+#include <linux/scatterlist.h>
+#include <linux/slab.h>
+
+#include "pcie-designware.h"
+#include "pcie-dw-edma-rockchip.h"
+#include "../../../dma/virt-dma.h"
+
+#define PCIE_DMA_WR_ENB			0xc
+#define PCIE_DMA_WR_DOORBELL		0x10
+#define PCIE_DMA_RD_ENB			0x2c
+#define PCIE_DMA_RD_DOORBELL		0x30
+#define PCIE_DMA_WR_CH_BASE		0x200
+#define PCIE_DMA_RD_CH_BASE		0x300
+#define PCIE_DMA_CH_STRIDE		0x200
+
+#define PCIE_DMA_CH_CTRL_LO		0x0
+#define PCIE_DMA_CH_CTRL_HI		0x4
+#define PCIE_DMA_CH_LLP_LO		0x1c
+#define PCIE_DMA_CH_LLP_HI		0x20
+
+#define PCIE_DMA_DOORBELL_STOP		BIT(31)
+
+/* Elements loaded per doorbell, longer lists are fed in chunks */
+#define RK_EDMA_LL_MAX			64
+#define RK_EDMA_LL_SIZE			(RK_EDMA_LL_MAX * sizeof(struct rk_edma_lli) + \
+					 sizeof(struct rk_edma_llp))
+
+struct rk_edma_burst {
+	u64				sar;
+	u64				dar;
+	u32				sz;
+};
+
+struct rk_edma_desc {
+	struct virt_dma_desc		vd;
+	u32				nr_bursts;
+	u32				next;	/* first burst not yet loaded */
+	struct rk_edma_burst		bursts[];
+};
+
+struct rk_edma_chan {
+	struct virt_dma_chan		vc;
+	struct pcie_dw_edma		*edma;
+	enum dma_dir			dir;
+	u32				id;
+	struct dma_slave_config		cfg;
+	struct rk_edma_desc		*desc;
+	void				*ll_virt;
+	dma_addr_t			ll_phys;
+};
+
+struct pcie_dw_edma {
+	struct dw_pcie			*pci;
+	u32				dma_off;
+	u32				chan_num;
+	struct dma_device		dma;
+	struct rk_edma_chan		*chans;	/* write channels first */
+};
+
+static inline struct rk_edma_chan *to_rk_edma_chan(struct dma_chan *dchan)
+{
+	return container_of(dchan, struct rk_edma_chan, vc.chan);
+}
+
+static inline struct rk_edma_desc *to_rk_edma_desc(struct virt_dma_desc *vd)
+{
+	return container_of(vd, struct rk_edma_desc, vd);
+}
+
+static inline void rk_edma_writel(struct pcie_dw_edma *edma, u32 reg, u32 val)
+{
+	dw_pcie_writel_dbi(edma->pci, edma->dma_off + reg, val);
+}
+
+static u32 rk_edma_ch_base(struct rk_edma_chan *chan)
+{
+	return (chan->dir == DMA_TO_BUS ? PCIE_DMA_WR_CH_BASE : PCIE_DMA_RD_CH_BASE) +
+	       chan->id * PCIE_DMA_CH_STRIDE;
+}
+
+static u32 rk_edma_doorbell(struct rk_edma_chan *chan)
+{
+	return chan->dir == DMA_TO_BUS ? PCIE_DMA_WR_DOORBELL : PCIE_DMA_RD_DOORBELL;
+}
+
+/* Called with vc.lock held */
+static void rk_edma_start_chunk(struct rk_edma_chan *chan)
+{
+	struct pcie_dw_edma *edma = chan->edma;
+	struct rk_edma_desc *desc = chan->desc;
+	struct rk_edma_lli *lli = chan->ll_virt;
+	struct rk_edma_llp *llp;
+	u32 base = rk_edma_ch_base(chan);
+	u32 i, n;
+
+	n = min_t(u32, desc->nr_bursts - desc->next, RK_EDMA_LL_MAX);
+	for (i = 0; i < n; i++) {
+		struct rk_edma_burst *burst = &desc->bursts[desc->next + i];
+
+		lli[i].control = PCIE_DWC_DMA_CB;
+		lli[i].transfer_size = burst->sz;
+		lli[i].sar.reg = burst->sar;
+		lli[i].dar.reg = burst->dar;
+	}
+	lli[n - 1].control |= PCIE_DWC_DMA_LIE;
+
+	/* Link element with a stale cycle bit ends the list */
+	llp = (struct rk_edma_llp *)&lli[n];
+	llp->control = PCIE_DWC_DMA_LLP | PCIE_DWC_DMA_TCB;
+	llp->llp.reg = chan->ll_phys;
+
+	desc->next += n;
+
+	rk_edma_writel(edma, chan->dir == DMA_TO_BUS ? PCIE_DMA_WR_ENB : PCIE_DMA_RD_ENB, 0x1);
+	rk_edma_writel(edma, base + PCIE_DMA_CH_CTRL_LO, PCIE_DWC_DMA_CCS | PCIE_DWC_DMA_LLE);
+	rk_edma_writel(edma, base + PCIE_DMA_CH_CTRL_HI, 0x0);
+	rk_edma_writel(edma, base + PCIE_DMA_CH_LLP_LO, lower_32_bits(chan->ll_phys));
+	rk_edma_writel(edma, base + PCIE_DMA_CH_LLP_HI, upper_32_bits(chan->ll_phys));
+	rk_edma_writel(edma, rk_edma_doorbell(chan), chan->id);
+}
+
+/* Called with vc.lock held */
+static void rk_edma_start_desc(struct rk_edma_chan *chan)
+{
+	struct virt_dma_desc *vd = vchan_next_desc(&chan->vc);
+
+	if (!vd)
+		return;
+
+	list_del(&vd->node);
+	chan->desc = to_rk_edma_desc(vd);
+	rk_edma_start_chunk(chan);
+}
+
+void pcie_dw_edma_irq(struct pcie_dw_edma *edma, u32 chn, enum dma_dir dir, bool abort)
+{
+	struct rk_edma_chan *chan;
+	struct rk_edma_desc *desc;
+
+	if (!edma || chn >= edma->chan_num)
+		return;
+
+	chan = &edma->chans[dir == DMA_TO_BUS ? chn : edma->chan_num + chn];
+
+	spin_lock(&chan->vc.lock);
+	desc = chan->desc;
+	if (!desc)
+		goto unlock;
+
+	if (!abort && desc->next < desc->nr_bursts) {
+		rk_edma_start_chunk(chan);
+		goto unlock;
+	}
+
+	if (abort)
+		desc->vd.tx_result.result = DMA_TRANS_ABORTED;
+	chan->desc = NULL;
+	vchan_cookie_complete(&desc->vd);
+	rk_edma_start_desc(chan);
+unlock:
+	spin_unlock(&chan->vc.lock);
+}
+EXPORT_SYMBOL_GPL(pcie_dw_edma_irq);
+
+static int rk_edma_alloc_chan_resources(struct dma_chan *dchan)
+{
+	struct rk_edma_chan *chan = to_rk_edma_chan(dchan);
+
+	chan->ll_virt = dma_alloc_coherent(chan->edma->dma.dev, RK_EDMA_LL_SIZE,
+					   &chan->ll_phys, GFP_KERNEL);
+	if (!chan->ll_virt)
+		return -ENOMEM;
+
+	return 0;
+}
+
+static void rk_edma_free_chan_resources(struct dma_chan *dchan)
+{
+	struct rk_edma_chan *chan = to_rk_edma_chan(dchan);
+
+	vchan_free_chan_resources(&chan->vc);
+	dma_free_coherent(chan->edma->dma.dev, RK_EDMA_LL_SIZE, chan->ll_virt,
+			  chan->ll_phys);
+	chan->ll_virt = NULL;
+}
+
+static int rk_edma_slave_config(struct dma_chan *dchan, struct dma_slave_config *cfg)
+{
+	struct rk_edma_chan *chan = to_rk_edma_chan(dchan);
+
+	memcpy(&chan->cfg, cfg, sizeof(*cfg));
+
+	return 0;
+}
+
+static struct dma_async_tx_descriptor *
+rk_edma_prep_slave_sg(struct dma_chan *dchan, struct scatterlist *sgl,
+		      unsigned int sg_len, enum dma_transfer_direction direction,
+		      unsigned long flags, void *context)
+{
+	struct rk_edma_chan *chan = to_rk_edma_chan(dchan);
+	struct rk_edma_desc *desc;
+	struct scatterlist *sg;
+	u64 bus_addr;
+	int i;
+
+	/* Write channels push local memory to the bus, read channels pull */
+	if (!sg_len || direction != (chan->dir == DMA_TO_BUS ? DMA_MEM_TO_DEV : DMA_DEV_TO_MEM))
+		return NULL;
+
+	desc = kzalloc(struct_size(desc, bursts, sg_len), GFP_NOWAIT);
+	if (!desc)
+		return NULL;
+
+	bus_addr = direction == DMA_DEV_TO_MEM ? chan->cfg.src_addr : chan->cfg.dst_addr;
+	for_each_sg(sgl, sg, sg_len, i) {
+		struct rk_edma_burst *burst = &desc->bursts[i];
+
+		if (direction == DMA_DEV_TO_MEM) {
+			burst->sar = bus_addr;
+			burst->dar = sg_dma_address(sg);
+		} else {
+			burst->sar = sg_dma_address(sg);
+			burst->dar = bus_addr;
+		}
+		burst->sz = sg_dma_len(sg);
+		bus_addr += burst->sz;
+	}
+	desc->nr_bursts = sg_len;
+
+	return vchan_tx_prep(&chan->vc, &desc->vd, flags);
+}
+
+static enum dma_status rk_edma_tx_status(struct dma_chan *dchan, dma_cookie_t cookie,
+					 struct dma_tx_state *txstate)
+{
+	return dma_cookie_status(dchan, cookie, txstate);
+}
+
+static void rk_edma_issue_pending(struct dma_chan *dchan)
+{
+	struct rk_edma_chan *chan = to_rk_edma_chan(dchan);
+	unsigned long flags;
+
+	spin_lock_irqsave(&chan->vc.lock, flags);
+	if (vchan_issue_pending(&chan->vc) && !chan->desc)
+		rk_edma_start_desc(chan);
+	spin_unlock_irqrestore(&chan->vc.lock, flags);
+}
+
+static int rk_edma_terminate_all(struct dma_chan *dchan)
+{
+	struct rk_edma_chan *chan = to_rk_edma_chan(dchan);
+	unsigned long flags;
+	LIST_HEAD(head);
+
+	spin_lock_irqsave(&chan->vc.lock, flags);
+	if (chan->desc) {
+		rk_edma_writel(chan->edma, rk_edma_doorbell(chan),
+			       PCIE_DMA_DOORBELL_STOP | chan->id);
+		vchan_terminate_vdesc(&chan->desc->vd);
+		chan->desc = NULL;
+	}
+	vchan_get_all_descriptors(&chan->vc, &head);
+	spin_unlock_irqrestore(&chan->vc.lock, flags);
+
+	vchan_dma_desc_free_list(&chan->vc, &head);
+
+	return 0;
+}
+
+static void rk_edma_synchronize(struct dma_chan *dchan)
+{
+	vchan_synchronize(&to_rk_edma_chan(dchan)->vc);
+}
+
+static void rk_edma_desc_free(struct virt_dma_desc *vd)
+{
+	kfree(to_rk_edma_desc(vd));
+}
+
+struct pcie_dw_edma *pcie_dw_edma_register(struct dw_pcie *pci, u32 dma_off, u32 chan_num)
+{
+	struct device *dev = pci->dev;
+	struct pcie_dw_edma *edma;
+	struct dma_device *dma;
+	u32 i;
+	int ret;
+
+	edma = devm_kzalloc(dev, sizeof(*edma), GFP_KERNEL);
+	if (!edma)
+		return ERR_PTR(-ENOMEM);
+
+	edma->chans = devm_kcalloc(dev, chan_num * 2, sizeof(*edma->chans), GFP_KERNEL);
+	if (!edma->chans)
+		return ERR_PTR(-ENOMEM);
+
+	edma->pci = pci;
+	edma->dma_off = dma_off;
+	edma->chan_num = chan_num;
+
+	dma = &edma->dma;
+	INIT_LIST_HEAD(&dma->channels);
+	dma_cap_set(DMA_SLAVE, dma->cap_mask);
+	dma_cap_set(DMA_PRIVATE, dma->cap_mask);
+	dma->dev = dev;
+	dma->directions = BIT(DMA_DEV_TO_MEM) | BIT(DMA_MEM_TO_DEV);
+	dma->src_addr_widths = BIT(DMA_SLAVE_BUSWIDTH_4_BYTES);
+	dma->dst_addr_widths = BIT(DMA_SLAVE_BUSWIDTH_4_BYTES);
+	dma->residue_granularity = DMA_RESIDUE_GRANULARITY_DESCRIPTOR;
+	dma->device_alloc_chan_resources = rk_edma_alloc_chan_resources;
+	dma->device_free_chan_resources = rk_edma_free_chan_resources;
+	dma->device_config = rk_edma_slave_config;
+	dma->device_prep_slave_sg = rk_edma_prep_slave_sg;
+	dma->device_tx_status = rk_edma_tx_status;
+	dma->device_issue_pending = rk_edma_issue_pending;
+	dma->device_terminate_all = rk_edma_terminate_all;
+	dma->device_synchronize = rk_edma_synchronize;
+
+	for (i = 0; i < chan_num * 2; i++) {
+		struct rk_edma_chan *chan = &edma->chans[i];
+
+		chan->edma = edma;
+		chan->id = i % chan_num;
+		chan->dir = i < chan_num ? DMA_TO_BUS : DMA_FROM_BUS;
+		chan->vc.desc_free = rk_edma_desc_free;
+		vchan_init(&chan->vc, dma);
+	}
+
+	ret = dmaenginem_async_device_register(dma);
+	if (ret) {
+		dev_err(dev, "failed to register edma dmaengine, ret=%d\n", ret);
+		return ERR_PTR(ret);
+	}
+
+	return edma;
+}
+EXPORT_SYMBOL_GPL(pcie_dw_edma_register);
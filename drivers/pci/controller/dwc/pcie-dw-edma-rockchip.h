@@ -0,0 +1,25 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * Copyright (C) 2023 Rockchip Electronics Co., Ltd.
+ */
+#ifndef __PCIE_DW_EDMA_ROCKCHIP_H
+#define __PCIE_DW_EDMA_ROCKCHIP_H
+
+#include "../rockchip-pcie-dma.h"
+
+struct dw_pcie;
+struct pcie_dw_edma;
+
+#if IS_ENABLED(CONFIG_PCIE_DW_ROCKCHIP_EDMA)
+struct pcie_dw_edma *pcie_dw_edma_register(struct dw_pcie *pci, u32 dma_off, u32 chan_num);
+void pcie_dw_edma_irq(struct pcie_dw_edma *edma, u32 chn, enum dma_dir dir, bool abort);
+#else
+static inline struct pcie_dw_edma *pcie_dw_edma_register(struct dw_pcie *pci, u32 dma_off, u32 chan_num)
+{
+	return NULL;
+}
+
+static inline void pcie_dw_edma_irq(struct pcie_dw_edma *edma, u32 chn, enum dma_dir dir, bool abort) { }
+#endif
+
+#endif
@@ -689,6 +689,36 @@ static int rockchip_pcie_poll_irq_user(struct rockchip_pcie *rockchip, struct pc
 	return 0;
 }
 
+static int rockchip_pcie_ep_dma_xfer(struct rockchip_pcie *rockchip,
+				     struct pcie_ep_dma_block_req *dma)
+{
+	struct pcie_ep_dma_block *block = &dma->block;
+	struct device *dev = rockchip->pci.dev;
+	bool coherent = dma->flag & PCIE_EP_DMA_BLOCK_FLAG_COHERENT;
+	int ret;
+
+	if (!rockchip->dma_obj)
+		return -ENODEV;
+
+	if (dma->wr) {
+		if (coherent)
+			dma_sync_single_for_device(dev, block->local_paddr, block->size,
+						   DMA_TO_DEVICE);
+		ret = pcie_dw_local_dma_tobus_block(rockchip->dma_obj, dma->chn,
+						    block->bus_paddr, block->local_paddr,
+						    block->size);
+	} else {
+		ret = pcie_dw_local_dma_frombus_block(rockchip->dma_obj, dma->chn,
+						      block->local_paddr, block->bus_paddr,
+						      block->size);
+		if (coherent)
+			dma_sync_single_for_cpu(dev, block->local_paddr, block->size,
+						DMA_FROM_DEVICE);
+	}
+
+	return ret;
+}
+
 static irqreturn_t rockchip_pcie_sys_irq_handler(int irq, void *arg)
 {
 	struct rockchip_pcie *rockchip = arg;
@@ -1011,6 +1041,7 @@ static long pcie_ep_ioctl(struct file *file, unsigned int cmd, unsigned long arg
 	struct pcie_ep_dma_cache_cfg cfg;
 	void __user *uarg = (void __user *)arg;
 	struct pcie_ep_obj_poll_virtual_id_cfg poll_cfg;
+	struct pcie_ep_dma_block_req dma;
 	enum pcie_ep_mmap_resource mmap_res;
 	int ret, index;
 
@@ -1082,6 +1113,20 @@ static long pcie_ep_ioctl(struct file *file, unsigned int cmd, unsigned long arg
 		if (copy_to_user(uarg, &poll_cfg, sizeof(poll_cfg)))
 			return -EFAULT;
 		break;
+	case PCIE_EP_DMA_XFER_BLOCK:
+		ret = copy_from_user(&dma, uarg, sizeof(dma));
+		if (ret) {
+			dev_err(rockchip->pci.dev,
+				"failed to get dma_data copy from userspace\n");
+			return -EFAULT;
+		}
+
+		ret = rockchip_pcie_ep_dma_xfer(rockchip, &dma);
+		if (ret) {
+			dev_err(rockchip->pci.dev, "failed to transfer dma, ret=%d\n", ret);
+			return -EFAULT;
+		}
+		break;
 	default:
 		break;
 	}
@@ -25,6 +25,7 @@
 #include "pcie-designware.h"
 #include "../rockchip-pcie-dma.h"
 #include "pcie-dw-dmatest.h"
+#include "pcie-dw-edma-rockchip.h"
 
 #define RK_PCIE_DBG			0
 
@@ -110,6 +111,7 @@
 #define PORT_LOGIC_LTSSM_STATE_L2(ltssm) \
 	((ltssm & PORT_LOGIC_LTSSM_STATE_MASK) == 0x15)
 #define RK_PCIE_ENUM_HW_RETRYIES	2
+#define RK_PCIE_L1SS_POLL_MS		10
 
 #define	PORT_LOGIC_LTSSM_L2
 
@@ -125,6 +127,7 @@ struct rk_pcie {
 	u32				perst_inactive_ms;
 	struct gpio_desc		*prsnt_gpio;
 	struct dma_trx_obj		*dma_obj;
+	struct pcie_dw_edma		*edma;
 	bool				in_suspend;
 	bool				skip_scan_in_resume;
 	bool				is_signal_test;
@@ -135,6 +138,12 @@ struct rk_pcie {
 	raw_spinlock_t			intx_lock;
 	u16				aspm;
 	u32				l1ss_ctl1;
+	struct delayed_work		l1ss_work;
+	u32				l1ss_idle_ms;	/* 0: leave L1SS to the ASPM core */
+	u32				l1ss_mask;	/* substates enabled by the ASPM core */
+	bool				l1ss_gated;
+	unsigned long			l1ss_idle_since;
+	u32				l1ss_gate_cnt;
 	struct dentry			*debugfs;
 	u32				msi_vector_num;
 	struct workqueue_struct		*hot_rst_wq;
@@ -437,6 +446,14 @@ static int rk_pcie_init_dma_trx(struct rk_pcie *rk_pcie)
 	/* Enable core read interrupt */
 	dw_pcie_writel_dbi(rk_pcie->pci, PCIE_DMA_OFFSET + PCIE_DMA_RD_INT_MASK,
 			   0x0);
+
+	rk_pcie->edma = pcie_dw_edma_register(rk_pcie->pci, PCIE_DMA_OFFSET,
+					      PCIE_DMA_CHANEL_MAX_NUM);
+	if (IS_ERR(rk_pcie->edma)) {
+		dev_warn(rk_pcie->pci->dev, "failed to register edma dmaengine\n");
+		rk_pcie->edma = NULL;
+	}
+
 	return 0;
 }
 
@@ -472,6 +489,12 @@ static int rk_add_pcie_port(struct rk_pcie *rk_pcie, struct platform_device *pde
 			dev_info(dev, "max MSI vector is %d\n", rk_pcie->msi_vector_num);
 			pp->num_vectors = rk_pcie->msi_vector_num;
 		}
+		/*
+		 * With "msiX" split IRQs, spread vectors over them so that
+		 * completions can be steered away from CPU0. Vectors behind
+		 * the ITS (msi-map) are steered by the ITS itself.
+		 */
+		pp->msi_spread = true;
 	}
 
 	ret = dw_pcie_host_init(pp);
@@ -554,6 +577,9 @@ static int rk_pcie_resource_get(struct platform_device *pdev,
 				     &rk_pcie->perst_inactive_ms))
 		rk_pcie->perst_inactive_ms = 200;
 
+	device_property_read_u32(&pdev->dev, "rockchip,l1ss-idle-ms",
+				 &rk_pcie->l1ss_idle_ms);
+
 	rk_pcie->prsnt_gpio = devm_gpiod_get_optional(&pdev->dev, "prsnt", GPIOD_IN);
 	if (IS_ERR_OR_NULL(rk_pcie->prsnt_gpio))
 		dev_info(&pdev->dev, "invalid prsnt-gpios property in node\n");
@@ -721,6 +747,7 @@ static irqreturn_t rk_pcie_sys_irq_handler(int irq, void *arg)
 					PCIE_DMA_WR_INT_CLEAR, clears.asdword);
 			if (rk_pcie->dma_obj && rk_pcie->dma_obj->cb)
 				rk_pcie->dma_obj->cb(rk_pcie->dma_obj, chn, DMA_TO_BUS);
+			pcie_dw_edma_irq(rk_pcie->edma, chn, DMA_TO_BUS, false);
 		}
 
 		if (status.abortsta & BIT(chn)) {
@@ -728,6 +755,7 @@ static irqreturn_t rk_pcie_sys_irq_handler(int irq, void *arg)
 			clears.abortclr = 0x1 << chn;
 			dw_pcie_writel_dbi(rk_pcie->pci, PCIE_DMA_OFFSET +
 					PCIE_DMA_WR_INT_CLEAR, clears.asdword);
+			pcie_dw_edma_irq(rk_pcie->edma, chn, DMA_TO_BUS, true);
 		}
 	}
 
@@ -740,6 +768,7 @@ static irqreturn_t rk_pcie_sys_irq_handler(int irq, void *arg)
 					PCIE_DMA_RD_INT_CLEAR, clears.asdword);
 			if (rk_pcie->dma_obj && rk_pcie->dma_obj->cb)
 				rk_pcie->dma_obj->cb(rk_pcie->dma_obj, chn, DMA_FROM_BUS);
+			pcie_dw_edma_irq(rk_pcie->edma, chn, DMA_FROM_BUS, false);
 		}
 
 		if (status.abortsta & BIT(chn)) {
@@ -747,6 +776,7 @@ static irqreturn_t rk_pcie_sys_irq_handler(int irq, void *arg)
 			clears.abortclr = 0x1 << chn;
 			dw_pcie_writel_dbi(rk_pcie->pci, PCIE_DMA_OFFSET +
 					PCIE_DMA_RD_INT_CLEAR, clears.asdword);
+			pcie_dw_edma_irq(rk_pcie->edma, chn, DMA_FROM_BUS, true);
 		}
 	}
 
@@ -1075,6 +1105,154 @@ static int rockchip_pcie_fifo_show(struct seq_file *s, void *data)
 	return 0;
 }
 
+#ifdef CONFIG_PCIEASPM
+static struct pci_bus *rk_pcie_root_bus(struct rk_pcie *rk_pcie)
+{
+	struct dw_pcie_rp *pp = &rk_pcie->pci->pp;
+	struct pci_bus *child;
+
+	list_for_each_entry(child, &pp->bridge->bus->children, node) {
+		if (child->parent == pp->bridge->bus)
+			return child;
+	}
+
+	return NULL;
+}
+
+/*
+ * Gate L1.1/L1.2 while the link is busy. The ASPM core keeps L1 as is,
+ * we only mask the substates it enabled, upstream port last on the way
+ * out and first on the way back in.
+ */
+static void rk_pcie_l1ss_gate(struct rk_pcie *rk_pcie, bool gate)
+{
+	struct pci_bus *root_bus = rk_pcie_root_bus(rk_pcie);
+	struct pci_dev *pdev, *bridge;
+	u32 val;
+
+	if (!root_bus)
+		return;
+
+	bridge = root_bus->self;
+
+	if (!gate) {
+		val = dw_pcie_readl_dbi(rk_pcie->pci, bridge->l1ss + PCI_L1SS_CTL1);
+		dw_pcie_writel_dbi(rk_pcie->pci, bridge->l1ss + PCI_L1SS_CTL1,
+				   val | rk_pcie->l1ss_mask);
+	}
+
+	list_for_each_entry(pdev, &root_bus->devices, bus_list) {
+		if (PCI_SLOT(pdev->devfn) || !pdev->l1ss)
+			continue;
+
+		pci_read_config_dword(pdev, pdev->l1ss + PCI_L1SS_CTL1, &val);
+		if (gate)
+			val &= ~rk_pcie->l1ss_mask;
+		else
+			val |= rk_pcie->l1ss_mask;
+		pci_write_config_dword(pdev, pdev->l1ss + PCI_L1SS_CTL1, val);
+	}
+
+	if (gate) {
+		val = dw_pcie_readl_dbi(rk_pcie->pci, bridge->l1ss + PCI_L1SS_CTL1);
+		dw_pcie_writel_dbi(rk_pcie->pci, bridge->l1ss + PCI_L1SS_CTL1,
+				   val & ~rk_pcie->l1ss_mask);
+		rk_pcie->l1ss_gate_cnt++;
+	}
+
+	rk_pcie->l1ss_gated = gate;
+}
+
+static void rk_pcie_l1ss_work(struct work_struct *work)
+{
+	struct rk_pcie *rk_pcie = container_of(to_delayed_work(work),
+					       struct rk_pcie, l1ss_work);
+	u32 val = rk_pcie_readl_apb(rk_pcie, PCIE_CLIENT_CDM_RASDES_TBA_INFO_CMN);
+
+	/* Link parked in L1, L1.1 or L1.2 counts as idle */
+	if (!(val & (BIT(3) | BIT(4) | BIT(5))) || (val & BIT(6))) {
+		rk_pcie->l1ss_idle_since = jiffies;
+		if (!rk_pcie->l1ss_gated)
+			rk_pcie_l1ss_gate(rk_pcie, true);
+	} else if (rk_pcie->l1ss_gated &&
+		   time_after_eq(jiffies, rk_pcie->l1ss_idle_since +
+				 msecs_to_jiffies(rk_pcie->l1ss_idle_ms))) {
+		rk_pcie_l1ss_gate(rk_pcie, false);
+	}
+
+	schedule_delayed_work(&rk_pcie->l1ss_work,
+			      msecs_to_jiffies(RK_PCIE_L1SS_POLL_MS));
+}
+
+static void rk_pcie_l1ss_policy_start(struct rk_pcie *rk_pcie)
+{
+	struct pci_bus *root_bus;
+	u32 val;
+
+	if (!rk_pcie->l1ss_idle_ms || rk_pcie->in_suspend)
+		return;
+
+	root_bus = rk_pcie_root_bus(rk_pcie);
+	if (!root_bus || !root_bus->self->l1ss)
+		return;
+
+	val = dw_pcie_readl_dbi(rk_pcie->pci, root_bus->self->l1ss + PCI_L1SS_CTL1);
+	rk_pcie->l1ss_mask = val & (PCI_L1SS_CTL1_ASPM_L1_1 | PCI_L1SS_CTL1_ASPM_L1_2);
+	if (!rk_pcie->l1ss_mask)
+		return;
+
+	rk_pcie->l1ss_gated = false;
+	rk_pcie->l1ss_idle_since = jiffies;
+	schedule_delayed_work(&rk_pcie->l1ss_work, 0);
+}
+
+static void rk_pcie_l1ss_policy_stop(struct rk_pcie *rk_pcie)
+{
+	cancel_delayed_work_sync(&rk_pcie->l1ss_work);
+	if (rk_pcie->l1ss_gated)
+		rk_pcie_l1ss_gate(rk_pcie, false);
+}
+
+static int rk_pcie_l1ss_idle_get(void *data, u64 *val)
+{
+	struct rk_pcie *rk_pcie = data;
+
+	*val = rk_pcie->l1ss_idle_ms;
+
+	return 0;
+}
+
+static int rk_pcie_l1ss_idle_set(void *data, u64 val)
+{
+	struct rk_pcie *rk_pcie = data;
+
+	rk_pcie_l1ss_policy_stop(rk_pcie);
+	rk_pcie->l1ss_idle_ms = val;
+	rk_pcie_l1ss_policy_start(rk_pcie);
+
+	return 0;
+}
+DEFINE_DEBUGFS_ATTRIBUTE(rk_pcie_l1ss_idle_fops, rk_pcie_l1ss_idle_get,
+			 rk_pcie_l1ss_idle_set, "%llu\n");
+
+static int rockchip_pcie_l1ss_show(struct seq_file *s, void *data)
+{
+	struct rk_pcie *pcie = (struct rk_pcie *)dev_get_drvdata(s->private);
+
+	seq_printf(s, "idle threshold: %u ms\n", pcie->l1ss_idle_ms);
+	seq_printf(s, "substates: %s%s\n",
+		   pcie->l1ss_mask & PCI_L1SS_CTL1_ASPM_L1_1 ? "L1.1 " : "",
+		   pcie->l1ss_mask & PCI_L1SS_CTL1_ASPM_L1_2 ? "L1.2" : "");
+	seq_printf(s, "gated: %d, gate count: %u\n", pcie->l1ss_gated,
+		   pcie->l1ss_gate_cnt);
+
+	return 0;
+}
+#else
+static inline void rk_pcie_l1ss_policy_start(struct rk_pcie *rk_pcie) { }
+static inline void rk_pcie_l1ss_policy_stop(struct rk_pcie *rk_pcie) { }
+#endif
+
 static void rockchip_pcie_debugfs_exit(struct rk_pcie *pcie)
 {
 	debugfs_remove_recursive(pcie->debugfs);
@@ -1097,6 +1275,13 @@ static int rockchip_pcie_debugfs_init(struct rk_pcie *pcie)
 	if (!file)
 		goto remove;
 
+#ifdef CONFIG_PCIEASPM
+	debugfs_create_file_unsafe("l1ss_idle_ms", 0644, pcie->debugfs, pcie,
+				   &rk_pcie_l1ss_idle_fops);
+	debugfs_create_devm_seqfile(pcie->pci->dev, "l1ss_policy",
+				    pcie->debugfs, rockchip_pcie_l1ss_show);
+#endif
+
 	return 0;
 
 remove:
@@ -1286,6 +1471,9 @@ static int rk_pcie_really_probe(void *p)
 		goto remove_irq_domain;
 	}
 	INIT_WORK(&rk_pcie->hot_rst_work, rk_pcie_hot_rst_work);
+#ifdef CONFIG_PCIEASPM
+	INIT_DELAYED_WORK(&rk_pcie->l1ss_work, rk_pcie_l1ss_work);
+#endif
 
 	ret = rk_add_pcie_port(rk_pcie, pdev);
 
@@ -1313,6 +1501,8 @@ static int rk_pcie_really_probe(void *p)
 	/* Enable async system PM for multiports SoC */
 	device_enable_async_suspend(dev);
 
+	rk_pcie_l1ss_policy_start(rk_pcie);
+
 	if (IS_ENABLED(CONFIG_DEBUG_FS)) {
 		ret = rockchip_pcie_debugfs_init(rk_pcie);
 		if (ret < 0)
@@ -1369,24 +1559,15 @@ static int rk_pcie_probe(struct platform_device *pdev)
 #ifdef CONFIG_PCIEASPM
 static void rk_pcie_downstream_dev_to_d0(struct rk_pcie *rk_pcie, bool enable)
 {
-	struct dw_pcie_rp *pp = &rk_pcie->pci->pp;
-	struct pci_bus *child, *root_bus = NULL;
+	struct pci_bus *root_bus = rk_pcie_root_bus(rk_pcie);
 	struct pci_dev *pdev, *bridge;
 	u32 val;
 
-	list_for_each_entry(child, &pp->bridge->bus->children, node) {
-		/* Bring downstream devices to D3 if they are not already in */
-		if (child->parent == pp->bridge->bus) {
-			root_bus = child;
-			bridge = root_bus->self;
-			break;
-		}
-	}
-
 	if (!root_bus) {
 		dev_err(rk_pcie->pci->dev, "Failed to find downstream devices\n");
 		return;
 	}
+	bridge = root_bus->self;
 
 	/* Save and restore root bus ASPM */
 	if (enable) {
@@ -1599,6 +1780,8 @@ static int rockchip_dw_pcie_prepare(struct device *dev)
 {
 	struct rk_pcie *rk_pcie = dev_get_drvdata(dev);
 
+	rk_pcie_l1ss_policy_stop(rk_pcie);
+
 	dw_pcie_dbi_ro_wr_en(rk_pcie->pci);
 	rk_pcie_downstream_dev_to_d0(rk_pcie, false);
 	dw_pcie_dbi_ro_wr_dis(rk_pcie->pci);
@@ -1613,6 +1796,8 @@ static void rockchip_dw_pcie_complete(struct device *dev)
 	dw_pcie_dbi_ro_wr_en(rk_pcie->pci);
 	rk_pcie_downstream_dev_to_d0(rk_pcie, true);
 	dw_pcie_dbi_ro_wr_dis(rk_pcie->pci);
+
+	rk_pcie_l1ss_policy_start(rk_pcie);
 }
 #endif
 
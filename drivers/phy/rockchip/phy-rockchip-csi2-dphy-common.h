@@ -126,6 +126,8 @@ struct csi2_dphy_hw {
 	int num_sensors;
 	int dphy_dev_num;
 	enum csi2_dphy_lane_mode lane_mode;
+	/* link rate the lane settle is programmed for, 0 after a reset */
+	u64 rate_mbps;
 
 	int (*stream_on)(struct csi2_dphy *dphy, struct v4l2_subdev *sd);
 	int (*stream_off)(struct csi2_dphy *dphy, struct v4l2_subdev *sd);
@@ -742,82 +742,18 @@ static void csi2_dphy_config_dual_mode(struct csi2_dphy *dphy,
 	}
 }
 
-static int csi2_dphy_hw_stream_on(struct csi2_dphy *dphy,
-					struct v4l2_subdev *sd)
+/*
+ * Program the calibration and HS settle of the lanes used by @sensor for
+ * dphy->data_rate_mbps. Called with hw->mutex held.
+ */
+static void csi2_dphy_hw_config_rate(struct csi2_dphy *dphy,
+				     struct csi2_sensor *sensor)
 {
-	struct v4l2_subdev *sensor_sd = get_remote_sensor(sd);
-	struct csi2_sensor *sensor;
 	struct csi2_dphy_hw *hw = dphy->dphy_hw;
 	const struct dphy_hw_drv_data *drv_data = hw->drv_data;
 	const struct hsfreq_range *hsfreq_ranges = drv_data->hsfreq_ranges;
 	int num_hsfreq_ranges = drv_data->num_hsfreq_ranges;
 	int i, hsfreq = 0;
-	u32 val = 0, pre_val;
-	u8 lvds_width = 0;
-
-	if (!sensor_sd)
-		return -ENODEV;
-	sensor = sd_to_sensor(dphy, sensor_sd);
-	if (!sensor)
-		return -ENODEV;
-
-	mutex_lock(&hw->mutex);
-
-	/* set data lane num and enable clock lane */
-	/*
-	 * for rk356x: dphy0 is used just for full mode,
-	 *             dphy1 is used just for split mode,uses lane0_1,
-	 *             dphy2 is used just for split mode,uses lane2_3
-	 */
-	read_csi2_dphy_reg(hw, CSI2PHY_REG_CTRL_LANE_ENABLE, &pre_val);
-	if (hw->lane_mode == LANE_MODE_FULL) {
-		val |= (GENMASK(sensor->lanes - 1, 0) <<
-			CSI2_DPHY_CTRL_DATALANE_ENABLE_OFFSET_BIT) |
-			(0x1 << CSI2_DPHY_CTRL_CLKLANE_ENABLE_OFFSET_BIT);
-		if (!(sensor->mbus.bus.mipi_csi2.flags & V4L2_MBUS_CSI2_NONCONTINUOUS_CLOCK))
-			write_csi2_dphy_reg(hw, CSI2PHY_CLK_CONTINUE_MODE, 0x30);
-	} else {
-		if (!(pre_val & (0x1 << CSI2_DPHY_CTRL_CLKLANE_ENABLE_OFFSET_BIT)))
-			val |= (0x1 << CSI2_DPHY_CTRL_CLKLANE_ENABLE_OFFSET_BIT);
-
-		if (dphy->phy_index % 3 == DPHY1) {
-			val |= (GENMASK(sensor->lanes - 1, 0) <<
-				CSI2_DPHY_CTRL_DATALANE_ENABLE_OFFSET_BIT);
-			if (!(sensor->mbus.bus.mipi_csi2.flags &
-			    V4L2_MBUS_CSI2_NONCONTINUOUS_CLOCK))
-				write_csi2_dphy_reg(
-					hw, CSI2PHY_CLK_CONTINUE_MODE, 0x30);
-		}
-
-		if (dphy->phy_index % 3 == DPHY2) {
-			val |= (GENMASK(sensor->lanes - 1, 0) <<
-				CSI2_DPHY_CTRL_DATALANE_SPLIT_LANE2_3_OFFSET_BIT);
-			if (hw->drv_data->chip_id >= CHIP_ID_RK3588)
-				write_csi2_dphy_reg(hw, CSI2PHY_CLK1_LANE_ENABLE, BIT(6));
-			if (!(sensor->mbus.bus.mipi_csi2.flags &
-			    V4L2_MBUS_CSI2_NONCONTINUOUS_CLOCK))
-				write_csi2_dphy_reg(
-					hw, CSI2PHY_CLK1_CONTINUE_MODE, 0x30);
-		}
-	}
-	val |= pre_val;
-	write_csi2_dphy_reg(hw, CSI2PHY_REG_CTRL_LANE_ENABLE, val);
-
-	/* Reset dphy digital part */
-	if (hw->lane_mode == LANE_MODE_FULL) {
-		write_csi2_dphy_reg(hw, CSI2PHY_DUAL_CLK_EN, 0x1e);
-		write_csi2_dphy_reg(hw, CSI2PHY_DUAL_CLK_EN, 0x1f);
-	} else {
-		read_csi2_dphy_reg(hw, CSI2PHY_DUAL_CLK_EN, &val);
-		if (!(val & CSI2_DPHY_LANE_DUAL_MODE_EN)) {
-			write_csi2_dphy_reg(hw, CSI2PHY_DUAL_CLK_EN, 0x5e);
-			write_csi2_dphy_reg(hw, CSI2PHY_DUAL_CLK_EN, 0x5f);
-		}
-	}
-	csi2_dphy_config_dual_mode(dphy, sensor);
-
-	/* not into receive mode/wait stopstate */
-	write_grf_reg(hw, GRF_DPHY_CSI2PHY_FORCERXMODE, 0x0);
 
 	/* enable calibration */
 	if (dphy->data_rate_mbps > 1500) {
@@ -889,6 +825,84 @@ static int csi2_dphy_hw_stream_on(struct csi2_dphy *dphy,
 		}
 	}
 
+	hw->rate_mbps = dphy->data_rate_mbps;
+}
+
+static int csi2_dphy_hw_stream_on(struct csi2_dphy *dphy,
+					struct v4l2_subdev *sd)
+{
+	struct v4l2_subdev *sensor_sd = get_remote_sensor(sd);
+	struct csi2_sensor *sensor;
+	struct csi2_dphy_hw *hw = dphy->dphy_hw;
+	u32 val = 0, pre_val;
+	u8 lvds_width = 0;
+
+	if (!sensor_sd)
+		return -ENODEV;
+	sensor = sd_to_sensor(dphy, sensor_sd);
+	if (!sensor)
+		return -ENODEV;
+
+	mutex_lock(&hw->mutex);
+
+	/* set data lane num and enable clock lane */
+	/*
+	 * for rk356x: dphy0 is used just for full mode,
+	 *             dphy1 is used just for split mode,uses lane0_1,
+	 *             dphy2 is used just for split mode,uses lane2_3
+	 */
+	read_csi2_dphy_reg(hw, CSI2PHY_REG_CTRL_LANE_ENABLE, &pre_val);
+	if (hw->lane_mode == LANE_MODE_FULL) {
+		val |= (GENMASK(sensor->lanes - 1, 0) <<
+			CSI2_DPHY_CTRL_DATALANE_ENABLE_OFFSET_BIT) |
+			(0x1 << CSI2_DPHY_CTRL_CLKLANE_ENABLE_OFFSET_BIT);
+		if (!(sensor->mbus.bus.mipi_csi2.flags & V4L2_MBUS_CSI2_NONCONTINUOUS_CLOCK))
+			write_csi2_dphy_reg(hw, CSI2PHY_CLK_CONTINUE_MODE, 0x30);
+	} else {
+		if (!(pre_val & (0x1 << CSI2_DPHY_CTRL_CLKLANE_ENABLE_OFFSET_BIT)))
+			val |= (0x1 << CSI2_DPHY_CTRL_CLKLANE_ENABLE_OFFSET_BIT);
+
+		if (dphy->phy_index % 3 == DPHY1) {
+			val |= (GENMASK(sensor->lanes - 1, 0) <<
+				CSI2_DPHY_CTRL_DATALANE_ENABLE_OFFSET_BIT);
+			if (!(sensor->mbus.bus.mipi_csi2.flags &
+			    V4L2_MBUS_CSI2_NONCONTINUOUS_CLOCK))
+				write_csi2_dphy_reg(
+					hw, CSI2PHY_CLK_CONTINUE_MODE, 0x30);
+		}
+
+		if (dphy->phy_index % 3 == DPHY2) {
+			val |= (GENMASK(sensor->lanes - 1, 0) <<
+				CSI2_DPHY_CTRL_DATALANE_SPLIT_LANE2_3_OFFSET_BIT);
+			if (hw->drv_data->chip_id >= CHIP_ID_RK3588)
+				write_csi2_dphy_reg(hw, CSI2PHY_CLK1_LANE_ENABLE, BIT(6));
+			if (!(sensor->mbus.bus.mipi_csi2.flags &
+			    V4L2_MBUS_CSI2_NONCONTINUOUS_CLOCK))
+				write_csi2_dphy_reg(
+					hw, CSI2PHY_CLK1_CONTINUE_MODE, 0x30);
+		}
+	}
+	val |= pre_val;
+	write_csi2_dphy_reg(hw, CSI2PHY_REG_CTRL_LANE_ENABLE, val);
+
+	/* Reset dphy digital part */
+	if (hw->lane_mode == LANE_MODE_FULL) {
+		write_csi2_dphy_reg(hw, CSI2PHY_DUAL_CLK_EN, 0x1e);
+		write_csi2_dphy_reg(hw, CSI2PHY_DUAL_CLK_EN, 0x1f);
+	} else {
+		read_csi2_dphy_reg(hw, CSI2PHY_DUAL_CLK_EN, &val);
+		if (!(val & CSI2_DPHY_LANE_DUAL_MODE_EN)) {
+			write_csi2_dphy_reg(hw, CSI2PHY_DUAL_CLK_EN, 0x5e);
+			write_csi2_dphy_reg(hw, CSI2PHY_DUAL_CLK_EN, 0x5f);
+		}
+	}
+	csi2_dphy_config_dual_mode(dphy, sensor);
+
+	/* not into receive mode/wait stopstate */
+	write_grf_reg(hw, GRF_DPHY_CSI2PHY_FORCERXMODE, 0x0);
+
+	csi2_dphy_hw_config_rate(dphy, sensor);
+
 	if (hw->drv_data->chip_id == CHIP_ID_RV1106) {
 		if (dphy->phy_index % 3 == DPHY0 ||
 		    dphy->phy_index % 3 == DPHY1) {
@@ -935,6 +949,7 @@ static int csi2_dphy_hw_stream_off(struct csi2_dphy *dphy,
 
 	write_csi2_dphy_reg(hw, CSI2PHY_REG_CTRL_LANE_ENABLE, 0x01);
 	csi2_dphy_hw_do_reset(hw);
+	hw->rate_mbps = 0;
 
 	mutex_unlock(&hw->mutex);
 
@@ -955,6 +970,16 @@ static int csi2_dphy_hw_quick_stream_on(struct csi2_dphy *dphy,
 	if (!sensor)
 		return -ENODEV;
 
+	/*
+	 * A mode switch may move the link rate while the lanes are off,
+	 * reprogram the settle then instead of a full stream restart.
+	 */
+	if (dphy->data_rate_mbps != hw->rate_mbps) {
+		mutex_lock(&hw->mutex);
+		csi2_dphy_hw_config_rate(dphy, sensor);
+		mutex_unlock(&hw->mutex);
+	}
+
 	read_csi2_dphy_reg(hw, CSI2PHY_REG_CTRL_LANE_ENABLE, &pre_val);
 	if (hw->lane_mode == LANE_MODE_FULL) {
 		val |= (GENMASK(sensor->lanes - 1, 0) <<
@@ -773,6 +773,10 @@ static long rkcif_csi2_dphy_ioctl(struct v4l2_subdev *sd, unsigned int cmd, void
 			dphy->csi_info = *((struct rkcif_csi_info *)arg);
 		break;
 	case RKMODULE_SET_QUICK_STREAM:
+		on = *(int *)arg;
+		/* pick up a link rate change from a mode switch */
+		if (on)
+			csi2_dphy_get_sensor_data_rate(sd);
 		for (i = 0; i < dphy->csi_info.csi_num; i++) {
 			if (dphy->csi_info.dphy_vendor[i] == PHY_VENDOR_INNO) {
 				dphy->dphy_hw = (struct csi2_dphy_hw *)dphy->phy_hw[i];
@@ -782,7 +786,6 @@ static long rkcif_csi2_dphy_ioctl(struct v4l2_subdev *sd, unsigned int cmd, void
 					ret = -EINVAL;
 					break;
 				}
-				on = *(int *)arg;
 				if (on)
 					dphy->dphy_hw->quick_stream_on(dphy, sd);
 				else
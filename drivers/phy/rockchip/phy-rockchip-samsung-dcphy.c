@@ -8,6 +8,7 @@
 #include <linux/clk.h>
 #include <linux/init.h>
 #include <linux/kernel.h>
+#include <linux/ktime.h>
 #include <linux/mfd/syscon.h>
 #include <linux/module.h>
 #include <linux/of_device.h>
@@ -1395,15 +1396,21 @@ static void samsung_mipi_dcphy_pll_configure(struct samsung_mipi_dcphy *samsung)
 
 static void samsung_mipi_dcphy_pll_enable(struct samsung_mipi_dcphy *samsung)
 {
+	ktime_t start;
 	u32 sts;
 	int ret;
 
 	regmap_update_bits(samsung->regmap, PLL_CON0, PLL_EN, PLL_EN);
 
+	/* lock usually takes tens of us, don't sleep a whole ms per poll */
+	start = ktime_get();
 	ret = regmap_read_poll_timeout(samsung->regmap, PLL_STAT0,
-				       sts, (sts & PLL_LOCK), 1000, 20000);
+				       sts, (sts & PLL_LOCK), 10, 20000);
 	if (ret < 0)
 		dev_err(samsung->dev, "DC-PHY pll is not locked\n");
+	else
+		dev_dbg(samsung->dev, "DC-PHY pll locked in %lld us\n",
+			ktime_us_delta(ktime_get(), start));
 }
 
 static void samsung_mipi_dcphy_pll_disable(struct samsung_mipi_dcphy *samsung)
@@ -1856,6 +1863,11 @@ samsung_mipi_dcphy_pll_calc_rate(struct samsung_mipi_dcphy *samsung,
 	int dsm = 0;
 	int ret;
 
+	/* same request as last time, the pll settings are still valid */
+	if (samsung->pll.req_rate == rate && samsung->pll.prate == prate &&
+	    samsung->pll.c_option == samsung->c_option)
+		return;
+
 	fout = samsung_mipi_dcphy_pll_round_rate(samsung, prate, rate,
 						 &prediv, &fbdiv, &dsm,
 						 &scaler);
@@ -1884,6 +1896,10 @@ samsung_mipi_dcphy_pll_calc_rate(struct samsung_mipi_dcphy *samsung,
 			samsung->pll.mrr = mrr;
 		}
 	}
+
+	samsung->pll.req_rate = rate;
+	samsung->pll.prate = prate;
+	samsung->pll.c_option = samsung->c_option;
 }
 
 static int samsung_mipi_dcphy_configure(struct phy *phy,
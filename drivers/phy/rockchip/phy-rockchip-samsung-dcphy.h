@@ -44,6 +44,11 @@ struct samsung_mipi_dcphy {
 		bool ssc_en;
 		u8 mfr;
 		u8 mrr;
+
+		/* request the settings above were calculated for */
+		unsigned long long req_rate;
+		unsigned long prate;
+		bool c_option;
 	} pll;
 
 	int (*stream_on)(struct csi2_dphy *dphy, struct v4l2_subdev *sd);
@@ -12,6 +12,7 @@
 #include <linux/io.h>
 #include <linux/iopoll.h>
 #include <linux/kernel.h>
+#include <linux/ktime.h>
 #include <linux/module.h>
 #include <linux/nvmem-consumer.h>
 #include <linux/of.h>
@@ -726,6 +727,9 @@ struct rockchip_hdptx_phy {
 
 	bool earc_en;
 	int count;
+
+	/* last rate missing from ropll_tmds_cfg, bit_rate 0 when unset */
+	struct ropll_config ropll_calc_cfg;
 };
 
 struct lcpll_config lcpll_cfg[] = {
@@ -916,6 +920,7 @@ static void hdptx_pre_power_up(struct rockchip_hdptx_phy *hdptx)
 
 static int hdptx_post_enable_lane(struct rockchip_hdptx_phy *hdptx)
 {
+	ktime_t start;
 	u32 val = 0;
 	int i;
 
@@ -931,6 +936,7 @@ static int hdptx_post_enable_lane(struct rockchip_hdptx_phy *hdptx)
 	else
 		hdptx_write(hdptx, LNTOP_REG0207, 0x0f);
 
+	start = ktime_get();
 	for (i = 0; i < 50; i++) {
 		val = hdptx_grf_read(hdptx, GRF_HDPTX_STATUS);
 
@@ -944,13 +950,15 @@ static int hdptx_post_enable_lane(struct rockchip_hdptx_phy *hdptx)
 		return -EINVAL;
 	}
 
-	dev_err(hdptx->dev, "hdptx phy lane locked!\n");
+	dev_err(hdptx->dev, "hdptx phy lane locked in %lld us!\n",
+		ktime_us_delta(ktime_get(), start));
 
 	return 0;
 }
 
 static int hdptx_post_enable_pll(struct rockchip_hdptx_phy *hdptx)
 {
+	ktime_t start;
 	u32 val = 0;
 	int i;
 
@@ -965,6 +973,7 @@ static int hdptx_post_enable_pll(struct rockchip_hdptx_phy *hdptx)
 	udelay(10);
 	reset_control_deassert(hdptx->cmn_reset);
 
+	start = ktime_get();
 	for (i = 0; i < 20; i++) {
 		val = hdptx_grf_read(hdptx, GRF_HDPTX_STATUS);
 
@@ -978,7 +987,8 @@ static int hdptx_post_enable_pll(struct rockchip_hdptx_phy *hdptx)
 		return -EINVAL;
 	}
 
-	dev_err(hdptx->dev, "hdptx phy pll locked!\n");
+	dev_err(hdptx->dev, "hdptx phy pll locked in %lld us!\n",
+		ktime_us_delta(ktime_get(), start));
 
 	return 0;
 }
@@ -1161,12 +1171,38 @@ static bool hdptx_phy_clk_pll_calc(unsigned int data_rate,
 	return true;
 }
 
+/*
+ * Look @bit_rate up in ropll_tmds_cfg, falling back to a calculated config.
+ * The calculated one is kept, so round_rate followed by set_rate, or a
+ * replug at the same mode, only runs the search once.
+ */
+static struct ropll_config *
+hdptx_ropll_tmds_find_cfg(struct rockchip_hdptx_phy *hdptx, u32 bit_rate)
+{
+	struct ropll_config *cfg = ropll_tmds_cfg;
+	struct ropll_config rc = {0};
+
+	for (; cfg->bit_rate != ~0; cfg++)
+		if (bit_rate == cfg->bit_rate)
+			return cfg;
+
+	if (hdptx->ropll_calc_cfg.bit_rate == bit_rate)
+		return &hdptx->ropll_calc_cfg;
+
+	if (!hdptx_phy_clk_pll_calc(bit_rate, &rc))
+		return NULL;
+
+	rc.bit_rate = bit_rate;
+	hdptx->ropll_calc_cfg = rc;
+
+	return &hdptx->ropll_calc_cfg;
+}
+
 static int hdptx_ropll_cmn_config(struct rockchip_hdptx_phy *hdptx, unsigned long bit_rate)
 {
 	int bus_width = phy_get_bus_width(hdptx->phy);
 	u8 color_depth = (bus_width & COLOR_DEPTH_MASK) ? 1 : 0;
-	struct ropll_config *cfg = ropll_tmds_cfg;
-	struct ropll_config rc = {0};
+	struct ropll_config *cfg;
 
 	dev_info(hdptx->dev, "%s bus_width:%x rate:%lu\n", __func__, bus_width, bit_rate);
 	hdptx->rate = bit_rate * 100;
@@ -1174,17 +1210,10 @@ static int hdptx_ropll_cmn_config(struct rockchip_hdptx_phy *hdptx, unsigned lon
 	if (color_depth)
 		bit_rate = bit_rate * 10 / 8;
 
-	for (; cfg->bit_rate != ~0; cfg++)
-		if (bit_rate == cfg->bit_rate)
-			break;
-
-	if (cfg->bit_rate == ~0) {
-		if (hdptx_phy_clk_pll_calc(bit_rate, &rc)) {
-			cfg = &rc;
-		} else {
-			dev_err(hdptx->dev, "%s can't find pll cfg\n", __func__);
-			return -EINVAL;
-		}
+	cfg = hdptx_ropll_tmds_find_cfg(hdptx, bit_rate);
+	if (!cfg) {
+		dev_err(hdptx->dev, "%s can't find pll cfg\n", __func__);
+		return -EINVAL;
 	}
 
 	dev_dbg(hdptx->dev, "mdiv=%u, sdiv=%u\n",
@@ -2073,17 +2102,13 @@ static unsigned long hdptx_phy_clk_recalc_rate(struct clk_hw *hw,
 static long hdptx_phy_clk_round_rate(struct clk_hw *hw, unsigned long rate,
 					 unsigned long *parent_rate)
 {
-	struct ropll_config *cfg = ropll_tmds_cfg;
+	struct rockchip_hdptx_phy *hdptx = to_rockchip_hdptx_phy(hw);
 	u32 bit_rate = rate / 100;
 
 	if (rate > HDMI20_MAX_RATE)
 		return rate;
 
-	for (; cfg->bit_rate != ~0; cfg++)
-		if (bit_rate == cfg->bit_rate)
-			break;
-
-	if (cfg->bit_rate == ~0 && !hdptx_phy_clk_pll_calc(bit_rate, NULL))
+	if (!hdptx_ropll_tmds_find_cfg(hdptx, bit_rate))
 		return -EINVAL;
 
 	return rate;
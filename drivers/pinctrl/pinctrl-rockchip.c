@@ -1242,6 +1242,10 @@ static int rockchip_set_mux(struct rockchip_pin_bank *bank, int pin, int mux)
 	if (ret < 0)
 		return ret;
 
+	/* the gpio driver sets the bit again once it muxed the pin back */
+	if (mux != RK_FUNC_GPIO)
+		clear_bit(pin, &bank->gpio_muxed);
+
 	if (bank->iomux[iomux_num].type & IOMUX_GPIO_ONLY)
 		return 0;
 
@@ -315,6 +315,7 @@ struct rockchip_drv {
  * @toggle_edge_mode: bit mask to toggle (falling/rising) edge mode
  * @recalced_mask: bit mask to indicate a need to recalulate the mask
  * @route_mask: bits describing the routing pins of per bank
+ * @gpio_muxed: pins known to be muxed to gpio, lets gpio skip pinctrl
  * @deferred_output: gpio output settings to be done after gpio bank probed
  * @deferred_lock: mutex for the deferred_output shared btw gpio and pinctrl
  */
@@ -345,6 +346,7 @@ struct rockchip_pin_bank {
 	u32				toggle_edge_mode;
 	u32				recalced_mask;
 	u32				route_mask;
+	unsigned long			gpio_muxed;
 	struct list_head		deferred_pins;
 	struct mutex			deferred_lock;
 };
@@ -3704,6 +3704,9 @@ static int _regulator_do_set_voltage(struct regulator_dev *rdev,
 		delay = 0;
 	}
 
+	/* The consumer covers part of the ramp with its own work */
+	delay -= min_t(unsigned int, delay, rdev->ramp_overlap_us);
+
 	/* Insert any necessary delays */
 	_regulator_delay_helper(delay);
 
@@ -4192,6 +4195,38 @@ int regulator_set_voltage(struct regulator *regulator, int min_uV, int max_uV)
 }
 EXPORT_SYMBOL_GPL(regulator_set_voltage);
 
+/**
+ * regulator_set_voltage_overlap - set voltage without waiting for full ramp
+ * @regulator: regulator source
+ * @min_uV: Minimum required voltage in uV
+ * @max_uV: Maximum acceptable voltage in uV
+ * @overlap_us: part of the ramp delay the caller does not wait for
+ *
+ * Same as regulator_set_voltage(), but may return up to @overlap_us before
+ * the output has settled, so the caller can overlap the ramp with work that
+ * does not depend on the new voltage yet, e.g. relocking a PLL. UINT_MAX
+ * skips the wait entirely.
+ */
+int regulator_set_voltage_overlap(struct regulator *regulator, int min_uV,
+				  int max_uV, unsigned int overlap_us)
+{
+	struct regulator_dev *rdev = regulator->rdev;
+	struct ww_acquire_ctx ww_ctx;
+	int ret;
+
+	regulator_lock_dependent(rdev, &ww_ctx);
+
+	rdev->ramp_overlap_us = overlap_us;
+	ret = regulator_set_voltage_unlocked(regulator, min_uV, max_uV,
+					     PM_SUSPEND_ON);
+	rdev->ramp_overlap_us = 0;
+
+	regulator_unlock_dependent(rdev, &ww_ctx);
+
+	return ret;
+}
+EXPORT_SYMBOL_GPL(regulator_set_voltage_overlap);
+
 static inline int regulator_suspend_toggle(struct regulator_dev *rdev,
 					   suspend_state_t state, bool en)
 {
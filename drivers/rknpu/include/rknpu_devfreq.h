@@ -14,6 +14,7 @@ int rknpu_devfreq_init(struct rknpu_device *rknpu_dev);
 void rknpu_devfreq_remove(struct rknpu_device *rknpu_dev);
 int rknpu_devfreq_runtime_suspend(struct device *dev);
 int rknpu_devfreq_runtime_resume(struct device *dev);
+void rknpu_devfreq_kick(struct rknpu_device *rknpu_dev);
 #else
 static inline int rknpu_devfreq_init(struct rknpu_device *rknpu_dev)
 {
@@ -41,6 +42,10 @@ static inline int rknpu_devfreq_runtime_resume(struct device *dev)
 {
 	return -EOPNOTSUPP;
 }
+
+static inline void rknpu_devfreq_kick(struct rknpu_device *rknpu_dev)
+{
+}
 #endif /* CONFIG_PM_DEVFREQ */
 
 #endif /* __LINUX_RKNPU_DEVFREQ_H_ */
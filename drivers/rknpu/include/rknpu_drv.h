@@ -17,6 +17,7 @@
 #include <linux/version.h>
 #include <linux/hrtimer.h>
 #include <linux/miscdevice.h>
+#include <linux/sched.h>
 
 #include <soc/rockchip/rockchip_opp_select.h>
 #include <soc/rockchip/rockchip_system_monitor.h>
@@ -55,6 +56,8 @@
 
 #define RKNPU_MAX_IOMMU_DOMAIN_NUM 16
 
+struct rknpu_gem_pool;
+
 struct rknpu_irqs_data {
 	const char *name;
 	irqreturn_t (*irq_hdl)(int irq, void *ctx);
@@ -91,12 +94,27 @@ struct rknpu_timer {
 	ktime_t total_busy_time;
 };
 
+#define RKNPU_LATENCY_BUCKETS 24
+
+/* reset accounting, protected by the reset_lock of the device */
+struct rknpu_reset_stats {
+	u64 full_count;
+	u64 core_count[RKNPU_MAX_CORES];
+	u64 last_us;
+	u64 max_us;
+	u64 total_us;
+};
+
 struct rknpu_subcore_data {
-	struct list_head todo_list;
+	struct list_head todo_list[RKNPU_JOB_PRIORITY_LEVELS];
 	wait_queue_head_t job_done_wq;
 	struct rknpu_job *job;
 	int64_t task_num;
 	struct rknpu_timer timer;
+	/* under core reset, no job may be started on it */
+	bool resetting;
+	/* log2 histogram of submit to done latency in us, under irq_lock */
+	u64 latency_hist[RKNPU_LATENCY_BUCKETS];
 };
 
 /**
@@ -112,6 +130,10 @@ struct rknpu_device {
 #ifdef CONFIG_ROCKCHIP_RKNPU_DRM_GEM
 	struct device *fake_dev;
 	struct drm_device *drm_dev;
+	struct rknpu_gem_pool *gem_pool;
+	/* sealed gem objects, looked up by content */
+	struct mutex shared_lock;
+	struct list_head shared_list;
 #endif
 #ifdef CONFIG_ROCKCHIP_RKNPU_DMA_HEAP
 	struct miscdevice miscdev;
@@ -120,6 +142,12 @@ struct rknpu_device {
 	atomic_t sequence;
 	spinlock_t lock;
 	spinlock_t irq_lock;
+	spinlock_t ring_lock;
+	struct mutex ring_submit_lock;
+	wait_queue_head_t ring_wq;
+	spinlock_t session_lock;
+	struct list_head session_list;
+	uint32_t last_rw_amount[3];
 	struct mutex power_lock;
 	struct mutex reset_lock;
 	struct mutex domain_lock;
@@ -130,6 +158,8 @@ struct rknpu_device {
 	bool iommu_en;
 	struct reset_control **srsts;
 	int num_srsts;
+	int srsts_per_core;
+	struct rknpu_reset_stats reset_stats;
 	struct clk_bulk_data *clks;
 	int num_clks;
 	struct regulator *vdd;
@@ -139,11 +169,18 @@ struct rknpu_device {
 	struct thermal_cooling_device *devfreq_cooling;
 	struct devfreq *devfreq;
 	unsigned long ondemand_freq;
+	struct work_struct deadline_work;
 	struct rockchip_opp_info opp_info;
 	unsigned long current_freq;
 	unsigned long current_volt;
 	int bypass_irq_handler;
 	int bypass_soft_reset;
+	uint32_t preempt_task_number;
+	uint32_t sram_session_quota;
+	uint32_t cpu_boost_us;
+	uint32_t power_hint_mw;
+	uint32_t power_hint_ms;
+	atomic64_t job_seq;
 	bool soft_reseting;
 	struct device *genpd_dev_npu0;
 	struct device *genpd_dev_npu1;
@@ -172,12 +209,42 @@ struct rknpu_device {
 	struct iommu_domain *iommu_domains[RKNPU_MAX_IOMMU_DOMAIN_NUM];
 };
 
+/**
+ * RKNPU session, one for each opened file
+ *
+ * @rknpu_dev: RKNPU device
+ * @list: memory objects of the session, DMA heap only
+ * @node: entry in the session list of the device
+ * @refcount: dropped by file release and by each job of the session
+ * @pid: tgid of the opener
+ * @comm: command name of the opener
+ * @stats: accounting, protected by the irq_lock of the device
+ * @sram_size: SRAM currently held by memory objects of the session
+ * @job_cycles: moving average of NPU cycles per job, protected by the
+ *	irq_lock of the device
+ */
 struct rknpu_session {
 	struct rknpu_device *rknpu_dev;
 	struct list_head list;
+	struct list_head node;
+	struct kref refcount;
+	pid_t pid;
+	char comm[TASK_COMM_LEN];
+	struct rknpu_session_stats stats;
+	atomic_long_t sram_size;
+	u64 job_cycles;
 };
 
 int rknpu_power_get(struct rknpu_device *rknpu_dev);
 int rknpu_power_put(struct rknpu_device *rknpu_dev);
 
+struct rknpu_session *rknpu_session_create(struct rknpu_device *rknpu_dev);
+void rknpu_session_close(struct rknpu_session *session);
+void rknpu_session_get(struct rknpu_session *session);
+void rknpu_session_put(struct rknpu_session *session);
+
+int rknpu_mem_sync_get_ranges(const struct rknpu_mem_sync *args,
+			      unsigned long obj_size,
+			      struct rknpu_mem_sync_range *ranges);
+
 #endif /* __LINUX_RKNPU_DRV_H_ */
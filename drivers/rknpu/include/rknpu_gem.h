@@ -15,6 +15,8 @@
 #include <drm/drm_gem.h>
 #include <drm/drm_mode.h>
 
+#include <crypto/sha2.h>
+
 #if KERNEL_VERSION(4, 14, 0) > LINUX_VERSION_CODE
 #include <drm/drm_mem_util.h>
 #endif
@@ -39,6 +41,11 @@
  *	device address with IOMMU.
  * @pages: Array of backing pages.
  * @sgt: Imported sg_table.
+ * @sram_session: session charged for the SRAM part of the buffer.
+ * @sealed: read-only from now on, set under the shared_lock of the device.
+ * @sealed_size: bytes covered by @digest.
+ * @digest: SHA-256 of the content of a sealed buffer.
+ * @shared_node: entry in the shared list of the device, while sealed.
  *
  * P.S. this object would be transferred to user as kms_bo.handle so
  *	user can access the buffer through kms_bo.handle.
@@ -61,6 +68,52 @@ struct rknpu_gem_object {
 	struct sg_table *sgt;
 	struct drm_mm_node mm_node;
 	int iommu_domain_id;
+	struct rknpu_session *sram_session;
+	bool sealed;
+	u64 sealed_size;
+	u8 digest[SHA256_DIGEST_SIZE];
+	struct list_head shared_node;
+};
+
+#define RKNPU_GEM_POOL_MAX_ORDER 10
+
+/*
+ * recycled backing store of a destroyed rknpu gem object.
+ *
+ * @head: entry in the size bucket.
+ * @lru: entry in the pool lru, most recently recycled first.
+ * @size: backing store size, in bytes.
+ * @dma_attrs: attributes the backing store was allocated with.
+ * @flags: memory type of the destroyed object, without RKNPU_MEM_ZEROING.
+ * @iommu_domain_id: iommu domain the backing store is mapped in.
+ * @cookie/@dma_addr/@pages/@sgt: as in struct rknpu_gem_object.
+ */
+struct rknpu_gem_pool_buf {
+	struct list_head head;
+	struct list_head lru;
+	unsigned long size;
+	unsigned long dma_attrs;
+	unsigned int flags;
+	int iommu_domain_id;
+	void *cookie;
+	dma_addr_t dma_addr;
+	struct page **pages;
+	struct sg_table *sgt;
+};
+
+/*
+ * pool of already mapped and zeroed gem backing stores, bucketed by
+ * allocation order. Buckets hold buffers of different sizes, a lookup
+ * only reuses an exact size match.
+ */
+struct rknpu_gem_pool {
+	struct mutex lock;
+	struct list_head buckets[RKNPU_GEM_POOL_MAX_ORDER + 1];
+	struct list_head lru;
+	unsigned long max_size;
+	unsigned long cached_size;
+	unsigned long hits;
+	unsigned long misses;
 };
 
 enum rknpu_cache_type {
@@ -73,7 +126,8 @@ struct rknpu_gem_object *rknpu_gem_object_create(struct drm_device *dev,
 						 unsigned int flags,
 						 unsigned long size,
 						 unsigned long sram_size,
-						 int iommu_domain_id);
+						 int iommu_domain_id,
+						 struct rknpu_session *session);
 
 /* destroy a buffer with gem object */
 void rknpu_gem_object_destroy(struct rknpu_gem_object *rknpu_obj);
@@ -193,6 +247,18 @@ int rknpu_gem_prime_mmap(struct drm_gem_object *obj,
 int rknpu_gem_sync_ioctl(struct drm_device *dev, void *data,
 			 struct drm_file *file_priv);
 
+int rknpu_gem_seal_ioctl(struct drm_device *dev, void *data,
+			 struct drm_file *file_priv);
+int rknpu_gem_attach_ioctl(struct drm_device *dev, void *data,
+			   struct drm_file *file_priv);
+
+int rknpu_gem_pool_init(struct rknpu_device *rknpu_dev,
+			unsigned long max_size);
+void rknpu_gem_pool_destroy(struct rknpu_device *rknpu_dev);
+void rknpu_gem_pool_resize(struct rknpu_device *rknpu_dev,
+			   unsigned long max_size);
+int rknpu_gem_pool_dump(struct seq_file *m, void *data);
+
 static inline void *rknpu_gem_alloc_page(size_t nr_pages)
 {
 #if KERNEL_VERSION(4, 13, 0) <= LINUX_VERSION_CODE
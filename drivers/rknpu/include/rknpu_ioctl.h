@@ -85,6 +85,8 @@ enum e_rknpu_mem_type {
 enum e_rknpu_mem_sync_mode {
 	RKNPU_MEM_SYNC_TO_DEVICE = 1 << 0,
 	RKNPU_MEM_SYNC_FROM_DEVICE = 1 << 1,
+	/* offset/size describe an array of struct rknpu_mem_sync_range */
+	RKNPU_MEM_SYNC_RANGES = 1 << 2,
 	RKNPU_MEM_SYNC_MASK =
 		RKNPU_MEM_SYNC_TO_DEVICE | RKNPU_MEM_SYNC_FROM_DEVICE
 };
@@ -98,9 +100,17 @@ enum e_rknpu_job_mode {
 	RKNPU_JOB_PINGPONG = 1 << 2,
 	RKNPU_JOB_FENCE_IN = 1 << 3,
 	RKNPU_JOB_FENCE_OUT = 1 << 4,
+	RKNPU_JOB_DEADLINE = 1 << 5,
 	RKNPU_JOB_MASK = RKNPU_JOB_PC | RKNPU_JOB_NONBLOCK |
 			 RKNPU_JOB_PINGPONG | RKNPU_JOB_FENCE_IN |
-			 RKNPU_JOB_FENCE_OUT
+			 RKNPU_JOB_FENCE_OUT | RKNPU_JOB_DEADLINE
+};
+
+/* job priority definitions, jobs of higher priority are served first. */
+enum e_rknpu_job_priority {
+	RKNPU_JOB_PRIORITY_LOW = -1,
+	RKNPU_JOB_PRIORITY_NORMAL = 0,
+	RKNPU_JOB_PRIORITY_HIGH = 1,
 };
 
 /* action definitions */
@@ -184,14 +194,30 @@ struct rknpu_mem_destroy {
 	__u64 obj_addr;
 };
 
+/* most ranges taken by one RKNPU_MEM_SYNC_RANGES request */
+#define RKNPU_MEM_SYNC_MAX_RANGES 16
+
+/**
+ * For synchronizing part of a DMA buffer
+ *
+ * @offset: offset in bytes from start address of buffer.
+ * @size: size of memory region.
+ */
+struct rknpu_mem_sync_range {
+	__u64 offset;
+	__u64 size;
+};
+
 /**
  * For synchronizing DMA buffer
  *
  * @flags: user request for setting memory type or cache attributes.
  * @reserved: reserved for padding.
  * @obj_addr: address of RKNPU memory object.
- * @offset: offset in bytes from start address of buffer.
- * @size: size of memory region.
+ * @offset: offset in bytes from start address of buffer, or the user
+ *	address of the range array with RKNPU_MEM_SYNC_RANGES.
+ * @size: size of memory region, or the number of ranges with
+ *	RKNPU_MEM_SYNC_RANGES.
  *
  */
 struct rknpu_mem_sync {
@@ -202,6 +228,46 @@ struct rknpu_mem_sync {
 	__u64 size;
 };
 
+#define RKNPU_MEM_DIGEST_SIZE 32
+
+/**
+ * For sealing a buffer, e.g. model weights, as read-only and sharing it
+ * by content with later loaders
+ *
+ * @handle: handle of the buffer.
+ * @reserved: reserved for padding.
+ * @size: bytes from the start of the buffer covered by the digest, 0 for
+ *	the whole buffer; returns the size used.
+ * @digest: returns the SHA-256 digest of the content.
+ */
+struct rknpu_mem_seal {
+	__u32 handle;
+	__u32 reserved;
+	__u64 size;
+	__u8 digest[RKNPU_MEM_DIGEST_SIZE];
+};
+
+/**
+ * For attaching to a sealed buffer with the same content
+ *
+ * @digest: SHA-256 digest of the content.
+ * @size: size of the content, as passed to seal.
+ * @iommu_domain_id: iommu domain the buffer has to be mapped in.
+ * @handle: returns the handle of the buffer.
+ * @obj_size: returns the size of the buffer.
+ * @obj_addr: returns the address of the RKNPU memory object.
+ * @dma_addr: returns the dma address of the buffer.
+ */
+struct rknpu_mem_attach {
+	__u8 digest[RKNPU_MEM_DIGEST_SIZE];
+	__u64 size;
+	__u32 iommu_domain_id;
+	__u32 handle;
+	__u64 obj_size;
+	__u64 obj_addr;
+	__u64 dma_addr;
+};
+
 /**
  * struct rknpu_task structure for task information
  *
@@ -248,10 +314,11 @@ struct rknpu_subcore_task {
  * @task_start: task start index
  * @task_number: task number
  * @task_counter: task counter
- * @priority: submit priority
+ * @priority: submit priority, see enum e_rknpu_job_priority
  * @task_obj_addr: address of task object
  * @iommu_domain_id: iommu domain id
- * @reserved: just padding to be 64-bit aligned.
+ * @reserved: with RKNPU_JOB_DEADLINE, deadline in us after submit,
+ *	otherwise just padding to be 64-bit aligned.
  * @task_base_addr: task base address
  * @hw_elapse_time: hardware elapse time
  * @core_mask: core mask of rknpu
@@ -276,6 +343,103 @@ struct rknpu_submit {
 	struct rknpu_subcore_task subcore_task[5];
 };
 
+/**
+ * struct rknpu_ring_header structure shared by the submission ring
+ *
+ * The ring object is a kernel-mapped, non-cacheable rknpu memory object laid
+ * out as this header, followed by @sq_entries submission entries and then
+ * @cq_entries completion entries. Both entry counts must be a power of two.
+ *
+ * @sq_head: submission head, advanced by the kernel
+ * @sq_tail: submission tail, advanced by the user
+ * @sq_entries: number of submission entries
+ * @cq_head: completion head, advanced by the user
+ * @cq_tail: completion tail, advanced by the kernel
+ * @cq_entries: number of completion entries
+ * @cq_overflow: number of completions dropped because the ring was full
+ * @reserved: just padding to be 64-bit aligned.
+ *
+ */
+struct rknpu_ring_header {
+	__u32 sq_head;
+	__u32 sq_tail;
+	__u32 sq_entries;
+	__u32 cq_head;
+	__u32 cq_tail;
+	__u32 cq_entries;
+	__u32 cq_overflow;
+	__u32 reserved;
+};
+
+/**
+ * struct rknpu_ring_sqe structure for submission ring entry
+ *
+ * @user_data: user data copied to the completion entry
+ * @submit: job submit, RKNPU_JOB_NONBLOCK is implied
+ *
+ */
+struct rknpu_ring_sqe {
+	__u64 user_data;
+	struct rknpu_submit submit;
+};
+
+/**
+ * struct rknpu_ring_cqe structure for completion ring entry
+ *
+ * @user_data: user data of the submission entry
+ * @ret: job return value
+ * @fence_fd: out-fence fd of the job, -1 if none
+ * @hw_elapse_time: hardware elapse time
+ *
+ */
+struct rknpu_ring_cqe {
+	__u64 user_data;
+	__s32 ret;
+	__s32 fence_fd;
+	__s64 hw_elapse_time;
+};
+
+/**
+ * struct rknpu_ring_submit structure for submitting ring entries
+ *
+ * @ring_obj_addr: address of ring object
+ * @to_submit: max number of submission entries to consume
+ * @submitted: number of submission entries consumed
+ * @min_complete: wait until there are at least this many completions
+ * @timeout: wait timeout in ms
+ *
+ */
+struct rknpu_ring_submit {
+	__u64 ring_obj_addr;
+	__u32 to_submit;
+	__u32 submitted;
+	__u32 min_complete;
+	__u32 timeout;
+};
+
+/**
+ * struct rknpu_session_stats structure for per-session accounting
+ *
+ * @job_count: number of completed jobs
+ * @busy_time: hardware busy time of each core in ns
+ * @wait_time: accumulated time from submit to first commit in ns
+ * @dt_wr_amount: data write amount in bytes
+ * @dt_rd_amount: data read amount in bytes
+ * @wt_rd_amount: weight read amount in bytes
+ *
+ * The bandwidth amounts are sampled from the device counters at every job
+ * commit and completion and split evenly between the sessions running in
+ * that interval. They stay zero on devices without those counters.
+ */
+struct rknpu_session_stats {
+	__u64 job_count;
+	__u64 busy_time[3];
+	__u64 wait_time;
+	__u64 dt_wr_amount;
+	__u64 dt_rd_amount;
+	__u64 wt_rd_amount;
+};
+
 /**
  * struct rknpu_task structure for action (GET, SET or ACT)
  *
@@ -294,6 +458,10 @@ struct rknpu_action {
 #define RKNPU_MEM_MAP 0x03
 #define RKNPU_MEM_DESTROY 0x04
 #define RKNPU_MEM_SYNC 0x05
+#define RKNPU_RING_SUBMIT 0x06
+#define RKNPU_SESSION_STATS 0x07
+#define RKNPU_MEM_SEAL 0x08
+#define RKNPU_MEM_ATTACH 0x09
 
 #define RKNPU_IOC_MAGIC 'r'
 #define RKNPU_IOW(nr, type) _IOW(RKNPU_IOC_MAGIC, nr, type)
@@ -314,6 +482,15 @@ struct rknpu_action {
 	DRM_IOWR(DRM_COMMAND_BASE + RKNPU_MEM_DESTROY, struct rknpu_mem_destroy)
 #define DRM_IOCTL_RKNPU_MEM_SYNC                                               \
 	DRM_IOWR(DRM_COMMAND_BASE + RKNPU_MEM_SYNC, struct rknpu_mem_sync)
+#define DRM_IOCTL_RKNPU_RING_SUBMIT                                            \
+	DRM_IOWR(DRM_COMMAND_BASE + RKNPU_RING_SUBMIT, struct rknpu_ring_submit)
+#define DRM_IOCTL_RKNPU_SESSION_STATS                                          \
+	DRM_IOR(DRM_COMMAND_BASE + RKNPU_SESSION_STATS,                        \
+		struct rknpu_session_stats)
+#define DRM_IOCTL_RKNPU_MEM_SEAL                                               \
+	DRM_IOWR(DRM_COMMAND_BASE + RKNPU_MEM_SEAL, struct rknpu_mem_seal)
+#define DRM_IOCTL_RKNPU_MEM_ATTACH                                             \
+	DRM_IOWR(DRM_COMMAND_BASE + RKNPU_MEM_ATTACH, struct rknpu_mem_attach)
 
 #define IOCTL_RKNPU_ACTION RKNPU_IOWR(RKNPU_ACTION, struct rknpu_action)
 #define IOCTL_RKNPU_SUBMIT RKNPU_IOWR(RKNPU_SUBMIT, struct rknpu_submit)
@@ -323,5 +500,9 @@ struct rknpu_action {
 #define IOCTL_RKNPU_MEM_DESTROY                                                \
 	RKNPU_IOWR(RKNPU_MEM_DESTROY, struct rknpu_mem_destroy)
 #define IOCTL_RKNPU_MEM_SYNC RKNPU_IOWR(RKNPU_MEM_SYNC, struct rknpu_mem_sync)
+#define IOCTL_RKNPU_RING_SUBMIT                                                \
+	RKNPU_IOWR(RKNPU_RING_SUBMIT, struct rknpu_ring_submit)
+#define IOCTL_RKNPU_SESSION_STATS                                              \
+	RKNPU_IOR(RKNPU_SESSION_STATS, struct rknpu_session_stats)
 
 #endif
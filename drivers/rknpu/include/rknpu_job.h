@@ -21,13 +21,37 @@
 #define RKNPU_JOB_ASYNC (1 << 1)
 #define RKNPU_JOB_DETACHED (1 << 2)
 
+/* priority levels of the per-core todo lists, level 0 is served first */
+#define RKNPU_JOB_PRIORITY_LEVELS 3
+
 #define RKNPU_CORE_AUTO_MASK 0x00
 #define RKNPU_CORE0_MASK 0x01
 #define RKNPU_CORE1_MASK 0x02
 #define RKNPU_CORE2_MASK 0x04
 
+/*
+ * struct rknpu_ring_ctx - submission ring context of a job
+ *
+ * @obj: ring memory object, referenced while the job is alive
+ * @header: kernel mapping of the ring header
+ * @cqes: completion entries following the submission entries
+ * @cq_entries: number of completion entries, sampled at submit time
+ * @user_data: user data of the submission entry
+ * @attached: set once a job owns the completion of this entry
+ */
+struct rknpu_ring_ctx {
+	void *obj;
+	struct rknpu_ring_header *header;
+	struct rknpu_ring_cqe *cqes;
+	uint32_t cq_entries;
+	__u64 user_data;
+	bool attached;
+};
+
 struct rknpu_job {
 	struct rknpu_device *rknpu_dev;
+	u64 id;
+	struct rknpu_session *session;
 	struct list_head head[RKNPU_MAX_CORES];
 	struct work_struct cleanup_work;
 	bool irq_entry[RKNPU_MAX_CORES];
@@ -49,20 +73,57 @@ struct rknpu_job {
 	ktime_t hw_elapse_time;
 	atomic_t submit_count[RKNPU_MAX_CORES];
 	int iommu_domain_id;
+	int priority_level;
+	uint32_t submit_slice;
+	ktime_t deadline;
+	struct rknpu_ring_ctx ring;
+	bool ring_posted;
+	/* foreign in-fence a nonblocking job is deferred on */
+	struct dma_fence *in_fence;
+	struct dma_fence_cb in_fence_cb;
+	struct work_struct in_fence_work;
 };
 
+unsigned long rknpu_job_deadline_rate(struct rknpu_device *rknpu_dev,
+				      bool *busy);
+
 irqreturn_t rknpu_core0_irq_handler(int irq, void *data);
 irqreturn_t rknpu_core1_irq_handler(int irq, void *data);
 irqreturn_t rknpu_core2_irq_handler(int irq, void *data);
 
+int rknpu_submit_kernel(struct rknpu_device *rknpu_dev,
+			struct rknpu_submit *args);
+
 #ifdef CONFIG_ROCKCHIP_RKNPU_DRM_GEM
 int rknpu_submit_ioctl(struct drm_device *dev, void *data,
 		       struct drm_file *file_priv);
 #endif
 #ifdef CONFIG_ROCKCHIP_RKNPU_DMA_HEAP
-int rknpu_submit_ioctl(struct rknpu_device *rknpu_dev, unsigned long data);
+int rknpu_submit_ioctl(struct rknpu_device *rknpu_dev, struct file *file,
+		       unsigned long data);
+#endif
+
+#ifdef CONFIG_ROCKCHIP_RKNPU_DRM_GEM
+int rknpu_ring_submit_ioctl(struct drm_device *dev, void *data,
+			    struct drm_file *file_priv);
+#endif
+#ifdef CONFIG_ROCKCHIP_RKNPU_DMA_HEAP
+int rknpu_ring_submit_ioctl(struct rknpu_device *rknpu_dev, struct file *file,
+			    unsigned long data);
 #endif
 
+#ifdef CONFIG_ROCKCHIP_RKNPU_DRM_GEM
+int rknpu_session_stats_ioctl(struct drm_device *dev, void *data,
+			      struct drm_file *file_priv);
+#endif
+#ifdef CONFIG_ROCKCHIP_RKNPU_DMA_HEAP
+int rknpu_session_stats_ioctl(struct rknpu_device *rknpu_dev,
+			      struct file *file, unsigned long data);
+#endif
+
+void rknpu_job_account_busy(struct rknpu_job *job, int core_index,
+			    ktime_t now);
+
 int rknpu_get_hw_version(struct rknpu_device *rknpu_dev, uint32_t *version);
 
 int rknpu_get_bw_priority(struct rknpu_device *rknpu_dev, uint32_t *priority,
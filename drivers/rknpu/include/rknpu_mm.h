@@ -20,6 +20,13 @@ struct rknpu_mm {
 	unsigned int chunk_size;
 	unsigned int total_chunks;
 	unsigned int free_chunks;
+	/* placement statistics, protected by lock */
+	unsigned long request_count;
+	unsigned long full_count;
+	unsigned long partial_count;
+	unsigned long fallback_count;
+	unsigned long request_bytes;
+	unsigned long alloc_bytes;
 };
 
 struct rknpu_mm_obj {
@@ -37,6 +44,11 @@ int rknpu_mm_alloc(struct rknpu_mm *mm, unsigned int size,
 
 int rknpu_mm_free(struct rknpu_mm *mm, struct rknpu_mm_obj *mm_obj);
 
+unsigned int rknpu_mm_max_free_size(struct rknpu_mm *mm);
+
+void rknpu_mm_account(struct rknpu_mm *mm, unsigned int request_size,
+		      unsigned int alloc_size);
+
 int rknpu_mm_dump(struct seq_file *m, void *data);
 
 #endif
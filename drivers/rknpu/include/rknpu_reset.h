@@ -15,4 +15,6 @@ int rknpu_reset_get(struct rknpu_device *rknpu_dev);
 
 int rknpu_soft_reset(struct rknpu_device *rknpu_dev);
 
+int rknpu_core_reset(struct rknpu_device *rknpu_dev, uint32_t core_mask);
+
 #endif
@@ -0,0 +1,122 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/*
+ * Copyright (C) Rockchip Electronics Co.Ltd
+ */
+
+#if !defined(__LINUX_RKNPU_TRACE_H_) || defined(TRACE_HEADER_MULTI_READ)
+#define __LINUX_RKNPU_TRACE_H_
+
+#include <linux/types.h>
+#include <linux/tracepoint.h>
+
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM rknpu
+#define TRACE_INCLUDE_FILE rknpu_trace
+
+DECLARE_EVENT_CLASS(rknpu_job,
+	TP_PROTO(u64 id, u32 core_mask, u32 task_number, int ret),
+	TP_ARGS(id, core_mask, task_number, ret),
+
+	TP_STRUCT__entry(
+		__field(u64, id)
+		__field(u32, core_mask)
+		__field(u32, task_number)
+		__field(int, ret)
+	),
+
+	TP_fast_assign(
+		__entry->id = id;
+		__entry->core_mask = core_mask;
+		__entry->task_number = task_number;
+		__entry->ret = ret;
+	),
+
+	TP_printk("id=%llu core_mask=%#x task_number=%u ret=%d",
+		  __entry->id, __entry->core_mask, __entry->task_number,
+		  __entry->ret)
+);
+
+DEFINE_EVENT(rknpu_job, rknpu_job_alloc,
+	TP_PROTO(u64 id, u32 core_mask, u32 task_number, int ret),
+	TP_ARGS(id, core_mask, task_number, ret)
+);
+
+DEFINE_EVENT(rknpu_job, rknpu_job_cleanup,
+	TP_PROTO(u64 id, u32 core_mask, u32 task_number, int ret),
+	TP_ARGS(id, core_mask, task_number, ret)
+);
+
+TRACE_EVENT(rknpu_job_commit,
+	TP_PROTO(u64 id, int core, u32 task_start, u32 task_number),
+	TP_ARGS(id, core, task_start, task_number),
+
+	TP_STRUCT__entry(
+		__field(u64, id)
+		__field(int, core)
+		__field(u32, task_start)
+		__field(u32, task_number)
+	),
+
+	TP_fast_assign(
+		__entry->id = id;
+		__entry->core = core;
+		__entry->task_start = task_start;
+		__entry->task_number = task_number;
+	),
+
+	TP_printk("id=%llu core=%d task_start=%u task_number=%u",
+		  __entry->id, __entry->core, __entry->task_start,
+		  __entry->task_number)
+);
+
+TRACE_EVENT(rknpu_job_irq,
+	TP_PROTO(u64 id, int core, u32 status),
+	TP_ARGS(id, core, status),
+
+	TP_STRUCT__entry(
+		__field(u64, id)
+		__field(int, core)
+		__field(u32, status)
+	),
+
+	TP_fast_assign(
+		__entry->id = id;
+		__entry->core = core;
+		__entry->status = status;
+	),
+
+	TP_printk("id=%llu core=%d status=%#x", __entry->id, __entry->core,
+		  __entry->status)
+);
+
+TRACE_EVENT(rknpu_job_done,
+	TP_PROTO(u64 id, int core, int ret, s64 wait_ns, s64 hw_ns),
+	TP_ARGS(id, core, ret, wait_ns, hw_ns),
+
+	TP_STRUCT__entry(
+		__field(u64, id)
+		__field(int, core)
+		__field(int, ret)
+		__field(s64, wait_ns)
+		__field(s64, hw_ns)
+	),
+
+	TP_fast_assign(
+		__entry->id = id;
+		__entry->core = core;
+		__entry->ret = ret;
+		__entry->wait_ns = wait_ns;
+		__entry->hw_ns = hw_ns;
+	),
+
+	TP_printk("id=%llu core=%d ret=%d wait_ns=%lld hw_ns=%lld",
+		  __entry->id, __entry->core, __entry->ret, __entry->wait_ns,
+		  __entry->hw_ns)
+);
+
+#endif /* __LINUX_RKNPU_TRACE_H_ */
+
+/* This part must be outside protection */
+#undef TRACE_INCLUDE_PATH
+#define TRACE_INCLUDE_PATH .
+#include <trace/define_trace.h>
@@ -11,6 +11,7 @@
 #include <linux/proc_fs.h>
 #include <linux/devfreq.h>
 #include <linux/clk.h>
+#include <linux/sort.h>
 #include <asm/div64.h>
 
 #ifndef FPGA_PLATFORM
@@ -24,6 +25,10 @@
 #include "rknpu_reset.h"
 #include "rknpu_debugger.h"
 
+#ifdef CONFIG_ROCKCHIP_RKNPU_DRM_GEM
+#include "rknpu_gem.h"
+#endif
+
 #define RKNPU_DEBUGGER_ROOT_NAME "rknpu"
 
 #if defined(CONFIG_ROCKCHIP_RKNPU_DEBUG_FS) ||                                 \
@@ -75,6 +80,96 @@ static int rknpu_load_show(struct seq_file *m, void *data)
 	return 0;
 }
 
+static int rknpu_session_show(struct seq_file *m, void *data)
+{
+	struct rknpu_debugger_node *node = m->private;
+	struct rknpu_debugger *debugger = node->debugger;
+	struct rknpu_device *rknpu_dev =
+		container_of(debugger, struct rknpu_device, debugger);
+	struct rknpu_session *session = NULL;
+	struct rknpu_session_stats stats;
+	unsigned long flags;
+	int i;
+
+	seq_puts(m, "pid\tcomm\tjobs\twait(us)");
+	for (i = 0; i < rknpu_dev->config->num_irqs; i++)
+		seq_printf(m, "\tcore%d(us)", i);
+	seq_puts(m, "\tdt_wr\tdt_rd\twt_rd\tsram\n");
+
+	spin_lock(&rknpu_dev->session_lock);
+	list_for_each_entry(session, &rknpu_dev->session_list, node) {
+		spin_lock_irqsave(&rknpu_dev->irq_lock, flags);
+		stats = session->stats;
+		spin_unlock_irqrestore(&rknpu_dev->irq_lock, flags);
+
+		seq_printf(m, "%d\t%s\t%llu\t%llu", session->pid,
+			   session->comm, stats.job_count,
+			   div_u64(stats.wait_time, NSEC_PER_USEC));
+		for (i = 0; i < rknpu_dev->config->num_irqs; i++)
+			seq_printf(m, "\t%llu",
+				   div_u64(stats.busy_time[i], NSEC_PER_USEC));
+		seq_printf(m, "\t%llu\t%llu\t%llu\t%ld\n", stats.dt_wr_amount,
+			   stats.dt_rd_amount, stats.wt_rd_amount,
+			   atomic_long_read(&session->sram_size));
+	}
+	spin_unlock(&rknpu_dev->session_lock);
+
+	return 0;
+}
+
+static int rknpu_latency_show(struct seq_file *m, void *data)
+{
+	struct rknpu_debugger_node *node = m->private;
+	struct rknpu_debugger *debugger = node->debugger;
+	struct rknpu_device *rknpu_dev =
+		container_of(debugger, struct rknpu_device, debugger);
+	u64 hist[RKNPU_LATENCY_BUCKETS];
+	unsigned long flags;
+	int i, j;
+
+	for (i = 0; i < rknpu_dev->config->num_irqs; i++) {
+		spin_lock_irqsave(&rknpu_dev->irq_lock, flags);
+		memcpy(hist, rknpu_dev->subcore_datas[i].latency_hist,
+		       sizeof(hist));
+		spin_unlock_irqrestore(&rknpu_dev->irq_lock, flags);
+
+		seq_printf(m, "core%d submit to done latency:\n", i);
+		for (j = 0; j < RKNPU_LATENCY_BUCKETS; j++) {
+			if (!hist[j])
+				continue;
+			if (j == RKNPU_LATENCY_BUCKETS - 1)
+				seq_printf(m, "  >= %lluus: %llu\n",
+					   1ULL << (j - 1), hist[j]);
+			else
+				seq_printf(m, "  < %lluus: %llu\n", 1ULL << j,
+					   hist[j]);
+		}
+	}
+
+	return 0;
+}
+
+static ssize_t rknpu_latency_set(struct file *file, const char __user *ubuf,
+				 size_t len, loff_t *offp)
+{
+	struct seq_file *priv = file->private_data;
+	struct rknpu_debugger_node *node = priv->private;
+	struct rknpu_debugger *debugger = node->debugger;
+	struct rknpu_device *rknpu_dev =
+		container_of(debugger, struct rknpu_device, debugger);
+	unsigned long flags;
+	int i;
+
+	/* any write clears the histograms */
+	spin_lock_irqsave(&rknpu_dev->irq_lock, flags);
+	for (i = 0; i < rknpu_dev->config->num_irqs; i++)
+		memset(rknpu_dev->subcore_datas[i].latency_hist, 0,
+		       sizeof(rknpu_dev->subcore_datas[i].latency_hist));
+	spin_unlock_irqrestore(&rknpu_dev->irq_lock, flags);
+
+	return len;
+}
+
 static int rknpu_power_show(struct seq_file *m, void *data)
 {
 	struct rknpu_debugger_node *node = m->private;
@@ -266,11 +361,27 @@ static int rknpu_reset_show(struct seq_file *m, void *data)
 	struct rknpu_device *rknpu_dev =
 		container_of(debugger, struct rknpu_device, debugger);
 
+	struct rknpu_reset_stats *stats = &rknpu_dev->reset_stats;
+	u64 count = stats->full_count;
+	int i;
+
 	if (!rknpu_dev->bypass_soft_reset)
 		seq_puts(m, "on\n");
 	else
 		seq_puts(m, "off\n");
 
+	/* racy, but reset_lock must stay free for rknpu_soft_reset() */
+	seq_printf(m, "per core reset: %s\n",
+		   rknpu_dev->srsts_per_core ? "yes" : "no");
+	seq_printf(m, "full resets: %llu\n", stats->full_count);
+	for (i = 0; i < rknpu_dev->config->num_irqs; i++) {
+		seq_printf(m, "core%d resets: %llu\n", i, stats->core_count[i]);
+		count += stats->core_count[i];
+	}
+	seq_printf(m, "recovery us last: %llu avg: %llu max: %llu\n",
+		   stats->last_us, div64_u64(stats->total_us, max_t(u64, count, 1)),
+		   stats->max_us);
+
 	return 0;
 }
 
@@ -301,9 +412,288 @@ static ssize_t rknpu_reset_set(struct file *file, const char __user *ubuf,
 	return len;
 }
 
+#ifdef CONFIG_ROCKCHIP_RKNPU_DRM_GEM
+/*
+ * submit latency benchmark
+ *
+ * Runs blocking PC jobs built in the kernel over a matrix of task counts,
+ * core masks and pingpong modes. The regcmd of every task is empty apart
+ * from the PC trailer, so the numbers are the driver and job dispatch
+ * overhead, not the compute of a model. Run it on an idle npu, user jobs
+ * would show up in the latencies and the rw amount counters.
+ */
+#define RKNPU_BENCH_MAX_TASKS 128
+#define RKNPU_BENCH_MAX_RESULTS 32
+#define RKNPU_BENCH_DEFAULT_INT_MASK 0x300
+#define RKNPU_BENCH_TIMEOUT_MS 1000
+
+struct rknpu_bench_result {
+	uint32_t core_mask;
+	uint32_t task_number;
+	bool pingpong;
+	int ret;
+	uint32_t jobs;
+	/* submit to wakeup latency percentiles, us */
+	uint32_t p50;
+	uint32_t p90;
+	uint32_t p99;
+	uint32_t max;
+	/* commit to irq, as reported in hw_elapse_time */
+	uint64_t hw_avg_us;
+	uint64_t elapsed_us;
+	uint64_t rw_amount;
+};
+
+static DEFINE_MUTEX(rknpu_bench_lock);
+static struct rknpu_bench_result rknpu_bench_results[RKNPU_BENCH_MAX_RESULTS];
+static int rknpu_bench_nr_results;
+
+static int rknpu_bench_cmp(const void *a, const void *b)
+{
+	uint32_t x = *(const uint32_t *)a;
+	uint32_t y = *(const uint32_t *)b;
+
+	return x < y ? -1 : x > y;
+}
+
+static void rknpu_bench_run_one(struct rknpu_device *rknpu_dev,
+				struct rknpu_gem_object *task_obj,
+				struct rknpu_bench_result *res,
+				uint32_t iterations, uint32_t *lat)
+{
+	struct rknpu_submit args;
+	uint32_t dt_wr = 0, dt_rd = 0, wt_rd = 0;
+	uint64_t hw_total = 0;
+	ktime_t start, t;
+	int core_num = hweight32(res->core_mask);
+	int i, j;
+
+	rknpu_clear_rw_amount(rknpu_dev);
+
+	start = ktime_get();
+	for (i = 0; i < iterations; i++) {
+		memset(&args, 0, sizeof(args));
+		args.flags = RKNPU_JOB_PC |
+			     (res->pingpong ? RKNPU_JOB_PINGPONG : 0);
+		args.timeout = RKNPU_BENCH_TIMEOUT_MS;
+		args.task_number = res->task_number;
+		args.task_obj_addr = (__u64)(uintptr_t)task_obj;
+		args.task_base_addr = task_obj->dma_addr;
+		args.core_mask = res->core_mask;
+		args.fence_fd = -1;
+		/* every core runs the same tasks, see rknpu_job_subcore_commit_pc */
+		for (j = 0; j < core_num; j++) {
+			int k = core_num == 3 ? j + 2 : j;
+
+			args.subcore_task[k].task_start = 0;
+			args.subcore_task[k].task_number = res->task_number;
+		}
+
+		t = ktime_get();
+		res->ret = rknpu_submit_kernel(rknpu_dev, &args);
+		lat[i] = ktime_us_delta(ktime_get(), t);
+		if (res->ret)
+			break;
+		hw_total += args.hw_elapse_time;
+	}
+	res->elapsed_us = ktime_us_delta(ktime_get(), start);
+	res->jobs = i;
+
+	rknpu_get_rw_amount(rknpu_dev, &dt_wr, &dt_rd, &wt_rd);
+	res->rw_amount = (uint64_t)dt_wr + dt_rd + wt_rd;
+
+	if (!res->jobs)
+		return;
+
+	sort(lat, res->jobs, sizeof(*lat), rknpu_bench_cmp, NULL);
+	res->p50 = lat[res->jobs * 50 / 100];
+	res->p90 = lat[res->jobs * 90 / 100];
+	res->p99 = lat[res->jobs * 99 / 100];
+	res->max = lat[res->jobs - 1];
+	res->hw_avg_us = div_u64(hw_total, res->jobs);
+}
+
+static int rknpu_bench_run(struct rknpu_device *rknpu_dev,
+			   uint32_t iterations, uint32_t int_mask)
+{
+	static const uint32_t task_numbers[] = { 1, 16, RKNPU_BENCH_MAX_TASKS };
+	static const uint32_t core_masks[] = {
+		RKNPU_CORE0_MASK, RKNPU_CORE1_MASK, RKNPU_CORE2_MASK,
+		RKNPU_CORE0_MASK | RKNPU_CORE1_MASK,
+		RKNPU_CORE0_MASK | RKNPU_CORE1_MASK | RKNPU_CORE2_MASK
+	};
+	struct rknpu_gem_object *task_obj = NULL;
+	struct rknpu_task *tasks = NULL;
+	struct rknpu_bench_result *res = NULL;
+	size_t regcmd_offset = 0;
+	uint32_t *lat = NULL;
+	int nr = 0;
+	int i, m, p;
+
+	lat = kvmalloc_array(iterations, sizeof(*lat), GFP_KERNEL);
+	if (!lat)
+		return -ENOMEM;
+
+	/* task descriptors, then one zeroed regcmd shared by all tasks */
+	regcmd_offset = ALIGN(RKNPU_BENCH_MAX_TASKS * sizeof(*tasks), 64);
+	task_obj = rknpu_gem_object_create(
+		rknpu_dev->drm_dev,
+		RKNPU_MEM_KERNEL_MAPPING | RKNPU_MEM_NON_CACHEABLE |
+			RKNPU_MEM_ZEROING,
+		regcmd_offset + RKNPU_PC_DATA_EXTRA_AMOUNT * sizeof(uint64_t),
+		0, 0, NULL);
+	if (IS_ERR(task_obj)) {
+		kvfree(lat);
+		return PTR_ERR(task_obj);
+	}
+
+	tasks = task_obj->kv_addr;
+	for (i = 0; i < RKNPU_BENCH_MAX_TASKS; i++) {
+		tasks[i].op_idx = i;
+		tasks[i].int_mask = int_mask;
+		tasks[i].int_clear = int_mask;
+		tasks[i].regcfg_amount = 0;
+		tasks[i].regcmd_addr = task_obj->dma_addr + regcmd_offset;
+	}
+
+	rknpu_power_get(rknpu_dev);
+
+	for (m = 0; m < ARRAY_SIZE(core_masks); m++) {
+		if ((core_masks[m] & rknpu_dev->config->core_mask) !=
+		    core_masks[m])
+			continue;
+		for (i = 0; i < ARRAY_SIZE(task_numbers); i++) {
+			for (p = 0; p < 2; p++) {
+				if (nr >= RKNPU_BENCH_MAX_RESULTS)
+					break;
+				res = &rknpu_bench_results[nr++];
+				memset(res, 0, sizeof(*res));
+				res->core_mask = core_masks[m];
+				res->task_number = task_numbers[i];
+				res->pingpong = p;
+				rknpu_bench_run_one(rknpu_dev, task_obj, res,
+						    iterations, lat);
+			}
+		}
+	}
+	rknpu_bench_nr_results = nr;
+
+	rknpu_power_put(rknpu_dev);
+
+	rknpu_gem_object_put(&task_obj->base);
+	kvfree(lat);
+
+	return 0;
+}
+
+static int rknpu_bench_show(struct seq_file *m, void *data)
+{
+	struct rknpu_bench_result *res = NULL;
+	int i;
+
+	mutex_lock(&rknpu_bench_lock);
+	if (!rknpu_bench_nr_results) {
+		seq_puts(m, "echo \"<iterations> [int_mask]\" to run\n");
+		mutex_unlock(&rknpu_bench_lock);
+		return 0;
+	}
+
+	seq_puts(m,
+		 "core\ttasks\tpp\tjobs\tp50us\tp90us\tp99us\tmaxus\thwus\tjobs/s\ttasks/s\tKB/s\tret\n");
+	for (i = 0; i < rknpu_bench_nr_results; i++) {
+		uint64_t elapsed_us;
+
+		res = &rknpu_bench_results[i];
+		elapsed_us = max_t(uint64_t, res->elapsed_us, 1);
+		seq_printf(
+			m,
+			"%#x\t%u\t%d\t%u\t%u\t%u\t%u\t%u\t%llu\t%llu\t%llu\t%llu\t%d\n",
+			res->core_mask, res->task_number, res->pingpong,
+			res->jobs, res->p50, res->p90, res->p99, res->max,
+			res->hw_avg_us,
+			div64_u64((uint64_t)res->jobs * USEC_PER_SEC,
+				  elapsed_us),
+			div64_u64((uint64_t)res->jobs * res->task_number *
+					  USEC_PER_SEC,
+				  elapsed_us),
+			div64_u64(res->rw_amount * USEC_PER_SEC, elapsed_us) >>
+				10,
+			res->ret);
+	}
+	mutex_unlock(&rknpu_bench_lock);
+
+	return 0;
+}
+
+static ssize_t rknpu_bench_set(struct file *file, const char __user *ubuf,
+			       size_t len, loff_t *offp)
+{
+	struct seq_file *priv = file->private_data;
+	struct rknpu_debugger_node *node = priv->private;
+	struct rknpu_debugger *debugger = node->debugger;
+	struct rknpu_device *rknpu_dev =
+		container_of(debugger, struct rknpu_device, debugger);
+	uint32_t iterations = 0;
+	uint32_t int_mask = RKNPU_BENCH_DEFAULT_INT_MASK;
+	char buf[32];
+	int ret = 0;
+
+	if (len == 0 || len > sizeof(buf) - 1)
+		return -EINVAL;
+	if (copy_from_user(buf, ubuf, len))
+		return -EFAULT;
+	buf[len] = '\0';
+
+	if (sscanf(buf, "%u %x", &iterations, &int_mask) < 1 ||
+	    iterations == 0 || iterations > 100000) {
+		LOG_ERROR("usage: echo \"<iterations> [int_mask]\" > bench\n");
+		return -EINVAL;
+	}
+
+	mutex_lock(&rknpu_bench_lock);
+	ret = rknpu_bench_run(rknpu_dev, iterations, int_mask);
+	mutex_unlock(&rknpu_bench_lock);
+
+	return ret ? ret : len;
+}
+
+static ssize_t rknpu_gem_pool_set(struct file *file, const char __user *ubuf,
+				  size_t len, loff_t *offp)
+{
+	struct seq_file *priv = file->private_data;
+	struct rknpu_debugger_node *node = priv->private;
+	struct rknpu_debugger *debugger = node->debugger;
+	struct rknpu_device *rknpu_dev =
+		container_of(debugger, struct rknpu_device, debugger);
+	char buf[16];
+	unsigned long max_size = 0;
+	int ret = 0;
+
+	if (len > sizeof(buf) - 1)
+		return -EINVAL;
+	if (copy_from_user(buf, ubuf, len))
+		return -EFAULT;
+	buf[len - 1] = '\0';
+
+	ret = kstrtoul(buf, 10, &max_size);
+	if (ret) {
+		LOG_ERROR("failed to parse gem pool size string: %s\n", buf);
+		return -EFAULT;
+	}
+
+	rknpu_gem_pool_resize(rknpu_dev, max_size << 20);
+
+	LOG_INFO("set rknpu gem pool size %luMB\n", max_size);
+
+	return len;
+}
+#endif
+
 static struct rknpu_debugger_list rknpu_debugger_root_list[] = {
 	{ "version", rknpu_version_show, NULL, NULL },
 	{ "load", rknpu_load_show, NULL, NULL },
+	{ "session", rknpu_session_show, NULL, NULL },
+	{ "latency", rknpu_latency_show, rknpu_latency_set, NULL },
 	{ "power", rknpu_power_show, rknpu_power_set, NULL },
 	{ "freq", rknpu_freq_show, rknpu_freq_set, NULL },
 	{ "volt", rknpu_volt_show, NULL, NULL },
@@ -313,6 +703,10 @@ static struct rknpu_debugger_list rknpu_debugger_root_list[] = {
 #ifdef CONFIG_ROCKCHIP_RKNPU_SRAM
 	{ "mm", rknpu_mm_dump, NULL, NULL },
 #endif
+#ifdef CONFIG_ROCKCHIP_RKNPU_DRM_GEM
+	{ "gem_pool", rknpu_gem_pool_dump, rknpu_gem_pool_set, NULL },
+	{ "bench", rknpu_bench_show, rknpu_bench_set, NULL },
+#endif
 };
 
 static ssize_t rknpu_debugger_write(struct file *file, const char __user *ubuf,
@@ -7,13 +7,18 @@
 #include <linux/clk.h>
 #include <linux/clk-provider.h>
 #include <linux/devfreq_cooling.h>
+#include <linux/energy_model.h>
 #include <linux/pm_runtime.h>
 #include <linux/regmap.h>
+#include <linux/pm_opp.h>
 #include <../drivers/devfreq/governor.h>
 #include "rknpu_drv.h"
+#include "rknpu_job.h"
 #include "rknpu_devfreq.h"
 
 #define POWER_DOWN_FREQ 200000000
+/* headroom in percent over the rate estimated from past jobs */
+#define RKNPU_DEADLINE_MARGIN 10
 
 static int npu_devfreq_target(struct device *dev, unsigned long *freq,
 			      u32 flags);
@@ -75,6 +80,103 @@ static struct devfreq_governor devfreq_rknpu_ondemand = {
 	.event_handler = devfreq_rknpu_ondemand_handler,
 };
 
+/*
+ * pick the lowest opp that still meets the deadlines of the queued jobs,
+ * jobs without deadline hints run at the rknpu_ondemand frequency and an
+ * idle npu drops to the lowest opp.
+ */
+static int devfreq_rknpu_deadline_func(struct devfreq *df, unsigned long *freq)
+{
+	struct rknpu_device *rknpu_dev = df->data;
+	struct dev_pm_opp *opp = NULL;
+	unsigned long rate = 0;
+	bool busy = false;
+
+	rate = rknpu_job_deadline_rate(rknpu_dev, &busy);
+	if (!busy) {
+		*freq = 0;
+		return 0;
+	}
+
+	if (!rate)
+		return devfreq_rknpu_ondemand_func(df, freq);
+
+	if (rate > ULONG_MAX / (100 + RKNPU_DEADLINE_MARGIN))
+		rate = ULONG_MAX;
+	else
+		rate = rate * (100 + RKNPU_DEADLINE_MARGIN) / 100;
+
+	/* round up here, devfreq rounds down when lowering the rate */
+	opp = dev_pm_opp_find_freq_ceil(df->dev.parent, &rate);
+	if (IS_ERR(opp)) {
+		*freq = ULONG_MAX;
+		return 0;
+	}
+	dev_pm_opp_put(opp);
+
+	*freq = rate;
+
+	return 0;
+}
+
+static int devfreq_rknpu_deadline_handler(struct devfreq *devfreq,
+					  unsigned int event, void *data)
+{
+	return 0;
+}
+
+static struct devfreq_governor devfreq_rknpu_deadline = {
+	.name = "rknpu_deadline",
+	.get_target_freq = devfreq_rknpu_deadline_func,
+	.event_handler = devfreq_rknpu_deadline_handler,
+};
+
+static void rknpu_devfreq_deadline_work(struct work_struct *work)
+{
+	struct rknpu_device *rknpu_dev =
+		container_of(work, struct rknpu_device, deadline_work);
+	struct devfreq *devfreq = rknpu_dev->devfreq;
+
+	mutex_lock(&devfreq->lock);
+	if (devfreq->governor == &devfreq_rknpu_deadline)
+		update_devfreq(devfreq);
+	mutex_unlock(&devfreq->lock);
+}
+
+/* re-evaluate the deadline governor on job submit and completion */
+void rknpu_devfreq_kick(struct rknpu_device *rknpu_dev)
+{
+	if (rknpu_dev->devfreq)
+		queue_work(system_highpri_wq, &rknpu_dev->deadline_work);
+}
+EXPORT_SYMBOL(rknpu_devfreq_kick);
+
+static int rknpu_devfreq_add_governors(struct device *dev)
+{
+	int ret = 0;
+
+	ret = devfreq_add_governor(&devfreq_rknpu_ondemand);
+	if (ret) {
+		LOG_DEV_ERROR(dev, "failed to add rknpu_ondemand governor\n");
+		return ret;
+	}
+
+	ret = devfreq_add_governor(&devfreq_rknpu_deadline);
+	if (ret) {
+		LOG_DEV_ERROR(dev, "failed to add rknpu_deadline governor\n");
+		devfreq_remove_governor(&devfreq_rknpu_ondemand);
+		return ret;
+	}
+
+	return 0;
+}
+
+static void rknpu_devfreq_remove_governors(void)
+{
+	devfreq_remove_governor(&devfreq_rknpu_deadline);
+	devfreq_remove_governor(&devfreq_rknpu_ondemand);
+}
+
 static int rk3576_npu_set_read_margin(struct device *dev,
 				      struct rockchip_opp_info *opp_info,
 				      u32 rm)
@@ -351,14 +453,14 @@ int rknpu_devfreq_init(struct rknpu_device *rknpu_dev)
 	dp->initial_freq = rknpu_dev->current_freq;
 	of_property_read_u32(dev->of_node, "dynamic-power-coefficient",
 			     &dyn_power_coeff);
-	if (dyn_power_coeff)
+	if (!rockchip_ipa_register_em(dev, NULL) || dyn_power_coeff)
 		dp->is_cooling_device = true;
 
-	ret = devfreq_add_governor(&devfreq_rknpu_ondemand);
-	if (ret) {
-		LOG_DEV_ERROR(dev, "failed to add rknpu_ondemand governor\n");
+	INIT_WORK(&rknpu_dev->deadline_work, rknpu_devfreq_deadline_work);
+
+	ret = rknpu_devfreq_add_governors(dev);
+	if (ret)
 		goto err_uinit_table;
-	}
 
 	rknpu_dev->devfreq = devm_devfreq_add_device(dev, dp, "rknpu_ondemand",
 						     (void *)rknpu_dev);
@@ -393,8 +495,9 @@ int rknpu_devfreq_init(struct rknpu_device *rknpu_dev)
 	return 0;
 
 err_remove_governor:
-	devfreq_remove_governor(&devfreq_rknpu_ondemand);
+	rknpu_devfreq_remove_governors();
 err_uinit_table:
+	em_dev_unregister_perf_domain(dev);
 	rockchip_uninit_opp_table(dev, info);
 
 	return ret;
@@ -667,11 +770,11 @@ int rknpu_devfreq_init(struct rknpu_device *rknpu_dev)
 	dev_pm_opp_put(opp);
 	dp->initial_freq = rknpu_dev->current_freq;
 
-	ret = devfreq_add_governor(&devfreq_rknpu_ondemand);
-	if (ret) {
-		LOG_DEV_ERROR(dev, "failed to add rknpu_ondemand governor\n");
+	INIT_WORK(&rknpu_dev->deadline_work, rknpu_devfreq_deadline_work);
+
+	ret = rknpu_devfreq_add_governors(dev);
+	if (ret)
 		goto err_remove_table;
-	}
 
 	rknpu_dev->devfreq = devm_devfreq_add_device(dev, dp, "rknpu_ondemand",
 						     (void *)rknpu_dev);
@@ -727,7 +830,7 @@ int rknpu_devfreq_init(struct rknpu_device *rknpu_dev)
 	return 0;
 
 err_remove_governor:
-	devfreq_remove_governor(&devfreq_rknpu_ondemand);
+	rknpu_devfreq_remove_governors();
 err_remove_table:
 	rockchip_uninit_opp_table(dev, &rknpu_dev->opp_info);
 
@@ -788,8 +891,10 @@ void rknpu_devfreq_remove(struct rknpu_device *rknpu_dev)
 		rockchip_system_monitor_unregister(rknpu_dev->mdev_info);
 		rknpu_dev->mdev_info = NULL;
 	}
-	if (rknpu_dev->devfreq)
-		devfreq_remove_governor(&devfreq_rknpu_ondemand);
+	if (rknpu_dev->devfreq) {
+		cancel_work_sync(&rknpu_dev->deadline_work);
+		rknpu_devfreq_remove_governors();
+	}
 	rockchip_uninit_opp_table(rknpu_dev->dev, &rknpu_dev->opp_info);
 }
 EXPORT_SYMBOL(rknpu_devfreq_remove);
@@ -19,6 +19,7 @@
 #include <linux/platform_device.h>
 #include <linux/printk.h>
 #include <linux/slab.h>
+#include <linux/sort.h>
 #include <linux/spinlock.h>
 #include <linux/time.h>
 #include <linux/uaccess.h>
@@ -72,6 +73,43 @@ module_param(bypass_soft_reset, int, 0644);
 MODULE_PARM_DESC(bypass_soft_reset,
 		 "bypass RKNPU soft reset if set it to 1, disabled by default");
 
+static int preempt_task_number;
+module_param(preempt_task_number, int, 0644);
+MODULE_PARM_DESC(
+	preempt_task_number,
+	"split low priority single core PC jobs into slices of this many tasks, so that high priority jobs can preempt them, 0 to disable");
+
+static int sram_session_quota;
+module_param(sram_session_quota, int, 0644);
+MODULE_PARM_DESC(
+	sram_session_quota,
+	"max percentage of SRAM that a single session may hold, so that the first allocator cannot take it all, 0 to disable");
+
+static int cpu_boost_us;
+module_param(cpu_boost_us, int, 0644);
+MODULE_PARM_DESC(
+	cpu_boost_us,
+	"boost the cpu cluster submitting a high priority job for this many us, 0 to disable");
+
+static int power_hint_mw;
+module_param(power_hint_mw, int, 0644);
+MODULE_PARM_DESC(
+	power_hint_mw,
+	"npu power announced to the system monitor when a job is scheduled, 0 to disable");
+
+static int power_hint_ms = 100;
+module_param(power_hint_ms, int, 0644);
+MODULE_PARM_DESC(power_hint_ms,
+		 "how long a power hint lasts after the job is scheduled");
+
+#ifdef CONFIG_ROCKCHIP_RKNPU_DRM_GEM
+static int gem_pool_size;
+module_param(gem_pool_size, int, 0444);
+MODULE_PARM_DESC(
+	gem_pool_size,
+	"size in MB of the pool recycling destroyed gem buffers for reuse, 0 to disable");
+#endif
+
 static const struct rknpu_irqs_data rknpu_irqs[] = {
 	{ "npu_irq", rknpu_core0_irq_handler }
 };
@@ -258,6 +296,69 @@ static int rknpu_get_drv_version(uint32_t *version)
 	return 0;
 }
 
+static int rknpu_mem_sync_range_cmp(const void *a, const void *b)
+{
+	const struct rknpu_mem_sync_range *ra = a, *rb = b;
+
+	if (ra->offset == rb->offset)
+		return 0;
+
+	return ra->offset < rb->offset ? -1 : 1;
+}
+
+/*
+ * Collect the ranges of a sync request into @ranges, which holds
+ * RKNPU_MEM_SYNC_MAX_RANGES entries. Ranges are clipped to the object,
+ * sorted and merged, so every cache line is maintained at most once.
+ * Returns the number of ranges left, possibly 0.
+ */
+int rknpu_mem_sync_get_ranges(const struct rknpu_mem_sync *args,
+			      unsigned long obj_size,
+			      struct rknpu_mem_sync_range *ranges)
+{
+	struct rknpu_mem_sync_range *r = NULL;
+	int num = 1, i = 0, n = 0;
+
+	if (args->flags & RKNPU_MEM_SYNC_RANGES) {
+		if (args->size > RKNPU_MEM_SYNC_MAX_RANGES)
+			return -EINVAL;
+		num = args->size;
+		if (copy_from_user(ranges, u64_to_user_ptr(args->offset),
+				   num * sizeof(*ranges)))
+			return -EFAULT;
+	} else {
+		ranges[0].offset = args->offset;
+		ranges[0].size = args->size;
+	}
+
+	for (i = 0; i < num; i++) {
+		r = &ranges[i];
+		if (!r->size || r->offset >= obj_size)
+			continue;
+		r->size = min_t(u64, r->size, obj_size - r->offset);
+		ranges[n++] = *r;
+	}
+
+	if (n <= 1)
+		return n;
+
+	sort(ranges, n, sizeof(*ranges), rknpu_mem_sync_range_cmp, NULL);
+
+	num = n;
+	n = 0;
+	for (i = 1; i < num; i++) {
+		r = &ranges[n];
+		if (ranges[i].offset <= r->offset + r->size)
+			r->size = max(r->size, ranges[i].offset +
+						       ranges[i].size -
+						       r->offset);
+		else
+			ranges[++n] = ranges[i];
+	}
+
+	return n + 1;
+}
+
 static int rknpu_power_on(struct rknpu_device *rknpu_dev);
 static int rknpu_power_off(struct rknpu_device *rknpu_dev);
 
@@ -313,6 +414,57 @@ static int rknpu_power_put_delay(struct rknpu_device *rknpu_dev)
 	return 0;
 }
 
+struct rknpu_session *rknpu_session_create(struct rknpu_device *rknpu_dev)
+{
+	struct rknpu_session *session = NULL;
+
+	session = kzalloc(sizeof(*session), GFP_KERNEL);
+	if (!session)
+		return NULL;
+
+	session->rknpu_dev = rknpu_dev;
+	INIT_LIST_HEAD(&session->list);
+	kref_init(&session->refcount);
+	session->pid = task_tgid_nr(current);
+	get_task_comm(session->comm, current);
+
+	spin_lock(&rknpu_dev->session_lock);
+	list_add_tail(&session->node, &rknpu_dev->session_list);
+	spin_unlock(&rknpu_dev->session_lock);
+
+	return session;
+}
+
+static void rknpu_session_release(struct kref *ref)
+{
+	struct rknpu_session *session =
+		container_of(ref, struct rknpu_session, refcount);
+
+	kfree(session);
+}
+
+void rknpu_session_get(struct rknpu_session *session)
+{
+	kref_get(&session->refcount);
+}
+
+void rknpu_session_put(struct rknpu_session *session)
+{
+	kref_put(&session->refcount, rknpu_session_release);
+}
+
+/* unlist the session on file release, in-flight jobs keep it alive */
+void rknpu_session_close(struct rknpu_session *session)
+{
+	struct rknpu_device *rknpu_dev = session->rknpu_dev;
+
+	spin_lock(&rknpu_dev->session_lock);
+	list_del_init(&session->node);
+	spin_unlock(&rknpu_dev->session_lock);
+
+	rknpu_session_put(session);
+}
+
 static int rknpu_action(struct rknpu_device *rknpu_dev,
 			struct rknpu_action *args)
 {
@@ -428,15 +580,12 @@ static int rknpu_open(struct inode *inode, struct file *file)
 		container_of(file->private_data, struct rknpu_device, miscdev);
 	struct rknpu_session *session = NULL;
 
-	session = kzalloc(sizeof(*session), GFP_KERNEL);
+	session = rknpu_session_create(rknpu_dev);
 	if (!session) {
 		LOG_ERROR("rknpu session alloc failed\n");
 		return -ENOMEM;
 	}
 
-	session->rknpu_dev = rknpu_dev;
-	INIT_LIST_HEAD(&session->list);
-
 	file->private_data = (void *)session;
 
 	return nonseekable_open(inode, file);
@@ -472,7 +621,7 @@ static int rknpu_release(struct inode *inode, struct file *file)
 		kfree(entry);
 	}
 
-	kfree(session);
+	rknpu_session_close(session);
 
 	return 0;
 }
@@ -519,7 +668,7 @@ static long rknpu_ioctl(struct file *file, unsigned int cmd, unsigned long arg)
 		ret = rknpu_action_ioctl(rknpu_dev, arg);
 		break;
 	case RKNPU_SUBMIT:
-		ret = rknpu_submit_ioctl(rknpu_dev, arg);
+		ret = rknpu_submit_ioctl(rknpu_dev, file, arg);
 		break;
 	case RKNPU_MEM_CREATE:
 		ret = rknpu_mem_create_ioctl(rknpu_dev, file, cmd, arg);
@@ -532,6 +681,12 @@ static long rknpu_ioctl(struct file *file, unsigned int cmd, unsigned long arg)
 	case RKNPU_MEM_SYNC:
 		ret = rknpu_mem_sync_ioctl(rknpu_dev, arg);
 		break;
+	case RKNPU_RING_SUBMIT:
+		ret = rknpu_ring_submit_ioctl(rknpu_dev, file, arg);
+		break;
+	case RKNPU_SESSION_STATS:
+		ret = rknpu_session_stats_ioctl(rknpu_dev, file, arg);
+		break;
 	default:
 		break;
 	}
@@ -568,6 +723,32 @@ static int rknpu_action_ioctl(struct drm_device *dev, void *data,
 	return rknpu_action(rknpu_dev, (struct rknpu_action *)data);
 }
 
+static int rknpu_drm_open(struct drm_device *dev, struct drm_file *file_priv)
+{
+	struct rknpu_device *rknpu_dev = dev_get_drvdata(dev->dev);
+	struct rknpu_session *session = NULL;
+
+	session = rknpu_session_create(rknpu_dev);
+	if (!session) {
+		LOG_ERROR("rknpu session alloc failed\n");
+		return -ENOMEM;
+	}
+
+	file_priv->driver_priv = session;
+
+	return 0;
+}
+
+static void rknpu_drm_postclose(struct drm_device *dev,
+				struct drm_file *file_priv)
+{
+	struct rknpu_session *session = file_priv->driver_priv;
+
+	file_priv->driver_priv = NULL;
+	if (session)
+		rknpu_session_close(session);
+}
+
 #define RKNPU_IOCTL(func)                                                      \
 	static int __##func(struct drm_device *dev, void *data,                \
 			    struct drm_file *file_priv)                        \
@@ -586,6 +767,10 @@ RKNPU_IOCTL(rknpu_gem_create_ioctl);
 RKNPU_IOCTL(rknpu_gem_map_ioctl);
 RKNPU_IOCTL(rknpu_gem_destroy_ioctl);
 RKNPU_IOCTL(rknpu_gem_sync_ioctl);
+RKNPU_IOCTL(rknpu_ring_submit_ioctl);
+RKNPU_IOCTL(rknpu_session_stats_ioctl);
+RKNPU_IOCTL(rknpu_gem_seal_ioctl);
+RKNPU_IOCTL(rknpu_gem_attach_ioctl);
 
 static const struct drm_ioctl_desc rknpu_ioctls[] = {
 	DRM_IOCTL_DEF_DRV(RKNPU_ACTION, __rknpu_action_ioctl, DRM_RENDER_ALLOW),
@@ -598,6 +783,14 @@ static const struct drm_ioctl_desc rknpu_ioctls[] = {
 			  DRM_RENDER_ALLOW),
 	DRM_IOCTL_DEF_DRV(RKNPU_MEM_SYNC, __rknpu_gem_sync_ioctl,
 			  DRM_RENDER_ALLOW),
+	DRM_IOCTL_DEF_DRV(RKNPU_RING_SUBMIT, __rknpu_ring_submit_ioctl,
+			  DRM_RENDER_ALLOW),
+	DRM_IOCTL_DEF_DRV(RKNPU_SESSION_STATS, __rknpu_session_stats_ioctl,
+			  DRM_RENDER_ALLOW),
+	DRM_IOCTL_DEF_DRV(RKNPU_MEM_SEAL, __rknpu_gem_seal_ioctl,
+			  DRM_RENDER_ALLOW),
+	DRM_IOCTL_DEF_DRV(RKNPU_MEM_ATTACH, __rknpu_gem_attach_ioctl,
+			  DRM_RENDER_ALLOW),
 };
 
 #if KERNEL_VERSION(6, 1, 0) <= LINUX_VERSION_CODE
@@ -633,6 +826,8 @@ static struct drm_driver rknpu_drm_driver = {
 	.gem_prime_vmap = rknpu_gem_prime_vmap,
 	.gem_prime_vunmap = rknpu_gem_prime_vunmap,
 #endif
+	.open = rknpu_drm_open,
+	.postclose = rknpu_drm_postclose,
 	.dumb_create = rknpu_gem_dumb_create,
 #if KERNEL_VERSION(4, 19, 0) > LINUX_VERSION_CODE
 	.dumb_map_offset = rknpu_gem_dumb_map_offset,
@@ -683,9 +878,7 @@ static enum hrtimer_restart hrtimer_handler(struct hrtimer *timer)
 		job = subcore_data->job;
 		if (job) {
 			now = ktime_get();
-			subcore_data->timer.busy_time +=
-				ktime_sub(now, job->hw_recoder_time);
-			job->hw_recoder_time = now;
+			rknpu_job_account_busy(job, i, now);
 		}
 
 		subcore_data->timer.total_busy_time =
@@ -1166,7 +1359,7 @@ static int rknpu_probe(struct platform_device *pdev)
 	struct device *virt_dev = NULL;
 	const struct of_device_id *match = NULL;
 	const struct rknpu_config *config = NULL;
-	int ret = -EINVAL, i = 0;
+	int ret = -EINVAL, i = 0, j = 0;
 
 	if (!pdev->dev.of_node) {
 		LOG_DEV_ERROR(dev, "rknpu device-tree data is missing!\n");
@@ -1226,6 +1419,12 @@ static int rknpu_probe(struct platform_device *pdev)
 
 	rknpu_dev->bypass_irq_handler = bypass_irq_handler;
 	rknpu_dev->bypass_soft_reset = bypass_soft_reset;
+	rknpu_dev->preempt_task_number =
+		preempt_task_number > 0 ? preempt_task_number : 0;
+	rknpu_dev->sram_session_quota = clamp(sram_session_quota, 0, 100);
+	rknpu_dev->cpu_boost_us = cpu_boost_us > 0 ? cpu_boost_us : 0;
+	rknpu_dev->power_hint_mw = power_hint_mw > 0 ? power_hint_mw : 0;
+	rknpu_dev->power_hint_ms = power_hint_ms > 0 ? power_hint_ms : 0;
 
 	rknpu_reset_get(rknpu_dev);
 
@@ -1267,11 +1466,18 @@ static int rknpu_probe(struct platform_device *pdev)
 
 	spin_lock_init(&rknpu_dev->lock);
 	spin_lock_init(&rknpu_dev->irq_lock);
+	spin_lock_init(&rknpu_dev->ring_lock);
+	mutex_init(&rknpu_dev->ring_submit_lock);
+	init_waitqueue_head(&rknpu_dev->ring_wq);
+	spin_lock_init(&rknpu_dev->session_lock);
+	INIT_LIST_HEAD(&rknpu_dev->session_list);
 	mutex_init(&rknpu_dev->power_lock);
 	mutex_init(&rknpu_dev->reset_lock);
 	mutex_init(&rknpu_dev->domain_lock);
 	for (i = 0; i < config->num_irqs; i++) {
-		INIT_LIST_HEAD(&rknpu_dev->subcore_datas[i].todo_list);
+		for (j = 0; j < RKNPU_JOB_PRIORITY_LEVELS; j++)
+			INIT_LIST_HEAD(
+				&rknpu_dev->subcore_datas[i].todo_list[j]);
 		init_waitqueue_head(&rknpu_dev->subcore_datas[i].job_done_wq);
 		rknpu_dev->subcore_datas[i].task_num = 0;
 		res = platform_get_resource(pdev, IORESOURCE_MEM, i);
@@ -1316,11 +1522,22 @@ static int rknpu_probe(struct platform_device *pdev)
 	}
 
 #ifdef CONFIG_ROCKCHIP_RKNPU_DRM_GEM
+	mutex_init(&rknpu_dev->shared_lock);
+	INIT_LIST_HEAD(&rknpu_dev->shared_list);
+
 	ret = rknpu_drm_probe(rknpu_dev);
 	if (ret) {
 		LOG_DEV_ERROR(dev, "failed to probe device for rknpu\n");
 		return ret;
 	}
+
+	ret = rknpu_gem_pool_init(
+		rknpu_dev,
+		gem_pool_size > 0 ? (unsigned long)gem_pool_size << 20 : 0);
+	if (ret) {
+		LOG_DEV_ERROR(dev, "failed to init gem pool for rknpu\n");
+		return ret;
+	}
 #endif
 #ifdef CONFIG_ROCKCHIP_RKNPU_DMA_HEAP
 	rknpu_dev->miscdev.minor = MISC_DYNAMIC_MINOR;
@@ -1443,7 +1660,7 @@ static int rknpu_probe(struct platform_device *pdev)
 static int rknpu_remove(struct platform_device *pdev)
 {
 	struct rknpu_device *rknpu_dev = platform_get_drvdata(pdev);
-	int i = 0;
+	int i = 0, j = 0;
 
 	cancel_delayed_work_sync(&rknpu_dev->power_off_work);
 	destroy_workqueue(rknpu_dev->power_off_wq);
@@ -1453,12 +1670,18 @@ static int rknpu_remove(struct platform_device *pdev)
 
 	for (i = 0; i < rknpu_dev->config->num_irqs; i++) {
 		WARN_ON(rknpu_dev->subcore_datas[i].job);
-		WARN_ON(!list_empty(&rknpu_dev->subcore_datas[i].todo_list));
+		for (j = 0; j < RKNPU_JOB_PRIORITY_LEVELS; j++)
+			WARN_ON(!list_empty(
+				&rknpu_dev->subcore_datas[i].todo_list[j]));
 	}
 
 	if (IS_ENABLED(CONFIG_ROCKCHIP_RKNPU_SRAM) && rknpu_dev->sram_mm)
 		rknpu_mm_destroy(rknpu_dev->sram_mm);
 
+#ifdef CONFIG_ROCKCHIP_RKNPU_DRM_GEM
+	rknpu_gem_pool_destroy(rknpu_dev);
+#endif
+
 	if (rknpu_dev->iommu_en) {
 		rknpu_iommu_free_domains(rknpu_dev);
 		iommu_group_put(rknpu_dev->iommu_group);
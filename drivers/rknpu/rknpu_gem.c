@@ -12,8 +12,10 @@
 
 #include <linux/shmem_fs.h>
 #include <linux/dma-buf.h>
+#include <linux/dma-buf-cache.h>
 #include <linux/iommu.h>
 #include <linux/pfn_t.h>
+#include <linux/highmem.h>
 #include <linux/version.h>
 #include <linux/version_compat_defs.h>
 #include <asm/cacheflush.h>
@@ -128,6 +130,173 @@ static void rknpu_gem_put_pages(struct rknpu_gem_object *rknpu_obj)
 }
 #endif
 
+static unsigned int rknpu_gem_pool_order(unsigned long size)
+{
+	return min_t(unsigned int, get_order(size), RKNPU_GEM_POOL_MAX_ORDER);
+}
+
+static void rknpu_gem_pool_free_buf(struct rknpu_device *rknpu_dev,
+				    struct rknpu_gem_pool_buf *buf)
+{
+	rknpu_iommu_switch_domain(rknpu_dev, buf->iommu_domain_id);
+
+	sg_free_table(buf->sgt);
+	kfree(buf->sgt);
+
+	dma_free_attrs(rknpu_dev->dev, buf->size, buf->cookie, buf->dma_addr,
+		       buf->dma_attrs);
+
+	rknpu_gem_free_page(buf->pages);
+
+	kfree(buf);
+}
+
+/*
+ * move the lru tail buffers out of the pool until it fits in max_size,
+ * the caller frees them once the pool lock is dropped.
+ */
+static void rknpu_gem_pool_shrink(struct rknpu_gem_pool *pool,
+				  unsigned long max_size,
+				  struct list_head *reap_list)
+{
+	struct rknpu_gem_pool_buf *buf = NULL;
+
+	while (pool->cached_size > max_size && !list_empty(&pool->lru)) {
+		buf = list_last_entry(&pool->lru, struct rknpu_gem_pool_buf,
+				      lru);
+		list_del(&buf->lru);
+		list_move(&buf->head, reap_list);
+		pool->cached_size -= buf->size;
+	}
+}
+
+static void rknpu_gem_pool_reap(struct rknpu_device *rknpu_dev,
+				struct list_head *reap_list)
+{
+	struct rknpu_gem_pool_buf *buf = NULL, *q = NULL;
+
+	list_for_each_entry_safe(buf, q, reap_list, head) {
+		list_del(&buf->head);
+		rknpu_gem_pool_free_buf(rknpu_dev, buf);
+	}
+}
+
+/*
+ * take over a recycled backing store with the same size, memory type and
+ * iommu domain, the dma attributes must already be set up by the caller.
+ */
+static bool rknpu_gem_pool_get(struct rknpu_gem_object *rknpu_obj)
+{
+	struct drm_device *drm = rknpu_obj->base.dev;
+	struct rknpu_device *rknpu_dev = drm->dev_private;
+	struct rknpu_gem_pool *pool = rknpu_dev->gem_pool;
+	struct rknpu_gem_pool_buf *buf = NULL, *found = NULL;
+	unsigned long dma_attrs = rknpu_obj->dma_attrs;
+	unsigned int flags = rknpu_obj->flags & ~RKNPU_MEM_ZEROING;
+
+#ifdef DMA_ATTR_SKIP_ZEROING
+	dma_attrs &= ~DMA_ATTR_SKIP_ZEROING;
+#endif
+
+	if (!pool || !READ_ONCE(pool->max_size))
+		return false;
+
+	mutex_lock(&pool->lock);
+	list_for_each_entry(buf,
+			    &pool->buckets[rknpu_gem_pool_order(rknpu_obj->size)],
+			    head) {
+		if (buf->size == rknpu_obj->size && buf->flags == flags &&
+		    buf->dma_attrs == dma_attrs &&
+		    buf->iommu_domain_id == rknpu_obj->iommu_domain_id) {
+			found = buf;
+			break;
+		}
+	}
+
+	if (found) {
+		list_del(&found->head);
+		list_del(&found->lru);
+		pool->cached_size -= found->size;
+		pool->hits++;
+	} else {
+		pool->misses++;
+	}
+	mutex_unlock(&pool->lock);
+
+	if (!found)
+		return false;
+
+	rknpu_obj->cookie = found->cookie;
+	rknpu_obj->dma_addr = found->dma_addr;
+	rknpu_obj->dma_attrs = found->dma_attrs;
+	rknpu_obj->pages = found->pages;
+	rknpu_obj->sgt = found->sgt;
+	if (rknpu_obj->flags & RKNPU_MEM_KERNEL_MAPPING)
+		rknpu_obj->kv_addr = rknpu_obj->cookie;
+
+	kfree(found);
+
+	return true;
+}
+
+/*
+ * hand the backing store of a dying object over to the pool. The buffer is
+ * zeroed here, so a later owner never observes the previous contents and
+ * the allocation path can skip zeroing altogether.
+ */
+static bool rknpu_gem_pool_put(struct rknpu_gem_object *rknpu_obj)
+{
+	struct drm_device *drm = rknpu_obj->base.dev;
+	struct rknpu_device *rknpu_dev = drm->dev_private;
+	struct rknpu_gem_pool *pool = rknpu_dev->gem_pool;
+	struct rknpu_gem_pool_buf *buf = NULL;
+	unsigned long nr_pages = rknpu_obj->size >> PAGE_SHIFT;
+	unsigned long i = 0;
+	LIST_HEAD(reap_list);
+
+	if (!pool || rknpu_obj->size > READ_ONCE(pool->max_size) ||
+	    (rknpu_obj->flags & RKNPU_MEM_SECURE))
+		return false;
+
+	buf = kzalloc(sizeof(*buf), GFP_KERNEL);
+	if (!buf)
+		return false;
+
+	for (i = 0; i < nr_pages; i++)
+		clear_highpage(rknpu_obj->pages[i]);
+	dma_sync_sgtable_for_device(drm->dev, rknpu_obj->sgt,
+				    DMA_BIDIRECTIONAL);
+
+	buf->size = rknpu_obj->size;
+	buf->dma_attrs = rknpu_obj->dma_attrs;
+#ifdef DMA_ATTR_SKIP_ZEROING
+	buf->dma_attrs &= ~DMA_ATTR_SKIP_ZEROING;
+#endif
+	buf->flags = rknpu_obj->flags & ~RKNPU_MEM_ZEROING;
+	buf->iommu_domain_id = rknpu_obj->iommu_domain_id;
+	buf->cookie = rknpu_obj->cookie;
+	buf->dma_addr = rknpu_obj->dma_addr;
+	buf->pages = rknpu_obj->pages;
+	buf->sgt = rknpu_obj->sgt;
+
+	mutex_lock(&pool->lock);
+	if (buf->size > pool->max_size) {
+		/* the pool was shrunk meanwhile */
+		mutex_unlock(&pool->lock);
+		kfree(buf);
+		return false;
+	}
+	rknpu_gem_pool_shrink(pool, pool->max_size - buf->size, &reap_list);
+	list_add(&buf->head, &pool->buckets[rknpu_gem_pool_order(buf->size)]);
+	list_add(&buf->lru, &pool->lru);
+	pool->cached_size += buf->size;
+	mutex_unlock(&pool->lock);
+
+	rknpu_gem_pool_reap(rknpu_dev, &reap_list);
+
+	return true;
+}
+
 static int rknpu_gem_alloc_buf(struct rknpu_gem_object *rknpu_obj)
 {
 	struct drm_device *drm = rknpu_obj->base.dev;
@@ -180,6 +349,9 @@ static int rknpu_gem_alloc_buf(struct rknpu_gem_object *rknpu_obj)
 	}
 #endif
 
+	if (rknpu_gem_pool_get(rknpu_obj))
+		return 0;
+
 	if (rknpu_obj->flags & RKNPU_MEM_ZEROING)
 		gfp_mask |= __GFP_ZERO;
 
@@ -305,6 +477,11 @@ static void rknpu_gem_free_buf(struct rknpu_gem_object *rknpu_obj)
 	}
 #endif
 
+	if (rknpu_gem_pool_put(rknpu_obj)) {
+		rknpu_obj->dma_addr = 0;
+		return;
+	}
+
 	sg_free_table(rknpu_obj->sgt);
 	kfree(rknpu_obj->sgt);
 
@@ -387,6 +564,7 @@ static struct rknpu_gem_object *rknpu_gem_init(struct drm_device *drm,
 	}
 
 	rknpu_obj->size = rknpu_obj->base.size;
+	INIT_LIST_HEAD(&rknpu_obj->shared_node);
 
 	gfp_mask = mapping_gfp_mask(obj->filp->f_mapping);
 
@@ -613,11 +791,24 @@ static void rknpu_gem_free_buf_with_cache(struct rknpu_gem_object *rknpu_obj,
 	}
 }
 
+static void rknpu_gem_sram_uncharge(struct rknpu_gem_object *rknpu_obj)
+{
+	struct rknpu_session *session = rknpu_obj->sram_session;
+
+	if (!session)
+		return;
+
+	atomic_long_sub(rknpu_obj->sram_size, &session->sram_size);
+	rknpu_session_put(session);
+	rknpu_obj->sram_session = NULL;
+}
+
 struct rknpu_gem_object *rknpu_gem_object_create(struct drm_device *drm,
 						 unsigned int flags,
 						 unsigned long size,
 						 unsigned long sram_size,
-						 int iommu_domain_id)
+						 int iommu_domain_id,
+						 struct rknpu_session *session)
 {
 	struct rknpu_device *rknpu_dev = drm->dev_private;
 	struct rknpu_gem_object *rknpu_obj = NULL;
@@ -652,6 +843,7 @@ struct rknpu_gem_object *rknpu_gem_object_create(struct drm_device *drm,
 	    (flags & RKNPU_MEM_TRY_ALLOC_SRAM) && rknpu_dev->sram_size > 0) {
 		size_t sram_free_size = 0;
 		size_t real_sram_size = 0;
+		size_t want_sram_size = 0;
 
 		if (sram_size != 0)
 			sram_size = round_up(sram_size, PAGE_SIZE);
@@ -659,16 +851,40 @@ struct rknpu_gem_object *rknpu_gem_object_create(struct drm_device *drm,
 		/* set memory type and cache attribute from user side. */
 		rknpu_obj->flags = flags;
 
+		want_sram_size = remain_ddr_size;
+		if (sram_size != 0 && remain_ddr_size > sram_size)
+			want_sram_size = sram_size;
+
 		sram_free_size = rknpu_dev->sram_mm->free_chunks *
 				 rknpu_dev->sram_mm->chunk_size;
+		if (session && rknpu_dev->sram_session_quota > 0) {
+			size_t quota = (size_t)rknpu_dev->sram_size *
+				       rknpu_dev->sram_session_quota / 100;
+			size_t held = atomic_long_read(&session->sram_size);
+
+			quota = round_down(quota, PAGE_SIZE);
+			if (sram_free_size > quota - min(held, quota))
+				sram_free_size = quota - min(held, quota);
+		}
 		if (sram_free_size > 0) {
-			real_sram_size = remain_ddr_size;
-			if (sram_size != 0 && remain_ddr_size > sram_size)
-				real_sram_size = sram_size;
+			real_sram_size = want_sram_size;
 			if (real_sram_size > sram_free_size)
 				real_sram_size = sram_free_size;
 			ret = rknpu_mm_alloc(rknpu_dev->sram_mm, real_sram_size,
 					     &rknpu_obj->sram_obj);
+			if (ret != 0) {
+				/*
+				 * free chunks are fragmented, place the
+				 * largest free run rather than nothing.
+				 */
+				real_sram_size = min_t(
+					size_t, real_sram_size,
+					rknpu_mm_max_free_size(rknpu_dev->sram_mm));
+				if (real_sram_size > 0)
+					ret = rknpu_mm_alloc(rknpu_dev->sram_mm,
+							     real_sram_size,
+							     &rknpu_obj->sram_obj);
+			}
 			if (ret != 0) {
 				sram_free_size =
 					rknpu_dev->sram_mm->free_chunks *
@@ -680,8 +896,17 @@ struct rknpu_gem_object *rknpu_gem_object_create(struct drm_device *drm,
 			}
 		}
 
+		rknpu_mm_account(rknpu_dev->sram_mm, want_sram_size,
+				 real_sram_size);
+
 		if (real_sram_size > 0) {
 			rknpu_obj->sram_size = real_sram_size;
+			if (session) {
+				rknpu_session_get(session);
+				atomic_long_add(real_sram_size,
+						&session->sram_size);
+				rknpu_obj->sram_session = session;
+			}
 
 			ret = rknpu_gem_alloc_buf_with_cache(rknpu_obj,
 							     RKNPU_CACHE_SRAM);
@@ -732,6 +957,7 @@ struct rknpu_gem_object *rknpu_gem_object_create(struct drm_device *drm,
 	if (IS_ENABLED(CONFIG_ROCKCHIP_RKNPU_SRAM) &&
 	    rknpu_obj->sram_obj != NULL)
 		rknpu_mm_free(rknpu_dev->sram_mm, rknpu_obj->sram_obj);
+	rknpu_gem_sram_uncharge(rknpu_obj);
 
 gem_release:
 	rknpu_gem_release(rknpu_obj);
@@ -739,6 +965,24 @@ struct rknpu_gem_object *rknpu_gem_object_create(struct drm_device *drm,
 	return ERR_PTR(ret);
 }
 
+/*
+ * Same as drm_prime_gem_destroy, the dma_buf_unmap_attachment and
+ * dma_buf_detach are re-defined to keep cached mappings if
+ * CONFIG_DMABUF_CACHE is enabled, uncached ones are released as usual.
+ */
+static void rknpu_gem_prime_destroy(struct drm_gem_object *obj,
+				    struct sg_table *sg)
+{
+	struct dma_buf_attachment *attach = obj->import_attach;
+	struct dma_buf *dma_buf = attach->dmabuf;
+
+	if (sg)
+		dma_buf_unmap_attachment(attach, sg, DMA_BIDIRECTIONAL);
+	dma_buf_detach(dma_buf, attach);
+	/* remove the reference */
+	dma_buf_put(dma_buf);
+}
+
 void rknpu_gem_object_destroy(struct rknpu_gem_object *rknpu_obj)
 {
 	struct drm_gem_object *obj = &rknpu_obj->base;
@@ -751,6 +995,12 @@ void rknpu_gem_object_destroy(struct rknpu_gem_object *rknpu_obj)
 
 	rknpu_iommu_switch_domain(rknpu_dev, rknpu_obj->iommu_domain_id);
 
+	if (rknpu_obj->sealed) {
+		mutex_lock(&rknpu_dev->shared_lock);
+		list_del(&rknpu_obj->shared_node);
+		mutex_unlock(&rknpu_dev->shared_lock);
+	}
+
 	/*
 	 * do not release memory region from exporter.
 	 *
@@ -758,7 +1008,7 @@ void rknpu_gem_object_destroy(struct rknpu_gem_object *rknpu_obj)
 	 * once dmabuf's refcount becomes 0.
 	 */
 	if (obj->import_attach) {
-		drm_prime_gem_destroy(obj, rknpu_obj->sgt);
+		rknpu_gem_prime_destroy(obj, rknpu_obj->sgt);
 		rknpu_gem_free_page(rknpu_obj->pages);
 	} else {
 		if (IS_ENABLED(CONFIG_ROCKCHIP_RKNPU_SRAM) &&
@@ -766,6 +1016,7 @@ void rknpu_gem_object_destroy(struct rknpu_gem_object *rknpu_obj)
 			if (rknpu_obj->sram_obj != NULL)
 				rknpu_mm_free(rknpu_dev->sram_mm,
 					      rknpu_obj->sram_obj);
+			rknpu_gem_sram_uncharge(rknpu_obj);
 			rknpu_gem_free_buf_with_cache(rknpu_obj,
 						      RKNPU_CACHE_SRAM);
 		} else if (IS_ENABLED(CONFIG_NO_GKI) &&
@@ -789,9 +1040,9 @@ int rknpu_gem_create_ioctl(struct drm_device *drm, void *data,
 
 	rknpu_obj = rknpu_gem_object_find(file_priv, args->handle);
 	if (!rknpu_obj) {
-		rknpu_obj = rknpu_gem_object_create(drm, args->flags,
-						    args->size, args->sram_size,
-						    args->iommu_domain_id);
+		rknpu_obj = rknpu_gem_object_create(
+			drm, args->flags, args->size, args->sram_size,
+			args->iommu_domain_id, file_priv->driver_priv);
 		if (IS_ERR(rknpu_obj))
 			return PTR_ERR(rknpu_obj);
 
@@ -1043,7 +1294,8 @@ int rknpu_gem_dumb_create(struct drm_file *file_priv, struct drm_device *drm,
 	else
 		flags = RKNPU_MEM_CONTIGUOUS | RKNPU_MEM_WRITE_COMBINE;
 
-	rknpu_obj = rknpu_gem_object_create(drm, flags, args->size, 0, 0);
+	rknpu_obj = rknpu_gem_object_create(drm, flags, args->size, 0, 0,
+					    file_priv->driver_priv);
 	if (IS_ERR(rknpu_obj)) {
 		LOG_DEV_ERROR(drm->dev, "gem object allocate failed.\n");
 		return PTR_ERR(rknpu_obj);
@@ -1104,6 +1356,10 @@ vm_fault_t rknpu_gem_fault(struct vm_fault *vmf)
 		return VM_FAULT_SIGBUS;
 	}
 
+	/* writable mappings were revoked when the object got sealed */
+	if (READ_ONCE(rknpu_obj->sealed) && (vma->vm_flags & VM_WRITE))
+		return VM_FAULT_SIGBUS;
+
 	pfn = page_to_pfn(rknpu_obj->pages[page_offset]);
 	return vmf_insert_mixed(vma, vmf->address,
 				__pfn_to_pfn_t(pfn, PFN_DEV));
@@ -1186,6 +1442,12 @@ int rknpu_gem_mmap_obj(struct drm_gem_object *obj, struct vm_area_struct *vma)
 
 	LOG_DEBUG("flags: %#x\n", rknpu_obj->flags);
 
+	if (READ_ONCE(rknpu_obj->sealed)) {
+		if (vma->vm_flags & VM_WRITE)
+			return -EACCES;
+		vma->vm_flags &= ~VM_MAYWRITE;
+	}
+
 	/* non-cacheable as default. */
 	if (rknpu_obj->flags & RKNPU_MEM_CACHEABLE) {
 		vma->vm_page_prot = vm_get_page_prot(vma->vm_flags);
@@ -1231,10 +1493,87 @@ int rknpu_gem_mmap(struct file *filp, struct vm_area_struct *vma)
 
 /* low-level interface prime helpers */
 #if KERNEL_VERSION(4, 13, 0) <= LINUX_VERSION_CODE
+/*
+ * Same as drm_gem_prime_import_dev, but the attachment and its mapping go
+ * through the dma-buf cache when CONFIG_DMABUF_CACHE is enabled, so a
+ * buffer reimported every frame keeps its IOVA until the dma-buf is
+ * released. The cache is keyed by device only, so it is used for the
+ * default iommu domain, other domains map the buffer on each import.
+ */
+static struct drm_gem_object *
+rknpu_gem_prime_import_dev(struct drm_device *dev, struct dma_buf *dma_buf,
+			   struct device *attach_dev)
+{
+	struct rknpu_device *rknpu_dev = dev->dev_private;
+	struct dma_buf_attachment *attach = NULL;
+	struct sg_table *sgt = NULL;
+	struct drm_gem_object *obj = NULL;
+	int iommu_domain_id = 0;
+	int ret = -EINVAL;
+
+	if (dma_buf->ops->release == drm_gem_dmabuf_release) {
+		obj = dma_buf->priv;
+		if (obj->dev == dev) {
+			/*
+			 * Importing dmabuf exported from our own gem increases
+			 * refcount on gem itself instead of f_count of dmabuf.
+			 */
+			drm_gem_object_get(obj);
+			return obj;
+		}
+	}
+
+	/* keep the domain the buffer gets mapped in until it is recorded */
+	mutex_lock(&rknpu_dev->domain_lock);
+	iommu_domain_id = rknpu_dev->iommu_domain_id;
+
+	if (iommu_domain_id != 0) {
+		obj = drm_gem_prime_import_dev(dev, dma_buf, attach_dev);
+		if (!IS_ERR(obj))
+			to_rknpu_obj(obj)->iommu_domain_id = iommu_domain_id;
+		mutex_unlock(&rknpu_dev->domain_lock);
+		return obj;
+	}
+
+	attach = dma_buf_attach(dma_buf, attach_dev);
+	if (IS_ERR(attach)) {
+		mutex_unlock(&rknpu_dev->domain_lock);
+		return ERR_CAST(attach);
+	}
+
+	get_dma_buf(dma_buf);
+
+	sgt = dma_buf_map_attachment(attach, DMA_BIDIRECTIONAL);
+	mutex_unlock(&rknpu_dev->domain_lock);
+	if (IS_ERR(sgt)) {
+		ret = PTR_ERR(sgt);
+		goto fail_detach;
+	}
+
+	obj = rknpu_gem_prime_import_sg_table(dev, attach, sgt);
+	if (IS_ERR(obj)) {
+		ret = PTR_ERR(obj);
+		goto fail_unmap;
+	}
+
+	obj->import_attach = attach;
+	obj->resv = dma_buf->resv;
+
+	return obj;
+
+fail_unmap:
+	dma_buf_unmap_attachment(attach, sgt, DMA_BIDIRECTIONAL);
+fail_detach:
+	dma_buf_detach(dma_buf, attach);
+	dma_buf_put(dma_buf);
+
+	return ERR_PTR(ret);
+}
+
 struct drm_gem_object *rknpu_gem_prime_import(struct drm_device *dev,
 					      struct dma_buf *dma_buf)
 {
-	return drm_gem_prime_import_dev(dev, dma_buf, dev->dev);
+	return rknpu_gem_prime_import_dev(dev, dma_buf, dev->dev);
 }
 #endif
 
@@ -1418,44 +1757,33 @@ static int rknpu_cache_sync(struct rknpu_gem_object *rknpu_obj,
 	return 0;
 }
 
-int rknpu_gem_sync_ioctl(struct drm_device *dev, void *data,
-			 struct drm_file *file_priv)
+static void rknpu_gem_sync_range(struct rknpu_device *rknpu_dev,
+				 struct rknpu_gem_object *rknpu_obj,
+				 u32 flags, unsigned long offset,
+				 unsigned long length)
 {
-	struct rknpu_gem_object *rknpu_obj = NULL;
-	struct rknpu_device *rknpu_dev = dev->dev_private;
-	struct rknpu_mem_sync *args = data;
+	struct device *dev = rknpu_dev->dev;
 	struct scatterlist *sg;
 	dma_addr_t sg_phys_addr;
-	unsigned long length, offset = 0;
 	unsigned long sg_offset, sg_left, size = 0;
 	unsigned long len = 0;
 	int i;
 
-	rknpu_obj = (struct rknpu_gem_object *)(uintptr_t)args->obj_addr;
-	if (!rknpu_obj)
-		return -EINVAL;
-
-	if (!(rknpu_obj->flags & RKNPU_MEM_CACHEABLE))
-		return -EINVAL;
-
 	if (!(rknpu_obj->flags & RKNPU_MEM_NON_CONTIGUOUS)) {
-		if (args->flags & RKNPU_MEM_SYNC_TO_DEVICE) {
-			dma_sync_single_range_for_device(
-				dev->dev, rknpu_obj->dma_addr, args->offset,
-				args->size, DMA_TO_DEVICE);
+		if (flags & RKNPU_MEM_SYNC_TO_DEVICE) {
+			dma_sync_single_range_for_device(dev,
+							 rknpu_obj->dma_addr,
+							 offset, length,
+							 DMA_TO_DEVICE);
 		}
-		if (args->flags & RKNPU_MEM_SYNC_FROM_DEVICE) {
-			dma_sync_single_range_for_cpu(dev->dev,
-						      rknpu_obj->dma_addr,
-						      args->offset, args->size,
+		if (flags & RKNPU_MEM_SYNC_FROM_DEVICE) {
+			dma_sync_single_range_for_cpu(dev, rknpu_obj->dma_addr,
+						      offset, length,
 						      DMA_FROM_DEVICE);
 		}
 	} else {
 		WARN_ON(!rknpu_dev->fake_dev);
 
-		length = args->size;
-		offset = args->offset;
-
 		if (IS_ENABLED(CONFIG_NO_GKI) &&
 		    IS_ENABLED(CONFIG_ROCKCHIP_RKNPU_SRAM) &&
 		    rknpu_obj->sram_size > 0) {
@@ -1483,13 +1811,13 @@ int rknpu_gem_sync_ioctl(struct drm_device *dev, void *data,
 
 			size = (length < sg_left) ? length : sg_left;
 
-			if (args->flags & RKNPU_MEM_SYNC_TO_DEVICE) {
+			if (flags & RKNPU_MEM_SYNC_TO_DEVICE) {
 				dma_sync_single_range_for_device(
 					rknpu_dev->fake_dev, sg_phys_addr,
 					sg_offset, size, DMA_TO_DEVICE);
 			}
 
-			if (args->flags & RKNPU_MEM_SYNC_FROM_DEVICE) {
+			if (flags & RKNPU_MEM_SYNC_FROM_DEVICE) {
 				dma_sync_single_range_for_cpu(
 					rknpu_dev->fake_dev, sg_phys_addr,
 					sg_offset, size, DMA_FROM_DEVICE);
@@ -1499,6 +1827,239 @@ int rknpu_gem_sync_ioctl(struct drm_device *dev, void *data,
 			length -= size;
 		}
 	}
+}
+
+int rknpu_gem_sync_ioctl(struct drm_device *dev, void *data,
+			 struct drm_file *file_priv)
+{
+	struct rknpu_mem_sync_range ranges[RKNPU_MEM_SYNC_MAX_RANGES];
+	struct rknpu_gem_object *rknpu_obj = NULL;
+	struct rknpu_device *rknpu_dev = dev->dev_private;
+	struct rknpu_mem_sync *args = data;
+	int num = 0, i = 0;
+
+	rknpu_obj = (struct rknpu_gem_object *)(uintptr_t)args->obj_addr;
+	if (!rknpu_obj)
+		return -EINVAL;
+
+	/* uncached or write combined, there is nothing to maintain */
+	if (!(rknpu_obj->flags & RKNPU_MEM_CACHEABLE))
+		return 0;
+
+	num = rknpu_mem_sync_get_ranges(args, rknpu_obj->size, ranges);
+	if (num < 0)
+		return num;
+
+	for (i = 0; i < num; i++)
+		rknpu_gem_sync_range(rknpu_dev, rknpu_obj, args->flags,
+				     ranges[i].offset, ranges[i].size);
+
+	return 0;
+}
+
+/*
+ * Sealed objects hold read-only data such as model weights. They are
+ * registered by the digest of their content, computed here rather than
+ * trusted from userspace, so every process loading the same model can
+ * attach to one backing store and iova instead of loading its own copy.
+ */
+static void rknpu_gem_digest(struct rknpu_gem_object *rknpu_obj, u64 size,
+			     u8 *digest)
+{
+	struct sha256_state sctx;
+	unsigned long i = 0, len = 0;
+	void *vaddr = NULL;
+
+	sha256_init(&sctx);
+	for (i = 0; size; i++) {
+		len = min_t(u64, size, PAGE_SIZE);
+		vaddr = kmap_local_page(rknpu_obj->pages[i]);
+		sha256_update(&sctx, vaddr, len);
+		kunmap_local(vaddr);
+		size -= len;
+		cond_resched();
+	}
+	sha256_final(&sctx, digest);
+}
+
+/* Called with the shared_lock of the device held, returns a reference */
+static struct rknpu_gem_object *
+rknpu_gem_shared_lookup(struct rknpu_device *rknpu_dev, const u8 *digest,
+			u64 size, int iommu_domain_id)
+{
+	struct rknpu_gem_object *rknpu_obj = NULL;
+
+	list_for_each_entry(rknpu_obj, &rknpu_dev->shared_list, shared_node) {
+		if (rknpu_obj->sealed_size == size &&
+		    rknpu_obj->iommu_domain_id == iommu_domain_id &&
+		    !memcmp(rknpu_obj->digest, digest, SHA256_DIGEST_SIZE) &&
+		    kref_get_unless_zero(&rknpu_obj->base.refcount))
+			return rknpu_obj;
+	}
+
+	return NULL;
+}
+
+int rknpu_gem_seal_ioctl(struct drm_device *dev, void *data,
+			 struct drm_file *file_priv)
+{
+	struct rknpu_device *rknpu_dev = dev->dev_private;
+	struct rknpu_gem_object *rknpu_obj = NULL;
+	struct rknpu_gem_object *shared_obj = NULL;
+	struct rknpu_mem_seal *args = data;
+	struct drm_gem_object *obj = NULL;
+	u64 size = 0;
+	int ret = 0;
+
+	obj = drm_gem_object_lookup(file_priv, args->handle);
+	if (!obj)
+		return -EINVAL;
+
+	rknpu_obj = to_rknpu_obj(obj);
+	size = args->size ? args->size : rknpu_obj->size;
+	if (obj->import_attach || !rknpu_obj->pages ||
+	    rknpu_obj->sram_size > 0 || rknpu_obj->nbuf_size > 0 ||
+	    size > rknpu_obj->size) {
+		ret = -EINVAL;
+		goto out;
+	}
+
+	/* held while hashing, so a racing seal or attach sees the result */
+	mutex_lock(&rknpu_dev->shared_lock);
+	if (rknpu_obj->sealed) {
+		ret = rknpu_obj->sealed_size == size ? 0 : -EBUSY;
+		goto out_unlock;
+	}
+
+	WRITE_ONCE(rknpu_obj->sealed, true);
+	drm_vma_node_unmap(&obj->vma_node, dev->anon_inode->i_mapping);
+
+	rknpu_gem_sync_range(rknpu_dev, rknpu_obj,
+			     RKNPU_MEM_SYNC_TO_DEVICE |
+				     RKNPU_MEM_SYNC_FROM_DEVICE,
+			     0, size);
+	rknpu_gem_digest(rknpu_obj, size, rknpu_obj->digest);
+	rknpu_obj->sealed_size = size;
+
+	/* an object with the same content may already be shared */
+	shared_obj = rknpu_gem_shared_lookup(rknpu_dev, rknpu_obj->digest, size,
+					     rknpu_obj->iommu_domain_id);
+	if (shared_obj)
+		rknpu_gem_object_put(&shared_obj->base);
+	else
+		list_add_tail(&rknpu_obj->shared_node,
+			      &rknpu_dev->shared_list);
+
+out_unlock:
+	mutex_unlock(&rknpu_dev->shared_lock);
+	if (!ret) {
+		args->size = rknpu_obj->sealed_size;
+		memcpy(args->digest, rknpu_obj->digest, SHA256_DIGEST_SIZE);
+	}
+out:
+	rknpu_gem_object_put(obj);
+
+	return ret;
+}
+
+int rknpu_gem_attach_ioctl(struct drm_device *dev, void *data,
+			   struct drm_file *file_priv)
+{
+	struct rknpu_device *rknpu_dev = dev->dev_private;
+	struct rknpu_gem_object *rknpu_obj = NULL;
+	struct rknpu_mem_attach *args = data;
+	int ret = 0;
+
+	mutex_lock(&rknpu_dev->shared_lock);
+	rknpu_obj = rknpu_gem_shared_lookup(rknpu_dev, args->digest,
+					    args->size, args->iommu_domain_id);
+	mutex_unlock(&rknpu_dev->shared_lock);
+	if (!rknpu_obj)
+		return -ENOENT;
+
+	ret = rknpu_gem_handle_create(&rknpu_obj->base, file_priv,
+				      &args->handle);
+	if (ret) {
+		rknpu_gem_object_put(&rknpu_obj->base);
+		return ret;
+	}
+
+	args->obj_size = rknpu_obj->size;
+	args->obj_addr = (__u64)(uintptr_t)rknpu_obj;
+	args->dma_addr = rknpu_obj->dma_addr;
+
+	return 0;
+}
+
+int rknpu_gem_pool_init(struct rknpu_device *rknpu_dev, unsigned long max_size)
+{
+	struct rknpu_gem_pool *pool = NULL;
+	int i = 0;
+
+	pool = devm_kzalloc(rknpu_dev->dev, sizeof(*pool), GFP_KERNEL);
+	if (!pool)
+		return -ENOMEM;
+
+	mutex_init(&pool->lock);
+	for (i = 0; i <= RKNPU_GEM_POOL_MAX_ORDER; i++)
+		INIT_LIST_HEAD(&pool->buckets[i]);
+	INIT_LIST_HEAD(&pool->lru);
+	pool->max_size = max_size;
+
+	rknpu_dev->gem_pool = pool;
+
+	return 0;
+}
+
+void rknpu_gem_pool_resize(struct rknpu_device *rknpu_dev,
+			   unsigned long max_size)
+{
+	struct rknpu_gem_pool *pool = rknpu_dev->gem_pool;
+	LIST_HEAD(reap_list);
+
+	if (!pool)
+		return;
+
+	mutex_lock(&pool->lock);
+	WRITE_ONCE(pool->max_size, max_size);
+	rknpu_gem_pool_shrink(pool, max_size, &reap_list);
+	mutex_unlock(&pool->lock);
+
+	rknpu_gem_pool_reap(rknpu_dev, &reap_list);
+}
+
+void rknpu_gem_pool_destroy(struct rknpu_device *rknpu_dev)
+{
+	rknpu_gem_pool_resize(rknpu_dev, 0);
+	rknpu_dev->gem_pool = NULL;
+}
+
+int rknpu_gem_pool_dump(struct seq_file *m, void *data)
+{
+	struct rknpu_debugger_node *node = m->private;
+	struct rknpu_debugger *debugger = node->debugger;
+	struct rknpu_device *rknpu_dev =
+		container_of(debugger, struct rknpu_device, debugger);
+	struct rknpu_gem_pool *pool = rknpu_dev->gem_pool;
+	struct rknpu_gem_pool_buf *buf = NULL;
+	unsigned long count = 0;
+	int i = 0;
+
+	if (!pool)
+		return 0;
+
+	mutex_lock(&pool->lock);
+	seq_printf(m, "max size: %lu, cached size: %lu\n", pool->max_size,
+		   pool->cached_size);
+	seq_printf(m, "hits: %lu, misses: %lu\n", pool->hits, pool->misses);
+	for (i = 0; i <= RKNPU_GEM_POOL_MAX_ORDER; i++) {
+		count = 0;
+		list_for_each_entry(buf, &pool->buckets[i], head)
+			count++;
+		if (count)
+			seq_printf(m, "order %d: %lu buffers\n", i, count);
+	}
+	mutex_unlock(&pool->lock);
 
 	return 0;
 }
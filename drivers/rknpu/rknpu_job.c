@@ -5,9 +5,12 @@
  */
 
 #include <linux/slab.h>
+#include <linux/cpufreq.h>
 #include <linux/delay.h>
 #include <linux/sync_file.h>
 #include <linux/io.h>
+#include <linux/log2.h>
+#include <linux/math64.h>
 
 #include "rknpu_ioctl.h"
 #include "rknpu_drv.h"
@@ -17,6 +20,10 @@
 #include "rknpu_mem.h"
 #include "rknpu_iommu.h"
 #include "rknpu_job.h"
+#include "rknpu_devfreq.h"
+
+#define CREATE_TRACE_POINTS
+#include "rknpu_trace.h"
 
 #define _REG_READ(base, offset) readl(base + (offset))
 #define _REG_WRITE(base, value, offset) writel(value, base + (offset))
@@ -68,6 +75,34 @@ static int rknpu_core_mask(int core_index)
 	return core_mask;
 }
 
+static int rknpu_job_priority_level(int32_t priority)
+{
+	if (priority > RKNPU_JOB_PRIORITY_NORMAL)
+		return 0;
+
+	if (priority < RKNPU_JOB_PRIORITY_NORMAL)
+		return RKNPU_JOB_PRIORITY_LEVELS - 1;
+
+	return 1;
+}
+
+/* must be called with irq_lock held */
+static struct rknpu_job *
+rknpu_job_first_todo(struct rknpu_subcore_data *subcore_data, int core_index,
+		     int max_level)
+{
+	int level = 0;
+
+	for (level = 0; level < max_level; level++) {
+		if (!list_empty(&subcore_data->todo_list[level]))
+			return list_first_entry(
+				&subcore_data->todo_list[level],
+				struct rknpu_job, head[core_index]);
+	}
+
+	return NULL;
+}
+
 static int rknpu_get_task_number(struct rknpu_job *job, int core_index)
 {
 	struct rknpu_device *rknpu_dev = job->rknpu_dev;
@@ -90,20 +125,76 @@ static int rknpu_get_task_number(struct rknpu_job *job, int core_index)
 	return task_num;
 }
 
+static void rknpu_ring_post_cqe(struct rknpu_device *rknpu_dev,
+				struct rknpu_ring_ctx *ring, int ret,
+				int fence_fd, int64_t hw_elapse_time)
+{
+	struct rknpu_ring_header *header = ring->header;
+	struct rknpu_ring_cqe *cqe = NULL;
+	unsigned long flags;
+	uint32_t tail;
+
+	spin_lock_irqsave(&rknpu_dev->ring_lock, flags);
+	tail = header->cq_tail;
+	if (tail - READ_ONCE(header->cq_head) >= ring->cq_entries) {
+		header->cq_overflow++;
+	} else {
+		cqe = &ring->cqes[tail & (ring->cq_entries - 1)];
+		cqe->user_data = ring->user_data;
+		cqe->ret = ret;
+		cqe->fence_fd = fence_fd;
+		cqe->hw_elapse_time = hw_elapse_time;
+		/* make the entry visible before publishing the new tail */
+		smp_store_release(&header->cq_tail, tail + 1);
+	}
+	spin_unlock_irqrestore(&rknpu_dev->ring_lock, flags);
+
+	wake_up_all(&rknpu_dev->ring_wq);
+}
+
+static void rknpu_job_ring_post(struct rknpu_job *job, int ret)
+{
+	if (!job->ring.header || xchg(&job->ring_posted, true))
+		return;
+
+	rknpu_ring_post_cqe(job->rknpu_dev, &job->ring, ret,
+			    job->fence ? job->args->fence_fd : -1,
+			    job->hw_elapse_time);
+}
+
 static void rknpu_job_free(struct rknpu_job *job)
 {
 #ifdef CONFIG_ROCKCHIP_RKNPU_DRM_GEM
 	struct rknpu_gem_object *task_obj = NULL;
+#endif
+
+	trace_rknpu_job_cleanup(job->id, job->args->core_mask,
+				job->args->task_number, job->ret);
 
+#ifdef CONFIG_ROCKCHIP_RKNPU_DRM_GEM
 	task_obj =
 		(struct rknpu_gem_object *)(uintptr_t)job->args->task_obj_addr;
 	if (task_obj)
 		rknpu_gem_object_put(&task_obj->base);
 #endif
 
+	if (job->ring.header) {
+		/* jobs dropped by timeout clean or abort never reach done */
+		rknpu_job_ring_post(job, job->ret ? job->ret : -ETIMEDOUT);
+#ifdef CONFIG_ROCKCHIP_RKNPU_DRM_GEM
+		rknpu_gem_object_put(
+			&((struct rknpu_gem_object *)job->ring.obj)->base);
+#endif
+	}
+
 	if (job->fence)
 		dma_fence_put(job->fence);
 
+	dma_fence_put(job->in_fence);
+
+	if (job->session)
+		rknpu_session_put(job->session);
+
 	if (job->args_owner)
 		kfree(job->args);
 
@@ -126,6 +217,7 @@ static void rknpu_job_cleanup_work(struct work_struct *work)
 }
 
 static inline struct rknpu_job *rknpu_job_alloc(struct rknpu_device *rknpu_dev,
+						struct rknpu_session *session,
 						struct rknpu_submit *args)
 {
 	struct rknpu_job *job = NULL;
@@ -140,12 +232,23 @@ static inline struct rknpu_job *rknpu_job_alloc(struct rknpu_device *rknpu_dev,
 
 	job->timestamp = ktime_get();
 	job->rknpu_dev = rknpu_dev;
+	job->id = atomic64_inc_return(&rknpu_dev->job_seq);
+	if (session) {
+		rknpu_session_get(session);
+		job->session = session;
+	}
 	job->use_core_num = (args->core_mask & RKNPU_CORE0_MASK) +
 			    ((args->core_mask & RKNPU_CORE1_MASK) >> 1) +
 			    ((args->core_mask & RKNPU_CORE2_MASK) >> 2);
 	atomic_set(&job->run_count, job->use_core_num);
 	atomic_set(&job->interrupt_count, job->use_core_num);
 	job->iommu_domain_id = args->iommu_domain_id;
+	job->priority_level = rknpu_job_priority_level(args->priority);
+	job->submit_slice = rknpu_dev->config->max_submit_number;
+	if ((args->flags & RKNPU_JOB_DEADLINE) && args->reserved)
+		job->deadline = ktime_add_us(job->timestamp, args->reserved);
+	for (i = 0; i < RKNPU_MAX_CORES; i++)
+		INIT_LIST_HEAD(&job->head[i]);
 	for (i = 0; i < rknpu_dev->config->num_irqs; i++)
 		atomic_set(&job->submit_count[i], 0);
 #ifdef CONFIG_ROCKCHIP_RKNPU_DRM_GEM
@@ -154,6 +257,8 @@ static inline struct rknpu_job *rknpu_job_alloc(struct rknpu_device *rknpu_dev,
 		rknpu_gem_object_get(&task_obj->base);
 #endif
 
+	trace_rknpu_job_alloc(job->id, args->core_mask, args->task_number, 0);
+
 	if (!(args->flags & RKNPU_JOB_NONBLOCK)) {
 		job->args = args;
 		job->args_owner = false;
@@ -162,6 +267,8 @@ static inline struct rknpu_job *rknpu_job_alloc(struct rknpu_device *rknpu_dev,
 
 	job->args = kzalloc(sizeof(*args), GFP_KERNEL);
 	if (!job->args) {
+		if (job->session)
+			rknpu_session_put(job->session);
 		kfree(job);
 		return NULL;
 	}
@@ -179,7 +286,6 @@ static inline int rknpu_job_wait(struct rknpu_job *job)
 	struct rknpu_submit *args = job->args;
 	struct rknpu_task *last_task = NULL;
 	struct rknpu_subcore_data *subcore_data = NULL;
-	struct rknpu_job *entry, *q;
 	void __iomem *rknpu_core_base = NULL;
 	int core_index = rknpu_wait_core_index(job->args->core_mask);
 	unsigned long flags;
@@ -222,15 +328,9 @@ static inline int rknpu_job_wait(struct rknpu_job *job)
 	last_task = job->last_task;
 	if (!last_task) {
 		spin_lock_irqsave(&rknpu_dev->irq_lock, flags);
-		for (i = 0; i < job->use_core_num; i++) {
-			subcore_data = &rknpu_dev->subcore_datas[i];
-			list_for_each_entry_safe(
-				entry, q, &subcore_data->todo_list, head[i]) {
-				if (entry == job) {
-					list_del(&job->head[i]);
-					break;
-				}
-			}
+		for (i = 0; i < rknpu_dev->config->num_irqs; i++) {
+			if (!list_empty(&job->head[i]))
+				list_del_init(&job->head[i]);
 		}
 		spin_unlock_irqrestore(&rknpu_dev->irq_lock, flags);
 
@@ -293,7 +393,7 @@ static inline int rknpu_job_subcore_commit_pc(struct rknpu_job *job,
 	int pc_task_number_bits = rknpu_dev->config->pc_task_number_bits;
 	int i = 0;
 	int submit_index = atomic_read(&job->submit_count[core_index]);
-	int max_submit_number = rknpu_dev->config->max_submit_number;
+	int submit_slice = job->submit_slice;
 	unsigned long flags;
 
 	if (!task_obj) {
@@ -329,10 +429,9 @@ static inline int rknpu_job_subcore_commit_pc(struct rknpu_job *job,
 		}
 	}
 
-	task_start = task_start + submit_index * max_submit_number;
-	task_number = task_number - submit_index * max_submit_number;
-	task_number = task_number > max_submit_number ? max_submit_number :
-							task_number;
+	task_start = task_start + submit_index * submit_slice;
+	task_number = task_number - submit_index * submit_slice;
+	task_number = task_number > submit_slice ? submit_slice : task_number;
 	task_end = task_start + task_number - 1;
 
 	task_base = task_obj->kv_addr;
@@ -367,6 +466,8 @@ static inline int rknpu_job_subcore_commit_pc(struct rknpu_job *job,
 	job->last_task = last_task;
 	job->int_mask[core_index] = last_task->int_mask;
 
+	trace_rknpu_job_commit(job->id, core_index, task_start, task_number);
+
 	REG_WRITE(0x1, RKNPU_OFFSET_PC_OP_EN);
 	REG_WRITE(0x0, RKNPU_OFFSET_PC_OP_EN);
 
@@ -425,6 +526,65 @@ static void rknpu_job_commit(struct rknpu_job *job)
 	}
 }
 
+/* must be called with irq_lock held */
+void rknpu_job_account_busy(struct rknpu_job *job, int core_index, ktime_t now)
+{
+	struct rknpu_device *rknpu_dev = job->rknpu_dev;
+	ktime_t busy_time = ktime_sub(now, job->hw_recoder_time);
+
+	rknpu_dev->subcore_datas[core_index].timer.busy_time += busy_time;
+	if (job->session)
+		job->session->stats.busy_time[core_index] += busy_time;
+	job->hw_recoder_time = now;
+}
+
+static void rknpu_read_rw_amount(struct rknpu_device *rknpu_dev,
+				 uint32_t *dt_wr, uint32_t *dt_rd,
+				 uint32_t *wd_rd);
+
+/*
+ * Charge the bandwidth used since the last sample evenly to the sessions
+ * running on the cores, must be called with irq_lock held before the set
+ * of running jobs changes.
+ */
+static void rknpu_session_account_amount(struct rknpu_device *rknpu_dev)
+{
+	struct rknpu_session *sessions[RKNPU_MAX_CORES];
+	struct rknpu_session *session = NULL;
+	struct rknpu_job *job = NULL;
+	uint32_t amount[3], delta[3];
+	int num = 0;
+	int i, j;
+
+	if (!rknpu_dev->config->amount_top)
+		return;
+
+	rknpu_read_rw_amount(rknpu_dev, &amount[0], &amount[1], &amount[2]);
+	for (i = 0; i < 3; i++) {
+		delta[i] = amount[i] - rknpu_dev->last_rw_amount[i];
+		rknpu_dev->last_rw_amount[i] = amount[i];
+	}
+
+	for (i = 0; i < rknpu_dev->config->num_irqs; i++) {
+		job = rknpu_dev->subcore_datas[i].job;
+		if (!job || !job->session)
+			continue;
+		for (j = 0; j < num; j++) {
+			if (sessions[j] == job->session)
+				break;
+		}
+		if (j == num)
+			sessions[num++] = job->session;
+	}
+
+	for (j = 0; j < num; j++) {
+		session = sessions[j];
+		session->stats.dt_wr_amount += delta[0] / num;
+		session->stats.dt_rd_amount += delta[1] / num;
+		session->stats.wt_rd_amount += delta[2] / num;
+	}
+}
+
 static void rknpu_job_next(struct rknpu_device *rknpu_dev, int core_index)
 {
 	struct rknpu_job *job = NULL;
@@ -438,18 +598,29 @@ static void rknpu_job_next(struct rknpu_device *rknpu_dev, int core_index)
 
 	spin_lock_irqsave(&rknpu_dev->irq_lock, flags);
 
-	if (subcore_data->job || list_empty(&subcore_data->todo_list)) {
+	if (subcore_data->job || subcore_data->resetting) {
 		spin_unlock_irqrestore(&rknpu_dev->irq_lock, flags);
 		return;
 	}
 
-	job = list_first_entry(&subcore_data->todo_list, struct rknpu_job,
-			       head[core_index]);
+	job = rknpu_job_first_todo(subcore_data, core_index,
+				   RKNPU_JOB_PRIORITY_LEVELS);
+	if (!job) {
+		spin_unlock_irqrestore(&rknpu_dev->irq_lock, flags);
+		return;
+	}
 
 	list_del_init(&job->head[core_index]);
+	rknpu_session_account_amount(rknpu_dev);
 	subcore_data->job = job;
-	job->hw_commit_time = ktime_get();
-	job->hw_recoder_time = job->hw_commit_time;
+	job->hw_recoder_time = ktime_get();
+	/* a preempted job keeps the time of its first commit */
+	if (!job->hw_commit_time) {
+		job->hw_commit_time = job->hw_recoder_time;
+		if (job->session)
+			job->session->stats.wait_time += ktime_sub(
+				job->hw_commit_time, job->timestamp);
+	}
 	spin_unlock_irqrestore(&rknpu_dev->irq_lock, flags);
 
 	if (atomic_dec_and_test(&job->run_count)) {
@@ -457,40 +628,189 @@ static void rknpu_job_next(struct rknpu_device *rknpu_dev, int core_index)
 	}
 }
 
+/*
+ * Preempt a sliced single core job at a task boundary if a job of higher
+ * priority is waiting on the same core. The preempted job is put back at
+ * the head of its own level and resumes from its next slice.
+ */
+static bool rknpu_job_preempt(struct rknpu_job *job, int core_index)
+{
+	struct rknpu_device *rknpu_dev = job->rknpu_dev;
+	struct rknpu_subcore_data *subcore_data =
+		&rknpu_dev->subcore_datas[core_index];
+	unsigned long flags;
+
+	if (job->use_core_num != 1 || job->priority_level == 0)
+		return false;
+
+	spin_lock_irqsave(&rknpu_dev->irq_lock, flags);
+	if (!rknpu_job_first_todo(subcore_data, core_index,
+				  job->priority_level)) {
+		spin_unlock_irqrestore(&rknpu_dev->irq_lock, flags);
+		return false;
+	}
+
+	rknpu_session_account_amount(rknpu_dev);
+	subcore_data->job = NULL;
+	rknpu_job_account_busy(job, core_index, ktime_get());
+	job->irq_entry[core_index] = false;
+	atomic_set(&job->run_count, 1);
+	list_add(&job->head[core_index],
+		 &subcore_data->todo_list[job->priority_level]);
+	spin_unlock_irqrestore(&rknpu_dev->irq_lock, flags);
+
+	rknpu_job_next(rknpu_dev, core_index);
+
+	return true;
+}
+
+/* called with irq_lock held */
+static void rknpu_job_account_latency(struct rknpu_subcore_data *subcore_data,
+				      struct rknpu_job *job, ktime_t now)
+{
+	s64 latency_us = ktime_us_delta(now, job->timestamp);
+	int bucket = 0;
+
+	if (latency_us > 0)
+		bucket = min_t(int, ilog2(latency_us) + 1,
+			       RKNPU_LATENCY_BUCKETS - 1);
+
+	subcore_data->latency_hist[bucket]++;
+}
+
+/* called with irq_lock held */
+static void rknpu_session_account_cycles(struct rknpu_session *session,
+					 struct rknpu_job *job,
+					 struct rknpu_device *rknpu_dev)
+{
+	u64 cycles = mul_u64_u64_div_u64(ktime_to_ns(job->hw_elapse_time),
+					 rknpu_dev->current_freq,
+					 NSEC_PER_SEC);
+
+	if (!session->job_cycles)
+		session->job_cycles = cycles;
+	else
+		session->job_cycles = (session->job_cycles * 3 + cycles) >> 2;
+}
+
+static void rknpu_job_deadline_step(struct rknpu_job *job, ktime_t now,
+				    u64 *work, u64 *rate)
+{
+	s64 slack = 0;
+
+	if (job->session)
+		*work += job->session->job_cycles;
+
+	if (!job->deadline)
+		return;
+
+	slack = ktime_to_ns(ktime_sub(job->deadline, now));
+	if (slack <= 0) {
+		/* already late, run flat out */
+		*rate = U64_MAX;
+		return;
+	}
+
+	*rate = max(*rate, mul_u64_u64_div_u64(*work, NSEC_PER_SEC, slack));
+}
+
+/*
+ * lowest clock rate that lets each job with a deadline finish in time,
+ * together with every job served before it on the same core. Cores serve
+ * the running job first, then their queues in priority order, and the
+ * work of a job is estimated from the recent jobs of its session.
+ * Returns 0 if no queued job carries a deadline, @busy tells whether any
+ * job is queued or running at all.
+ */
+unsigned long rknpu_job_deadline_rate(struct rknpu_device *rknpu_dev,
+				      bool *busy)
+{
+	struct rknpu_subcore_data *subcore_data = NULL;
+	struct rknpu_job *job = NULL;
+	ktime_t now = ktime_get();
+	unsigned long flags;
+	u64 work = 0, rate = 0;
+	int i = 0, level = 0;
+
+	*busy = false;
+
+	spin_lock_irqsave(&rknpu_dev->irq_lock, flags);
+	for (i = 0; i < rknpu_dev->config->num_irqs; i++) {
+		subcore_data = &rknpu_dev->subcore_datas[i];
+		work = 0;
+
+		if (subcore_data->job) {
+			*busy = true;
+			rknpu_job_deadline_step(subcore_data->job, now, &work,
+						&rate);
+		}
+
+		for (level = 0; level < RKNPU_JOB_PRIORITY_LEVELS; level++) {
+			list_for_each_entry(job, &subcore_data->todo_list[level],
+					    head[i]) {
+				*busy = true;
+				rknpu_job_deadline_step(job, now, &work, &rate);
+			}
+		}
+	}
+	spin_unlock_irqrestore(&rknpu_dev->irq_lock, flags);
+
+	return min_t(u64, rate, ULONG_MAX);
+}
+
 static void rknpu_job_done(struct rknpu_job *job, int ret, int core_index)
 {
 	struct rknpu_device *rknpu_dev = job->rknpu_dev;
 	struct rknpu_subcore_data *subcore_data = NULL;
 	ktime_t now;
 	unsigned long flags;
-	int max_submit_number = rknpu_dev->config->max_submit_number;
+	int submit_slice = job->submit_slice;
 
 	if (atomic_inc_return(&job->submit_count[core_index]) <
-	    (rknpu_get_task_number(job, core_index) + max_submit_number - 1) /
-		    max_submit_number) {
-		rknpu_job_subcore_commit(job, core_index);
+	    (rknpu_get_task_number(job, core_index) + submit_slice - 1) /
+		    submit_slice) {
+		if (!rknpu_job_preempt(job, core_index))
+			rknpu_job_subcore_commit(job, core_index);
 		return;
 	}
 
 	subcore_data = &rknpu_dev->subcore_datas[core_index];
 
 	spin_lock_irqsave(&rknpu_dev->irq_lock, flags);
+	rknpu_session_account_amount(rknpu_dev);
 	subcore_data->job = NULL;
 	subcore_data->task_num -= rknpu_get_task_number(job, core_index);
 	now = ktime_get();
 	job->hw_elapse_time = ktime_sub(now, job->hw_commit_time);
-	subcore_data->timer.busy_time += ktime_sub(now, job->hw_recoder_time);
+	rknpu_job_account_busy(job, core_index, now);
+	rknpu_job_account_latency(subcore_data, job, now);
 	spin_unlock_irqrestore(&rknpu_dev->irq_lock, flags);
 
+	trace_rknpu_job_done(
+		job->id, core_index, ret,
+		ktime_to_ns(ktime_sub(job->hw_commit_time, job->timestamp)),
+		ktime_to_ns(job->hw_elapse_time));
+
 	if (atomic_dec_and_test(&job->interrupt_count)) {
 		int use_core_num = job->use_core_num;
 
 		job->flags |= RKNPU_JOB_DONE;
 		job->ret = ret;
 
+		if (job->session) {
+			spin_lock_irqsave(&rknpu_dev->irq_lock, flags);
+			job->session->stats.job_count++;
+			if (!ret)
+				rknpu_session_account_cycles(job->session, job,
+							     rknpu_dev);
+			spin_unlock_irqrestore(&rknpu_dev->irq_lock, flags);
+		}
+
 		if (job->fence)
 			dma_fence_signal(job->fence);
 
+		rknpu_job_ring_post(job, ret);
+
 		if (job->flags & RKNPU_JOB_ASYNC)
 			schedule_work(&job->cleanup_work);
 
@@ -501,15 +821,26 @@ static void rknpu_job_done(struct rknpu_job *job, int ret, int core_index)
 	}
 
 	rknpu_job_next(rknpu_dev, core_index);
+
+	rknpu_devfreq_kick(rknpu_dev);
 }
 
-static int rknpu_schedule_core_index(struct rknpu_device *rknpu_dev)
+static int rknpu_schedule_core_index(struct rknpu_device *rknpu_dev,
+				     int priority_level)
 {
 	int core_num = rknpu_dev->config->num_irqs;
 	int task_num = rknpu_dev->subcore_datas[0].task_num;
 	int core_index = 0;
 	int i = 0;
 
+	/* high priority jobs prefer an idle core over the least loaded one */
+	if (priority_level == 0) {
+		for (i = 0; i < core_num; i++) {
+			if (!READ_ONCE(rknpu_dev->subcore_datas[i].job))
+				return i;
+		}
+	}
+
 	for (i = 1; i < core_num; i++) {
 		if (task_num > rknpu_dev->subcore_datas[i].task_num) {
 			core_index = i;
@@ -528,18 +859,32 @@ static void rknpu_job_schedule(struct rknpu_job *job)
 	unsigned long flags;
 
 	if (job->args->core_mask == RKNPU_CORE_AUTO_MASK) {
-		core_index = rknpu_schedule_core_index(rknpu_dev);
+		core_index = rknpu_schedule_core_index(rknpu_dev,
+						       job->priority_level);
 		job->args->core_mask = rknpu_core_mask(core_index);
 		job->use_core_num = 1;
 		atomic_set(&job->run_count, job->use_core_num);
 		atomic_set(&job->interrupt_count, job->use_core_num);
 	}
 
+	if (rknpu_dev->preempt_task_number > 0 && job->use_core_num == 1 &&
+	    job->priority_level > 0 &&
+	    rknpu_dev->preempt_task_number < job->submit_slice)
+		job->submit_slice = rknpu_dev->preempt_task_number;
+
+	/* let the other domains make room before the heat arrives */
+	if (rknpu_dev->power_hint_mw && rknpu_dev->power_hint_ms)
+		rockchip_system_monitor_power_hint(rknpu_dev->dev,
+						   rknpu_dev->power_hint_mw,
+						   rknpu_dev->power_hint_ms);
+
 	spin_lock_irqsave(&rknpu_dev->irq_lock, flags);
 	for (i = 0; i < rknpu_dev->config->num_irqs; i++) {
 		if (job->args->core_mask & rknpu_core_mask(i)) {
 			subcore_data = &rknpu_dev->subcore_datas[i];
-			list_add_tail(&job->head[i], &subcore_data->todo_list);
+			list_add_tail(
+				&job->head[i],
+				&subcore_data->todo_list[job->priority_level]);
 			subcore_data->task_num += rknpu_get_task_number(job, i);
 		}
 	}
@@ -549,6 +894,9 @@ static void rknpu_job_schedule(struct rknpu_job *job)
 		if (job->args->core_mask & rknpu_core_mask(i))
 			rknpu_job_next(rknpu_dev, i);
 	}
+
+	if (job->deadline)
+		rknpu_devfreq_kick(rknpu_dev);
 }
 
 static void rknpu_job_abort(struct rknpu_job *job)
@@ -568,6 +916,11 @@ static void rknpu_job_abort(struct rknpu_job *job)
 				subcore_data->job = NULL;
 				subcore_data->task_num -=
 					rknpu_get_task_number(job, i);
+			} else if (!list_empty(&job->head[i])) {
+				/* preempted and still waiting to resume */
+				list_del_init(&job->head[i]);
+				subcore_data->task_num -=
+					rknpu_get_task_number(job, i);
 			}
 		}
 	}
@@ -592,7 +945,12 @@ static void rknpu_job_abort(struct rknpu_job *job)
 						       job->timestamp));
 			}
 		}
-		rknpu_soft_reset(rknpu_dev);
+		rknpu_core_reset(rknpu_dev, job->args->core_mask);
+		/* jobs queued behind it on the reset cores */
+		for (i = 0; i < rknpu_dev->config->num_irqs; i++) {
+			if (job->args->core_mask & rknpu_core_mask(i))
+				rknpu_job_next(rknpu_dev, i);
+		}
 	} else {
 		LOG_ERROR(
 			"job abort, flags: %#x, ret: %d, elapsed time: %lldus\n",
@@ -654,6 +1012,8 @@ static inline irqreturn_t rknpu_irq_handler(int irq, void *data, int core_index)
 
 	job->int_status[core_index] = status;
 
+	trace_rknpu_job_irq(job->id, core_index, status);
+
 	if (rknpu_fuzz_status(status) != job->int_mask[core_index]) {
 		LOG_ERROR(
 			"invalid irq status: %#x, raw status: %#x, require mask: %#x, task counter: %#x\n",
@@ -687,6 +1047,54 @@ irqreturn_t rknpu_core2_irq_handler(int irq, void *data)
 	return rknpu_irq_handler(irq, data, 2);
 }
 
+/*
+ * Fail a timed out asynchronous job and reset only the cores it runs on.
+ * Jobs queued on those cores are kept and started once the reset is done,
+ * the other cores are not disturbed.
+ */
+static void rknpu_job_timeout_core_reset(struct rknpu_job *job)
+{
+	struct rknpu_device *rknpu_dev = job->rknpu_dev;
+	struct rknpu_subcore_data *subcore_data = NULL;
+	uint32_t reset_mask = 0;
+	unsigned long flags;
+	int i = 0;
+
+	spin_lock_irqsave(&rknpu_dev->irq_lock, flags);
+	for (i = 0; i < rknpu_dev->config->num_irqs; i++) {
+		subcore_data = &rknpu_dev->subcore_datas[i];
+		if (subcore_data->job == job) {
+			subcore_data->job = NULL;
+			subcore_data->task_num -= rknpu_get_task_number(job, i);
+			reset_mask |= rknpu_core_mask(i);
+		}
+	}
+	spin_unlock_irqrestore(&rknpu_dev->irq_lock, flags);
+
+	/* done from another path meanwhile */
+	if (!reset_mask)
+		return;
+
+	LOG_ERROR("job %llu timeout, core mask: %#x, elapsed time: %lldus\n",
+		  job->id, reset_mask, ktime_us_delta(ktime_get(), job->timestamp));
+
+	rknpu_core_reset(rknpu_dev, reset_mask);
+
+	job->ret = -ETIMEDOUT;
+	job->flags |= RKNPU_JOB_DONE;
+	if (job->fence) {
+		dma_fence_set_error(job->fence, -ETIMEDOUT);
+		dma_fence_signal(job->fence);
+	}
+	rknpu_job_ring_post(job, -ETIMEDOUT);
+	schedule_work(&job->cleanup_work);
+
+	for (i = 0; i < rknpu_dev->config->num_irqs; i++) {
+		if (reset_mask & rknpu_core_mask(i))
+			rknpu_job_next(rknpu_dev, i);
+	}
+}
+
 static void rknpu_job_timeout_clean(struct rknpu_device *rknpu_dev,
 				    int core_mask)
 {
@@ -701,7 +1109,14 @@ static void rknpu_job_timeout_clean(struct rknpu_device *rknpu_dev,
 			job = subcore_data->job;
 			if (job &&
 			    ktime_us_delta(ktime_get(), job->timestamp) >=
-				    job->args->timeout) {
+				    job->args->timeout * 1000) {
+				/* synchronous jobs are reset by their waiter */
+				if (rknpu_dev->srsts_per_core) {
+					if (job->flags & RKNPU_JOB_ASYNC)
+						rknpu_job_timeout_core_reset(job);
+					continue;
+				}
+
 				rknpu_soft_reset(rknpu_dev);
 
 				spin_lock_irqsave(&rknpu_dev->irq_lock, flags);
@@ -715,16 +1130,11 @@ static void rknpu_job_timeout_clean(struct rknpu_device *rknpu_dev,
 					spin_lock_irqsave(&rknpu_dev->irq_lock,
 							  flags);
 
-					if (!list_empty(
-						    &subcore_data->todo_list)) {
-						job = list_first_entry(
-							&subcore_data->todo_list,
-							struct rknpu_job,
-							head[i]);
+					job = rknpu_job_first_todo(
+						subcore_data, i,
+						RKNPU_JOB_PRIORITY_LEVELS);
+					if (job)
 						list_del_init(&job->head[i]);
-					} else {
-						job = NULL;
-					}
 
 					spin_unlock_irqrestore(
 						&rknpu_dev->irq_lock, flags);
@@ -734,8 +1144,60 @@ static void rknpu_job_timeout_clean(struct rknpu_device *rknpu_dev,
 	}
 }
 
+static void rknpu_job_in_fence_work(struct work_struct *work)
+{
+	struct rknpu_job *job =
+		container_of(work, struct rknpu_job, in_fence_work);
+	int status = dma_fence_get_status(job->in_fence);
+
+	dma_fence_put(job->in_fence);
+	job->in_fence = NULL;
+
+	if (status < 0) {
+		LOG_ERROR("job %llu in fence signaled with error %d\n",
+			  job->id, status);
+		job->ret = status;
+		if (job->fence) {
+			dma_fence_set_error(job->fence, status);
+			dma_fence_signal(job->fence);
+		}
+		rknpu_job_cleanup(job);
+		return;
+	}
+
+	/* timeout and wait time count from the moment the job is runnable */
+	job->timestamp = ktime_get();
+	rknpu_job_timeout_clean(job->rknpu_dev, job->args->core_mask);
+	rknpu_job_schedule(job);
+	if (job->ret)
+		rknpu_job_abort(job);
+}
+
+static void rknpu_job_in_fence_cb(struct dma_fence *fence,
+				  struct dma_fence_cb *cb)
+{
+	struct rknpu_job *job =
+		container_of(cb, struct rknpu_job, in_fence_cb);
+
+	schedule_work(&job->in_fence_work);
+}
+
+/*
+ * A nonblocking job with a foreign in-fence, e.g. from RGA preprocessing,
+ * is scheduled from the fence callback instead of blocking the submitter.
+ */
+static void rknpu_job_defer_on_fence(struct rknpu_job *job)
+{
+	INIT_WORK(&job->in_fence_work, rknpu_job_in_fence_work);
+	if (dma_fence_add_callback(job->in_fence, &job->in_fence_cb,
+				   rknpu_job_in_fence_cb))
+		schedule_work(&job->in_fence_work);
+}
+
 static int rknpu_submit(struct rknpu_device *rknpu_dev,
-			struct rknpu_submit *args)
+			struct rknpu_session *session,
+			struct rknpu_submit *args,
+			struct rknpu_ring_ctx *ring)
 {
 	struct rknpu_job *job = NULL;
 	int ret = -EINVAL;
@@ -750,12 +1212,26 @@ static int rknpu_submit(struct rknpu_device *rknpu_dev,
 		return -EINVAL;
 	}
 
-	job = rknpu_job_alloc(rknpu_dev, args);
+	job = rknpu_job_alloc(rknpu_dev, session, args);
 	if (!job) {
 		LOG_ERROR("failed to allocate rknpu job!\n");
 		return -ENOMEM;
 	}
 
+	/* the submitter usually consumes the result right after done */
+	if (rknpu_dev->cpu_boost_us && job->priority_level == 0)
+		cpufreq_interactive_boost_cpu(raw_smp_processor_id(),
+					      rknpu_dev->cpu_boost_us);
+
+	if (ring) {
+		job->ring = *ring;
+		ring->attached = true;
+#ifdef CONFIG_ROCKCHIP_RKNPU_DRM_GEM
+		rknpu_gem_object_get(
+			&((struct rknpu_gem_object *)ring->obj)->base);
+#endif
+	}
+
 	if (args->flags & RKNPU_JOB_FENCE_IN) {
 #ifdef CONFIG_ROCKCHIP_RKNPU_FENCE
 		struct dma_fence *in_fence;
@@ -765,25 +1241,34 @@ static int rknpu_submit(struct rknpu_device *rknpu_dev,
 		if (!in_fence) {
 			LOG_ERROR("invalid fence in fd, fd: %d\n",
 				  args->fence_fd);
+			rknpu_job_free(job);
 			return -EINVAL;
 		}
 		args->fence_fd = -1;
 
 		/*
 		 * Wait if the fence is from a foreign context, or if the fence
-		 * array contains any fence from a foreign context.
+		 * array contains any fence from a foreign context. Nonblocking
+		 * jobs are deferred on the fence instead.
 		 */
 		ret = 0;
-		if (!dma_fence_match_context(in_fence,
-					     rknpu_dev->fence_ctx->context))
+		if (dma_fence_match_context(in_fence,
+					    rknpu_dev->fence_ctx->context)) {
+			dma_fence_put(in_fence);
+		} else if (args->flags & RKNPU_JOB_NONBLOCK) {
+			job->in_fence = in_fence;
+		} else {
 			ret = dma_fence_wait_timeout(in_fence, true,
 						     args->timeout);
-		dma_fence_put(in_fence);
+			dma_fence_put(in_fence);
+		}
 		if (ret < 0) {
 			if (ret != -ERESTARTSYS)
 				LOG_ERROR("Error (%d) waiting for fence!\n",
 					  ret);
 
+			job->ret = ret;
+			rknpu_job_free(job);
 			return ret;
 		}
 #else
@@ -798,6 +1283,7 @@ static int rknpu_submit(struct rknpu_device *rknpu_dev,
 #ifdef CONFIG_ROCKCHIP_RKNPU_FENCE
 		ret = rknpu_fence_alloc(job);
 		if (ret) {
+			job->ret = ret;
 			rknpu_job_free(job);
 			return ret;
 		}
@@ -813,6 +1299,10 @@ static int rknpu_submit(struct rknpu_device *rknpu_dev,
 
 	if (args->flags & RKNPU_JOB_NONBLOCK) {
 		job->flags |= RKNPU_JOB_ASYNC;
+		if (job->in_fence) {
+			rknpu_job_defer_on_fence(job);
+			return 0;
+		}
 		rknpu_job_timeout_clean(rknpu_dev, job->args->core_mask);
 		rknpu_job_schedule(job);
 		ret = job->ret;
@@ -836,6 +1326,13 @@ static int rknpu_submit(struct rknpu_device *rknpu_dev,
 	return ret;
 }
 
+/* blocking submit of a job built in the kernel, for the debugger bench */
+int rknpu_submit_kernel(struct rknpu_device *rknpu_dev,
+			struct rknpu_submit *args)
+{
+	return rknpu_submit(rknpu_dev, NULL, args, NULL);
+}
+
 #ifdef CONFIG_ROCKCHIP_RKNPU_DRM_GEM
 int rknpu_submit_ioctl(struct drm_device *dev, void *data,
 		       struct drm_file *file_priv)
@@ -845,12 +1342,13 @@ int rknpu_submit_ioctl(struct drm_device *dev, void *data,
 
 	rknpu_iommu_switch_domain(rknpu_dev, args->iommu_domain_id);
 
-	return rknpu_submit(rknpu_dev, args);
+	return rknpu_submit(rknpu_dev, file_priv->driver_priv, args, NULL);
 }
 #endif
 
 #ifdef CONFIG_ROCKCHIP_RKNPU_DMA_HEAP
-int rknpu_submit_ioctl(struct rknpu_device *rknpu_dev, unsigned long data)
+int rknpu_submit_ioctl(struct rknpu_device *rknpu_dev, struct file *file,
+		       unsigned long data)
 {
 	struct rknpu_submit args;
 	int ret = -EINVAL;
@@ -862,7 +1360,7 @@ int rknpu_submit_ioctl(struct rknpu_device *rknpu_dev, unsigned long data)
 		return ret;
 	}
 
-	ret = rknpu_submit(rknpu_dev, &args);
+	ret = rknpu_submit(rknpu_dev, file->private_data, &args, NULL);
 
 	if (unlikely(copy_to_user((struct rknpu_submit *)data, &args,
 				  sizeof(struct rknpu_submit)))) {
@@ -875,6 +1373,187 @@ int rknpu_submit_ioctl(struct rknpu_device *rknpu_dev, unsigned long data)
 }
 #endif
 
+static int rknpu_ring_submit(struct rknpu_device *rknpu_dev,
+			     struct rknpu_session *session,
+			     struct rknpu_ring_submit *args)
+{
+#ifdef CONFIG_ROCKCHIP_RKNPU_DRM_GEM
+	struct rknpu_gem_object *ring_obj =
+		(struct rknpu_gem_object *)(uintptr_t)args->ring_obj_addr;
+#endif
+#ifdef CONFIG_ROCKCHIP_RKNPU_DMA_HEAP
+	struct rknpu_mem_object *ring_obj =
+		(struct rknpu_mem_object *)(uintptr_t)args->ring_obj_addr;
+#endif
+	struct rknpu_ring_header *header = NULL;
+	struct rknpu_ring_sqe *sqes = NULL;
+	struct rknpu_ring_sqe sqe;
+	struct rknpu_ring_ctx ring;
+	uint32_t sq_entries, cq_entries, head, tail;
+	size_t ring_size;
+	long wait_ret;
+	int ret = 0;
+
+	args->submitted = 0;
+
+	if (!ring_obj || !ring_obj->kv_addr) {
+		LOG_ERROR("invalid rknpu ring object!\n");
+		return -EINVAL;
+	}
+
+	header = (struct rknpu_ring_header *)ring_obj->kv_addr;
+	sq_entries = READ_ONCE(header->sq_entries);
+	cq_entries = READ_ONCE(header->cq_entries);
+	if (!is_power_of_2(sq_entries) || !is_power_of_2(cq_entries)) {
+		LOG_ERROR("invalid rknpu ring entries, sq: %u, cq: %u\n",
+			  sq_entries, cq_entries);
+		return -EINVAL;
+	}
+
+	ring_size = sizeof(*header) +
+		    (size_t)sq_entries * sizeof(struct rknpu_ring_sqe) +
+		    (size_t)cq_entries * sizeof(struct rknpu_ring_cqe);
+	if (ring_size > ring_obj->size) {
+		LOG_ERROR("rknpu ring size %zu exceeds object size %lu\n",
+			  ring_size, ring_obj->size);
+		return -EINVAL;
+	}
+
+	sqes = (struct rknpu_ring_sqe *)(header + 1);
+
+	ring.obj = ring_obj;
+	ring.header = header;
+	ring.cqes = (struct rknpu_ring_cqe *)(sqes + sq_entries);
+	ring.cq_entries = cq_entries;
+
+	mutex_lock(&rknpu_dev->ring_submit_lock);
+
+	head = header->sq_head;
+	tail = smp_load_acquire(&header->sq_tail);
+	while (head != tail && args->submitted < args->to_submit) {
+		struct rknpu_ring_sqe *entry = &sqes[head & (sq_entries - 1)];
+
+		/* snapshot the entry, userspace may rewrite it at any time */
+		memcpy(&sqe, entry, sizeof(sqe));
+		sqe.submit.flags |= RKNPU_JOB_NONBLOCK;
+		if (!(sqe.submit.flags & RKNPU_JOB_FENCE_IN))
+			sqe.submit.fence_fd = -1;
+
+		ring.user_data = sqe.user_data;
+		ring.attached = false;
+
+		rknpu_iommu_switch_domain(rknpu_dev,
+					  sqe.submit.iommu_domain_id);
+
+		ret = rknpu_submit(rknpu_dev, session, &sqe.submit, &ring);
+		if (ret && !ring.attached)
+			rknpu_ring_post_cqe(rknpu_dev, &ring, ret, -1, 0);
+
+		entry->submit.fence_fd = sqe.submit.fence_fd;
+
+		head++;
+		args->submitted++;
+	}
+	smp_store_release(&header->sq_head, head);
+
+	mutex_unlock(&rknpu_dev->ring_submit_lock);
+
+	if (args->min_complete == 0)
+		return 0;
+
+	wait_ret = wait_event_interruptible_timeout(
+		rknpu_dev->ring_wq,
+		smp_load_acquire(&header->cq_tail) -
+				READ_ONCE(header->cq_head) >=
+			min(args->min_complete, cq_entries),
+		msecs_to_jiffies(args->timeout));
+	if (wait_ret < 0)
+		return wait_ret;
+
+	return wait_ret == 0 ? -ETIMEDOUT : 0;
+}
+
+#ifdef CONFIG_ROCKCHIP_RKNPU_DRM_GEM
+int rknpu_ring_submit_ioctl(struct drm_device *dev, void *data,
+			    struct drm_file *file_priv)
+{
+	struct rknpu_device *rknpu_dev = dev_get_drvdata(dev->dev);
+
+	return rknpu_ring_submit(rknpu_dev, file_priv->driver_priv, data);
+}
+#endif
+
+#ifdef CONFIG_ROCKCHIP_RKNPU_DMA_HEAP
+int rknpu_ring_submit_ioctl(struct rknpu_device *rknpu_dev, struct file *file,
+			    unsigned long data)
+{
+	struct rknpu_ring_submit args;
+	int ret = -EINVAL;
+
+	if (unlikely(copy_from_user(&args, (struct rknpu_ring_submit *)data,
+				    sizeof(struct rknpu_ring_submit)))) {
+		LOG_ERROR("%s: copy_from_user failed\n", __func__);
+		ret = -EFAULT;
+		return ret;
+	}
+
+	ret = rknpu_ring_submit(rknpu_dev, file->private_data, &args);
+
+	if (unlikely(copy_to_user((struct rknpu_ring_submit *)data, &args,
+				  sizeof(struct rknpu_ring_submit)))) {
+		LOG_ERROR("%s: copy_to_user failed\n", __func__);
+		ret = -EFAULT;
+		return ret;
+	}
+
+	return ret;
+}
+#endif
+
+static void rknpu_session_get_stats(struct rknpu_session *session,
+				    struct rknpu_session_stats *stats)
+{
+	struct rknpu_device *rknpu_dev = session->rknpu_dev;
+	unsigned long flags;
+
+	spin_lock_irqsave(&rknpu_dev->irq_lock, flags);
+	*stats = session->stats;
+	spin_unlock_irqrestore(&rknpu_dev->irq_lock, flags);
+}
+
+#ifdef CONFIG_ROCKCHIP_RKNPU_DRM_GEM
+int rknpu_session_stats_ioctl(struct drm_device *dev, void *data,
+			      struct drm_file *file_priv)
+{
+	struct rknpu_session *session = file_priv->driver_priv;
+
+	if (!session)
+		return -EINVAL;
+
+	rknpu_session_get_stats(session, data);
+
+	return 0;
+}
+#endif
+
+#ifdef CONFIG_ROCKCHIP_RKNPU_DMA_HEAP
+int rknpu_session_stats_ioctl(struct rknpu_device *rknpu_dev,
+			      struct file *file, unsigned long data)
+{
+	struct rknpu_session_stats stats;
+
+	rknpu_session_get_stats(file->private_data, &stats);
+
+	if (unlikely(copy_to_user((struct rknpu_session_stats *)data, &stats,
+				  sizeof(struct rknpu_session_stats)))) {
+		LOG_ERROR("%s: copy_to_user failed\n", __func__);
+		return -EFAULT;
+	}
+
+	return 0;
+}
+#endif
+
 int rknpu_get_hw_version(struct rknpu_device *rknpu_dev, uint32_t *version)
 {
 	void __iomem *rknpu_core_base = rknpu_dev->base[0];
@@ -977,23 +1656,23 @@ int rknpu_clear_rw_amount(struct rknpu_device *rknpu_dev)
 		spin_unlock(&rknpu_dev->lock);
 	}
 
+	/* the session accounting samples against the cleared counters */
+	spin_lock_irqsave(&rknpu_dev->irq_lock, flags);
+	memset(rknpu_dev->last_rw_amount, 0,
+	       sizeof(rknpu_dev->last_rw_amount));
+	spin_unlock_irqrestore(&rknpu_dev->irq_lock, flags);
+
 	return 0;
 }
 
-int rknpu_get_rw_amount(struct rknpu_device *rknpu_dev, uint32_t *dt_wr,
-			uint32_t *dt_rd, uint32_t *wd_rd)
+static void rknpu_read_rw_amount(struct rknpu_device *rknpu_dev,
+				 uint32_t *dt_wr, uint32_t *dt_rd,
+				 uint32_t *wd_rd)
 {
 	void __iomem *rknpu_core_base = rknpu_dev->base[0];
 	const struct rknpu_config *config = rknpu_dev->config;
 	int amount_scale = config->pc_data_amount_scale;
 
-	if (config->amount_top == NULL) {
-		LOG_WARN("Get rw_amount is not supported on this device!\n");
-		return 0;
-	}
-
-	spin_lock(&rknpu_dev->lock);
-
 	if (dt_wr != NULL) {
 		*dt_wr = REG_READ(config->amount_top->offset_dt_wr) *
 			 amount_scale;
@@ -1020,7 +1699,20 @@ int rknpu_get_rw_amount(struct rknpu_device *rknpu_dev, uint32_t *dt_wr,
 				  amount_scale;
 		}
 	}
+}
 
+int rknpu_get_rw_amount(struct rknpu_device *rknpu_dev, uint32_t *dt_wr,
+			uint32_t *dt_rd, uint32_t *wd_rd)
+{
+	const struct rknpu_config *config = rknpu_dev->config;
+
+	if (config->amount_top == NULL) {
+		LOG_WARN("Get rw_amount is not supported on this device!\n");
+		return 0;
+	}
+
+	spin_lock(&rknpu_dev->lock);
+	rknpu_read_rw_amount(rknpu_dev, dt_wr, dt_rd, wd_rd);
 	spin_unlock(&rknpu_dev->lock);
 
 	return 0;
@@ -303,12 +303,14 @@ static void __maybe_unused rknpu_dma_buf_sync(
 
 int rknpu_mem_sync_ioctl(struct rknpu_device *rknpu_dev, unsigned long data)
 {
+	struct rknpu_mem_sync_range ranges[RKNPU_MEM_SYNC_MAX_RANGES];
 	struct rknpu_mem_object *rknpu_obj = NULL;
 	struct rknpu_mem_sync args;
 #ifdef CONFIG_DMABUF_PARTIAL
 	struct dma_buf *dmabuf;
 #endif
 	int ret = -EFAULT;
+	int num = 0, i = 0;
 
 	if (unlikely(copy_from_user(&args, (struct rknpu_mem_sync *)data,
 				    sizeof(struct rknpu_mem_sync)))) {
@@ -326,24 +328,40 @@ int rknpu_mem_sync_ioctl(struct rknpu_device *rknpu_dev, unsigned long data)
 
 	rknpu_obj = (struct rknpu_mem_object *)(uintptr_t)args.obj_addr;
 
+	/* nothing is ever dirty in the cpu caches */
+	if (dev_is_dma_coherent(rknpu_dev->dev))
+		return 0;
+
+	num = rknpu_mem_sync_get_ranges(&args, rknpu_obj->size, ranges);
+	if (num < 0)
+		return num;
+
 #ifndef CONFIG_DMABUF_PARTIAL
-	if (args.flags & RKNPU_MEM_SYNC_TO_DEVICE) {
-		rknpu_dma_buf_sync(rknpu_dev, rknpu_obj, args.offset, args.size,
-				   DMA_TO_DEVICE, false);
-	}
-	if (args.flags & RKNPU_MEM_SYNC_FROM_DEVICE) {
-		rknpu_dma_buf_sync(rknpu_dev, rknpu_obj, args.offset, args.size,
-				   DMA_FROM_DEVICE, true);
+	for (i = 0; i < num; i++) {
+		if (args.flags & RKNPU_MEM_SYNC_TO_DEVICE) {
+			rknpu_dma_buf_sync(rknpu_dev, rknpu_obj,
+					   ranges[i].offset, ranges[i].size,
+					   DMA_TO_DEVICE, false);
+		}
+		if (args.flags & RKNPU_MEM_SYNC_FROM_DEVICE) {
+			rknpu_dma_buf_sync(rknpu_dev, rknpu_obj,
+					   ranges[i].offset, ranges[i].size,
+					   DMA_FROM_DEVICE, true);
+		}
 	}
 #else
 	dmabuf = rknpu_obj->dmabuf;
-	if (args.flags & RKNPU_MEM_SYNC_TO_DEVICE) {
-		dmabuf->ops->end_cpu_access_partial(dmabuf, DMA_TO_DEVICE,
-						    args.offset, args.size);
-	}
-	if (args.flags & RKNPU_MEM_SYNC_FROM_DEVICE) {
-		dmabuf->ops->begin_cpu_access_partial(dmabuf, DMA_FROM_DEVICE,
-						      args.offset, args.size);
+	for (i = 0; i < num; i++) {
+		if (args.flags & RKNPU_MEM_SYNC_TO_DEVICE) {
+			dmabuf->ops->end_cpu_access_partial(
+				dmabuf, DMA_TO_DEVICE, ranges[i].offset,
+				ranges[i].size);
+		}
+		if (args.flags & RKNPU_MEM_SYNC_FROM_DEVICE) {
+			dmabuf->ops->begin_cpu_access_partial(
+				dmabuf, DMA_FROM_DEVICE, ranges[i].offset,
+				ranges[i].size);
+		}
 	}
 #endif
 
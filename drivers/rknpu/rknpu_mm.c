@@ -171,6 +171,40 @@ int rknpu_mm_free(struct rknpu_mm *mm, struct rknpu_mm_obj *mm_obj)
 	return 0;
 }
 
+/* size of the largest run of free chunks */
+unsigned int rknpu_mm_max_free_size(struct rknpu_mm *mm)
+{
+	unsigned int start = 0, end = 0, max_chunks = 0;
+
+	mutex_lock(&mm->lock);
+	start = find_first_zero_bit(mm->bitmap, mm->total_chunks);
+	while (start < mm->total_chunks) {
+		end = find_next_bit(mm->bitmap, mm->total_chunks, start);
+		if (end - start > max_chunks)
+			max_chunks = end - start;
+		start = find_next_zero_bit(mm->bitmap, mm->total_chunks, end);
+	}
+	mutex_unlock(&mm->lock);
+
+	return max_chunks * mm->chunk_size;
+}
+
+void rknpu_mm_account(struct rknpu_mm *mm, unsigned int request_size,
+		      unsigned int alloc_size)
+{
+	mutex_lock(&mm->lock);
+	mm->request_count++;
+	if (alloc_size == 0)
+		mm->fallback_count++;
+	else if (alloc_size < request_size)
+		mm->partial_count++;
+	else
+		mm->full_count++;
+	mm->request_bytes += request_size;
+	mm->alloc_bytes += alloc_size;
+	mutex_unlock(&mm->lock);
+}
+
 int rknpu_mm_dump(struct seq_file *m, void *data)
 {
 	struct rknpu_debugger_node *node = m->private;
@@ -234,5 +268,13 @@ int rknpu_mm_dump(struct seq_file *m, void *data)
 		   rknpu_dev->sram_size, rknpu_dev->sram_size - free_size,
 		   free_size);
 
+	seq_printf(
+		m,
+		"SRAM requests: %lu, full: %lu, partial: %lu, fallback: %lu\n",
+		mm->request_count, mm->full_count, mm->partial_count,
+		mm->fallback_count);
+	seq_printf(m, "SRAM requested bytes: %lu, placed bytes: %lu\n",
+		   mm->request_bytes, mm->alloc_bytes);
+
 	return 0;
 }
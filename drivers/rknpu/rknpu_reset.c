@@ -6,6 +6,8 @@
 
 #include <linux/delay.h>
 #include <linux/iommu.h>
+#include <linux/ktime.h>
+#include <soc/rockchip/rockchip_iommu.h>
 
 #include "rknpu_reset.h"
 
@@ -25,6 +27,33 @@ static inline struct reset_control *rknpu_reset_control_get(struct device *dev,
 }
 #endif
 
+#ifndef FPGA_PLATFORM
+/*
+ * Cores can be reset on their own when the reset lines are grouped per
+ * core and named after it, e.g. srst_a0, srst_h0, srst_a1, srst_h1, ...
+ */
+static int rknpu_reset_per_core(struct rknpu_device *rknpu_dev, int num_srsts)
+{
+	int num_cores = rknpu_dev->config->num_irqs;
+	const char *name = NULL;
+	int per_core = 0;
+	int i = 0;
+
+	if (num_cores <= 1 || num_srsts % num_cores)
+		return 0;
+
+	per_core = num_srsts / num_cores;
+	for (i = 0; i < num_srsts; ++i) {
+		if (of_property_read_string_index(rknpu_dev->dev->of_node,
+						  "reset-names", i, &name) ||
+		    !*name || name[strlen(name) - 1] != '0' + i / per_core)
+			return 0;
+	}
+
+	return per_core;
+}
+#endif
+
 int rknpu_reset_get(struct rknpu_device *rknpu_dev)
 {
 #ifndef FPGA_PLATFORM
@@ -54,6 +83,7 @@ int rknpu_reset_get(struct rknpu_device *rknpu_dev)
 	}
 
 	rknpu_dev->num_srsts = num_srsts;
+	rknpu_dev->srsts_per_core = rknpu_reset_per_core(rknpu_dev, num_srsts);
 
 	return num_srsts;
 #endif
@@ -93,6 +123,16 @@ static int rknpu_reset_deassert(struct reset_control *rst)
 
 	return 0;
 }
+
+static void rknpu_reset_account(struct rknpu_device *rknpu_dev, ktime_t start)
+{
+	struct rknpu_reset_stats *stats = &rknpu_dev->reset_stats;
+	u64 us = ktime_us_delta(ktime_get(), start);
+
+	stats->last_us = us;
+	stats->max_us = max(stats->max_us, us);
+	stats->total_us += us;
+}
 #endif
 
 int rknpu_soft_reset(struct rknpu_device *rknpu_dev)
@@ -100,6 +140,7 @@ int rknpu_soft_reset(struct rknpu_device *rknpu_dev)
 #ifndef FPGA_PLATFORM
 	struct iommu_domain *domain = NULL;
 	struct rknpu_subcore_data *subcore_data = NULL;
+	ktime_t start = ktime_get();
 	int ret = 0, i = 0;
 
 	if (rknpu_dev->bypass_soft_reset) {
@@ -148,8 +189,101 @@ int rknpu_soft_reset(struct rknpu_device *rknpu_dev)
 
 	rknpu_dev->soft_reseting = false;
 
+	rknpu_dev->reset_stats.full_count++;
+	rknpu_reset_account(rknpu_dev, start);
+
 	mutex_unlock(&rknpu_dev->reset_lock);
 #endif
 
 	return 0;
 }
+
+/*
+ * Reset only the cores in @core_mask, jobs running on the other cores are
+ * left alone. Falls back to rknpu_soft_reset() if the SoC has no per core
+ * reset lines or all cores are affected anyway.
+ */
+int rknpu_core_reset(struct rknpu_device *rknpu_dev, uint32_t core_mask)
+{
+#ifndef FPGA_PLATFORM
+	int num_cores = rknpu_dev->config->num_irqs;
+	int per_core = rknpu_dev->srsts_per_core;
+	struct iommu_domain *domain = NULL;
+	ktime_t start;
+	unsigned long flags;
+	int ret = 0, i = 0, j = 0;
+
+	core_mask &= GENMASK(num_cores - 1, 0);
+	if (!per_core || core_mask == GENMASK(num_cores - 1, 0))
+		return rknpu_soft_reset(rknpu_dev);
+
+	if (rknpu_dev->bypass_soft_reset) {
+		LOG_WARN("bypass soft reset\n");
+		return 0;
+	}
+
+	mutex_lock(&rknpu_dev->reset_lock);
+	start = ktime_get();
+
+	spin_lock_irqsave(&rknpu_dev->irq_lock, flags);
+	for (i = 0; i < num_cores; ++i) {
+		if (core_mask & BIT(i))
+			rknpu_dev->subcore_datas[i].resetting = true;
+	}
+	spin_unlock_irqrestore(&rknpu_dev->irq_lock, flags);
+
+	LOG_INFO("core reset, mask: %#x\n", core_mask);
+
+	for (i = 0; i < num_cores; ++i) {
+		if (!(core_mask & BIT(i)))
+			continue;
+		for (j = 0; j < per_core; ++j)
+			ret |= rknpu_reset_assert(
+				rknpu_dev->srsts[i * per_core + j]);
+	}
+
+	udelay(10);
+
+	for (i = 0; i < num_cores; ++i) {
+		if (!(core_mask & BIT(i)))
+			continue;
+		for (j = 0; j < per_core; ++j)
+			ret |= rknpu_reset_deassert(
+				rknpu_dev->srsts[i * per_core + j]);
+	}
+
+	udelay(10);
+
+	/* the iommu is shared by all cores, only reattach if it was lost */
+	if (!ret && rknpu_dev->iommu_en &&
+	    !rockchip_iommu_is_enabled(rknpu_dev->dev)) {
+		domain = iommu_get_domain_for_dev(rknpu_dev->dev);
+		if (domain) {
+			iommu_detach_device(domain, rknpu_dev->dev);
+			iommu_attach_device(domain, rknpu_dev->dev);
+		}
+	}
+
+	spin_lock_irqsave(&rknpu_dev->irq_lock, flags);
+	for (i = 0; i < num_cores; ++i) {
+		if (core_mask & BIT(i)) {
+			rknpu_dev->subcore_datas[i].resetting = false;
+			rknpu_dev->reset_stats.core_count[i]++;
+		}
+	}
+	spin_unlock_irqrestore(&rknpu_dev->irq_lock, flags);
+
+	rknpu_reset_account(rknpu_dev, start);
+
+	mutex_unlock(&rknpu_dev->reset_lock);
+
+	if (ret) {
+		LOG_DEV_ERROR(rknpu_dev->dev,
+			      "failed to reset rknpu cores %#x: %d\n",
+			      core_mask, ret);
+		return rknpu_soft_reset(rknpu_dev);
+	}
+#endif
+
+	return 0;
+}
@@ -0,0 +1,367 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Rockchip AMP Shared Memory Ring Transport.
+ *
+ * Zero copy single producer single consumer rings between Linux and a
+ * remote (RTOS) core, for streams such as sensor data where the rpmsg
+ * copy and per message interrupt cost too much. The doorbell uses the
+ * same softirq scheme as rockchip_rpmsg_softirq.c.
+ *
+ * Copyright (c) 2023 Rockchip Electronics Co. Ltd.
+ */
+
+#include <linux/err.h>
+#include <linux/interrupt.h>
+#include <linux/io.h>
+#include <linux/irq.h>
+#include <linux/kernel.h>
+#include <linux/module.h>
+#include <linux/of.h>
+#include <linux/of_platform.h>
+#include <linux/platform_device.h>
+#include <linux/rpmsg/rockchip_shm_ring.h>
+#include <linux/slab.h>
+#include <linux/spinlock.h>
+
+struct rk_shm_ring_dir {
+	struct rk_shm_ring_ctrl *ctrl;
+	void *slots;
+	/* local copy of the index this side owns */
+	u32 pos;
+};
+
+struct rk_shm_ring {
+	struct platform_device *pdev;
+	u32 slot_size;
+	u32 slot_num;
+	struct rk_shm_ring_dir rx;
+	struct rk_shm_ring_dir tx;
+	/* last consumer wait value the doorbell was rung for */
+	u32 tx_kicked_wait;
+	/* serializes the producer side for rk_shm_ring_send() users */
+	spinlock_t tx_lock;
+	/* protects rx_cb and rx_priv */
+	spinlock_t rx_lock;
+	rk_shm_ring_rx_cb_t rx_cb;
+	void *rx_priv;
+	u32 rx_wait;
+	int irq_tx;
+	int irq_rx;
+};
+
+static struct rk_shm_ring_slot *rk_shm_ring_slot(struct rk_shm_ring *ring,
+						 struct rk_shm_ring_dir *dir, u32 pos)
+{
+	return dir->slots + (pos & (ring->slot_num - 1)) * ring->slot_size;
+}
+
+static void rk_shm_ring_kick(struct rk_shm_ring *ring)
+{
+	struct irq_chip *chip = irq_get_chip(ring->irq_tx);
+
+	if (chip && chip->irq_retrigger)
+		chip->irq_retrigger(irq_get_irq_data(ring->irq_tx));
+}
+
+static irqreturn_t rk_shm_ring_rx_irq(int irq, void *data)
+{
+	struct rk_shm_ring *ring = data;
+	struct rk_shm_ring_dir *rx = &ring->rx;
+	u32 payload = RK_SHM_RING_SLOT_PAYLOAD(ring->slot_size);
+	struct rk_shm_ring_slot *slot;
+	u32 head, len;
+
+	do {
+		WRITE_ONCE(rx->ctrl->wait, 0);
+
+		while ((head = READ_ONCE(rx->ctrl->head)) != rx->pos) {
+			/* read the slots only after seeing the new head */
+			dma_rmb();
+
+			spin_lock(&ring->rx_lock);
+			for (; rx->pos != head; rx->pos++) {
+				slot = rk_shm_ring_slot(ring, rx, rx->pos);
+				len = READ_ONCE(slot->len);
+				if (len > payload) {
+					dev_warn_ratelimited(&ring->pdev->dev,
+							     "drop bad slot len %u\n", len);
+					continue;
+				}
+				if (ring->rx_cb)
+					ring->rx_cb(ring->rx_priv, slot->data, len);
+			}
+			spin_unlock(&ring->rx_lock);
+
+			/* hand the slots back in one go, once they are consumed */
+			mb();
+			WRITE_ONCE(rx->ctrl->tail, rx->pos);
+		}
+
+		/* a new wait value per sleep, 0 means running */
+		if (!++ring->rx_wait)
+			ring->rx_wait = 1;
+		WRITE_ONCE(rx->ctrl->wait, ring->rx_wait);
+		/* publish wait before the last look at head */
+		mb();
+	} while (READ_ONCE(rx->ctrl->head) != rx->pos);
+
+	return IRQ_HANDLED;
+}
+
+/**
+ * rk_shm_ring_tx_reserve - get the next free tx slot
+ * @ring: the ring
+ * @max_len: returns the payload size of the slot
+ *
+ * The caller fills the returned buffer in place and passes it on with
+ * rk_shm_ring_tx_commit(). There is a single producer: calls must be
+ * serialized by the caller.
+ *
+ * Return: the slot payload, or NULL if the ring is full.
+ */
+void *rk_shm_ring_tx_reserve(struct rk_shm_ring *ring, u32 *max_len)
+{
+	struct rk_shm_ring_dir *tx = &ring->tx;
+
+	if (tx->pos - READ_ONCE(tx->ctrl->tail) >= ring->slot_num)
+		return NULL;
+
+	/* the consumer must be done with the slot before we write it */
+	mb();
+
+	if (max_len)
+		*max_len = RK_SHM_RING_SLOT_PAYLOAD(ring->slot_size);
+
+	return rk_shm_ring_slot(ring, tx, tx->pos)->data;
+}
+EXPORT_SYMBOL(rk_shm_ring_tx_reserve);
+
+/**
+ * rk_shm_ring_tx_commit - pass the reserved slot to the remote
+ * @ring: the ring
+ * @len: bytes written to the slot payload
+ *
+ * The doorbell is only rung if the remote went to sleep since the last
+ * one, so back to back commits cost no interrupt.
+ */
+void rk_shm_ring_tx_commit(struct rk_shm_ring *ring, u32 len)
+{
+	struct rk_shm_ring_dir *tx = &ring->tx;
+	u32 wait;
+
+	WRITE_ONCE(rk_shm_ring_slot(ring, tx, tx->pos)->len, len);
+	/* slot contents before the new head */
+	dma_wmb();
+	WRITE_ONCE(tx->ctrl->head, ++tx->pos);
+	/* new head before looking at the consumer state */
+	mb();
+
+	wait = READ_ONCE(tx->ctrl->wait);
+	if (wait && wait != ring->tx_kicked_wait) {
+		ring->tx_kicked_wait = wait;
+		rk_shm_ring_kick(ring);
+	}
+}
+EXPORT_SYMBOL(rk_shm_ring_tx_commit);
+
+int rk_shm_ring_send(struct rk_shm_ring *ring, const void *data, u32 len)
+{
+	unsigned long flags;
+	u32 max_len;
+	void *buf;
+	int ret = 0;
+
+	spin_lock_irqsave(&ring->tx_lock, flags);
+	buf = rk_shm_ring_tx_reserve(ring, &max_len);
+	if (!buf) {
+		ret = -EAGAIN;
+	} else if (len > max_len) {
+		ret = -EMSGSIZE;
+	} else {
+		memcpy(buf, data, len);
+		rk_shm_ring_tx_commit(ring, len);
+	}
+	spin_unlock_irqrestore(&ring->tx_lock, flags);
+
+	return ret;
+}
+EXPORT_SYMBOL(rk_shm_ring_send);
+
+/**
+ * rk_shm_ring_set_rx_cb - set the receive callback
+ * @ring: the ring
+ * @cb: called from the irq thread for each message, NULL to stop
+ * @priv: passed to @cb
+ *
+ * @cb runs under a spinlock and must not sleep. @data points into the
+ * shared memory and is only valid until @cb returns.
+ */
+int rk_shm_ring_set_rx_cb(struct rk_shm_ring *ring, rk_shm_ring_rx_cb_t cb, void *priv)
+{
+	spin_lock_irq(&ring->rx_lock);
+	ring->rx_cb = cb;
+	ring->rx_priv = priv;
+	spin_unlock_irq(&ring->rx_lock);
+
+	return 0;
+}
+EXPORT_SYMBOL(rk_shm_ring_set_rx_cb);
+
+/**
+ * rk_shm_ring_get - get the ring referenced by a device
+ * @dev: device with a "rockchip,shm-ring" phandle
+ *
+ * Return: the ring, ERR_PTR(-EPROBE_DEFER) if it is not probed yet.
+ */
+struct rk_shm_ring *rk_shm_ring_get(struct device *dev)
+{
+	struct platform_device *pdev;
+	struct device_node *np;
+	struct rk_shm_ring *ring;
+
+	np = of_parse_phandle(dev->of_node, "rockchip,shm-ring", 0);
+	if (!np)
+		return ERR_PTR(-ENODEV);
+
+	pdev = of_find_device_by_node(np);
+	of_node_put(np);
+	if (!pdev)
+		return ERR_PTR(-EPROBE_DEFER);
+
+	ring = platform_get_drvdata(pdev);
+	if (!ring) {
+		put_device(&pdev->dev);
+		return ERR_PTR(-EPROBE_DEFER);
+	}
+
+	return ring;
+}
+EXPORT_SYMBOL(rk_shm_ring_get);
+
+void rk_shm_ring_put(struct rk_shm_ring *ring)
+{
+	rk_shm_ring_set_rx_cb(ring, NULL, NULL);
+	put_device(&ring->pdev->dev);
+}
+EXPORT_SYMBOL(rk_shm_ring_put);
+
+static void rk_shm_ring_init_dir(struct rk_shm_ring *ring,
+				 struct rk_shm_ring_dir *dir, void *base)
+{
+	dir->ctrl = base;
+	dir->slots = base + sizeof(struct rk_shm_ring_ctrl);
+	dir->pos = 0;
+
+	WRITE_ONCE(dir->ctrl->head, 0);
+	WRITE_ONCE(dir->ctrl->tail, 0);
+	WRITE_ONCE(dir->ctrl->wait, 0);
+	WRITE_ONCE(dir->ctrl->slot_size, ring->slot_size);
+	WRITE_ONCE(dir->ctrl->slot_num, ring->slot_num);
+}
+
+static int rockchip_shm_ring_probe(struct platform_device *pdev)
+{
+	struct device *dev = &pdev->dev;
+	struct rk_shm_ring *ring;
+	struct resource *res;
+	size_t ring_size;
+	void *base;
+	int ret;
+
+	ring = devm_kzalloc(dev, sizeof(*ring), GFP_KERNEL);
+	if (!ring)
+		return -ENOMEM;
+
+	ring->pdev = pdev;
+	spin_lock_init(&ring->tx_lock);
+	spin_lock_init(&ring->rx_lock);
+
+	if (device_property_read_u32(dev, "rockchip,slot-size", &ring->slot_size))
+		ring->slot_size = RK_SHM_RING_SLOT_SIZE;
+	if (device_property_read_u32(dev, "rockchip,slot-num", &ring->slot_num))
+		ring->slot_num = RK_SHM_RING_SLOT_NUM;
+
+	if (!IS_ALIGNED(ring->slot_size, RK_SHM_RING_CACHELINE) ||
+	    !is_power_of_2(ring->slot_num)) {
+		dev_err(dev, "slot size %u must be cache line aligned, slot num %u a power of 2\n",
+			ring->slot_size, ring->slot_num);
+		return -EINVAL;
+	}
+
+	res = platform_get_resource(pdev, IORESOURCE_MEM, 0);
+	if (!res)
+		return -ENOMEM;
+
+	ring_size = RK_SHM_RING_SIZE(ring->slot_size, ring->slot_num);
+	if (resource_size(res) < 2 * ring_size) {
+		dev_err(dev, "Too small memory size %x!\n", (u32)resource_size(res));
+		return -EINVAL;
+	}
+
+	/* the remote is not cache coherent with us */
+	base = devm_memremap(dev, res->start, 2 * ring_size, MEMREMAP_WC);
+	if (IS_ERR(base))
+		return PTR_ERR(base);
+
+	rk_shm_ring_init_dir(ring, &ring->rx, base);
+	rk_shm_ring_init_dir(ring, &ring->tx, base + ring_size);
+
+	ring->irq_tx = platform_get_irq(pdev, 0);
+	if (ring->irq_tx < 0)
+		return ring->irq_tx;
+
+	ring->irq_rx = platform_get_irq(pdev, 1);
+	if (ring->irq_rx < 0)
+		return ring->irq_rx;
+
+	ret = devm_request_threaded_irq(dev, ring->irq_rx, NULL, rk_shm_ring_rx_irq,
+					IRQF_ONESHOT, "rockchip-shm-ring", ring);
+	if (ret) {
+		dev_err(dev, "could not install irq\n");
+		return ret;
+	}
+
+	/* the remote waits for the magic before using the rings */
+	dma_wmb();
+	WRITE_ONCE(ring->rx.ctrl->magic, RK_SHM_RING_MAGIC);
+	WRITE_ONCE(ring->tx.ctrl->magic, RK_SHM_RING_MAGIC);
+	mb();
+	rk_shm_ring_kick(ring);
+
+	platform_set_drvdata(pdev, ring);
+
+	dev_info(dev, "%u slots of %u bytes per direction at %pa\n",
+		 ring->slot_num, ring->slot_size, &res->start);
+
+	return 0;
+}
+
+static int rockchip_shm_ring_remove(struct platform_device *pdev)
+{
+	struct rk_shm_ring *ring = platform_get_drvdata(pdev);
+
+	WRITE_ONCE(ring->rx.ctrl->magic, 0);
+	WRITE_ONCE(ring->tx.ctrl->magic, 0);
+
+	return 0;
+}
+
+static const struct of_device_id rockchip_shm_ring_match[] = {
+	{ .compatible = "rockchip,amp-shm-ring", },
+	{ /* sentinel */ },
+};
+
+MODULE_DEVICE_TABLE(of, rockchip_shm_ring_match);
+
+static struct platform_driver rockchip_shm_ring_driver = {
+	.probe = rockchip_shm_ring_probe,
+	.remove = rockchip_shm_ring_remove,
+	.driver = {
+		.name = "rockchip-shm-ring",
+		.of_match_table = rockchip_shm_ring_match,
+	},
+};
+module_platform_driver(rockchip_shm_ring_driver);
+
+MODULE_LICENSE("GPL");
+MODULE_DESCRIPTION("Rockchip AMP Shared Memory Ring Transport");
@@ -0,0 +1,164 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Rockchip AMP Shared Memory Ring Test.
+ *
+ * Sends MSG_LIMIT timestamped messages to the remote, which is expected
+ * to echo each one back unchanged, then reports the round trip latency
+ * and the echoed throughput.
+ *
+ * Copyright (c) 2023 Rockchip Electronics Co. Ltd.
+ */
+
+#include <linux/completion.h>
+#include <linux/delay.h>
+#include <linux/kernel.h>
+#include <linux/kthread.h>
+#include <linux/ktime.h>
+#include <linux/module.h>
+#include <linux/of.h>
+#include <linux/platform_device.h>
+#include <linux/rpmsg/rockchip_shm_ring.h>
+
+#define MSG_LIMIT	100000
+
+static unsigned int msg_size = 64;
+module_param(msg_size, uint, 0444);
+MODULE_PARM_DESC(msg_size, "Test message size in bytes");
+
+struct rk_shm_ring_test_msg {
+	u32 seq;
+	u32 reserved;
+	u64 send_ns;
+};
+
+struct rk_shm_ring_test {
+	struct device *dev;
+	struct rk_shm_ring *ring;
+	struct task_struct *task;
+	struct completion done;
+	u32 rx_count;
+	u64 rtt_min_ns;
+	u64 rtt_max_ns;
+	u64 rtt_sum_ns;
+};
+
+static void rockchip_shm_ring_test_cb(void *priv, const void *data, u32 len)
+{
+	const struct rk_shm_ring_test_msg *msg = data;
+	struct rk_shm_ring_test *test = priv;
+	u64 rtt_ns;
+
+	if (len < sizeof(*msg) || test->rx_count >= MSG_LIMIT)
+		return;
+
+	rtt_ns = ktime_get_ns() - msg->send_ns;
+	test->rtt_min_ns = min(test->rtt_min_ns, rtt_ns);
+	test->rtt_max_ns = max(test->rtt_max_ns, rtt_ns);
+	test->rtt_sum_ns += rtt_ns;
+
+	if (++test->rx_count == MSG_LIMIT)
+		complete(&test->done);
+}
+
+static int rockchip_shm_ring_test_thread(void *data)
+{
+	struct rk_shm_ring_test *test = data;
+	struct rk_shm_ring_test_msg *msg;
+	u32 seq = 0, max_len;
+	ktime_t start;
+	s64 elapsed_us;
+
+	start = ktime_get();
+	while (seq < MSG_LIMIT && !kthread_should_stop()) {
+		/* only this thread produces, no locking needed */
+		msg = rk_shm_ring_tx_reserve(test->ring, &max_len);
+		if (!msg) {
+			usleep_range(10, 20);
+			continue;
+		}
+
+		msg->seq = seq++;
+		msg->send_ns = ktime_get_ns();
+		rk_shm_ring_tx_commit(test->ring, clamp_t(u32, msg_size, sizeof(*msg), max_len));
+	}
+
+	if (!wait_for_completion_timeout(&test->done, msecs_to_jiffies(10000))) {
+		dev_err(test->dev, "timeout, %u of %u messages echoed\n",
+			test->rx_count, MSG_LIMIT);
+		goto out;
+	}
+
+	elapsed_us = ktime_us_delta(ktime_get(), start);
+	dev_info(test->dev, "%u msgs of %u bytes in %lld us, %llu KB/s\n",
+		 MSG_LIMIT, msg_size, elapsed_us,
+		 div64_u64((u64)MSG_LIMIT * msg_size * 1000, max_t(s64, elapsed_us, 1)) * 1000 / 1024);
+	dev_info(test->dev, "round trip min %llu avg %llu max %llu ns\n",
+		 test->rtt_min_ns, div_u64(test->rtt_sum_ns, MSG_LIMIT),
+		 test->rtt_max_ns);
+
+out:
+	while (!kthread_should_stop())
+		schedule_timeout_interruptible(MAX_SCHEDULE_TIMEOUT);
+
+	return 0;
+}
+
+static int rockchip_shm_ring_test_probe(struct platform_device *pdev)
+{
+	struct device *dev = &pdev->dev;
+	struct rk_shm_ring_test *test;
+
+	test = devm_kzalloc(dev, sizeof(*test), GFP_KERNEL);
+	if (!test)
+		return -ENOMEM;
+
+	test->dev = dev;
+	test->rtt_min_ns = U64_MAX;
+	init_completion(&test->done);
+
+	test->ring = rk_shm_ring_get(dev);
+	if (IS_ERR(test->ring))
+		return PTR_ERR(test->ring);
+
+	rk_shm_ring_set_rx_cb(test->ring, rockchip_shm_ring_test_cb, test);
+	platform_set_drvdata(pdev, test);
+
+	test->task = kthread_run(rockchip_shm_ring_test_thread, test, "shm-ring-test");
+	if (IS_ERR(test->task)) {
+		rk_shm_ring_put(test->ring);
+		return PTR_ERR(test->task);
+	}
+
+	return 0;
+}
+
+static int rockchip_shm_ring_test_remove(struct platform_device *pdev)
+{
+	struct rk_shm_ring_test *test = platform_get_drvdata(pdev);
+
+	kthread_stop(test->task);
+	rk_shm_ring_put(test->ring);
+	dev_info(&pdev->dev, "rockchip shm ring test is removed\n");
+
+	return 0;
+}
+
+static const struct of_device_id rockchip_shm_ring_test_match[] = {
+	{ .compatible = "rockchip,amp-shm-ring-test", },
+	{ /* sentinel */ },
+};
+
+MODULE_DEVICE_TABLE(of, rockchip_shm_ring_test_match);
+
+static struct platform_driver rockchip_shm_ring_test_driver = {
+	.probe = rockchip_shm_ring_test_probe,
+	.remove = rockchip_shm_ring_test_remove,
+	.driver = {
+		.name = "rockchip-shm-ring-test",
+		.of_match_table = rockchip_shm_ring_test_match,
+	},
+};
+module_platform_driver(rockchip_shm_ring_test_driver);
+
+MODULE_LICENSE("GPL");
+MODULE_DESCRIPTION("Rockchip AMP Shared Memory Ring Test");
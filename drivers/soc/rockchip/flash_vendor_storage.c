@@ -111,9 +111,10 @@ static int flash_vendor_read(u32 id, void *pbuf, u32 size)
 	return (-1);
 }
 
-static int flash_vendor_write(u32 id, void *pbuf, u32 size)
+/* Update an item in the in-memory copy only, see flash_vendor_commit() */
+static int flash_vendor_update(u32 id, void *pbuf, u32 size)
 {
-	u32 i, j, next_index, align_size, alloc_size, item_num;
+	u32 i, j, align_size, alloc_size, item_num;
 	u32 offset, next_size;
 	u8 *p_data;
 	struct vendor_item *item;
@@ -125,7 +126,6 @@ static int flash_vendor_write(u32 id, void *pbuf, u32 size)
 	p_data = g_vendor->data;
 	item_num = g_vendor->item_num;
 	align_size = ALIGN(size, 0x40); /* align to 64 bytes*/
-	next_index = g_vendor->next_index;
 	for (i = 0; i < item_num; i++) {
 		item = &g_vendor->item[i];
 		if (item->id == id) {
@@ -161,15 +161,6 @@ static int flash_vendor_write(u32 id, void *pbuf, u32 size)
 				       size);
 				g_vendor->item[i].size = size;
 			}
-			g_vendor->version++;
-			g_vendor->version2 = g_vendor->version;
-			g_vendor->next_index++;
-			if (g_vendor->next_index >= FLASH_VENDOR_PART_NUM)
-				g_vendor->next_index = 0;
-			_flash_write(FLASH_VENDOR_PART_START +
-					FLASH_VENDOR_PART_SIZE * next_index,
-					FLASH_VENDOR_PART_SIZE,
-					g_vendor);
 			return 0;
 		}
 	}
@@ -184,21 +175,41 @@ static int flash_vendor_write(u32 id, void *pbuf, u32 size)
 		g_vendor->free_size -= align_size;
 		memcpy(&g_vendor->data[item->offset], pbuf, size);
 		g_vendor->item_num++;
-		g_vendor->version++;
-		g_vendor->next_index++;
-		g_vendor->version2 = g_vendor->version;
-		if (g_vendor->next_index >= FLASH_VENDOR_PART_NUM)
-			g_vendor->next_index = 0;
-		_flash_write(FLASH_VENDOR_PART_START +
-				FLASH_VENDOR_PART_SIZE * next_index,
-				FLASH_VENDOR_PART_SIZE,
-			g_vendor);
 		return 0;
 	}
 
 	return(-1);
 }
 
+static int flash_vendor_commit(void)
+{
+	u32 next_index;
+
+	if (!g_vendor)
+		return -1;
+
+	next_index = g_vendor->next_index;
+	g_vendor->version++;
+	g_vendor->version2 = g_vendor->version;
+	g_vendor->next_index++;
+	if (g_vendor->next_index >= FLASH_VENDOR_PART_NUM)
+		g_vendor->next_index = 0;
+	return _flash_write(FLASH_VENDOR_PART_START +
+			    FLASH_VENDOR_PART_SIZE * next_index,
+			    FLASH_VENDOR_PART_SIZE,
+			    g_vendor);
+}
+
+static int flash_vendor_write(u32 id, void *pbuf, u32 size)
+{
+	int ret;
+
+	ret = flash_vendor_update(id, pbuf, size);
+	if (ret)
+		return ret;
+	return flash_vendor_commit();
+}
+
 #if (FLASH_VENDOR_TEST)
 static void print_hex(char *s, void *buf, int width, int len)
 {
@@ -316,6 +327,8 @@ static int vendor_init_thread(void *arg)
 		ret = misc_register(&vender_storage_dev);
 		#ifdef CONFIG_ROCKCHIP_VENDOR_STORAGE
 		rk_vendor_register(flash_vendor_read, flash_vendor_write);
+		rk_vendor_register_writeback(flash_vendor_update,
+					     flash_vendor_commit);
 		#endif
 	}
 	pr_info("flash vendor storage:20170308 ret = %d\n", ret);
@@ -331,6 +344,9 @@ static int __init vendor_storage_init(void)
 static __exit void vendor_storage_deinit(void)
 {
 	if (g_vendor) {
+		#ifdef CONFIG_ROCKCHIP_VENDOR_STORAGE
+		rk_vendor_flush();
+		#endif
 		misc_deregister(&vender_storage_dev);
 		kfree(g_vendor);
 		g_vendor = NULL;
@@ -202,7 +202,8 @@ static int mtd_vendor_read(u32 id, void *pbuf, u32 size)
 	return (-1);
 }
 
-static int mtd_vendor_write(u32 id, void *pbuf, u32 size)
+/* Update an item in the in-memory copy only, see mtd_vendor_commit() */
+static int mtd_vendor_update(u32 id, void *pbuf, u32 size)
 {
 	u32 i, j, align_size, alloc_size, item_num;
 	u32 offset, next_size;
@@ -250,9 +251,6 @@ static int mtd_vendor_write(u32 id, void *pbuf, u32 size)
 				       size);
 				g_vendor->item[i].size = size;
 			}
-			g_vendor->version++;
-			g_vendor->version2 = g_vendor->version;
-			mtd_vendor_nand_write();
 			return 0;
 		}
 	}
@@ -266,14 +264,54 @@ static int mtd_vendor_write(u32 id, void *pbuf, u32 size)
 		g_vendor->free_size -= align_size;
 		memcpy(&g_vendor->data[item->offset], pbuf, size);
 		g_vendor->item_num++;
-		g_vendor->version++;
-		g_vendor->version2 = g_vendor->version;
-		mtd_vendor_nand_write();
 		return 0;
 	}
 	return(-1);
 }
 
+static int mtd_vendor_commit(void)
+{
+	if (!g_vendor)
+		return -ENOMEM;
+
+	g_vendor->version++;
+	g_vendor->version2 = g_vendor->version;
+	return mtd_vendor_nand_write();
+}
+
+static int mtd_vendor_write(u32 id, void *pbuf, u32 size)
+{
+	int ret;
+
+	ret = mtd_vendor_update(id, pbuf, size);
+	if (ret)
+		return ret;
+	return mtd_vendor_commit();
+}
+
+/* Write-back entry points, serialised against the ioctl path */
+static int mtd_vendor_update_locked(u32 id, void *pbuf, u32 size)
+{
+	int ret;
+
+	mutex_lock(&vendor_ops_mutex);
+	ret = mtd_vendor_update(id, pbuf, size);
+	mutex_unlock(&vendor_ops_mutex);
+
+	return ret;
+}
+
+static int mtd_vendor_commit_locked(void)
+{
+	int ret;
+
+	mutex_lock(&vendor_ops_mutex);
+	ret = mtd_vendor_commit();
+	mutex_unlock(&vendor_ops_mutex);
+
+	return ret;
+}
+
 static int vendor_storage_open(struct inode *inode, struct file *file)
 {
 	return 0;
@@ -383,6 +421,8 @@ static int vendor_storage_probe(struct platform_device *pdev)
 
 	ret = misc_register(&vendor_storage_dev);
 	rk_vendor_register(mtd_vendor_read, mtd_vendor_write);
+	rk_vendor_register_writeback(mtd_vendor_update_locked,
+				     mtd_vendor_commit_locked);
 
 	pr_err("mtd vendor storage:20200313 ret = %d\n", ret);
 
@@ -392,6 +432,7 @@ static int vendor_storage_probe(struct platform_device *pdev)
 static int vendor_storage_remove(struct platform_device *pdev)
 {
 	if (g_vendor) {
+		rk_vendor_flush();
 		misc_deregister(&vendor_storage_dev);
 		g_vendor = NULL;
 	}
@@ -6,6 +6,7 @@
  */
 
 #include <linux/module.h>
+#include <linux/debugfs.h>
 #include <linux/io.h>
 #include <linux/iopoll.h>
 #include <linux/err.h>
@@ -22,6 +23,9 @@
 #include <linux/panic_notifier.h>
 #include <linux/pm_runtime.h>
 #include <linux/regulator/consumer.h>
+#include <linux/seq_file.h>
+#include <linux/sysfs.h>
+#include <linux/workqueue.h>
 #include <linux/rockchip/cpu.h>
 #include <soc/rockchip/pm_domains.h>
 #include <soc/rockchip/rockchip_dmc.h>
@@ -100,6 +104,37 @@ struct rockchip_pmu_info {
 
 #define SHAPING_NBPKTMAX0	0x0
 
+static const u32 qos_reg_offset[MAX_QOS_REGS_NUM] = {
+	[ROCKCHIP_QOS_PRIORITY] = QOS_PRIORITY,
+	[ROCKCHIP_QOS_MODE] = QOS_MODE,
+	[ROCKCHIP_QOS_BANDWIDTH] = QOS_BANDWIDTH,
+	[ROCKCHIP_QOS_SATURATION] = QOS_SATURATION,
+	[ROCKCHIP_QOS_EXTCONTROL] = QOS_EXTCONTROL,
+};
+
+#define PD_LAT_HIST_NUM		6
+
+/* upper bounds of the latency histogram buckets, the last one is open */
+static const u32 pd_lat_hist_us[PD_LAT_HIST_NUM - 1] = { 10, 50, 100, 500, 1000 };
+
+struct rockchip_pd_stats {
+	bool is_on;
+	u64 on_count;
+	u64 off_count;
+	u64 denied_count;
+	u64 on_time_ns;
+	ktime_t on_since;
+	ktime_t off_since;
+	/* running averages, updated on every transition */
+	u64 on_latency_ns;
+	u64 off_latency_ns;
+	u64 idle_ns;
+	u64 on_latency_max_ns;
+	u64 off_latency_max_ns;
+	u64 on_hist[PD_LAT_HIST_NUM];
+	u64 off_hist[PD_LAT_HIST_NUM];
+};
+
 struct rockchip_pm_domain {
 	struct generic_pm_domain genpd;
 	const struct rockchip_domain_info *info;
@@ -120,10 +155,18 @@ struct rockchip_pm_domain {
 	bool is_qos_need_init;
 	bool is_shaping_need_init;
 	struct regulator *supply;
+	struct rockchip_pd_stats stats;
+	struct delayed_work gov_work;
+	bool gov_retry;
+	/* runtime qos values, applied on top of the saved/DT ones */
+	u32 qos_override[MAX_QOS_REGS_NUM];
+	unsigned long qos_override_mask;
+	struct kobject *qos_kobj;
 };
 
 struct rockchip_pmu {
 	struct device *dev;
+	struct kobject *qos_kobj;
 	struct regmap *regmap;
 	const struct rockchip_pmu_info *info;
 	struct mutex mutex; /* mutex lock for pmu */
@@ -138,6 +181,12 @@ module_param_named(always_on, pm_domain_always_on, bool, 0644);
 MODULE_PARM_DESC(always_on,
 		 "Always keep pm domains power on except for system suspend.");
 
+static unsigned int pd_break_even_ratio = 10;
+
+module_param_named(break_even_ratio, pd_break_even_ratio, uint, 0644);
+MODULE_PARM_DESC(break_even_ratio,
+		 "Keep a domain on while its recent idle periods are shorter than this many times its on + off latency, 0 to disable.");
+
 #if 0
 #define NAME_LEN 20
 
@@ -748,6 +797,16 @@ static int rockchip_pmu_restore_qos(struct rockchip_pm_domain *pd)
 	return rockchip_pmu_restore_shaping(pd);
 }
 
+static void rockchip_pmu_apply_qos_override(struct rockchip_pm_domain *pd)
+{
+	int i, reg;
+
+	for_each_set_bit(reg, &pd->qos_override_mask, MAX_QOS_REGS_NUM)
+		for (i = 0; i < pd->num_qos; i++)
+			regmap_write(pd->qos_regmap[i], qos_reg_offset[reg],
+				     pd->qos_override[reg]);
+}
+
 static void rockchip_pmu_init_qos(struct rockchip_pm_domain *pd)
 {
 	int i;
@@ -829,6 +888,7 @@ int rockchip_restore_qos(struct device *dev)
 
 	rockchip_pmu_lock(pd);
 	ret = rockchip_pmu_restore_qos(pd);
+	rockchip_pmu_apply_qos_override(pd);
 	rockchip_pmu_unlock(pd);
 
 	return ret;
@@ -974,11 +1034,57 @@ static int rockchip_do_pmu_set_power_domain(struct rockchip_pm_domain *pd,
 	return ret;
 }
 
+static u64 rockchip_pd_avg(u64 avg, u64 val)
+{
+	return avg ? (avg * 3 + val) >> 2 : val;
+}
+
+static void rockchip_pd_hist_add(u64 *hist, u64 lat_ns)
+{
+	int i;
+
+	for (i = 0; i < PD_LAT_HIST_NUM - 1; i++)
+		if (lat_ns < pd_lat_hist_us[i] * NSEC_PER_USEC)
+			break;
+	hist[i]++;
+}
+
+/* Called with the pmu lock held, after a successful power transition. */
+static void rockchip_pd_update_stats(struct rockchip_pm_domain *pd,
+				     bool power_on, ktime_t start)
+{
+	struct rockchip_pd_stats *st = &pd->stats;
+	ktime_t now = ktime_get();
+	u64 lat_ns = ktime_to_ns(ktime_sub(now, start));
+
+	if (power_on) {
+		st->on_count++;
+		st->on_latency_ns = rockchip_pd_avg(st->on_latency_ns, lat_ns);
+		st->on_latency_max_ns = max(st->on_latency_max_ns, lat_ns);
+		rockchip_pd_hist_add(st->on_hist, lat_ns);
+		if (st->off_since)
+			st->idle_ns = rockchip_pd_avg(st->idle_ns,
+						      ktime_to_ns(ktime_sub(start, st->off_since)));
+		st->on_since = now;
+	} else {
+		st->off_count++;
+		st->off_latency_ns = rockchip_pd_avg(st->off_latency_ns, lat_ns);
+		st->off_latency_max_ns = max(st->off_latency_max_ns, lat_ns);
+		rockchip_pd_hist_add(st->off_hist, lat_ns);
+		if (st->is_on)
+			st->on_time_ns += ktime_to_ns(ktime_sub(now, st->on_since));
+		st->off_since = now;
+	}
+	st->is_on = power_on;
+	pd->gov_retry = false;
+}
+
 static int rockchip_pd_power(struct rockchip_pm_domain *pd, bool power_on)
 {
 	struct rockchip_pmu *pmu = pd->pmu;
 	int ret = 0;
 	struct generic_pm_domain *genpd = &pd->genpd;
+	ktime_t start;
 
 	if (pm_domain_always_on && !power_on)
 		return 0;
@@ -991,6 +1097,8 @@ static int rockchip_pd_power(struct rockchip_pm_domain *pd, bool power_on)
 	rockchip_pmu_lock(pd);
 
 	if (rockchip_pmu_domain_is_on(pd) != power_on) {
+		start = ktime_get();
+
 		if (IS_ERR_OR_NULL(pd->supply) &&
 		    PTR_ERR(pd->supply) != -ENODEV)
 			pd->supply = devm_regulator_get_optional(pd->pmu->dev,
@@ -1051,6 +1159,7 @@ static int rockchip_pd_power(struct rockchip_pm_domain *pd, bool power_on)
 				rockchip_pmu_restore_qos(pd);
 			if (pd->is_qos_need_init || pd->is_shaping_need_init)
 				rockchip_pmu_init_qos(pd);
+			rockchip_pmu_apply_qos_override(pd);
 		}
 
 out:
@@ -1059,6 +1168,9 @@ static int rockchip_pd_power(struct rockchip_pm_domain *pd, bool power_on)
 
 		if (!power_on && !IS_ERR(pd->supply))
 			ret = regulator_disable(pd->supply);
+
+		if (!ret)
+			rockchip_pd_update_stats(pd, power_on, start);
 	}
 
 	rockchip_pmu_unlock(pd);
@@ -1085,6 +1197,48 @@ static int rockchip_pd_power_off(struct generic_pm_domain *domain)
 	return rockchip_pd_power(pd, false);
 }
 
+static u64 rockchip_pd_break_even_ns(struct rockchip_pm_domain *pd)
+{
+	return (pd->stats.on_latency_ns + pd->stats.off_latency_ns) *
+		READ_ONCE(pd_break_even_ratio);
+}
+
+/*
+ * Bouncing a domain costs its on/off latency plus the qos save/restore in
+ * rockchip_pd_power(), which is wasted when the domain is needed again
+ * right away. If the recent idle periods were shorter than the break even
+ * time keep the domain on, and only power it off once it has stayed idle
+ * for that long.
+ */
+static bool rockchip_pd_power_down_ok(struct dev_pm_domain *domain)
+{
+	struct rockchip_pm_domain *pd = to_rockchip_pd(pd_to_genpd(domain));
+	u64 break_even_ns = rockchip_pd_break_even_ns(pd);
+
+	if (pd->gov_retry || !pd->stats.idle_ns || pd->stats.idle_ns >= break_even_ns)
+		return true;
+
+	pd->stats.denied_count++;
+	mod_delayed_work(system_wq, &pd->gov_work,
+			 usecs_to_jiffies(div_u64(break_even_ns, NSEC_PER_USEC)));
+
+	return false;
+}
+
+static void rockchip_pd_gov_work(struct work_struct *work)
+{
+	struct rockchip_pm_domain *pd = container_of(to_delayed_work(work),
+						     struct rockchip_pm_domain,
+						     gov_work);
+
+	pd->gov_retry = true;
+	queue_work(pm_wq, &pd->genpd.power_off_work);
+}
+
+static struct dev_power_governor rockchip_pd_gov = {
+	.power_down_ok = rockchip_pd_power_down_ok,
+};
+
 int rockchip_pmu_pd_on(struct device *dev)
 {
 	struct generic_pm_domain *genpd;
@@ -1144,6 +1298,50 @@ bool rockchip_pmu_pd_is_on(struct device *dev)
 }
 EXPORT_SYMBOL(rockchip_pmu_pd_is_on);
 
+static int rockchip_pd_set_qos(struct rockchip_pm_domain *pd,
+			       enum rockchip_pmu_qos_reg reg, u32 val)
+{
+	int i;
+
+	if (reg >= MAX_QOS_REGS_NUM)
+		return -EINVAL;
+
+	if (!pd->num_qos)
+		return -ENODEV;
+
+	rockchip_pmu_lock(pd);
+	pd->qos_override[reg] = val;
+	set_bit(reg, &pd->qos_override_mask);
+	/* a domain that is off picks the value up on its next power on */
+	if (rockchip_pmu_domain_is_on(pd))
+		for (i = 0; i < pd->num_qos; i++)
+			regmap_write(pd->qos_regmap[i], qos_reg_offset[reg], val);
+	rockchip_pmu_unlock(pd);
+
+	return 0;
+}
+
+/*
+ * Change one qos register of every AXI master port in the power domain of
+ * @dev. The value is kept across power domain cycles until changed again.
+ */
+int rockchip_pmu_set_qos(struct device *dev, enum rockchip_pmu_qos_reg reg,
+			 u32 val)
+{
+	struct generic_pm_domain *genpd;
+
+	if (IS_ERR_OR_NULL(dev))
+		return -EINVAL;
+
+	if (IS_ERR_OR_NULL(dev->pm_domain))
+		return -EINVAL;
+
+	genpd = pd_to_genpd(dev->pm_domain);
+
+	return rockchip_pd_set_qos(to_rockchip_pd(genpd), reg, val);
+}
+EXPORT_SYMBOL(rockchip_pmu_set_qos);
+
 static int rockchip_pd_attach_dev(struct generic_pm_domain *genpd,
 				  struct device *dev)
 {
@@ -1503,7 +1701,11 @@ static int rockchip_pm_add_one_domain(struct rockchip_pmu *pmu,
 	}
 	rockchip_pd_qos_init(pd);
 
-	pm_genpd_init(&pd->genpd, NULL, !rockchip_pmu_domain_is_on(pd));
+	INIT_DELAYED_WORK(&pd->gov_work, rockchip_pd_gov_work);
+	pd->stats.is_on = rockchip_pmu_domain_is_on(pd);
+	if (pd->stats.is_on)
+		pd->stats.on_since = ktime_get();
+	pm_genpd_init(&pd->genpd, &rockchip_pd_gov, !pd->stats.is_on);
 
 	pmu->genpd_data.domains[id] = &pd->genpd;
 	return 0;
@@ -1529,6 +1731,8 @@ static void rockchip_pm_remove_one_domain(struct rockchip_pm_domain *pd)
 	if (ret < 0)
 		dev_err(pd->pmu->dev, "failed to remove domain '%s' : %d - state may be inconsistent\n",
 			pd->genpd.name, ret);
+	cancel_delayed_work_sync(&pd->gov_work);
+	kobject_put(pd->qos_kobj);
 
 	clk_bulk_unprepare(pd->num_clks, pd->clks);
 	clk_bulk_put(pd->num_clks, pd->clks);
@@ -1541,6 +1745,133 @@ static void rockchip_pm_remove_one_domain(struct rockchip_pm_domain *pd)
 	/* devm will free our memory */
 }
 
+struct rockchip_pd_qos_attr {
+	struct kobj_attribute attr;
+	enum rockchip_pmu_qos_reg reg;
+};
+
+static struct rockchip_pm_domain *rockchip_pd_from_qos_kobj(struct kobject *kobj)
+{
+	struct rockchip_pm_domain *pd;
+	int i;
+
+	for (i = 0; g_pmu && i < g_pmu->genpd_data.num_domains; i++) {
+		if (!g_pmu->genpd_data.domains[i])
+			continue;
+		pd = to_rockchip_pd(g_pmu->genpd_data.domains[i]);
+		if (pd->qos_kobj == kobj)
+			return pd;
+	}
+
+	return NULL;
+}
+
+static ssize_t rockchip_pd_qos_show(struct kobject *kobj,
+				    struct kobj_attribute *attr, char *buf)
+{
+	struct rockchip_pd_qos_attr *qattr =
+		container_of(attr, struct rockchip_pd_qos_attr, attr);
+	struct rockchip_pm_domain *pd = rockchip_pd_from_qos_kobj(kobj);
+	ssize_t len = 0;
+	u32 val;
+	int i;
+
+	if (!pd)
+		return -ENODEV;
+
+	rockchip_pmu_lock(pd);
+	for (i = 0; i < pd->num_qos; i++) {
+		if (rockchip_pmu_domain_is_on(pd))
+			regmap_read(pd->qos_regmap[i], qos_reg_offset[qattr->reg], &val);
+		else if (test_bit(qattr->reg, &pd->qos_override_mask))
+			val = pd->qos_override[qattr->reg];
+		else
+			val = pd->qos_save_regs[qattr->reg][i];
+		len += sysfs_emit_at(buf, len, "%s0x%x", i ? " " : "", val);
+	}
+	rockchip_pmu_unlock(pd);
+	len += sysfs_emit_at(buf, len, "\n");
+
+	return len;
+}
+
+static ssize_t rockchip_pd_qos_store(struct kobject *kobj,
+				     struct kobj_attribute *attr,
+				     const char *buf, size_t count)
+{
+	struct rockchip_pd_qos_attr *qattr =
+		container_of(attr, struct rockchip_pd_qos_attr, attr);
+	struct rockchip_pm_domain *pd = rockchip_pd_from_qos_kobj(kobj);
+	u32 val;
+	int ret;
+
+	if (!pd)
+		return -ENODEV;
+
+	ret = kstrtou32(buf, 0, &val);
+	if (ret)
+		return ret;
+
+	ret = rockchip_pd_set_qos(pd, qattr->reg, val);
+
+	return ret ? ret : count;
+}
+
+#define PD_QOS_ATTR(_name, _reg)					\
+static struct rockchip_pd_qos_attr pd_qos_attr_##_name = {		\
+	.attr = __ATTR(_name, 0644, rockchip_pd_qos_show,		\
+		       rockchip_pd_qos_store),				\
+	.reg = _reg,							\
+}
+
+PD_QOS_ATTR(priority, ROCKCHIP_QOS_PRIORITY);
+PD_QOS_ATTR(mode, ROCKCHIP_QOS_MODE);
+PD_QOS_ATTR(bandwidth, ROCKCHIP_QOS_BANDWIDTH);
+PD_QOS_ATTR(saturation, ROCKCHIP_QOS_SATURATION);
+PD_QOS_ATTR(extcontrol, ROCKCHIP_QOS_EXTCONTROL);
+
+static struct attribute *rockchip_pd_qos_attrs[] = {
+	&pd_qos_attr_priority.attr.attr,
+	&pd_qos_attr_mode.attr.attr,
+	&pd_qos_attr_bandwidth.attr.attr,
+	&pd_qos_attr_saturation.attr.attr,
+	&pd_qos_attr_extcontrol.attr.attr,
+	NULL,
+};
+
+static const struct attribute_group rockchip_pd_qos_group = {
+	.attrs = rockchip_pd_qos_attrs,
+};
+
+/* /sys/devices/.../power-controller/qos/<domain>/<register> */
+static void rockchip_pm_qos_sysfs_init(struct rockchip_pmu *pmu)
+{
+	struct rockchip_pm_domain *pd;
+	int i;
+
+	pmu->qos_kobj = kobject_create_and_add("qos", &pmu->dev->kobj);
+	if (!pmu->qos_kobj)
+		return;
+
+	for (i = 0; i < pmu->genpd_data.num_domains; i++) {
+		if (!pmu->genpd_data.domains[i])
+			continue;
+		pd = to_rockchip_pd(pmu->genpd_data.domains[i]);
+		if (!pd->num_qos)
+			continue;
+
+		pd->qos_kobj = kobject_create_and_add(pd->genpd.name, pmu->qos_kobj);
+		if (!pd->qos_kobj)
+			continue;
+		if (sysfs_create_group(pd->qos_kobj, &rockchip_pd_qos_group)) {
+			dev_warn(pmu->dev, "failed to create qos sysfs for '%s'\n",
+				 pd->genpd.name);
+			kobject_put(pd->qos_kobj);
+			pd->qos_kobj = NULL;
+		}
+	}
+}
+
 static void rockchip_pm_domain_cleanup(struct rockchip_pmu *pmu)
 {
 	struct generic_pm_domain *genpd;
@@ -1558,6 +1889,64 @@ static void rockchip_pm_domain_cleanup(struct rockchip_pmu *pmu)
 	/* devm will free our memory */
 }
 
+#ifdef CONFIG_DEBUG_FS
+static int rockchip_pd_stats_show(struct seq_file *s, void *data)
+{
+	struct rockchip_pmu *pmu = s->private;
+	struct rockchip_pm_domain *pd;
+	struct rockchip_pd_stats *st;
+	u64 on_time_ns;
+	int i, j;
+
+	seq_puts(s, "domain           on       off      denied   on_ms      on_us  off_us  max_on  max_off idle_us  break_even_us\n");
+	for (i = 0; i < pmu->genpd_data.num_domains; i++) {
+		if (!pmu->genpd_data.domains[i])
+			continue;
+		pd = to_rockchip_pd(pmu->genpd_data.domains[i]);
+		st = &pd->stats;
+
+		rockchip_pmu_lock(pd);
+		on_time_ns = st->on_time_ns;
+		if (st->is_on)
+			on_time_ns += ktime_to_ns(ktime_sub(ktime_get(), st->on_since));
+		seq_printf(s, "%-16s %-8llu %-8llu %-8llu %-10llu %-6llu %-7llu %-7llu %-8llu %-8llu %llu\n",
+			   pd->genpd.name, st->on_count, st->off_count,
+			   st->denied_count, div_u64(on_time_ns, NSEC_PER_MSEC),
+			   div_u64(st->on_latency_ns, NSEC_PER_USEC),
+			   div_u64(st->off_latency_ns, NSEC_PER_USEC),
+			   div_u64(st->on_latency_max_ns, NSEC_PER_USEC),
+			   div_u64(st->off_latency_max_ns, NSEC_PER_USEC),
+			   div_u64(st->idle_ns, NSEC_PER_USEC),
+			   div_u64(rockchip_pd_break_even_ns(pd), NSEC_PER_USEC));
+		for (j = 0; j < 2; j++) {
+			u64 *hist = j ? st->off_hist : st->on_hist;
+			int k;
+
+			seq_printf(s, "  %-3s latency:", j ? "off" : "on");
+			for (k = 0; k < PD_LAT_HIST_NUM - 1; k++)
+				seq_printf(s, " <%uus:%llu", pd_lat_hist_us[k], hist[k]);
+			seq_printf(s, " >=%uus:%llu\n", pd_lat_hist_us[k - 1], hist[k]);
+		}
+		rockchip_pmu_unlock(pd);
+	}
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(rockchip_pd_stats);
+
+static void rockchip_pd_debugfs_init(struct rockchip_pmu *pmu)
+{
+	struct dentry *root;
+
+	root = debugfs_create_dir("rockchip_pm_domains", NULL);
+	debugfs_create_file("stats", 0444, root, pmu, &rockchip_pd_stats_fops);
+}
+#else
+static inline void rockchip_pd_debugfs_init(struct rockchip_pmu *pmu)
+{
+}
+#endif
+
 static void rockchip_configure_pd_cnt(struct rockchip_pmu *pmu,
 				      u32 domain_reg_offset,
 				      unsigned int count)
@@ -1856,7 +2245,11 @@ static int rockchip_pm_domain_probe(struct platform_device *pdev)
 	atomic_notifier_chain_register(&panic_notifier_list,
 				       &pmu_panic_block);
 
+	rockchip_pd_debugfs_init(pmu);
+
 	g_pmu = pmu;
+	rockchip_pm_qos_sysfs_init(pmu);
+
 	return 0;
 
 err_out:
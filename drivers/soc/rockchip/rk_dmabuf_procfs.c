@@ -129,6 +129,36 @@ static int rk_dmabuf_dev_show(struct seq_file *s, void *v)
 	return dma_buf_get_each(rk_dmabuf_cb3, s);
 }
 
+#if IS_ENABLED(CONFIG_RK_DMABUF_DEBUG)
+static int rk_dmabuf_stats_cb(const struct dma_buf_owner_stats *stats,
+			      void *private)
+{
+	struct seq_file *s = private;
+	int i;
+
+	if (stats->tgid)
+		seq_printf(s, "%8d ", stats->tgid);
+	else
+		seq_printf(s, "%8s ", "-");
+	seq_printf(s, "%-16.16s %10lu KiB %10lu KiB %8lu ", stats->name,
+		   K(stats->size), K(stats->peak), stats->count);
+	for (i = 0; i < DMA_BUF_STATS_ORDERS; i++)
+		seq_printf(s, " %lu", stats->chunks[i]);
+	seq_puts(s, "\n");
+
+	return 0;
+}
+
+static int rk_dmabuf_stats_show(struct seq_file *s, void *v)
+{
+	seq_printf(s, "%8s %-16s %14s %14s %8s  %s\n\n",
+		   "PID", "NAME", "SIZE:KiB", "PEAK:KiB", "COUNT",
+		   "CHUNKS:ORDER0..");
+
+	return dma_buf_owner_stats_get_each(rk_dmabuf_stats_cb, s);
+}
+#endif
+
 static int rk_dmabuf_size_show(struct seq_file *s, void *v)
 {
 	seq_printf(s, "Total: %lu KiB\n", K(dma_buf_get_total_size()));
@@ -194,6 +224,9 @@ static int __init rk_dmabuf_init(void)
 	proc_create_single("sgt", 0, root, rk_dmabuf_sgt_show);
 	proc_create_single("dev", 0, root, rk_dmabuf_dev_show);
 	proc_create_single("size", 0, root, rk_dmabuf_size_show);
+#if IS_ENABLED(CONFIG_RK_DMABUF_DEBUG)
+	proc_create_single("stats", 0, root, rk_dmabuf_stats_show);
+#endif
 	proc_create("peak", 0644, root, &rk_dmabuf_peak_ops);
 
 	return 0;
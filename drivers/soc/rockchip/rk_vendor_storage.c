@@ -9,10 +9,30 @@
 
 #include <linux/kernel.h>
 #include <linux/module.h>
+#include <linux/mutex.h>
+#include <linux/reboot.h>
+#include <linux/workqueue.h>
 #include <linux/soc/rockchip/rk_vendor_storage.h>
 
 static int (*_vendor_read)(u32 id, void *pbuf, u32 size);
 static int (*_vendor_write)(u32 id, void *pbuf, u32 size);
+static int (*_vendor_update)(u32 id, void *pbuf, u32 size);
+static int (*_vendor_commit)(void);
+
+/*
+ * Buffered writes only update the backend's in-memory image. The image is
+ * committed to storage once, writeback_delay_ms after the first buffered
+ * write, so a burst of small updates costs a single storage write.
+ */
+static unsigned int writeback_delay_ms = 1000;
+module_param(writeback_delay_ms, uint, 0644);
+MODULE_PARM_DESC(writeback_delay_ms, "Delay before buffered items are written back");
+
+static DEFINE_MUTEX(vendor_wb_lock);
+static bool vendor_wb_dirty;
+
+static void rk_vendor_writeback_work(struct work_struct *work);
+static DECLARE_DELAYED_WORK(vendor_wb_work, rk_vendor_writeback_work);
 
 int rk_vendor_read(u32 id, void *pbuf, u32 size)
 {
@@ -24,12 +44,74 @@ EXPORT_SYMBOL(rk_vendor_read);
 
 int rk_vendor_write(u32 id, void *pbuf, u32 size)
 {
-	if (_vendor_write)
-		return _vendor_write(id, pbuf, size);
-	return -1;
+	int ret;
+
+	if (!_vendor_write)
+		return -1;
+
+	mutex_lock(&vendor_wb_lock);
+	ret = _vendor_write(id, pbuf, size);
+	/* a synchronous write commits any buffered items along with it */
+	if (!ret)
+		vendor_wb_dirty = false;
+	mutex_unlock(&vendor_wb_lock);
+
+	return ret;
 }
 EXPORT_SYMBOL(rk_vendor_write);
 
+int rk_vendor_write_buffered(u32 id, void *pbuf, u32 size)
+{
+	int ret;
+
+	if (!_vendor_update || !_vendor_commit)
+		return rk_vendor_write(id, pbuf, size);
+
+	mutex_lock(&vendor_wb_lock);
+	ret = _vendor_update(id, pbuf, size);
+	if (!ret && !vendor_wb_dirty) {
+		vendor_wb_dirty = true;
+		schedule_delayed_work(&vendor_wb_work,
+				      msecs_to_jiffies(writeback_delay_ms));
+	}
+	mutex_unlock(&vendor_wb_lock);
+
+	return ret;
+}
+EXPORT_SYMBOL(rk_vendor_write_buffered);
+
+static int rk_vendor_writeback(void)
+{
+	int ret = 0;
+
+	mutex_lock(&vendor_wb_lock);
+	if (vendor_wb_dirty) {
+		ret = _vendor_commit();
+		if (!ret)
+			vendor_wb_dirty = false;
+	}
+	mutex_unlock(&vendor_wb_lock);
+
+	return ret;
+}
+
+static void rk_vendor_writeback_work(struct work_struct *work)
+{
+	int ret;
+
+	ret = rk_vendor_writeback();
+	if (ret)
+		pr_err("vendor storage: writeback failed %d\n", ret);
+}
+
+int rk_vendor_flush(void)
+{
+	cancel_delayed_work_sync(&vendor_wb_work);
+
+	return rk_vendor_writeback();
+}
+EXPORT_SYMBOL(rk_vendor_flush);
+
 int rk_vendor_register(void *read, void *write)
 {
 	_vendor_read = read;
@@ -39,6 +121,15 @@ int rk_vendor_register(void *read, void *write)
 }
 EXPORT_SYMBOL(rk_vendor_register);
 
+int rk_vendor_register_writeback(void *update, void *commit)
+{
+	_vendor_update = update;
+	_vendor_commit = commit;
+
+	return 0;
+}
+EXPORT_SYMBOL(rk_vendor_register_writeback);
+
 bool is_rk_vendor_ready(void)
 {
 	if (_vendor_read)
@@ -47,4 +138,29 @@ bool is_rk_vendor_ready(void)
 }
 EXPORT_SYMBOL(is_rk_vendor_ready);
 
+static int rk_vendor_reboot_notify(struct notifier_block *nb,
+				   unsigned long action, void *data)
+{
+	rk_vendor_flush();
+
+	return NOTIFY_DONE;
+}
+
+static struct notifier_block rk_vendor_reboot_nb = {
+	.notifier_call = rk_vendor_reboot_notify,
+};
+
+static int __init rk_vendor_storage_init(void)
+{
+	return register_reboot_notifier(&rk_vendor_reboot_nb);
+}
+
+static void __exit rk_vendor_storage_exit(void)
+{
+	unregister_reboot_notifier(&rk_vendor_reboot_nb);
+	rk_vendor_flush();
+}
+
+module_init(rk_vendor_storage_init);
+module_exit(rk_vendor_storage_exit);
 MODULE_LICENSE("GPL");
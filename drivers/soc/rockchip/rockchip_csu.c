@@ -5,19 +5,37 @@
  */
 
 #include <linux/arm-smccc.h>
+#include <linux/debugfs.h>
+#include <linux/ktime.h>
 #include <linux/module.h>
 #include <linux/of.h>
 #include <linux/platform_device.h>
 #include <linux/rockchip/rockchip_sip.h>
 #include <linux/slab.h>
 #include <linux/string.h>
+#include <linux/workqueue.h>
 #include <soc/rockchip/rockchip_csu.h>
 
+/*
+ * While released, the CSU drops the bus clock on its own whenever the AXI
+ * port goes idle. A consumer holds it (rockchip_csu_disable()) to keep the
+ * full rate; the hold takes effect at once, the release after
+ * release_delay_ms so that short busy/idle cycles do not bounce through
+ * the firmware. wake_*_ns is how long the firmware takes to apply a hold.
+ */
 struct csu_bus {
 	unsigned int id;
 	unsigned int cfg_val;
 	unsigned int en_mask;
 	unsigned int disable_count;
+	bool held;
+	ktime_t last_change;
+	u64 held_ns;
+	u64 released_ns;
+	unsigned int hold_cnt;
+	u64 wake_last_ns;
+	u64 wake_max_ns;
+	struct delayed_work release_work;
 };
 
 struct csu_clk {
@@ -31,6 +49,8 @@ struct rockchip_csu {
 	struct csu_clk *clk;
 	unsigned int bus_cnt;
 	unsigned int clk_cnt;
+	unsigned int release_delay_ms;
+	struct dentry *debugfs;
 };
 
 static struct rockchip_csu *rk_csu;
@@ -81,10 +101,51 @@ struct csu_clk *rockchip_csu_get(struct device *dev, const char *name)
 }
 EXPORT_SYMBOL(rockchip_csu_get);
 
+static unsigned int csu_en_mask(struct csu_bus *bus)
+{
+	return bus->held ? bus->en_mask & CSU_EN_MASK : bus->en_mask;
+}
+
+/* Caller holds csu_lock */
+static int csu_apply(struct csu_bus *bus, bool hold)
+{
+	ktime_t now = ktime_get();
+	u64 delta = ktime_to_ns(ktime_sub(now, bus->last_change));
+	int ret;
+
+	if (bus->held)
+		bus->held_ns += delta;
+	else
+		bus->released_ns += delta;
+	bus->last_change = now;
+	bus->held = hold;
+
+	ret = rockchip_csu_sip_config(rk_csu->dev, bus->id, bus->cfg_val,
+				      csu_en_mask(bus));
+	if (hold) {
+		bus->wake_last_ns = ktime_to_ns(ktime_sub(ktime_get(), now));
+		bus->wake_max_ns = max(bus->wake_max_ns, bus->wake_last_ns);
+		bus->hold_cnt++;
+	}
+
+	return ret;
+}
+
+static void csu_release_work(struct work_struct *work)
+{
+	struct csu_bus *bus = container_of(to_delayed_work(work),
+					   struct csu_bus, release_work);
+
+	mutex_lock(&csu_lock);
+	if (rk_csu && !bus->disable_count && bus->held &&
+	    csu_apply(bus, false))
+		dev_err(rk_csu->dev, "csu sip config enable error\n");
+	mutex_unlock(&csu_lock);
+}
+
 static int csu_disable(struct csu_clk *clk, bool disable)
 {
 	struct csu_bus *bus = NULL;
-	unsigned int en_mask = 0;
 	int ret = 0;
 
 	if (IS_ERR_OR_NULL(clk))
@@ -102,12 +163,18 @@ static int csu_disable(struct csu_clk *clk, bool disable)
 	else if (bus->disable_count > 0)
 		bus->disable_count--;
 
-	if (bus->disable_count)
-		en_mask = bus->en_mask & CSU_EN_MASK;
-	else
-		en_mask = bus->en_mask;
-
-	ret = rockchip_csu_sip_config(rk_csu->dev, bus->id, bus->cfg_val, en_mask);
+	if (bus->disable_count) {
+		/* a queued release re-checks disable_count, no need to sync */
+		cancel_delayed_work(&bus->release_work);
+		if (!bus->held)
+			ret = csu_apply(bus, true);
+	} else if (bus->held) {
+		if (rk_csu->release_delay_ms)
+			mod_delayed_work(system_wq, &bus->release_work,
+					 msecs_to_jiffies(rk_csu->release_delay_ms));
+		else
+			ret = csu_apply(bus, false);
+	}
 	if (ret)
 		dev_err(rk_csu->dev, "csu sip config disable error\n");
 
@@ -148,9 +215,12 @@ int rockchip_csu_set_div(struct csu_clk *clk, unsigned int div)
 		div = CSU_MAX_DIV;
 	cfg_val = (bus->cfg_val & ~CSU_DIV_MASK) | ((div - 1) & CSU_DIV_MASK);
 
-	ret = rockchip_csu_sip_config(rk_csu->dev, bus->id, cfg_val, bus->en_mask);
+	/* keep the divider across holds and releases, and the current hold */
+	ret = rockchip_csu_sip_config(rk_csu->dev, bus->id, cfg_val, csu_en_mask(bus));
 	if (ret)
 		dev_err(rk_csu->dev, "csu sip config freq error\n");
+	else
+		bus->cfg_val = cfg_val;
 
 	mutex_unlock(&csu_lock);
 
@@ -310,6 +380,52 @@ static int rockchip_csu_bus_node(struct rockchip_csu *csu)
 	return 0;
 }
 
+#ifdef CONFIG_DEBUG_FS
+static int csu_summary_show(struct seq_file *s, void *data)
+{
+	struct rockchip_csu *csu = s->private;
+	struct csu_bus *bus;
+	u64 held_ns, released_ns, delta;
+	int i;
+
+	seq_puts(s, " bus  state     held(ms) released(ms)  holds wake_last(us) wake_max(us)\n");
+
+	mutex_lock(&csu_lock);
+	for (i = 0; i < csu->bus_cnt; i++) {
+		bus = &csu->bus[i];
+		held_ns = bus->held_ns;
+		released_ns = bus->released_ns;
+		delta = ktime_to_ns(ktime_sub(ktime_get(), bus->last_change));
+		if (bus->held)
+			held_ns += delta;
+		else
+			released_ns += delta;
+
+		seq_printf(s, "%4u  %-8s %10llu %12llu %6u %13llu %12llu\n",
+			   bus->id, bus->held ? "held" : "released",
+			   div_u64(held_ns, NSEC_PER_MSEC),
+			   div_u64(released_ns, NSEC_PER_MSEC), bus->hold_cnt,
+			   div_u64(bus->wake_last_ns, NSEC_PER_USEC),
+			   div_u64(bus->wake_max_ns, NSEC_PER_USEC));
+	}
+	mutex_unlock(&csu_lock);
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(csu_summary);
+
+static void rockchip_csu_debugfs_init(struct rockchip_csu *csu)
+{
+	csu->debugfs = debugfs_create_dir("csu", NULL);
+	debugfs_create_file("summary", 0444, csu->debugfs, csu,
+			    &csu_summary_fops);
+}
+#else
+static inline void rockchip_csu_debugfs_init(struct rockchip_csu *csu)
+{
+}
+#endif
+
 static const struct of_device_id rockchip_csu_of_match[] = {
 	{ .compatible = "rockchip,rk3562-csu", },
 	{ },
@@ -322,7 +438,7 @@ static int rockchip_csu_probe(struct platform_device *pdev)
 	struct device *dev = &pdev->dev;
 	struct device_node *np = dev->of_node;
 	struct rockchip_csu *csu;
-	int ret = 0;
+	int ret = 0, i;
 
 	csu = devm_kzalloc(dev, sizeof(*csu), GFP_KERNEL);
 	if (!csu)
@@ -333,18 +449,45 @@ static int rockchip_csu_probe(struct platform_device *pdev)
 
 	rockchip_csu_parse_clk(csu);
 
+	of_property_read_u32(np, "rockchip,release-delay-ms",
+			     &csu->release_delay_ms);
+
 	if (of_find_property(np, "rockchip,bus", NULL))
 		ret = rockchip_csu_bus_table(csu);
 	else
 		ret = rockchip_csu_bus_node(csu);
-	if (!ret)
-		rk_csu = csu;
+	if (ret)
+		return ret;
 
-	return ret;
+	for (i = 0; i < csu->bus_cnt; i++) {
+		csu->bus[i].last_change = ktime_get();
+		INIT_DELAYED_WORK(&csu->bus[i].release_work, csu_release_work);
+	}
+	rockchip_csu_debugfs_init(csu);
+	rk_csu = csu;
+
+	return 0;
+}
+
+static int rockchip_csu_remove(struct platform_device *pdev)
+{
+	struct rockchip_csu *csu = platform_get_drvdata(pdev);
+	int i;
+
+	mutex_lock(&csu_lock);
+	rk_csu = NULL;
+	mutex_unlock(&csu_lock);
+
+	for (i = 0; i < csu->bus_cnt; i++)
+		cancel_delayed_work_sync(&csu->bus[i].release_work);
+	debugfs_remove_recursive(csu->debugfs);
+
+	return 0;
 }
 
 static struct platform_driver rockchip_csu_driver = {
 	.probe	= rockchip_csu_probe,
+	.remove	= rockchip_csu_remove,
 	.driver = {
 		.name	= "rockchip,csu",
 		.of_match_table = rockchip_csu_of_match,
@@ -13,7 +13,9 @@
 
 #include <linux/dma-buf.h>
 #include <linux/dma-direct.h>
+#include <linux/dma-fence.h>
 #include <linux/dma-mapping.h>
+#include <linux/file.h>
 #include <linux/fs.h>
 #include <linux/ioctl.h>
 #include <linux/miscdevice.h>
@@ -21,20 +23,57 @@
 #include <linux/mutex.h>
 #include <linux/slab.h>
 #include <linux/soc/rockchip/rockchip_decompress.h>
+#include <linux/sync_file.h>
+#include <linux/workqueue.h>
 #include <uapi/linux/rk-decom.h>
 
 #define RK_DECOME_TIMEOUT	3 /* 3 seconds */
+#define RK_DECOM_MAX_JOBS	16 /* queued or unreaped jobs per file */
 
 struct rk_decom_dev {
 	struct miscdevice miscdev;
 	struct device *dev;
 	struct mutex mutex;
+	struct workqueue_struct *wq;
+	spinlock_t fence_lock;
+	u64 fence_context;
+	atomic64_t fence_seqno;
+};
+
+struct rk_decom_bufs {
+	struct sg_table *sg_tbl_in, *sg_tbl_out;
+	struct dma_buf *dma_buf_in, *dma_buf_out;
+	struct dma_buf_attachment *dma_attach_in, *dma_attach_out;
+};
+
+struct rk_decom_ctx {
+	struct rk_decom_dev *rk_decom;
+	spinlock_t lock;
+	struct list_head jobs;
+	unsigned int num_jobs;
+	u64 next_id;
+};
+
+struct rk_decom_job {
+	struct list_head node;
+	struct rk_decom_ctx *ctx;
+	struct work_struct work;
+	struct dma_fence *fence;
+	struct rk_decom_param param;
+	struct rk_decom_bufs bufs;
+	u64 id;
+	int status;
+	bool done;
 };
 
 static long rk_decom_misc_ioctl(struct file *fptr, unsigned int cmd, unsigned long arg);
+static int rk_decom_misc_open(struct inode *inode, struct file *fptr);
+static int rk_decom_misc_release(struct inode *inode, struct file *fptr);
 
 static const struct file_operations rk_decom_fops = {
 	.owner           = THIS_MODULE,
+	.open            = rk_decom_misc_open,
+	.release         = rk_decom_misc_release,
 	.unlocked_ioctl  = rk_decom_misc_ioctl,
 };
 
@@ -137,12 +176,26 @@ static int put_dmafd_sgtbl(struct device *dev, int dma_fd, enum dma_data_directi
 	return 0;
 }
 
-static int rk_decom_for_user(struct device *dev, struct rk_decom_param *param)
+static void rk_decom_put_bufs(struct device *dev, struct rk_decom_param *param,
+			      struct rk_decom_bufs *bufs)
+{
+	if (bufs->sg_tbl_in && bufs->dma_buf_in && bufs->dma_attach_in)
+		put_dmafd_sgtbl(dev, param->src_fd, DMA_TO_DEVICE,
+				bufs->sg_tbl_in, bufs->dma_attach_in, bufs->dma_buf_in);
+
+	if (bufs->sg_tbl_out && bufs->dma_buf_out && bufs->dma_attach_out)
+		put_dmafd_sgtbl(dev, param->dst_fd, DMA_FROM_DEVICE,
+				bufs->sg_tbl_out, bufs->dma_attach_out, bufs->dma_buf_out);
+
+	memset(bufs, 0, sizeof(*bufs));
+}
+
+static int rk_decom_get_bufs(struct device *dev, struct rk_decom_param *param,
+			     struct rk_decom_bufs *bufs)
 {
 	int ret;
-	struct sg_table *sg_tbl_in = NULL, *sg_tbl_out = NULL;
-	struct dma_buf *dma_buf_in = NULL, *dma_buf_out = NULL;
-	struct dma_buf_attachment *dma_attach_in = NULL, *dma_attach_out = NULL;
+
+	memset(bufs, 0, sizeof(*bufs));
 
 	if (param->mode != RK_GZIP_MOD && param->mode != RK_ZLIB_MOD) {
 		dev_err(dev, "unsupported mode %u for decompress.\n", param->mode);
@@ -150,78 +203,335 @@ static int rk_decom_for_user(struct device *dev, struct rk_decom_param *param)
 	}
 
 	ret = get_dmafd_sgtbl(dev, param->src_fd, DMA_TO_DEVICE,
-			      &sg_tbl_in, &dma_attach_in, &dma_buf_in);
+			      &bufs->sg_tbl_in, &bufs->dma_attach_in, &bufs->dma_buf_in);
 	if (unlikely(ret)) {
 		dev_err(dev, "src_fd[%d] get_dmafd_sgtbl error.", (int)param->src_fd);
 		goto exit;
 	}
 
 	ret = get_dmafd_sgtbl(dev, param->dst_fd, DMA_FROM_DEVICE,
-			      &sg_tbl_out, &dma_attach_out, &dma_buf_out);
+			      &bufs->sg_tbl_out, &bufs->dma_attach_out, &bufs->dma_buf_out);
 	if (unlikely(ret)) {
 		dev_err(dev, "dst_fd[%d] get_dmafd_sgtbl error.", (int)param->dst_fd);
 		goto exit;
 	}
 
-	if (!check_scatter_list(0, sg_tbl_in)) {
+	if (!check_scatter_list(0, bufs->sg_tbl_in)) {
 		dev_err(dev, "Input dma_fd not a continuous buffer.\n");
 		ret = -EINVAL;
 		goto exit;
 	}
 
-	if (!check_scatter_list(param->dst_max_size, sg_tbl_out)) {
+	if (!check_scatter_list(param->dst_max_size, bufs->sg_tbl_out)) {
 		dev_err(dev, "Output dma_fd not a continuous buffer or dst_max_size too big.\n");
 		ret = -EINVAL;
 		goto exit;
 	}
 
-	ret = rk_decom_start(param->mode | DECOM_NOBLOCKING, sg_dma_address(sg_tbl_in->sgl),
-			     sg_dma_address(sg_tbl_out->sgl), param->dst_max_size);
+	return 0;
+exit:
+	rk_decom_put_bufs(dev, param, bufs);
 
+	return ret;
+}
+
+/* Run one job on the hardware, caller holds rk_decom->mutex */
+static int rk_decom_run(struct device *dev, struct rk_decom_param *param,
+			struct rk_decom_bufs *bufs)
+{
+	int ret;
+
+	ret = rk_decom_start(param->mode | DECOM_NOBLOCKING,
+			     sg_dma_address(bufs->sg_tbl_in->sgl),
+			     sg_dma_address(bufs->sg_tbl_out->sgl), param->dst_max_size);
 	if (ret) {
 		dev_err(dev, "rk_decom_start failed[%d].", ret);
-		goto exit;
+		return ret;
 	}
 
-	ret = rk_decom_wait_done(RK_DECOME_TIMEOUT, &param->decom_data_len);
+	return rk_decom_wait_done(RK_DECOME_TIMEOUT, &param->decom_data_len);
+}
 
-exit:
-	if (sg_tbl_in && dma_buf_in && dma_attach_in)
-		put_dmafd_sgtbl(dev, param->src_fd, DMA_TO_DEVICE,
-				sg_tbl_in, dma_attach_in, dma_buf_in);
+static int rk_decom_for_user(struct device *dev, struct rk_decom_param *param)
+{
+	struct rk_decom_bufs bufs;
+	int ret;
 
-	if (sg_tbl_out && dma_buf_out && dma_attach_out)
-		put_dmafd_sgtbl(dev, param->dst_fd, DMA_FROM_DEVICE,
-				sg_tbl_out, dma_attach_out, dma_buf_out);
+	ret = rk_decom_get_bufs(dev, param, &bufs);
+	if (ret)
+		return ret;
+
+	ret = rk_decom_run(dev, param, &bufs);
+
+	rk_decom_put_bufs(dev, param, &bufs);
 
 	return ret;
 }
 
-static long rk_decom_misc_ioctl(struct file *fptr, unsigned int cmd, unsigned long arg)
+static const char *rk_decom_fence_get_driver_name(struct dma_fence *fence)
 {
-	struct rk_decom_param param;
-	struct rk_decom_dev *rk_decom = NULL;
-	int ret = -EINVAL;
+	return RK_DECOM_NAME;
+}
+
+static const char *rk_decom_fence_get_timeline_name(struct dma_fence *fence)
+{
+	return RK_DECOM_NAME;
+}
+
+static const struct dma_fence_ops rk_decom_fence_ops = {
+	.get_driver_name = rk_decom_fence_get_driver_name,
+	.get_timeline_name = rk_decom_fence_get_timeline_name,
+};
+
+static void rk_decom_job_complete(struct rk_decom_job *job, int status)
+{
+	struct rk_decom_ctx *ctx = job->ctx;
+
+	rk_decom_put_bufs(ctx->rk_decom->dev, &job->param, &job->bufs);
 
-	rk_decom = container_of(fptr->private_data, struct rk_decom_dev, miscdev);
+	spin_lock(&ctx->lock);
+	job->status = status;
+	job->done = true;
+	spin_unlock(&ctx->lock);
+
+	if (status)
+		dma_fence_set_error(job->fence, status);
+	dma_fence_signal(job->fence);
+}
+
+static void rk_decom_job_work(struct work_struct *work)
+{
+	struct rk_decom_job *job = container_of(work, struct rk_decom_job, work);
+	struct rk_decom_dev *rk_decom = job->ctx->rk_decom;
+	int ret;
 
 	mutex_lock(&rk_decom->mutex);
+	ret = rk_decom_run(rk_decom->dev, &job->param, &job->bufs);
+	mutex_unlock(&rk_decom->mutex);
+
+	rk_decom_job_complete(job, ret);
+}
+
+static void rk_decom_job_free(struct rk_decom_job *job)
+{
+	dma_fence_put(job->fence);
+	kfree(job);
+}
+
+static int rk_decom_async_submit(struct rk_decom_ctx *ctx,
+				 struct rk_decom_async_param *async)
+{
+	struct rk_decom_dev *rk_decom = ctx->rk_decom;
+	struct sync_file *sync_file;
+	struct rk_decom_job *job;
+	int fd, ret;
+
+	/* Reserve a slot in the per-file queue */
+	spin_lock(&ctx->lock);
+	if (ctx->num_jobs >= RK_DECOM_MAX_JOBS) {
+		spin_unlock(&ctx->lock);
+		return -EBUSY;
+	}
+	ctx->num_jobs++;
+	spin_unlock(&ctx->lock);
+
+	ret = -ENOMEM;
+	job = kzalloc(sizeof(*job), GFP_KERNEL);
+	if (!job)
+		goto err_release_slot;
+
+	job->fence = kzalloc(sizeof(*job->fence), GFP_KERNEL);
+	if (!job->fence) {
+		kfree(job);
+		goto err_release_slot;
+	}
+
+	dma_fence_init(job->fence, &rk_decom_fence_ops, &rk_decom->fence_lock,
+		       rk_decom->fence_context,
+		       atomic64_inc_return(&rk_decom->fence_seqno));
+
+	job->ctx = ctx;
+	job->param = async->param;
+	job->param.decom_data_len = 0;
+	INIT_WORK(&job->work, rk_decom_job_work);
+
+	/* Pin the buffers now so that closing the fds does not race the job */
+	ret = rk_decom_get_bufs(rk_decom->dev, &job->param, &job->bufs);
+	if (ret)
+		goto err_free_job;
+
+	fd = get_unused_fd_flags(O_CLOEXEC);
+	if (fd < 0) {
+		ret = fd;
+		goto err_put_bufs;
+	}
+
+	sync_file = sync_file_create(job->fence);
+	if (!sync_file) {
+		ret = -ENOMEM;
+		goto err_put_fd;
+	}
+
+	spin_lock(&ctx->lock);
+	job->id = ctx->next_id++;
+	list_add_tail(&job->node, &ctx->jobs);
+	spin_unlock(&ctx->lock);
+
+	async->fence_fd = fd;
+	async->job_id = job->id;
+	fd_install(fd, sync_file->file);
+
+	queue_work(rk_decom->wq, &job->work);
+
+	return 0;
+
+err_put_fd:
+	put_unused_fd(fd);
+err_put_bufs:
+	rk_decom_put_bufs(rk_decom->dev, &job->param, &job->bufs);
+err_free_job:
+	rk_decom_job_free(job);
+err_release_slot:
+	spin_lock(&ctx->lock);
+	ctx->num_jobs--;
+	spin_unlock(&ctx->lock);
+
+	return ret;
+}
+
+static int rk_decom_async_result(struct rk_decom_ctx *ctx,
+				 struct rk_decom_async_result *result)
+{
+	struct rk_decom_job *job, *found = NULL;
+
+	spin_lock(&ctx->lock);
+	list_for_each_entry(job, &ctx->jobs, node) {
+		if (job->id == result->job_id) {
+			found = job;
+			break;
+		}
+	}
+
+	if (!found) {
+		spin_unlock(&ctx->lock);
+		return -ENOENT;
+	}
+
+	if (!found->done) {
+		spin_unlock(&ctx->lock);
+		return -EBUSY;
+	}
+
+	list_del(&found->node);
+	ctx->num_jobs--;
+	spin_unlock(&ctx->lock);
+
+	result->status = found->status;
+	result->decom_data_len = found->param.decom_data_len;
+	rk_decom_job_free(found);
+
+	return 0;
+}
+
+static int rk_decom_misc_open(struct inode *inode, struct file *fptr)
+{
+	struct rk_decom_ctx *ctx;
+
+	ctx = kzalloc(sizeof(*ctx), GFP_KERNEL);
+	if (!ctx)
+		return -ENOMEM;
+
+	ctx->rk_decom = container_of(fptr->private_data, struct rk_decom_dev, miscdev);
+	spin_lock_init(&ctx->lock);
+	INIT_LIST_HEAD(&ctx->jobs);
+	fptr->private_data = ctx;
+
+	return 0;
+}
+
+static int rk_decom_misc_release(struct inode *inode, struct file *fptr)
+{
+	struct rk_decom_ctx *ctx = fptr->private_data;
+	struct rk_decom_job *job, *tmp;
+
+	/*
+	 * Jobs still queued are cancelled, a job already on the hardware
+	 * is waited for as its buffers are in use.
+	 */
+	list_for_each_entry_safe(job, tmp, &ctx->jobs, node) {
+		if (cancel_work_sync(&job->work))
+			rk_decom_job_complete(job, -ECANCELED);
+
+		list_del(&job->node);
+		rk_decom_job_free(job);
+	}
+
+	kfree(ctx);
+
+	return 0;
+}
+
+static long rk_decom_misc_ioctl(struct file *fptr, unsigned int cmd, unsigned long arg)
+{
+	struct rk_decom_async_result result;
+	struct rk_decom_async_param async;
+	struct rk_decom_param param;
+	struct rk_decom_ctx *ctx = fptr->private_data;
+	struct rk_decom_dev *rk_decom = ctx->rk_decom;
+	int ret = -EINVAL;
 
 	switch (cmd) {
 	case RK_DECOM_USER: {
 		ret = copy_from_user((char *)&param, (char *)arg, sizeof(param));
 		if (unlikely(ret)) {
-			ret = -EFAULT;
 			dev_err(rk_decom->dev, "copy from user fail.\n");
-			goto exit;
+			return -EFAULT;
 		}
 
+		mutex_lock(&rk_decom->mutex);
 		ret = rk_decom_for_user(rk_decom->dev, &param);
+		mutex_unlock(&rk_decom->mutex);
 
 		if (copy_to_user((char *)arg, &param, sizeof(param))) {
 			dev_err(rk_decom->dev, " copy to user fail.\n");
 			ret = -EFAULT;
-			goto exit;
+		}
+
+		break;
+	}
+
+	case RK_DECOM_ASYNC_SUBMIT: {
+		if (copy_from_user(&async, (void __user *)arg, sizeof(async))) {
+			dev_err(rk_decom->dev, "copy from user fail.\n");
+			return -EFAULT;
+		}
+
+		ret = rk_decom_async_submit(ctx, &async);
+		if (ret)
+			break;
+
+		/* The job is already queued, a fault here only loses its ids */
+		if (copy_to_user((void __user *)arg, &async, sizeof(async))) {
+			dev_err(rk_decom->dev, " copy to user fail.\n");
+			ret = -EFAULT;
+		}
+
+		break;
+	}
+
+	case RK_DECOM_ASYNC_RESULT: {
+		if (copy_from_user(&result, (void __user *)arg, sizeof(result))) {
+			dev_err(rk_decom->dev, "copy from user fail.\n");
+			return -EFAULT;
+		}
+
+		ret = rk_decom_async_result(ctx, &result);
+		if (ret)
+			break;
+
+		if (copy_to_user((void __user *)arg, &result, sizeof(result))) {
+			dev_err(rk_decom->dev, " copy to user fail.\n");
+			ret = -EFAULT;
 		}
 
 		break;
@@ -232,9 +542,6 @@ static long rk_decom_misc_ioctl(struct file *fptr, unsigned int cmd, unsigned lo
 		break;
 	}
 
-exit:
-	mutex_unlock(&rk_decom->mutex);
-
 	return ret;
 }
 
@@ -262,6 +569,15 @@ static int __init rk_decom_misc_init(void)
 	}
 
 	mutex_init(&rk_decom->mutex);
+	spin_lock_init(&rk_decom->fence_lock);
+	rk_decom->fence_context = dma_fence_context_alloc(1);
+
+	/* The hardware decodes one stream at a time, keep jobs in order */
+	rk_decom->wq = alloc_ordered_workqueue("rk_decom", 0);
+	if (!rk_decom->wq) {
+		ret = -ENOMEM;
+		goto error;
+	}
 
 	dev_info(rk_decom->dev, "misc device %s register success.\n", RK_DECOM_NAME);
 
@@ -276,6 +592,7 @@ static int __init rk_decom_misc_init(void)
 static void __exit rk_decom_misc_exit(void)
 {
 	misc_deregister(&g_rk_decom.miscdev);
+	destroy_workqueue(g_rk_decom.wq);
 }
 
 module_init(rk_decom_misc_init)
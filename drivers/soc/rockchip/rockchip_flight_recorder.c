@@ -0,0 +1,245 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Rockchip multimedia flight recorder
+ *
+ * Multimedia drivers log compact submit/start/irq/done events into a per
+ * cpu ring, which keeps the recent history of the hardware queues around
+ * for intermittent stalls. Writers only reserve a slot with a cpu local
+ * increment, no locks and no shared cache lines.
+ *
+ * All rings live in one buffer starting with struct rk_fr_header, which
+ * is registered with minidump so it can be decoded offline as well.
+ *
+ * Copyright (c) 2023 Rockchip Electronics Co., Ltd.
+ */
+
+#include <linux/cache.h>
+#include <linux/debugfs.h>
+#include <linux/init.h>
+#include <linux/io.h>
+#include <linux/kernel.h>
+#include <linux/log2.h>
+#include <linux/mm.h>
+#include <linux/module.h>
+#include <linux/percpu.h>
+#include <linux/sched/clock.h>
+#include <linux/seq_file.h>
+#include <asm/local.h>
+#include <soc/rockchip/rk_minidump.h>
+#include <soc/rockchip/rockchip_flight_recorder.h>
+
+#define RK_FR_MAGIC		0x52464b52	/* "RKFR" */
+#define RK_FR_VERSION		1
+
+struct rk_fr_header {
+	u32 magic;
+	u32 version;
+	u32 nr_cpus;
+	/* entries per cpu, power of 2 */
+	u32 entries;
+	u32 entry_size;
+	/* offset of cpu 0's struct rk_fr_cpu, and distance to the next one */
+	u32 cpu_offset;
+	u32 cpu_stride;
+	u32 reserved;
+};
+
+struct rk_fr_cpu {
+	/* records ever written on this cpu, the newest is at head - 1 */
+	local_t head;
+	struct rk_fr_entry ring[] ____cacheline_aligned;
+} ____cacheline_aligned;
+
+static const char * const rk_fr_src_names[RK_FR_SRC_NR] = {
+	[RK_FR_SRC_VOP2] = "vop2",
+	[RK_FR_SRC_MPP] = "mpp",
+	[RK_FR_SRC_RKNPU] = "rknpu",
+	[RK_FR_SRC_RGA] = "rga",
+	[RK_FR_SRC_ISP] = "isp",
+};
+
+static const char * const rk_fr_event_names[RK_FR_EV_NR] = {
+	[RK_FR_EV_SUBMIT] = "submit",
+	[RK_FR_EV_START] = "start",
+	[RK_FR_EV_IRQ] = "irq",
+	[RK_FR_EV_DONE] = "done",
+	[RK_FR_EV_TIMEOUT] = "timeout",
+	[RK_FR_EV_RESET] = "reset",
+};
+
+static unsigned int entries = 1024;
+module_param(entries, uint, 0444);
+MODULE_PARM_DESC(entries, "Events kept per cpu, rounded up to a power of 2");
+
+static bool enable = true;
+module_param(enable, bool, 0444);
+MODULE_PARM_DESC(enable, "Start recording at boot");
+
+DEFINE_STATIC_KEY_FALSE(rk_fr_enabled);
+EXPORT_SYMBOL_GPL(rk_fr_enabled);
+
+static DEFINE_PER_CPU_READ_MOSTLY(struct rk_fr_cpu *, rk_fr_cpu);
+static struct rk_fr_header *rk_fr_buf;
+static size_t rk_fr_size;
+static u32 rk_fr_mask;
+
+void __rk_fr_log(u8 src, u8 event, u16 id, u32 arg)
+{
+	struct rk_fr_cpu *c;
+	struct rk_fr_entry *e;
+
+	preempt_disable_notrace();
+
+	c = __this_cpu_read(rk_fr_cpu);
+	/* nested writers from irq/nmi on this cpu get their own slot */
+	e = &c->ring[(local_inc_return(&c->head) - 1) & rk_fr_mask];
+	e->src = src;
+	e->event = event;
+	e->id = id;
+	e->arg = arg;
+	WRITE_ONCE(e->ts_ns, local_clock());
+
+	preempt_enable_notrace();
+}
+EXPORT_SYMBOL_GPL(__rk_fr_log);
+
+static struct rk_fr_cpu *rk_fr_cpu_ring(unsigned int cpu)
+{
+	return (void *)rk_fr_buf + rk_fr_buf->cpu_offset + cpu * rk_fr_buf->cpu_stride;
+}
+
+/* seq position: cpu * entries + n, the n-th oldest record of that cpu */
+static void *rk_fr_seq_start(struct seq_file *s, loff_t *pos)
+{
+	return *pos < (loff_t)nr_cpu_ids * rk_fr_buf->entries ? pos : NULL;
+}
+
+static void *rk_fr_seq_next(struct seq_file *s, void *v, loff_t *pos)
+{
+	++*pos;
+
+	return rk_fr_seq_start(s, pos);
+}
+
+static void rk_fr_seq_stop(struct seq_file *s, void *v)
+{
+}
+
+static int rk_fr_seq_show(struct seq_file *s, void *v)
+{
+	loff_t pos = *(loff_t *)v;
+	unsigned int cpu = div_u64(pos, rk_fr_buf->entries);
+	unsigned long head, n = pos - (loff_t)cpu * rk_fr_buf->entries;
+	struct rk_fr_cpu *c;
+	struct rk_fr_entry e;
+	u64 ts;
+	u32 rem;
+
+	if (!cpu_possible(cpu))
+		return SEQ_SKIP;
+
+	c = rk_fr_cpu_ring(cpu);
+	head = local_read(&c->head);
+	if (n >= min_t(unsigned long, head, rk_fr_buf->entries))
+		return SEQ_SKIP;
+
+	e = c->ring[(head - min_t(unsigned long, head, rk_fr_buf->entries) + n) & rk_fr_mask];
+	if (!e.ts_ns)
+		return SEQ_SKIP;
+
+	ts = e.ts_ns;
+	rem = do_div(ts, NSEC_PER_SEC);
+	seq_printf(s, "[%5llu.%06u] cpu%u %-5s %-7s id %u arg 0x%08x\n",
+		   ts, rem / NSEC_PER_USEC, cpu,
+		   e.src < RK_FR_SRC_NR ? rk_fr_src_names[e.src] : "?",
+		   e.event < RK_FR_EV_NR ? rk_fr_event_names[e.event] : "?",
+		   e.id, e.arg);
+
+	return 0;
+}
+
+static const struct seq_operations rk_fr_seq_ops = {
+	.start = rk_fr_seq_start,
+	.next = rk_fr_seq_next,
+	.stop = rk_fr_seq_stop,
+	.show = rk_fr_seq_show,
+};
+DEFINE_SEQ_ATTRIBUTE(rk_fr_seq);
+
+static int rk_fr_enable_get(void *data, u64 *val)
+{
+	*val = static_key_enabled(&rk_fr_enabled);
+
+	return 0;
+}
+
+static int rk_fr_enable_set(void *data, u64 val)
+{
+	if (val)
+		static_branch_enable(&rk_fr_enabled);
+	else
+		static_branch_disable(&rk_fr_enabled);
+
+	return 0;
+}
+DEFINE_DEBUGFS_ATTRIBUTE(rk_fr_enable_fops, rk_fr_enable_get, rk_fr_enable_set, "%llu\n");
+
+static int __init rk_fr_init(void)
+{
+	struct dentry *dir;
+	u32 stride;
+	int cpu;
+
+	entries = roundup_pow_of_two(clamp(entries, 64U, 16384U));
+	stride = ALIGN(sizeof(struct rk_fr_cpu) + entries * sizeof(struct rk_fr_entry),
+		       SMP_CACHE_BYTES);
+	rk_fr_size = PAGE_ALIGN(ALIGN(sizeof(struct rk_fr_header), SMP_CACHE_BYTES) +
+				(size_t)stride * nr_cpu_ids);
+
+	/* linear map memory, minidump needs the physical address */
+	rk_fr_buf = alloc_pages_exact(rk_fr_size, GFP_KERNEL | __GFP_ZERO);
+	if (!rk_fr_buf)
+		return -ENOMEM;
+
+	rk_fr_buf->magic = RK_FR_MAGIC;
+	rk_fr_buf->version = RK_FR_VERSION;
+	rk_fr_buf->nr_cpus = nr_cpu_ids;
+	rk_fr_buf->entries = entries;
+	rk_fr_buf->entry_size = sizeof(struct rk_fr_entry);
+	rk_fr_buf->cpu_offset = ALIGN(sizeof(struct rk_fr_header), SMP_CACHE_BYTES);
+	rk_fr_buf->cpu_stride = stride;
+	rk_fr_mask = entries - 1;
+
+	for_each_possible_cpu(cpu)
+		per_cpu(rk_fr_cpu, cpu) = rk_fr_cpu_ring(cpu);
+
+	dir = debugfs_create_dir("rockchip_flight_recorder", NULL);
+	debugfs_create_file("events", 0400, dir, NULL, &rk_fr_seq_fops);
+	debugfs_create_file_unsafe("enable", 0600, dir, NULL, &rk_fr_enable_fops);
+
+	if (enable)
+		static_branch_enable(&rk_fr_enabled);
+
+	return 0;
+}
+arch_initcall(rk_fr_init);
+
+/* minidump may only come up with the drivers, register late */
+static int __init rk_fr_minidump_init(void)
+{
+	struct md_region md_entry = {};
+
+	if (!rk_fr_buf)
+		return 0;
+
+	strscpy(md_entry.name, "rk_flightrec", sizeof(md_entry.name));
+	md_entry.virt_addr = (u64)rk_fr_buf;
+	md_entry.phys_addr = virt_to_phys(rk_fr_buf);
+	md_entry.size = rk_fr_size;
+
+	if (rk_minidump_add_region(&md_entry) < 0)
+		pr_err("Failed to add flight recorder in Minidump\n");
+
+	return 0;
+}
+late_initcall(rk_fr_minidump_init);
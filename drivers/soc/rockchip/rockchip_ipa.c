@@ -2,9 +2,11 @@
 /*
  * Copyright (c) 2018 Fuzhou Rockchip Electronics Co., Ltd
  */
+#include <linux/energy_model.h>
 #include <linux/kernel.h>
 #include <linux/of.h>
 #include <linux/module.h>
+#include <linux/pm_opp.h>
 #include <linux/slab.h>
 #include <linux/thermal.h>
 #include <soc/rockchip/rockchip_ipa.h>
@@ -230,6 +232,94 @@ rockchip_ipa_get_static_power(struct ipa_power_model_data *data,
 }
 EXPORT_SYMBOL(rockchip_ipa_get_static_power);
 
+/*
+ * "dynamic-power-table" holds <kHz uV uW> entries measured on a reference
+ * chip. The entry closest to the opp is scaled to the voltage this chip was
+ * given by the pvtm / leakage selection: P' = P * (V' / V)^2 * f' / f.
+ */
+static int rockchip_ipa_get_table_power(struct device *dev, unsigned long *uW,
+					unsigned long *kHz)
+{
+	const char *name = "dynamic-power-table";
+	struct dev_pm_opp *opp;
+	unsigned long hz = *kHz * 1000, khz, uv;
+	u32 tbl_khz = 0, tbl_uv = 0, tbl_uw = 0, f, v, p;
+	int count, i;
+	u64 power;
+
+	opp = dev_pm_opp_find_freq_ceil(dev, &hz);
+	if (IS_ERR(opp))
+		return -EINVAL;
+	uv = dev_pm_opp_get_voltage(opp);
+	dev_pm_opp_put(opp);
+	khz = hz / 1000;
+	if (!uv)
+		return -EINVAL;
+
+	count = of_property_count_u32_elems(dev->of_node, name);
+	if (count < 3 || count % 3)
+		return -EINVAL;
+	for (i = 0; i < count; i += 3) {
+		if (of_property_read_u32_index(dev->of_node, name, i, &f) ||
+		    of_property_read_u32_index(dev->of_node, name, i + 1, &v) ||
+		    of_property_read_u32_index(dev->of_node, name, i + 2, &p))
+			return -EINVAL;
+		if (!f || !v)
+			continue;
+		if (!tbl_khz || abs((long)f - (long)khz) <
+				abs((long)tbl_khz - (long)khz)) {
+			tbl_khz = f;
+			tbl_uv = v;
+			tbl_uw = p;
+		}
+	}
+	if (!tbl_khz || !tbl_uw)
+		return -EINVAL;
+
+	power = div_u64((u64)tbl_uw * uv, tbl_uv);
+	power = div_u64(power * uv, tbl_uv);
+	power = div_u64(power * khz, tbl_khz);
+
+	*uW = power;
+	*kHz = khz;
+
+	return 0;
+}
+
+/**
+ * rockchip_ipa_register_em() - register energy model from a measured table
+ * @dev:	device with "dynamic-power-table" and an opp table
+ * @cpus:	cpus sharing the opp table, or NULL for other devices
+ *
+ * Must be called once the opp voltages have been adjusted for this chip and
+ * before the cpufreq / devfreq cooling core registers its coefficient based
+ * model, which then backs off with -EEXIST.
+ *
+ * Return: 0 on success or when a model is already registered.
+ */
+int rockchip_ipa_register_em(struct device *dev, struct cpumask *cpus)
+{
+	struct em_data_callback em_cb = EM_DATA_CB(rockchip_ipa_get_table_power);
+	int nr_opp, ret;
+
+	if (!of_find_property(dev->of_node, "dynamic-power-table", NULL))
+		return -ENODEV;
+
+	if (em_pd_get(dev) || (cpus && em_cpu_get(cpumask_first(cpus))))
+		return 0;
+
+	nr_opp = dev_pm_opp_get_opp_count(dev);
+	if (nr_opp <= 0)
+		return -EINVAL;
+
+	ret = em_dev_register_perf_domain(dev, nr_opp, &em_cb, cpus, true);
+	if (ret)
+		dev_err(dev, "failed to register dynamic power table: %d\n", ret);
+
+	return ret;
+}
+EXPORT_SYMBOL(rockchip_ipa_register_em);
+
 MODULE_DESCRIPTION("Rockchip IPA driver");
 MODULE_AUTHOR("Finley Xiao <finley.xiao@rock-chips.com>");
 MODULE_LICENSE("GPL");
@@ -0,0 +1,395 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Rockchip media pipeline
+ *
+ * Chains the jobs of a frame across drivers (ISP, MPP, RGA, RKNPU, VOP2)
+ * in the kernel: each stage is submitted from the completion of the
+ * previous one's dma-fence, instead of userspace waiting for every stage
+ * and submitting the next. Queue, run and end to end latency of every
+ * pipeline are kept for debugfs.
+ *
+ * Copyright (c) 2023 Rockchip Electronics Co., Ltd.
+ */
+
+#include <linux/debugfs.h>
+#include <linux/dma-fence.h>
+#include <linux/kref.h>
+#include <linux/ktime.h>
+#include <linux/module.h>
+#include <linux/seq_file.h>
+#include <linux/slab.h>
+#include <linux/spinlock.h>
+#include <linux/workqueue.h>
+#include <soc/rockchip/rockchip_media_pipeline.h>
+
+#define RK_MPIPE_MAX_STAGES	8
+
+struct rk_mpipe_stage_stats {
+	u64 queue_us_total;
+	u32 queue_us_max;
+	u64 run_us_total;
+	u32 run_us_max;
+};
+
+struct rk_mpipe {
+	struct kref ref;
+	char name[32];
+	unsigned int nr_stages;
+	struct dentry *debugfs;
+
+	/* protects the statistics below */
+	spinlock_t lock;
+	u64 frames;
+	u64 errors;
+	u64 e2e_us_total;
+	u32 e2e_us_max;
+	u32 e2e_us_last;
+	struct rk_mpipe_stage_stats stages[];
+};
+
+struct rk_mpipe_job {
+	const struct rk_mpipe_stage_ops *ops;
+	void *data;
+	/* submitted to the driver, completed */
+	ktime_t submitted;
+	ktime_t done;
+};
+
+struct rk_mpipe_frame {
+	struct rk_mpipe *pipe;
+	u32 id;
+	int error;
+	struct dma_fence *in_fence;
+	/* commit or in-fence signalled, whichever came last */
+	ktime_t start;
+
+	/* stage being run and the fence it is waiting for */
+	unsigned int cur;
+	struct dma_fence *fence;
+	struct dma_fence_cb cb;
+	ktime_t signalled;
+	struct work_struct work;
+
+	struct rk_mpipe_job jobs[];
+};
+
+static struct dentry *rk_mpipe_debugfs_root;
+
+static void rk_mpipe_release(struct kref *ref)
+{
+	kfree(container_of(ref, struct rk_mpipe, ref));
+}
+
+static void rk_mpipe_account(struct rk_mpipe_frame *frame)
+{
+	struct rk_mpipe *pipe = frame->pipe;
+	struct rk_mpipe_stage_stats *stats;
+	struct rk_mpipe_job *job;
+	ktime_t prev_done = frame->start;
+	unsigned long flags;
+	u32 queue_us, run_us, e2e_us;
+	unsigned int i;
+
+	spin_lock_irqsave(&pipe->lock, flags);
+
+	if (frame->error) {
+		pipe->errors++;
+		goto out;
+	}
+
+	for (i = 0; i < pipe->nr_stages; i++) {
+		job = &frame->jobs[i];
+		stats = &pipe->stages[i];
+
+		queue_us = ktime_us_delta(job->submitted, prev_done);
+		run_us = ktime_us_delta(job->done, job->submitted);
+		stats->queue_us_total += queue_us;
+		stats->queue_us_max = max(stats->queue_us_max, queue_us);
+		stats->run_us_total += run_us;
+		stats->run_us_max = max(stats->run_us_max, run_us);
+		prev_done = job->done;
+	}
+
+	e2e_us = ktime_us_delta(prev_done, frame->start);
+	pipe->frames++;
+	pipe->e2e_us_total += e2e_us;
+	pipe->e2e_us_max = max(pipe->e2e_us_max, e2e_us);
+	pipe->e2e_us_last = e2e_us;
+
+	pr_debug("%s: frame %u done in %u us\n", pipe->name, frame->id, e2e_us);
+out:
+	spin_unlock_irqrestore(&pipe->lock, flags);
+}
+
+static void rk_mpipe_frame_free(struct rk_mpipe_frame *frame)
+{
+	struct rk_mpipe *pipe = frame->pipe;
+
+	if (frame->in_fence)
+		dma_fence_put(frame->in_fence);
+	kfree(frame);
+	kref_put(&pipe->ref, rk_mpipe_release);
+}
+
+static void rk_mpipe_fence_cb(struct dma_fence *fence, struct dma_fence_cb *cb)
+{
+	struct rk_mpipe_frame *frame = container_of(cb, struct rk_mpipe_frame, cb);
+
+	frame->signalled = ktime_get();
+	queue_work(system_highpri_wq, &frame->work);
+}
+
+/* Returns true if the frame has to wait for @fence, which it now owns */
+static bool rk_mpipe_frame_wait(struct rk_mpipe_frame *frame, struct dma_fence *fence)
+{
+	frame->fence = fence;
+	if (!dma_fence_add_callback(fence, &frame->cb, rk_mpipe_fence_cb))
+		return true;
+
+	frame->signalled = ktime_get();
+
+	return false;
+}
+
+static void rk_mpipe_frame_signalled(struct rk_mpipe_frame *frame)
+{
+	struct rk_mpipe_job *job = &frame->jobs[frame->cur];
+
+	if (frame->fence->error && !frame->error)
+		frame->error = frame->fence->error;
+	if (frame->fence != frame->in_fence)
+		dma_fence_put(frame->fence);
+	frame->fence = NULL;
+
+	/* the in-fence only gates stage 0 */
+	if (job->submitted) {
+		job->done = frame->signalled;
+		frame->cur++;
+	} else {
+		frame->start = frame->signalled;
+	}
+}
+
+static void rk_mpipe_frame_run(struct rk_mpipe_frame *frame)
+{
+	struct rk_mpipe_job *job;
+	struct dma_fence *fence;
+
+	while (frame->cur < frame->pipe->nr_stages) {
+		job = &frame->jobs[frame->cur];
+
+		if (frame->error) {
+			if (job->ops->cancel)
+				job->ops->cancel(job->data);
+			frame->cur++;
+			continue;
+		}
+
+		fence = job->ops->submit(job->data);
+		job->submitted = ktime_get();
+
+		if (IS_ERR(fence)) {
+			frame->error = PTR_ERR(fence);
+			frame->cur++;
+			continue;
+		}
+
+		if (!fence) {
+			job->done = job->submitted;
+			frame->cur++;
+			continue;
+		}
+
+		if (rk_mpipe_frame_wait(frame, fence))
+			return;
+
+		rk_mpipe_frame_signalled(frame);
+	}
+
+	rk_mpipe_account(frame);
+	rk_mpipe_frame_free(frame);
+}
+
+static void rk_mpipe_frame_work(struct work_struct *work)
+{
+	struct rk_mpipe_frame *frame = container_of(work, struct rk_mpipe_frame, work);
+
+	rk_mpipe_frame_signalled(frame);
+	rk_mpipe_frame_run(frame);
+}
+
+/**
+ * rk_mpipe_frame_create - Start describing a frame of a pipeline
+ * @pipe: the pipeline
+ * @id: frame id, only used for debugging
+ * @in_fence: fence gating the first stage, may be NULL; a reference is taken
+ */
+struct rk_mpipe_frame *rk_mpipe_frame_create(struct rk_mpipe *pipe, u32 id,
+					     struct dma_fence *in_fence)
+{
+	struct rk_mpipe_frame *frame;
+
+	frame = kzalloc(struct_size(frame, jobs, pipe->nr_stages), GFP_KERNEL);
+	if (!frame)
+		return ERR_PTR(-ENOMEM);
+
+	kref_get(&pipe->ref);
+	frame->pipe = pipe;
+	frame->id = id;
+	if (in_fence)
+		frame->in_fence = dma_fence_get(in_fence);
+	INIT_WORK(&frame->work, rk_mpipe_frame_work);
+
+	return frame;
+}
+EXPORT_SYMBOL_GPL(rk_mpipe_frame_create);
+
+int rk_mpipe_frame_set_stage(struct rk_mpipe_frame *frame, unsigned int stage,
+			     const struct rk_mpipe_stage_ops *ops, void *data)
+{
+	if (stage >= frame->pipe->nr_stages || !ops || !ops->submit)
+		return -EINVAL;
+
+	frame->jobs[stage].ops = ops;
+	frame->jobs[stage].data = data;
+
+	return 0;
+}
+EXPORT_SYMBOL_GPL(rk_mpipe_frame_set_stage);
+
+/**
+ * rk_mpipe_frame_abort - Drop a frame which was not committed
+ * @frame: the frame
+ *
+ * The data of every stage set so far is released through its cancel op.
+ */
+void rk_mpipe_frame_abort(struct rk_mpipe_frame *frame)
+{
+	struct rk_mpipe_job *job;
+	unsigned int i;
+
+	for (i = 0; i < frame->pipe->nr_stages; i++) {
+		job = &frame->jobs[i];
+		if (job->ops && job->ops->cancel)
+			job->ops->cancel(job->data);
+	}
+
+	rk_mpipe_frame_free(frame);
+}
+EXPORT_SYMBOL_GPL(rk_mpipe_frame_abort);
+
+/**
+ * rk_mpipe_frame_commit - Run a frame
+ * @frame: the frame, owned by the pipeline from now on
+ *
+ * If the in-fence already signalled, stage 0 is submitted from the
+ * caller's context, the following stages from a high priority workqueue.
+ *
+ * Return: 0, or -EINVAL if a stage was left unset; the frame is aborted.
+ */
+int rk_mpipe_frame_commit(struct rk_mpipe_frame *frame)
+{
+	unsigned int i;
+
+	for (i = 0; i < frame->pipe->nr_stages; i++) {
+		if (!frame->jobs[i].ops) {
+			rk_mpipe_frame_abort(frame);
+			return -EINVAL;
+		}
+	}
+
+	frame->start = ktime_get();
+
+	if (frame->in_fence) {
+		if (rk_mpipe_frame_wait(frame, frame->in_fence))
+			return 0;
+		rk_mpipe_frame_signalled(frame);
+	}
+
+	rk_mpipe_frame_run(frame);
+
+	return 0;
+}
+EXPORT_SYMBOL_GPL(rk_mpipe_frame_commit);
+
+static int rk_mpipe_show(struct seq_file *s, void *unused)
+{
+	struct rk_mpipe *pipe = s->private;
+	struct rk_mpipe_stage_stats *stats;
+	unsigned long flags;
+	u64 frames;
+	unsigned int i;
+
+	spin_lock_irqsave(&pipe->lock, flags);
+	frames = max_t(u64, pipe->frames, 1);
+	seq_printf(s, "frames: %llu errors: %llu\n", pipe->frames, pipe->errors);
+	seq_printf(s, "e2e us last: %u avg: %llu max: %u\n", pipe->e2e_us_last,
+		   div64_u64(pipe->e2e_us_total, frames), pipe->e2e_us_max);
+	for (i = 0; i < pipe->nr_stages; i++) {
+		stats = &pipe->stages[i];
+		seq_printf(s, "stage%u queue us avg: %llu max: %u run us avg: %llu max: %u\n",
+			   i, div64_u64(stats->queue_us_total, frames), stats->queue_us_max,
+			   div64_u64(stats->run_us_total, frames), stats->run_us_max);
+	}
+	spin_unlock_irqrestore(&pipe->lock, flags);
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(rk_mpipe);
+
+/**
+ * rk_mpipe_create - Create a pipeline
+ * @name: name of the pipeline in debugfs
+ * @nr_stages: number of stages every frame goes through
+ */
+struct rk_mpipe *rk_mpipe_create(const char *name, unsigned int nr_stages)
+{
+	struct rk_mpipe *pipe;
+
+	if (!nr_stages || nr_stages > RK_MPIPE_MAX_STAGES)
+		return ERR_PTR(-EINVAL);
+
+	pipe = kzalloc(struct_size(pipe, stages, nr_stages), GFP_KERNEL);
+	if (!pipe)
+		return ERR_PTR(-ENOMEM);
+
+	kref_init(&pipe->ref);
+	spin_lock_init(&pipe->lock);
+	strscpy(pipe->name, name, sizeof(pipe->name));
+	pipe->nr_stages = nr_stages;
+	pipe->debugfs = debugfs_create_file(pipe->name, 0444, rk_mpipe_debugfs_root,
+					    pipe, &rk_mpipe_fops);
+
+	return pipe;
+}
+EXPORT_SYMBOL_GPL(rk_mpipe_create);
+
+/**
+ * rk_mpipe_destroy - Release a pipeline
+ * @pipe: the pipeline
+ *
+ * Frames still in flight keep running to completion.
+ */
+void rk_mpipe_destroy(struct rk_mpipe *pipe)
+{
+	debugfs_remove(pipe->debugfs);
+	kref_put(&pipe->ref, rk_mpipe_release);
+}
+EXPORT_SYMBOL_GPL(rk_mpipe_destroy);
+
+static int __init rk_mpipe_init(void)
+{
+	rk_mpipe_debugfs_root = debugfs_create_dir("rockchip_media_pipeline", NULL);
+
+	return 0;
+}
+module_init(rk_mpipe_init);
+
+static void __exit rk_mpipe_exit(void)
+{
+	debugfs_remove_recursive(rk_mpipe_debugfs_root);
+}
+module_exit(rk_mpipe_exit);
+
+MODULE_LICENSE("GPL");
+MODULE_DESCRIPTION("Rockchip media pipeline");
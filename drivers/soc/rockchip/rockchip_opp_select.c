@@ -6,6 +6,7 @@
 //#define DEBUG
 #include <linux/clk.h>
 #include <linux/cpufreq.h>
+#include <linux/crc32.h>
 #include <linux/devfreq.h>
 #include <linux/mfd/syscon.h>
 #include <linux/module.h>
@@ -15,6 +16,7 @@
 #include <linux/rockchip/rockchip_sip.h>
 #include <linux/slab.h>
 #include <linux/soc/rockchip/pvtm.h>
+#include <linux/soc/rockchip/rk_vendor_storage.h>
 #include <linux/thermal.h>
 #include <linux/pm_opp.h>
 #include <linux/version.h>
@@ -76,6 +78,22 @@ struct otp_opp_info {
 #define PVTM_CH_MAX	8
 #define PVTM_SUB_CH_MAX	8
 
+#define OPP_SEL_CACHE_TAG	0x4f505053	/* "OPPS" */
+#define OPP_SEL_CACHE_MAX	16
+
+struct opp_sel_entry {
+	u32 node;
+	u32 dt_crc;
+	s32 scale;
+	s32 volt_sel;
+} __packed;
+
+struct opp_sel_cache {
+	u32 tag;
+	u32 chip_id;
+	struct opp_sel_entry entry[OPP_SEL_CACHE_MAX];
+} __packed;
+
 #define FRAC_BITS 10
 #define int_to_frac(x) ((x) << FRAC_BITS)
 #define frac_to_int(x) ((x) >> FRAC_BITS)
@@ -1473,6 +1491,143 @@ static int rockchip_set_opp_supported_hw(struct device *dev,
 	return 0;
 }
 
+static DEFINE_MUTEX(opp_sel_cache_lock);
+static u32 opp_sel_chip_id;
+
+static u32 rockchip_opp_sel_chip_id(void)
+{
+	struct device_node *np;
+	u8 id[16];
+
+	if (opp_sel_chip_id)
+		return opp_sel_chip_id;
+
+	np = of_find_compatible_node(NULL, NULL, "rockchip,cpuinfo");
+	if (!np)
+		return 0;
+	if (!rockchip_nvmem_cell_read_common(np, "id", id, sizeof(id)))
+		opp_sel_chip_id = crc32(0, id, sizeof(id)) ? : 1;
+	of_node_put(np);
+
+	return opp_sel_chip_id;
+}
+
+/*
+ * The selections only depend on the efuse and the opp table node, so a
+ * checksum of both tells whether a cached result is still valid.
+ */
+static u32 rockchip_opp_sel_dt_crc(struct device_node *np,
+				   struct rockchip_opp_info *info)
+{
+	struct property *prop;
+	u32 crc;
+
+	crc = crc32(0, &info->bin, sizeof(info->bin));
+	crc = crc32(crc, &info->process, sizeof(info->process));
+	for_each_property_of_node(np, prop) {
+		crc = crc32(crc, prop->name, strlen(prop->name));
+		crc = crc32(crc, prop->value, prop->length);
+	}
+
+	return crc;
+}
+
+static bool rockchip_opp_sel_cache_get(struct device *dev,
+				       struct device_node *np,
+				       struct rockchip_opp_info *info)
+{
+	struct opp_sel_cache *cache;
+	u32 node, dt_crc, chip_id;
+	bool found = false;
+	int i;
+
+	if (!is_rk_vendor_ready())
+		return false;
+	chip_id = rockchip_opp_sel_chip_id();
+	if (!chip_id)
+		return false;
+
+	cache = kzalloc(sizeof(*cache), GFP_KERNEL);
+	if (!cache)
+		return false;
+
+	node = crc32(0, np->full_name, strlen(np->full_name));
+	dt_crc = rockchip_opp_sel_dt_crc(np, info);
+
+	mutex_lock(&opp_sel_cache_lock);
+	if (rk_vendor_read(OPP_SEL_CACHE_ID, cache, sizeof(*cache)) !=
+	    sizeof(*cache))
+		goto out;
+	if (cache->tag != OPP_SEL_CACHE_TAG || cache->chip_id != chip_id)
+		goto out;
+	for (i = 0; i < OPP_SEL_CACHE_MAX; i++) {
+		if (cache->entry[i].node != node)
+			continue;
+		if (cache->entry[i].dt_crc != dt_crc)
+			break;
+		info->scale = cache->entry[i].scale;
+		info->volt_sel = cache->entry[i].volt_sel;
+		found = true;
+		break;
+	}
+out:
+	mutex_unlock(&opp_sel_cache_lock);
+	kfree(cache);
+
+	if (found)
+		dev_info(dev, "scale=%d, volt-sel=%d, from cache\n",
+			 info->scale, info->volt_sel);
+
+	return found;
+}
+
+static void rockchip_opp_sel_cache_put(struct device_node *np,
+				       struct rockchip_opp_info *info)
+{
+	struct opp_sel_cache *cache;
+	u32 node, chip_id;
+	int i, slot = -1;
+
+	if (!is_rk_vendor_ready())
+		return;
+	chip_id = rockchip_opp_sel_chip_id();
+	if (!chip_id)
+		return;
+
+	cache = kzalloc(sizeof(*cache), GFP_KERNEL);
+	if (!cache)
+		return;
+
+	node = crc32(0, np->full_name, strlen(np->full_name));
+
+	mutex_lock(&opp_sel_cache_lock);
+	if (rk_vendor_read(OPP_SEL_CACHE_ID, cache, sizeof(*cache)) !=
+	    sizeof(*cache) || cache->tag != OPP_SEL_CACHE_TAG ||
+	    cache->chip_id != chip_id) {
+		memset(cache, 0, sizeof(*cache));
+		cache->tag = OPP_SEL_CACHE_TAG;
+		cache->chip_id = chip_id;
+	}
+	for (i = 0; i < OPP_SEL_CACHE_MAX; i++) {
+		if (cache->entry[i].node == node) {
+			slot = i;
+			break;
+		}
+		if (slot < 0 && !cache->entry[i].node)
+			slot = i;
+	}
+	if (slot >= 0) {
+		cache->entry[slot].node = node;
+		cache->entry[slot].dt_crc = rockchip_opp_sel_dt_crc(np, info);
+		cache->entry[slot].scale = info->scale;
+		cache->entry[slot].volt_sel = info->volt_sel;
+		rk_vendor_write_buffered(OPP_SEL_CACHE_ID, cache,
+					 sizeof(*cache));
+	}
+	mutex_unlock(&opp_sel_cache_lock);
+	kfree(cache);
+}
+
 static void rockchip_get_scale_volt_sel(struct device *dev, char *lkg_name,
 					const char *reg_name,
 					struct rockchip_opp_info *info)
@@ -1488,6 +1643,10 @@ static void rockchip_get_scale_volt_sel(struct device *dev, char *lkg_name,
 		return;
 	}
 
+	if (of_property_read_bool(np, "rockchip,opp-sel-cache") &&
+	    rockchip_opp_sel_cache_get(dev, np, info))
+		goto out;
+
 	rockchip_of_get_lkg_sel(dev, np, lkg_name, info->process,
 				&lkg_volt_sel, &lkg_scale);
 	rockchip_of_get_pvtm_sel(dev, np, info, reg_name, &pvtm_volt_sel,
@@ -1500,6 +1659,9 @@ static void rockchip_get_scale_volt_sel(struct device *dev, char *lkg_name,
 	else
 		info->volt_sel = max(lkg_volt_sel, pvtm_volt_sel);
 
+	if (of_property_read_bool(np, "rockchip,opp-sel-cache"))
+		rockchip_opp_sel_cache_put(np, info);
+out:
 	of_node_put(np);
 }
 
@@ -1700,6 +1862,8 @@ int rockchip_init_opp_info(struct device *dev, struct rockchip_opp_info *info,
 	mutex_init(&info->dvfs_mutex);
 
 	of_property_read_u32(np, "rockchip,init-freq", &info->init_freq);
+	info->is_fast_dvfs = of_property_read_bool(np, "rockchip,fast-dvfs");
+	of_property_read_u32(np, "rockchip,pll-lock-time-us", &info->pll_lock_us);
 
 	info->grf = syscon_regmap_lookup_by_phandle(np, "rockchip,grf");
 	if (IS_ERR(info->grf))
@@ -2206,13 +2370,50 @@ int rockchip_set_intermediate_rate(struct device *dev,
 }
 EXPORT_SYMBOL(rockchip_set_intermediate_rate);
 
-static int rockchip_opp_set_volt(struct device *dev, struct regulator *reg,
-				 struct dev_pm_opp_supply *supply, char *reg_name)
+/*
+ * How much of the vdd ramp can be left to settle in the background. When
+ * scaling up, the pll runs from the slow clock while it relocks, so the
+ * ramp may overlap the lock time. When scaling down, the frequency has
+ * already dropped and nothing waits for the lower voltage, unless a mem
+ * supply is lowered after it.
+ */
+static unsigned int rockchip_opp_ramp_overlap(struct rockchip_opp_info *info,
+					      unsigned long old_volt,
+					      unsigned long new_volt,
+					      unsigned long old_freq,
+					      unsigned long freq,
+					      unsigned int count)
+{
+	if (!info->is_fast_dvfs || info->is_scmi_clk || info->volt_rm_tbl)
+		return 0;
+
+	if (new_volt > old_volt)
+		return freq > old_freq ? info->pll_lock_us : 0;
+
+	return count > 1 ? 0 : UINT_MAX;
+}
+
+static int rockchip_opp_set_volt_overlap(struct device *dev,
+					 struct regulator *reg,
+					 struct dev_pm_opp_supply *supply,
+					 char *reg_name, unsigned int overlap_us)
 {
 	int ret = 0;
 
-	ret = regulator_set_voltage_triplet(reg, supply->u_volt_min,
-					    supply->u_volt, supply->u_volt_max);
+	if (overlap_us) {
+		ret = regulator_set_voltage_overlap(reg, supply->u_volt,
+						    supply->u_volt_max,
+						    overlap_us);
+		if (ret)
+			ret = regulator_set_voltage_overlap(reg,
+							    supply->u_volt_min,
+							    supply->u_volt_max,
+							    overlap_us);
+	} else {
+		ret = regulator_set_voltage_triplet(reg, supply->u_volt_min,
+						    supply->u_volt,
+						    supply->u_volt_max);
+	}
 	if (ret)
 		dev_err(dev, "%s: failed to set voltage (%lu %lu %lu uV): %d\n",
 			reg_name, supply->u_volt_min, supply->u_volt,
@@ -2221,6 +2422,12 @@ static int rockchip_opp_set_volt(struct device *dev, struct regulator *reg,
 	return ret;
 }
 
+static int rockchip_opp_set_volt(struct device *dev, struct regulator *reg,
+				 struct dev_pm_opp_supply *supply, char *reg_name)
+{
+	return rockchip_opp_set_volt_overlap(dev, reg, supply, reg_name, 0);
+}
+
 int rockchip_opp_config_regulators(struct device *dev,
 				   struct dev_pm_opp *old_opp,
 				   struct dev_pm_opp *new_opp,
@@ -2234,6 +2441,7 @@ int rockchip_opp_config_regulators(struct device *dev,
 	struct dev_pm_opp_supply new_supplies[2] = { 0 };
 	unsigned long old_freq, freq;
 	u32 target_rm = UINT_MAX;
+	unsigned int overlap_us;
 	int ret = 0;
 
 	if (count > 1)
@@ -2256,6 +2464,9 @@ int rockchip_opp_config_regulators(struct device *dev,
 
 	old_freq = dev_pm_opp_get_freq(old_opp);
 	freq = dev_pm_opp_get_freq(new_opp);
+	overlap_us = rockchip_opp_ramp_overlap(info, old_supplies[0].u_volt,
+					       new_supplies[0].u_volt,
+					       old_freq, freq, count);
 
 	if (count > 1)
 		dev_dbg(dev, "%lu %lu -> %lu %lu (uV)\n",
@@ -2271,13 +2482,15 @@ int rockchip_opp_config_regulators(struct device *dev,
 			if (ret)
 				goto restore_voltage;
 		}
-		ret = rockchip_opp_set_volt(dev, vdd_reg, &new_supplies[0], "vdd");
+		ret = rockchip_opp_set_volt_overlap(dev, vdd_reg, &new_supplies[0],
+						    "vdd", overlap_us);
 		if (ret)
 			goto restore_voltage;
 		rockchip_set_read_margin(dev, info, target_rm, info->is_runtime_active);
 	} else {
 		rockchip_set_read_margin(dev, info, target_rm, info->is_runtime_active);
-		ret = rockchip_opp_set_volt(dev, vdd_reg, &new_supplies[0], "vdd");
+		ret = rockchip_opp_set_volt_overlap(dev, vdd_reg, &new_supplies[0],
+						    "vdd", overlap_us);
 		if (ret)
 			goto restore_voltage;
 		if (count > 1) {
@@ -6,13 +6,52 @@
 #include <linux/proc_fs.h>
 #include <linux/seq_file.h>
 #include <linux/sched/cputime.h>
+#include <linux/uaccess.h>
+#include <uapi/linux/sched/types.h>
 #include <soc/rockchip/rockchip_performance.h>
 #include <../../kernel/sched/sched.h>
 
+enum {
+	PERF_CLUSTER_ANY = 0,
+	PERF_CLUSTER_LITTLE,
+	PERF_CLUSTER_BIG,
+};
+
+enum {
+	PERF_MISFIT_NEVER = 0,
+	PERF_MISFIT_LEVEL,	/* follow the global level */
+	PERF_MISFIT_EAGER,
+};
+
+/*
+ * Latency classes let audio, camera or ui threads get their own cluster,
+ * uclamp and misfit policy instead of moving the global level.
+ */
+struct perf_class {
+	int cluster;
+	int uclamp_min;		/* -1 for no request */
+	int uclamp_max;		/* -1 for no request */
+	int misfit;
+};
+
+static const char * const perf_cluster_names[] = {
+	[PERF_CLUSTER_ANY] = "any",
+	[PERF_CLUSTER_LITTLE] = "little",
+	[PERF_CLUSTER_BIG] = "big",
+};
+
 static int perf_level = CONFIG_ROCKCHIP_PERFORMANCE_LEVEL;
 static cpumask_var_t cpul_mask, cpub_mask;
 static bool perf_init_done;
 static DEFINE_MUTEX(update_mutex);
+static struct perf_class perf_classes[ROCKCHIP_PERF_CLASS_NUM] = {
+	[0 ... ROCKCHIP_PERF_CLASS_NUM - 1] = {
+		.cluster = PERF_CLUSTER_ANY,
+		.uclamp_min = -1,
+		.uclamp_max = -1,
+		.misfit = PERF_MISFIT_LEVEL,
+	},
+};
 
 #ifdef CONFIG_UCLAMP_TASK
 static inline void set_uclamp_util_min_rt(unsigned int util)
@@ -95,6 +134,173 @@ static const struct kernel_param_ops level_param_ops = {
 };
 module_param_cb(level, &level_param_ops, &perf_level, 0644);
 
+static const struct cpumask *perf_class_cpus(int cluster)
+{
+	if (!static_branch_unlikely(&sched_asym_cpucapacity))
+		return cpu_possible_mask;
+
+	if (cluster == PERF_CLUSTER_LITTLE)
+		return cpul_mask;
+	if (cluster == PERF_CLUSTER_BIG)
+		return cpub_mask;
+
+	return cpu_possible_mask;
+}
+
+int rockchip_perf_set_task_class(struct task_struct *p, int class)
+{
+	struct perf_class pc;
+	int ret;
+
+	if (class < 0 || class >= ROCKCHIP_PERF_CLASS_NUM)
+		return -EINVAL;
+	if (!perf_init_done)
+		return -EBUSY;
+
+	mutex_lock(&update_mutex);
+	pc = perf_classes[class];
+	mutex_unlock(&update_mutex);
+
+	ret = set_cpus_allowed_ptr(p, perf_class_cpus(pc.cluster));
+	if (ret)
+		return ret;
+
+#ifdef CONFIG_UCLAMP_TASK
+	if (!dl_task(p)) {
+		struct sched_attr attr = {
+			.size = sizeof(attr),
+			/* keep the policy, see SETPARAM_POLICY */
+			.sched_policy = -1,
+			.sched_priority = p->rt_priority,
+			.sched_flags = SCHED_FLAG_KEEP_ALL |
+				       SCHED_FLAG_UTIL_CLAMP,
+			.sched_util_min = pc.uclamp_min,
+			.sched_util_max = pc.uclamp_max,
+		};
+
+		ret = sched_setattr_nocheck(p, &attr);
+		if (ret)
+			return ret;
+	}
+#endif
+
+	WRITE_ONCE(p->rk_perf_class, class);
+
+	return 0;
+}
+
+static int perf_class_show(struct seq_file *m, void *v)
+{
+	struct perf_class *pc;
+	int i;
+
+	seq_puts(m, "class cluster uclamp_min uclamp_max misfit\n");
+	mutex_lock(&update_mutex);
+	for (i = 0; i < ROCKCHIP_PERF_CLASS_NUM; i++) {
+		pc = &perf_classes[i];
+		seq_printf(m, "%d %s %d %d %d\n", i,
+			   perf_cluster_names[pc->cluster], pc->uclamp_min,
+			   pc->uclamp_max, pc->misfit);
+	}
+	mutex_unlock(&update_mutex);
+
+	return 0;
+}
+
+static int perf_class_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, perf_class_show, NULL);
+}
+
+/* "<class> <any|little|big> <uclamp_min> <uclamp_max> <misfit>" */
+static ssize_t perf_class_write(struct file *file, const char __user *ubuf,
+				size_t count, loff_t *ppos)
+{
+	struct perf_class pc;
+	char buf[64], name[8];
+	int class, i;
+
+	if (count >= sizeof(buf))
+		return -EINVAL;
+	if (copy_from_user(buf, ubuf, count))
+		return -EFAULT;
+	buf[count] = '\0';
+
+	if (sscanf(buf, "%d %7s %d %d %d", &class, name, &pc.uclamp_min,
+		   &pc.uclamp_max, &pc.misfit) != 5)
+		return -EINVAL;
+	/* class 0 is what every task starts with */
+	if (class <= ROCKCHIP_PERF_CLASS_DEFAULT ||
+	    class >= ROCKCHIP_PERF_CLASS_NUM)
+		return -EINVAL;
+	if (pc.uclamp_min < -1 || pc.uclamp_min > SCHED_CAPACITY_SCALE ||
+	    pc.uclamp_max < -1 || pc.uclamp_max > SCHED_CAPACITY_SCALE ||
+	    pc.misfit < PERF_MISFIT_NEVER || pc.misfit > PERF_MISFIT_EAGER)
+		return -EINVAL;
+	for (i = 0; i < ARRAY_SIZE(perf_cluster_names); i++)
+		if (!strcmp(name, perf_cluster_names[i]))
+			break;
+	if (i == ARRAY_SIZE(perf_cluster_names))
+		return -EINVAL;
+	pc.cluster = i;
+
+	mutex_lock(&update_mutex);
+	perf_classes[class] = pc;
+	mutex_unlock(&update_mutex);
+
+	return count;
+}
+
+static const struct proc_ops perf_class_ops = {
+	.proc_open	= perf_class_open,
+	.proc_read	= seq_read,
+	.proc_write	= perf_class_write,
+	.proc_lseek	= seq_lseek,
+	.proc_release	= single_release,
+};
+
+/* "<pid> <class>", applies the class as it is at the time of the write */
+static ssize_t perf_task_write(struct file *file, const char __user *ubuf,
+			       size_t count, loff_t *ppos)
+{
+	struct task_struct *p;
+	char buf[32];
+	int pid, class, ret;
+
+	if (count >= sizeof(buf))
+		return -EINVAL;
+	if (copy_from_user(buf, ubuf, count))
+		return -EFAULT;
+	buf[count] = '\0';
+
+	if (sscanf(buf, "%d %d", &pid, &class) != 2)
+		return -EINVAL;
+
+	p = find_get_task_by_vpid(pid);
+	if (!p)
+		return -ESRCH;
+	ret = rockchip_perf_set_task_class(p, class);
+	put_task_struct(p);
+
+	return ret ? ret : count;
+}
+
+static const struct proc_ops perf_task_ops = {
+	.proc_write	= perf_task_write,
+};
+
+static void rockchip_perf_proc_init(void)
+{
+	struct proc_dir_entry *dir;
+
+	dir = proc_mkdir("rockchip_perf", NULL);
+	if (!dir)
+		return;
+
+	proc_create("class", 0600, dir, &perf_class_ops);
+	proc_create("task", 0200, dir, &perf_task_ops);
+}
+
 static __init int rockchip_perf_init(void)
 {
 	int cpu;
@@ -113,6 +319,7 @@ static __init int rockchip_perf_init(void)
 	}
 
 	update_perf_level(perf_level);
+	rockchip_perf_proc_init();
 
 	perf_init_done = true;
 
@@ -182,4 +389,28 @@ bool rockchip_perf_misfit_rt(int cpu)
 
 	return false;
 }
+
+bool rockchip_perf_misfit_task(struct task_struct *p, int cpu)
+{
+	int class = READ_ONCE(p->rk_perf_class);
+	struct perf_class *pc;
+
+	if (!perf_init_done || class < 0 || class >= ROCKCHIP_PERF_CLASS_NUM)
+		return false;
+
+	if (!static_branch_unlikely(&sched_asym_cpucapacity))
+		return false;
+
+	pc = &perf_classes[class];
+	switch (pc->misfit) {
+	case PERF_MISFIT_NEVER:
+		return false;
+	case PERF_MISFIT_EAGER:
+		if (pc->cluster == PERF_CLUSTER_LITTLE)
+			return cpumask_test_cpu(cpu, cpub_mask);
+		return cpumask_test_cpu(cpu, cpul_mask);
+	default:
+		return rockchip_perf_misfit_rt(cpu);
+	}
+}
 #endif /* CONFIG_SMP */
@@ -25,6 +25,7 @@ struct rd_device {
 	size_t			mem_pages;
 	void			*mem_kaddr;
 	struct dax_device	*dax_dev;
+	bool			dax_pmd;
 };
 
 static int rd_major;
@@ -191,8 +192,12 @@ static long rd_dax_direct_access(struct dax_device *dax_dev, pgoff_t pgoff,
 	struct rd_device *rd = dax_get_private(dax_dev);
 
 	phys_addr_t offset = PFN_PHYS(pgoff);
-	size_t max_nr_pages = rd->mem_pages - pgoff;
+	size_t max_nr_pages;
 
+	if (pgoff >= rd->mem_pages)
+		return -ERANGE;
+
+	max_nr_pages = rd->mem_pages - pgoff;
 	if (kaddr)
 		*kaddr = rd->mem_kaddr + offset;
 	if (pfn)
@@ -268,6 +273,21 @@ static int rd_init(struct rd_device *rd, int major, int minor)
 	 */
 	blk_queue_physical_block_size(disk->queue, PAGE_SIZE);
 
+	/*
+	 * fs/dax only installs PMD mappings when the pfn and the file
+	 * offset are both PMD aligned. Advertise PMD_SIZE as the optimal
+	 * I/O size so partitioning and mkfs tools align partitions and
+	 * extents to it, letting large files on a DAX mount be mapped
+	 * with huge pages.
+	 */
+	rd->dax_pmd = rd->dax_dev && IS_ENABLED(CONFIG_FS_DAX_PMD) &&
+		      IS_ALIGNED(rd->mem_addr, PMD_SIZE) &&
+		      rd->mem_size >= PMD_SIZE;
+	if (rd->dax_pmd) {
+		blk_queue_io_min(disk->queue, PAGE_SIZE);
+		blk_queue_io_opt(disk->queue, PMD_SIZE);
+	}
+
 	/* Tell the block layer that this is not a rotational device */
 	blk_queue_flag_set(QUEUE_FLAG_NONROT, disk->queue);
 	blk_queue_flag_clear(QUEUE_FLAG_ADD_RANDOM, disk->queue);
@@ -319,8 +339,9 @@ static int rd_probe(struct platform_device *pdev)
 	rd->mem_size = resource_size(&reg);
 
 	ret = rd_init(rd, rd_major, 0);
-	dev_info(dev, "0x%zx@%pa -> 0x%px dax:%d ret:%d\n",
-		 rd->mem_size, &rd->mem_addr, rd->mem_kaddr, (bool)rd->dax_dev, ret);
+	dev_info(dev, "0x%zx@%pa -> 0x%px dax:%d pmd:%d ret:%d\n",
+		 rd->mem_size, &rd->mem_addr, rd->mem_kaddr, (bool)rd->dax_dev,
+		 rd->dax_pmd, ret);
 
 	return ret;
 }
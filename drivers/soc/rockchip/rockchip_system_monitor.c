@@ -42,16 +42,20 @@
 #include "../../regulator/internal.h"
 #include "../../thermal/thermal_core.h"
 
+#define CREATE_TRACE_POINTS
+#include <trace/events/rockchip_system_monitor.h>
+
 #define CPU_REBOOT_FREQ		816000 /* kHz */
 #define VIDEO_1080P_SIZE	(1920 * 1080)
 #define THERMAL_POLLING_DELAY	200 /* milliseconds */
+#define BUDGET_FULL		1000 /* per-mille */
+#define BUDGET_WINDOW		10000 /* millicelsius */
+#define BUDGET_KP		100 /* per-mille per celsius */
+#define BUDGET_KI		20 /* per-mille per celsius-second */
+#define BUDGET_KD		0 /* per-mille per celsius/second */
 
 struct video_info {
-	unsigned int width;
-	unsigned int height;
-	unsigned int ishevc;
-	unsigned int videoFramerate;
-	unsigned int streamBitrate;
+	struct rockchip_video_stream stream;
 	struct list_head node;
 };
 
@@ -79,6 +83,26 @@ struct system_monitor {
 	int temp_hysteresis;
 	unsigned int delay;
 	bool is_temp_offline;
+
+	/* pid controller sharing out a thermal budget, see thermal_budget */
+	int budget_temp;
+	int budget_window;
+	int budget_last_err;
+	u32 budget_pid[3];
+	s64 budget_integral;
+	ktime_t budget_last_time;
+	unsigned int budget;
+	struct mutex budget_lock;
+
+	/* workload power hints, see rockchip_system_monitor_power_hint */
+	spinlock_t hint_lock;
+	struct delayed_work hint_work;
+	struct device *hint_dev;
+	unsigned int hint_power;
+	ktime_t hint_end;
+	unsigned int hint_budget;
+	u32 hint_total_power;
+	u32 hint_temp_margin;
 };
 
 static unsigned long system_status;
@@ -86,6 +110,7 @@ static unsigned long ref_count[32] = {0};
 
 static DEFINE_MUTEX(system_status_mutex);
 static DEFINE_MUTEX(video_info_mutex);
+static DEFINE_MUTEX(video_status_mutex);
 static DEFINE_MUTEX(cpu_on_off_mutex);
 
 static DECLARE_RWSEM(mdev_list_sem);
@@ -322,134 +347,255 @@ int rockchip_add_system_status_interface(struct device *dev)
 }
 EXPORT_SYMBOL(rockchip_add_system_status_interface);
 
-static unsigned long rockchip_get_video_param(char **str)
+static struct rockchip_video_load video_load;
+static unsigned long video_status;
+static BLOCKING_NOTIFIER_HEAD(video_load_notifier_list);
+
+int rockchip_register_video_load_notifier(struct notifier_block *nb)
 {
-	char *p;
-	unsigned long val = 0;
+	return blocking_notifier_chain_register(&video_load_notifier_list, nb);
+}
+EXPORT_SYMBOL(rockchip_register_video_load_notifier);
 
-	strsep(str, "=");
-	p = strsep(str, ",");
-	if (p) {
-		if (kstrtoul(p, 10, &val))
-			return 0;
-	}
+int rockchip_unregister_video_load_notifier(struct notifier_block *nb)
+{
+	return blocking_notifier_chain_unregister(&video_load_notifier_list,
+						  nb);
+}
+EXPORT_SYMBOL(rockchip_unregister_video_load_notifier);
 
-	return val;
+void rockchip_get_video_load(struct rockchip_video_load *load)
+{
+	mutex_lock(&video_info_mutex);
+	*load = video_load;
+	mutex_unlock(&video_info_mutex);
+}
+EXPORT_SYMBOL(rockchip_get_video_load);
+
+static unsigned int rockchip_get_video_codec(const char *name)
+{
+	if (!strcmp(name, "h264"))
+		return ROCKCHIP_VIDEO_CODEC_H264;
+	if (!strcmp(name, "hevc") || !strcmp(name, "h265"))
+		return ROCKCHIP_VIDEO_CODEC_HEVC;
+	if (!strcmp(name, "vp9"))
+		return ROCKCHIP_VIDEO_CODEC_VP9;
+	if (!strcmp(name, "av1"))
+		return ROCKCHIP_VIDEO_CODEC_AV1;
+
+	return ROCKCHIP_VIDEO_CODEC_OTHER;
 }
 
 /*
  * format:
  * 0,width=val,height=val,ishevc=val,videoFramerate=val,streamBitrate=val
  * 1,width=val,height=val,ishevc=val,videoFramerate=val,streamBitrate=val
+ *
+ * or with any subset of, in any order:
+ * 1,codec=h264|hevc|vp9|av1,width=val,height=val,fps=val,depth=val,hdr=val,
+ *   count=val
+ *
+ * streamBitrate carries the bit depth, as in the legacy media framework.
  */
-static struct video_info *rockchip_parse_video_info(const char *buf)
+static int rockchip_parse_video_info(const char *buf,
+				     struct rockchip_video_stream *stream)
 {
-	struct video_info *video_info;
-	const char *cp = buf;
-	char *str, *p;
-	int ntokens = 0;
-
-	while ((cp = strpbrk(cp + 1, ",")))
-		ntokens++;
-	if (ntokens != 5)
-		return NULL;
-
-	video_info = kzalloc(sizeof(*video_info), GFP_KERNEL);
-	if (!video_info)
-		return NULL;
+	char *str, *p, *key, *val;
+	unsigned long v;
+	int ret = 0;
 
-	INIT_LIST_HEAD(&video_info->node);
+	memset(stream, 0, sizeof(*stream));
+	stream->bit_depth = 8;
+	stream->count = 1;
 
 	str = kstrdup(buf, GFP_KERNEL);
-	p = str;
+	if (!str)
+		return -ENOMEM;
+
+	p = strim(str);
 	strsep(&p, ",");
-	video_info->width = rockchip_get_video_param(&p);
-	video_info->height = rockchip_get_video_param(&p);
-	video_info->ishevc = rockchip_get_video_param(&p);
-	video_info->videoFramerate = rockchip_get_video_param(&p);
-	video_info->streamBitrate = rockchip_get_video_param(&p);
-	pr_debug("%c,width=%d,height=%d,ishevc=%d,videoFramerate=%d,streamBitrate=%d\n",
-		 buf[0],
-		 video_info->width,
-		 video_info->height,
-		 video_info->ishevc,
-		 video_info->videoFramerate,
-		 video_info->streamBitrate);
+	while ((val = strsep(&p, ","))) {
+		key = strsep(&val, "=");
+		if (!val) {
+			ret = -EINVAL;
+			break;
+		}
+		if (!strcmp(key, "codec")) {
+			stream->codec = rockchip_get_video_codec(val);
+			continue;
+		}
+		if (kstrtoul(val, 10, &v)) {
+			ret = -EINVAL;
+			break;
+		}
+		if (!strcmp(key, "width"))
+			stream->width = v;
+		else if (!strcmp(key, "height"))
+			stream->height = v;
+		else if (!strcmp(key, "ishevc"))
+			stream->codec = v ? ROCKCHIP_VIDEO_CODEC_HEVC :
+					    ROCKCHIP_VIDEO_CODEC_H264;
+		else if (!strcmp(key, "videoFramerate") || !strcmp(key, "fps"))
+			stream->fps = v;
+		else if (!strcmp(key, "streamBitrate") || !strcmp(key, "depth"))
+			stream->bit_depth = v == 10 ? 10 : 8;
+		else if (!strcmp(key, "hdr"))
+			stream->hdr = !!v;
+		else if (!strcmp(key, "count"))
+			stream->count = v;
+	}
 	kfree(str);
+	if (ret)
+		return ret;
+	if (!stream->width || !stream->height || !stream->count)
+		return -EINVAL;
+
+	pr_debug("%c,codec=%u,width=%u,height=%u,fps=%u,depth=%u,hdr=%u,count=%u\n",
+		 buf[0], stream->codec, stream->width, stream->height,
+		 stream->fps, stream->bit_depth, stream->hdr, stream->count);
+
+	return 0;
+}
 
-	return video_info;
+static bool rockchip_video_stream_equal(const struct rockchip_video_stream *a,
+					const struct rockchip_video_stream *b)
+{
+	return a->codec == b->codec && a->width == b->width &&
+	       a->height == b->height && a->fps == b->fps &&
+	       a->bit_depth == b->bit_depth && a->hdr == b->hdr;
 }
 
-static void rockchip_add_video_info(struct video_info *video_info)
+/* Called with video_info_mutex held, returns the video status bits needed. */
+static unsigned long rockchip_update_video_load(void)
 {
-	if (video_info) {
-		mutex_lock(&video_info_mutex);
-		list_add(&video_info->node, &video_info_list);
-		mutex_unlock(&video_info_mutex);
+	struct video_info *info;
+	struct rockchip_video_stream *stream;
+	struct rockchip_video_load *load = &video_load;
+	unsigned long status = 0;
+	unsigned int pixels;
+	u64 rate;
+
+	memset(load, 0, sizeof(*load));
+	list_for_each_entry(info, &video_info_list, node) {
+		stream = &info->stream;
+		pixels = stream->width * stream->height;
+		/* a stream of unknown rate is accounted at 30fps */
+		rate = (u64)pixels * (stream->fps ? stream->fps : 30) *
+		       stream->count;
+
+		load->streams += stream->count;
+		if (stream->bit_depth > 8)
+			load->pixel_rate_10bit += rate;
+		else
+			load->pixel_rate += rate;
+		load->max_pixels = max(load->max_pixels, pixels);
+		load->max_fps = max(load->max_fps, stream->fps);
+		if (stream->hdr)
+			load->hdr = true;
+
+		if (pixels <= VIDEO_1080P_SIZE) {
+			status |= SYS_STATUS_VIDEO_1080P;
+		} else {
+			status |= SYS_STATUS_VIDEO_4K;
+			if (stream->bit_depth > 8)
+				status |= SYS_STATUS_VIDEO_4K_10B;
+			if (stream->fps >= 60)
+				status |= SYS_STATUS_VIDEO_4K_60P;
+		}
 	}
+
+	return status;
 }
 
-static void rockchip_del_video_info(struct video_info *video_info)
+/*
+ * The registry holds one reference on each SYS_STATUS_VIDEO_* bit it
+ * wants, so stale bits are dropped as streams come and go.
+ */
+static void rockchip_video_load_changed(void)
 {
-	struct video_info *info, *tmp;
+	struct rockchip_video_load load;
+	unsigned long status, old;
 
-	if (!video_info)
-		return;
+	mutex_lock(&video_status_mutex);
+	mutex_lock(&video_info_mutex);
+	status = rockchip_update_video_load();
+	load = video_load;
+	mutex_unlock(&video_info_mutex);
+
+	old = video_status;
+	video_status = status;
+	if (status & ~old)
+		rockchip_set_system_status(status & ~old);
+	if (old & ~status)
+		rockchip_clear_system_status(old & ~status);
+
+	blocking_notifier_call_chain(&video_load_notifier_list, 0, &load);
+	mutex_unlock(&video_status_mutex);
+}
+
+/*
+ * Register one or more identical decode streams. Consumers get the sum of
+ * all streams through rockchip_get_video_load() and the video load
+ * notifier, the coarse SYS_STATUS_VIDEO_* bits are kept for the users of
+ * the system status.
+ */
+int rockchip_add_video_stream(const struct rockchip_video_stream *stream)
+{
+	struct video_info *info, *new;
+
+	if (!stream->width || !stream->height || !stream->count)
+		return -EINVAL;
+
+	new = kzalloc(sizeof(*new), GFP_KERNEL);
+	if (!new)
+		return -ENOMEM;
 
 	mutex_lock(&video_info_mutex);
-	list_for_each_entry_safe(info, tmp, &video_info_list, node) {
-		if (info->width == video_info->width &&
-		    info->height == video_info->height &&
-		    info->ishevc == video_info->ishevc &&
-		    info->videoFramerate == video_info->videoFramerate &&
-		    info->streamBitrate == video_info->streamBitrate) {
-			list_del(&info->node);
-			kfree(info);
+	list_for_each_entry(info, &video_info_list, node) {
+		if (rockchip_video_stream_equal(&info->stream, stream)) {
+			info->stream.count += stream->count;
+			kfree(new);
+			new = NULL;
 			break;
 		}
 	}
-	kfree(video_info);
+	if (new) {
+		new->stream = *stream;
+		list_add(&new->node, &video_info_list);
+	}
 	mutex_unlock(&video_info_mutex);
+
+	rockchip_video_load_changed();
+
+	return 0;
 }
+EXPORT_SYMBOL(rockchip_add_video_stream);
 
-static void rockchip_update_video_info(void)
+void rockchip_del_video_stream(const struct rockchip_video_stream *stream)
 {
-	struct video_info *video_info;
-	unsigned int max_res = 0, max_stream_bitrate = 0, res = 0;
-	unsigned int max_video_framerate = 0;
+	struct video_info *info, *tmp;
 
 	mutex_lock(&video_info_mutex);
-	if (list_empty(&video_info_list)) {
-		mutex_unlock(&video_info_mutex);
-		rockchip_clear_system_status(SYS_STATUS_VIDEO);
-		return;
-	}
-
-	list_for_each_entry(video_info, &video_info_list, node) {
-		res = video_info->width * video_info->height;
-		if (res > max_res)
-			max_res = res;
-		if (video_info->streamBitrate > max_stream_bitrate)
-			max_stream_bitrate = video_info->streamBitrate;
-		if (video_info->videoFramerate > max_video_framerate)
-			max_video_framerate = video_info->videoFramerate;
+	list_for_each_entry_safe(info, tmp, &video_info_list, node) {
+		if (!rockchip_video_stream_equal(&info->stream, stream))
+			continue;
+		if (info->stream.count > stream->count) {
+			info->stream.count -= stream->count;
+		} else {
+			list_del(&info->node);
+			kfree(info);
+		}
+		break;
 	}
 	mutex_unlock(&video_info_mutex);
 
-	if (max_res <= VIDEO_1080P_SIZE) {
-		rockchip_set_system_status(SYS_STATUS_VIDEO_1080P);
-	} else {
-		if (max_stream_bitrate == 10)
-			rockchip_set_system_status(SYS_STATUS_VIDEO_4K_10B);
-		if (max_video_framerate == 60)
-			rockchip_set_system_status(SYS_STATUS_VIDEO_4K_60P);
-		rockchip_set_system_status(SYS_STATUS_VIDEO_4K);
-	}
+	rockchip_video_load_changed();
 }
+EXPORT_SYMBOL(rockchip_del_video_stream);
 
 void rockchip_update_system_status(const char *buf)
 {
-	struct video_info *video_info;
+	struct rockchip_video_stream stream;
 
 	if (!buf)
 		return;
@@ -457,19 +603,13 @@ void rockchip_update_system_status(const char *buf)
 	switch (buf[0]) {
 	case '0':
 		/* clear video flag */
-		video_info = rockchip_parse_video_info(buf);
-		if (video_info) {
-			rockchip_del_video_info(video_info);
-			rockchip_update_video_info();
-		}
+		if (!rockchip_parse_video_info(buf, &stream))
+			rockchip_del_video_stream(&stream);
 		break;
 	case '1':
 		/* set video flag */
-		video_info = rockchip_parse_video_info(buf);
-		if (video_info) {
-			rockchip_add_video_info(video_info);
-			rockchip_update_video_info();
-		}
+		if (!rockchip_parse_video_info(buf, &stream))
+			rockchip_add_video_stream(&stream);
 		break;
 	case 'L':
 		/* clear low power flag */
@@ -1249,6 +1389,13 @@ rockchip_system_monitor_freq_qos_requset(struct monitor_dev_info *info)
 			freq_qos_remove_request(&info->min_sta_freq_req);
 			return ret;
 		}
+		if (system_monitor->budget_temp &&
+		    freq_qos_add_request(&policy->constraints,
+					 &info->max_budget_freq_req,
+					 FREQ_QOS_MAX,
+					 FREQ_QOS_MAX_DEFAULT_VALUE) < 0)
+			dev_info(info->dev,
+				 "failed to add budget freq constraint\n");
 	} else if (info->devp->type == MONITOR_TYPE_DEV) {
 		devfreq = (struct devfreq *)info->devp->data;
 		ret = dev_pm_qos_add_request(devfreq->dev.parent,
@@ -1259,11 +1406,70 @@ rockchip_system_monitor_freq_qos_requset(struct monitor_dev_info *info)
 			dev_info(info->dev, "failed to add freq constraint\n");
 			return ret;
 		}
+		if (system_monitor->budget_temp &&
+		    dev_pm_qos_add_request(devfreq->dev.parent,
+					   &info->dev_max_budget_freq_req,
+					   DEV_PM_QOS_MAX_FREQUENCY,
+					   PM_QOS_MAX_FREQUENCY_DEFAULT_VALUE) < 0)
+			dev_info(info->dev,
+				 "failed to add budget freq constraint\n");
 	}
 
 	return 0;
 }
 
+static void rockchip_system_monitor_budget_init(struct monitor_dev_info *info)
+{
+	struct dev_pm_opp *opp;
+	unsigned long rate = 0;
+
+	if (!system_monitor->budget_temp)
+		return;
+
+	opp = dev_pm_opp_find_freq_ceil(info->dev, &rate);
+	if (IS_ERR(opp))
+		return;
+	dev_pm_opp_put(opp);
+	info->budget_min_freq = rate / 1000;
+
+	rate = ULONG_MAX;
+	opp = dev_pm_opp_find_freq_floor(info->dev, &rate);
+	if (IS_ERR(opp))
+		return;
+	dev_pm_opp_put(opp);
+	info->budget_max_freq = rate / 1000;
+}
+
+static void rockchip_system_monitor_budget_apply(struct monitor_dev_info *info,
+						 unsigned int budget)
+{
+	unsigned long freq;
+
+	if (!info->budget_max_freq)
+		return;
+
+	/* scale linearly between the lowest and highest opp, no cliffs */
+	freq = info->budget_min_freq +
+	       (info->budget_max_freq - info->budget_min_freq) * budget /
+	       BUDGET_FULL;
+
+	if (info->devp->type == MONITOR_TYPE_CPU) {
+		if (!freq_qos_request_active(&info->max_budget_freq_req))
+			return;
+		freq_qos_update_request(&info->max_budget_freq_req,
+					budget >= BUDGET_FULL ?
+					FREQ_QOS_MAX_DEFAULT_VALUE : freq);
+	} else {
+		if (!dev_pm_qos_request_active(&info->dev_max_budget_freq_req))
+			return;
+		dev_pm_qos_update_request(&info->dev_max_budget_freq_req,
+					  budget >= BUDGET_FULL ?
+					  PM_QOS_MAX_FREQUENCY_DEFAULT_VALUE :
+					  freq);
+	}
+	trace_rockchip_thermal_budget_cap(dev_name(info->dev), freq);
+}
+
 int rockchip_monitor_check_rate_volt(struct monitor_dev_info *info)
 {
 	struct device *dev = info->dev;
@@ -1322,7 +1528,11 @@ rockchip_system_monitor_register(struct device *dev,
 	rockchip_system_monitor_early_regulator_init(info);
 	rockchip_system_monitor_wide_temp_init(info);
 	rockchip_system_monitor_check_rate_volt(info);
+	rockchip_system_monitor_budget_init(info);
 	rockchip_system_monitor_freq_qos_requset(info);
+	if (system_monitor->budget < BUDGET_FULL)
+		rockchip_system_monitor_budget_apply(info,
+						     system_monitor->budget);
 
 	down_write(&mdev_list_sem);
 	list_add(&info->node, &monitor_dev_list);
@@ -1348,9 +1558,13 @@ void rockchip_system_monitor_unregister(struct monitor_dev_info *info)
 			freq_qos_remove_request(&info->min_sta_freq_req);
 		if (freq_qos_request_active(&info->max_sta_freq_req))
 			freq_qos_remove_request(&info->max_sta_freq_req);
+		if (freq_qos_request_active(&info->max_budget_freq_req))
+			freq_qos_remove_request(&info->max_budget_freq_req);
 	} else {
 		if (dev_pm_qos_request_active(&info->dev_max_freq_req))
 			dev_pm_qos_remove_request(&info->dev_max_freq_req);
+		if (dev_pm_qos_request_active(&info->dev_max_budget_freq_req))
+			dev_pm_qos_remove_request(&info->dev_max_budget_freq_req);
 	}
 
 	kfree(info->low_temp_adjust_table);
@@ -1399,6 +1613,9 @@ static int rockchip_system_monitor_parse_dt(struct system_monitor *monitor)
 	struct device_node *np = monitor->dev->of_node;
 	const char *tz_name, *buf = NULL;
 
+	monitor->budget = BUDGET_FULL;
+	monitor->hint_budget = BUDGET_FULL;
+
 	if (of_property_read_string(np, "rockchip,video-4k-offline-cpus", &buf))
 		cpumask_clear(&monitor->video_4k_offline_cpus);
 	else
@@ -1427,6 +1644,23 @@ static int rockchip_system_monitor_parse_dt(struct system_monitor *monitor)
 	of_property_read_u32(np, "rockchip,temp-hysteresis",
 			     &system_monitor->temp_hysteresis);
 
+	of_property_read_u32(np, "rockchip,thermal-budget-temp",
+			     &system_monitor->budget_temp);
+	if (of_property_read_u32(np, "rockchip,thermal-budget-window",
+				 &system_monitor->budget_window))
+		system_monitor->budget_window = BUDGET_WINDOW;
+	if (of_property_read_u32_array(np, "rockchip,thermal-budget-pid",
+				       system_monitor->budget_pid, 3)) {
+		system_monitor->budget_pid[0] = BUDGET_KP;
+		system_monitor->budget_pid[1] = BUDGET_KI;
+		system_monitor->budget_pid[2] = BUDGET_KD;
+	}
+	of_property_read_u32(np, "rockchip,power-hint-total-mw",
+			     &system_monitor->hint_total_power);
+	if (of_property_read_u32(np, "rockchip,power-hint-temp-margin",
+				 &system_monitor->hint_temp_margin))
+		system_monitor->hint_temp_margin = system_monitor->budget_window;
+
 	if (of_find_property(np, "rockchip,thermal-governor-dummy", NULL)) {
 		if (monitor->tz->governor->unbind_from_tz)
 			monitor->tz->governor->unbind_from_tz(monitor->tz);
@@ -1496,6 +1730,213 @@ static void rockchip_system_monitor_temp_cpu_on_off(int temp)
 	rockchip_system_monitor_cpu_on_off();
 }
 
+static void rockchip_system_monitor_budget_update(void)
+{
+	struct system_monitor *monitor = system_monitor;
+	struct monitor_dev_info *info;
+	unsigned int budget;
+	unsigned long flags;
+	struct device *hint_dev;
+
+	mutex_lock(&monitor->budget_lock);
+	spin_lock_irqsave(&monitor->hint_lock, flags);
+	hint_dev = monitor->hint_dev;
+	spin_unlock_irqrestore(&monitor->hint_lock, flags);
+
+	down_read(&mdev_list_sem);
+	list_for_each_entry(info, &monitor_dev_list, node) {
+		budget = monitor->budget;
+		if (info->dev != hint_dev)
+			budget = min(budget, monitor->hint_budget);
+		rockchip_system_monitor_budget_apply(info, budget);
+	}
+	up_read(&mdev_list_sem);
+	mutex_unlock(&monitor->budget_lock);
+}
+
+/*
+ * Share one thermal budget between cpu, gpu, npu and dmc: a pid loop on
+ * the distance to budget_temp gives a per-mille budget, and every device
+ * is capped at the same fraction of its opp range. Throughput then
+ * settles where the heat stays at budget_temp instead of bouncing
+ * between full speed and the coarse high temperature limits.
+ */
+static void rockchip_system_monitor_thermal_budget(int temp)
+{
+	struct system_monitor *monitor = system_monitor;
+	s64 integral, deriv, out;
+	unsigned int budget;
+	ktime_t now;
+	int err, dt;
+
+	if (!monitor->budget_temp)
+		return;
+
+	now = ktime_get();
+	dt = ktime_ms_delta(now, monitor->budget_last_time);
+	monitor->budget_last_time = now;
+	if (dt <= 0 || dt > 10 * monitor->delay)
+		dt = monitor->delay;
+
+	err = monitor->budget_temp - temp;
+	if (err > monitor->budget_window) {
+		monitor->budget_integral = 0;
+		deriv = 0;
+		budget = BUDGET_FULL;
+		goto apply;
+	}
+
+	integral = monitor->budget_integral + div_s64((s64)err * dt, 1000);
+	deriv = div_s64((s64)(err - monitor->budget_last_err) * 1000, dt);
+	out = BUDGET_FULL +
+	      div_s64((s64)monitor->budget_pid[0] * err +
+		      monitor->budget_pid[1] * integral +
+		      monitor->budget_pid[2] * deriv, 1000);
+	/* only integrate while not saturated to avoid windup */
+	if (out > 0 && out < BUDGET_FULL)
+		monitor->budget_integral = integral;
+	budget = clamp_t(s64, out, 0, BUDGET_FULL);
+
+apply:
+	monitor->budget_last_err = err;
+	trace_rockchip_thermal_budget(temp, err, monitor->budget_integral,
+				      deriv, budget);
+	if (budget == monitor->budget)
+		return;
+	monitor->budget = budget;
+
+	rockchip_system_monitor_budget_update();
+}
+
+/*
+ * Hinted power eats into the total, everything but the hinting device
+ * is capped to what is left before the heat shows up on the sensor.
+ */
+static void rockchip_system_monitor_hint_work(struct work_struct *work)
+{
+	struct system_monitor *monitor = system_monitor;
+	unsigned int budget = BUDGET_FULL;
+	unsigned long flags;
+	s64 left;
+
+	spin_lock_irqsave(&monitor->hint_lock, flags);
+	left = ktime_ms_delta(monitor->hint_end, ktime_get());
+	if (left <= 0) {
+		monitor->hint_dev = NULL;
+		monitor->hint_power = 0;
+	} else if (monitor->last_temp != INT_MAX &&
+		   monitor->last_temp + (int)monitor->hint_temp_margin >=
+		   monitor->budget_temp) {
+		if (monitor->hint_power >= monitor->hint_total_power)
+			budget = 0;
+		else
+			budget = (monitor->hint_total_power -
+				  monitor->hint_power) * BUDGET_FULL /
+				 monitor->hint_total_power;
+	}
+	spin_unlock_irqrestore(&monitor->hint_lock, flags);
+
+	if (left > 0)
+		mod_delayed_work(system_freezable_wq, &monitor->hint_work,
+				 msecs_to_jiffies(left));
+
+	if (budget == monitor->hint_budget)
+		return;
+	monitor->hint_budget = budget;
+
+	rockchip_system_monitor_budget_update();
+}
+
+/**
+ * rockchip_system_monitor_power_hint() - announce an upcoming power spike
+ * @dev: the device about to load, e.g. the npu before a model runs
+ * @power_mw: expected power of @dev
+ * @duration_ms: how long the load is expected to last
+ *
+ * May be called from atomic context. A stronger hint replaces a weaker
+ * one, the hint expires on its own after @duration_ms.
+ */
+void rockchip_system_monitor_power_hint(struct device *dev,
+					unsigned int power_mw,
+					unsigned int duration_ms)
+{
+	struct system_monitor *monitor = system_monitor;
+	unsigned long flags;
+	ktime_t now;
+
+	if (!monitor || !monitor->budget_temp || !monitor->hint_total_power)
+		return;
+
+	now = ktime_get();
+	spin_lock_irqsave(&monitor->hint_lock, flags);
+	if (ktime_after(now, monitor->hint_end) ||
+	    power_mw >= monitor->hint_power) {
+		monitor->hint_dev = dev;
+		monitor->hint_power = power_mw;
+		monitor->hint_end = ktime_add_ms(now, duration_ms);
+	}
+	spin_unlock_irqrestore(&monitor->hint_lock, flags);
+
+	mod_delayed_work(system_freezable_wq, &monitor->hint_work, 0);
+}
+EXPORT_SYMBOL(rockchip_system_monitor_power_hint);
+
+/* the fastest active display, for devices pacing their work to frames */
+static DEFINE_SPINLOCK(vsync_lock);
+static ktime_t vsync_last;
+static u32 vsync_period;
+
+/**
+ * rockchip_system_monitor_vsync() - report a display vblank
+ * @timestamp: time of the vblank
+ * @period_ns: frame period of the display
+ *
+ * May be called from interrupt context. With several displays active the
+ * one with the shortest frame period is tracked, a slower display takes
+ * over once the faster one stops reporting for two frames.
+ */
+void rockchip_system_monitor_vsync(ktime_t timestamp, u32 period_ns)
+{
+	unsigned long flags;
+
+	if (!period_ns)
+		return;
+
+	spin_lock_irqsave(&vsync_lock, flags);
+	if (!vsync_period || period_ns <= vsync_period ||
+	    ktime_after(timestamp, ktime_add_ns(vsync_last, 2ULL * vsync_period))) {
+		vsync_last = timestamp;
+		vsync_period = period_ns;
+	}
+	spin_unlock_irqrestore(&vsync_lock, flags);
+}
+EXPORT_SYMBOL(rockchip_system_monitor_vsync);
+
+/**
+ * rockchip_system_monitor_get_vsync() - get the last reported vblank
+ * @last: time of the last vblank
+ * @period_ns: frame period of the display
+ *
+ * Return: false if no display reported a vblank in the last two frames.
+ */
+bool rockchip_system_monitor_get_vsync(ktime_t *last, u32 *period_ns)
+{
+	unsigned long flags;
+	bool active;
+
+	spin_lock_irqsave(&vsync_lock, flags);
+	*last = vsync_last;
+	*period_ns = vsync_period;
+	spin_unlock_irqrestore(&vsync_lock, flags);
+
+	active = *period_ns &&
+		 ktime_before(ktime_get(),
+			      ktime_add_ns(*last, 2ULL * *period_ns));
+
+	return active;
+}
+EXPORT_SYMBOL(rockchip_system_monitor_get_vsync);
+
 static void rockchip_system_monitor_thermal_update(void)
 {
 	int temp, ret;
@@ -1507,6 +1948,8 @@ static void rockchip_system_monitor_thermal_update(void)
 
 	dev_dbg(system_monitor->dev, "temperature=%d\n", temp);
 
+	rockchip_system_monitor_thermal_budget(temp);
+
 	if (temp < system_monitor->last_temp &&
 	    system_monitor->last_temp - temp <= 2000)
 		goto out;
@@ -1786,6 +2229,10 @@ static int rockchip_system_monitor_probe(struct platform_device *pdev)
 	rockchip_system_monitor_parse_dt(system_monitor);
 	if (system_monitor->tz) {
 		system_monitor->last_temp = INT_MAX;
+		mutex_init(&system_monitor->budget_lock);
+		spin_lock_init(&system_monitor->hint_lock);
+		INIT_DELAYED_WORK(&system_monitor->hint_work,
+				  rockchip_system_monitor_hint_work);
 		INIT_DELAYED_WORK(&system_monitor->thermal_work,
 				  rockchip_system_monitor_thermal_check);
 		mod_delayed_work(system_freezable_wq,
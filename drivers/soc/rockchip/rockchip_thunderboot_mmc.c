@@ -14,6 +14,7 @@
 #include <linux/platform_device.h>
 #include <linux/soc/rockchip/rockchip_decompress.h>
 #include <linux/soc/rockchip/rockchip_thunderboot_crypto.h>
+#include <linux/soc/rockchip/rockchip_thunderboot_preload.h>
 
 #define SDMMC_RINTSTS		0x044
 #define SDMMC_STATUS		0x048
@@ -68,9 +69,13 @@ static int rk_tb_mmc_thread(void *p)
 	status = readl_relaxed(regs + SDMMC_RINTSTS);
 	if (status & SDMMC_INTR_ERROR) {
 		dev_err(dev, "SDMMC_INTR_ERROR status: 0x%08x\n", status);
+		rk_tb_preload_complete(dev->of_node, -EIO);
 		goto out;
 	}
 
+	/* Loader DMA is done, hand preloaded regions to their consumers */
+	rk_tb_preload_complete(dev->of_node, 0);
+
 	/* Parse ramdisk addr and help start decompressing */
 	if (rds && rdd) {
 		struct resource src, dst;
@@ -0,0 +1,76 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Copyright (C) 2023 Rockchip Electronics Co., Ltd.
+ *
+ * The loader streams the regions listed in "memory-region-preload" of the
+ * thunder boot storage node while the kernel boots. Once the storage
+ * thread sees the loader DMA finished it publishes them here, so that
+ * consumers (isp, npu models, ...) can pick their data up directly
+ * instead of reading it again from storage.
+ */
+#include <linux/completion.h>
+#include <linux/kernel.h>
+#include <linux/of.h>
+#include <linux/of_address.h>
+#include <linux/soc/rockchip/rockchip_thunderboot_preload.h>
+#include <linux/string.h>
+
+#define RK_TB_PRELOAD_MAX	8
+
+struct rk_tb_preload {
+	const char *name;
+	struct resource res;
+};
+
+static struct rk_tb_preload preloads[RK_TB_PRELOAD_MAX];
+static int num_preloads;
+static int preload_err;
+static DECLARE_COMPLETION(preload_done);
+
+void rk_tb_preload_complete(struct device_node *np, int err)
+{
+	struct device_node *mem;
+	int i, n;
+
+	if (completion_done(&preload_done))
+		return;
+
+	n = of_property_count_strings(np, "memory-region-preload-names");
+	for (i = 0; !err && i < n && num_preloads < RK_TB_PRELOAD_MAX; i++) {
+		struct rk_tb_preload *p = &preloads[num_preloads];
+
+		mem = of_parse_phandle(np, "memory-region-preload", i);
+		if (!mem)
+			break;
+
+		if (!of_property_read_string_index(np, "memory-region-preload-names",
+						   i, &p->name) &&
+		    !of_address_to_resource(mem, 0, &p->res))
+			num_preloads++;
+		of_node_put(mem);
+	}
+
+	preload_err = err;
+	complete_all(&preload_done);
+}
+
+int rk_tb_preload_get(const char *name, struct resource *res, unsigned long timeout)
+{
+	int i;
+
+	if (!wait_for_completion_timeout(&preload_done, timeout))
+		return -ETIMEDOUT;
+
+	if (preload_err)
+		return preload_err;
+
+	for (i = 0; i < num_preloads; i++) {
+		if (!strcmp(preloads[i].name, name)) {
+			*res = preloads[i].res;
+			return 0;
+		}
+	}
+
+	return -ENOENT;
+}
+EXPORT_SYMBOL(rk_tb_preload_get);
@@ -13,6 +13,7 @@
 #include <linux/platform_device.h>
 #include <linux/soc/rockchip/rockchip_decompress.h>
 #include <linux/soc/rockchip/rockchip_thunderboot_crypto.h>
+#include <linux/soc/rockchip/rockchip_thunderboot_preload.h>
 
 #define SFC_ICLR	0x08
 #define SFC_SR		0x24
@@ -53,6 +54,7 @@ static int rk_tb_sfc_thread(void *p)
 				 1000 * USEC_PER_MSEC);
 	if (ret) {
 		dev_err(dev, "Wait for SFC idle timeout!\n");
+		rk_tb_preload_complete(dev->of_node, ret);
 		goto out;
 	} else {
 		if (likely(readl(regs + SFC_RAWISR) & DMA_INT))
@@ -61,6 +63,9 @@ static int rk_tb_sfc_thread(void *p)
 			dev_err(dev, "Last transfer non DMA!\n");
 	}
 
+	/* Loader DMA is done, hand preloaded regions to their consumers */
+	rk_tb_preload_complete(dev->of_node, 0);
+
 	/* Parse ramdisk addr and help start decompressing */
 	if (rds && rdd) {
 		struct resource src, dst;
@@ -118,9 +118,10 @@ static int emmc_vendor_read(u32 id, void *pbuf, u32 size)
 	return (-1);
 }
 
-static int emmc_vendor_write(u32 id, void *pbuf, u32 size)
+/* Update an item in the in-memory copy only, see emmc_vendor_commit() */
+static int emmc_vendor_update(u32 id, void *pbuf, u32 size)
 {
-	u32 i, j, next_index, align_size, alloc_size, item_num;
+	u32 i, j, align_size, alloc_size, item_num;
 	u32 offset, next_size;
 	u8 *p_data;
 	struct vendor_item *item;
@@ -132,7 +133,6 @@ static int emmc_vendor_write(u32 id, void *pbuf, u32 size)
 	p_data = g_vendor->data;
 	item_num = g_vendor->item_num;
 	align_size = ALIGN(size, 0x40); /* align to 64 bytes*/
-	next_index = g_vendor->next_index;
 	for (i = 0; i < item_num; i++) {
 		item = &g_vendor->item[i];
 		if (item->id == id) {
@@ -168,14 +168,6 @@ static int emmc_vendor_write(u32 id, void *pbuf, u32 size)
 				       size);
 				g_vendor->item[i].size = size;
 			}
-			g_vendor->version++;
-			g_vendor->version2 = g_vendor->version;
-			g_vendor->next_index++;
-			if (g_vendor->next_index >= EMMC_VENDOR_PART_NUM)
-				g_vendor->next_index = 0;
-			emmc_vendor_ops((u8 *)g_vendor, EMMC_VENDOR_PART_START +
-					EMMC_VENDOR_PART_SIZE * next_index,
-					EMMC_VENDOR_PART_SIZE, 1);
 			return 0;
 		}
 	}
@@ -189,19 +181,62 @@ static int emmc_vendor_write(u32 id, void *pbuf, u32 size)
 		g_vendor->free_size -= align_size;
 		memcpy(&g_vendor->data[item->offset], pbuf, size);
 		g_vendor->item_num++;
-		g_vendor->version++;
-		g_vendor->version2 = g_vendor->version;
-		g_vendor->next_index++;
-		if (g_vendor->next_index >= EMMC_VENDOR_PART_NUM)
-			g_vendor->next_index = 0;
-		emmc_vendor_ops((u8 *)g_vendor, EMMC_VENDOR_PART_START +
-				EMMC_VENDOR_PART_SIZE * next_index,
-				EMMC_VENDOR_PART_SIZE, 1);
 		return 0;
 	}
 	return(-1);
 }
 
+static int emmc_vendor_commit(void)
+{
+	u32 next_index;
+
+	if (!g_vendor)
+		return -ENOMEM;
+
+	next_index = g_vendor->next_index;
+	g_vendor->version++;
+	g_vendor->version2 = g_vendor->version;
+	g_vendor->next_index++;
+	if (g_vendor->next_index >= EMMC_VENDOR_PART_NUM)
+		g_vendor->next_index = 0;
+	return emmc_vendor_ops((u8 *)g_vendor, EMMC_VENDOR_PART_START +
+			       EMMC_VENDOR_PART_SIZE * next_index,
+			       EMMC_VENDOR_PART_SIZE, 1);
+}
+
+static int emmc_vendor_write(u32 id, void *pbuf, u32 size)
+{
+	int ret;
+
+	ret = emmc_vendor_update(id, pbuf, size);
+	if (ret)
+		return ret;
+	return emmc_vendor_commit();
+}
+
+/* Write-back entry points, serialised against the ioctl path */
+static int emmc_vendor_update_locked(u32 id, void *pbuf, u32 size)
+{
+	int ret;
+
+	mutex_lock(&vendor_ops_mutex);
+	ret = emmc_vendor_update(id, pbuf, size);
+	mutex_unlock(&vendor_ops_mutex);
+
+	return ret;
+}
+
+static int emmc_vendor_commit_locked(void)
+{
+	int ret;
+
+	mutex_lock(&vendor_ops_mutex);
+	ret = emmc_vendor_commit();
+	mutex_unlock(&vendor_ops_mutex);
+
+	return ret;
+}
+
 #ifdef CONFIG_ROCKCHIP_VENDOR_STORAGE_UPDATE_LOADER
 static int id_blk_read_data(u32 index, u32 n_sec, u8 *buf)
 {
@@ -557,6 +592,8 @@ static int vendor_init_thread(void *arg)
 	if (!ret) {
 		ret = misc_register(&vender_storage_dev);
 		rk_vendor_register(emmc_vendor_read, emmc_vendor_write);
+		rk_vendor_register_writeback(emmc_vendor_update_locked,
+					     emmc_vendor_commit_locked);
 	} else {
 		kfree(g_vendor);
 		g_vendor = NULL;
@@ -575,6 +612,7 @@ static int __init vendor_storage_init(void)
 static __exit void vendor_storage_deinit(void)
 {
 	if (g_vendor) {
+		rk_vendor_flush();
 		misc_deregister(&vender_storage_dev);
 		kfree(g_vendor);
 		g_vendor = NULL;
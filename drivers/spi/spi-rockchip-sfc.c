@@ -181,6 +181,9 @@
 /* DMA is only enabled for large data transmission */
 #define SFC_DMA_TRANS_THRETHOLD		(0x40)
 
+/* Dirmap read ahead, kept in the dma bounce buffer */
+#define SFC_DIRMAP_PREFETCH_SIZE	(0x4000U)
+
 /* Maximum clock values from datasheet suggest keeping clock value under
  * 150MHz. No minimum or average value is suggested.
  */
@@ -203,6 +206,11 @@ struct rockchip_sfc {
 	/* virtual mapped addr for dma_buffer */
 	void *buffer;
 	dma_addr_t dma_buffer;
+	/* dirmap read ahead data held in buffer, invalid if desc is NULL */
+	u32 prefetch_size;
+	struct spi_mem_dirmap_desc *prefetch_desc;
+	u64 prefetch_offs;
+	u32 prefetch_len;
 	struct completion cp;
 	bool use_dma;
 	u32 max_iosize;
@@ -576,7 +584,8 @@ static int rockchip_sfc_xfer_data_dma(struct rockchip_sfc *sfc,
 #endif
 	if (op->data.dir == SPI_MEM_DATA_IN) {
 		dma_sync_single_for_cpu(sfc->dev, sfc->dma_buffer, len, DMA_FROM_DEVICE);
-		memcpy(op->data.buf.in, sfc->buffer, len);
+		if (op->data.buf.in != sfc->buffer)
+			memcpy(op->data.buf.in, sfc->buffer, len);
 	}
 #ifdef ROCKCHIP_SFC_VERBOSE
 	end_time = ktime_get();
@@ -762,6 +771,9 @@ static int rockchip_sfc_exec_mem_op(struct spi_mem *mem, const struct spi_mem_op
 			sfc->speed[cs], rockchip_sfc_clk_get_rate(sfc));
 	}
 
+	/* Any op may change the flash contents or reuse the buffer */
+	sfc->prefetch_desc = NULL;
+
 	rockchip_sfc_adjust_op_work((struct spi_mem_op *)op);
 	rockchip_sfc_set_cs_gpio(sfc, cs, true);
 	rockchip_sfc_xfer_setup(sfc, mem, op, len);
@@ -811,10 +823,84 @@ static bool rockchip_sfc_supports_op(struct spi_mem *mem, const struct spi_mem_o
 	return true;
 }
 
+static int rockchip_sfc_dirmap_create(struct spi_mem_dirmap_desc *desc)
+{
+	struct rockchip_sfc *sfc = spi_master_get_devdata(desc->mem->spi->master);
+
+	if (!sfc->use_dma || !sfc->prefetch_size)
+		return -EOPNOTSUPP;
+
+	/* Writes keep going through exec_op */
+	if (desc->info.op_tmpl.data.dir != SPI_MEM_DATA_IN)
+		return -EOPNOTSUPP;
+
+	if (!rockchip_sfc_supports_op(desc->mem, &desc->info.op_tmpl))
+		return -EOPNOTSUPP;
+
+	return 0;
+}
+
+static void rockchip_sfc_dirmap_destroy(struct spi_mem_dirmap_desc *desc)
+{
+	struct rockchip_sfc *sfc = spi_master_get_devdata(desc->mem->spi->master);
+
+	if (sfc->prefetch_desc == desc)
+		sfc->prefetch_desc = NULL;
+}
+
+/*
+ * Small sequential reads, such as mtdblock sectors or a SPI NAND page
+ * read in pieces, are served from a read ahead window in the dma bounce
+ * buffer instead of issuing a flash command for each of them.
+ */
+static ssize_t rockchip_sfc_dirmap_read(struct spi_mem_dirmap_desc *desc,
+					u64 offs, size_t len, void *buf)
+{
+	struct rockchip_sfc *sfc = spi_master_get_devdata(desc->mem->spi->master);
+	struct spi_mem_op op = desc->info.op_tmpl;
+	u32 nbytes;
+	int ret;
+
+	if (sfc->prefetch_desc == desc && offs >= sfc->prefetch_offs &&
+	    offs + len <= sfc->prefetch_offs + sfc->prefetch_len) {
+		memcpy(buf, sfc->buffer + (offs - sfc->prefetch_offs), len);
+
+		return len;
+	}
+
+	op.addr.val = desc->info.offset + offs;
+
+	/* Nothing to gain for large reads, transfer them straight away */
+	if (len >= sfc->prefetch_size) {
+		op.data.nbytes = min_t(size_t, len, sfc->max_iosize);
+		op.data.buf.in = buf;
+		ret = rockchip_sfc_exec_mem_op(desc->mem, &op);
+
+		return ret ? ret : op.data.nbytes;
+	}
+
+	nbytes = min_t(u64, sfc->prefetch_size, desc->info.length - offs);
+	op.data.nbytes = nbytes;
+	op.data.buf.in = sfc->buffer;
+	ret = rockchip_sfc_exec_mem_op(desc->mem, &op);
+	if (ret)
+		return ret;
+
+	sfc->prefetch_desc = desc;
+	sfc->prefetch_offs = offs;
+	sfc->prefetch_len = nbytes;
+	memcpy(buf, sfc->buffer, len);
+
+	return len;
+}
+
 static const struct spi_controller_mem_ops rockchip_sfc_mem_ops = {
 	.exec_op = rockchip_sfc_exec_mem_op,
 	.adjust_op_size = rockchip_sfc_adjust_op_size,
 	.supports_op = rockchip_sfc_supports_op,
+	.dirmap_create = rockchip_sfc_dirmap_create,
+	.dirmap_destroy = rockchip_sfc_dirmap_destroy,
+	.dirmap_read = rockchip_sfc_dirmap_read,
 };
 
 static irqreturn_t rockchip_sfc_irq_handler(int irq, void *dev_id)
@@ -987,6 +1073,11 @@ static int rockchip_sfc_probe(struct platform_device *pdev)
 	sfc->version = rockchip_sfc_get_version(sfc);
 	sfc->max_iosize = rockchip_sfc_get_max_iosize(sfc);
 
+	sfc->prefetch_size = SFC_DIRMAP_PREFETCH_SIZE;
+	of_property_read_u32(sfc->dev->of_node, "rockchip,prefetch-size",
+			     &sfc->prefetch_size);
+	sfc->prefetch_size = min(ALIGN_DOWN(sfc->prefetch_size, 4), sfc->max_iosize);
+
 	master->mode_bits = SPI_TX_QUAD | SPI_TX_DUAL | SPI_RX_QUAD | SPI_RX_DUAL;
 	if (sfc->version >= SFC_VER_8)
 		master->mode_bits |= SPI_TX_OCTAL | SPI_RX_OCTAL;
@@ -12,13 +12,18 @@
 #include <linux/gpio.h>
 #include <linux/interrupt.h>
 #include <linux/iopoll.h>
+#include <linux/miscdevice.h>
 #include <linux/module.h>
 #include <linux/of.h>
 #include <linux/of_address.h>
 #include <linux/platform_device.h>
+#include <linux/poll.h>
+#include <linux/sizes.h>
 #include <linux/spi/spi.h>
 #include <linux/pm_runtime.h>
 #include <linux/dma-mapping.h>
+#include <linux/uaccess.h>
+#include <linux/rk-spi-slave.h>
 
 #define DRIVER_NAME "rockchip-spi-slave"
 
@@ -153,6 +158,8 @@
  */
 #define ROCKCHIP_SPI_CLK_TO_CS_DEASSERT_US	10000
 
+#define ROCKCHIP_SPI_RING_MAX_SIZE		SZ_4M
+
 enum rockchip_spi_slave_xfer_mode {
 	ROCKCHIP_SPI_DMA,
 	ROCKCHIP_SPI_IRQ,
@@ -197,6 +204,29 @@ struct rockchip_spi {
 
 	bool verbose;
 	ktime_t dbg_time;
+
+	/*
+	 * Ring mode: the rx dma runs cyclically into ring_buf until stopped,
+	 * so a master streaming without gaps loses nothing between messages.
+	 * ring_lock serializes it against the spi message path, ring_spin
+	 * protects the positions updated from the dma callback.
+	 */
+	struct miscdevice ring_misc;
+	struct mutex ring_lock;
+	spinlock_t ring_spin;
+	wait_queue_head_t ring_wait;
+	atomic_t ring_open;
+	bool ring_active;
+	void *ring_buf;
+	dma_addr_t ring_phys;
+	u32 ring_size;
+	u32 ring_watermark;
+	u32 ring_pos;
+	dma_cookie_t ring_cookie;
+	u64 ring_head;
+	u64 ring_tail;
+	u32 ring_overruns;
+	u32 ring_fifo_overruns;
 };
 
 static inline void spi_enable_chip(struct rockchip_spi *rs, bool enable)
@@ -308,6 +338,14 @@ static irqreturn_t rockchip_spi_slave_isr(int irq, void *dev_id)
 	struct spi_controller *ctlr = dev_id;
 	struct rockchip_spi *rs = spi_controller_get_devdata(ctlr);
 
+	if (rs->ring_active) {
+		if (readl_relaxed(rs->regs + ROCKCHIP_SPI_ISR) & INT_RF_OVERFLOW) {
+			rs->ring_fifo_overruns++;
+			writel_relaxed(ICR_RF_OVERFLOW, rs->regs + ROCKCHIP_SPI_ICR);
+		}
+		return IRQ_HANDLED;
+	}
+
 	if (rs->xfer_mode == ROCKCHIP_SPI_IRQ) {
 		if (rs->tx_left)
 			rockchip_spi_slave_pio_writer(rs);
@@ -634,6 +672,13 @@ static int rockchip_spi_slave_do_one_msg(struct spi_controller *ctlr, struct spi
 	bool use_dma;
 	u32 status;
 
+	mutex_lock(&rs->ring_lock);
+	if (rs->ring_active) {
+		dev_err(rs->dev, "ring mode is running\n");
+		ret = -EBUSY;
+		goto out;
+	}
+
 	WARN_ON(readl_relaxed(rs->regs + ROCKCHIP_SPI_SSIENR) &&
 		(readl_relaxed(rs->regs + ROCKCHIP_SPI_SR) & SR_BUSY));
 
@@ -709,12 +754,328 @@ static int rockchip_spi_slave_do_one_msg(struct spi_controller *ctlr, struct spi
 	}
 
 out:
+	mutex_unlock(&rs->ring_lock);
 	m->status = ret;
 
 	spi_finalize_current_message(ctlr);
 	return 0;
 }
 
+/* Caller holds ring_spin */
+static void rockchip_spi_slave_ring_update(struct rockchip_spi *rs)
+{
+	struct spi_controller *ctlr = dev_get_drvdata(rs->dev);
+	struct dma_tx_state state;
+	u32 pos;
+
+	if (dmaengine_tx_status(ctlr->dma_rx, rs->ring_cookie, &state) == DMA_ERROR)
+		return;
+
+	pos = rs->ring_size - state.residue;
+	if (pos >= rs->ring_size)
+		pos = 0;
+
+	rs->ring_head += (pos + rs->ring_size - rs->ring_pos) % rs->ring_size;
+	rs->ring_pos = pos;
+
+	if (rs->ring_head - rs->ring_tail > rs->ring_size) {
+		rs->ring_tail = rs->ring_head - rs->ring_size;
+		rs->ring_overruns++;
+	}
+}
+
+static void rockchip_spi_slave_ring_cb(void *data)
+{
+	struct rockchip_spi *rs = data;
+	unsigned long flags;
+	bool wake;
+
+	spin_lock_irqsave(&rs->ring_spin, flags);
+	rockchip_spi_slave_ring_update(rs);
+	wake = rs->ring_head - rs->ring_tail >= rs->ring_watermark;
+	spin_unlock_irqrestore(&rs->ring_spin, flags);
+
+	if (wake)
+		wake_up_interruptible(&rs->ring_wait);
+}
+
+static int rockchip_spi_slave_ring_start(struct rockchip_spi *rs,
+					 struct rkspi_ring_config *cfg)
+{
+	struct spi_controller *ctlr = dev_get_drvdata(rs->dev);
+	struct dma_async_tx_descriptor *rxdesc;
+	u32 cr0 = CR0_FRF_SPI  << CR0_FRF_OFFSET
+		| CR0_BHT_8BIT << CR0_BHT_OFFSET
+		| CR0_EM_BIG   << CR0_EM_OFFSET
+		| CR0_OPM_SLAVE << CR0_OPM_OFFSET
+		| CR0_XFM_RO << CR0_XFM_OFFSET;
+	struct dma_slave_config rxconf = {
+		.direction = DMA_DEV_TO_MEM,
+		.src_addr = rs->dma_addr_rx,
+	};
+	u32 burst, val;
+	int ret;
+
+	if (rs->ring_active)
+		return -EBUSY;
+
+	switch (cfg->bits_per_word) {
+	case 8:
+		cr0 |= CR0_DFS_8BIT << CR0_DFS_OFFSET;
+		rs->n_bytes = 1;
+		break;
+	case 16:
+		cr0 |= CR0_DFS_16BIT << CR0_DFS_OFFSET;
+		rs->n_bytes = 2;
+		break;
+	default:
+		return -EINVAL;
+	}
+
+	if (cfg->mode & ~(SPI_CPOL | SPI_CPHA | SPI_LSB_FIRST))
+		return -EINVAL;
+	cr0 |= (cfg->mode & 0x3U) << CR0_SCPH_OFFSET;
+	if (cfg->mode & SPI_LSB_FIRST)
+		cr0 |= CR0_FBM_LSB << CR0_FBM_OFFSET;
+
+	if (!cfg->period || cfg->period % rs->n_bytes ||
+	    cfg->size % cfg->period || cfg->size / cfg->period < 2 ||
+	    cfg->size > ROCKCHIP_SPI_RING_MAX_SIZE ||
+	    cfg->watermark > cfg->size)
+		return -EINVAL;
+
+	/* The ring stays allocated while mmap()ed, only the same size can restart */
+	if (rs->ring_buf && rs->ring_size != cfg->size)
+		return -EBUSY;
+
+	if (!rs->ring_buf) {
+		rs->ring_buf = dma_alloc_coherent(rs->dev, cfg->size, &rs->ring_phys,
+						  GFP_KERNEL);
+		if (!rs->ring_buf)
+			return -ENOMEM;
+		rs->ring_size = cfg->size;
+	}
+
+	ret = pm_runtime_resume_and_get(rs->dev);
+	if (ret < 0)
+		return ret;
+
+	burst = rockchip_spi_slave_calc_burst_size(rs, cfg->period / rs->n_bytes);
+	rxconf.src_addr_width = rs->n_bytes;
+	rxconf.src_maxburst = burst;
+	dmaengine_slave_config(ctlr->dma_rx, &rxconf);
+
+	rxdesc = dmaengine_prep_dma_cyclic(ctlr->dma_rx, rs->ring_phys, rs->ring_size,
+					   cfg->period, DMA_DEV_TO_MEM,
+					   DMA_PREP_INTERRUPT);
+	if (!rxdesc) {
+		pm_runtime_put_autosuspend(rs->dev);
+		return -EINVAL;
+	}
+	rxdesc->callback = rockchip_spi_slave_ring_cb;
+	rxdesc->callback_param = rs;
+
+	spin_lock_irq(&rs->ring_spin);
+	rs->ring_watermark = cfg->watermark ? cfg->watermark : cfg->period;
+	rs->ring_pos = 0;
+	rs->ring_head = 0;
+	rs->ring_tail = 0;
+	rs->ring_overruns = 0;
+	rs->ring_fifo_overruns = 0;
+	spin_unlock_irq(&rs->ring_spin);
+
+	writel_relaxed(cr0, rs->regs + ROCKCHIP_SPI_CTRLR0);
+	writel_relaxed(ROCKCHIP_SPI_MAX_TRANLEN, rs->regs + ROCKCHIP_SPI_CTRLR1);
+	if (rs->ext_spi_clk) {
+		val = BYPASS_EN | BYPASS_INT_TF_EN | CLOCK_GATING_NONE;
+		writel_relaxed(val, rs->regs + ROCKCHIP_SPI_BYPASS);
+	}
+	if (rs->dma_timeout) {
+		val = TIMEOUT_SINGLE_REQUEST_EN | TIMEOUT_COUNTER_EN |
+			16 << TIMEOUT_THRESHOLD_OFFSET;
+		writel_relaxed(val, rs->regs + ROCKCHIP_SPI_TIMEOUT);
+	}
+	writel_relaxed(rs->fifo_len / 2 - 1, rs->regs + ROCKCHIP_SPI_RXFTLR);
+	writel_relaxed(burst - 1, rs->regs + ROCKCHIP_SPI_DMARDLR);
+	writel_relaxed(RF_DMA_EN, rs->regs + ROCKCHIP_SPI_DMACR);
+	writel_relaxed(0xffffffff, rs->regs + ROCKCHIP_SPI_ICR);
+
+	rs->ring_active = true;
+	rs->ring_cookie = dmaengine_submit(rxdesc);
+	dma_async_issue_pending(ctlr->dma_rx);
+
+	/* cs toggles between the master's frames do not stop the ring */
+	writel_relaxed(INT_RF_OVERFLOW, rs->regs + ROCKCHIP_SPI_IMR);
+	spi_enable_chip(rs, true);
+
+	if (rs->ready) {
+		gpiod_set_value(rs->ready, 0);
+		gpiod_set_value(rs->ready, 1);
+	}
+
+	return 0;
+}
+
+static void rockchip_spi_slave_ring_stop(struct rockchip_spi *rs)
+{
+	struct spi_controller *ctlr = dev_get_drvdata(rs->dev);
+
+	if (!rs->ring_active)
+		return;
+
+	writel_relaxed(0, rs->regs + ROCKCHIP_SPI_IMR);
+	spi_enable_chip(rs, false);
+	dmaengine_terminate_sync(ctlr->dma_rx);
+	writel_relaxed(0, rs->regs + ROCKCHIP_SPI_DMACR);
+	rockchop_spi_rx_fifo_flush(ctlr);
+	writel_relaxed(0xffffffff, rs->regs + ROCKCHIP_SPI_ICR);
+	rs->ring_active = false;
+
+	pm_runtime_mark_last_busy(rs->dev);
+	pm_runtime_put_autosuspend(rs->dev);
+
+	wake_up_interruptible(&rs->ring_wait);
+}
+
+static struct rockchip_spi *rockchip_spi_slave_ring_from_file(struct file *file)
+{
+	struct miscdevice *misc = file->private_data;
+
+	return container_of(misc, struct rockchip_spi, ring_misc);
+}
+
+static int rockchip_spi_slave_ring_open(struct inode *inode, struct file *file)
+{
+	struct rockchip_spi *rs = rockchip_spi_slave_ring_from_file(file);
+
+	/* one reader owns the ring */
+	if (atomic_cmpxchg(&rs->ring_open, 0, 1))
+		return -EBUSY;
+
+	return 0;
+}
+
+static int rockchip_spi_slave_ring_release(struct inode *inode, struct file *file)
+{
+	struct rockchip_spi *rs = rockchip_spi_slave_ring_from_file(file);
+
+	mutex_lock(&rs->ring_lock);
+	rockchip_spi_slave_ring_stop(rs);
+	if (rs->ring_buf) {
+		dma_free_coherent(rs->dev, rs->ring_size, rs->ring_buf, rs->ring_phys);
+		rs->ring_buf = NULL;
+		rs->ring_size = 0;
+	}
+	mutex_unlock(&rs->ring_lock);
+
+	atomic_set(&rs->ring_open, 0);
+
+	return 0;
+}
+
+static long rockchip_spi_slave_ring_ioctl(struct file *file, unsigned int cmd,
+					  unsigned long arg)
+{
+	struct rockchip_spi *rs = rockchip_spi_slave_ring_from_file(file);
+	void __user *argp = (void __user *)arg;
+	struct rkspi_ring_config cfg;
+	struct rkspi_ring_status status;
+	u32 bytes;
+	long ret = 0;
+
+	if (mutex_lock_interruptible(&rs->ring_lock))
+		return -ERESTARTSYS;
+
+	switch (cmd) {
+	case RKSPI_IOCTL_RING_START:
+		if (copy_from_user(&cfg, argp, sizeof(cfg))) {
+			ret = -EFAULT;
+			break;
+		}
+		ret = rockchip_spi_slave_ring_start(rs, &cfg);
+		break;
+	case RKSPI_IOCTL_RING_STOP:
+		rockchip_spi_slave_ring_stop(rs);
+		break;
+	case RKSPI_IOCTL_RING_STATUS:
+		spin_lock_irq(&rs->ring_spin);
+		if (rs->ring_active)
+			rockchip_spi_slave_ring_update(rs);
+		status.head = rs->ring_head;
+		status.tail = rs->ring_tail;
+		status.overruns = rs->ring_overruns;
+		status.fifo_overruns = rs->ring_fifo_overruns;
+		spin_unlock_irq(&rs->ring_spin);
+		if (copy_to_user(argp, &status, sizeof(status)))
+			ret = -EFAULT;
+		break;
+	case RKSPI_IOCTL_RING_CONSUME:
+		if (get_user(bytes, (u32 __user *)argp)) {
+			ret = -EFAULT;
+			break;
+		}
+		spin_lock_irq(&rs->ring_spin);
+		if (bytes > rs->ring_head - rs->ring_tail)
+			ret = -EINVAL;
+		else
+			rs->ring_tail += bytes;
+		spin_unlock_irq(&rs->ring_spin);
+		break;
+	default:
+		ret = -ENOTTY;
+	}
+
+	mutex_unlock(&rs->ring_lock);
+
+	return ret;
+}
+
+static __poll_t rockchip_spi_slave_ring_poll(struct file *file, poll_table *wait)
+{
+	struct rockchip_spi *rs = rockchip_spi_slave_ring_from_file(file);
+	__poll_t mask = 0;
+
+	poll_wait(file, &rs->ring_wait, wait);
+
+	spin_lock_irq(&rs->ring_spin);
+	if (rs->ring_head - rs->ring_tail >= rs->ring_watermark)
+		mask |= EPOLLIN | EPOLLRDNORM;
+	if (!rs->ring_active)
+		mask |= EPOLLHUP;
+	spin_unlock_irq(&rs->ring_spin);
+
+	return mask;
+}
+
+static int rockchip_spi_slave_ring_mmap(struct file *file, struct vm_area_struct *vma)
+{
+	struct rockchip_spi *rs = rockchip_spi_slave_ring_from_file(file);
+	int ret;
+
+	if (vma->vm_flags & VM_WRITE)
+		return -EPERM;
+
+	mutex_lock(&rs->ring_lock);
+	if (!rs->ring_buf)
+		ret = -ENODEV;
+	else
+		ret = dma_mmap_coherent(rs->dev, vma, rs->ring_buf, rs->ring_phys,
+					rs->ring_size);
+	mutex_unlock(&rs->ring_lock);
+
+	return ret;
+}
+
+static const struct file_operations rockchip_spi_slave_ring_fops = {
+	.owner = THIS_MODULE,
+	.open = rockchip_spi_slave_ring_open,
+	.release = rockchip_spi_slave_ring_release,
+	.unlocked_ioctl = rockchip_spi_slave_ring_ioctl,
+	.compat_ioctl = compat_ptr_ioctl,
+	.poll = rockchip_spi_slave_ring_poll,
+	.mmap = rockchip_spi_slave_ring_mmap,
+};
+
 static bool rockchip_spi_slave_can_dma(struct spi_controller *ctlr,
 				 struct spi_device *spi,
 				 struct spi_transfer *xfer)
@@ -879,6 +1240,9 @@ static int rockchip_spi_slave_probe(struct platform_device *pdev)
 	ctlr->can_dma = rockchip_spi_slave_can_dma;
 
 	init_completion(&rs->xfer_done);
+	mutex_init(&rs->ring_lock);
+	spin_lock_init(&rs->ring_spin);
+	init_waitqueue_head(&rs->ring_wait);
 	switch (rs->version) {
 	case ROCKCHIP_SPI_VER3:
 		rs->ext_spi_clk = true;
@@ -926,6 +1290,16 @@ static int rockchip_spi_slave_probe(struct platform_device *pdev)
 		goto err_free_dma_rx;
 	}
 
+	rs->ring_misc.minor = MISC_DYNAMIC_MINOR;
+	rs->ring_misc.name = devm_kasprintf(&pdev->dev, GFP_KERNEL, "spi_slave_ring%d",
+					    ctlr->bus_num);
+	rs->ring_misc.fops = &rockchip_spi_slave_ring_fops;
+	rs->ring_misc.parent = &pdev->dev;
+	if (!rs->ring_misc.name || misc_register(&rs->ring_misc)) {
+		dev_warn(&pdev->dev, "ring mode is not available\n");
+		rs->ring_misc.name = NULL;
+	}
+
 	dev_info(rs->dev, "slave probed, cs-inactive=%d, ready=%d, ext=%d, dam_buf=%x\n",
 		 rs->cs_inactive, rs->ready ? 1 : 0, rs->ext_spi_clk, (u32)rs->dma_phys);
 
@@ -950,6 +1324,9 @@ static int rockchip_spi_slave_remove(struct platform_device *pdev)
 	struct spi_controller *ctlr = spi_controller_get(platform_get_drvdata(pdev));
 	struct rockchip_spi *rs = spi_controller_get_devdata(ctlr);
 
+	if (rs->ring_misc.name)
+		misc_deregister(&rs->ring_misc);
+
 	pm_runtime_get_sync(&pdev->dev);
 
 	clk_bulk_disable_unprepare(rs->clk_cnt, rs->clks);
@@ -7,8 +7,10 @@
 #include <linux/acpi.h>
 #include <linux/clk.h>
 #include <linux/delay.h>
+#include <linux/dma-mapping.h>
 #include <linux/dmaengine.h>
 #include <linux/interrupt.h>
+#include <linux/ktime.h>
 #include <linux/miscdevice.h>
 #include <linux/module.h>
 #include <linux/of.h>
@@ -173,6 +175,9 @@
 
 #define ROCKCHIP_SPI_REGISTER_SIZE		0x1000
 
+/* bounce buffer size for coalesced transfers */
+#define ROCKCHIP_SPI_COALESCE_SIZE		PAGE_SIZE
+
 enum rockchip_spi_xfer_mode {
 	ROCKCHIP_SPI_DMA,
 	ROCKCHIP_SPI_IRQ,
@@ -229,6 +234,28 @@ struct rockchip_spi {
 
 	/* quirks */
 	u32 max_baud_div_in_cpha;
+
+	/*
+	 * Back to back small transfers of a message are sent as one through
+	 * these bounce buffers, see rockchip_spi_coalesce().
+	 */
+	bool coalesce;
+	void *coalesce_tx;
+	void *coalesce_rx;
+	dma_addr_t coalesce_tx_dma;
+	dma_addr_t coalesce_rx_dma;
+	struct scatterlist coalesce_tx_sg;
+	struct scatterlist coalesce_rx_sg;
+	struct spi_transfer coalesce_xfer;
+	/* last transfer already sent as part of the current batch */
+	struct spi_transfer *coalesce_last;
+
+	/* bus utilization */
+	u64 busy_ns;
+	u64 xfer_count;
+	u64 coalesced_count;
+	ktime_t util_stamp;
+	u64 util_busy_ns;
 };
 
 static inline void spi_enable_chip(struct rockchip_spi *rs, bool enable)
@@ -332,6 +359,7 @@ static void rockchip_spi_handle_err(struct spi_controller *ctlr,
 	if (atomic_read(&rs->state) & RXDMA)
 		dmaengine_terminate_async(ctlr->dma_rx);
 	atomic_set(&rs->state, 0);
+	rs->coalesce_last = NULL;
 }
 
 static void rockchip_spi_pio_writer(struct rockchip_spi *rs)
@@ -799,12 +827,109 @@ static int rockchip_spi_transfer_wait(struct spi_controller *ctlr,
 	return 0;
 }
 
+static bool rockchip_spi_can_coalesce(struct rockchip_spi *rs,
+				      struct spi_transfer *prev,
+				      struct spi_transfer *next)
+{
+	/* only transfers small enough to not use dma on their own */
+	if (!next->len || next->len / rs->n_bytes >= rs->fifo_len)
+		return false;
+
+	/* the chip select must stay asserted with nothing in between */
+	if (prev->cs_change || prev->delay.value || prev->cs_off || next->cs_off ||
+	    prev->word_delay.value || next->word_delay.value)
+		return false;
+
+	return next->bits_per_word == prev->bits_per_word &&
+	       next->speed_hz == prev->speed_hz &&
+	       !next->tx_buf == !prev->tx_buf &&
+	       !next->rx_buf == !prev->rx_buf;
+}
+
+/*
+ * Merge @xfer with the compatible transfers following it in the message
+ * into rs->coalesce_xfer, backed by the bounce buffers. Returns the last
+ * merged transfer, or NULL if there is nothing to merge.
+ */
+static struct spi_transfer *rockchip_spi_coalesce(struct spi_controller *ctlr,
+						  struct spi_transfer *xfer)
+{
+	struct rockchip_spi *rs = spi_controller_get_devdata(ctlr);
+	struct spi_message *msg = ctlr->cur_msg;
+	struct spi_transfer *last = xfer, *t;
+	unsigned int len = 0;
+
+	if (!rs->coalesce || !msg || xfer->len / rs->n_bytes >= rs->fifo_len)
+		return NULL;
+
+	while (!list_is_last(&last->transfer_list, &msg->transfers)) {
+		t = list_next_entry(last, transfer_list);
+		if (!rockchip_spi_can_coalesce(rs, last, t) ||
+		    xfer->len + len + t->len > ROCKCHIP_SPI_COALESCE_SIZE)
+			break;
+		len += t->len;
+		last = t;
+	}
+
+	if (last == xfer)
+		return NULL;
+
+	len = 0;
+	t = xfer;
+	list_for_each_entry_from(t, &msg->transfers, transfer_list) {
+		if (t->tx_buf)
+			memcpy(rs->coalesce_tx + len, t->tx_buf, t->len);
+		len += t->len;
+		if (t == last)
+			break;
+	}
+
+	rs->coalesce_xfer = *xfer;
+	rs->coalesce_xfer.len = len;
+	rs->coalesce_xfer.cs_change = last->cs_change;
+	rs->coalesce_xfer.tx_buf = xfer->tx_buf ? rs->coalesce_tx : NULL;
+	rs->coalesce_xfer.rx_buf = xfer->rx_buf ? rs->coalesce_rx : NULL;
+
+	sg_init_table(&rs->coalesce_tx_sg, 1);
+	sg_dma_address(&rs->coalesce_tx_sg) = rs->coalesce_tx_dma;
+	sg_dma_len(&rs->coalesce_tx_sg) = len;
+	rs->coalesce_xfer.tx_sg.sgl = &rs->coalesce_tx_sg;
+	rs->coalesce_xfer.tx_sg.nents = 1;
+
+	sg_init_table(&rs->coalesce_rx_sg, 1);
+	sg_dma_address(&rs->coalesce_rx_sg) = rs->coalesce_rx_dma;
+	sg_dma_len(&rs->coalesce_rx_sg) = len;
+	rs->coalesce_xfer.rx_sg.sgl = &rs->coalesce_rx_sg;
+	rs->coalesce_xfer.rx_sg.nents = 1;
+
+	return last;
+}
+
+static void rockchip_spi_coalesce_done(struct spi_controller *ctlr,
+				       struct spi_transfer *xfer,
+				       struct spi_transfer *last)
+{
+	struct rockchip_spi *rs = spi_controller_get_devdata(ctlr);
+	unsigned int len = 0;
+
+	list_for_each_entry_from(xfer, &ctlr->cur_msg->transfers, transfer_list) {
+		if (xfer->rx_buf)
+			memcpy(xfer->rx_buf, rs->coalesce_rx + len, xfer->len);
+		len += xfer->len;
+		rs->coalesced_count++;
+		if (xfer == last)
+			break;
+	}
+}
+
 static int rockchip_spi_transfer_one(
 		struct spi_controller *ctlr,
 		struct spi_device *spi,
 		struct spi_transfer *xfer)
 {
 	struct rockchip_spi *rs = spi_controller_get_devdata(ctlr);
+	struct spi_transfer *last = NULL, *orig = xfer;
+	ktime_t start;
 	int ret;
 	bool use_dma;
 	enum rockchip_spi_xfer_mode xfer_mode;
@@ -815,6 +940,13 @@ static int rockchip_spi_transfer_one(
 		return 1;
 	}
 
+	/* already sent together with an earlier transfer of the message */
+	if (rs->coalesce_last) {
+		if (xfer == rs->coalesce_last)
+			rs->coalesce_last = NULL;
+		return 0;
+	}
+
 	WARN_ON(readl_relaxed(rs->regs + ROCKCHIP_SPI_SSIENR) &&
 		(readl_relaxed(rs->regs + ROCKCHIP_SPI_SR) & SR_BUSY));
 
@@ -829,6 +961,12 @@ static int rockchip_spi_transfer_one(
 	}
 
 	rs->n_bytes = xfer->bits_per_word <= 8 ? 1 : 2;
+
+	last = rockchip_spi_coalesce(ctlr, xfer);
+	if (last)
+		xfer = &rs->coalesce_xfer;
+
+	start = ktime_get();
 	rs->xfer = xfer;
 	if (rs->poll) {
 		xfer_mode = ROCKCHIP_SPI_POLL;
@@ -872,6 +1010,14 @@ static int rockchip_spi_transfer_one(
 	if (rs->ready)
 		gpiod_set_value(rs->ready, 0);
 
+	if (!ret && last) {
+		rockchip_spi_coalesce_done(ctlr, orig, last);
+		rs->coalesce_last = last;
+	}
+
+	rs->busy_ns += ktime_to_ns(ktime_sub(ktime_get(), start));
+	rs->xfer_count++;
+
 	return ret;
 }
 
@@ -973,6 +1119,48 @@ static const struct file_operations rockchip_spi_misc_fops = {
 	.mmap		= rockchip_spi_mmap,
 };
 
+static void rockchip_spi_free_coalesce(struct spi_controller *ctlr)
+{
+	struct rockchip_spi *rs = spi_controller_get_devdata(ctlr);
+
+	if (rs->coalesce_tx)
+		dma_free_coherent(ctlr->dma_tx->device->dev, ROCKCHIP_SPI_COALESCE_SIZE,
+				  rs->coalesce_tx, rs->coalesce_tx_dma);
+	if (rs->coalesce_rx)
+		dma_free_coherent(ctlr->dma_rx->device->dev, ROCKCHIP_SPI_COALESCE_SIZE,
+				  rs->coalesce_rx, rs->coalesce_rx_dma);
+	rs->coalesce_tx = NULL;
+	rs->coalesce_rx = NULL;
+	rs->coalesce = false;
+}
+
+/* busy percentage since the previous read, then the running totals */
+static ssize_t utilization_show(struct device *dev,
+				struct device_attribute *attr, char *buf)
+{
+	struct spi_controller *ctlr = dev_get_drvdata(dev);
+	struct rockchip_spi *rs = spi_controller_get_devdata(ctlr);
+	ktime_t now = ktime_get();
+	u64 busy_ns = READ_ONCE(rs->busy_ns);
+	u64 window_ns = ktime_to_ns(ktime_sub(now, rs->util_stamp));
+	u64 percent;
+
+	percent = window_ns ? div64_u64((busy_ns - rs->util_busy_ns) * 100, window_ns) : 0;
+	rs->util_stamp = now;
+	rs->util_busy_ns = busy_ns;
+
+	return sysfs_emit(buf, "%llu%% busy_us %llu xfers %llu coalesced %llu\n",
+			  percent, div_u64(busy_ns, NSEC_PER_USEC),
+			  READ_ONCE(rs->xfer_count), READ_ONCE(rs->coalesced_count));
+}
+static DEVICE_ATTR_RO(utilization);
+
+static struct attribute *rockchip_spi_attrs[] = {
+	&dev_attr_utilization.attr,
+	NULL,
+};
+ATTRIBUTE_GROUPS(rockchip_spi);
+
 static int rockchip_spi_probe(struct platform_device *pdev)
 {
 	int ret;
@@ -1186,6 +1374,21 @@ static int rockchip_spi_probe(struct platform_device *pdev)
 		goto err_free_dma_rx;
 	}
 
+	if (ctlr->can_dma && !slave_mode &&
+	    device_property_read_bool(&pdev->dev, "rockchip,coalesce-xfers")) {
+		rs->coalesce_tx = dma_alloc_coherent(ctlr->dma_tx->device->dev,
+						     ROCKCHIP_SPI_COALESCE_SIZE,
+						     &rs->coalesce_tx_dma, GFP_KERNEL);
+		rs->coalesce_rx = dma_alloc_coherent(ctlr->dma_rx->device->dev,
+						     ROCKCHIP_SPI_COALESCE_SIZE,
+						     &rs->coalesce_rx_dma, GFP_KERNEL);
+		if (rs->coalesce_tx && rs->coalesce_rx)
+			rs->coalesce = true;
+		else
+			dev_warn(rs->dev, "no memory to coalesce transfers\n");
+	}
+	rs->util_stamp = ktime_get();
+
 	switch (rs->version) {
 	case ROCKCHIP_SPI_VER2_TYPE2:
 		rs->cs_high_supported = true;
@@ -1246,6 +1449,7 @@ static int rockchip_spi_probe(struct platform_device *pdev)
 	return 0;
 
 err_free_dma_rx:
+	rockchip_spi_free_coalesce(ctlr);
 	if (ctlr->dma_rx)
 		dma_release_channel(ctlr->dma_rx);
 err_free_dma_tx:
@@ -1283,6 +1487,7 @@ static int rockchip_spi_remove(struct platform_device *pdev)
 	pm_runtime_disable(&pdev->dev);
 	pm_runtime_set_suspended(&pdev->dev);
 
+	rockchip_spi_free_coalesce(ctlr);
 	if (ctlr->dma_tx)
 		dma_release_channel(ctlr->dma_tx);
 	if (ctlr->dma_rx)
@@ -1399,6 +1604,7 @@ static struct platform_driver rockchip_spi_driver = {
 		.name	= DRIVER_NAME,
 		.pm = &rockchip_spi_pm,
 		.of_match_table = of_match_ptr(rockchip_spi_dt_match),
+		.dev_groups = rockchip_spi_groups,
 	},
 	.probe = rockchip_spi_probe,
 	.remove = rockchip_spi_remove,
@@ -18,6 +18,7 @@
 #include <linux/reset.h>
 #include <linux/rockchip/cpu.h>
 #include <linux/thermal.h>
+#include <linux/workqueue.h>
 #include <linux/mfd/syscon.h>
 #include <linux/pinctrl/consumer.h>
 #include <linux/nvmem-consumer.h>
@@ -153,6 +154,9 @@ struct rockchip_tsadc_chip {
  * @id: identifier of the thermal sensor
  * @trim_temp: the trim temp of the thermal sensor
  * @tshut_temp: the hardware-controlled shutdown temperature value
+ * @track_work: samples the sensor against the low trip while hot
+ * @track_low: the low end of the trip window, -INT_MAX below all trips
+ * @track_ms: the sampling period of @track_work, 0 to disable
  */
 struct rockchip_thermal_sensor {
 	struct rockchip_thermal_data *thermal;
@@ -160,6 +164,9 @@ struct rockchip_thermal_sensor {
 	int id;
 	int trim_temp;
 	int tshut_temp;
+	struct delayed_work track_work;
+	int track_low;
+	u32 track_ms;
 };
 
 /**
@@ -2096,10 +2103,49 @@ rockchip_thermal_toggle_sensor(struct rockchip_thermal_sensor *sensor, bool on)
 {
 	struct thermal_zone_device *tzd = sensor->tzd;
 
-	if (on)
+	if (on) {
 		thermal_zone_device_enable(tzd);
-	else
+		/* the trip window may be unchanged, set_trips not called */
+		if (sensor->track_ms && READ_ONCE(sensor->track_low) != -INT_MAX)
+			mod_delayed_work(system_freezable_power_efficient_wq,
+					 &sensor->track_work, 0);
+	} else {
 		thermal_zone_device_disable(tzd);
+		cancel_delayed_work_sync(&sensor->track_work);
+	}
+}
+
+/*
+ * The tsadc only raises an alarm on the high end of the trip window, and
+ * samples faster itself once above it. Leaving the window downwards is
+ * only seen by the thermal core polling, so while the sensor sits above a
+ * trip it is sampled here instead, and the zone polling can be relaxed or
+ * turned off.
+ */
+static void rockchip_thermal_track_work(struct work_struct *work)
+{
+	struct rockchip_thermal_sensor *sensor =
+		container_of(work, struct rockchip_thermal_sensor,
+			     track_work.work);
+	const struct rockchip_tsadc_chip *tsadc = sensor->thermal->chip;
+	int low = READ_ONCE(sensor->track_low);
+	int temp;
+
+	if (low == -INT_MAX)
+		return;
+
+	if (!tsadc->get_temp(&tsadc->table, sensor->id,
+			     sensor->thermal->regs, &temp) &&
+	    temp - sensor->trim_temp < low) {
+		/* set_trips requeues us if still above a trip */
+		thermal_zone_device_update(sensor->tzd,
+					   THERMAL_EVENT_UNSPECIFIED);
+		return;
+	}
+
+	queue_delayed_work(system_freezable_power_efficient_wq,
+			   &sensor->track_work,
+			   msecs_to_jiffies(sensor->track_ms));
 }
 
 static irqreturn_t rockchip_thermal_alarm_irq_thread(int irq, void *dev)
@@ -2127,6 +2173,16 @@ static int rockchip_thermal_set_trips(struct thermal_zone_device *tz, int low, i
 	dev_dbg(&thermal->pdev->dev, "%s: sensor %d: low: %d, high %d\n",
 		__func__, sensor->id, low, high);
 
+	if (sensor->track_ms) {
+		WRITE_ONCE(sensor->track_low, low);
+		if (low != -INT_MAX)
+			mod_delayed_work(system_freezable_power_efficient_wq,
+					 &sensor->track_work,
+					 msecs_to_jiffies(sensor->track_ms));
+		else
+			cancel_delayed_work(&sensor->track_work);
+	}
+
 	high += sensor->trim_temp;
 
 	return tsadc->set_alarm_temp(&tsadc->table,
@@ -2272,7 +2328,7 @@ static int rockchip_configure_from_dt(struct device *dev,
 				      struct rockchip_thermal_data *thermal)
 {
 	u32 shut_temp, tshut_mode, tshut_polarity;
-	int i;
+	int i, ret;
 
 	if (of_property_read_u32(np, "rockchip,hw-tshut-temp", &shut_temp)) {
 		dev_warn(dev,
@@ -2330,6 +2386,13 @@ static int rockchip_configure_from_dt(struct device *dev,
 
 	rockchip_get_trim_configure(dev, np, thermal);
 
+	/* one period for all channels, or one per channel */
+	ret = of_property_count_u32_elems(np, "rockchip,trip-track-ms");
+	for (i = 0; ret > 0 && i < thermal->chip->chn_num; i++)
+		of_property_read_u32_index(np, "rockchip,trip-track-ms",
+					   min(i, ret - 1),
+					   &thermal->sensors[i].track_ms);
+
 	return 0;
 }
 
@@ -2353,6 +2416,8 @@ rockchip_thermal_register_sensor(struct platform_device *pdev,
 
 	sensor->thermal = thermal;
 	sensor->id = id;
+	sensor->track_low = -INT_MAX;
+	INIT_DELAYED_WORK(&sensor->track_work, rockchip_thermal_track_work);
 	sensor->tzd = devm_thermal_of_zone_register(&pdev->dev, id, sensor,
 						    &rockchip_of_thermal_ops);
 	if (IS_ERR(sensor->tzd)) {
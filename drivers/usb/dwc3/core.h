@@ -686,6 +686,9 @@ struct dwc3_event_buffer {
 
 #define DWC3_TRB_NUM		256
 
+/* max IN requests completing on one interrupt, see dwc3_gadget_skip_ioc() */
+#define DWC3_IOC_BATCH_MAX	8
+
 /**
  * struct dwc3_ep - device side endpoint representation
  * @endpoint: usb endpoint
@@ -697,6 +700,7 @@ struct dwc3_event_buffer {
  * @trb_pool_dma: dma address of @trb_pool
  * @trb_enqueue: enqueue 'pointer' into TRB array
  * @trb_dequeue: dequeue 'pointer' into TRB array
+ * @ioc_skipped: requests prepared without IOC since the last one with IOC
  * @dwc: pointer to DWC controller
  * @saved_state: ep state saved during hibernation
  * @flags: endpoint flags (wedged, stalled, ...)
@@ -756,6 +760,7 @@ struct dwc3_ep {
 	 */
 	u8			trb_enqueue;
 	u8			trb_dequeue;
+	u8			ioc_skipped;
 
 	u8			number;
 	u8			type;
@@ -923,6 +928,8 @@ struct dwc3_hwparams {
  * @num_trbs: number of TRBs used by this request
  * @needs_extra_trb: true when request needs one extra TRB (either due to ZLP
  *	or unaligned OUT)
+ * @ioc_batched: true when the request completes on the interrupt of a later
+ *	request of the same batch
  * @direction: IN or OUT direction flag
  * @mapped: true when request has been dma-mapped
  */
@@ -953,6 +960,7 @@ struct dwc3_request {
 	unsigned int		num_trbs;
 
 	unsigned int		needs_extra_trb:1;
+	unsigned int		ioc_batched:1;
 	unsigned int		direction:1;
 	unsigned int		mapped:1;
 };
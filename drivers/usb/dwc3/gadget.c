@@ -1048,6 +1048,7 @@ static int __dwc3_gadget_ep_enable(struct dwc3_ep *dep, unsigned int action)
 
 		dep->trb_dequeue = 0;
 		dep->trb_enqueue = 0;
+		dep->ioc_skipped = 0;
 
 		if (usb_endpoint_xfer_control(desc))
 			goto out;
@@ -1378,7 +1379,8 @@ static void dwc3_prepare_one_trb(struct dwc3_ep *dep,
 	dma_addr_t		dma;
 	unsigned int		stream_id = req->request.stream_id;
 	unsigned int		short_not_ok = req->request.short_not_ok;
-	unsigned int		no_interrupt = req->request.no_interrupt;
+	unsigned int		no_interrupt = req->request.no_interrupt ||
+					   req->ioc_batched;
 	unsigned int		is_last = req->request.is_last;
 	struct dwc3		*dwc = dep->dwc;
 	struct usb_gadget	*gadget = dwc->gadget;
@@ -1489,6 +1491,9 @@ static void dwc3_prepare_one_trb(struct dwc3_ep *dep,
 	if ((!no_interrupt && !chain) || must_interrupt)
 		trb->ctrl |= DWC3_TRB_CTRL_IOC;
 
+	if (trb->ctrl & DWC3_TRB_CTRL_IOC)
+		dep->ioc_skipped = 0;
+
 	if (chain)
 		trb->ctrl |= DWC3_TRB_CTRL_CHN;
 	else if (dep->stream_capable && is_last &&
@@ -1531,6 +1536,50 @@ static bool dwc3_needs_extra_trb(struct dwc3_ep *dep, struct dwc3_request *req)
 	return false;
 }
 
+/**
+ * dwc3_gadget_skip_ioc - check if a request can complete without interrupt
+ * @dep: The endpoint that the request belongs to
+ * @req: The request about to get its last TRBs prepared
+ * @num_trbs: The number of TRBs those last TRBs take
+ *
+ * Bulk and isoc IN requests queued back to back, like a UVC or mass storage
+ * stream, don't need an interrupt each: the request with IOC retires all
+ * the earlier ones of its batch. That only holds when a later request is
+ * pending and is sure to get TRBs, and a batch is capped so the function
+ * driver still gets its requests back in time to requeue them.
+ *
+ * Returns true when IOC can be left off the last TRB of @req.
+ */
+static bool dwc3_gadget_skip_ioc(struct dwc3_ep *dep, struct dwc3_request *req,
+		unsigned int num_trbs)
+{
+	struct dwc3_request *next;
+
+	if (!dep->direction || dep->stream_capable)
+		return false;
+
+	if (!usb_endpoint_xfer_bulk(dep->endpoint.desc) &&
+	    !usb_endpoint_xfer_isoc(dep->endpoint.desc))
+		return false;
+
+	if (dep->ioc_skipped >= DWC3_IOC_BATCH_MAX - 1)
+		return false;
+
+	/* an IN request takes at most two TRBs, one more for a ZLP */
+	if (dwc3_calc_trbs_left(dep) < num_trbs + 2)
+		return false;
+
+	/*
+	 * The next request must raise the interrupt itself or pass it on,
+	 * leave functions that use no_interrupt to their own scheme.
+	 */
+	list_for_each_entry(next, &dep->pending_list, list)
+		if (next != req)
+			return !next->request.no_interrupt;
+
+	return false;
+}
+
 /**
  * dwc3_prepare_last_sg - prepare TRBs for the last SG entry
  * @dep: The endpoint that the request belongs to
@@ -1555,6 +1604,9 @@ static int dwc3_prepare_last_sg(struct dwc3_ep *dep,
 		return 0;
 
 	req->needs_extra_trb = num_trbs > 1;
+	req->ioc_batched = dwc3_gadget_skip_ioc(dep, req, num_trbs);
+	if (req->ioc_batched)
+		dep->ioc_skipped++;
 
 	/* Prepare a normal TRB */
 	if (req->direction || req->request.length)
@@ -2092,6 +2144,7 @@ static int __dwc3_gadget_ep_queue(struct dwc3_ep *dep, struct dwc3_request *req)
 
 	req->request.actual	= 0;
 	req->request.status	= -EINPROGRESS;
+	req->ioc_batched	= false;
 
 	trace_dwc3_ep_queue(req);
 
@@ -3601,7 +3654,7 @@ static int dwc3_gadget_ep_cleanup_completed_request(struct dwc3_ep *dep,
 	 * needs to check and return the status of the completed TRBs associated
 	 * with the request. Use the status of the last TRB of the request.
 	 */
-	if (req->request.no_interrupt) {
+	if (req->request.no_interrupt || req->ioc_batched) {
 		struct dwc3_trb *trb;
 
 		trb = dwc3_ep_prev_trb(dep, dep->trb_dequeue);
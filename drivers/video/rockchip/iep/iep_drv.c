@@ -688,6 +688,13 @@ static long iep_ioctl(struct file *filp, uint32_t cmd, unsigned long arg)
 		return -EINVAL;
 	}
 
+	/*
+	 * Wait without the service mutex, other sessions keep queueing
+	 * jobs meanwhile; the queues are protected by iep_service.lock.
+	 */
+	if (cmd == IEP_GET_RESULT_SYNC)
+		return iep_get_result_sync(session) < 0 ? -ETIMEDOUT : 0;
+
 	mutex_lock(&iep_service.mutex);
 
 	switch (cmd) {
@@ -721,11 +728,6 @@ static long iep_ioctl(struct file *filp, uint32_t cmd, unsigned long arg)
 			kfree(msg);
 		}
 		break;
-	case IEP_GET_RESULT_SYNC:
-		if (0 > iep_get_result_sync(session)) {
-			ret = -ETIMEDOUT;
-		}
-		break;
 	case IEP_GET_RESULT_ASYNC:
 		iep_get_result_async(session);
 		break;
@@ -776,6 +778,10 @@ static long compat_iep_ioctl(struct file *filp, uint32_t cmd,
 		return -EINVAL;
 	}
 
+	/* as in iep_ioctl(), wait without the service mutex */
+	if (cmd == COMPAT_IEP_GET_RESULT_SYNC)
+		return iep_get_result_sync(session) < 0 ? -ETIMEDOUT : 0;
+
 	mutex_lock(&iep_service.mutex);
 
 	switch (cmd) {
@@ -812,10 +818,6 @@ static long compat_iep_ioctl(struct file *filp, uint32_t cmd,
 			kfree(msg);
 		}
 		break;
-	case COMPAT_IEP_GET_RESULT_SYNC:
-		if (0 > iep_get_result_sync(session))
-			ret = -ETIMEDOUT;
-		break;
 	case COMPAT_IEP_GET_RESULT_ASYNC:
 		iep_get_result_async(session);
 		break;
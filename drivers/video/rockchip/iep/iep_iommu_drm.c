@@ -314,6 +314,33 @@ iep_drm_clear_session(struct iep_iommu_session_info *session_info)
 	}
 }
 
+/*
+ * Drop the least recently used buffer which no queued job holds a mapping
+ * of, so that a session cycling through dma-bufs doesn't keep every one it
+ * has ever seen attached. Caller must hold list_mutex.
+ */
+static void iep_drm_evict_no_lock(struct iep_iommu_session_info *session_info,
+				  struct iep_drm_buffer *keep)
+{
+	struct iep_drm_buffer *drm_buffer, *n;
+
+	list_for_each_entry_safe(drm_buffer, n, &session_info->buffer_list,
+				 list) {
+		if (drm_buffer == keep || kref_read(&drm_buffer->ref) != 1)
+			continue;
+
+		kref_put(&drm_buffer->ref, iep_drm_clear_map);
+		dma_buf_put(drm_buffer->dma_buf);
+		list_del_init(&drm_buffer->list);
+		kfree(drm_buffer);
+		session_info->buffer_nums--;
+		vpu_iommu_debug(session_info->debug_level, DEBUG_IOMMU_NORMAL,
+				"evict, buffer nums %d\n",
+				session_info->buffer_nums);
+		return;
+	}
+}
+
 static int iep_drm_import(struct iep_iommu_session_info *session_info,
 			  int fd)
 {
@@ -333,13 +360,19 @@ static int iep_drm_import(struct iep_iommu_session_info *session_info,
 		return ret;
 	}
 
+	mutex_lock(&session_info->list_mutex);
 	list_for_each_entry_safe(drm_buffer, n,
 				 &session_info->buffer_list, list) {
 		if (drm_buffer->dma_buf == dma_buf) {
+			/* keep the list in least recently used order */
+			list_move_tail(&drm_buffer->list,
+				       &session_info->buffer_list);
+			mutex_unlock(&session_info->list_mutex);
 			dma_buf_put(dma_buf);
 			return drm_buffer->index;
 		}
 	}
+	mutex_unlock(&session_info->list_mutex);
 
 	drm_buffer = kzalloc(sizeof(*drm_buffer), GFP_KERNEL);
 	if (!drm_buffer) {
@@ -395,6 +428,8 @@ static int iep_drm_import(struct iep_iommu_session_info *session_info,
 	session_info->max_idx++;
 	if ((session_info->max_idx & 0xfffffff) == 0)
 		session_info->max_idx = 0;
+	if (session_info->buffer_nums > BUFFER_LIST_MAX_NUMS)
+		iep_drm_evict_no_lock(session_info, drm_buffer);
 	mutex_unlock(&session_info->list_mutex);
 
 	return drm_buffer->index;
@@ -12,7 +12,9 @@
 #define pr_fmt(fmt) KBUILD_MODNAME ": " fmt
 
 #include <linux/clk.h>
+#include <linux/cpufreq.h>
 #include <linux/delay.h>
+#include <linux/eventfd.h>
 #include <linux/interrupt.h>
 #include <linux/iopoll.h>
 #include <linux/module.h>
@@ -31,11 +33,16 @@
 #include <linux/nospec.h>
 
 #include <soc/rockchip/pm_domains.h>
+#include <soc/rockchip/rockchip_flight_recorder.h>
+#include <soc/rockchip/rockchip_system_monitor.h>
 
 #include "mpp_debug.h"
 #include "mpp_common.h"
 #include "mpp_iommu.h"
 
+#define CREATE_TRACE_POINTS
+#include "mpp_trace.h"
+
 /* input parmater structure for version 1 */
 struct mpp_msg_v1 {
 	__u32 cmd;
@@ -105,6 +112,15 @@ mpp_taskqueue_get_pending_task(struct mpp_taskqueue *queue)
 {
 	struct mpp_task *task = NULL;
 
+	/*
+	 * Every producer kicks the queue worker after it has released
+	 * pending_lock, so an empty list seen here without the lock is
+	 * either current or will be rechecked by the next worker pass.
+	 * This keeps the idle worker and power off out of the mutex.
+	 */
+	if (list_empty_careful(&queue->pending_list))
+		return NULL;
+
 	mutex_lock(&queue->pending_lock);
 	task = list_first_entry_or_null(&queue->pending_list,
 					struct mpp_task,
@@ -117,20 +133,29 @@ mpp_taskqueue_get_pending_task(struct mpp_taskqueue *queue)
 static bool
 mpp_taskqueue_is_running(struct mpp_taskqueue *queue)
 {
-	unsigned long flags;
-	bool flag;
-
-	spin_lock_irqsave(&queue->running_lock, flags);
-	flag = !list_empty(&queue->running_list);
-	spin_unlock_irqrestore(&queue->running_lock, flags);
+	/*
+	 * Only the queue worker moves tasks onto the running list while
+	 * the irq / timeout paths only remove them with list_del_init(),
+	 * so from the worker a lockless check can merely report a task
+	 * that is just finishing, and the finish path triggers the worker
+	 * again.
+	 */
+	return !list_empty_careful(&queue->running_list);
+}
 
-	return flag;
+static bool
+mpp_taskqueue_is_idle(struct mpp_taskqueue *queue)
+{
+	return list_empty_careful(&queue->pending_list) &&
+	       list_empty_careful(&queue->running_list);
 }
 
 int mpp_taskqueue_pending_to_run(struct mpp_taskqueue *queue, struct mpp_task *task)
 {
 	unsigned long flags;
 
+	task->stat_run = ktime_get();
+
 	mutex_lock(&queue->pending_lock);
 	spin_lock_irqsave(&queue->running_lock, flags);
 	list_move_tail(&task->queue_link, &queue->running_list);
@@ -141,21 +166,6 @@ int mpp_taskqueue_pending_to_run(struct mpp_taskqueue *queue, struct mpp_task *t
 	return 0;
 }
 
-static struct mpp_task *
-mpp_taskqueue_get_running_task(struct mpp_taskqueue *queue)
-{
-	unsigned long flags;
-	struct mpp_task *task = NULL;
-
-	spin_lock_irqsave(&queue->running_lock, flags);
-	task = list_first_entry_or_null(&queue->running_list,
-					struct mpp_task,
-					queue_link);
-	spin_unlock_irqrestore(&queue->running_lock, flags);
-
-	return task;
-}
-
 static int
 mpp_taskqueue_pop_running(struct mpp_taskqueue *queue,
 			  struct mpp_task *task)
@@ -181,7 +191,8 @@ mpp_taskqueue_trigger_work(struct mpp_dev *mpp)
 
 int mpp_power_on(struct mpp_dev *mpp)
 {
-	pm_runtime_get_sync(mpp->dev);
+	if (!pm_runtime_get_sync(mpp->dev))
+		atomic64_inc(&mpp->power_on);
 	pm_stay_awake(mpp->dev);
 
 	if (mpp->hw_ops->clk_on)
@@ -196,17 +207,55 @@ int mpp_power_off(struct mpp_dev *mpp)
 		mpp->hw_ops->clk_off(mpp);
 
 	pm_relax(mpp->dev);
-	if (mpp_taskqueue_get_pending_task(mpp->queue) ||
-	    mpp_taskqueue_get_running_task(mpp->queue)) {
+	if (!mpp_taskqueue_is_idle(mpp->queue)) {
+		pm_runtime_mark_last_busy(mpp->dev);
+		pm_runtime_put_autosuspend(mpp->dev);
+	} else if (READ_ONCE(mpp->power_hold_ms)) {
+		/* the next frame is due soon, skip the power cycle */
+		atomic64_inc(&mpp->power_hold);
+		pm_runtime_set_autosuspend_delay(mpp->dev,
+						 READ_ONCE(mpp->power_hold_ms));
 		pm_runtime_mark_last_busy(mpp->dev);
 		pm_runtime_put_autosuspend(mpp->dev);
 	} else {
+		atomic64_inc(&mpp->power_off);
 		pm_runtime_put_sync_suspend(mpp->dev);
 	}
 
 	return 0;
 }
 
+/*
+ * Track the submit interval of the session. A regular stream keeps the
+ * device powered a quarter interval past the expected next frame, and a
+ * suspended device starts resuming at submit, in parallel with the task
+ * setup and the previous task still finishing.
+ */
+static void mpp_power_hint_submit(struct mpp_session *session,
+				  struct mpp_dev *mpp, ktime_t now)
+{
+	s64 interval_us = ktime_us_delta(now, session->last_submit);
+	u32 avg = session->frame_interval_us;
+
+	if (session->last_submit &&
+	    interval_us < MPP_POWER_HOLD_MAX_MS * USEC_PER_MSEC)
+		avg = avg ? (avg * 7 + interval_us) / 8 : interval_us;
+	else
+		avg = 0;
+	session->last_submit = now;
+	session->frame_interval_us = avg;
+
+	avg += avg / 4;
+	WRITE_ONCE(mpp->power_hold_ms,
+		   avg < MPP_POWER_HOLD_MAX_MS * USEC_PER_MSEC ?
+		   DIV_ROUND_UP(avg, USEC_PER_MSEC) : 0);
+
+	if (pm_runtime_suspended(mpp->dev)) {
+		atomic64_inc(&mpp->power_pre_on);
+		pm_request_resume(mpp->dev);
+	}
+}
+
 static void task_msgs_reset(struct mpp_task_msgs *msgs)
 {
 	list_del_init(&msgs->list);
@@ -384,6 +433,8 @@ static struct mpp_session *mpp_session_init(void)
 	INIT_LIST_HEAD(&session->list_msgs);
 	INIT_LIST_HEAD(&session->list_msgs_idle);
 	spin_lock_init(&session->lock_msgs);
+	init_waitqueue_head(&session->wait);
+	session->priority = MPP_SESSION_PRIO_DEFAULT;
 
 	mpp_dbg_session("session %p init\n", session);
 	return session;
@@ -430,6 +481,9 @@ void mpp_session_deinit(struct mpp_session *session)
 
 	clear_task_msgs(session);
 
+	if (session->done_evfd)
+		eventfd_ctx_put(session->done_evfd);
+
 	kfree(session);
 }
 
@@ -505,6 +559,107 @@ mpp_session_get_pending_task(struct mpp_session *session)
 	return task;
 }
 
+static bool mpp_task_hw_done(struct mpp_task *task)
+{
+	return test_bit(TASK_STATE_DONE, &task->state) ||
+	       test_bit(TASK_STATE_PROC_DONE, &task->state);
+}
+
+static void mpp_task_stats_add(struct mpp_task_stats *stats, u32 hw_cycles,
+			       s64 prepare_us, s64 wait_us, s64 run_us,
+			       bool timeout)
+{
+	atomic64_inc(&stats->frames);
+	atomic64_add(hw_cycles, &stats->hw_cycles);
+	atomic64_add(prepare_us, &stats->prepare_us);
+	atomic64_add(wait_us, &stats->wait_us);
+	atomic64_add(run_us, &stats->run_us);
+	if (timeout)
+		atomic64_inc(&stats->timeouts);
+}
+
+static void mpp_task_stats_account(struct mpp_task *task)
+{
+	struct mpp_session *session = task->session;
+	struct mpp_dev *mpp = mpp_get_task_used_device(task, session);
+	bool timeout = test_bit(TASK_STATE_TIMEOUT, &task->state);
+	s64 prepare_us, wait_us = 0, run_us = 0;
+
+	prepare_us = ktime_us_delta(task->stat_create_end, task->stat_create);
+	/* the task may be aborted before it reached the running list */
+	if (task->stat_run) {
+		wait_us = ktime_us_delta(task->stat_run, task->stat_create_end);
+		run_us = ktime_us_delta(ktime_get(), task->stat_run);
+	}
+
+	mpp_task_stats_add(&mpp->stats, task->hw_cycles, prepare_us,
+			   wait_us, run_us, timeout);
+	mpp_task_stats_add(&session->stats, task->hw_cycles, prepare_us,
+			   wait_us, run_us, timeout);
+
+	trace_mpp_task_done(dev_name(mpp->dev), task->core_id, session->index,
+			    task->task_id, task->hw_cycles, prepare_us, wait_us,
+			    run_us, timeout);
+	rk_fr_log(RK_FR_SRC_MPP, timeout ? RK_FR_EV_TIMEOUT : RK_FR_EV_DONE,
+		  mpp->var->device_type, task->task_id);
+}
+
+/*
+ * Start the task chained after this one. Called once the task is done,
+ * or when it is freed without having completed, whichever comes first.
+ */
+void mpp_task_chain_release(struct mpp_task *task)
+{
+	struct mpp_task *next = xchg(&task->chain_next, NULL);
+
+	if (!next)
+		return;
+
+	atomic_set(&next->chain_wait, 0);
+	mpp_taskqueue_trigger_work(mpp_get_task_used_device(next, next->session));
+	kref_put(&next->ref, mpp_free_task);
+}
+
+static void mpp_task_chain(struct mpp_task *prev, struct mpp_task *task)
+{
+	atomic_set(&task->chain_wait, 1);
+	kref_get(&task->ref);
+	WRITE_ONCE(prev->chain_next, task);
+	/* pairs with the barrier of test_and_set_bit in mpp_task_wake_up */
+	smp_mb();
+
+	/* the previous task may already be done in link mode */
+	if (mpp_task_hw_done(prev))
+		mpp_task_chain_release(prev);
+}
+
+void mpp_task_wake_up(struct mpp_task *task)
+{
+	struct mpp_session *session = task->session;
+	struct eventfd_ctx *evfd;
+
+	if (!session) {
+		wake_up(&task->wait);
+		return;
+	}
+
+	/* slice wakeups come before done, account the task only once */
+	if (mpp_task_hw_done(task) &&
+	    !test_and_set_bit(TASK_STATE_STATS, &task->state)) {
+		mpp_task_stats_account(task);
+		mpp_task_chain_release(task);
+	}
+
+	/* Wake up the GET thread and then the pollers on the session fd */
+	wake_up(&task->wait);
+
+	wake_up_interruptible(&session->wait);
+
+	evfd = READ_ONCE(session->done_evfd);
+	if (evfd)
+		eventfd_signal(evfd, 1);
+}
+
 void mpp_free_task(struct kref *ref)
 {
 	struct mpp_dev *mpp;
@@ -522,6 +677,7 @@ void mpp_free_task(struct kref *ref)
 		       atomic_read(&task->abort_request));
 
 	mpp = mpp_get_task_used_device(task, session);
+	mpp_task_chain_release(task);
 	if (mpp->dev_ops->free_task)
 		mpp->dev_ops->free_task(session, task);
 
@@ -577,7 +733,7 @@ static void mpp_task_timeout_work(struct work_struct *work_s)
 	set_bit(TASK_STATE_TIMEOUT, &task->state);
 	set_bit(TASK_STATE_DONE, &task->state);
 	/* Wake up the GET thread */
-	wake_up(&task->wait);
+	mpp_task_wake_up(task);
 
 	/* remove task from taskqueue running list */
 	mpp_taskqueue_pop_running(mpp->queue, task);
@@ -596,7 +752,7 @@ static int mpp_process_task_default(struct mpp_session *session,
 {
 	struct mpp_task *task = NULL;
 	struct mpp_dev *mpp = session->mpp;
-	u32 timing_en;
+	u32 timing_en, window_us;
 	ktime_t on_create;
 
 	if (unlikely(!mpp)) {
@@ -606,8 +762,7 @@ static int mpp_process_task_default(struct mpp_session *session,
 	}
 
 	timing_en = session->srv->timing_en;
-	if (timing_en)
-		on_create = ktime_get();
+	on_create = ktime_get();
 
 	if (mpp->dev_ops->alloc_task)
 		task = mpp->dev_ops->alloc_task(session, msgs);
@@ -616,6 +771,19 @@ static int mpp_process_task_default(struct mpp_session *session,
 		return -ENOMEM;
 	}
 
+	task->stat_create = on_create;
+	task->stat_create_end = ktime_get();
+	window_us = session->deadline_us ? session->deadline_us :
+		    MPP_PRIO_SLACK_US << session->priority;
+	task->deadline = ktime_add_us(task->stat_create_end, window_us);
+	if (mpp->power_hint_mw)
+		rockchip_system_monitor_power_hint(mpp->dev, mpp->power_hint_mw,
+						   DIV_ROUND_UP(window_us, 1000));
+	/* sessions with a deadline get their cluster boosted until it */
+	if (session->deadline_us)
+		cpufreq_interactive_boost_cpu(raw_smp_processor_id(),
+					      session->deadline_us);
+
 	if (timing_en) {
 		task->on_create_end = ktime_get();
 		task->on_create = on_create;
@@ -625,6 +793,7 @@ static int mpp_process_task_default(struct mpp_session *session,
 
 	/* ensure current device */
 	mpp = mpp_get_task_used_device(task, session);
+	mpp_power_hint_submit(session, mpp, on_create);
 
 	kref_init(&task->ref);
 	init_waitqueue_head(&task->wait);
@@ -648,6 +817,7 @@ static int mpp_process_task_default(struct mpp_session *session,
 	 */
 	atomic_inc(&session->task_count);
 	mpp_session_push_pending(session, task);
+	rk_fr_log(RK_FR_SRC_MPP, RK_FR_EV_SUBMIT, mpp->var->device_type, task->task_id);
 
 	return 0;
 }
@@ -728,6 +898,7 @@ int mpp_dev_reset(struct mpp_dev *mpp)
 	mpp_iommu_down_write(mpp->iommu_info);
 	mpp_reset_down_write(mpp->reset_group);
 	atomic_set(&mpp->reset_request, 0);
+	atomic64_inc(&mpp->stats.resets);
 
 	if (mpp->hw_ops->reset)
 		mpp->hw_ops->reset(mpp);
@@ -827,6 +998,7 @@ static int mpp_task_run(struct mpp_dev *mpp,
 		mpp->hw_ops->set_freq(mpp, task);
 
 	mpp_iommu_dev_activate(mpp->iommu_info, mpp);
+	rk_fr_log(RK_FR_SRC_MPP, RK_FR_EV_START, mpp->var->device_type, task->task_id);
 	if (mpp->dev_ops->run)
 		mpp->dev_ops->run(mpp, task);
 
@@ -854,6 +1026,10 @@ static void mpp_task_worker_default(struct kthread_work *work_s)
 		goto again;
 	}
 
+	/* chained post-process task, wait for the task before it */
+	if (atomic_read(&task->chain_wait))
+		goto done;
+
 	/* get device for current task */
 	mpp = task->session->mpp;
 
@@ -1323,6 +1499,50 @@ static int mpp_process_request(struct mpp_session *session,
 		}
 		return ret;
 	} break;
+	case MPP_CMD_SET_EVENTFD: {
+		struct eventfd_ctx *evfd;
+		int fd;
+
+		if (req->size < sizeof(fd))
+			return -EINVAL;
+
+		if (copy_from_user(&fd, req->data, sizeof(fd))) {
+			mpp_err("copy_from_user failed.\n");
+			return -EFAULT;
+		}
+
+		evfd = eventfd_ctx_fdget(fd);
+		if (IS_ERR(evfd)) {
+			mpp_err("session %d invalid eventfd %d\n", session->index, fd);
+			return PTR_ERR(evfd);
+		}
+
+		/* eventfd can be set only once, it is released with the session */
+		if (cmpxchg(&session->done_evfd, NULL, evfd)) {
+			eventfd_ctx_put(evfd);
+			return -EBUSY;
+		}
+	} break;
+	case MPP_CMD_SET_SESSION_PRIO: {
+		struct mpp_session_prio prio;
+
+		if (req->size < sizeof(prio))
+			return -EINVAL;
+
+		if (copy_from_user(&prio, req->data, sizeof(prio))) {
+			mpp_err("copy_from_user failed.\n");
+			return -EFAULT;
+		}
+
+		if (prio.priority > MPP_SESSION_PRIO_MAX) {
+			mpp_err("session %d invalid priority %d\n",
+				session->index, prio.priority);
+			return -EINVAL;
+		}
+
+		session->priority = prio.priority;
+		session->deadline_us = prio.deadline_us;
+	} break;
 	case MPP_CMD_TRANS_FD_TO_IOVA: {
 		u32 i;
 		u32 count;
@@ -1404,6 +1624,43 @@ static int mpp_process_request(struct mpp_session *session,
 	return 0;
 }
 
+static struct mpp_task *
+mpp_session_get_last_task(struct mpp_session *session)
+{
+	struct mpp_task *task = NULL;
+
+	mutex_lock(&session->pending_lock);
+	if (!list_empty(&session->pending_list))
+		task = list_last_entry(&session->pending_list,
+				       struct mpp_task, pending_link);
+	mutex_unlock(&session->pending_lock);
+
+	return task;
+}
+
+/* chain the task just created for msgs after the task of the previous msgs */
+static void task_msgs_chain(struct mpp_task_msgs *msgs, struct list_head *head)
+{
+	struct mpp_task_msgs *prev;
+	struct mpp_session *prev_session;
+	struct mpp_task *prev_task, *task;
+
+	if (list_empty(head))
+		return;
+
+	prev = list_last_entry(head, struct mpp_task_msgs, list);
+	prev_session = prev->session;
+	if (!prev->set_cnt || prev_session == msgs->session)
+		return;
+
+	/* link mode decoders do not fill msgs->task, use the session list */
+	prev_task = mpp_session_get_last_task(prev_session);
+	task = mpp_session_get_last_task(msgs->session);
+
+	if (prev_task && task && !prev_task->chain_next)
+		mpp_task_chain(prev_task, task);
+}
+
 static void task_msgs_add(struct mpp_task_msgs *msgs, struct list_head *head)
 {
 	struct mpp_session *session = msgs->session;
@@ -1414,6 +1671,8 @@ static void task_msgs_add(struct mpp_task_msgs *msgs, struct list_head *head)
 		/* NOTE: update msg_flags for fd over 1024 */
 		session->msg_flags = msgs->flags;
 		ret = mpp_process_task(session, msgs);
+		if (!ret && (msgs->flags & MPP_FLAGS_CHAIN_PREV))
+			task_msgs_chain(msgs, head);
 	}
 
 	if (!ret) {
@@ -1553,6 +1812,28 @@ static int mpp_collect_msgs(struct list_head *head, struct mpp_session *session,
 	return 0;
 }
 
+/*
+ * Insert a task into the pending list ordered by deadline, caller holds
+ * pending_lock. The deadline is the creation time plus a slack from the
+ * session priority, so equal sessions stay FIFO, and a background task
+ * is overtaken only by tasks created less than the extra slack after it,
+ * which keeps it from starving. Never pass a task of the same session
+ * to keep the per-session order that wait_result relies on.
+ */
+static void mpp_taskqueue_insert_pending(struct mpp_taskqueue *queue,
+					 struct mpp_task *task)
+{
+	struct mpp_task *loop;
+
+	list_for_each_entry_reverse(loop, &queue->pending_list, queue_link) {
+		if (loop->session == task->session ||
+		    !ktime_after(loop->deadline, task->deadline))
+			break;
+	}
+
+	list_add(&task->queue_link, &loop->queue_link);
+}
+
 static void mpp_msgs_trigger(struct list_head *msgs_list)
 {
 	struct mpp_task_msgs *msgs, *n;
@@ -1589,7 +1870,7 @@ static void mpp_msgs_trigger(struct list_head *msgs_list)
 			pr_info("try to trigger abort task %d\n", task->task_id);
 
 		set_bit(TASK_STATE_PENDING, &task->state);
-		list_add_tail(&task->queue_link, &queue->pending_list);
+		mpp_taskqueue_insert_pending(queue, task);
 	}
 
 	if (mpp_prev && queue_prev) {
@@ -1598,10 +1879,46 @@ static void mpp_msgs_trigger(struct list_head *msgs_list)
 	}
 }
 
+/*
+ * For a batch carrying several frames in one ioctl, sleep once on the
+ * last polled task. The earlier frames normally complete before it, so
+ * the per-task wait below finds them done and does not sleep again.
+ * Slice polling returns partial results and is left to the normal path.
+ */
+static void mpp_msgs_wait_batch(struct list_head *msgs_list)
+{
+	struct mpp_task_msgs *msgs, *last = NULL;
+	struct mpp_task *task;
+	u32 poll_cnt = 0;
+
+	list_for_each_entry(msgs, msgs_list, list) {
+		if (!msgs->poll_cnt || !msgs->task)
+			continue;
+
+		if (msgs->poll_req)
+			return;
+
+		poll_cnt++;
+		last = msgs;
+	}
+
+	if (poll_cnt < 2)
+		return;
+
+	task = last->task;
+	kref_get(&task->ref);
+	if (wait_event_interruptible(task->wait, mpp_task_hw_done(task)))
+		mpp_debug(DEBUG_IOCTL, "batch wait task %d break by signal\n",
+			  task->task_index);
+	kref_put(&task->ref, mpp_free_task);
+}
+
 static void mpp_msgs_wait(struct list_head *msgs_list)
 {
 	struct mpp_task_msgs *msgs, *n;
 
+	mpp_msgs_wait_batch(msgs_list);
+
 	/* poll and release each task */
 	list_for_each_entry_safe(msgs, n, msgs_list, list) {
 		struct mpp_session *session = msgs->session;
@@ -1714,9 +2031,33 @@ static int mpp_dev_release(struct inode *inode, struct file *filp)
 	return 0;
 }
 
+static __poll_t mpp_dev_poll(struct file *filp, poll_table *wait)
+{
+	struct mpp_session *session = filp->private_data;
+	struct mpp_task *task;
+	__poll_t mask = 0;
+
+	if (!session)
+		return EPOLLERR;
+
+	poll_wait(filp, &session->wait, wait);
+
+	/* readable when the oldest task can be polled without blocking */
+	mutex_lock(&session->pending_lock);
+	task = list_first_entry_or_null(&session->pending_list,
+					struct mpp_task,
+					pending_link);
+	if (task && mpp_task_hw_done(task))
+		mask |= EPOLLIN | EPOLLRDNORM;
+	mutex_unlock(&session->pending_lock);
+
+	return mask;
+}
+
 const struct file_operations rockchip_mpp_fops = {
 	.open		= mpp_dev_open,
 	.release	= mpp_dev_release,
+	.poll		= mpp_dev_poll,
 	.unlocked_ioctl = mpp_dev_ioctl,
 #ifdef CONFIG_COMPAT
 	.compat_ioctl   = mpp_dev_ioctl,
@@ -1925,6 +2266,46 @@ int mpp_translate_reg_offset_info(struct mpp_task *task,
 	return 0;
 }
 
+/*
+ * Driver task objects embed the full register set, so they are large and
+ * allocated for every frame. Devices which set task_size in their
+ * mpp_dev_var get them from a per-device cache instead of kmalloc, which
+ * recycles freed objects and avoids the power-of-two rounding.
+ */
+void *mpp_task_alloc(struct mpp_dev *mpp, size_t size)
+{
+	void *task;
+	int used;
+
+	if (mpp->task_cache) {
+		if (WARN_ON(size > mpp->var->task_size))
+			return NULL;
+		task = kmem_cache_zalloc(mpp->task_cache, GFP_KERNEL);
+	} else {
+		task = kzalloc(size, GFP_KERNEL);
+	}
+	if (!task)
+		return NULL;
+
+	used = atomic_inc_return(&mpp->task_pool_used);
+	if (used > atomic_read(&mpp->task_pool_peak))
+		atomic_set(&mpp->task_pool_peak, used);
+
+	return task;
+}
+
+void mpp_task_free(struct mpp_dev *mpp, void *task)
+{
+	if (!task)
+		return;
+
+	atomic_dec(&mpp->task_pool_used);
+	if (mpp->task_cache)
+		kmem_cache_free(mpp->task_cache, task);
+	else
+		kfree(task);
+}
+
 int mpp_task_init(struct mpp_session *session, struct mpp_task *task)
 {
 	INIT_LIST_HEAD(&task->pending_link);
@@ -1966,7 +2347,7 @@ int mpp_task_finish(struct mpp_session *session,
 	}
 
 	/* Wake up the GET thread */
-	wake_up(&task->wait);
+	mpp_task_wake_up(task);
 	mpp_taskqueue_pop_running(mpp->queue, task);
 
 	return 0;
@@ -2098,6 +2479,7 @@ int mpp_dev_probe(struct mpp_dev *mpp,
 				   &mpp->task_capacity);
 	if (ret)
 		mpp->task_capacity = 1;
+	of_property_read_u32(np, "rockchip,power-hint-mw", &mpp->power_hint_mw);
 
 	mpp->dev = dev;
 	mpp->hw_ops = mpp->var->hw_ops;
@@ -2166,6 +2548,16 @@ int mpp_dev_probe(struct mpp_dev *mpp,
 			goto failed;
 	}
 
+	if (mpp->var->task_size) {
+		mpp->task_cache = kmem_cache_create(dev_name(dev),
+						    mpp->var->task_size, 0,
+						    SLAB_HWCACHE_ALIGN, NULL);
+		if (!mpp->task_cache)
+			dev_warn(dev, "failed to create task cache\n");
+	}
+	atomic_set(&mpp->task_pool_used, 0);
+	atomic_set(&mpp->task_pool_peak, 0);
+
 	/* read hardware id */
 	if (hw_info->reg_id >= 0) {
 		pm_runtime_get_sync(dev);
@@ -2196,6 +2588,8 @@ int mpp_dev_remove(struct mpp_dev *mpp)
 	mpp_detach_workqueue(mpp);
 	device_init_wakeup(mpp->dev, false);
 	pm_runtime_disable(mpp->dev);
+	kmem_cache_destroy(mpp->task_cache);
+	mpp->task_cache = NULL;
 
 	return 0;
 }
@@ -2245,6 +2639,8 @@ irqreturn_t mpp_dev_irq(int irq, void *param)
 	if (mpp->dev_ops->irq)
 		irq_ret = mpp->dev_ops->irq(mpp);
 
+	rk_fr_log(RK_FR_SRC_MPP, RK_FR_EV_IRQ, mpp->var->device_type, mpp->irq_status);
+
 	if (task) {
 		if (irq_ret == IRQ_WAKE_THREAD) {
 			/* if wait or delayed work timeout, abort request will turn on,
@@ -2603,9 +2999,50 @@ mpp_procfs_create_u32(const char *name, umode_t mode,
 	return proc_create_data(name, mode, parent, &procfs_fops_u32, data);
 }
 
+void mpp_show_task_stats(struct seq_file *seq, struct mpp_task_stats *stats)
+{
+	seq_printf(seq, " frames:     %lld\n", atomic64_read(&stats->frames));
+	seq_printf(seq, " hw_cycles:  %lld\n", atomic64_read(&stats->hw_cycles));
+	seq_printf(seq, " prepare_us: %lld\n", atomic64_read(&stats->prepare_us));
+	seq_printf(seq, " wait_us:    %lld\n", atomic64_read(&stats->wait_us));
+	seq_printf(seq, " run_us:     %lld\n", atomic64_read(&stats->run_us));
+	seq_printf(seq, " timeouts:   %lld\n", atomic64_read(&stats->timeouts));
+	seq_printf(seq, " resets:     %lld\n", atomic64_read(&stats->resets));
+}
+
+static int mpp_show_dev_stats(struct seq_file *seq, void *offset)
+{
+	struct mpp_dev *mpp = seq->private;
+
+	seq_printf(seq, "%s:%d\n", dev_name(mpp->dev), mpp->core_id);
+	mpp_show_task_stats(seq, &mpp->stats);
+	seq_printf(seq, " power_on:   %lld\n", atomic64_read(&mpp->power_on));
+	seq_printf(seq, " pre_on:     %lld\n", atomic64_read(&mpp->power_pre_on));
+	seq_printf(seq, " power_off:  %lld\n", atomic64_read(&mpp->power_off));
+	seq_printf(seq, " power_hold: %lld\n", atomic64_read(&mpp->power_hold));
+	seq_printf(seq, " hold_ms:    %u\n", READ_ONCE(mpp->power_hold_ms));
+
+	return 0;
+}
+
+static int mpp_show_task_pool(struct seq_file *seq, void *offset)
+{
+	struct mpp_dev *mpp = seq->private;
+
+	seq_printf(seq, "%-8s %8s %8s %8s\n", "pool", "size", "used", "peak");
+	seq_printf(seq, "%-8s %8zu %8d %8d\n",
+		   mpp->task_cache ? "cache" : "kmalloc", mpp->var->task_size,
+		   atomic_read(&mpp->task_pool_used),
+		   atomic_read(&mpp->task_pool_peak));
+
+	return 0;
+}
+
 void mpp_procfs_create_common(struct proc_dir_entry *parent, struct mpp_dev *mpp)
 {
 	mpp_procfs_create_u32("disable_work", 0644, parent, &mpp->disable);
 	mpp_procfs_create_u32("timing_check", 0644, parent, &mpp->timing_check);
+	proc_create_single_data("stats", 0444, parent, mpp_show_dev_stats, mpp);
+	proc_create_single_data("task_pool", 0444, parent, mpp_show_task_pool, mpp);
 }
 #endif
@@ -39,6 +39,12 @@
 /* max 4 cores supported */
 #define MPP_MAX_CORE_NUM		(4)
 
+/* task slack in the taskqueue for priority 0, doubled for each lower level */
+#define MPP_PRIO_SLACK_US		(8000)
+
+/* longest frame interval the device is kept powered across, in ms */
+#define MPP_POWER_HOLD_MAX_MS		(2000)
+
 /**
  * Device type: classified by hardware feature
  */
@@ -250,6 +256,8 @@ struct mpp_dev_var {
 	struct mpp_trans_info *trans_info;
 	struct mpp_hw_ops *hw_ops;
 	struct mpp_dev_ops *dev_ops;
+	/* size of the task object, allocated from a per-device cache if set */
+	size_t task_size;
 };
 
 struct mpp_mem_region {
@@ -265,6 +273,18 @@ struct mpp_mem_region {
 };
 
 
+/* task statistics accumulated per device and per session */
+struct mpp_task_stats {
+	atomic64_t frames;
+	atomic64_t hw_cycles;
+	/* us spent in alloc_task, in the queue and from run to done */
+	atomic64_t prepare_us;
+	atomic64_t wait_us;
+	atomic64_t run_us;
+	atomic64_t timeouts;
+	atomic64_t resets;
+};
+
 struct mpp_dev {
 	struct device *dev;
 	const struct mpp_dev_var *var;
@@ -290,6 +310,8 @@ struct mpp_dev {
 	 * Multi-core hardware can accept more message at one shot ioctl.
 	 */
 	u32 msgs_cap;
+	/* power announced to the system monitor for each task, in mW */
+	u32 power_hint_mw;
 
 	int irq;
 	bool is_irq_startup;
@@ -322,6 +344,25 @@ struct mpp_dev {
 	/* common per-device procfs */
 	u32 disable;
 	u32 timing_check;
+
+	struct mpp_task_stats stats;
+
+	/*
+	 * runtime pm transitions: cold power on in the run path, resumes
+	 * started early at submit, immediate power off on idle, and idle
+	 * periods held with autosuspend across the frame interval
+	 */
+	atomic64_t power_on;
+	atomic64_t power_pre_on;
+	atomic64_t power_off;
+	atomic64_t power_hold;
+	/* autosuspend delay to use on the next idle, 0 to power off */
+	u32 power_hold_ms;
+
+	/* task object cache, see mpp_task_alloc */
+	struct kmem_cache *task_cache;
+	atomic_t task_pool_used;
+	atomic_t task_pool_peak;
 };
 
 struct mpp_session {
@@ -368,6 +409,20 @@ struct mpp_session {
 	struct list_head list_msgs;
 	struct list_head list_msgs_idle;
 	spinlock_t lock_msgs;
+
+	/* wait queue for poll on the session fd */
+	wait_queue_head_t wait;
+	/* optional eventfd signaled on each task completion */
+	struct eventfd_ctx *done_evfd;
+	/* scheduling on the shared taskqueue, see struct mpp_session_prio */
+	u32 priority;
+	u32 deadline_us;
+
+	/* averaged interval between task submits, 0 if irregular */
+	ktime_t last_submit;
+	u32 frame_interval_us;
+
+	struct mpp_task_stats stats;
 };
 
 /* task state in work thread */
@@ -385,6 +440,7 @@ enum mpp_task_state {
 	TASK_STATE_ABORT	= 9,
 	TASK_STATE_ABORT_READY	= 10,
 	TASK_STATE_PROC_DONE	= 11,
+	TASK_STATE_STATS	= 12,
 
 	/* timing debug state */
 	TASK_TIMING_CREATE	= 16,
@@ -438,6 +494,18 @@ struct mpp_task {
 	ktime_t on_isr;
 	ktime_t on_finish;
 
+	/* always recorded for the task statistics */
+	ktime_t stat_create;
+	ktime_t stat_create_end;
+	ktime_t stat_run;
+	/* the time this task should start by, taskqueue pending order */
+	ktime_t deadline;
+
+	/* post-process task started when this task is done */
+	struct mpp_task *chain_next;
+	/* set while waiting for the task chained before this one */
+	atomic_t chain_wait;
+
 	/* hardware info for current task */
 	struct mpp_hw_info *hw_info;
 	u32 task_index;
@@ -642,6 +710,10 @@ void mpp_task_dump_timing(struct mpp_task *task, s64 time_diff);
 void mpp_reg_show(struct mpp_dev *mpp, u32 offset);
 void mpp_reg_show_range(struct mpp_dev *mpp, u32 start, u32 end);
 void mpp_free_task(struct kref *ref);
+void mpp_task_wake_up(struct mpp_task *task);
+void *mpp_task_alloc(struct mpp_dev *mpp, size_t size);
+void mpp_task_free(struct mpp_dev *mpp, void *task);
+void mpp_task_chain_release(struct mpp_task *task);
 
 void mpp_session_deinit(struct mpp_session *session);
 void mpp_session_cleanup_detach(struct mpp_taskqueue *queue,
@@ -821,6 +893,7 @@ struct proc_dir_entry *
 mpp_procfs_create_u32(const char *name, umode_t mode,
 		      struct proc_dir_entry *parent, void *data);
 void mpp_procfs_create_common(struct proc_dir_entry *parent, struct mpp_dev *mpp);
+void mpp_show_task_stats(struct seq_file *seq, struct mpp_task_stats *stats);
 #else
 static inline struct proc_dir_entry *
 mpp_procfs_create_u32(const char *name, umode_t mode,
@@ -38,14 +38,20 @@ mpp_dma_find_buffer_fd(struct mpp_dma_session *dma, int fd)
 	if (IS_ERR(dmabuf))
 		return NULL;
 
+	/*
+	 * used_list is kept in LRU order, oldest at head. Scan from the
+	 * tail so the buffers reused every frame are found first, and move
+	 * a hit to the tail to keep the order.
+	 */
 	mutex_lock(&dma->list_mutex);
-	list_for_each_entry_safe(buffer, n,
-				 &dma->used_list, link) {
+	list_for_each_entry_safe_reverse(buffer, n,
+					 &dma->used_list, link) {
 		/*
 		 * fd may dup several and point the same dambuf.
 		 * thus, here should be distinguish with the dmabuf.
 		 */
 		if (buffer->dmabuf == dmabuf) {
+			list_move_tail(&buffer->link, &dma->used_list);
 			out = buffer;
 			break;
 		}
@@ -84,22 +90,19 @@ static int
 mpp_dma_remove_extra_buffer(struct mpp_dma_session *dma)
 {
 	struct mpp_dma_buffer *n;
-	struct mpp_dma_buffer *oldest = NULL, *buffer = NULL;
-	ktime_t oldest_time = ktime_set(0, 0);
+	struct mpp_dma_buffer *buffer = NULL;
 
 	if (dma->buffer_count > dma->max_buffers) {
 		mutex_lock(&dma->list_mutex);
+		/* drop the least recently used buffer not held by a task */
 		list_for_each_entry_safe(buffer, n,
 					 &dma->used_list,
 					 link) {
-			if (ktime_to_ns(oldest_time) == 0 ||
-			    ktime_after(oldest_time, buffer->last_used)) {
-				oldest_time = buffer->last_used;
-				oldest = buffer;
+			if (kref_read(&buffer->ref) == 1) {
+				kref_put(&buffer->ref, mpp_dma_release_buffer);
+				break;
 			}
 		}
-		if (oldest && kref_read(&oldest->ref) == 1)
-			kref_put(&oldest->ref, mpp_dma_release_buffer);
 		mutex_unlock(&dma->list_mutex);
 	}
 
@@ -73,6 +73,9 @@
 
 #define JPGDEC_REG_PERF_WORKING_CNT	0x9c
 
+/* keep clocks on this long after a task when more tasks are queued */
+#define JPGDEC_CLK_IDLE_MS		(10)
+
 #define to_jpgdec_task(task)	\
 		container_of(task, struct jpgdec_task, mpp_task)
 #define to_jpgdec_dev(dev)	\
@@ -103,6 +106,12 @@ struct jpgdec_dev {
 #endif
 	struct reset_control *rst_a;
 	struct reset_control *rst_h;
+
+	/* lock for clock state below */
+	struct mutex clk_lock;
+	bool clk_enabled;
+	bool clk_busy;
+	struct delayed_work clk_work;
 };
 
 static struct mpp_hw_info jpgdec_v1_hw_info = {
@@ -411,11 +420,32 @@ static inline int jpgdec_procfs_init(struct mpp_dev *mpp)
 }
 #endif
 
+static void jpgdec_clk_disable(struct jpgdec_dev *dec)
+{
+	mpp_clk_safe_disable(dec->aclk_info.clk);
+	mpp_clk_safe_disable(dec->hclk_info.clk);
+	dec->clk_enabled = false;
+}
+
+static void jpgdec_clk_idle_work(struct work_struct *work_s)
+{
+	struct jpgdec_dev *dec = container_of(to_delayed_work(work_s),
+					      struct jpgdec_dev, clk_work);
+
+	mutex_lock(&dec->clk_lock);
+	if (dec->clk_enabled && !dec->clk_busy)
+		jpgdec_clk_disable(dec);
+	mutex_unlock(&dec->clk_lock);
+}
+
 static int jpgdec_init(struct mpp_dev *mpp)
 {
 	int ret;
 	struct jpgdec_dev *dec = to_jpgdec_dev(mpp);
 
+	mutex_init(&dec->clk_lock);
+	INIT_DELAYED_WORK(&dec->clk_work, jpgdec_clk_idle_work);
+
 	/* Get clock info from dtsi */
 	ret = mpp_get_clk_info(mpp, &dec->aclk_info, "aclk_vcodec");
 	if (ret)
@@ -441,8 +471,15 @@ static int jpgdec_clk_on(struct mpp_dev *mpp)
 {
 	struct jpgdec_dev *dec = to_jpgdec_dev(mpp);
 
-	mpp_clk_safe_enable(dec->aclk_info.clk);
-	mpp_clk_safe_enable(dec->hclk_info.clk);
+	mutex_lock(&dec->clk_lock);
+	cancel_delayed_work(&dec->clk_work);
+	if (!dec->clk_enabled) {
+		mpp_clk_safe_enable(dec->aclk_info.clk);
+		mpp_clk_safe_enable(dec->hclk_info.clk);
+		dec->clk_enabled = true;
+	}
+	dec->clk_busy = true;
+	mutex_unlock(&dec->clk_lock);
 
 	return 0;
 }
@@ -451,8 +488,21 @@ static int jpgdec_clk_off(struct mpp_dev *mpp)
 {
 	struct jpgdec_dev *dec = to_jpgdec_dev(mpp);
 
-	mpp_clk_safe_disable(dec->aclk_info.clk);
-	mpp_clk_safe_disable(dec->hclk_info.clk);
+	/*
+	 * Gating and ungating the clocks costs about as much as decoding
+	 * a thumbnail, so keep them on while images are queued back to
+	 * back and let the idle work gate them if nothing follows.
+	 */
+	mutex_lock(&dec->clk_lock);
+	dec->clk_busy = false;
+	if (dec->clk_enabled) {
+		if (mpp->queue && !list_empty_careful(&mpp->queue->pending_list))
+			schedule_delayed_work(&dec->clk_work,
+					      msecs_to_jiffies(JPGDEC_CLK_IDLE_MS));
+		else
+			jpgdec_clk_disable(dec);
+	}
+	mutex_unlock(&dec->clk_lock);
 
 	return 0;
 }
@@ -639,11 +689,17 @@ static int jpgdec_remove(struct platform_device *pdev)
 {
 	struct device *dev = &pdev->dev;
 	struct mpp_dev *mpp = dev_get_drvdata(dev);
+	struct jpgdec_dev *dec = to_jpgdec_dev(mpp);
 
 	dev_info(dev, "remove device\n");
 	mpp_dev_remove(mpp);
 	jpgdec_procfs_remove(mpp);
 
+	/* gate the clocks still kept on for queued images */
+	cancel_delayed_work_sync(&dec->clk_work);
+	if (dec->clk_enabled)
+		jpgdec_clk_disable(dec);
+
 	return 0;
 }
 
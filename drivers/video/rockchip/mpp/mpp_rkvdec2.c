@@ -285,28 +285,73 @@ int mpp_set_rcbbuf(struct mpp_dev *mpp, struct mpp_session *session,
 	mpp_debug_enter();
 
 	if (priv && dec->rcb_iova) {
-		u32 i;
-		u32 reg_idx, rcb_size, rcb_offset;
+		u32 i, j, cnt;
+		u32 reg_idx, rcb_size, rcb_offset, window_offset;
+		u32 sram_bytes = 0, total_bytes = 0;
+		u8 order[RKVDEC_MAX_RCB_NUM];
+		bool placed[RKVDEC_MAX_RCB_NUM];
 		struct rkvdec2_rcb_info *rcb_inf = &priv->rcb_inf;
+		struct rkvdec2_rcb_stats *stats = &dec->rcb_stats;
 		u32 width = priv->codec_info[DEC_INFO_WIDTH].val;
 
-		if (width < dec->rcb_min_width)
+		atomic64_inc(&stats->tasks);
+		if (width < dec->rcb_min_width) {
+			atomic64_inc(&stats->narrow_tasks);
 			goto done;
+		}
+
+		/*
+		 * The window is reused by every task, as the core decodes one
+		 * at a time. Place the largest buffers first so the sram part
+		 * keeps as many rcb bytes as possible, then fill the ddr tail
+		 * of the window with the rest.
+		 */
+		cnt = min_t(u32, rcb_inf->cnt, RKVDEC_MAX_RCB_NUM);
+		for (i = 0; i < cnt; i++) {
+			rcb_size = rcb_inf->elem[i].size;
+			for (j = i; j > 0 && rcb_inf->elem[order[j - 1]].size < rcb_size; j--)
+				order[j] = order[j - 1];
+			order[j] = i;
+			placed[i] = false;
+		}
 
 		rcb_offset = 0;
-		for (i = 0; i < rcb_inf->cnt; i++) {
+		window_offset = dec->sram_size;
+		for (j = 0; j < cnt * 2; j++) {
+			bool sram_pass = j < cnt;
+
+			i = order[j % cnt];
 			reg_idx = rcb_inf->elem[i].index;
 			rcb_size = rcb_inf->elem[i].size;
-			if ((rcb_offset + rcb_size) > dec->rcb_size) {
-				mpp_debug(DEBUG_SRAM_INFO,
-					  "rcb: reg %d use original buffer\n", reg_idx);
+			if (placed[i] || reg_idx >= RKVDEC_REG_NUM)
 				continue;
+
+			if (sram_pass) {
+				total_bytes += rcb_size;
+				if (rcb_offset + rcb_size > dec->sram_size)
+					continue;
+				task->reg[reg_idx] = dec->rcb_iova + rcb_offset;
+				rcb_offset += rcb_size;
+				sram_bytes += rcb_size;
+				atomic64_inc(&stats->sram_elems);
+			} else {
+				if (window_offset + rcb_size > dec->rcb_size) {
+					mpp_debug(DEBUG_SRAM_INFO,
+						  "rcb: reg %d use original buffer\n", reg_idx);
+					atomic64_inc(&stats->user_elems);
+					continue;
+				}
+				task->reg[reg_idx] = dec->rcb_iova + window_offset;
+				window_offset += rcb_size;
+				atomic64_inc(&stats->window_elems);
 			}
+			placed[i] = true;
 			mpp_debug(DEBUG_SRAM_INFO, "rcb: reg %d offset %d, size %d\n",
-				  reg_idx, rcb_offset, rcb_size);
-			task->reg[reg_idx] = dec->rcb_iova + rcb_offset;
-			rcb_offset += rcb_size;
+				  reg_idx, task->reg[reg_idx] - (u32)dec->rcb_iova,
+				  rcb_size);
 		}
+		atomic64_add(sram_bytes, &stats->sram_bytes);
+		atomic64_add(total_bytes, &stats->total_bytes);
 	}
 done:
 	mpp_debug_leave();
@@ -377,13 +422,13 @@ void *rkvdec2_alloc_task(struct mpp_session *session,
 	int ret;
 	struct rkvdec2_task *task;
 
-	task = kzalloc(sizeof(*task), GFP_KERNEL);
+	task = mpp_task_alloc(session->mpp, sizeof(*task));
 	if (!task)
 		return NULL;
 
 	ret = rkvdec2_task_init(session->mpp, session, task, msgs);
 	if (ret) {
-		kfree(task);
+		mpp_task_free(session->mpp, task);
 		return NULL;
 	}
 	mpp_set_rcbbuf(session->mpp, session, &task->mpp_task);
@@ -774,7 +819,7 @@ int rkvdec2_free_task(struct mpp_session *session, struct mpp_task *mpp_task)
 	struct rkvdec2_task *task = to_rkvdec2_task(mpp_task);
 
 	mpp_task_finalize(session, mpp_task);
-	kfree(task);
+	mpp_task_free(session->mpp, task);
 
 	return 0;
 }
@@ -868,6 +913,32 @@ static int rkvdec2_show_pref_sel_offset(struct seq_file *file, void *v)
 	return 0;
 }
 
+static int rkvdec2_show_rcb_stats(struct seq_file *file, void *v)
+{
+	struct rkvdec2_dev *dec = file->private;
+	struct rkvdec2_rcb_stats *stats = &dec->rcb_stats;
+	u64 sram = atomic64_read(&stats->sram_elems);
+	u64 total = sram + atomic64_read(&stats->window_elems) +
+		    atomic64_read(&stats->user_elems);
+
+	seq_printf(file, "sram_size: %u rcb_size: %u min_width: %u\n",
+		   dec->sram_size, dec->rcb_size, dec->rcb_min_width);
+	seq_printf(file, "tasks: %lld narrow: %lld\n",
+		   atomic64_read(&stats->tasks),
+		   atomic64_read(&stats->narrow_tasks));
+	seq_printf(file, "elems sram: %llu window: %lld user: %lld hit: %llu%%\n",
+		   sram, atomic64_read(&stats->window_elems),
+		   atomic64_read(&stats->user_elems),
+		   total ? div64_u64(sram * 100, total) : 0);
+	/* each rcb byte kept in sram is at least one ddr write and read saved */
+	seq_printf(file, "bytes sram: %lld total: %lld ddr saved: %lld\n",
+		   atomic64_read(&stats->sram_bytes),
+		   atomic64_read(&stats->total_bytes),
+		   atomic64_read(&stats->sram_bytes) * 2);
+
+	return 0;
+}
+
 static int rkvdec2_procfs_init(struct mpp_dev *mpp)
 {
 	struct rkvdec2_dev *dec = to_rkvdec2_dev(mpp);
@@ -903,6 +974,9 @@ static int rkvdec2_procfs_init(struct mpp_dev *mpp)
 			   dec->procfs, rkvdec2_show_pref_sel_offset);
 	mpp_procfs_create_u32("task_count", 0644,
 			      dec->procfs, &mpp->task_index);
+	if (dec->rcb_iova)
+		proc_create_single_data("rcb_stats", 0444, dec->procfs,
+					rkvdec2_show_rcb_stats, dec);
 
 	return 0;
 }
@@ -1516,6 +1590,7 @@ static const struct mpp_dev_var rkvdec_v2_data = {
 	.trans_info = rkvdec_v2_trans,
 	.hw_ops = &rkvdec_v2_hw_ops,
 	.dev_ops = &rkvdec_v2_dev_ops,
+	.task_size = sizeof(struct rkvdec2_task),
 };
 
 static const struct mpp_dev_var rkvdec_rk3568_data = {
@@ -1524,6 +1599,7 @@ static const struct mpp_dev_var rkvdec_rk3568_data = {
 	.trans_info = rkvdec_v2_trans,
 	.hw_ops = &rkvdec_rk3568_hw_ops,
 	.dev_ops = &rkvdec_rk3568_dev_ops,
+	.task_size = sizeof(struct rkvdec2_task),
 };
 
 static const struct mpp_dev_var rkvdec_vdpu382_data = {
@@ -1532,6 +1608,7 @@ static const struct mpp_dev_var rkvdec_vdpu382_data = {
 	.trans_info = rkvdec_v2_trans,
 	.hw_ops = &rkvdec_v2_hw_ops,
 	.dev_ops = &rkvdec_v2_dev_ops,
+	.task_size = sizeof(struct rkvdec2_task),
 };
 
 static const struct mpp_dev_var rkvdec_rk3588_data = {
@@ -1540,6 +1617,7 @@ static const struct mpp_dev_var rkvdec_rk3588_data = {
 	.trans_info = rkvdec_v2_trans,
 	.hw_ops = &rkvdec_rk3588_hw_ops,
 	.dev_ops = &rkvdec_v2_dev_ops,
+	.task_size = sizeof(struct rkvdec2_task),
 };
 
 static const struct mpp_dev_var rkvdec_rk3576_data = {
@@ -1548,6 +1626,7 @@ static const struct mpp_dev_var rkvdec_rk3576_data = {
 	.trans_info = rkvdec_vdpu383_trans,
 	.hw_ops = &rkvdec_rk3576_hw_ops,
 	.dev_ops = &rkvdec_vdpu383_dev_ops,
+	.task_size = sizeof(struct rkvdec2_task),
 };
 
 static const struct of_device_id mpp_rkvdec2_dt_match[] = {
@@ -120,6 +120,20 @@ struct rkvdec2_rcb_info {
 	struct rcb_info_elem elem[RKVDEC_MAX_RCB_NUM];
 };
 
+/* where the rcb buffers of the decoded tasks ended up */
+struct rkvdec2_rcb_stats {
+	atomic64_t tasks;
+	/* tasks narrower than rcb_min_width, left in ddr */
+	atomic64_t narrow_tasks;
+	atomic64_t sram_elems;
+	/* placed in the ddr tail of the rcb window */
+	atomic64_t window_elems;
+	/* left in the buffer given by userspace */
+	atomic64_t user_elems;
+	atomic64_t sram_bytes;
+	atomic64_t total_bytes;
+};
+
 struct rkvdec2_task {
 	struct mpp_task mpp_task;
 
@@ -204,6 +218,7 @@ struct rkvdec2_dev {
 	u32 rcb_min_width;
 	u32 rcb_info_count;
 	u32 rcb_infos[RKVDEC_MAX_RCB_NUM * 2];
+	struct rkvdec2_rcb_stats rcb_stats;
 
 	/* for link mode */
 	struct rkvdec_link_dev *link_dec;
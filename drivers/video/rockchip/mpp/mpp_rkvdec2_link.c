@@ -575,6 +575,8 @@ static int rkvdec2_link_reset(struct mpp_dev *mpp)
 	mpp_iommu_down_write(mpp->iommu_info);
 	mpp_reset_down_write(mpp->reset_group);
 	atomic_set(&mpp->reset_request, 0);
+	atomic64_inc(&mpp->stats.resets);
+	to_rkvdec2_dev(mpp)->link_dec->reset_cnt++;
 
 	rockchip_save_qos(mpp->dev);
 
@@ -721,9 +723,18 @@ int rkvdec2_link_procfs_init(struct mpp_dev *mpp)
 
 	link_dec->statistic_count = 0;
 
-	if (dec->procfs)
+	if (dec->procfs) {
 		mpp_procfs_create_u32("statistic_count", 0644,
 				      dec->procfs, &link_dec->statistic_count);
+		mpp_procfs_create_u32("link_err_no_reset", 0644,
+				      dec->procfs, &link_dec->err_no_reset);
+		mpp_procfs_create_u32("link_err_skip", 0644,
+				      dec->procfs, &link_dec->err_skip_cnt);
+		mpp_procfs_create_u32("link_reset", 0644,
+				      dec->procfs, &link_dec->reset_cnt);
+		mpp_procfs_create_u32("link_resend", 0644,
+				      dec->procfs, &link_dec->resend_cnt);
+	}
 
 	return 0;
 }
@@ -848,6 +859,7 @@ static void rkvdec2_link_free_task(struct kref *ref)
 	}
 	mpp = session->mpp;
 	list_del_init(&task->queue_link);
+	mpp_task_chain_release(task);
 
 	rkvdec2_free_task(session, task);
 	/* Decrease reference count */
@@ -1004,6 +1016,7 @@ static void rkvdec2_link_resend(struct mpp_dev *mpp)
 	link_dec->task_running = 0;
 	list_for_each_entry_safe(mpp_task, n, &queue->running_list, queue_link) {
 		dev_err(mpp->dev, "resend task %d\n", mpp_task->task_index);
+		link_dec->resend_cnt++;
 		cancel_delayed_work_sync(&mpp_task->timeout_work);
 		clear_bit(TASK_STATE_TIMEOUT, &mpp_task->state);
 		clear_bit(TASK_STATE_HANDLE, &mpp_task->state);
@@ -1059,7 +1072,7 @@ static void rkvdec2_link_try_dequeue(struct mpp_dev *mpp)
 			list_del_init(&mpp_task->queue_link);
 			link_dec->task_running--;
 			link_dec->hack_task_running--;
-			kfree(task);
+			mpp_task_free(mpp, task);
 			mpp_dbg_link("hack running %d irq_status %#08x timeout %d abort %d\n",
 				     link_dec->hack_task_running, irq_status,
 				     timeout_flag, abort_flag);
@@ -1107,11 +1120,18 @@ static void rkvdec2_link_try_dequeue(struct mpp_dev *mpp)
 				"session %d task %d irq_status %#08x timeout %u abort %u\n",
 				mpp_task->session->index, mpp_task->task_index,
 				irq_status, timeout_flag, abort_flag);
-			if (!reset_flag)
+			/*
+			 * The hardware has written back this node and moved
+			 * on to the next one, so when allowed only drop the
+			 * error frame and keep the link running.
+			 */
+			if (link_dec->err_no_reset && link_en && !timeout_flag)
+				link_dec->err_skip_cnt++;
+			else if (!reset_flag)
 				atomic_inc(&mpp->reset_request);
 		}
 
-		wake_up(&mpp_task->wait);
+		mpp_task_wake_up(mpp_task);
 		kref_put(&mpp_task->ref, rkvdec2_link_free_task);
 	}
 
@@ -1148,7 +1168,7 @@ static int mpp_task_queue(struct mpp_dev *mpp, struct mpp_task *mpp_task)
 		if (!table)
 			return -EBUSY;
 
-		hack_task = kzalloc(sizeof(*hack_task), GFP_KERNEL);
+		hack_task = mpp_task_alloc(mpp, sizeof(*hack_task));
 
 		if (!hack_task)
 			return -ENOMEM;
@@ -1361,7 +1381,7 @@ void rkvdec2_link_worker(struct kthread_work *work_s)
 		set_bit(TASK_STATE_PROC_DONE, &task->state);
 
 		mutex_unlock(&queue->pending_lock);
-		wake_up(&task->wait);
+		mpp_task_wake_up(task);
 		kref_put(&task->ref, rkvdec2_link_free_task);
 		goto again;
 	}
@@ -1650,7 +1670,7 @@ static int rkvdec2_soft_ccu_dequeue(struct mpp_taskqueue *queue)
 			set_bit(mpp->core_id, &queue->core_idle);
 			mpp_dbg_core("set core %d idle %lx\n", mpp->core_id, queue->core_idle);
 			/* Wake up the GET thread */
-			wake_up(&mpp_task->wait);
+			mpp_task_wake_up(mpp_task);
 			/* free task */
 			list_del_init(&mpp_task->queue_link);
 			kref_put(&mpp_task->ref, mpp_free_task);
@@ -1728,13 +1748,13 @@ void *rkvdec2_ccu_alloc_task(struct mpp_session *session,
 	int ret;
 	struct rkvdec2_task *task;
 
-	task = kzalloc(sizeof(*task), GFP_KERNEL);
+	task = mpp_task_alloc(session->mpp, sizeof(*task));
 	if (!task)
 		return NULL;
 
 	ret = rkvdec2_task_init(session->mpp, session, task, msgs);
 	if (ret) {
-		kfree(task);
+		mpp_task_free(session->mpp, task);
 		return NULL;
 	}
 
@@ -2039,7 +2059,7 @@ void rkvdec2_soft_ccu_worker(struct kthread_work *work_s)
 			set_bit(TASK_STATE_PROC_DONE, &mpp_task->state);
 
 			mutex_unlock(&queue->pending_lock);
-			wake_up(&mpp_task->wait);
+			mpp_task_wake_up(mpp_task);
 			kref_put(&mpp_task->ref, rkvdec2_link_free_task);
 			continue;
 		}
@@ -2250,7 +2270,7 @@ static int rkvdec2_hard_ccu_dequeue(struct mpp_taskqueue *queue,
 			/* free task */
 			list_del_init(&mpp_task->queue_link);
 			/* Wake up the GET thread */
-			wake_up(&mpp_task->wait);
+			mpp_task_wake_up(mpp_task);
 			if ((irq_status & RKVDEC_INT_ERROR_MASK) || timeout_flag) {
 				pr_err("session %d task %d irq_status %#x timeout=%u abort=%u\n",
 					mpp_task->session->index, mpp_task->task_index,
@@ -170,6 +170,15 @@ struct rkvdec_link_dev {
 	atomic_t power_enabled;
 	u32 irq_enabled;
 
+	/*
+	 * error recovery, err_no_reset skips the core reset for a node that
+	 * reports a decode error while the link keeps running
+	 */
+	u32 err_no_reset;
+	u32 err_skip_cnt;
+	u32 reset_cnt;
+	u32 resend_cnt;
+
 	/* debug variable */
 	u32 statistic_count;
 	u64 task_cycle_sum;
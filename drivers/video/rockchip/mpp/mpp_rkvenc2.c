@@ -314,6 +314,8 @@ struct rkvenc_dev {
 	/* for ccu */
 	struct rkvenc_ccu *ccu;
 	struct list_head core_link;
+	/* tasks dispatched to this core by the ccu */
+	u32 dispatch_cnt;
 
 	/* internal rcb-memory */
 	u32 sram_size;
@@ -336,6 +338,8 @@ struct rkvenc_ccu {
 	struct mutex lock;
 	struct list_head core_list;
 	struct mpp_dev *main_core;
+	/* core picked by the last dispatch, protected by queue running_lock */
+	u32 last_core;
 
 	spinlock_t lock_dchs;
 	union rkvenc2_dual_core_handshake_id dchs[RKVENC_MAX_CORE_NUM];
@@ -1038,7 +1042,7 @@ static void *rkvenc_alloc_task(struct mpp_session *session,
 
 	mpp_debug_enter();
 
-	task = kzalloc(sizeof(*task), GFP_KERNEL);
+	task = mpp_task_alloc(mpp, sizeof(*task));
 	if (!task)
 		return NULL;
 
@@ -1119,7 +1123,7 @@ static void *rkvenc_alloc_task(struct mpp_session *session,
 	/* free class register buffer */
 	rkvenc_free_class_msg(task);
 free_task:
-	kfree(task);
+	mpp_task_free(mpp, task);
 
 	return NULL;
 }
@@ -1127,6 +1131,7 @@ static void *rkvenc_alloc_task(struct mpp_session *session,
 static void *rkvenc2_prepare(struct mpp_dev *mpp, struct mpp_task *mpp_task)
 {
 	struct mpp_taskqueue *queue = mpp->queue;
+	struct rkvenc_ccu *ccu = to_rkvenc_dev(mpp)->ccu;
 	unsigned long core_idle;
 	unsigned long flags;
 	u32 core_id_max;
@@ -1145,7 +1150,16 @@ static void *rkvenc2_prepare(struct mpp_dev *mpp, struct mpp_task *mpp_task)
 			clear_bit(i, &core_idle);
 	}
 
-	core_id = find_first_bit(&core_idle, core_id_max + 1);
+	/*
+	 * Rotate from the core used by the last dispatch instead of always
+	 * starting at core 0, so frames from independent sessions spread
+	 * over all idle cores. Dual-core handshake frames do not need to
+	 * stay on one core, their tx/rx ids are remapped per core by
+	 * rkvenc2_patch_dchs().
+	 */
+	core_id = find_next_bit(&core_idle, core_id_max + 1, ccu->last_core + 1);
+	if (core_id >= core_id_max + 1)
+		core_id = find_first_bit(&core_idle, core_id_max + 1);
 
 	if (core_id >= core_id_max + 1 || !queue->cores[core_id]) {
 		mpp_task = NULL;
@@ -1154,8 +1168,10 @@ static void *rkvenc2_prepare(struct mpp_dev *mpp, struct mpp_task *mpp_task)
 		struct rkvenc_task *task = to_rkvenc_task(mpp_task);
 
 		clear_bit(core_id, &queue->core_idle);
+		ccu->last_core = core_id;
 		mpp_task->mpp = queue->cores[core_id];
 		mpp_task->core_id = core_id;
+		to_rkvenc_dev(mpp_task->mpp)->dispatch_cnt++;
 		rkvenc2_set_rcbbuf(mpp_task->mpp, mpp_task->session, task);
 		mpp_dbg_core("core %d set idle %lx -> %lx\n", core_id,
 			     core_idle, queue->core_idle);
@@ -1567,7 +1583,7 @@ static int rkvenc_irq(struct mpp_dev *mpp)
 	    (irq_status & (INT_STA_SLC_DONE_STA | INT_STA_ENC_DONE_STA))) {
 		mpp_time_part_diff(mpp_task);
 		rkvenc2_read_slice_len(mpp, task, &irq_status);
-		wake_up(&mpp_task->wait);
+		mpp_task_wake_up(mpp_task);
 	}
 
 	/* 2. process slice irq */
@@ -1736,7 +1752,7 @@ static int rkvenc_free_task(struct mpp_session *session,
 
 	mpp_task_finalize(session, mpp_task);
 	rkvenc_free_class_msg(task);
-	kfree(task);
+	mpp_task_free(session->mpp, task);
 
 	return 0;
 }
@@ -1933,6 +1949,8 @@ static int rkvenc_procfs_ccu_init(struct mpp_dev *mpp)
 	if (!enc->procfs)
 		goto done;
 
+	mpp_procfs_create_u32("ccu_dispatch", 0644,
+			      enc->procfs, &enc->dispatch_cnt);
 done:
 	return 0;
 }
@@ -2414,6 +2432,7 @@ static const struct mpp_dev_var rkvenc_v2_data = {
 	.trans_info = trans_rkvenc_v2,
 	.hw_ops = &rkvenc_hw_ops,
 	.dev_ops = &rkvenc_dev_ops_v2,
+	.task_size = sizeof(struct rkvenc_task),
 };
 
 static const struct mpp_dev_var rkvenc_540c_data = {
@@ -2422,6 +2441,7 @@ static const struct mpp_dev_var rkvenc_540c_data = {
 	.trans_info = trans_rkvenc_540c,
 	.hw_ops = &rkvenc_hw_ops,
 	.dev_ops = &vepu540c_dev_ops_v2,
+	.task_size = sizeof(struct rkvenc_task),
 };
 
 static const struct mpp_dev_var rkvenc_510_data = {
@@ -2430,6 +2450,7 @@ static const struct mpp_dev_var rkvenc_510_data = {
 	.trans_info = trans_rkvenc_540c,
 	.hw_ops = &rkvenc_hw_ops,
 	.dev_ops = &rkvenc_dev_ops_v2,
+	.task_size = sizeof(struct rkvenc_task),
 };
 
 static const struct mpp_dev_var rkvenc_ccu_data = {
@@ -2438,6 +2459,7 @@ static const struct mpp_dev_var rkvenc_ccu_data = {
 	.trans_info = trans_rkvenc_v2,
 	.hw_ops = &rkvenc_hw_ops,
 	.dev_ops = &rkvenc_ccu_dev_ops,
+	.task_size = sizeof(struct rkvenc_task),
 };
 
 static const struct mpp_dev_var rkvenc_rk3576_ccu_data = {
@@ -2446,6 +2468,7 @@ static const struct mpp_dev_var rkvenc_rk3576_ccu_data = {
 	.trans_info = trans_rkvenc_540c,
 	.hw_ops = &rkvenc_hw_ops,
 	.dev_ops = &rkvenc_ccu_dev_ops,
+	.task_size = sizeof(struct rkvenc_task),
 };
 
 static const struct of_device_id mpp_rkvenc_dt_match[] = {
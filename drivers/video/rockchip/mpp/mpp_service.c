@@ -222,6 +222,7 @@ static int mpp_dump_session(struct mpp_session *session, struct seq_file *s)
 	seq_printf(s, "session: pid=%d index=%d\n", session->pid, session->index);
 	seq_printf(s, " device: %s\n", dev_name(session->mpp->dev));
 	seq_printf(s, " memory: %lu MiB\n", K(K(t)));
+	mpp_show_task_stats(s, &session->stats);
 
 	return 0;
 }
@@ -278,6 +279,8 @@ static int mpp_show_support_cmd(struct seq_file *file, void *v)
 	seq_printf(file, "TRANS_FD_TO_IOVA:     0x%08x\n", MPP_CMD_TRANS_FD_TO_IOVA);
 	seq_printf(file, "RELEASE_FD:           0x%08x\n", MPP_CMD_RELEASE_FD);
 	seq_printf(file, "SEND_CODEC_INFO:      0x%08x\n", MPP_CMD_SEND_CODEC_INFO);
+	seq_printf(file, "SET_EVENTFD:          0x%08x\n", MPP_CMD_SET_EVENTFD);
+	seq_printf(file, "SET_SESSION_PRIO:     0x%08x\n", MPP_CMD_SET_SESSION_PRIO);
 	seq_printf(file, "CONTROL_BUTT:         0x%08x\n", MPP_CMD_CONTROL_BUTT);
 
 	return 0;
@@ -0,0 +1,59 @@
+/* SPDX-License-Identifier: (GPL-2.0+ OR MIT) */
+/*
+ * Copyright (c) 2024 Rockchip Electronics Co., Ltd
+ */
+
+#if !defined(_MPP_TRACE_H_) || defined(TRACE_HEADER_MULTI_READ)
+#define _MPP_TRACE_H_
+
+#include <linux/types.h>
+#include <linux/tracepoint.h>
+
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM mpp
+#define TRACE_INCLUDE_FILE mpp_trace
+
+TRACE_EVENT(mpp_task_done,
+	TP_PROTO(const char *dev_name, s32 core_id, u32 session, u32 task_id,
+		 u32 hw_cycles, s64 prepare_us, s64 wait_us, s64 run_us,
+		 bool timeout),
+	TP_ARGS(dev_name, core_id, session, task_id, hw_cycles, prepare_us,
+		wait_us, run_us, timeout),
+
+	TP_STRUCT__entry(
+		__string(dev_name, dev_name)
+		__field(s32, core_id)
+		__field(u32, session)
+		__field(u32, task_id)
+		__field(u32, hw_cycles)
+		__field(s64, prepare_us)
+		__field(s64, wait_us)
+		__field(s64, run_us)
+		__field(bool, timeout)
+	),
+
+	TP_fast_assign(
+		__assign_str(dev_name, dev_name);
+		__entry->core_id = core_id;
+		__entry->session = session;
+		__entry->task_id = task_id;
+		__entry->hw_cycles = hw_cycles;
+		__entry->prepare_us = prepare_us;
+		__entry->wait_us = wait_us;
+		__entry->run_us = run_us;
+		__entry->timeout = timeout;
+	),
+
+	TP_printk("%s:%d session %u task %u hw_cycles %u prepare %lld us wait %lld us run %lld us%s",
+		  __get_str(dev_name), __entry->core_id, __entry->session,
+		  __entry->task_id, __entry->hw_cycles, __entry->prepare_us,
+		  __entry->wait_us, __entry->run_us,
+		  __entry->timeout ? " timeout" : "")
+);
+
+#endif /* _MPP_TRACE_H_ */
+
+/* This part must be outside protection */
+#undef TRACE_INCLUDE_PATH
+#define TRACE_INCLUDE_PATH .
+#include <trace/define_trace.h>
@@ -40,6 +40,7 @@
 #endif
 
 #include "vehicle_flinger.h"
+#include "vehicle_main.h"
 #include "../../../gpu/drm/rockchip/rockchip_drm_direct_show.h"
 #include "../drivers/video/rockchip/rga3/include/rga_drv.h"
 
@@ -1111,6 +1112,7 @@ static int rk_flinger_vop_show(struct flinger *flinger,
 	}
 
 	rk_drm_vehicle_commit(flinger, buffer);
+	vehicle_boot_mark(VEHICLE_BOOT_FIRST_SHOW);
 
 	flinger->debug_vop_count++;
 	/* save vop show buffer */
@@ -1510,6 +1512,7 @@ void vehicle_flinger_commit_cif_buffer(u32 buf_phy_addr)
 	buffer = rk_flinger_lookup_buffer_by_phy_addr(buf_phy_addr);
 	if (buffer) {
 		buffer->timestamp = ktime_get();
+		vehicle_boot_mark(VEHICLE_BOOT_FIRST_FRAME);
 		atomic_inc(&flg->worker_cond_atomic);
 		flg->debug_cif_count++;
 		wake_up(&flg->worker_wait);
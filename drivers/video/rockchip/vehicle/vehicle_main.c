@@ -69,6 +69,49 @@ struct vehicle {
 
 static struct vehicle *g_vehicle;
 
+static const char * const vehicle_boot_stage_name[VEHICLE_BOOT_NR] = {
+	[VEHICLE_BOOT_START] = "start",
+	[VEHICLE_BOOT_GPIO] = "gpio",
+	[VEHICLE_BOOT_AD] = "ad",
+	[VEHICLE_BOOT_CIF] = "cif",
+	[VEHICLE_BOOT_FLINGER] = "flinger",
+	[VEHICLE_BOOT_STREAM_ON] = "stream_on",
+	[VEHICLE_BOOT_FIRST_FRAME] = "first_frame",
+	[VEHICLE_BOOT_FIRST_SHOW] = "first_show",
+};
+
+/* boot time of each stage in us, 0 until reached */
+static u64 vehicle_boot_us[VEHICLE_BOOT_NR];
+
+static void vehicle_boot_report(void)
+{
+	u64 last = 0;
+	int i;
+
+	VEHICLE_INFO("reverse camera boot time breakdown:\n");
+	for (i = 0; i < VEHICLE_BOOT_NR; i++) {
+		if (!vehicle_boot_us[i])
+			continue;
+		VEHICLE_INFO("  %-12s at %llu us (+%llu us)\n", vehicle_boot_stage_name[i],
+			     vehicle_boot_us[i], last ? vehicle_boot_us[i] - last : 0);
+		last = vehicle_boot_us[i];
+	}
+}
+
+/*
+ * Record the first time each stage is reached since boot, may be called from
+ * the cif irq. The breakdown is printed once the first frame is on screen.
+ */
+void vehicle_boot_mark(enum vehicle_boot_stage stage)
+{
+	if (stage >= VEHICLE_BOOT_NR || vehicle_boot_us[stage])
+		return;
+
+	vehicle_boot_us[stage] = div_u64(ktime_get_boottime_ns(), NSEC_PER_USEC);
+	if (stage == VEHICLE_BOOT_FIRST_SHOW)
+		vehicle_boot_report();
+}
+
 static int vehicle_parse_dt(struct vehicle *vehicle_info)
 {
 	struct device	*dev = vehicle_info->dev;
@@ -127,6 +170,7 @@ static void vehicle_open(struct vehicle_cfg *v_cfg)
 			__func__, g_vehicle->android_is_ready);
 	vehicle_flinger_reverse_open(v_cfg, g_vehicle->android_is_ready);
 	vehicle_cif_reverse_open(v_cfg);
+	vehicle_boot_mark(VEHICLE_BOOT_STREAM_ON);
 }
 
 static void vehicle_close(void)
@@ -168,6 +212,7 @@ static int vehicle_state_change(struct vehicle *v)
 	}
 	VEHICLE_DG("%s: flinger init success\r\n", __func__);
 	flinger_inited = true;
+	vehicle_boot_mark(VEHICLE_BOOT_FLINGER);
 
 	gpio_reverse_on = vehicle_gpio_reverse_check(gpiod);
 	gpio_reverse_on = TEST_GPIO & gpio_reverse_on;
@@ -415,6 +460,7 @@ static int rk_vehicle_system_main(void *arg)
 		VEHICLE_DGERR("vehicle probe failed, g_vehicle is NULL.\n");
 		goto VEHICLE_EXIT;
 	}
+	vehicle_boot_mark(VEHICLE_BOOT_START);
 
 	/*  0. gpio init and check state */
 	ret = vehicle_gpio_init(&v->gpio_data, v->ad.ad_name);
@@ -423,6 +469,7 @@ static int rk_vehicle_system_main(void *arg)
 		goto VEHICLE_GPIO_DEINIT;
 	}
 	VEHICLE_DG("vehicle_gpio_init ok!\n");
+	vehicle_boot_mark(VEHICLE_BOOT_GPIO);
 
 	/*  1.ad */
 	VEHICLE_DG("%s: vehicle_ad_init start\r\n", __func__);
@@ -434,6 +481,7 @@ static int rk_vehicle_system_main(void *arg)
 		goto VEHICLE_AD_DEINIT;
 	}
 	VEHICLE_DG("vehicle_ad_init ok!\r\n");
+	vehicle_boot_mark(VEHICLE_BOOT_AD);
 
 	/*  3. cif init */
 	ret = vehicle_cif_init(&v->cif);
@@ -442,6 +490,7 @@ static int rk_vehicle_system_main(void *arg)
 		goto VEHICLE_CIF_DEINIT;
 	}
 	VEHICLE_DG("%s: vehicle_cif_init ok!\r\n", __func__);
+	vehicle_boot_mark(VEHICLE_BOOT_CIF);
 	pm_runtime_enable(v->dev);
 	pm_runtime_get_sync(v->dev);
 
@@ -7,6 +7,19 @@
 #ifndef __VEHICLE_MAIN_H
 #define __VEHICLE_MAIN_H
 
+/* reverse camera bring up milestones, in boot order */
+enum vehicle_boot_stage {
+	VEHICLE_BOOT_START = 0,
+	VEHICLE_BOOT_GPIO,
+	VEHICLE_BOOT_AD,
+	VEHICLE_BOOT_CIF,
+	VEHICLE_BOOT_FLINGER,
+	VEHICLE_BOOT_STREAM_ON,
+	VEHICLE_BOOT_FIRST_FRAME,
+	VEHICLE_BOOT_FIRST_SHOW,
+	VEHICLE_BOOT_NR,
+};
+
 /* impl by vehicle_main, call by ad detect */
 void vehicle_ad_stat_change_notify(void);
 void vehicle_cif_stat_change_notify(void);
@@ -15,5 +28,6 @@ void vehicle_cif_error_notify(int last_line);
 void vehicle_android_is_ready_notify(void);
 void vehicle_apk_state_change(char crtc[22]);
 void vechile_module_exit(void);
+void vehicle_boot_mark(enum vehicle_boot_stage stage);
 
 #endif
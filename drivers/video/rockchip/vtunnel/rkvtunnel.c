@@ -0,0 +1,795 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Rockchip video tunnel
+ *
+ * Passes frames between a producer and a consumer process (camera ->
+ * encoder -> display) without unix socket round trips. The producer adds
+ * a fixed pool of dma-bufs to the tunnel, after which a frame costs one
+ * ioctl per side: dequeue/queue for the producer, acquire/release for the
+ * consumer, each optionally carrying a sync_file fence. At most depth
+ * frames are queued, a producer running ahead of its consumer waits or
+ * replaces the oldest frame.
+ *
+ * Copyright (c) 2023 Rockchip Electronics Co., Ltd.
+ */
+
+#include <linux/debugfs.h>
+#include <linux/dma-buf.h>
+#include <linux/dma-fence.h>
+#include <linux/file.h>
+#include <linux/fs.h>
+#include <linux/idr.h>
+#include <linux/kref.h>
+#include <linux/ktime.h>
+#include <linux/miscdevice.h>
+#include <linux/module.h>
+#include <linux/mutex.h>
+#include <linux/poll.h>
+#include <linux/seq_file.h>
+#include <linux/slab.h>
+#include <linux/sync_file.h>
+#include <linux/uaccess.h>
+#include <linux/wait.h>
+#include <uapi/linux/rk-vtunnel.h>
+
+#define RKVT_DEFAULT_DEPTH	2
+
+enum rkvt_buf_state {
+	RKVT_BUF_FREE,
+	RKVT_BUF_DEQUEUED,
+	RKVT_BUF_QUEUED,
+	RKVT_BUF_ACQUIRED,
+};
+
+struct rkvt_buf {
+	struct dma_buf *dmabuf;
+	enum rkvt_buf_state state;
+	/* release fence while free, acquire fence while queued */
+	struct dma_fence *fence;
+	struct list_head node;
+	ktime_t queued;
+	ktime_t acquired;
+};
+
+struct rkvt_tunnel {
+	int id;
+	struct kref ref;
+	/* file which allocated the id, the tunnel goes away with it */
+	struct file *owner;
+
+	struct mutex lock;
+	wait_queue_head_t wq;
+	bool dead;
+	bool has_producer;
+	bool has_consumer;
+	u32 depth;
+	u32 nr_bufs;
+	u32 nr_ready;
+	struct list_head free;
+	struct list_head ready;
+	struct rkvt_buf bufs[RKVT_MAX_BUFFERS];
+
+	/* statistics */
+	u64 frames;
+	u64 drops;
+	u64 stalls;
+	u64 acquired;
+	u64 released;
+	/* queue to acquire, acquire to release */
+	u64 wait_us_total;
+	u32 wait_us_max;
+	u64 hold_us_total;
+	u32 hold_us_max;
+};
+
+struct rkvt_session {
+	/* protects tunnel and role */
+	struct mutex lock;
+	struct rkvt_tunnel *tunnel;
+	u32 role;
+};
+
+static DEFINE_IDR(rkvt_idr);
+static DEFINE_MUTEX(rkvt_idr_lock);
+static struct dentry *rkvt_debugfs;
+
+static void rkvt_tunnel_release(struct kref *ref)
+{
+	struct rkvt_tunnel *t = container_of(ref, struct rkvt_tunnel, ref);
+	u32 i;
+
+	for (i = 0; i < t->nr_bufs; i++) {
+		dma_fence_put(t->bufs[i].fence);
+		dma_buf_put(t->bufs[i].dmabuf);
+	}
+	kfree(t);
+}
+
+static void rkvt_tunnel_put(struct rkvt_tunnel *t)
+{
+	kref_put(&t->ref, rkvt_tunnel_release);
+}
+
+/* Called with rkvt_idr_lock held */
+static void rkvt_tunnel_kill(struct rkvt_tunnel *t)
+{
+	idr_remove(&rkvt_idr, t->id);
+
+	mutex_lock(&t->lock);
+	t->dead = true;
+	mutex_unlock(&t->lock);
+	wake_up_all(&t->wq);
+
+	rkvt_tunnel_put(t);
+}
+
+/* Takes the reference of @fence, returns a sync_file fd or -1 */
+static int rkvt_fence_to_fd(struct dma_fence *fence)
+{
+	struct sync_file *sync_file;
+	int fd;
+
+	if (!fence)
+		return -1;
+
+	if (dma_fence_is_signaled(fence))
+		goto wait;
+
+	sync_file = sync_file_create(fence);
+	if (!sync_file)
+		goto wait;
+
+	fd = get_unused_fd_flags(O_CLOEXEC);
+	if (fd < 0) {
+		fput(sync_file->file);
+		goto wait;
+	}
+
+	fd_install(fd, sync_file->file);
+	dma_fence_put(fence);
+
+	return fd;
+
+wait:
+	/* no fd to hand out, resolve the dependency here */
+	dma_fence_wait(fence, false);
+	dma_fence_put(fence);
+
+	return -1;
+}
+
+static int rkvt_fd_to_fence(int fd, struct dma_fence **fence)
+{
+	*fence = NULL;
+	if (fd < 0)
+		return 0;
+
+	*fence = sync_file_get_fence(fd);
+
+	return *fence ? 0 : -EINVAL;
+}
+
+static bool rkvt_has_free(struct rkvt_tunnel *t)
+{
+	return !list_empty(&t->free);
+}
+
+static bool rkvt_has_space(struct rkvt_tunnel *t)
+{
+	return READ_ONCE(t->nr_ready) < t->depth;
+}
+
+static bool rkvt_has_ready(struct rkvt_tunnel *t)
+{
+	return !list_empty(&t->ready);
+}
+
+/* Called with t->lock held, which is dropped while sleeping */
+static int rkvt_wait(struct rkvt_tunnel *t, bool (*cond)(struct rkvt_tunnel *t),
+		     s32 timeout_ms)
+{
+	long timeout = timeout_ms < 0 ? MAX_SCHEDULE_TIMEOUT : msecs_to_jiffies(timeout_ms);
+	bool waited = false;
+	long ret;
+
+	while (!cond(t)) {
+		if (t->dead)
+			return -ENODEV;
+		if (!timeout)
+			return waited ? -ETIMEDOUT : -EAGAIN;
+
+		mutex_unlock(&t->lock);
+		ret = wait_event_interruptible_timeout(t->wq, cond(t) || READ_ONCE(t->dead),
+						       timeout);
+		mutex_lock(&t->lock);
+		if (ret < 0)
+			return ret;
+
+		timeout = ret;
+		waited = true;
+	}
+
+	return 0;
+}
+
+static struct rkvt_buf *rkvt_get_buf(struct rkvt_tunnel *t, u32 index,
+				     enum rkvt_buf_state state)
+{
+	if (index >= t->nr_bufs || t->bufs[index].state != state)
+		return NULL;
+
+	return &t->bufs[index];
+}
+
+static void rkvt_buf_free(struct rkvt_tunnel *t, struct rkvt_buf *buf,
+			  struct dma_fence *release_fence)
+{
+	dma_fence_put(buf->fence);
+	buf->fence = release_fence;
+	buf->state = RKVT_BUF_FREE;
+	list_add_tail(&buf->node, &t->free);
+}
+
+static struct rkvt_tunnel *rkvt_session_get(struct rkvt_session *session, u32 role)
+{
+	struct rkvt_tunnel *t;
+
+	mutex_lock(&session->lock);
+	t = session->tunnel;
+	if (t && (!role || session->role == role))
+		kref_get(&t->ref);
+	else
+		t = NULL;
+	mutex_unlock(&session->lock);
+
+	return t;
+}
+
+static int rkvt_alloc_id(struct file *file, void __user *argp)
+{
+	struct rkvt_alloc_data data;
+	struct rkvt_tunnel *t;
+	int id;
+
+	if (copy_from_user(&data, argp, sizeof(data)))
+		return -EFAULT;
+
+	if (data.depth > RKVT_MAX_BUFFERS)
+		return -EINVAL;
+
+	t = kzalloc(sizeof(*t), GFP_KERNEL);
+	if (!t)
+		return -ENOMEM;
+
+	kref_init(&t->ref);
+	mutex_init(&t->lock);
+	init_waitqueue_head(&t->wq);
+	INIT_LIST_HEAD(&t->free);
+	INIT_LIST_HEAD(&t->ready);
+	t->owner = file;
+	t->depth = data.depth ? data.depth : RKVT_DEFAULT_DEPTH;
+
+	mutex_lock(&rkvt_idr_lock);
+	id = idr_alloc(&rkvt_idr, t, 1, 0, GFP_KERNEL);
+	if (id < 0) {
+		mutex_unlock(&rkvt_idr_lock);
+		kfree(t);
+		return id;
+	}
+	t->id = id;
+	mutex_unlock(&rkvt_idr_lock);
+
+	data.tunnel_id = id;
+	if (copy_to_user(argp, &data, sizeof(data))) {
+		mutex_lock(&rkvt_idr_lock);
+		rkvt_tunnel_kill(t);
+		mutex_unlock(&rkvt_idr_lock);
+		return -EFAULT;
+	}
+
+	return 0;
+}
+
+static int rkvt_free_id(struct file *file, void __user *argp)
+{
+	struct rkvt_tunnel *t;
+	int id, ret = 0;
+
+	if (get_user(id, (s32 __user *)argp))
+		return -EFAULT;
+
+	mutex_lock(&rkvt_idr_lock);
+	t = idr_find(&rkvt_idr, id);
+	if (!t)
+		ret = -ENOENT;
+	else if (t->owner != file)
+		ret = -EPERM;
+	else
+		rkvt_tunnel_kill(t);
+	mutex_unlock(&rkvt_idr_lock);
+
+	return ret;
+}
+
+static int rkvt_connect(struct rkvt_session *session, void __user *argp)
+{
+	struct rkvt_connect_data data;
+	struct rkvt_tunnel *t;
+	bool *slot;
+	int ret = 0;
+
+	if (copy_from_user(&data, argp, sizeof(data)))
+		return -EFAULT;
+
+	if (data.role != RKVT_ROLE_PRODUCER && data.role != RKVT_ROLE_CONSUMER)
+		return -EINVAL;
+
+	mutex_lock(&rkvt_idr_lock);
+	t = idr_find(&rkvt_idr, data.tunnel_id);
+	if (t)
+		kref_get(&t->ref);
+	mutex_unlock(&rkvt_idr_lock);
+	if (!t)
+		return -ENOENT;
+
+	mutex_lock(&session->lock);
+	if (session->tunnel) {
+		ret = -EBUSY;
+		goto out;
+	}
+
+	mutex_lock(&t->lock);
+	slot = data.role == RKVT_ROLE_PRODUCER ? &t->has_producer : &t->has_consumer;
+	if (*slot || t->dead)
+		ret = -EBUSY;
+	else
+		*slot = true;
+	mutex_unlock(&t->lock);
+	if (ret)
+		goto out;
+
+	session->tunnel = t;
+	session->role = data.role;
+	t = NULL;
+out:
+	mutex_unlock(&session->lock);
+	if (t)
+		rkvt_tunnel_put(t);
+
+	return ret;
+}
+
+static void rkvt_disconnect(struct rkvt_session *session)
+{
+	enum rkvt_buf_state held;
+	struct rkvt_tunnel *t;
+	u32 i;
+
+	mutex_lock(&session->lock);
+	t = session->tunnel;
+	session->tunnel = NULL;
+	mutex_unlock(&session->lock);
+	if (!t)
+		return;
+
+	/* buffers the peer still holds go back to the pool */
+	mutex_lock(&t->lock);
+	if (session->role == RKVT_ROLE_PRODUCER) {
+		held = RKVT_BUF_DEQUEUED;
+		t->has_producer = false;
+	} else {
+		held = RKVT_BUF_ACQUIRED;
+		t->has_consumer = false;
+	}
+	for (i = 0; i < t->nr_bufs; i++) {
+		if (t->bufs[i].state == held)
+			rkvt_buf_free(t, &t->bufs[i], NULL);
+	}
+	mutex_unlock(&t->lock);
+	wake_up_all(&t->wq);
+
+	rkvt_tunnel_put(t);
+}
+
+static int rkvt_pool_add(struct rkvt_tunnel *t, void __user *argp)
+{
+	struct rkvt_pool_data data;
+	struct dma_buf *dmabuf;
+	struct rkvt_buf *buf;
+
+	if (copy_from_user(&data, argp, sizeof(data)))
+		return -EFAULT;
+
+	dmabuf = dma_buf_get(data.fd);
+	if (IS_ERR(dmabuf))
+		return PTR_ERR(dmabuf);
+
+	mutex_lock(&t->lock);
+	if (t->nr_bufs >= RKVT_MAX_BUFFERS) {
+		mutex_unlock(&t->lock);
+		dma_buf_put(dmabuf);
+		return -ENOSPC;
+	}
+	data.index = t->nr_bufs;
+	buf = &t->bufs[t->nr_bufs++];
+	buf->dmabuf = dmabuf;
+	rkvt_buf_free(t, buf, NULL);
+	mutex_unlock(&t->lock);
+	wake_up_all(&t->wq);
+
+	return copy_to_user(argp, &data, sizeof(data)) ? -EFAULT : 0;
+}
+
+static int rkvt_get_buffer(struct rkvt_tunnel *t, void __user *argp)
+{
+	struct rkvt_pool_data data;
+	struct dma_buf *dmabuf;
+
+	if (copy_from_user(&data, argp, sizeof(data)))
+		return -EFAULT;
+
+	mutex_lock(&t->lock);
+	if (data.index >= t->nr_bufs) {
+		mutex_unlock(&t->lock);
+		return -EINVAL;
+	}
+	dmabuf = t->bufs[data.index].dmabuf;
+	get_dma_buf(dmabuf);
+	mutex_unlock(&t->lock);
+
+	data.fd = dma_buf_fd(dmabuf, O_CLOEXEC);
+	if (data.fd < 0) {
+		dma_buf_put(dmabuf);
+		return data.fd;
+	}
+
+	return copy_to_user(argp, &data, sizeof(data)) ? -EFAULT : 0;
+}
+
+static int rkvt_dequeue(struct rkvt_tunnel *t, void __user *argp)
+{
+	struct rkvt_buf_data data;
+	struct dma_fence *fence;
+	struct rkvt_buf *buf;
+	int ret;
+
+	if (copy_from_user(&data, argp, sizeof(data)))
+		return -EFAULT;
+
+	mutex_lock(&t->lock);
+	if (!rkvt_has_free(t))
+		t->stalls++;
+	ret = rkvt_wait(t, rkvt_has_free, data.timeout_ms);
+	if (ret) {
+		mutex_unlock(&t->lock);
+		return ret;
+	}
+	buf = list_first_entry(&t->free, struct rkvt_buf, node);
+	list_del(&buf->node);
+	buf->state = RKVT_BUF_DEQUEUED;
+	fence = buf->fence;
+	buf->fence = NULL;
+	mutex_unlock(&t->lock);
+
+	data.index = buf - t->bufs;
+	data.fence_fd = rkvt_fence_to_fd(fence);
+
+	return copy_to_user(argp, &data, sizeof(data)) ? -EFAULT : 0;
+}
+
+static int rkvt_queue(struct rkvt_tunnel *t, void __user *argp)
+{
+	struct rkvt_buf_data data;
+	struct dma_fence *fence;
+	struct rkvt_buf *buf, *old;
+	int ret;
+
+	if (copy_from_user(&data, argp, sizeof(data)))
+		return -EFAULT;
+
+	ret = rkvt_fd_to_fence(data.fence_fd, &fence);
+	if (ret)
+		return ret;
+
+	mutex_lock(&t->lock);
+	buf = rkvt_get_buf(t, data.index, RKVT_BUF_DEQUEUED);
+	if (!buf) {
+		ret = -EINVAL;
+		goto err;
+	}
+
+	if (!rkvt_has_space(t)) {
+		if (data.flags & RKVT_QUEUE_DROP_OLDEST) {
+			/* never read, it is free once the producer is done with it */
+			old = list_first_entry(&t->ready, struct rkvt_buf, node);
+			list_del(&old->node);
+			t->nr_ready--;
+			t->drops++;
+			rkvt_buf_free(t, old, dma_fence_get(old->fence));
+		} else {
+			t->stalls++;
+			ret = rkvt_wait(t, rkvt_has_space, data.timeout_ms);
+			if (ret)
+				goto err;
+		}
+	}
+
+	buf->state = RKVT_BUF_QUEUED;
+	buf->fence = fence;
+	buf->queued = ktime_get();
+	list_add_tail(&buf->node, &t->ready);
+	t->nr_ready++;
+	t->frames++;
+	mutex_unlock(&t->lock);
+	wake_up_all(&t->wq);
+
+	return 0;
+
+err:
+	mutex_unlock(&t->lock);
+	dma_fence_put(fence);
+
+	return ret;
+}
+
+static int rkvt_acquire(struct rkvt_tunnel *t, void __user *argp)
+{
+	struct rkvt_buf_data data;
+	struct dma_fence *fence;
+	struct rkvt_buf *buf;
+	u32 wait_us;
+	int ret;
+
+	if (copy_from_user(&data, argp, sizeof(data)))
+		return -EFAULT;
+
+	mutex_lock(&t->lock);
+	ret = rkvt_wait(t, rkvt_has_ready, data.timeout_ms);
+	if (ret) {
+		mutex_unlock(&t->lock);
+		return ret;
+	}
+	buf = list_first_entry(&t->ready, struct rkvt_buf, node);
+	list_del(&buf->node);
+	t->nr_ready--;
+	buf->state = RKVT_BUF_ACQUIRED;
+	buf->acquired = ktime_get();
+	fence = buf->fence;
+	buf->fence = NULL;
+
+	wait_us = ktime_us_delta(buf->acquired, buf->queued);
+	t->acquired++;
+	t->wait_us_total += wait_us;
+	t->wait_us_max = max(t->wait_us_max, wait_us);
+	mutex_unlock(&t->lock);
+	wake_up_all(&t->wq);
+
+	data.index = buf - t->bufs;
+	data.fence_fd = rkvt_fence_to_fd(fence);
+
+	return copy_to_user(argp, &data, sizeof(data)) ? -EFAULT : 0;
+}
+
+static int rkvt_release_buf(struct rkvt_tunnel *t, void __user *argp)
+{
+	struct rkvt_buf_data data;
+	struct dma_fence *fence;
+	struct rkvt_buf *buf;
+	u32 hold_us;
+	int ret;
+
+	if (copy_from_user(&data, argp, sizeof(data)))
+		return -EFAULT;
+
+	ret = rkvt_fd_to_fence(data.fence_fd, &fence);
+	if (ret)
+		return ret;
+
+	mutex_lock(&t->lock);
+	buf = rkvt_get_buf(t, data.index, RKVT_BUF_ACQUIRED);
+	if (!buf) {
+		mutex_unlock(&t->lock);
+		dma_fence_put(fence);
+		return -EINVAL;
+	}
+
+	hold_us = ktime_us_delta(ktime_get(), buf->acquired);
+	t->hold_us_total += hold_us;
+	t->hold_us_max = max(t->hold_us_max, hold_us);
+	t->released++;
+	rkvt_buf_free(t, buf, fence);
+	mutex_unlock(&t->lock);
+	wake_up_all(&t->wq);
+
+	return 0;
+}
+
+static long rkvt_ioctl(struct file *file, unsigned int cmd, unsigned long arg)
+{
+	struct rkvt_session *session = file->private_data;
+	void __user *argp = (void __user *)arg;
+	struct rkvt_tunnel *t;
+	u32 role;
+	long ret;
+
+	switch (cmd) {
+	case RKVT_IOCTL_ALLOC_ID:
+		return rkvt_alloc_id(file, argp);
+	case RKVT_IOCTL_FREE_ID:
+		return rkvt_free_id(file, argp);
+	case RKVT_IOCTL_CONNECT:
+		return rkvt_connect(session, argp);
+	case RKVT_IOCTL_DISCONNECT:
+		rkvt_disconnect(session);
+		return 0;
+	case RKVT_IOCTL_GET_BUFFER:
+		role = 0;
+		break;
+	case RKVT_IOCTL_POOL_ADD:
+	case RKVT_IOCTL_DEQUEUE:
+	case RKVT_IOCTL_QUEUE:
+		role = RKVT_ROLE_PRODUCER;
+		break;
+	case RKVT_IOCTL_ACQUIRE:
+	case RKVT_IOCTL_RELEASE:
+		role = RKVT_ROLE_CONSUMER;
+		break;
+	default:
+		return -ENOTTY;
+	}
+
+	t = rkvt_session_get(session, role);
+	if (!t)
+		return -EPERM;
+
+	switch (cmd) {
+	case RKVT_IOCTL_GET_BUFFER:
+		ret = rkvt_get_buffer(t, argp);
+		break;
+	case RKVT_IOCTL_POOL_ADD:
+		ret = rkvt_pool_add(t, argp);
+		break;
+	case RKVT_IOCTL_DEQUEUE:
+		ret = rkvt_dequeue(t, argp);
+		break;
+	case RKVT_IOCTL_QUEUE:
+		ret = rkvt_queue(t, argp);
+		break;
+	case RKVT_IOCTL_ACQUIRE:
+		ret = rkvt_acquire(t, argp);
+		break;
+	default:
+		ret = rkvt_release_buf(t, argp);
+		break;
+	}
+	rkvt_tunnel_put(t);
+
+	return ret;
+}
+
+static __poll_t rkvt_poll(struct file *file, poll_table *wait)
+{
+	struct rkvt_session *session = file->private_data;
+	struct rkvt_tunnel *t;
+	__poll_t mask = 0;
+
+	t = rkvt_session_get(session, 0);
+	if (!t)
+		return EPOLLERR;
+
+	poll_wait(file, &t->wq, wait);
+
+	mutex_lock(&t->lock);
+	if (t->dead)
+		mask = EPOLLHUP;
+	else if (session->role == RKVT_ROLE_CONSUMER && rkvt_has_ready(t))
+		mask = EPOLLIN | EPOLLRDNORM;
+	else if (session->role == RKVT_ROLE_PRODUCER && rkvt_has_free(t) && rkvt_has_space(t))
+		mask = EPOLLOUT | EPOLLWRNORM;
+	mutex_unlock(&t->lock);
+
+	rkvt_tunnel_put(t);
+
+	return mask;
+}
+
+static int rkvt_open(struct inode *inode, struct file *file)
+{
+	struct rkvt_session *session;
+
+	session = kzalloc(sizeof(*session), GFP_KERNEL);
+	if (!session)
+		return -ENOMEM;
+
+	mutex_init(&session->lock);
+	file->private_data = session;
+
+	return nonseekable_open(inode, file);
+}
+
+static int rkvt_release(struct inode *inode, struct file *file)
+{
+	struct rkvt_session *session = file->private_data;
+	struct rkvt_tunnel *t;
+	int id;
+
+	rkvt_disconnect(session);
+
+	mutex_lock(&rkvt_idr_lock);
+	idr_for_each_entry(&rkvt_idr, t, id) {
+		if (t->owner == file)
+			rkvt_tunnel_kill(t);
+	}
+	mutex_unlock(&rkvt_idr_lock);
+
+	kfree(session);
+
+	return 0;
+}
+
+static const struct file_operations rkvt_fops = {
+	.owner = THIS_MODULE,
+	.open = rkvt_open,
+	.release = rkvt_release,
+	.unlocked_ioctl = rkvt_ioctl,
+	.compat_ioctl = compat_ptr_ioctl,
+	.poll = rkvt_poll,
+	.llseek = no_llseek,
+};
+
+static struct miscdevice rkvt_misc = {
+	.minor = MISC_DYNAMIC_MINOR,
+	.name = "rkvtunnel",
+	.fops = &rkvt_fops,
+};
+
+static int rkvt_stats_show(struct seq_file *s, void *unused)
+{
+	struct rkvt_tunnel *t;
+	int id;
+
+	mutex_lock(&rkvt_idr_lock);
+	idr_for_each_entry(&rkvt_idr, t, id) {
+		mutex_lock(&t->lock);
+		seq_printf(s, "tunnel %d: depth %u bufs %u ready %u producer %d consumer %d\n",
+			   id, t->depth, t->nr_bufs, t->nr_ready,
+			   t->has_producer, t->has_consumer);
+		seq_printf(s, "  frames %llu drops %llu stalls %llu\n",
+			   t->frames, t->drops, t->stalls);
+		seq_printf(s, "  queue->acquire us avg %llu max %u, acquire->release us avg %llu max %u\n",
+			   div64_u64(t->wait_us_total, max_t(u64, t->acquired, 1)),
+			   t->wait_us_max,
+			   div64_u64(t->hold_us_total, max_t(u64, t->released, 1)),
+			   t->hold_us_max);
+		mutex_unlock(&t->lock);
+	}
+	mutex_unlock(&rkvt_idr_lock);
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(rkvt_stats);
+
+static int __init rkvt_init(void)
+{
+	int ret;
+
+	ret = misc_register(&rkvt_misc);
+	if (ret)
+		return ret;
+
+	rkvt_debugfs = debugfs_create_dir("rkvtunnel", NULL);
+	debugfs_create_file("stats", 0444, rkvt_debugfs, NULL, &rkvt_stats_fops);
+
+	return 0;
+}
+module_init(rkvt_init);
+
+static void __exit rkvt_exit(void)
+{
+	debugfs_remove_recursive(rkvt_debugfs);
+	misc_deregister(&rkvt_misc);
+}
+module_exit(rkvt_exit);
+
+MODULE_LICENSE("GPL");
+MODULE_DESCRIPTION("Rockchip video tunnel");
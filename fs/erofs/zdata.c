@@ -351,9 +351,12 @@ static inline int z_erofs_init_workqueue(void)
 	/*
 	 * no need to spawn too many threads, limiting threads could minimum
 	 * scheduling overhead, perhaps per-CPU threads should be better?
+	 *
+	 * WQ_SYSFS exposes the cpumask so that platforms can keep async
+	 * decompression off latency-critical cores.
 	 */
 	z_erofs_workqueue = alloc_workqueue("erofs_unzipd",
-					    WQ_UNBOUND | WQ_HIGHPRI,
+					    WQ_UNBOUND | WQ_HIGHPRI | WQ_SYSFS,
 					    onlinecpus + onlinecpus / 4);
 	return z_erofs_workqueue ? 0 : -ENOMEM;
 }
@@ -266,11 +266,14 @@ void cpufreq_stats_create_table(struct cpufreq_policy *policy);
 void cpufreq_stats_free_table(struct cpufreq_policy *policy);
 void cpufreq_stats_record_transition(struct cpufreq_policy *policy,
 				     unsigned int new_freq);
+void cpufreq_stats_record_latency(struct cpufreq_policy *policy, u64 latency_ns);
 #else
 static inline void cpufreq_stats_create_table(struct cpufreq_policy *policy) { }
 static inline void cpufreq_stats_free_table(struct cpufreq_policy *policy) { }
 static inline void cpufreq_stats_record_transition(struct cpufreq_policy *policy,
 						   unsigned int new_freq) { }
+static inline void cpufreq_stats_record_latency(struct cpufreq_policy *policy,
+						u64 latency_ns) { }
 #endif /* CONFIG_CPU_FREQ_STAT */
 
 /*********************************************************************
@@ -1199,6 +1202,13 @@ static inline void sched_cpufreq_governor_change(struct cpufreq_policy *policy,
 			struct cpufreq_governor *old_gov) { }
 #endif
 
+#if IS_REACHABLE(CONFIG_CPU_FREQ_GOV_INTERACTIVE)
+void cpufreq_interactive_boost_cpu(unsigned int cpu, unsigned int duration_us);
+#else
+static inline void cpufreq_interactive_boost_cpu(unsigned int cpu,
+						 unsigned int duration_us) { }
+#endif
+
 extern unsigned int arch_freq_get_on_cpu(int cpu);
 
 #ifndef arch_set_freq_scale
@@ -287,6 +287,35 @@ struct dma_buf_ops {
 	void (*vunmap)(struct dma_buf *dmabuf, struct iosys_map *map);
 };
 
+#if IS_ENABLED(CONFIG_RK_DMABUF_DEBUG)
+/* Contiguous chunks are accounted by order, the last one holds larger ones */
+#define DMA_BUF_STATS_ORDERS	11
+
+/**
+ * struct dma_buf_owner_stats - dma-buf accounting of an exporter or process
+ * @node: entry in the exporter or process list, protected by db_list.lock
+ * @name: exporter name, or command of the process
+ * @tgid: process id, 0 for an exporter
+ * @size: current size of the dma-bufs
+ * @peak: peak of @size since the last dma_buf_reset_peak_size()
+ * @count: current number of dma-bufs
+ * @chunks: number of contiguous chunks per order, as reported by the
+ *          exporters through dma_buf_account_sgt()
+ *
+ * Maintained on export and release, so reading it does not depend on the
+ * number of dma-bufs.
+ */
+struct dma_buf_owner_stats {
+	struct list_head node;
+	char name[32];
+	pid_t tgid;
+	size_t size;
+	size_t peak;
+	unsigned long count;
+	unsigned long chunks[DMA_BUF_STATS_ORDERS];
+};
+#endif
+
 #ifdef CONFIG_DMABUF_CACHE
 /**
  * dma_buf_destructor - dma-buf destructor function
@@ -474,6 +503,11 @@ struct dma_buf {
 	void *dtor_data;
 	struct mutex cache_lock;
 #endif
+#if IS_ENABLED(CONFIG_RK_DMABUF_DEBUG)
+	struct dma_buf_owner_stats *exp_stats;
+	struct dma_buf_owner_stats *proc_stats;
+	unsigned int chunks[DMA_BUF_STATS_ORDERS];
+#endif
 };
 
 /**
@@ -680,10 +714,15 @@ static inline void dma_buf_set_destructor(struct dma_buf *dmabuf,
 void dma_buf_reset_peak_size(void);
 size_t dma_buf_get_peak_size(void);
 size_t dma_buf_get_total_size(void);
+void dma_buf_account_sgt(struct dma_buf *dmabuf, struct sg_table *sgt);
+int dma_buf_owner_stats_get_each(int (*callback)(const struct dma_buf_owner_stats *stats,
+						 void *private), void *private);
 #else
 static inline void dma_buf_reset_peak_size(void) {}
 static inline size_t dma_buf_get_peak_size(void) { return 0; }
 static inline size_t dma_buf_get_total_size(void) { return 0; }
+static inline void dma_buf_account_sgt(struct dma_buf *dmabuf,
+				       struct sg_table *sgt) {}
 #endif
 
 #endif /* __DMA_BUF_H__ */
@@ -647,6 +647,8 @@ struct regulator_dev {
 
 	/* time when this regulator was disabled last time */
 	ktime_t last_off;
+	/* ramp wait skipped for the voltage change in progress */
+	unsigned int ramp_overlap_us;
 	int cached_err;
 	bool use_cached_err;
 	spinlock_t err_lock;
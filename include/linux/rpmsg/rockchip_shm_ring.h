@@ -0,0 +1,101 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/*
+ * Copyright (c) 2023 Rockchip Electronics Co., Ltd.
+ */
+#ifndef ROCKCHIP_SHM_RING_H
+#define ROCKCHIP_SHM_RING_H
+
+#include <linux/err.h>
+#include <linux/types.h>
+
+/*
+ * Shared memory layout, must match the remote (RTOS) side.
+ *
+ * The region holds two single producer single consumer rings, first the
+ * one the remote writes (rx for Linux), then the one Linux writes (tx).
+ * Each ring is a control block followed by slot_num slots of slot_size
+ * bytes. Producer and consumer fields sit in separate cache lines so each
+ * side only ever writes its own line.
+ *
+ * head and tail are free running slot counters. The consumer sets wait to
+ * a new non zero value each time it goes to sleep and to 0 once it runs;
+ * the producer only rings the doorbell for a wait value it has not kicked
+ * yet, so a busy consumer takes no interrupts at all.
+ */
+#define RK_SHM_RING_MAGIC			(0x524B5247U)
+#define RK_SHM_RING_CACHELINE			(64U)
+
+#define RK_SHM_RING_SLOT_SIZE			(256U)
+#define RK_SHM_RING_SLOT_NUM			(64U)
+
+struct rk_shm_ring_ctrl {
+	/* written by the producer */
+	u32 magic;
+	u32 slot_size;
+	u32 slot_num;
+	u32 head;
+	u8 reserved0[RK_SHM_RING_CACHELINE - 16];
+	/* written by the consumer */
+	u32 tail;
+	u32 wait;
+	u8 reserved1[RK_SHM_RING_CACHELINE - 8];
+};
+
+struct rk_shm_ring_slot {
+	u32 len;
+	u32 reserved;
+	u8 data[];
+};
+
+#define RK_SHM_RING_SLOT_PAYLOAD(slot_size)	((slot_size) - sizeof(struct rk_shm_ring_slot))
+#define RK_SHM_RING_SIZE(slot_size, slot_num)	\
+	(sizeof(struct rk_shm_ring_ctrl) + (slot_size) * (slot_num))
+
+struct device;
+struct rk_shm_ring;
+
+typedef void (*rk_shm_ring_rx_cb_t)(void *priv, const void *data, u32 len);
+
+#if IS_REACHABLE(CONFIG_RPMSG_ROCKCHIP_SHM_RING)
+
+struct rk_shm_ring *rk_shm_ring_get(struct device *dev);
+void rk_shm_ring_put(struct rk_shm_ring *ring);
+int rk_shm_ring_set_rx_cb(struct rk_shm_ring *ring, rk_shm_ring_rx_cb_t cb, void *priv);
+void *rk_shm_ring_tx_reserve(struct rk_shm_ring *ring, u32 *max_len);
+void rk_shm_ring_tx_commit(struct rk_shm_ring *ring, u32 len);
+int rk_shm_ring_send(struct rk_shm_ring *ring, const void *data, u32 len);
+
+#else
+
+static inline struct rk_shm_ring *rk_shm_ring_get(struct device *dev)
+{
+	return ERR_PTR(-ENODEV);
+}
+
+static inline void rk_shm_ring_put(struct rk_shm_ring *ring)
+{
+}
+
+static inline int rk_shm_ring_set_rx_cb(struct rk_shm_ring *ring,
+					rk_shm_ring_rx_cb_t cb, void *priv)
+{
+	return -ENODEV;
+}
+
+static inline void *rk_shm_ring_tx_reserve(struct rk_shm_ring *ring, u32 *max_len)
+{
+	return NULL;
+}
+
+static inline void rk_shm_ring_tx_commit(struct rk_shm_ring *ring, u32 len)
+{
+}
+
+static inline int rk_shm_ring_send(struct rk_shm_ring *ring, const void *data, u32 len)
+{
+	return -ENODEV;
+}
+
+#endif
+
+#endif /* ROCKCHIP_SHM_RING_H */
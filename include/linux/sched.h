@@ -813,6 +813,11 @@ struct task_struct {
 	struct uclamp_se		uclamp[UCLAMP_CNT];
 #endif
 
+#ifdef CONFIG_ROCKCHIP_PERFORMANCE
+	/* latency class, see drivers/soc/rockchip/rockchip_performance.c */
+	int				rk_perf_class;
+#endif
+
 	struct sched_statistics         stats;
 
 #ifdef CONFIG_PREEMPT_NOTIFIERS
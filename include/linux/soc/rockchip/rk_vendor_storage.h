@@ -28,6 +28,8 @@
 #define IMEI_ID				15
 #define LAN_RGMII_DL_ID			16
 #define EINK_VCOM_ID			17
+#define OPP_SEL_CACHE_ID		18
+#define MMC_TUNING_CACHE_ID		19
 
 #define VENDOR_HEAD_TAG			0x524B5644
 #define FLASH_VENDOR_PART_SIZE		8
@@ -69,7 +71,10 @@ struct flash_vendor_info {
 #if IS_REACHABLE(CONFIG_ROCKCHIP_VENDOR_STORAGE)
 int rk_vendor_read(u32 id, void *pbuf, u32 size);
 int rk_vendor_write(u32 id, void *pbuf, u32 size);
+int rk_vendor_write_buffered(u32 id, void *pbuf, u32 size);
+int rk_vendor_flush(void);
 int rk_vendor_register(void *read, void *write);
+int rk_vendor_register_writeback(void *update, void *commit);
 bool is_rk_vendor_ready(void);
 #else
 static inline int rk_vendor_read(u32 id, void *pbuf, u32 size)
@@ -82,11 +87,26 @@ static inline int rk_vendor_write(u32 id, void *pbuf, u32 size)
 	return -1;
 }
 
+static inline int rk_vendor_write_buffered(u32 id, void *pbuf, u32 size)
+{
+	return -1;
+}
+
+static inline int rk_vendor_flush(void)
+{
+	return 0;
+}
+
 static inline int rk_vendor_register(void *read, void *write)
 {
 	return -1;
 }
 
+static inline int rk_vendor_register_writeback(void *update, void *commit)
+{
+	return -1;
+}
+
 static inline bool is_rk_vendor_ready(void)
 {
 	return false;
@@ -0,0 +1,27 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/* Copyright (c) 2023 Rockchip Electronics Co., Ltd */
+
+#ifndef _ROCKCHIP_THUNDERBOOT_PRELOAD_H
+#define _ROCKCHIP_THUNDERBOOT_PRELOAD_H
+
+#include <linux/ioport.h>
+
+struct device_node;
+
+#ifdef CONFIG_ROCKCHIP_THUNDER_BOOT_PRELOAD
+void rk_tb_preload_complete(struct device_node *np, int err);
+/* timeout in jiffies */
+int rk_tb_preload_get(const char *name, struct resource *res, unsigned long timeout);
+#else
+static inline void rk_tb_preload_complete(struct device_node *np, int err)
+{
+}
+
+static inline int rk_tb_preload_get(const char *name, struct resource *res,
+				    unsigned long timeout)
+{
+	return -ENODEV;
+}
+#endif
+
+#endif
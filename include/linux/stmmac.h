@@ -133,6 +133,7 @@ struct stmmac_rxq_cfg {
 	u8 pkt_route;
 	bool use_prio;
 	u32 prio;
+	bool low_latency;
 };
 
 struct stmmac_txq_cfg {
@@ -146,6 +147,7 @@ struct stmmac_txq_cfg {
 	bool use_prio;
 	u32 prio;
 	int tbs_en;
+	bool low_latency;
 };
 
 /* FPE link state */
@@ -7,9 +7,19 @@
 #define __SOC_ROCKCHIP_PM_DOMAINS_H__
 
 #include <linux/errno.h>
+#include <linux/types.h>
 
 struct device;
 
+/* per AXI master port qos registers, see rockchip_pmu_set_qos() */
+enum rockchip_pmu_qos_reg {
+	ROCKCHIP_QOS_PRIORITY,
+	ROCKCHIP_QOS_MODE,
+	ROCKCHIP_QOS_BANDWIDTH,
+	ROCKCHIP_QOS_SATURATION,
+	ROCKCHIP_QOS_EXTCONTROL,
+};
+
 #if IS_REACHABLE(CONFIG_ROCKCHIP_PM_DOMAINS)
 
 int rockchip_pmu_block(void);
@@ -20,6 +30,8 @@ bool rockchip_pmu_pd_is_on(struct device *dev);
 int rockchip_pmu_idle_request(struct device *dev, bool idle);
 int rockchip_save_qos(struct device *dev);
 int rockchip_restore_qos(struct device *dev);
+int rockchip_pmu_set_qos(struct device *dev, enum rockchip_pmu_qos_reg reg,
+			 u32 val);
 void rockchip_dump_pmu(void);
 
 #else /* CONFIG_ROCKCHIP_PM_DOMAINS */
@@ -61,6 +73,12 @@ static inline int rockchip_restore_qos(struct device *dev)
 	return -ENOTSUPP;
 }
 
+static inline int rockchip_pmu_set_qos(struct device *dev,
+				       enum rockchip_pmu_qos_reg reg, u32 val)
+{
+	return -ENOTSUPP;
+}
+
 static inline void rockchip_dump_pmu(void)
 {
 }
@@ -7,6 +7,52 @@
 #define __SOC_ROCKCHIP_SYSTEM_STATUS_H
 
 #include <dt-bindings/soc/rockchip-system-status.h>
+#include <linux/string.h>
+#include <linux/types.h>
+
+#define ROCKCHIP_VIDEO_CODEC_OTHER	0
+#define ROCKCHIP_VIDEO_CODEC_H264	1
+#define ROCKCHIP_VIDEO_CODEC_HEVC	2
+#define ROCKCHIP_VIDEO_CODEC_VP9	3
+#define ROCKCHIP_VIDEO_CODEC_AV1	4
+
+/**
+ * struct rockchip_video_stream - a video decode hint
+ * @codec:	ROCKCHIP_VIDEO_CODEC_*
+ * @width:	Frame width in pixels
+ * @height:	Frame height in pixels
+ * @fps:	Frame rate, 0 if unknown
+ * @bit_depth:	8 or 10
+ * @hdr:	HDR content
+ * @count:	Number of identical streams
+ */
+struct rockchip_video_stream {
+	unsigned int codec;
+	unsigned int width;
+	unsigned int height;
+	unsigned int fps;
+	unsigned int bit_depth;
+	bool hdr;
+	unsigned int count;
+};
+
+/**
+ * struct rockchip_video_load - the sum of all registered video streams
+ * @streams:		Number of streams
+ * @pixel_rate:		Decoded pixels per second of the 8 bit streams
+ * @pixel_rate_10bit:	Decoded pixels per second of the 10 bit streams
+ * @max_pixels:		Largest frame size in pixels
+ * @max_fps:		Highest frame rate
+ * @hdr:		At least one stream is HDR
+ */
+struct rockchip_video_load {
+	unsigned int streams;
+	u64 pixel_rate;
+	u64 pixel_rate_10bit;
+	unsigned int max_pixels;
+	unsigned int max_fps;
+	bool hdr;
+};
 
 #if IS_REACHABLE(CONFIG_ROCKCHIP_SYSTEM_MONITOR)
 int rockchip_register_system_status_notifier(struct notifier_block *nb);
@@ -16,6 +62,11 @@ void rockchip_clear_system_status(unsigned long status);
 unsigned long rockchip_get_system_status(void);
 int rockchip_add_system_status_interface(struct device *dev);
 void rockchip_update_system_status(const char *buf);
+int rockchip_add_video_stream(const struct rockchip_video_stream *stream);
+void rockchip_del_video_stream(const struct rockchip_video_stream *stream);
+void rockchip_get_video_load(struct rockchip_video_load *load);
+int rockchip_register_video_load_notifier(struct notifier_block *nb);
+int rockchip_unregister_video_load_notifier(struct notifier_block *nb);
 #else
 static inline int
 rockchip_register_system_status_notifier(struct notifier_block *nb)
@@ -50,6 +101,34 @@ static inline int rockchip_add_system_status_interface(struct device *dev)
 static inline void rockchip_update_system_status(const char *buf)
 {
 };
+
+static inline int
+rockchip_add_video_stream(const struct rockchip_video_stream *stream)
+{
+	return -ENOTSUPP;
+};
+
+static inline void
+rockchip_del_video_stream(const struct rockchip_video_stream *stream)
+{
+};
+
+static inline void rockchip_get_video_load(struct rockchip_video_load *load)
+{
+	memset(load, 0, sizeof(*load));
+};
+
+static inline int
+rockchip_register_video_load_notifier(struct notifier_block *nb)
+{
+	return -ENOTSUPP;
+};
+
+static inline int
+rockchip_unregister_video_load_notifier(struct notifier_block *nb)
+{
+	return -ENOTSUPP;
+};
 #endif /* CONFIG_ROCKCHIP_SYSTEM_MONITOR */
 
 #endif
@@ -14,6 +14,7 @@
 #define __SOC_ROCKCHIP_DMC_H
 
 #include <linux/devfreq.h>
+#include <linux/list.h>
 
 /* for lcdc_type */
 #define SCREEN_NULL		0
@@ -53,6 +54,10 @@ struct dmcfreq_common_info {
 	struct delayed_work msch_rl_work;
 	unsigned long vop_4k_rate;
 	unsigned long vop_req_rate;
+	unsigned long bw_req_rate;
+	unsigned int bw_bus_bytes;
+	unsigned int bw_util;
+	unsigned int bw_headroom;
 	unsigned int read_latency;
 	unsigned int auto_freq_en;
 	unsigned int stall_time_ns;
@@ -67,6 +72,18 @@ struct dmcfreq_vop_info {
 	unsigned int plane_num_4k;
 };
 
+struct dmcfreq_bw_req {
+	struct list_head node;
+	const char *name;
+	unsigned int mbyte; /* expected ddr bandwidth in MB/s */
+};
+
+struct dmcfreq_load {
+	unsigned long status; /* system status when sampled */
+	unsigned long busy_time;
+	unsigned long total_time;
+};
+
 #if IS_REACHABLE(CONFIG_ARM_ROCKCHIP_DMC_DEVFREQ)
 void rockchip_dmcfreq_lock(void);
 void rockchip_dmcfreq_lock_nested(void);
@@ -78,6 +95,15 @@ int rockchip_dmcfreq_vop_bandwidth_init(struct dmcfreq_common_info *info);
 int rockchip_dmcfreq_vop_bandwidth_request(struct dmcfreq_vop_info *vop_info);
 void rockchip_dmcfreq_vop_bandwidth_update(struct dmcfreq_vop_info *vop_info);
 unsigned int rockchip_dmcfreq_get_stall_time_ns(void);
+void rockchip_dmcfreq_bw_req_add(struct dmcfreq_bw_req *req, const char *name);
+void rockchip_dmcfreq_bw_req_update(struct dmcfreq_bw_req *req,
+				    unsigned int mbyte);
+void rockchip_dmcfreq_bw_req_remove(struct dmcfreq_bw_req *req);
+int rockchip_dmcfreq_bw_register_notifier(struct notifier_block *nb);
+int rockchip_dmcfreq_bw_unregister_notifier(struct notifier_block *nb);
+void rockchip_dmcfreq_load_notify(struct dmcfreq_load *load);
+int rockchip_dmcfreq_load_register_notifier(struct notifier_block *nb);
+int rockchip_dmcfreq_load_unregister_notifier(struct notifier_block *nb);
 #else
 static inline void rockchip_dmcfreq_lock(void)
 {
@@ -126,6 +152,48 @@ rockchip_dmcfreq_get_stall_time_ns(void)
 {
 	return 0;
 }
+
+static inline void
+rockchip_dmcfreq_bw_req_add(struct dmcfreq_bw_req *req, const char *name)
+{
+}
+
+static inline void
+rockchip_dmcfreq_bw_req_update(struct dmcfreq_bw_req *req, unsigned int mbyte)
+{
+}
+
+static inline void rockchip_dmcfreq_bw_req_remove(struct dmcfreq_bw_req *req)
+{
+}
+
+static inline int
+rockchip_dmcfreq_bw_register_notifier(struct notifier_block *nb)
+{
+	return -EOPNOTSUPP;
+}
+
+static inline int
+rockchip_dmcfreq_bw_unregister_notifier(struct notifier_block *nb)
+{
+	return 0;
+}
+
+static inline void rockchip_dmcfreq_load_notify(struct dmcfreq_load *load)
+{
+}
+
+static inline int
+rockchip_dmcfreq_load_register_notifier(struct notifier_block *nb)
+{
+	return -EOPNOTSUPP;
+}
+
+static inline int
+rockchip_dmcfreq_load_unregister_notifier(struct notifier_block *nb)
+{
+	return 0;
+}
 #endif
 
 #endif
@@ -0,0 +1,61 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/*
+ * Copyright (c) 2023 Rockchip Electronics Co., Ltd.
+ */
+
+#ifndef __SOC_ROCKCHIP_FLIGHT_RECORDER_H
+#define __SOC_ROCKCHIP_FLIGHT_RECORDER_H
+
+#include <linux/jump_label.h>
+#include <linux/types.h>
+
+enum rk_fr_src {
+	RK_FR_SRC_VOP2,
+	RK_FR_SRC_MPP,
+	RK_FR_SRC_RKNPU,
+	RK_FR_SRC_RGA,
+	RK_FR_SRC_ISP,
+	RK_FR_SRC_NR,
+};
+
+enum rk_fr_event {
+	RK_FR_EV_SUBMIT,
+	RK_FR_EV_START,
+	RK_FR_EV_IRQ,
+	RK_FR_EV_DONE,
+	RK_FR_EV_TIMEOUT,
+	RK_FR_EV_RESET,
+	RK_FR_EV_NR,
+};
+
+/*
+ * One record of the ring, also the layout found in minidumps.
+ * @id tells hardware instances of a source apart (core, video port),
+ * @arg is up to the source, usually a job id or an irq status.
+ */
+struct rk_fr_entry {
+	u64 ts_ns;
+	u8 src;
+	u8 event;
+	u16 id;
+	u32 arg;
+};
+
+#ifdef CONFIG_ROCKCHIP_FLIGHT_RECORDER
+DECLARE_STATIC_KEY_FALSE(rk_fr_enabled);
+
+void __rk_fr_log(u8 src, u8 event, u16 id, u32 arg);
+
+/* Safe from any context, costs a patched out branch while disabled */
+static inline void rk_fr_log(u8 src, u8 event, u16 id, u32 arg)
+{
+	if (static_branch_unlikely(&rk_fr_enabled))
+		__rk_fr_log(src, event, id, arg);
+}
+#else
+static inline void rk_fr_log(u8 src, u8 event, u16 id, u32 arg)
+{
+}
+#endif
+
+#endif /* __SOC_ROCKCHIP_FLIGHT_RECORDER_H */
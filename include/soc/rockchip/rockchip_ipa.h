@@ -22,6 +22,7 @@ struct ipa_power_model_data *rockchip_ipa_power_model_init(struct device *dev,
 unsigned long
 rockchip_ipa_get_static_power(struct ipa_power_model_data *model_data,
 			      unsigned long voltage_mv);
+int rockchip_ipa_register_em(struct device *dev, struct cpumask *cpus);
 #else
 static inline struct ipa_power_model_data *
 rockchip_ipa_power_model_init(struct device *dev, char *lkg_name)
@@ -35,6 +36,12 @@ rockchip_ipa_get_static_power(struct ipa_power_model_data *data,
 {
 	return 0;
 }
+
+static inline int rockchip_ipa_register_em(struct device *dev,
+					   struct cpumask *cpus)
+{
+	return -ENOTSUPP;
+}
 #endif /* CONFIG_ROCKCHIP_IPA */
 
 #endif
@@ -0,0 +1,79 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/*
+ * Copyright (c) 2023 Rockchip Electronics Co., Ltd.
+ */
+
+#ifndef __SOC_ROCKCHIP_MEDIA_PIPELINE_H
+#define __SOC_ROCKCHIP_MEDIA_PIPELINE_H
+
+#include <linux/err.h>
+#include <linux/types.h>
+
+struct dma_fence;
+struct rk_mpipe;
+struct rk_mpipe_frame;
+
+/*
+ * One stage of a frame, e.g. an RGA blit or an RKNPU job.
+ *
+ * @submit is called from a workqueue once the previous stage is done (the
+ * frame's in-fence for stage 0). It queues the job to the hardware and
+ * returns the fence signalled on completion, NULL if the job already
+ * completed, or an ERR_PTR. @cancel, if set, releases @data of a stage
+ * which never got submitted because an earlier stage failed.
+ */
+struct rk_mpipe_stage_ops {
+	struct dma_fence *(*submit)(void *data);
+	void (*cancel)(void *data);
+};
+
+#if IS_REACHABLE(CONFIG_ROCKCHIP_MEDIA_PIPELINE)
+
+struct rk_mpipe *rk_mpipe_create(const char *name, unsigned int nr_stages);
+void rk_mpipe_destroy(struct rk_mpipe *pipe);
+
+struct rk_mpipe_frame *rk_mpipe_frame_create(struct rk_mpipe *pipe, u32 id,
+					     struct dma_fence *in_fence);
+int rk_mpipe_frame_set_stage(struct rk_mpipe_frame *frame, unsigned int stage,
+			     const struct rk_mpipe_stage_ops *ops, void *data);
+int rk_mpipe_frame_commit(struct rk_mpipe_frame *frame);
+void rk_mpipe_frame_abort(struct rk_mpipe_frame *frame);
+
+#else
+
+static inline struct rk_mpipe *rk_mpipe_create(const char *name,
+					       unsigned int nr_stages)
+{
+	return ERR_PTR(-ENODEV);
+}
+
+static inline void rk_mpipe_destroy(struct rk_mpipe *pipe)
+{
+}
+
+static inline struct rk_mpipe_frame *
+rk_mpipe_frame_create(struct rk_mpipe *pipe, u32 id, struct dma_fence *in_fence)
+{
+	return ERR_PTR(-ENODEV);
+}
+
+static inline int rk_mpipe_frame_set_stage(struct rk_mpipe_frame *frame,
+					   unsigned int stage,
+					   const struct rk_mpipe_stage_ops *ops,
+					   void *data)
+{
+	return -ENODEV;
+}
+
+static inline int rk_mpipe_frame_commit(struct rk_mpipe_frame *frame)
+{
+	return -ENODEV;
+}
+
+static inline void rk_mpipe_frame_abort(struct rk_mpipe_frame *frame)
+{
+}
+
+#endif
+
+#endif /* __SOC_ROCKCHIP_MEDIA_PIPELINE_H */
@@ -122,6 +122,8 @@ struct rockchip_opp_info {
 	u32 current_rm;
 	u32 target_rm;
 	bool is_runtime_active;
+	bool is_fast_dvfs;
+	u32 pll_lock_us;
 
 	int opp_token;
 	int scale;
@@ -11,6 +11,11 @@ enum {
 	ROCKCHIP_PERFORMANCE_HIGH
 };
 
+#define ROCKCHIP_PERF_CLASS_DEFAULT	0
+#define ROCKCHIP_PERF_CLASS_NUM		8
+
+struct task_struct;
+
 #ifdef CONFIG_ROCKCHIP_PERFORMANCE
 extern int rockchip_perf_get_level(void);
 extern struct cpumask *rockchip_perf_get_cpul_mask(void);
@@ -18,6 +23,8 @@ extern struct cpumask *rockchip_perf_get_cpub_mask(void);
 extern int rockchip_perf_select_rt_cpu(int prev_cpu, struct cpumask *lowest_mask);
 extern bool rockchip_perf_misfit_rt(int cpu);
 extern void rockchip_perf_uclamp_sync_util_min_rt_default(void);
+extern int rockchip_perf_set_task_class(struct task_struct *p, int class);
+extern bool rockchip_perf_misfit_task(struct task_struct *p, int cpu);
 #else
 static inline int rockchip_perf_get_level(void) { return ROCKCHIP_PERFORMANCE_NORMAL; }
 static inline struct cpumask *rockchip_perf_get_cpul_mask(void) { return NULL; };
@@ -28,6 +35,14 @@ static inline int rockchip_perf_select_rt_cpu(int prev_cpu, struct cpumask *lowe
 }
 static inline bool rockchip_perf_misfit_rt(int cpu) { return false; }
 static inline void rockchip_perf_uclamp_sync_util_min_rt_default(void) {}
+static inline int rockchip_perf_set_task_class(struct task_struct *p, int class)
+{
+	return -EOPNOTSUPP;
+}
+static inline bool rockchip_perf_misfit_task(struct task_struct *p, int cpu)
+{
+	return false;
+}
 #endif
 
 #endif
@@ -104,12 +104,16 @@ struct monitor_dev_info {
 	struct freq_qos_request min_sta_freq_req;
 	struct freq_qos_request max_sta_freq_req;
 	struct dev_pm_qos_request dev_max_freq_req;
+	struct freq_qos_request max_budget_freq_req;
+	struct dev_pm_qos_request dev_max_budget_freq_req;
 	struct regulator *early_reg;
 	unsigned long low_limit;
 	unsigned long high_limit;
 	unsigned long max_volt;
 	unsigned long low_temp_min_volt;
 	unsigned long high_temp_max_volt;
+	unsigned long budget_min_freq; /* kHz */
+	unsigned long budget_max_freq; /* kHz */
 	unsigned int video_4k_freq;
 	unsigned int reboot_freq;
 	unsigned int status_min_limit;
@@ -150,6 +154,11 @@ int rockchip_monitor_dev_high_temp_adjust(struct monitor_dev_info *info,
 int rockchip_monitor_suspend_low_temp_adjust(int cpu);
 int rockchip_system_monitor_register_notifier(struct notifier_block *nb);
 void rockchip_system_monitor_unregister_notifier(struct notifier_block *nb);
+void rockchip_system_monitor_power_hint(struct device *dev,
+					unsigned int power_mw,
+					unsigned int duration_ms);
+void rockchip_system_monitor_vsync(ktime_t timestamp, u32 period_ns);
+bool rockchip_system_monitor_get_vsync(ktime_t *last, u32 *period_ns);
 #else
 static inline struct monitor_dev_info *
 rockchip_system_monitor_register(struct device *dev,
@@ -210,6 +219,23 @@ static inline void
 rockchip_system_monitor_unregister_notifier(struct notifier_block *nb)
 {
 };
+
+static inline void
+rockchip_system_monitor_power_hint(struct device *dev, unsigned int power_mw,
+				   unsigned int duration_ms)
+{
+};
+
+static inline void
+rockchip_system_monitor_vsync(ktime_t timestamp, u32 period_ns)
+{
+};
+
+static inline bool
+rockchip_system_monitor_get_vsync(ktime_t *last, u32 *period_ns)
+{
+	return false;
+};
 #endif /* CONFIG_ROCKCHIP_SYSTEM_MONITOR */
 
 #ifdef CONFIG_ROCKCHIP_EARLYSUSPEND
@@ -0,0 +1,56 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM rockchip_system_monitor
+
+#if !defined(_TRACE_ROCKCHIP_SYSTEM_MONITOR_H) || defined(TRACE_HEADER_MULTI_READ)
+#define _TRACE_ROCKCHIP_SYSTEM_MONITOR_H
+
+#include <linux/tracepoint.h>
+
+TRACE_EVENT(rockchip_thermal_budget,
+	TP_PROTO(int temp, int err, s64 integral, s64 deriv,
+		 unsigned int budget),
+	TP_ARGS(temp, err, integral, deriv, budget),
+
+	TP_STRUCT__entry(
+		__field(int, temp)
+		__field(int, err)
+		__field(s64, integral)
+		__field(s64, deriv)
+		__field(unsigned int, budget)
+	),
+
+	TP_fast_assign(
+		__entry->temp = temp;
+		__entry->err = err;
+		__entry->integral = integral;
+		__entry->deriv = deriv;
+		__entry->budget = budget;
+	),
+
+	TP_printk("temp=%d err=%d integral=%lld deriv=%lld budget=%u",
+		  __entry->temp, __entry->err, __entry->integral,
+		  __entry->deriv, __entry->budget)
+);
+
+TRACE_EVENT(rockchip_thermal_budget_cap,
+	TP_PROTO(const char *name, unsigned long freq),
+	TP_ARGS(name, freq),
+
+	TP_STRUCT__entry(
+		__string(name, name)
+		__field(unsigned long, freq)
+	),
+
+	TP_fast_assign(
+		__assign_str(name, name);
+		__entry->freq = freq;
+	),
+
+	TP_printk("dev=%s freq=%lu", __get_str(name), __entry->freq)
+);
+
+#endif /* _TRACE_ROCKCHIP_SYSTEM_MONITOR_H */
+
+/* This part must be outside protection */
+#include <trace/define_trace.h>
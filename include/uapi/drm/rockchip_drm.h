@@ -87,6 +87,34 @@ enum drm_rockchip_gem_cpu_acquire_type {
 	DRM_ROCKCHIP_GEM_CPU_ACQUIRE_EXCLUSIVE = 0x1,
 };
 
+/**
+ * A structure for streaming a crtc into a ring of writeback buffers.
+ *
+ * @crtc_id: crtc the writeback connector is attached to.
+ * @count: number of buffers in @fb_id, 2 to 4, or 0 to stop the ring.
+ * @fb_id: framebuffers filled in turn, one per frame.
+ */
+struct drm_rockchip_wb_ring {
+	uint32_t crtc_id;
+	uint32_t count;
+	uint32_t fb_id[4];
+};
+
+/**
+ * A structure for getting the completion fence of a writeback ring buffer.
+ *
+ * @crtc_id: crtc the writeback ring runs on.
+ * @index: buffer of the ring to wait for.
+ * @fence_fd: returned sync_file, signalled when the buffer fill completes.
+ * @pad: just padding to be 64-bit aligned.
+ */
+struct drm_rockchip_wb_ring_fence {
+	uint32_t crtc_id;
+	uint32_t index;
+	int32_t fence_fd;
+	uint32_t pad;
+};
+
 enum rockchip_crtc_feture {
 	ROCKCHIP_DRM_CRTC_FEATURE_ALPHA_SCALE,
 	ROCKCHIP_DRM_CRTC_FEATURE_HDR10,
@@ -117,6 +145,8 @@ enum rockchip_cabc_mode {
 #define DRM_ROCKCHIP_GEM_CPU_RELEASE	0x03
 #define DRM_ROCKCHIP_GEM_GET_PHYS	0x04
 #define DRM_ROCKCHIP_GET_VCNT_EVENT	0x05
+#define DRM_ROCKCHIP_WB_RING		0x06
+#define DRM_ROCKCHIP_WB_RING_FENCE	0x07
 
 #define DRM_IOCTL_ROCKCHIP_GEM_CREATE	DRM_IOWR(DRM_COMMAND_BASE + \
 		DRM_ROCKCHIP_GEM_CREATE, struct drm_rockchip_gem_create)
@@ -136,4 +166,10 @@ enum rockchip_cabc_mode {
 #define DRM_IOCTL_ROCKCHIP_GET_VCNT_EVENT	DRM_IOWR(DRM_COMMAND_BASE + \
 		DRM_ROCKCHIP_GET_VCNT_EVENT, union drm_wait_vblank)
 
+#define DRM_IOCTL_ROCKCHIP_WB_RING	DRM_IOWR(DRM_COMMAND_BASE + \
+		DRM_ROCKCHIP_WB_RING, struct drm_rockchip_wb_ring)
+
+#define DRM_IOCTL_ROCKCHIP_WB_RING_FENCE	DRM_IOWR(DRM_COMMAND_BASE + \
+		DRM_ROCKCHIP_WB_RING_FENCE, struct drm_rockchip_wb_ring_fence)
+
 #endif /* _UAPI_ROCKCHIP_DRM_H */
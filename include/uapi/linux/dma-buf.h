@@ -179,6 +179,12 @@ struct dma_buf_import_sync_file {
 #define DMA_BUF_IOCTL_EXPORT_SYNC_FILE	_IOWR(DMA_BUF_BASE, 2, struct dma_buf_export_sync_file)
 #define DMA_BUF_IOCTL_IMPORT_SYNC_FILE	_IOW(DMA_BUF_BASE, 3, struct dma_buf_import_sync_file)
 
+/*
+ * Partial cache maintenance of [offset, offset + len) of a dma-buf. Exporters
+ * may remember the ranges started with DMA_BUF_SYNC_WRITE and then only clean
+ * those on the next DMA_BUF_IOCTL_SYNC with DMA_BUF_SYNC_END, unless the whole
+ * buffer was started for writing.
+ */
 struct dma_buf_sync_partial {
 	__u64 flags;
 	__u32 offset;
@@ -530,6 +530,12 @@ struct io_uring_files_update {
  * -1 file descriptors.
  */
 #define IORING_RSRC_REGISTER_SPARSE	(1U << 0)
+/*
+ * Register dma-buf fds as fixed buffers (IORING_REGISTER_BUFFERS2 only). data
+ * points to an array of __s32 dma-buf fds, -1 leaves a slot empty. The addr
+ * of a fixed read or write is then a byte offset into the dma-buf.
+ */
+#define IORING_RSRC_REGISTER_DMABUF	(1U << 1)
 
 struct io_uring_rsrc_register {
 	__u32 nr;
@@ -28,7 +28,31 @@ struct rk_decom_param {
 	__u64 decom_data_len;
 };
 
+/*
+ * input of RK_DECOM_ASYNC_SUBMIT
+ *
+ * The request is queued and the ioctl returns immediately. fence_fd is a
+ * sync_file signalled when the job completes, job_id is then passed to
+ * RK_DECOM_ASYNC_RESULT to fetch the status and decompressed length.
+ */
+struct rk_decom_async_param {
+	struct rk_decom_param param;
+	__s32 fence_fd;
+	__u32 reserved;
+	__u64 job_id;
+};
+
+/* input of RK_DECOM_ASYNC_RESULT */
+struct rk_decom_async_result {
+	__u64 job_id;
+	__s32 status;
+	__u32 reserved;
+	__u64 decom_data_len;
+};
+
 #define  RK_DECOM_MAGIC		'D'
 #define  RK_DECOM_USER		_IOWR(RK_DECOM_MAGIC, 101, struct rk_decom_param)
+#define  RK_DECOM_ASYNC_SUBMIT	_IOWR(RK_DECOM_MAGIC, 102, struct rk_decom_async_param)
+#define  RK_DECOM_ASYNC_RESULT	_IOWR(RK_DECOM_MAGIC, 103, struct rk_decom_async_result)
 
 #endif
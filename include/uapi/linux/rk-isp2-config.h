@@ -71,6 +71,12 @@
 #define RKISP_CMD_AIISP_RD_START \
 	_IO('V', BASE_VIDIOC_PRIVATE + 18)
 
+#define RKISP_CMD_SET_RDBK_SCHED \
+	_IOW('V', BASE_VIDIOC_PRIVATE + 19, struct rkisp_rdbk_sched)
+
+#define RKISP_CMD_GET_RDBK_SCHED \
+	_IOR('V', BASE_VIDIOC_PRIVATE + 20, struct rkisp_rdbk_sched)
+
 /****************ISP VIDEO IOCTL******************************/
 
 #define RKISP_CMD_GET_CSI_MEMORY_MODE \
@@ -118,9 +124,46 @@
 #define RKISP_CMD_SET_EXPANDER \
 	_IOW('V', BASE_VIDIOC_PRIVATE + 114, struct rkmodule_hdr_cfg)
 
+/*
+ * 1: attach a write fence to the dmabuf of each queued buffer, signaled
+ * when the frame is written, so that a consumer like ispp importing the
+ * same dmabuf can wait for it in kernel. Only for V4L2_MEMORY_DMABUF.
+ */
+#define RKISP_CMD_SET_OUT_FENCE \
+	_IOW('V', BASE_VIDIOC_PRIVATE + 115, int)
+
 /**********************EVENT_PRIVATE***************************/
 #define RKISP_V4L2_EVENT_AIISP_LINECNT (V4L2_EVENT_PRIVATE_START + 1)
 
+/**********************STATS RING******************************/
+/*
+ * mmap() of the statistics video node at RKISP_STATS_RING_OFFSET maps a
+ * read-only ring holding the statistics of the latest frames, so that 3A can
+ * read them without DQBUF/QBUF. The newest slot is (head - 1) % slot_num
+ * once head is non-zero. A slot is stable if its seq is even and unchanged
+ * after reading its data.
+ */
+#define RKISP_STATS_RING_OFFSET		0x40000000
+#define RKISP_STATS_RING_SLOTS		4
+
+struct rkisp_stats_ring_slot {
+	__u32 seq;
+	__u32 frame_id;
+	__u64 timestamp;
+	__u32 size;
+	__u32 reserved[3];
+	__u8 data[];
+} __attribute__ ((packed));
+
+struct rkisp_stats_ring_header {
+	__u32 head;
+	__u32 slot_num;
+	__u32 slot_offset;
+	__u32 slot_size;
+	__u32 data_size;
+	__u32 reserved[3];
+} __attribute__ ((packed));
+
 /*************************************************************/
 #define ISP2X_ID_DPCC			(0)
 #define ISP2X_ID_BLS			(1)
@@ -358,6 +401,21 @@ struct rkisp_aiisp_cfg {
 	int rd_linecnt;
 } __attribute__ ((packed));
 
+/* scheduling of the isp devices sharing one hardware in readback mode
+ * priority: device with higher priority is handled first
+ * fps: frame rate target, devices with target are handled earliest deadline
+ *	first, 0 for no target
+ * busy: hardware busy time of this device in the last second, in 1/1000,
+ *	only for get
+ * frame_cnt: frames handled in the last second, only for get
+ */
+struct rkisp_rdbk_sched {
+	__u32 priority;
+	__u32 fps;
+	__u32 busy;
+	__u32 frame_cnt;
+} __attribute__ ((packed));
+
 struct rkisp_bay3dbuf_info {
 	int iir_fd;
 	int iir_size;
@@ -49,6 +49,8 @@ enum MPP_DEV_COMMAND_TYPE {
 	MPP_CMD_TRANS_FD_TO_IOVA	= MPP_CMD_CONTROL_BASE + 1,
 	MPP_CMD_RELEASE_FD		= MPP_CMD_CONTROL_BASE + 2,
 	MPP_CMD_SEND_CODEC_INFO		= MPP_CMD_CONTROL_BASE + 3,
+	MPP_CMD_SET_EVENTFD		= MPP_CMD_CONTROL_BASE + 4,
+	MPP_CMD_SET_SESSION_PRIO	= MPP_CMD_CONTROL_BASE + 5,
 	MPP_CMD_CONTROL_BUTT,
 
 	MPP_CMD_BUTT,
@@ -60,6 +62,8 @@ enum MPP_DEV_COMMAND_TYPE {
 #define MPP_FLAGS_REG_FD_NO_TRANS	(0x00000004)
 #define MPP_FLAGS_SCL_FD_NO_TRANS	(0x00000008)
 #define MPP_FLAGS_REG_NO_OFFSET		(0x00000010)
+/* start this task only after the previous task of the same ioctl is done */
+#define MPP_FLAGS_CHAIN_PREV		(0x00000020)
 #define MPP_FLAGS_SECURE_MODE		(0x00010000)
 
 /* data common struct for parse out */
@@ -71,6 +75,19 @@ struct mpp_request {
 	void __user *data;
 };
 
+/*
+ * session scheduling on a shared taskqueue:
+ * priority    - 0 (highest) to MPP_SESSION_PRIO_MAX, default MPP_SESSION_PRIO_DEFAULT
+ * deadline_us - if not zero, relative deadline of each task, overrides priority
+ */
+#define MPP_SESSION_PRIO_MAX		(4)
+#define MPP_SESSION_PRIO_DEFAULT	(2)
+
+struct mpp_session_prio {
+	__u32 priority;
+	__u32 deadline_us;
+};
+
 #define MPP_BAT_MSG_DONE		(0x00000001)
 
 struct mpp_bat_msg {
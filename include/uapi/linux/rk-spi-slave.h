@@ -0,0 +1,53 @@
+/* SPDX-License-Identifier: GPL-2.0 WITH Linux-syscall-note */
+/*
+ * Rockchip SPI slave ring mode userspace API
+ *
+ * Copyright (c) 2023 Rockchip Electronics Co., Ltd.
+ */
+#ifndef _UAPI_LINUX_RK_SPI_SLAVE_H
+#define _UAPI_LINUX_RK_SPI_SLAVE_H
+
+#include <linux/ioctl.h>
+#include <linux/types.h>
+
+/**
+ * struct rkspi_ring_config - continuous reception setup
+ * @size:	ring size in bytes, a multiple of @period, at least two periods
+ * @period:	DMA period in bytes, the granularity of the notifications
+ * @watermark:	bytes pending before poll() reports POLLIN, 0 for one period
+ * @bits_per_word: 8 or 16
+ * @mode:	SPI_CPHA, SPI_CPOL and SPI_LSB_FIRST from linux/spi/spi.h
+ */
+struct rkspi_ring_config {
+	__u32 size;
+	__u32 period;
+	__u32 watermark;
+	__u32 bits_per_word;
+	__u32 mode;
+};
+
+/**
+ * struct rkspi_ring_status - ring position
+ * @head:	bytes written by the controller since START
+ * @tail:	bytes consumed since START, the data at @tail % size in the
+ *		mmap()ed ring is the oldest not yet consumed
+ * @overruns:	times the producer caught up with @tail, the tail is then
+ *		pushed forward and the oldest data is lost
+ * @fifo_overruns: rx fifo overflows, data lost before reaching the ring
+ */
+struct rkspi_ring_status {
+	__u64 head;
+	__u64 tail;
+	__u32 overruns;
+	__u32 fifo_overruns;
+};
+
+#define RKSPI_IOC_MAGIC		0xb8
+
+#define RKSPI_IOCTL_RING_START	_IOW(RKSPI_IOC_MAGIC, 0x0, struct rkspi_ring_config)
+#define RKSPI_IOCTL_RING_STOP	_IO(RKSPI_IOC_MAGIC, 0x1)
+#define RKSPI_IOCTL_RING_STATUS	_IOR(RKSPI_IOC_MAGIC, 0x2, struct rkspi_ring_status)
+/* advance the tail by the given number of bytes */
+#define RKSPI_IOCTL_RING_CONSUME _IOW(RKSPI_IOC_MAGIC, 0x3, __u32)
+
+#endif /* _UAPI_LINUX_RK_SPI_SLAVE_H */
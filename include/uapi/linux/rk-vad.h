@@ -0,0 +1,47 @@
+/* SPDX-License-Identifier: ((GPL-2.0+ WITH Linux-syscall-note) OR MIT) */
+/*
+ * Copyright (C) 2023 Rockchip Electronics Co., Ltd.
+ */
+
+#ifndef _UAPI_RK_VAD_H
+#define _UAPI_RK_VAD_H
+
+#include <linux/types.h>
+
+#define RK_VAD_NAME		"rk_vad"
+
+/*
+ * mmap offsets of /dev/rk_vad, in pages. Both mappings are read-only:
+ * the status page describes the ring, the ring is the VAD buffer the
+ * hardware records into.
+ */
+#define RK_VAD_PGOFF_STATUS	0
+#define RK_VAD_PGOFF_RING	1
+
+/* the ring has wrapped, the oldest sample is at write_offset */
+#define RK_VAD_STATUS_LOOPED	(1 << 0)
+/* detection is stopped, the ring contents no longer change */
+#define RK_VAD_STATUS_STOPPED	(1 << 1)
+
+/*
+ * Layout of the status page, also returned by read().
+ *
+ * seq is odd while the kernel updates the page. Readers of the mapping
+ * retry until they see the same even seq before and after copying the
+ * fields. poll() reports EPOLLIN once seq moved past the last read().
+ *
+ * Offsets are relative to the first ring byte, which is ring_offset
+ * bytes into the RK_VAD_PGOFF_RING mapping.
+ */
+struct rk_vad_status {
+	__u32 seq;
+	__u32 flags;
+	__u32 ring_offset;
+	__u32 ring_size;
+	__u32 write_offset;
+	__u32 valid_bytes;
+	__u32 channels;
+	__u32 sample_bytes;
+};
+
+#endif
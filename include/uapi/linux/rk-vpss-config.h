@@ -65,6 +65,10 @@
 #define RKVPSS_CMD_MODULE_GET \
 	_IOR('V', BASE_VIDIOC_PRIVATE + 54, struct rkvpss_module_sel)
 
+/* handle several frames in one call, see struct rkvpss_frame_batch */
+#define RKVPSS_CMD_FRAME_BATCH \
+	_IOWR('V', BASE_VIDIOC_PRIVATE + 55, struct rkvpss_frame_batch)
+
 /********************************************************************/
 
 /* struct rkvpss_mirror_flip
@@ -261,6 +265,28 @@ struct rkvpss_frame_cfg {
 	struct rkvpss_output_cfg output[RKVPSS_OUTPUT_MAX];
 } __attribute__ ((packed));
 
+#define RKVPSS_FRAME_BATCH_MAX 16
+
+/* return at once, the frames are completed when fence_fd is signaled */
+#define RKVPSS_BATCH_ASYNC (1 << 0)
+
+/* struct rkvpss_frame_batch
+ * frames handle in one submission
+ *
+ * frame_num: number of struct rkvpss_frame_cfg at frames, range 1~16.
+ * flags: RKVPSS_BATCH_ASYNC or 0.
+ * fence_fd: return sync_file fd if RKVPSS_BATCH_ASYNC, other -1.
+ * done_num: return number of frames handled if no RKVPSS_BATCH_ASYNC.
+ * frames: user pointer of struct rkvpss_frame_cfg array.
+ */
+struct rkvpss_frame_batch {
+	int frame_num;
+	int flags;
+	int fence_fd;
+	int done_num;
+	__u64 frames;
+} __attribute__ ((packed));
+
 #define RKVPSS_BUF_MAX 32
 
 /* struct rkvpss_buf_info
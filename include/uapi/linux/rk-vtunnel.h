@@ -0,0 +1,81 @@
+/* SPDX-License-Identifier: GPL-2.0 WITH Linux-syscall-note */
+/*
+ * Rockchip video tunnel userspace API
+ *
+ * Copyright (c) 2023 Rockchip Electronics Co., Ltd.
+ */
+#ifndef _UAPI_LINUX_RK_VTUNNEL_H
+#define _UAPI_LINUX_RK_VTUNNEL_H
+
+#include <linux/ioctl.h>
+#include <linux/types.h>
+
+/* buffers in the pool of a tunnel */
+#define RKVT_MAX_BUFFERS	16
+
+#define RKVT_ROLE_PRODUCER	1
+#define RKVT_ROLE_CONSUMER	2
+
+/* RKVT_IOCTL_QUEUE: replace the oldest queued frame rather than wait */
+#define RKVT_QUEUE_DROP_OLDEST	(1 << 0)
+
+/**
+ * struct rkvt_alloc_data - tunnel creation
+ * @tunnel_id:	returned id, to be passed to the peers
+ * @depth:	frames queued before the producer is throttled, 0 for default
+ */
+struct rkvt_alloc_data {
+	__s32 tunnel_id;
+	__u32 depth;
+};
+
+/**
+ * struct rkvt_connect_data - attach the file to a tunnel
+ * @tunnel_id:	the tunnel
+ * @role:	RKVT_ROLE_PRODUCER or RKVT_ROLE_CONSUMER, one of each per tunnel
+ */
+struct rkvt_connect_data {
+	__s32 tunnel_id;
+	__u32 role;
+};
+
+/**
+ * struct rkvt_pool_data - pool buffer
+ * @fd:		dma-buf fd, in for POOL_ADD, out for GET_BUFFER
+ * @index:	buffer index, out for POOL_ADD, in for GET_BUFFER
+ */
+struct rkvt_pool_data {
+	__s32 fd;
+	__u32 index;
+};
+
+/**
+ * struct rkvt_buf_data - frame handoff
+ * @index:	buffer index
+ * @fence_fd:	sync_file fd or -1; the acquire fence for QUEUE/ACQUIRE,
+ *		the release fence for RELEASE/DEQUEUE
+ * @timeout_ms:	time to wait in DEQUEUE, QUEUE and ACQUIRE, 0 to fail with
+ *		-EAGAIN, negative to wait forever
+ * @flags:	RKVT_QUEUE_* for QUEUE
+ */
+struct rkvt_buf_data {
+	__u32 index;
+	__s32 fence_fd;
+	__s32 timeout_ms;
+	__u32 flags;
+};
+
+#define RKVT_IOC_MAGIC		0xb7
+
+#define RKVT_IOCTL_ALLOC_ID	_IOWR(RKVT_IOC_MAGIC, 0x0, struct rkvt_alloc_data)
+#define RKVT_IOCTL_FREE_ID	_IOW(RKVT_IOC_MAGIC, 0x1, __s32)
+#define RKVT_IOCTL_CONNECT	_IOW(RKVT_IOC_MAGIC, 0x2, struct rkvt_connect_data)
+#define RKVT_IOCTL_DISCONNECT	_IO(RKVT_IOC_MAGIC, 0x3)
+#define RKVT_IOCTL_POOL_ADD	_IOWR(RKVT_IOC_MAGIC, 0x4, struct rkvt_pool_data)
+#define RKVT_IOCTL_GET_BUFFER	_IOWR(RKVT_IOC_MAGIC, 0x5, struct rkvt_pool_data)
+#define RKVT_IOCTL_DEQUEUE	_IOWR(RKVT_IOC_MAGIC, 0x6, struct rkvt_buf_data)
+#define RKVT_IOCTL_QUEUE	_IOW(RKVT_IOC_MAGIC, 0x7, struct rkvt_buf_data)
+#define RKVT_IOCTL_ACQUIRE	_IOWR(RKVT_IOC_MAGIC, 0x8, struct rkvt_buf_data)
+#define RKVT_IOCTL_RELEASE	_IOW(RKVT_IOC_MAGIC, 0x9, struct rkvt_buf_data)
+
+#endif /* _UAPI_LINUX_RK_VTUNNEL_H */
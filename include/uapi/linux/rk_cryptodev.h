@@ -51,6 +51,29 @@ struct crypt_fd_map_op {
 	__u32	phys_addr;	/* physics addr */
 };
 
+/* entry of RIOCCRYPT_FD_BATCH, cipher/hash sessions return the mac in tag */
+struct crypt_fd_batch_entry {
+	struct crypt_auth_fd_op	op;
+	__s32	status;		/* result of this op */
+	__u32	reserved;
+};
+
+#define RK_CRYPT_BATCH_MAX		256
+
+#define RK_CRYPT_BATCH_ASYNC		(1 << 0) /* return before the ops are run */
+#define RK_CRYPT_BATCH_STOP_ON_ERROR	(1 << 1) /* skip ops after a failed one */
+
+/* input of RIOCCRYPT_FD_BATCH/RIOCCRYPT_FD_BATCH_WAIT */
+struct crypt_fd_batch_op {
+	__u64	entries;	/* array of struct crypt_fd_batch_entry */
+	__u32	num;		/* number of entries */
+	__u32	flags;		/* see RK_CRYPT_BATCH_* */
+	__s32	eventfd;	/* signalled when an async batch is done, -1 for none */
+	__u32	id;		/* async batch id, 0 reaps any finished batch */
+	__u32	done;		/* number of entries that were run */
+	__s32	status;		/* result of the first failed entry */
+};
+
 #define AOP_ENCRYPT	0
 #define AOP_DECRYPT	1
 
@@ -81,5 +104,7 @@ struct crypt_rsa_op {
 #define RIOCCRYPT_DEV_ACCESS	_IOW('r',  108, struct crypt_fd_map_op)
 #define RIOCCRYPT_RSA_CRYPT	_IOWR('r', 109, struct crypt_rsa_op)
 #define RIOCAUTHCRYPT_FD	_IOWR('r', 110, struct crypt_auth_fd_op)
+#define RIOCCRYPT_FD_BATCH	_IOWR('r', 111, struct crypt_fd_batch_op)
+#define RIOCCRYPT_FD_BATCH_WAIT	_IOWR('r', 112, struct crypt_fd_batch_op)
 
 #endif
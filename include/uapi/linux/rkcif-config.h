@@ -77,6 +77,15 @@
 #define RKCIF_CMD_GET_CONNECT_ID \
 	_IOWR('V', BASE_VIDIOC_PRIVATE + 19, int)
 
+/* number of frames delivered together to userspace, 0 or 1 for each frame */
+#define RKCIF_CMD_SET_BATCH_NUM \
+	_IOW('V', BASE_VIDIOC_PRIVATE + 20, unsigned int)
+
+#define RKCIF_CMD_GET_BATCH_NUM \
+	_IOR('V', BASE_VIDIOC_PRIVATE + 21, unsigned int)
+
+#define RKCIF_MAX_BATCH_NUM		8
+
 /* cif memory mode
  * 0: raw12/raw10/raw8 8bit memory compact
  * 1: raw12/raw10 16bit memory one pixel
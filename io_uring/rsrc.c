@@ -8,6 +8,10 @@
 #include <linux/nospec.h>
 #include <linux/hugetlb.h>
 #include <linux/compat.h>
+#include <linux/device.h>
+#include <linux/dma-buf.h>
+#include <linux/dma-mapping.h>
+#include <linux/dma-resv.h>
 #include <linux/io_uring.h>
 
 #include <uapi/linux/io_uring.h>
@@ -26,6 +30,7 @@ struct io_rsrc_update {
 static int io_sqe_buffer_register(struct io_ring_ctx *ctx, struct iovec *iov,
 				  struct io_mapped_ubuf **pimu,
 				  struct page **last_hpage);
+static void io_dmabuf_unmap(struct io_mapped_ubuf *imu);
 
 #define IO_RSRC_REF_BATCH	100
 
@@ -142,8 +147,11 @@ static void io_buffer_unmap(struct io_ring_ctx *ctx, struct io_mapped_ubuf **slo
 	unsigned int i;
 
 	if (imu != ctx->dummy_ubuf) {
-		for (i = 0; i < imu->nr_bvecs; i++)
-			unpin_user_page(imu->bvec[i].bv_page);
+		if (imu->attach)
+			io_dmabuf_unmap(imu);
+		else
+			for (i = 0; i < imu->nr_bvecs; i++)
+				unpin_user_page(imu->bvec[i].bv_page);
 		if (imu->acct_pages)
 			io_unaccount_mem(ctx, imu->acct_pages);
 		kvfree(imu);
@@ -635,11 +643,14 @@ __cold int io_register_rsrc(struct io_ring_ctx *ctx, void __user *arg,
 		return -EFAULT;
 	if (!rr.nr || rr.resv2)
 		return -EINVAL;
-	if (rr.flags & ~IORING_RSRC_REGISTER_SPARSE)
+	if (rr.flags & ~(IORING_RSRC_REGISTER_SPARSE |
+			 IORING_RSRC_REGISTER_DMABUF))
 		return -EINVAL;
 
 	switch (type) {
 	case IORING_RSRC_FILE:
+		if (rr.flags & IORING_RSRC_REGISTER_DMABUF)
+			break;
 		if (rr.flags & IORING_RSRC_REGISTER_SPARSE && rr.data)
 			break;
 		return io_sqe_files_register(ctx, u64_to_user_ptr(rr.data),
@@ -647,6 +658,13 @@ __cold int io_register_rsrc(struct io_ring_ctx *ctx, void __user *arg,
 	case IORING_RSRC_BUFFER:
 		if (rr.flags & IORING_RSRC_REGISTER_SPARSE && rr.data)
 			break;
+		if (rr.flags & IORING_RSRC_REGISTER_DMABUF) {
+			if (!rr.data)
+				break;
+			return io_sqe_dmabufs_register(ctx,
+						u64_to_user_ptr(rr.data),
+						rr.nr, u64_to_user_ptr(rr.tags));
+		}
 		return io_sqe_buffers_register(ctx, u64_to_user_ptr(rr.data),
 					       rr.nr, u64_to_user_ptr(rr.tags));
 	}
@@ -1236,6 +1254,8 @@ static int io_sqe_buffer_register(struct io_ring_ctx *ctx, struct iovec *iov,
 	imu->ubuf = (unsigned long) iov->iov_base;
 	imu->ubuf_end = imu->ubuf + iov->iov_len;
 	imu->nr_bvecs = nr_pages;
+	imu->attach = NULL;
+	imu->sgt = NULL;
 	*pimu = imu;
 	ret = 0;
 done:
@@ -1245,19 +1265,179 @@ static int io_sqe_buffer_register(struct io_ring_ctx *ctx, struct iovec *iov,
 	return ret;
 }
 
+#ifdef CONFIG_DMA_SHARED_BUFFER
+static struct device *io_dmabuf_dev;
+static DEFINE_MUTEX(io_dmabuf_dev_lock);
+
+/*
+ * dma-bufs are attached to this device only to get at their pages, the
+ * actual I/O is mapped by the driver of the file being read or written.
+ */
+static struct device *io_dmabuf_device(void)
+{
+	struct device *dev;
+
+	mutex_lock(&io_dmabuf_dev_lock);
+	if (!io_dmabuf_dev) {
+		dev = root_device_register("io_uring");
+		if (!IS_ERR(dev)) {
+			dma_coerce_mask_and_coherent(dev, DMA_BIT_MASK(64));
+			io_dmabuf_dev = dev;
+		}
+	}
+	mutex_unlock(&io_dmabuf_dev_lock);
+	return io_dmabuf_dev;
+}
+
+static int io_sqe_dmabuf_register(struct io_ring_ctx *ctx, int fd,
+				  struct io_mapped_ubuf **pimu)
+{
+	struct io_mapped_ubuf *imu = NULL;
+	struct dma_buf_attachment *attach;
+	struct sg_page_iter piter;
+	struct dma_buf *dmabuf;
+	struct sg_table *sgt;
+	struct device *dev;
+	unsigned int i = 0, nr_pages;
+	int ret;
+
+	*pimu = ctx->dummy_ubuf;
+	if (fd < 0)
+		return 0;
+
+	/* importers only see mangled page pointers with dma-buf debugging */
+	if (IS_ENABLED(CONFIG_DMABUF_DEBUG))
+		return -EOPNOTSUPP;
+	dev = io_dmabuf_device();
+	if (!dev)
+		return -ENODEV;
+
+	dmabuf = dma_buf_get(fd);
+	if (IS_ERR(dmabuf))
+		return PTR_ERR(dmabuf);
+
+	/* same arbitrary limit as for user memory */
+	ret = -EFAULT;
+	if (!dmabuf->size || dmabuf->size > SZ_1G ||
+	    !PAGE_ALIGNED(dmabuf->size))
+		goto err_put;
+
+	attach = dma_buf_attach(dmabuf, dev);
+	if (IS_ERR(attach)) {
+		ret = PTR_ERR(attach);
+		goto err_put;
+	}
+	sgt = dma_buf_map_attachment_unlocked(attach, DMA_BIDIRECTIONAL);
+	if (IS_ERR(sgt)) {
+		ret = PTR_ERR(sgt);
+		goto err_detach;
+	}
+
+	ret = -ENOMEM;
+	nr_pages = dmabuf->size >> PAGE_SHIFT;
+	imu = kvmalloc(struct_size(imu, bvec, nr_pages), GFP_KERNEL);
+	if (!imu)
+		goto err_unmap;
+
+	ret = -EOPNOTSUPP;
+	for_each_sgtable_page(sgt, &piter, 0) {
+		/* exporters without struct pages can't back a bvec */
+		if (!sg_page(piter.sg))
+			goto err_free;
+		if (i == nr_pages)
+			break;
+		imu->bvec[i].bv_page = sg_page_iter_page(&piter);
+		imu->bvec[i].bv_len = PAGE_SIZE;
+		imu->bvec[i].bv_offset = 0;
+		i++;
+	}
+	if (i != nr_pages)
+		goto err_free;
+
+	/* fixed reads and writes address a dma-buf by byte offset */
+	imu->ubuf = 0;
+	imu->ubuf_end = dmabuf->size;
+	imu->nr_bvecs = nr_pages;
+	imu->acct_pages = 0;
+	imu->attach = attach;
+	imu->sgt = sgt;
+	*pimu = imu;
+	return 0;
+
+err_free:
+	kvfree(imu);
+err_unmap:
+	dma_buf_unmap_attachment_unlocked(attach, sgt, DMA_BIDIRECTIONAL);
+err_detach:
+	dma_buf_detach(dmabuf, attach);
+err_put:
+	dma_buf_put(dmabuf);
+	return ret;
+}
+
+static void io_dmabuf_unmap(struct io_mapped_ubuf *imu)
+{
+	struct dma_buf *dmabuf = imu->attach->dmabuf;
+
+	dma_buf_unmap_attachment_unlocked(imu->attach, imu->sgt,
+					  DMA_BIDIRECTIONAL);
+	dma_buf_detach(dmabuf, imu->attach);
+	dma_buf_put(dmabuf);
+}
+
+/*
+ * Implicit sync: filling a dma-buf waits for all its fences, reading it out
+ * only for pending writers. Blocking is left to io-wq.
+ */
+int __io_dmabuf_wait(struct io_mapped_ubuf *imu, int ddir,
+		     unsigned int issue_flags)
+{
+	struct dma_resv *resv = imu->attach->dmabuf->resv;
+	enum dma_resv_usage usage = dma_resv_usage_rw(ddir == ITER_DEST);
+	long ret;
+
+	if (dma_resv_test_signaled(resv, usage))
+		return 0;
+	if (issue_flags & IO_URING_F_NONBLOCK)
+		return -EAGAIN;
+
+	ret = dma_resv_wait_timeout(resv, usage, true, MAX_SCHEDULE_TIMEOUT);
+	return ret < 0 ? ret : 0;
+}
+#else
+static int io_sqe_dmabuf_register(struct io_ring_ctx *ctx, int fd,
+				  struct io_mapped_ubuf **pimu)
+{
+	*pimu = ctx->dummy_ubuf;
+	return fd < 0 ? 0 : -EOPNOTSUPP;
+}
+
+static void io_dmabuf_unmap(struct io_mapped_ubuf *imu)
+{
+}
+
+int __io_dmabuf_wait(struct io_mapped_ubuf *imu, int ddir,
+		     unsigned int issue_flags)
+{
+	return 0;
+}
+#endif
+
 static int io_buffers_map_alloc(struct io_ring_ctx *ctx, unsigned int nr_args)
 {
 	ctx->user_bufs = kcalloc(nr_args, sizeof(*ctx->user_bufs), GFP_KERNEL);
 	return ctx->user_bufs ? 0 : -ENOMEM;
 }
 
-int io_sqe_buffers_register(struct io_ring_ctx *ctx, void __user *arg,
-			    unsigned int nr_args, u64 __user *tags)
+static int __io_sqe_buffers_register(struct io_ring_ctx *ctx, void __user *arg,
+				     unsigned int nr_args, u64 __user *tags,
+				     bool dmabuf)
 {
 	struct page *last_hpage = NULL;
 	struct io_rsrc_data *data;
 	int i, ret;
 	struct iovec iov;
+	s32 fd;
 
 	BUILD_BUG_ON(IORING_MAX_REG_BUFFERS >= (1u << 16));
 
@@ -1278,6 +1458,24 @@ int io_sqe_buffers_register(struct io_ring_ctx *ctx, void __user *arg,
 	}
 
 	for (i = 0; i < nr_args; i++, ctx->nr_user_bufs++) {
+		if (dmabuf) {
+			s32 __user *fds = arg;
+
+			if (copy_from_user(&fd, &fds[i], sizeof(fd))) {
+				ret = -EFAULT;
+				break;
+			}
+			if (fd < 0 && *io_get_tag_slot(data, i)) {
+				ret = -EINVAL;
+				break;
+			}
+			ret = io_sqe_dmabuf_register(ctx, fd,
+						     &ctx->user_bufs[i]);
+			if (ret)
+				break;
+			continue;
+		}
+
 		if (arg) {
 			ret = io_copy_iov(ctx, &iov, arg, i);
 			if (ret)
@@ -1310,6 +1508,18 @@ int io_sqe_buffers_register(struct io_ring_ctx *ctx, void __user *arg,
 	return ret;
 }
 
+int io_sqe_buffers_register(struct io_ring_ctx *ctx, void __user *arg,
+			    unsigned int nr_args, u64 __user *tags)
+{
+	return __io_sqe_buffers_register(ctx, arg, nr_args, tags, false);
+}
+
+int io_sqe_dmabufs_register(struct io_ring_ctx *ctx, void __user *arg,
+			    unsigned int nr_args, u64 __user *tags)
+{
+	return __io_sqe_buffers_register(ctx, arg, nr_args, tags, true);
+}
+
 int io_import_fixed(int ddir, struct iov_iter *iter,
 			   struct io_mapped_ubuf *imu,
 			   u64 buf_addr, size_t len)
@@ -50,6 +50,9 @@ struct io_mapped_ubuf {
 	u64		ubuf_end;
 	unsigned int	nr_bvecs;
 	unsigned long	acct_pages;
+	/* set for buffers registered with IORING_RSRC_REGISTER_DMABUF */
+	struct dma_buf_attachment *attach;
+	struct sg_table	*sgt;
 	struct bio_vec	bvec[];
 };
 
@@ -67,11 +70,23 @@ void io_rsrc_node_switch(struct io_ring_ctx *ctx,
 int io_import_fixed(int ddir, struct iov_iter *iter,
 			   struct io_mapped_ubuf *imu,
 			   u64 buf_addr, size_t len);
+int __io_dmabuf_wait(struct io_mapped_ubuf *imu, int ddir,
+		     unsigned int issue_flags);
+
+static inline int io_dmabuf_wait(struct io_mapped_ubuf *imu, int ddir,
+				 unsigned int issue_flags)
+{
+	if (likely(!imu->attach))
+		return 0;
+	return __io_dmabuf_wait(imu, ddir, issue_flags);
+}
 
 void __io_sqe_buffers_unregister(struct io_ring_ctx *ctx);
 int io_sqe_buffers_unregister(struct io_ring_ctx *ctx);
 int io_sqe_buffers_register(struct io_ring_ctx *ctx, void __user *arg,
 			    unsigned int nr_args, u64 __user *tags);
+int io_sqe_dmabufs_register(struct io_ring_ctx *ctx, void __user *arg,
+			    unsigned int nr_args, u64 __user *tags);
 void __io_sqe_files_unregister(struct io_ring_ctx *ctx);
 int io_sqe_files_unregister(struct io_ring_ctx *ctx);
 int io_sqe_files_register(struct io_ring_ctx *ctx, void __user *arg,
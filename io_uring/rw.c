@@ -692,6 +692,15 @@ static int io_rw_init_file(struct io_kiocb *req, fmode_t mode)
 	return 0;
 }
 
+static inline int io_rw_fixed_wait(struct io_kiocb *req, int ddir,
+				   unsigned int issue_flags)
+{
+	if (req->opcode != IORING_OP_READ_FIXED &&
+	    req->opcode != IORING_OP_WRITE_FIXED)
+		return 0;
+	return io_dmabuf_wait(req->imu, ddir, issue_flags);
+}
+
 int io_read(struct io_kiocb *req, unsigned int issue_flags)
 {
 	struct io_rw *rw = io_kiocb_to_cmd(req, struct io_rw);
@@ -703,6 +712,10 @@ int io_read(struct io_kiocb *req, unsigned int issue_flags)
 	ssize_t ret, ret2;
 	loff_t *ppos;
 
+	ret = io_rw_fixed_wait(req, ITER_DEST, issue_flags);
+	if (unlikely(ret))
+		return ret;
+
 	if (!req_has_async_data(req)) {
 		ret = io_import_iovec(ITER_DEST, req, &iovec, s, issue_flags);
 		if (unlikely(ret < 0))
@@ -850,6 +863,10 @@ int io_write(struct io_kiocb *req, unsigned int issue_flags)
 	ssize_t ret, ret2;
 	loff_t *ppos;
 
+	ret = io_rw_fixed_wait(req, ITER_SOURCE, issue_flags);
+	if (unlikely(ret))
+		return ret;
+
 	if (!req_has_async_data(req)) {
 		ret = io_import_iovec(ITER_SOURCE, req, &iovec, s, issue_flags);
 		if (unlikely(ret < 0))
@@ -428,6 +428,12 @@ int snd_dmaengine_pcm_refine_runtime_hwparams(
 			hw->info |= SNDRV_PCM_INFO_PAUSE | SNDRV_PCM_INFO_RESUME;
 		if (dma_caps.residue_granularity <= DMA_RESIDUE_GRANULARITY_SEGMENT)
 			hw->info |= SNDRV_PCM_INFO_BATCH;
+		/*
+		 * The position is read back from the controller, so timer
+		 * driven clients can run without period interrupts.
+		 */
+		if (dma_caps.residue_granularity == DMA_RESIDUE_GRANULARITY_BURST)
+			hw->info |= SNDRV_PCM_INFO_NO_PERIOD_WAKEUP;
 
 		if (substream->stream == SNDRV_PCM_STREAM_PLAYBACK)
 			addr_widths = dma_caps.dst_addr_widths;
@@ -8,6 +8,7 @@
  */
 
 #include <linux/kref.h>
+#include <linux/math64.h>
 #include <linux/module.h>
 #include <linux/init.h>
 #include <linux/dmaengine.h>
@@ -261,23 +262,45 @@ static int dlp_get_offset_size(struct dlp_runtime_data *drd,
 	return ret;
 }
 
-static int dlp_mix_frame_buffer(struct dlp_runtime_data *drd, void *buf)
+/*
+ * Mix all channels of @frames playback frames at @src down to one sample
+ * per frame at @dst. The sample size is resolved once per chunk rather
+ * than per frame, the sum is kept in a wider type so every frame takes a
+ * single division, and the playback ring is left untouched so a frame
+ * read twice is not mixed twice.
+ */
+static int dlp_mix_frames(struct dlp_runtime_data *drd, const char *src,
+			  char *dst, unsigned int dst_stride, int frames)
 {
 	int sample_bytes = dlp_channels_to_bytes(drd, 1);
-	int16_t *p16 = (int16_t *)buf, v16 = 0;
-	int32_t *p32 = (int32_t *)buf, v32 = 0;
-	int i = 0;
+	unsigned int channels = drd->channels;
+	unsigned int src_stride = drd->frame_bytes;
+	int i, ch;
 
 	switch (sample_bytes) {
 	case 2:
-		for (i = 0; i < drd->channels; i++)
-			v16 += (p16[i] / drd->channels);
-		p16[0] = v16;
+		for (i = 0; i < frames; i++) {
+			const int16_t *p16 = (const int16_t *)src;
+			int32_t v32 = 0;
+
+			for (ch = 0; ch < channels; ch++)
+				v32 += p16[ch];
+			*(int16_t *)dst = v32 / (int32_t)channels;
+			src += src_stride;
+			dst += dst_stride;
+		}
 		break;
 	case 4:
-		for (i = 0; i < drd->channels; i++)
-			v32 += (p32[i] / drd->channels);
-		p32[0] = v32;
+		for (i = 0; i < frames; i++) {
+			const int32_t *p32 = (const int32_t *)src;
+			int64_t v64 = 0;
+
+			for (ch = 0; ch < channels; ch++)
+				v64 += p32[ch];
+			*(int32_t *)dst = div_s64(v64, channels);
+			src += src_stride;
+			dst += dst_stride;
+		}
 		break;
 	default:
 		return -EINVAL;
@@ -680,10 +703,10 @@ static int process_capture(struct snd_soc_component *component,
 	struct dlp_runtime_data *drd_ref = NULL;
 	snd_pcm_sframes_t frames = 0;
 	snd_pcm_sframes_t frames_consumed = 0, frames_residue = 0, frames_tmp = 0;
-	snd_pcm_sframes_t ofs = 0;
+	snd_pcm_sframes_t ofs = 0, chunk = 0;
 	snd_pcm_uframes_t appl_ptr;
 	int ofs_cap, ofs_play, size_cap, size_play;
-	int i = 0, j = 0, ret = 0;
+	int i = 0, j = 0, k = 0, ret = 0;
 	bool free_ref = false, mix = false;
 	char *cbuf = NULL, *pbuf = NULL;
 	void *dma_ptr;
@@ -778,12 +801,21 @@ static int process_capture(struct snd_soc_component *component,
 	dev_dbg(dlp->dev, "applptr: %8lu, ofs: %8ld, frames: %5ld, refc: %u\n",
 		appl_ptr, ofs, frames, kref_read(&drd_ref->refcount));
 
-	for (i = 0; i < frames; i++, j++) {
-		cbuf = drd->buf + dlp_frames_to_bytes(drd, j + frames_consumed) + ofs_cap;
-		pbuf = drd_ref->buf + dlp_frames_to_bytes(drd_ref, ((i + ofs) % drd_ref->buf_sz)) + ofs_play;
-		if (mix)
-			dlp_mix_frame_buffer(drd_ref, pbuf);
-		memcpy(cbuf, pbuf, size_cap);
+	/* walk the playback ring in contiguous chunks, split at its end */
+	for (i = 0; i < frames; i += chunk) {
+		chunk = min_t(snd_pcm_sframes_t, frames - i, drd_ref->buf_sz - ofs);
+		cbuf = drd->buf + dlp_frames_to_bytes(drd, i + j + frames_consumed) + ofs_cap;
+		pbuf = drd_ref->buf + dlp_frames_to_bytes(drd_ref, ofs) + ofs_play;
+		if (mix) {
+			dlp_mix_frames(drd_ref, pbuf, cbuf, drd->frame_bytes, chunk);
+		} else {
+			for (k = 0; k < chunk; k++) {
+				memcpy(cbuf, pbuf, size_cap);
+				cbuf += drd->frame_bytes;
+				pbuf += drd_ref->frame_bytes;
+			}
+		}
+		ofs = (ofs + chunk) % drd_ref->buf_sz;
 	}
 
 	appl_ptr += frames;
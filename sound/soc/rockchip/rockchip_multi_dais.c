@@ -109,14 +109,80 @@ static int rockchip_mdais_hw_free(struct snd_pcm_substream *substream,
 	return 0;
 }
 
+/*
+ * A DAI whose bit and frame clocks come from outside waits for the first
+ * frame edge once enabled, so it can be armed ahead of the clock master.
+ */
+static inline bool mdais_dai_is_slave(struct rk_dai *dai)
+{
+	return (dai->fmt_msk & SND_SOC_DAIFMT_MASTER_MASK) &&
+	       (dai->fmt & SND_SOC_DAIFMT_MASTER_MASK) == SND_SOC_DAIFMT_CBM_CFM;
+}
+
+static int rockchip_mdais_trigger_child(struct snd_pcm_substream *substream,
+					int cmd, struct rk_dai *dai)
+{
+	struct snd_soc_dai *child = dai->dai;
+
+	if (child->driver->ops && child->driver->ops->trigger)
+		return child->driver->ops->trigger(substream, cmd, child);
+
+	return 0;
+}
+
+static int rockchip_mdais_trigger_start(struct rk_mdais_dev *mdais,
+					struct snd_pcm_substream *substream,
+					int cmd)
+{
+	unsigned int *channel_maps = mdais_channel_maps(mdais, substream);
+	u64 first = 0, last = 0;
+	int ret, i, pass;
+
+	/*
+	 * Arm the clock slaves first and start the masters last: the slaves
+	 * then all begin on the same frame edge, the first one the masters
+	 * drive, and the start no longer depends on how long each trigger
+	 * takes. The span of the trigger writes is kept as start skew.
+	 */
+	for (pass = 0; pass < 2; pass++) {
+		for (i = 0; i < mdais->num_dais; i++) {
+			if (!channel_maps[i] ||
+			    mdais_dai_is_slave(&mdais->dais[i]) != !pass)
+				continue;
+
+			if (!first)
+				first = ktime_get_ns();
+			ret = rockchip_mdais_trigger_child(substream, cmd,
+							   &mdais->dais[i]);
+			if (ret < 0)
+				return ret;
+			last = ktime_get_ns();
+		}
+	}
+
+	WRITE_ONCE(mdais->start_skew_ns, last - first);
+	if (last - first > mdais->start_skew_max_ns)
+		WRITE_ONCE(mdais->start_skew_max_ns, last - first);
+
+	return 0;
+}
+
 static int rockchip_mdais_trigger(struct snd_pcm_substream *substream,
 				  int cmd, struct snd_soc_dai *dai)
 {
 	struct rk_mdais_dev *mdais = to_info(dai);
-	struct snd_soc_dai *child;
 	unsigned int *channel_maps;
 	int ret = 0, i = 0;
 
+	switch (cmd) {
+	case SNDRV_PCM_TRIGGER_START:
+	case SNDRV_PCM_TRIGGER_RESUME:
+	case SNDRV_PCM_TRIGGER_PAUSE_RELEASE:
+		return rockchip_mdais_trigger_start(mdais, substream, cmd);
+	default:
+		break;
+	}
+
 	channel_maps = mdais_channel_maps(mdais, substream);
 
 	for (i = 0; i < mdais->num_dais; i++) {
@@ -124,13 +190,10 @@ static int rockchip_mdais_trigger(struct snd_pcm_substream *substream,
 		if (!channel_maps[i])
 			continue;
 
-		child = mdais->dais[i].dai;
-		if (child->driver->ops && child->driver->ops->trigger) {
-			ret = child->driver->ops->trigger(substream,
-							  cmd, child);
-			if (ret < 0)
-				return ret;
-		}
+		ret = rockchip_mdais_trigger_child(substream, cmd,
+						   &mdais->dais[i]);
+		if (ret < 0)
+			return ret;
 	}
 
 	return 0;
@@ -323,8 +386,47 @@ static const struct snd_soc_dai_ops rockchip_mdais_dai_ops = {
 	.prepare = rockchip_mdais_prepare,
 };
 
+static int rockchip_mdais_skew_info(struct snd_kcontrol *kcontrol,
+				    struct snd_ctl_elem_info *uinfo)
+{
+	uinfo->type = SNDRV_CTL_ELEM_TYPE_INTEGER;
+	uinfo->count = 2;
+	uinfo->value.integer.min = 0;
+	uinfo->value.integer.max = INT_MAX;
+
+	return 0;
+}
+
+/* last and worst start skew in ns, see rockchip_mdais_trigger_start() */
+static int rockchip_mdais_skew_get(struct snd_kcontrol *kcontrol,
+				   struct snd_ctl_elem_value *ucontrol)
+{
+	struct snd_soc_component *component = snd_kcontrol_chip(kcontrol);
+	struct rk_mdais_dev *mdais = snd_soc_component_get_drvdata(component);
+
+	ucontrol->value.integer.value[0] =
+		min_t(u64, READ_ONCE(mdais->start_skew_ns), INT_MAX);
+	ucontrol->value.integer.value[1] =
+		min_t(u64, READ_ONCE(mdais->start_skew_max_ns), INT_MAX);
+
+	return 0;
+}
+
+static const struct snd_kcontrol_new rockchip_mdais_controls[] = {
+	{
+		.iface = SNDRV_CTL_ELEM_IFACE_MIXER,
+		.name = "Start Skew",
+		.access = SNDRV_CTL_ELEM_ACCESS_READ |
+			  SNDRV_CTL_ELEM_ACCESS_VOLATILE,
+		.info = rockchip_mdais_skew_info,
+		.get = rockchip_mdais_skew_get,
+	},
+};
+
 static const struct snd_soc_component_driver rockchip_mdais_component = {
 	.name = DAIS_DRV_NAME,
+	.controls = rockchip_mdais_controls,
+	.num_controls = ARRAY_SIZE(rockchip_mdais_controls),
 	.legacy_dai_naming = 1,
 };
 
@@ -25,6 +25,9 @@ struct rk_mdais_dev {
 	unsigned int *playback_channel_maps;
 	unsigned int *capture_channel_maps;
 	int num_dais;
+	/* span of the last and the worst grouped start, in ns */
+	u64 start_skew_ns;
+	u64 start_skew_max_ns;
 };
 
 int snd_dmaengine_mpcm_register(struct rk_mdais_dev *mdais);
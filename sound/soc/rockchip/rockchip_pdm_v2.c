@@ -205,9 +205,6 @@ static int rockchip_pdm_v2_hw_params(struct snd_pcm_substream *substream,
 
 	regmap_update_bits(pdm->regmap, PDM_V2_CTRL,
 			   PDM_V2_SJM_SEL_MSK, PDM_V2_SJM_SEL_L);
-	regmap_update_bits(pdm->regmap, PDM_V2_FILTER_CTRL,
-			   PDM_V2_HPF_R_MSK | PDM_V2_HPF_L_MSK | PDM_V2_HPF_FREQ_MSK,
-			   PDM_V2_HPF_R_EN | PDM_V2_HPF_L_EN | PDM_V2_HPF_FREQ_60);
 	rockchip_pdm_v2_set_samplerate(pdm, params_rate(params));
 	switch (params_format(params)) {
 	case SNDRV_PCM_FORMAT_S16_LE:
@@ -726,6 +723,13 @@ static int rockchip_pdm_v2_probe(struct platform_device *pdev)
 	/* Set the default gain */
 	regmap_update_bits(pdm->regmap, PDM_V2_FILTER_CTRL, PDM_V2_GAIN_CTRL_MSK,
 			   PDM_V2_GAIN_0DB);
+	/*
+	 * Set the default HPF once here rather than on every hw_params, so
+	 * the "HPF Cutoff" and "HPFL/HPFR Switch" controls stick.
+	 */
+	regmap_update_bits(pdm->regmap, PDM_V2_FILTER_CTRL,
+			   PDM_V2_HPF_R_MSK | PDM_V2_HPF_L_MSK | PDM_V2_HPF_FREQ_MSK,
+			   PDM_V2_HPF_R_EN | PDM_V2_HPF_L_EN | PDM_V2_HPF_FREQ_60);
 
 	ret = rockchip_pdm_v2_path_parse(pdm, node);
 	if (ret != 0 && ret != -ENOENT)
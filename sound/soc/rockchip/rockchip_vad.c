@@ -11,13 +11,18 @@
 #include <linux/clk.h>
 #include <linux/interrupt.h>
 #include <linux/io.h>
+#include <linux/miscdevice.h>
+#include <linux/mm.h>
 #include <linux/of_device.h>
 #include <linux/of_address.h>
 #include <linux/pm_runtime.h>
 #include <linux/regmap.h>
+#include <linux/poll.h>
+#include <linux/slab.h>
 #include <sound/pcm.h>
 #include <sound/pcm_params.h>
 #include <sound/soc.h>
+#include <uapi/linux/rk-vad.h>
 
 #include "rockchip_vad.h"
 #include "rockchip_multi_dais.h"
@@ -72,7 +77,12 @@ struct rockchip_vad {
 	struct regmap *regmap;
 	unsigned int memphy;
 	unsigned int memphy_end;
+	unsigned int memsize;
 	void __iomem *membase;
+	struct miscdevice miscdev;
+	struct rk_vad_status *status;
+	spinlock_t status_lock;
+	wait_queue_head_t status_wait;
 	struct vad_buf vbuf;
 	struct vad_params params;
 	struct vad_uparams uparams;
@@ -94,11 +104,44 @@ struct rockchip_vad {
 	enum rk_vad_version version;
 };
 
+struct rockchip_vad_file {
+	struct rockchip_vad *vad;
+	u32 seq;
+};
+
 static inline int vframe_size(struct rockchip_vad *vad, int bytes)
 {
 	return bytes / vad->channels / vad->sample_bytes;
 }
 
+/*
+ * Update the status page mapped by the wake-word engine. It follows the
+ * seqcount protocol documented in rk-vad.h, readers never block us.
+ */
+static void rockchip_vad_publish(struct rockchip_vad *vad, u32 flags,
+				 u32 write_offset, u32 valid_bytes)
+{
+	struct rk_vad_status *st = smp_load_acquire(&vad->status);
+	unsigned long irqflags;
+
+	if (!st)
+		return;
+
+	spin_lock_irqsave(&vad->status_lock, irqflags);
+	WRITE_ONCE(st->seq, st->seq + 1);
+	smp_wmb();
+	st->flags = flags;
+	st->write_offset = write_offset;
+	st->valid_bytes = valid_bytes;
+	st->channels = vad->channels;
+	st->sample_bytes = vad->sample_bytes;
+	smp_wmb();
+	WRITE_ONCE(st->seq, st->seq + 1);
+	spin_unlock_irqrestore(&vad->status_lock, irqflags);
+
+	wake_up_interruptible(&vad->status_wait);
+}
+
 static int chunk_sort(void __iomem *pos, void __iomem *end, int loop_cnt)
 {
 	char tbuf[CHUNK_SIZE];
@@ -180,6 +223,7 @@ static int rockchip_vad_stop(struct rockchip_vad *vad)
 	if (!val) {
 		vbuf->size = 0;
 		vbuf->cur = vbuf->begin;
+		rockchip_vad_publish(vad, RK_VAD_STATUS_STOPPED, 0, 0);
 		return 0;
 	}
 	vbuf->cur = vbuf->begin + (val - vad->memphy);
@@ -206,7 +250,13 @@ static int rockchip_vad_stop(struct rockchip_vad *vad)
 				vbuf->loop_cnt = (vbuf->loop_cnt + 1) % 16;
 		}
 		vbuf->sorted = false;
+		/* the mapped ring must be in order for in place readers */
+		vad_buffer_sort(vad);
 	}
+	rockchip_vad_publish(vad, RK_VAD_STATUS_STOPPED |
+			     (vbuf->loop ? RK_VAD_STATUS_LOOPED : 0),
+			     vbuf->cur - vbuf->begin, vbuf->size);
+
 	regmap_read(vad->regmap, VAD_DET_CON0, &val);
 	params->noise_level = (val & NOISE_LEVEL_MASK) >> NOISE_LEVEL_SHIFT;
 	params->vad_con_thd = (val & VAD_CON_THD_MASK) >> VAD_CON_THD_SHIFT;
@@ -671,13 +721,23 @@ static int rockchip_vad_get_audio_src_address(struct rockchip_vad *vad,
 static irqreturn_t rockchip_vad_irq(int irqno, void *dev_id)
 {
 	struct rockchip_vad *vad = dev_id;
-	unsigned  int val;
+	unsigned  int val, cur;
 
 	regmap_read(vad->regmap, VAD_INT, &val);
 	regmap_write(vad->regmap, VAD_INT, val);
 
 	dev_dbg(vad->dev, "irq 0x%08x\n", val);
 
+	/* let the wake-word engine look at the history right away */
+	regmap_read(vad->regmap, VAD_RAM_CUR_ADDR, &cur);
+	if (cur) {
+		bool loop = val & BIT(8);
+
+		rockchip_vad_publish(vad, loop ? RK_VAD_STATUS_LOOPED : 0,
+				     cur - vad->memphy,
+				     loop ? vad->memsize : cur - vad->memphy);
+	}
+
 	return IRQ_HANDLED;
 }
 
@@ -1116,6 +1176,137 @@ static const struct file_operations rockchip_vad_reg_debugfs_fops = {
 };
 #endif
 
+static int rockchip_vad_fops_open(struct inode *inode, struct file *file)
+{
+	struct rockchip_vad *vad = container_of(file->private_data,
+						struct rockchip_vad, miscdev);
+	struct rockchip_vad_file *vfile;
+
+	vfile = kzalloc(sizeof(*vfile), GFP_KERNEL);
+	if (!vfile)
+		return -ENOMEM;
+
+	vfile->vad = vad;
+	vfile->seq = READ_ONCE(vad->status->seq);
+	file->private_data = vfile;
+
+	return 0;
+}
+
+static int rockchip_vad_fops_release(struct inode *inode, struct file *file)
+{
+	kfree(file->private_data);
+
+	return 0;
+}
+
+static ssize_t rockchip_vad_fops_read(struct file *file, char __user *buf,
+				      size_t count, loff_t *ppos)
+{
+	struct rockchip_vad_file *vfile = file->private_data;
+	struct rockchip_vad *vad = vfile->vad;
+	struct rk_vad_status st;
+
+	if (count < sizeof(st))
+		return -EINVAL;
+
+	spin_lock_irq(&vad->status_lock);
+	st = *vad->status;
+	spin_unlock_irq(&vad->status_lock);
+
+	if (copy_to_user(buf, &st, sizeof(st)))
+		return -EFAULT;
+	vfile->seq = st.seq;
+
+	return sizeof(st);
+}
+
+static __poll_t rockchip_vad_fops_poll(struct file *file, poll_table *wait)
+{
+	struct rockchip_vad_file *vfile = file->private_data;
+	struct rockchip_vad *vad = vfile->vad;
+
+	poll_wait(file, &vad->status_wait, wait);
+
+	if (READ_ONCE(vad->status->seq) != vfile->seq)
+		return EPOLLIN | EPOLLRDNORM;
+
+	return 0;
+}
+
+static int rockchip_vad_fops_mmap(struct file *file, struct vm_area_struct *vma)
+{
+	struct rockchip_vad_file *vfile = file->private_data;
+	struct rockchip_vad *vad = vfile->vad;
+	unsigned long size = vma->vm_end - vma->vm_start;
+
+	/* both the status page and the ring are owned by the kernel */
+	if (vma->vm_flags & VM_WRITE)
+		return -EPERM;
+	vma->vm_flags &= ~VM_MAYWRITE;
+	vma->vm_flags |= VM_DONTCOPY | VM_DONTEXPAND | VM_DONTDUMP;
+
+	switch (vma->vm_pgoff) {
+	case RK_VAD_PGOFF_STATUS:
+		if (size != PAGE_SIZE)
+			return -EINVAL;
+		return vm_insert_page(vma, vma->vm_start,
+				      virt_to_page(vad->status));
+	case RK_VAD_PGOFF_RING:
+		vma->vm_pgoff = 0;
+		vma->vm_page_prot = pgprot_noncached(vma->vm_page_prot);
+		return vm_iomap_memory(vma, vad->memphy, vad->memsize);
+	default:
+		return -EINVAL;
+	}
+}
+
+static const struct file_operations rockchip_vad_fops = {
+	.owner = THIS_MODULE,
+	.open = rockchip_vad_fops_open,
+	.release = rockchip_vad_fops_release,
+	.read = rockchip_vad_fops_read,
+	.poll = rockchip_vad_fops_poll,
+	.mmap = rockchip_vad_fops_mmap,
+	.llseek = noop_llseek,
+};
+
+static int rockchip_vad_misc_register(struct rockchip_vad *vad)
+{
+	struct rk_vad_status *status;
+	int ret;
+
+	status = (struct rk_vad_status *)get_zeroed_page(GFP_KERNEL);
+	if (!status)
+		return -ENOMEM;
+
+	status->ring_offset = offset_in_page(vad->memphy);
+	status->ring_size = vad->memsize;
+	spin_lock_init(&vad->status_lock);
+	init_waitqueue_head(&vad->status_wait);
+	/* the irq handler may publish from here on */
+	smp_store_release(&vad->status, status);
+
+	vad->miscdev.minor = MISC_DYNAMIC_MINOR;
+	vad->miscdev.name = RK_VAD_NAME;
+	vad->miscdev.fops = &rockchip_vad_fops;
+	vad->miscdev.parent = vad->dev;
+	ret = misc_register(&vad->miscdev);
+	if (ret) {
+		free_page((unsigned long)vad->status);
+		vad->status = NULL;
+	}
+
+	return ret;
+}
+
+static void rockchip_vad_misc_deregister(struct rockchip_vad *vad)
+{
+	misc_deregister(&vad->miscdev);
+	free_page((unsigned long)vad->status);
+	vad->status = NULL;
+}
+
 static void rockchip_vad_init(struct rockchip_vad *vad)
 {
 	unsigned int val, mask;
@@ -1227,6 +1418,7 @@ static int rockchip_vad_probe(struct platform_device *pdev)
 		goto err_phandle;
 	vad->memphy = sram_res.start;
 	vad->memphy_end = sram_res.start + resource_size(&sram_res) - 0x8;
+	vad->memsize = resource_size(&sram_res);
 	vad->membase = devm_ioremap(&pdev->dev, sram_res.start,
 				    resource_size(&sram_res));
 	if (!vad->membase) {
@@ -1279,14 +1471,20 @@ static int rockchip_vad_probe(struct platform_device *pdev)
 #endif
 
 	platform_set_drvdata(pdev, vad);
+	ret = rockchip_vad_misc_register(vad);
+	if (ret)
+		goto err;
+
 	ret = snd_soc_register_component(&pdev->dev, &soc_vad_codec,
 					 &vad_dai, 1);
 	if (ret)
-		goto err;
+		goto err_misc;
 
 	of_node_put(sram_np);
 
 	return 0;
+err_misc:
+	rockchip_vad_misc_deregister(vad);
 err:
 	clk_disable_unprepare(vad->hclk);
 err_phandle:
@@ -1303,6 +1501,7 @@ static int rockchip_vad_remove(struct platform_device *pdev)
 		clk_disable_unprepare(vad->hclk);
 	of_node_put(vad->audio_node);
 	snd_soc_unregister_component(&pdev->dev);
+	rockchip_vad_misc_deregister(vad);
 	return 0;
 }
 